@@ -10,6 +10,10 @@
  * This example shows how to start and stop ODP CLI using the CLI helper
  * API functions. This example application can also be used to try out
  * the CLI by connecting to a running application with a telnet client.
+ *
+ * When the statistics server is enabled, the main thread publishes an
+ * example counter once a second, which may be read with the "stats" CLI
+ * command or by sending "stats" lines to the statistics port.
  */
 
 #include <odp_api.h>
@@ -23,6 +27,7 @@ typedef struct {
 	int time;
 	char *addr;
 	uint16_t port;
+	uint16_t stats_port;
 } options_t;
 
 static void usage(const char *prog)
@@ -34,6 +39,7 @@ static void usage(const char *prog)
 	       "  -t, --time <sec>        Keep CLI open for <sec> seconds. (default -1 (infinite))\n"
 	       "  -a, --address <addr>    Bind listening socket to IP address <addr>.\n"
 	       "  -p, --port <port>       Bind listening socket to port <port>.\n"
+	       "  -s, --stats_port <port> Enable statistics server on port <port>.\n"
 	       "\n"
 	       "ODP helper defaults are used for address and port, if the options are\n"
 	       "not given.\n"
@@ -47,11 +53,12 @@ static void parse_args(int argc, char *argv[], options_t *opt)
 		{ "time", required_argument, NULL, 't' },
 		{ "address", required_argument, NULL, 'a' },
 		{ "port", required_argument, NULL, 'p' },
+		{ "stats_port", required_argument, NULL, 's' },
 		{ "help", no_argument, NULL, 'h' },
 		{ NULL, 0, NULL, 0 }
 	};
 
-	static const char *shortopts = "+t:a:p:h";
+	static const char *shortopts = "+t:a:p:s:h";
 
 	while (1) {
 		int c = getopt_long(argc, argv, shortopts, longopts, NULL);
@@ -69,6 +76,9 @@ static void parse_args(int argc, char *argv[], options_t *opt)
 		case 'p':
 			opt->port = atoi(optarg);
 			break;
+		case 's':
+			opt->stats_port = atoi(optarg);
+			break;
 		default:
 			usage(argv[0]);
 			exit(EXIT_SUCCESS);
@@ -129,6 +139,7 @@ int main(int argc, char *argv[])
 		.time = -1,
 		.addr = NULL,
 		.port = 0,
+		.stats_port = 0,
 	};
 
 	parse_args(argc, argv, &opt);
@@ -159,6 +170,8 @@ int main(int argc, char *argv[])
 	if (opt.port)
 		cli_param.port = opt.port;
 
+	cli_param.stats_port = opt.stats_port;
+
 	/* Initialize CLI helper. */
 	if (odph_cli_init(&cli_param)) {
 		ODPH_ERR("CLI helper initialization failed.\n");
@@ -172,6 +185,12 @@ int main(int argc, char *argv[])
 		exit(EXIT_FAILURE);
 	}
 
+	/* Register example statistics counter. */
+	if (odph_cli_stats_register("seconds") < 0) {
+		ODPH_ERR("Registering statistics counter failed.\n");
+		exit(EXIT_FAILURE);
+	}
+
 	/* Create server thread. */
 
 	odp_cpumask_t cpumask;
@@ -202,9 +221,17 @@ int main(int argc, char *argv[])
 	printf("CLI server started on %s:%d\n", cli_param.address,
 	       cli_param.port);
 
+	if (cli_param.stats_port)
+		printf("Statistics server started on %s:%d\n", cli_param.address,
+		       cli_param.stats_port);
+
 	/* Wait for the given number of seconds. */
-	for (int i = 0; (opt.time < 0 || i < opt.time) && !shutdown_sig; i++)
+	for (int i = 0; (opt.time < 0 || i < opt.time) && !shutdown_sig; i++) {
+		uint64_t seconds = i;
+
+		odph_cli_stats_publish(&seconds, 1);
 		odp_time_wait_ns(ODP_TIME_SEC_IN_NS);
+	}
 
 	printf("Stopping CLI server.\n");
 
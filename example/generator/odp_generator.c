@@ -28,6 +28,10 @@
 #define DEFAULT_PKT_INTERVAL   1000  /* Interval between each packet */
 #define DEFAULT_UDP_TX_BURST	16
 #define MAX_UDP_TX_BURST	512
+#define MAX_UDP_TX_TMPL		4096 /* Max UDP template packets per thread */
+#define MAX_THR_TX_QUEUES	8    /* Max output queues per thread */
+#define FRAME_OVERHEAD		24   /* Preamble, FCS and inter-frame gap */
+#define FRAME_LEN_MIN		60   /* Min Ethernet frame length w/o FCS */
 #define DEFAULT_RX_BURST	32
 #define MAX_RX_BURST		512
 #define STATS_INTERVAL		10   /* Interval between stats prints (sec) */
@@ -54,7 +58,7 @@
 typedef struct {
 	odp_pktio_t pktio;
 	odp_pktio_config_t config;
-	odp_pktout_queue_t pktout[MAX_WORKERS];
+	odp_pktout_queue_t pktout[MAX_WORKERS * MAX_THR_TX_QUEUES];
 	uint32_t pktout_count;
 	odp_pktin_queue_t pktin[MAX_WORKERS];
 	uint32_t pktin_count;
@@ -88,6 +92,9 @@ typedef struct {
 				      API call */
 	int rx_burst;	/**< number of packets to receive with one
 				      API call */
+	int tx_queues;		/**< number of output queues per thread */
+	uint64_t pps;		/**< UDP send rate in packets per second */
+	uint64_t bps;		/**< UDP send rate in bits per second */
 	odp_bool_t csum;	/**< use platform csum support if available */
 	odp_bool_t sched;	/**< use scheduler API to receive packets */
 } appl_args_t;
@@ -103,17 +110,20 @@ typedef struct {
 	uint64_t ctr_seq;	/**< ip seq to be send */
 	uint64_t ctr_udp_rcv;	/**< udp packets */
 	uint64_t ctr_icmp_reply_rcv;	/**< icmp reply packets */
+	uint64_t ctr_tx_ns;	/**< time spent in sending */
 } counters_t;
 
-/** UDP Packet processing function argument */
+/**
+ * UDP flows of a thread
+ *
+ * Flows are numbered from 0 to (srcport range * dstport range - 1). A thread
+ * sends flows flow_first, flow_first + flow_step, ...
+ */
 typedef struct {
-	odp_bool_t multi_flow;
-	uint16_t srcport_crt;
-	uint16_t srcport_start;
-	uint16_t srcport_end;
-	uint16_t dstport_crt;
-	uint16_t dstport_start;
-	uint16_t dstport_end;
+	uint32_t flow_first;	/**< First flow of the thread */
+	uint32_t flow_step;	/**< Distance between flows of the thread */
+	uint32_t num_flows;	/**< Number of flows of the thread */
+	int num_tmpl;		/**< Number of template packets */
 } udp_args_t;
 
 /** * Thread specific arguments
@@ -123,9 +133,12 @@ typedef struct {
 	odp_bool_t stop; /**< Stop packet processing */
 	union {
 		struct {
-			odp_pktout_queue_t pktout; /**< Packet output queue */
+			/** Packet output queues */
+			odp_pktout_queue_t pktout[MAX_THR_TX_QUEUES];
+			int num_pktout; /**< Number of output queues */
 			odp_pktout_config_opt_t *pktout_cfg; /**< Packet output config*/
 			udp_args_t udp_param;  /**< UDP configuration */
+			uint64_t pps; /**< Send rate limit, or 0 */
 		} tx;
 		struct {
 			odp_pktin_queue_t pktin; /**< Packet input queue */
@@ -287,24 +300,31 @@ static int setup_pkt_array(odp_pktout_config_opt_t *pktout_cfg,
 }
 
 /**
- * set up an udp packet reference
+ * Set up an udp template packet
  *
- * @param pool Buffer pool to create packet in
- * @param pktout_cfg Interface output configuration
+ * Template packets are complete, including checksums, and are not modified
+ * after creation. Packets are sent as static references to templates.
+ * Output checksum offload (--csum) is not used here, since checksum insertion
+ * on output would write into the data shared by the references. Checksums
+ * are calculated once per template instead.
  *
+ * @param pool Buffer pool to create packet in
+ * @param flow Index of the flow, selects UDP ports
+ * @param ip_id IP identification
  *
  * @retval Handle of created packet
  * @retval ODP_PACKET_INVALID  Packet could not be created
- *
  */
-static odp_packet_t setup_udp_pkt_ref(odp_pool_t pool,
-				      odp_pktout_config_opt_t *pktout_cfg)
+static odp_packet_t setup_udp_tmpl(odp_pool_t pool, uint32_t flow,
+				   uint16_t ip_id)
 {
 	odp_packet_t pkt;
 	char *buf;
 	odph_ethhdr_t *eth;
 	odph_ipv4hdr_t *ip;
 	odph_udphdr_t *udp;
+	uint32_t sport_range = args->appl.srcport_end - args->appl.srcport + 1;
+	uint32_t dport_range = args->appl.dstport_end - args->appl.dstport + 1;
 
 	pkt = odp_packet_alloc(pool, args->appl.payload + ODPH_UDPHDR_LEN +
 			       ODPH_IPV4HDR_LEN + ODPH_ETHHDR_LEN);
@@ -328,88 +348,34 @@ static odp_packet_t setup_udp_pkt_ref(odp_pool_t pool,
 	ip->dst_addr = odp_cpu_to_be_32(args->appl.dstip);
 	ip->src_addr = odp_cpu_to_be_32(args->appl.srcip);
 	ip->ver_ihl = ODPH_IPV4 << 4 | ODPH_IPV4HDR_IHL_MIN;
+	ip->tos = 0;
 	ip->tot_len = odp_cpu_to_be_16(args->appl.payload + ODPH_UDPHDR_LEN +
 				       ODPH_IPV4HDR_LEN);
 	ip->proto = ODPH_IPPROTO_UDP;
-	ip->id = 0;
+	ip->id = odp_cpu_to_be_16(ip_id);
+	ip->frag_offset = 0;
 	ip->ttl = 64;
 	ip->chksum = 0;
+	ip->chksum = ~odp_chksum_ones_comp16(ip, ODPH_IPV4HDR_LEN);
 
 	/* udp */
 	odp_packet_l4_offset_set(pkt, ODPH_ETHHDR_LEN + ODPH_IPV4HDR_LEN);
 	odp_packet_has_udp_set(pkt, 1);
 	udp = (odph_udphdr_t *)(buf + ODPH_ETHHDR_LEN + ODPH_IPV4HDR_LEN);
-	udp->src_port = odp_cpu_to_be_16(args->appl.srcport);
-	udp->dst_port = odp_cpu_to_be_16(args->appl.dstport);
+	udp->src_port = odp_cpu_to_be_16(args->appl.srcport +
+					 flow % sport_range);
+	udp->dst_port = odp_cpu_to_be_16(args->appl.dstport +
+					 (flow / sport_range) % dport_range);
 	udp->length = odp_cpu_to_be_16(args->appl.payload + ODPH_UDPHDR_LEN);
-	if (!pktout_cfg->bit.udp_chksum) {
-		udp->chksum = 0;
-		udp->chksum = odph_ipv4_udp_chksum(pkt);
-	}
+	udp->chksum = 0;
+	udp->chksum = odph_ipv4_udp_chksum(pkt);
 
-	return pkt;
-}
+	/* Checksums are already in place, the packet must not be modified
+	 * on output */
+	odp_packet_l3_chksum_insert(pkt, 0);
+	odp_packet_l4_chksum_insert(pkt, 0);
 
-/**
- * set up an udp packet
- *
- * @param pkt Reference UDP packet
- * @param pktout_cfg Interface output configuration
- *
- * @return Success/Failed
- * @retval 0 on success, -1 on fail
- */
-static int setup_udp_pkt(odp_packet_t pkt, odp_pktout_config_opt_t *pktout_cfg,
-			 counters_t *counters, void *arg)
-{
-	char *buf;
-	odph_ipv4hdr_t *ip;
-	unsigned short seq;
-	udp_args_t *udp_arg = (udp_args_t *)arg;
-
-	buf = (char *)odp_packet_data(pkt);
-
-	/*Update IP ID and checksum*/
-	ip = (odph_ipv4hdr_t *)(buf + ODPH_ETHHDR_LEN);
-	seq = counters->ctr_seq % 0xFFFF;
-	counters->ctr_seq++;
-	ip->id = odp_cpu_to_be_16(seq);
-	if (!pktout_cfg->bit.ipv4_chksum) {
-		ip->chksum = 0;
-		ip->chksum = ~odp_chksum_ones_comp16(ip, ODPH_IPV4HDR_LEN);
-	}
-
-	if (udp_arg->multi_flow) {
-		odph_udphdr_t *udp = (odph_udphdr_t *)(buf + ODPH_ETHHDR_LEN +
-						       ODPH_IPV4HDR_LEN);
-
-		if (udp_arg->srcport_start != udp_arg->srcport_end) {
-			udp->src_port = odp_cpu_to_be_16(udp_arg->srcport_crt);
-			if (udp_arg->srcport_crt >= udp_arg->srcport_end)
-				udp_arg->srcport_crt = udp_arg->srcport_start;
-			else
-				udp_arg->srcport_crt++;
-		}
-		if (udp_arg->dstport_start != udp_arg->dstport_end) {
-			udp->dst_port = odp_cpu_to_be_16(udp_arg->dstport_crt);
-			if (udp_arg->dstport_crt >= udp_arg->dstport_end)
-				udp_arg->dstport_crt = udp_arg->dstport_start;
-			else
-				udp_arg->dstport_crt++;
-		}
-
-		udp->chksum = 0;
-	}
-
-	if (pktout_cfg->bit.ipv4_chksum || pktout_cfg->bit.udp_chksum) {
-		odp_packet_l2_offset_set(pkt, 0);
-		odp_packet_l3_offset_set(pkt, ODPH_ETHHDR_LEN);
-		odp_packet_has_ipv4_set(pkt, 1);
-		odp_packet_l4_offset_set(pkt, ODPH_ETHHDR_LEN +
-					 ODPH_IPV4HDR_LEN);
-		odp_packet_has_udp_set(pkt, 1);
-	}
-	return 0;
+	return pkt;
 }
 
 /**
@@ -683,7 +649,41 @@ static int create_pktio(const char *dev, odp_pool_t pool,
 }
 
 /**
- * Packet IO loopback worker thread using ODP queues
+ * Send a burst of packets
+ *
+ * Retries until all packets are sent. Packets that could not be sent on
+ * the first attempt are counted as drops.
+ *
+ * @return Number of packets sent
+ */
+static int send_burst(int thr, odp_pktout_queue_t pktout,
+		      odp_packet_t pkt_array[], int num, counters_t *counters)
+{
+	int burst_start, burst_size, ret;
+
+	for (burst_start = 0, burst_size = num;;) {
+		ret = odp_pktout_send(pktout, &pkt_array[burst_start],
+				      burst_size);
+		if (ret == burst_size) {
+			burst_size = 0;
+			break;
+		} else if (ret >= 0 && ret < burst_size) {
+			counters->ctr_pkt_snd_drop += burst_size - ret;
+
+			burst_start += ret;
+			burst_size -= ret;
+			continue;
+		}
+		ODPH_ERR("  [%02i] packet send failed\n", thr);
+		odp_packet_free_multi(&pkt_array[burst_start], burst_size);
+		break;
+	}
+
+	return num - burst_size;
+}
+
+/**
+ * Ping send thread
  *
  * @param arg  thread arguments of type 'thread_args_t *'
  */
@@ -691,51 +691,29 @@ static int create_pktio(const char *dev, odp_pool_t pool,
 static int gen_send_thread(void *arg)
 {
 	int thr;
-	int ret = 0;
 	thread_args_t *thr_args;
 	odp_pktout_queue_t pktout;
 	odp_pktout_config_opt_t *pktout_cfg;
 	odp_packet_t pkt_ref_array[MAX_UDP_TX_BURST];
 	odp_packet_t pkt_array[MAX_UDP_TX_BURST];
-	int pkt_array_size, seq_step;
-	int burst_start, burst_size;
-	setup_pkt_ref_fn_t setup_pkt_ref = NULL;
-	setup_pkt_fn_t setup_pkt = NULL;
-	void *setup_pkt_arg = NULL;
+	int pkt_array_size;
 	counters_t *counters;
 	uint64_t pkt_count_max = 0;
 
 	thr = odp_thread_id();
 	thr_args = arg;
-	pktout = thr_args->tx.pktout;
+	pktout = thr_args->tx.pktout[0];
 	pktout_cfg = thr_args->tx.pktout_cfg;
 	counters = &thr_args->counters;
 
 	/* Create reference packets*/
-	if (args->appl.mode == APPL_MODE_UDP) {
-		setup_pkt_ref = setup_udp_pkt_ref;
-		setup_pkt = setup_udp_pkt;
-		seq_step = args->tx_burst_size * (args->thread_cnt - 1);
-		if (args->appl.number != -1)
-			pkt_count_max = args->appl.number / args->thread_cnt +
-				(args->appl.number % args->thread_cnt ? 1 : 0);
-		setup_pkt_arg = &thr_args->tx.udp_param;
-	} else if (args->appl.mode == APPL_MODE_PING) {
-		setup_pkt_ref = setup_icmp_pkt_ref;
-		setup_pkt = setup_icmp_pkt;
-		seq_step = 0;
-		if (args->appl.number != -1)
-			pkt_count_max = args->appl.number;
-	} else {
-		ODPH_ERR("  [%02i] Error: invalid processing mode %d\n", thr,
-			 args->appl.mode);
-		return -1;
-	}
+	if (args->appl.number != -1)
+		pkt_count_max = args->appl.number;
 	pkt_array_size = args->tx_burst_size;
 
 	if (setup_pkt_ref_array(thr_args->pool, pktout_cfg,
 				pkt_ref_array, pkt_array_size,
-				setup_pkt_ref)) {
+				setup_icmp_pkt_ref)) {
 		ODPH_ERR("[%02i] Error: failed to create reference packets\n",
 			 thr);
 		return -1;
@@ -757,42 +735,153 @@ static int gen_send_thread(void *arg)
 		/* Setup TX burst*/
 		if (setup_pkt_array(pktout_cfg, counters,
 				    pkt_ref_array, pkt_array,
-				    pkt_array_size, setup_pkt, setup_pkt_arg)) {
+				    pkt_array_size, setup_icmp_pkt, NULL)) {
 			ODPH_ERR("[%02i] Error: failed to setup packets\n",
 				 thr);
 			break;
 		}
 
 		/* Send TX burst*/
-		for (burst_start = 0, burst_size = pkt_array_size;;) {
-			ret = odp_pktout_send(pktout, &pkt_array[burst_start],
-					      burst_size);
-			if (ret == burst_size) {
-				burst_size = 0;
-				break;
-			} else if (ret >= 0 && ret < burst_size) {
-				thr_args->counters.ctr_pkt_snd_drop +=
-					burst_size - ret;
+		counters->ctr_pkt_snd += send_burst(thr, pktout, pkt_array,
+						    pkt_array_size, counters);
 
-				burst_start += ret;
-				burst_size -= ret;
+		if (args->appl.interval != 0)
+			odp_time_wait_ns((uint64_t)args->appl.interval *
+					 ODP_TIME_MSEC_IN_NS);
+	}
+
+	odp_packet_free_multi(pkt_ref_array, pkt_array_size);
+
+	return 0;
+}
+
+/**
+ * UDP send thread
+ *
+ * Packets are static references to per flow template packets, which are
+ * created before sending starts. Sending a packet only increments the
+ * reference count of a template. Bursts are sent to the output queues of
+ * the thread in turns.
+ *
+ * When a send rate is set, time is checked once per burst and a burst is
+ * sent when it is due. Sent packets are accounted in one second windows,
+ * so that the thread catches up short stalls but does not burst after
+ * long ones.
+ *
+ * @param arg  thread arguments of type 'thread_args_t *'
+ */
+static int gen_send_udp_thread(void *arg)
+{
+	int thr = odp_thread_id();
+	thread_args_t *thr_args = arg;
+	udp_args_t *udp = &thr_args->tx.udp_param;
+	counters_t *counters = &thr_args->counters;
+	odp_packet_t tmpl[MAX_UDP_TX_TMPL];
+	odp_packet_t pkt_array[MAX_UDP_TX_BURST];
+	int burst_size = args->tx_burst_size;
+	int num_tmpl = udp->num_tmpl;
+	int tmpl_idx = 0, queue_idx = 0;
+	uint64_t pps = thr_args->tx.pps;
+	uint64_t pkt_count_max = 0;
+	uint64_t start_ns, win_start, win_sent = 0;
+	int i;
+
+	for (i = 0; i < num_tmpl; i++) {
+		uint32_t flow = udp->flow_first +
+				(i % udp->num_flows) * udp->flow_step;
+
+		tmpl[i] = setup_udp_tmpl(thr_args->pool, flow, i);
+		if (tmpl[i] == ODP_PACKET_INVALID) {
+			ODPH_ERR("[%02i] Error: failed to create template "
+				 "packets\n", thr);
+			odp_packet_free_multi(tmpl, i);
+			return -1;
+		}
+	}
+
+	if (args->appl.number != -1)
+		pkt_count_max = args->appl.number / args->thread_cnt +
+			(args->appl.number % args->thread_cnt ? 1 : 0);
+
+	printf("  [%02i] created mode: SEND, %u flows, %i output queues\n",
+	       thr, udp->num_flows, thr_args->tx.num_pktout);
+
+	odp_barrier_wait(&args->barrier);
+
+	start_ns = odp_time_local_ns();
+	win_start = start_ns;
+
+	while (!thr_args->stop) {
+		int num = burst_size;
+
+		if (pkt_count_max) {
+			if (counters->ctr_pkt_snd >= pkt_count_max) {
+				if (counters->ctr_tx_ns == 0)
+					counters->ctr_tx_ns =
+						odp_time_local_ns() - start_ns;
+				sleep(1); /* wait for stop command */
+				continue;
+			}
+
+			if (pkt_count_max - counters->ctr_pkt_snd <
+			    (uint64_t)num)
+				num = pkt_count_max - counters->ctr_pkt_snd;
+		}
+
+		if (pps) {
+			uint64_t elapsed = odp_time_local_ns() - win_start;
+
+			if (odp_unlikely(elapsed >= ODP_TIME_SEC_IN_NS)) {
+				uint64_t sec = elapsed / ODP_TIME_SEC_IN_NS;
+
+				win_start += sec * ODP_TIME_SEC_IN_NS;
+				elapsed -= sec * ODP_TIME_SEC_IN_NS;
+				win_sent = win_sent > sec * pps ?
+					   win_sent - sec * pps : 0;
+			}
+
+			if (elapsed * pps / ODP_TIME_SEC_IN_NS <
+			    win_sent + num) {
+				odp_cpu_pause();
 				continue;
 			}
-			ODPH_ERR("  [%02i] packet send failed\n", thr);
-			odp_packet_free_multi(&pkt_array[burst_start],
-					      burst_size);
+
+			win_sent += num;
+		}
+
+		/* Templates are not repeated within a burst */
+		for (i = 0; i < num; i++) {
+			pkt_array[i] = odp_packet_ref_static(tmpl[tmpl_idx]);
+			if (pkt_array[i] == ODP_PACKET_INVALID)
+				break;
+
+			if (++tmpl_idx == num_tmpl)
+				tmpl_idx = 0;
+		}
+
+		if (odp_unlikely(i < num)) {
+			ODPH_ERR("[%02i] Error: failed to create packet references\n",
+				 thr);
+			odp_packet_free_multi(pkt_array, i);
 			break;
 		}
 
-		counters->ctr_pkt_snd += pkt_array_size - burst_size;
+		counters->ctr_pkt_snd +=
+			send_burst(thr, thr_args->tx.pktout[queue_idx],
+				   pkt_array, num, counters);
 
-		if (args->appl.interval != 0)
+		if (++queue_idx == thr_args->tx.num_pktout)
+			queue_idx = 0;
+
+		if (!pps && args->appl.interval != 0)
 			odp_time_wait_ns((uint64_t)args->appl.interval *
 					 ODP_TIME_MSEC_IN_NS);
-		counters->ctr_seq += seq_step;
 	}
 
-	odp_packet_free_multi(pkt_ref_array, pkt_array_size);
+	if (counters->ctr_tx_ns == 0)
+		counters->ctr_tx_ns = odp_time_local_ns() - start_ns;
+
+	odp_packet_free_multi(tmpl, num_tmpl);
 
 	return 0;
 }
@@ -1095,6 +1184,97 @@ static void print_global_stats(int num_workers)
 		args->thread[i].stop = 1;
 }
 
+/**
+ * Distribute UDP flows to threads and set send rate of each thread
+ *
+ * @param num_workers Number of worker threads
+ *
+ * @return Total number of template packets
+ */
+static uint32_t setup_udp_flows(int num_workers)
+{
+	uint32_t sport_range = args->appl.srcport_end - args->appl.srcport + 1;
+	uint32_t dport_range = args->appl.dstport_end - args->appl.dstport + 1;
+	uint64_t total_flows = (uint64_t)sport_range * dport_range;
+	uint64_t pps = args->appl.pps;
+	uint32_t num_tmpl = 0;
+	int i;
+
+	if (args->appl.bps) {
+		/* Rate on the wire, including Ethernet overhead */
+		uint64_t frame_len = args->appl.payload + ODPH_UDPHDR_LEN +
+				     ODPH_IPV4HDR_LEN + ODPH_ETHHDR_LEN;
+
+		frame_len = MAX(frame_len, FRAME_LEN_MIN) + FRAME_OVERHEAD;
+		pps = args->appl.bps / (8 * frame_len);
+		if (pps == 0)
+			pps = 1;
+	}
+
+	if (pps)
+		printf("send rate:          %" PRIu64 " pps\n", pps);
+
+	for (i = 0; i < num_workers; i++) {
+		udp_args_t *udp = &args->thread[i].tx.udp_param;
+		uint64_t num_flows;
+
+		if (total_flows <= (uint64_t)i) {
+			udp->flow_first = i % total_flows;
+			udp->flow_step = total_flows;
+			num_flows = 1;
+		} else {
+			udp->flow_first = i;
+			udp->flow_step = num_workers;
+			num_flows = (total_flows - i + num_workers - 1) /
+				    num_workers;
+		}
+
+		if (num_flows > MAX_UDP_TX_TMPL) {
+			printf("Warning: thread %i sends %i of its %" PRIu64
+			       " flows\n", i, MAX_UDP_TX_TMPL, num_flows);
+			num_flows = MAX_UDP_TX_TMPL;
+		}
+
+		udp->num_flows = num_flows;
+		udp->num_tmpl = MAX((int)num_flows, args->tx_burst_size);
+		num_tmpl += udp->num_tmpl;
+
+		args->thread[i].tx.pps = pps / num_workers +
+					 ((uint64_t)i < pps % num_workers);
+		if (pps && args->thread[i].tx.pps == 0)
+			args->thread[i].tx.pps = 1;
+	}
+
+	return num_tmpl;
+}
+
+/**
+ * Print send rate of each thread
+ */
+static void print_thread_stats(int num_workers)
+{
+	uint64_t pkts, nsec, pps, total_pps = 0;
+	int i;
+
+	printf("\nPer thread send rate:\n");
+
+	for (i = 0; i < num_workers; i++) {
+		counters_t *counters = &args->thread[i].counters;
+
+		pkts = counters->ctr_pkt_snd;
+		nsec = counters->ctr_tx_ns;
+		pps = nsec ? (uint64_t)((double)pkts * ODP_TIME_SEC_IN_NS /
+					nsec) : 0;
+		total_pps += pps;
+
+		printf("  [%02i] sent: %" PRIu64 ", drops: %" PRIu64 ", "
+		       "send rate: %" PRIu64 " pps\n", i, pkts,
+		       counters->ctr_pkt_snd_drop, pps);
+	}
+
+	printf("total send rate: %" PRIu64 " pps\n", total_pps);
+}
+
 /**
  * ODP packet example main function
  */
@@ -1115,6 +1295,7 @@ int main(int argc, char *argv[])
 	odp_init_t init_param;
 	odph_thread_common_param_t thr_common;
 	odph_thread_param_t thr_param;
+	uint32_t num_tmpl = 0;
 
 	/* Signal handler has to be registered before global init in case ODP
 	 * implementation creates internal threads/processes. */
@@ -1210,11 +1391,15 @@ int main(int argc, char *argv[])
 	/* Configure scheduler */
 	odp_schedule_config(NULL);
 
+	/* UDP flows and template packets of each thread */
+	if (args->appl.mode == APPL_MODE_UDP)
+		num_tmpl = setup_udp_flows(num_workers);
+
 	/* Create packet pool */
 	odp_pool_param_init(&params);
 	params.pkt.seg_len = POOL_PKT_LEN;
 	params.pkt.len     = POOL_PKT_LEN;
-	params.pkt.num     = POOL_NUM_PKT;
+	params.pkt.num     = POOL_NUM_PKT + num_tmpl;
 	params.type        = ODP_POOL_PACKET;
 
 	pool = odp_pool_create("packet_pool", &params);
@@ -1236,6 +1421,7 @@ int main(int argc, char *argv[])
 			num_tx_queues = num_workers / args->appl.if_count;
 			if (i < num_workers % args->appl.if_count)
 				num_tx_queues++;
+			num_tx_queues *= args->appl.tx_queues;
 		} else { /* APPL_MODE_RCV*/
 			num_rx_queues = num_workers / args->appl.if_count;
 			if (i < num_workers % args->appl.if_count)
@@ -1292,7 +1478,8 @@ int main(int argc, char *argv[])
 				   &thr_param, 1);
 
 		thr_args = &args->thread[PING_THR_TX];
-		thr_args->tx.pktout = ifs[0].pktout[0];
+		thr_args->tx.pktout[0] = ifs[0].pktout[0];
+		thr_args->tx.num_pktout = 1;
 		thr_args->tx.pktout_cfg = &ifs[0].config.pktout;
 		thr_args->pool = pool;
 		thr_args->mode = args->appl.mode;
@@ -1308,23 +1495,11 @@ int main(int argc, char *argv[])
 
 	} else {
 		int cpu = odp_cpumask_first(&cpumask);
-		udp_args_t *udp_param = NULL;
-		uint16_t sport_range = args->appl.srcport_end -
-			args->appl.srcport + 1;
-		uint16_t dport_range = args->appl.dstport_end -
-			args->appl.dstport + 1;
-		float sport_step = (float)(sport_range) / num_workers;
-		float dport_step = (float)(dport_range) / num_workers;
-		odp_bool_t multi_flow = false;
-
-		if (sport_range > 1 || dport_range > 1)
-			multi_flow = true;
 
 		for (i = 0; i < num_workers; ++i) {
 			odp_cpumask_t thd_mask;
 			int (*thr_run_func)(void *);
-			int if_idx, pktq_idx;
-			uint64_t start_seq;
+			int if_idx, pktq_idx, q;
 
 			if_idx = i % args->appl.if_count;
 
@@ -1335,39 +1510,27 @@ int main(int argc, char *argv[])
 					args->thread[i].rx.pktin =
 						ifs[if_idx].pktin[pktq_idx];
 			} else {
-				udp_param = &args->thread[i].tx.udp_param;
-
-				pktq_idx = (i / args->appl.if_count) %
-					ifs[if_idx].pktout_count;
-				start_seq = i * args->tx_burst_size;
-
-				args->thread[i].tx.pktout =
-					ifs[if_idx].pktout[pktq_idx];
+				/* Each thread has tx_queues output queues.
+				 * When the interface has less queues, those
+				 * are shared in MT safe mode. */
+				pktq_idx = (i / args->appl.if_count) *
+					args->appl.tx_queues;
+
+				for (q = 0; q < args->appl.tx_queues; q++)
+					args->thread[i].tx.pktout[q] =
+						ifs[if_idx].pktout[(pktq_idx + q) %
+						ifs[if_idx].pktout_count];
+
+				args->thread[i].tx.num_pktout =
+					args->appl.tx_queues;
 				args->thread[i].tx.pktout_cfg =
 					&ifs[if_idx].config.pktout;
-
-				udp_param->multi_flow = multi_flow;
-				udp_param->srcport_start = args->appl.srcport;
-				udp_param->srcport_end = args->appl.srcport_end;
-				udp_param->srcport_crt = args->appl.srcport;
-				if (sport_range > 1)
-					udp_param->srcport_crt +=
-						(uint16_t)(i * sport_step);
-
-				udp_param->dstport_start = args->appl.dstport;
-				udp_param->dstport_end = args->appl.dstport_end;
-				udp_param->dstport_crt = args->appl.dstport;
-				if (dport_range > 1)
-					udp_param->dstport_crt +=
-						(uint16_t)(i * dport_step);
-
-				args->thread[i].counters.ctr_seq = start_seq;
 			}
 			args->thread[i].pool = pool;
 			args->thread[i].mode = args->appl.mode;
 
 			if (args->appl.mode == APPL_MODE_UDP) {
-				thr_run_func = gen_send_thread;
+				thr_run_func = gen_send_udp_thread;
 			} else if (args->appl.mode == APPL_MODE_RCV) {
 				if (args->appl.sched)
 					thr_run_func = gen_recv_thread;
@@ -1401,6 +1564,9 @@ int main(int argc, char *argv[])
 	/* Master thread waits for other threads to exit */
 	odph_thread_join(thread_tbl, num_workers);
 
+	if (args->appl.mode == APPL_MODE_UDP)
+		print_thread_stats(num_workers);
+
 	for (i = 0; i < args->appl.if_count; ++i)
 		odp_pktio_stop(ifs[i].pktio);
 
@@ -1459,11 +1625,14 @@ static void parse_args(int argc, char *argv[], appl_args_t *appl_args)
 		{"rx_burst", required_argument, NULL, 'r'},
 		{"csum", no_argument, NULL, 'y'},
 		{"sched", no_argument, NULL, 'z'},
+		{"tx_queues", required_argument, NULL, 'q'},
+		{"pps", required_argument, NULL, 'P'},
+		{"bps", required_argument, NULL, 'B'},
 		{NULL, 0, NULL, 0}
 	};
 
 	static const char *shortopts = "+I:a:b:s:d:p:i:m:n:t:w:c:x:he:j:f:k"
-					":yr:z";
+					":yr:zq:P:B:";
 
 	appl_args->mode = -1; /* Invalid, must be changed by parsing */
 	appl_args->number = -1;
@@ -1479,6 +1648,9 @@ static void parse_args(int argc, char *argv[], appl_args_t *appl_args)
 	appl_args->csum = 0;
 	appl_args->sched = 0;
 	appl_args->num_workers = -1;
+	appl_args->tx_queues = 1;
+	appl_args->pps = 0;
+	appl_args->bps = 0;
 
 	while (1) {
 		opt = getopt_long(argc, argv, shortopts, longopts, &long_index);
@@ -1639,6 +1811,21 @@ static void parse_args(int argc, char *argv[], appl_args_t *appl_args)
 		case 'z':
 			appl_args->sched = 1;
 			break;
+		case 'q':
+			appl_args->tx_queues = atoi(optarg);
+			if (appl_args->tx_queues < 1 ||
+			    appl_args->tx_queues > MAX_THR_TX_QUEUES) {
+				ODPH_ERR("wrong number of TX queues (max %d)\n",
+					 MAX_THR_TX_QUEUES);
+				exit(EXIT_FAILURE);
+			}
+			break;
+		case 'P':
+			appl_args->pps = strtoull(optarg, NULL, 0);
+			break;
+		case 'B':
+			appl_args->bps = strtoull(optarg, NULL, 0);
+			break;
 		case 'h':
 			usage(argv[0]);
 			exit(EXIT_SUCCESS);
@@ -1660,6 +1847,11 @@ static void parse_args(int argc, char *argv[], appl_args_t *appl_args)
 		exit(EXIT_FAILURE);
 	}
 
+	if (appl_args->pps && appl_args->bps) {
+		ODPH_ERR("set either pps or bps send rate\n");
+		exit(EXIT_FAILURE);
+	}
+
 	if ((appl_args->srcport != 0 && appl_args->srcport_end == 0) ||
 	    (appl_args->srcport_end < appl_args->srcport))
 		appl_args->srcport_end = appl_args->srcport;
@@ -1747,9 +1939,22 @@ static void usage(char *progname)
 	       "  -x, --udp_tx_burst size of UDP TX burst\n"
 	       "  -r, --rx_burst size of RX burst\n"
 	       "  -y, --csum use platform checksum support if available\n"
-	       "	         default is disabled\n"
+	       "	         default is disabled. In UDP mode, checksums of\n"
+	       "	         sent packets are always calculated by the\n"
+	       "	         application.\n"
 	       "  -z, --sched use scheduler API to receive packets\n"
 	       "                 default is direct mode API\n"
-	       "\n", NO_PATH(progname), NO_PATH(progname)
+	       "  -q, --tx_queues number of output queues per UDP send thread\n"
+	       "                 default is 1, max %d\n"
+	       "  -P, --pps total UDP send rate in packets per second\n"
+	       "                 overrides interval, default is no limit\n"
+	       "  -B, --bps total UDP send rate in bits per second, including\n"
+	       "                 Ethernet preamble, FCS and inter-frame gap\n"
+	       "\n"
+	       "  UDP packets are static references to per flow template packets.\n"
+	       "  Each thread sends its share of the flows (srcport range x dstport\n"
+	       "  range, max %d flows per thread) in bursts of udp_tx_burst packets.\n"
+	       "\n", NO_PATH(progname), NO_PATH(progname), MAX_THR_TX_QUEUES,
+	       MAX_UDP_TX_TMPL
 	      );
 }
@@ -7,13 +7,16 @@
 /**
  * @file
  *
- * @example odp_ipfragreass.c  ODP IPv4 lock-free fragmentation and reassembly
+ * @example odp_ipfragreass.c  ODP IPv4 fragmentation and parallel reassembly
  */
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
 #include <time.h>
 #include <assert.h>
+#include <getopt.h>
 
 #include <odp/helper/odph_api.h>
 
@@ -21,60 +24,278 @@
 #include "odp_ipfragreass_reassemble.h"
 #include "odp_ipfragreass_helpers.h"
 
-#define NUM_PACKETS 200   /**< Number of packets to fragment/reassemble */
-#define MAX_WORKERS 32    /**< Maximum number of worker threads */
-#define FRAGLISTS   16384 /**< Hash map size for reassembly */
+#define NUM_PACKETS   200  /**< Default number of packets to reassemble */
+#define BENCH_PACKETS 2048 /**< Default number of packets per benchmark round */
+#define BENCH_ROUNDS  10   /**< Default number of benchmark rounds */
+#define MAX_WORKERS   32   /**< Maximum number of worker threads */
+#define BURST_SIZE    32   /**< Number of fragments passed to reassembly */
+#define SHARDS_PER_WORKER 16 /**< Reassembly table shards per worker */
 
-#define MIN_MF_FRAG_SIZE  576  /**< Minimum fragment size */
-#define MAX_PKT_LEN	  8192 /**< Maximum packet size */
-#define MAX_FRAGS_PER_PKT 6    /**< Maximum number of fragments per packet */
+/** Interval of stale flow eviction */
+#define EVICT_INTERVAL_NS (100 * ODP_TIME_MSEC_IN_NS)
+
+#define MAX_PKT_LEN	  8192 /**< Maximum packet size in check mode */
+#define MAX_FRAGS_PER_PKT 16   /**< Maximum number of fragments per packet */
+
+/** Maximum number of different IP IDs in one round */
+#define MAX_PACKETS (UINT16_MAX + 1)
 
 /**
  * Derived parameters for packet storage (inc. pool configuration)
  */
-#define POOL_MIN_SEG_LEN IP_HDR_LEN_MIN
-#define POOL_UAREA_SIZE	 sizeof(struct packet)
-#define MAX_FRAGS	 (MAX_FRAGS_PER_PKT * NUM_PACKETS)
+#define POOL_SEG_LEN	(MTU + IP_HDR_LEN_MAX)
+#define POOL_MAX_LEN	(MAX_FRAGS_PER_PKT * MTU + IP_HDR_LEN_MAX)
+#define POOL_UAREA_SIZE	sizeof(struct packet)
+
+/** Number of elements in an array */
+#define ARRAY_SIZE(x) (sizeof(x) / sizeof((x)[0]))
+
+/** Fragment counts swept in benchmark mode */
+static const int bench_frags[] = {2, 4, 8, 16};
+
+/** Per worker state */
+typedef struct ODP_ALIGNED_CACHE {
+	odp_packet_t *frags;	/**< Fragments of the current round */
+	int num_frags;		/**< Number of fragments in the round */
+	odp_packet_t *out;	/**< Reassembled packets (check mode) */
+	int num_out;		/**< Number of reassembled packets */
+	uint64_t reassembled;	/**< Number of packets reassembled */
+	uint64_t frags_done;	/**< Number of fragments processed */
+	int idx;		/**< Worker index */
+	odp_queue_t tmo_queue;	/**< Queue for eviction timeouts */
+	odp_timer_t timer;	/**< Eviction timer */
+	odp_event_t tmo_ev;	/**< Timeout event, when not in timer */
+	uint64_t next_evict;	/**< Next eviction, when timers are not used */
+} worker_t;
+
+/** Application options */
+typedef struct {
+	int num_workers;	/**< Maximum number of workers */
+	int num_pkts;		/**< Number of packets per round */
+	int num_frags;		/**< Number of fragments per packet, or 0 */
+	int rounds;		/**< Number of benchmark rounds */
+	int bench;		/**< Benchmark mode */
+} appl_opt_t;
+
+/** Global application state */
+static struct {
+	appl_opt_t opt;
+	odp_pool_t pool;
+	odp_pool_t tmo_pool;
+	odp_timer_pool_t timer_pool;
+	uint64_t evict_tick;
+	struct reass_table *tbl;
+	odp_barrier_t barrier;
+	int active_workers;
+	int rounds;
+	worker_t worker[MAX_WORKERS];
+} g;
+
+static void print_usage(void)
+{
+	printf("\n"
+	       "IPv4 fragmentation and reassembly example.\n"
+	       "\n"
+	       "Packets are generated, fragmented and shuffled. Worker threads\n"
+	       "reassemble the fragments in parallel. By default, reassembled\n"
+	       "packets are checked against the originals.\n"
+	       "\n"
+	       "OPTIONS:\n"
+	       "  -w, --workers <num>   Maximum number of worker threads. Default: all available\n"
+	       "  -n, --num_pkt <num>   Number of packets per round. Default: %d, benchmark %d\n"
+	       "  -f, --num_frag <num>  Number of fragments per packet (2 - %d). Default: random\n"
+	       "                        size packets, benchmark sweeps 2, 4, 8 and 16.\n"
+	       "  -b, --bench           Benchmark mode. Reassembly rate is measured for an\n"
+	       "                        increasing number of workers (1, 2, 4, ...).\n"
+	       "  -r, --rounds <num>    Number of benchmark rounds. Default: %d\n"
+	       "  -h, --help            Display help and exit.\n\n",
+	       NUM_PACKETS, BENCH_PACKETS, MAX_FRAGS_PER_PKT, BENCH_ROUNDS);
+}
+
+static int parse_options(int argc, char *argv[], appl_opt_t *opt)
+{
+	int c, long_index;
+	const struct option longopts[] = {
+		{"workers",  required_argument, NULL, 'w'},
+		{"num_pkt",  required_argument, NULL, 'n'},
+		{"num_frag", required_argument, NULL, 'f'},
+		{"bench",    no_argument,	NULL, 'b'},
+		{"rounds",   required_argument, NULL, 'r'},
+		{"help",     no_argument,	NULL, 'h'},
+		{NULL, 0, NULL, 0}
+	};
+	const char *shortopts = "+w:n:f:br:h";
+
+	opt->num_workers = MAX_WORKERS;
+	opt->num_pkts = 0;
+	opt->num_frags = 0;
+	opt->rounds = BENCH_ROUNDS;
+	opt->bench = 0;
+
+	while (1) {
+		c = getopt_long(argc, argv, shortopts, longopts, &long_index);
+
+		if (c == -1)
+			break;	/* No more options */
+
+		switch (c) {
+		case 'w':
+			opt->num_workers = atoi(optarg);
+			break;
+		case 'n':
+			opt->num_pkts = atoi(optarg);
+			break;
+		case 'f':
+			opt->num_frags = atoi(optarg);
+			break;
+		case 'b':
+			opt->bench = 1;
+			break;
+		case 'r':
+			opt->rounds = atoi(optarg);
+			break;
+		case 'h':
+		default:
+			print_usage();
+			return -1;
+		}
+	}
+
+	if (opt->num_pkts == 0)
+		opt->num_pkts = opt->bench ? BENCH_PACKETS : NUM_PACKETS;
+
+	if (opt->num_workers < 1 || opt->num_workers > MAX_WORKERS ||
+	    opt->num_pkts < 1 || opt->num_pkts > MAX_PACKETS ||
+	    (opt->num_frags &&
+	     (opt->num_frags < 2 || opt->num_frags > MAX_FRAGS_PER_PKT)) ||
+	    opt->rounds < 1) {
+		print_usage();
+		return -1;
+	}
+
+	return 0;
+}
+
+/**
+ * Create the eviction timer of each worker
+ *
+ * Each worker has its own timer and a plain timeout queue, which the worker
+ * polls between bursts of fragments. When timers with plain queues are not
+ * supported, workers check the time instead.
+ *
+ * @return 0 when timers are used, -1 otherwise
+ */
+static int init_timers(void)
+{
+	odp_timer_capability_t timer_capa;
+	odp_timer_res_capability_t res_capa;
+	odp_timer_pool_param_t tp_param;
+	odp_pool_param_t pool_param;
+	odp_queue_param_t queue_param;
+	uint64_t res_ns = EVICT_INTERVAL_NS / 10;
+	int i;
 
-/** Output queue for fragmentation, input queue for reassembly */
-static odp_queue_t fragments;
+	if (odp_timer_capability(ODP_CLOCK_DEFAULT, &timer_capa) ||
+	    !timer_capa.queue_type_plain || timer_capa.max_timers < MAX_WORKERS)
+		return -1;
+
+	memset(&res_capa, 0, sizeof(res_capa));
+	res_capa.max_tmo = 2 * EVICT_INTERVAL_NS;
+	if (odp_timer_res_capability(ODP_CLOCK_DEFAULT, &res_capa))
+		return -1;
+
+	if (res_capa.res_ns > res_ns)
+		res_ns = res_capa.res_ns;
+
+	odp_timer_pool_param_init(&tp_param);
+	tp_param.res_ns = res_ns;
+	tp_param.min_tmo = EVICT_INTERVAL_NS / 2;
+	tp_param.max_tmo = 2 * EVICT_INTERVAL_NS;
+	tp_param.num_timers = MAX_WORKERS;
+	tp_param.clk_src = ODP_CLOCK_DEFAULT;
+
+	g.timer_pool = odp_timer_pool_create("reass_evict", &tp_param);
+	if (g.timer_pool == ODP_TIMER_POOL_INVALID)
+		return -1;
+
+	odp_timer_pool_start();
+	g.evict_tick = odp_timer_ns_to_tick(g.timer_pool, EVICT_INTERVAL_NS);
+
+	odp_pool_param_init(&pool_param);
+	pool_param.type = ODP_POOL_TIMEOUT;
+	pool_param.tmo.num = MAX_WORKERS;
+	g.tmo_pool = odp_pool_create("reass_tmo", &pool_param);
+	if (g.tmo_pool == ODP_POOL_INVALID)
+		return -1;
+
+	odp_queue_param_init(&queue_param);
+	queue_param.type = ODP_QUEUE_TYPE_PLAIN;
+	queue_param.enq_mode = ODP_QUEUE_OP_MT;
+	queue_param.deq_mode = ODP_QUEUE_OP_MT_UNSAFE;
+
+	for (i = 0; i < MAX_WORKERS; i++) {
+		worker_t *w = &g.worker[i];
+		odp_timeout_t tmo;
+
+		w->tmo_queue = odp_queue_create(NULL, &queue_param);
+		if (w->tmo_queue == ODP_QUEUE_INVALID)
+			return -1;
+
+		w->timer = odp_timer_alloc(g.timer_pool, w->tmo_queue, NULL);
+		if (w->timer == ODP_TIMER_INVALID)
+			return -1;
+
+		tmo = odp_timeout_alloc(g.tmo_pool);
+		if (tmo == ODP_TIMEOUT_INVALID)
+			return -1;
+
+		w->tmo_ev = odp_timeout_to_event(tmo);
+	}
 
-/** Output queue for reassembly, input queue for validation */
-static odp_queue_t reassembled_pkts;
+	return 0;
+}
 
-/** Number of packets reassembled thus far */
-static odp_atomic_u32_t packets_reassembled;
+static void term_timers(void)
+{
+	int i;
 
-/** Number of fragments processed per thread in reassembly (for printing) */
-static struct ODP_ALIGNED_CACHE {
-	uint32_t frags;
-} thread_stats[MAX_WORKERS];
+	for (i = 0; i < MAX_WORKERS; i++) {
+		worker_t *w = &g.worker[i];
 
-/** Shared hash map structure for reassembly */
-static odp_atomic_u128_t *fraglists;
+		if (w->tmo_ev != ODP_EVENT_INVALID)
+			odp_event_free(w->tmo_ev);
+		if (w->timer != ODP_TIMER_INVALID)
+			odp_timer_free(w->timer);
+		if (w->tmo_queue != ODP_QUEUE_INVALID)
+			odp_queue_destroy(w->tmo_queue);
 
-/** Barrier for synchronising reassembly worker threads */
-static odp_barrier_t barrier;
+		w->tmo_ev = ODP_EVENT_INVALID;
+		w->timer = ODP_TIMER_INVALID;
+		w->tmo_queue = ODP_QUEUE_INVALID;
+	}
+
+	if (g.tmo_pool != ODP_POOL_INVALID)
+		odp_pool_destroy(g.tmo_pool);
+	if (g.timer_pool != ODP_TIMER_POOL_INVALID)
+		odp_timer_pool_destroy(g.timer_pool);
+
+	g.tmo_pool = ODP_POOL_INVALID;
+	g.timer_pool = ODP_TIMER_POOL_INVALID;
+}
 
 /**
  * Initialise the base structures required for execution of this application
  *
  * @param[out] instance		ODP instance handle to initialise
- * @param[out] fragment_pool	Output for fragment pool creation
- * @param[out] shm		Output for reassembly shared memory creation
- * @param[out] cpumask		Output for worker threads CPU mask
- * @param[out] num_workers	Output for number of worker threads
  */
-static void init(odp_instance_t *instance, odp_pool_t *fragment_pool,
-		 odp_shm_t *shm, odp_cpumask_t *cpumask, int *num_workers)
+static void init(odp_instance_t *instance)
 {
 	unsigned int seed = time(NULL);
-	int i;
+	int max_frags = g.opt.num_frags;
+	uint32_t max_flows = g.opt.num_pkts;
+	odp_pool_capability_t pool_capa;
 	odp_pool_param_t pool_params;
-	odp_queue_param_t frag_queue_params;
-	odp_queue_param_t reass_queue_params;
-	char cpumask_str[ODP_CPUMASK_STR_SIZE];
-	union fraglist init_data;
+	int i;
 
 	srand(seed);
 	printf("= Seed: %d\n", seed);
@@ -90,285 +311,547 @@ static void init(odp_instance_t *instance, odp_pool_t *fragment_pool,
 		exit(1);
 	}
 
-	/* Create a pool for packet storage */
+	if (max_frags == 0)
+		max_frags = g.opt.bench ? MAX_FRAGS_PER_PKT :
+			    MAX_PKT_LEN / MTU + 1;
+
+	/*
+	 * Create a pool for packet storage. Packets are allocated in fragment
+	 * sized units, so that fragments can be concatenated into complete
+	 * packets without copying. In check mode, a copy of each original
+	 * packet is stored in addition to the fragments.
+	 */
+	if (odp_pool_capability(&pool_capa)) {
+		fprintf(stderr, "ERROR: odp_pool_capability\n");
+		exit(1);
+	}
+
 	odp_pool_param_init(&pool_params);
-	pool_params.pkt.seg_len    = POOL_MIN_SEG_LEN;
-	pool_params.pkt.len	   = MAX_PKT_LEN;
-	pool_params.pkt.num	   = 2 * MAX_FRAGS + MAX_WORKERS;
+	pool_params.pkt.seg_len    = POOL_SEG_LEN;
+	pool_params.pkt.len	   = POOL_SEG_LEN;
+	pool_params.pkt.max_len	   = POOL_MAX_LEN;
+	pool_params.pkt.num	   = (g.opt.bench ? 1 : 2) * g.opt.num_pkts *
+				     (max_frags + 1) + MAX_WORKERS * BURST_SIZE;
 	pool_params.pkt.uarea_size = POOL_UAREA_SIZE;
 	pool_params.type	   = ODP_POOL_PACKET;
-	*fragment_pool = odp_pool_create("packet pool", &pool_params);
-	if (*fragment_pool == ODP_POOL_INVALID) {
-		fprintf(stderr, "ERROR: packet pool create failed.\n");
+
+	if (pool_capa.pkt.max_len && pool_capa.pkt.max_len < POOL_MAX_LEN)
+		pool_params.pkt.max_len = pool_capa.pkt.max_len;
+	if (pool_capa.pkt.max_num &&
+	    pool_capa.pkt.max_num < pool_params.pkt.num) {
+		fprintf(stderr, "ERROR: %u packets needed, pool max is %u\n",
+			pool_params.pkt.num, pool_capa.pkt.max_num);
 		exit(1);
 	}
 
-	/* Reserve (and initialise) shared memory for reassembly fraglists */
-	*shm = odp_shm_reserve("fraglists",
-			       FRAGLISTS * sizeof(odp_atomic_u128_t),
-			       ODP_CACHE_LINE_SIZE, 0);
-	if (*shm == ODP_SHM_INVALID) {
-		fprintf(stderr, "ERROR: odp_shm_reserve\n");
+	g.pool = odp_pool_create("packet pool", &pool_params);
+	if (g.pool == ODP_POOL_INVALID) {
+		fprintf(stderr, "ERROR: packet pool create failed.\n");
 		exit(1);
 	}
-	fraglists = odp_shm_addr(*shm);
-	if (fraglists == NULL) {
-		fprintf(stderr, "ERROR: odp_shm_addr\n");
+
+	/*
+	 * Size the reassembly table so that all packets of a round may be
+	 * under reassembly at the same time
+	 */
+	g.tbl = reass_table_create("reass_table", max_flows,
+				   SHARDS_PER_WORKER * g.opt.num_workers,
+				   FLOW_TIMEOUT_NS);
+	if (g.tbl == NULL) {
+		fprintf(stderr, "ERROR: reass_table_create\n");
 		exit(1);
 	}
 
-	init_fraglist(&init_data);
-	for (i = 0; i < FRAGLISTS; ++i)
-		odp_atomic_init_u128(&fraglists[i], init_data.raw);
+	g.tmo_pool = ODP_POOL_INVALID;
+	g.timer_pool = ODP_TIMER_POOL_INVALID;
+	for (i = 0; i < MAX_WORKERS; i++) {
+		g.worker[i].idx = i;
+		g.worker[i].tmo_queue = ODP_QUEUE_INVALID;
+		g.worker[i].timer = ODP_TIMER_INVALID;
+		g.worker[i].tmo_ev = ODP_EVENT_INVALID;
+	}
 
-	/* Create a queue for holding fragments */
-	odp_queue_param_init(&frag_queue_params);
-	frag_queue_params.type = ODP_QUEUE_TYPE_PLAIN;
-	frag_queue_params.enq_mode = ODP_QUEUE_OP_MT_UNSAFE;
-	fragments = odp_queue_create("fragments", &frag_queue_params);
-	if (fragments == ODP_QUEUE_INVALID) {
-		fprintf(stderr, "ERROR: odp_queue_create\n");
-		exit(1);
+	if (init_timers()) {
+		printf("= Timers not available, eviction polls time\n");
+		term_timers();
 	}
 
-	/* Create a queue for holding reassembled packets */
-	odp_queue_param_init(&reass_queue_params);
-	reass_queue_params.type = ODP_QUEUE_TYPE_PLAIN;
-	reass_queue_params.deq_mode = ODP_QUEUE_OP_MT_UNSAFE;
-	reassembled_pkts = odp_queue_create("reassembled packets",
-					    &reass_queue_params);
-	if (reassembled_pkts == ODP_QUEUE_INVALID) {
-		fprintf(stderr, "ERROR: odp_queue_create\n");
-		exit(1);
+	printf("= Reassembly table: %u shards, %u flows\n",
+	       g.tbl->num_shards, max_flows);
+}
+
+/**
+ * Start the eviction timer of a worker
+ *
+ * When the timer cannot be started, the worker keeps the timeout event and
+ * polls time until the next eviction.
+ */
+static void evict_start(worker_t *w)
+{
+	odp_timer_start_t start;
+
+	w->next_evict = odp_time_local_ns() + EVICT_INTERVAL_NS;
+
+	if (w->timer == ODP_TIMER_INVALID)
+		return;
+
+	start.tick_type = ODP_TIMER_TICK_REL;
+	start.tick = g.evict_tick;
+	start.tmo_ev = w->tmo_ev;
+	if (odp_timer_start(w->timer, &start) == ODP_TIMER_SUCCESS)
+		w->tmo_ev = ODP_EVENT_INVALID;
+}
+
+/**
+ * Evict stale flows when the eviction interval has passed
+ *
+ * Each worker evicts its own subset of table shards.
+ */
+static void evict_poll(worker_t *w)
+{
+	if (w->timer != ODP_TIMER_INVALID && w->tmo_ev == ODP_EVENT_INVALID) {
+		/* Timer is running */
+		w->tmo_ev = odp_queue_deq(w->tmo_queue);
+		if (w->tmo_ev == ODP_EVENT_INVALID)
+			return;
+	} else if (odp_time_local_ns() < w->next_evict) {
+		/* Timers are not used, or the timer could not be started */
+		return;
 	}
 
-	/* Set up worker threads */
-	*num_workers = odp_cpumask_default_worker(cpumask, *num_workers);
-	odp_barrier_init(&barrier, *num_workers + 1);
-	odp_cpumask_to_str(cpumask, cpumask_str, sizeof(cpumask_str));
-	printf("= Workers: %d\n", *num_workers);
-	printf("= CPU Mask: %s (first CPU: %d)\n\n", cpumask_str,
-	       odp_cpumask_first(cpumask));
+	/* Restart the timer, which is retried on the next eviction if the
+	 * start fails */
+	evict_start(w);
+
+	reass_table_evict(g.tbl, w->idx, g.active_workers, false);
+}
+
+/**
+ * Stop the eviction timer of a worker and get the timeout event back
+ */
+static void evict_stop(worker_t *w)
+{
+	odp_event_t ev;
+
+	if (w->timer == ODP_TIMER_INVALID || w->tmo_ev != ODP_EVENT_INVALID)
+		return;
+
+	if (odp_timer_cancel(w->timer, &ev) == 0) {
+		w->tmo_ev = ev;
+		return;
+	}
+
+	/* Timer has expired, wait for the timeout */
+	while ((ev = odp_queue_deq(w->tmo_queue)) == ODP_EVENT_INVALID)
+		odp_cpu_pause();
+
+	w->tmo_ev = ev;
 }
 
 /**
  * Reassembly worker thread function
  *
- * Repeatedly dequeues input fragments, validating them and then passing them
- * to the reassembly procedure "reassemble_ipv4_packets". When a packet has
- * been reassembled, it is added to the output queue, and when NUM_PACKETS
- * packets have been completed the function returns. Thread 0 additionally
- * executes the garbage collection procedure to clean up stale fragments.
+ * For each round, passes the fragments assigned to this worker in bursts to
+ * the reassembly procedure "reassemble_ipv4_packets". Stale flows are
+ * evicted periodically between bursts. In benchmark mode reassembled
+ * packets are freed, otherwise those are stored for checking.
  *
- * @param arg The thread number of this worker (masquerading as a pointer)
+ * @param arg The worker state
  *
  * @return Always returns zero
  */
-static int run_worker(void *arg ODP_UNUSED)
+static int run_worker(void *arg)
 {
-	int threadno = odp_thread_id() - 1;
-	int iterations = 0;
-	odp_event_t ev;
+	worker_t *w = arg;
+	odp_packet_t out[BURST_SIZE];
+	int rnd, i;
 
-	odp_barrier_wait(&barrier);
-	while (odp_atomic_load_u32(&packets_reassembled) < NUM_PACKETS) {
-		odp_packet_t pkt;
-		odp_time_t timestamp;
-		odph_ipv4hdr_t *hdr;
-		struct packet *fragment;
-		int reassembled;
+	evict_start(w);
 
-		ev = odp_queue_deq(fragments);
-		if (ev == ODP_EVENT_INVALID)
-			break;
-		assert(odp_event_type(ev) == ODP_EVENT_PACKET);
-		++thread_stats[threadno].frags;
-
-		pkt = odp_packet_from_event(ev);
-		hdr = odp_packet_data(pkt);
-		fragment = odp_packet_user_area(pkt);
-		timestamp = odp_time_global();
-		assert(fragment != NULL);
-		assert(odp_packet_len(pkt) == ipv4hdr_payload_len(*hdr)
-					      + ipv4hdr_ihl(*hdr));
-		assert(!ipv4hdr_more_fragments(*hdr) ||
-		       (odp_packet_len(pkt) >= MIN_MF_FRAG_SIZE &&
-				(odp_packet_len(pkt)
-				 - ipv4hdr_ihl(*hdr)) % 8 == 0));
-		assert(odp_packet_len(pkt) <= MAX_PKT_LEN);
-		fragment->handle    = pkt;
-		fragment->prev      = NULL;
-		fragment->arrival.t = odp_time_to_ns(timestamp) / TS_RES_NS;
-
-		reassembled = reassemble_ipv4_packets(fraglists, FRAGLISTS,
-						      fragment, 1,
-						      reassembled_pkts);
-		if (reassembled > 0)
-			odp_atomic_add_u32(&packets_reassembled, reassembled);
-
-		/*
-		 * Perform garbage collection of stale fragments every 50
-		 * iterations. (In real applications, use a timer!)
-		 */
-		if (threadno == 0 && iterations++ > 50) {
-			iterations = 0;
-			garbage_collect_fraglists(fraglists, FRAGLISTS,
-						  reassembled_pkts, 0);
+	for (rnd = 0; rnd < g.rounds; rnd++) {
+		/* Wait for fragments */
+		odp_barrier_wait(&g.barrier);
+
+		for (i = 0; i < w->num_frags; i += BURST_SIZE) {
+			int num = min(w->num_frags - i, BURST_SIZE);
+			int num_out;
+
+			num_out = reassemble_ipv4_packets(g.tbl, &w->frags[i],
+							  num, out);
+
+			if (g.opt.bench) {
+				odp_packet_free_multi(out, num_out);
+			} else {
+				memcpy(&w->out[w->num_out], out,
+				       num_out * sizeof(odp_packet_t));
+				w->num_out += num_out;
+			}
+
+			w->reassembled += num_out;
+			w->frags_done += num;
+			evict_poll(w);
 		}
-	}
 
-	while ((ev = odp_queue_deq(fragments)) != ODP_EVENT_INVALID) {
-		assert(odp_event_type(ev) == ODP_EVENT_PACKET);
-		odp_packet_free(odp_packet_from_event(ev));
+		odp_barrier_wait(&g.barrier);
 	}
 
+	evict_stop(w);
+
 	return 0;
 }
 
 /**
- * ODP fragmentation and reassembly example main function
+ * Select packet size range that results in a number of fragments
  */
-int main(void)
+static void packet_size_range(int num_frags, uint32_t *min_size,
+			      uint32_t *max_size)
 {
-	odp_instance_t instance;
-	odp_pool_t fragment_pool;
-	odp_shm_t shm;
-	odp_cpumask_t cpumask;
-	odph_thread_t thread_tbl[MAX_WORKERS];
-	odph_thread_common_param_t thr_common;
-	odph_thread_param_t thr_param;
-	odp_packet_t dequeued_pkts[NUM_PACKETS];
-	odp_event_t ev;
-	odp_u16be_t ip_id = 0;
-	odp_packet_t orig_pkts[NUM_PACKETS];
-	odp_packet_t fragment_buffer[MAX_FRAGS];
-	int total_fragments = 0;
+	if (num_frags == 0) {
+		*min_size = MTU + IP_HDR_LEN_MAX + 1;
+		*max_size = MAX_PKT_LEN;
+		return;
+	}
+
+	/* Payload of more than (num_frags - 1) * MTU bytes, with any header */
+	*min_size = (num_frags - 1) * MTU + IP_HDR_LEN_MAX + 1;
+	*max_size = num_frags * MTU + IP_HDR_LEN_MIN + 1;
+}
+
+/**
+ * Generate and fragment packets, and shuffle the fragments
+ *
+ * @param num_pkts      Number of packets to generate
+ * @param num_frags     Number of fragments per packet, or 0 for random
+ * @param[out] frags    Fragments
+ * @param[out] orig     Copy of original packets, or NULL
+ *
+ * @return Number of fragments, or -1 on failure
+ */
+static int generate_fragments(int num_pkts, int num_frags,
+			      odp_packet_t frags[], odp_packet_t orig[])
+{
+	uint32_t min_size, max_size;
+	int total = 0;
 	int i;
-	int num_workers = MAX_WORKERS;
-	int reassembled;
 
-	init(&instance, &fragment_pool, &shm, &cpumask, &num_workers);
+	packet_size_range(num_frags, &min_size, &max_size);
 
-	/* Packet generation & fragmentation */
-	printf("\n= Fragmenting %d packets...\n", NUM_PACKETS);
-	for (i = 0; i < NUM_PACKETS; ++i) {
+	for (i = 0; i < num_pkts; ++i) {
 		odp_packet_t packet;
-		int num_fragments;
+		int num;
 
-		packet = pack_udp_ipv4_packet(fragment_pool, ip_id++,
-					      MAX_PKT_LEN,
-					      MTU + IP_HDR_LEN_MAX + 1);
+		packet = pack_udp_ipv4_packet(g.pool, i, max_size, min_size);
 		if (packet == ODP_PACKET_INVALID) {
 			fprintf(stderr, "ERROR: pack_udp_ipv4_packet\n");
-			return 1;
+			return -1;
 		}
 
-		orig_pkts[i] = odp_packet_copy(packet, fragment_pool);
-		if (orig_pkts[i] == ODP_PACKET_INVALID) {
-			fprintf(stderr, "ERROR: odp_packet_copy\n");
-			return 1;
+		if (orig) {
+			orig[i] = odp_packet_copy(packet, g.pool);
+			if (orig[i] == ODP_PACKET_INVALID) {
+				fprintf(stderr, "ERROR: odp_packet_copy\n");
+				return -1;
+			}
 		}
 
-		if (fragment_ipv4_packet(packet,
-					 &fragment_buffer[total_fragments],
-					 &num_fragments)) {
+		if (fragment_ipv4_packet(packet, &frags[total], &num)) {
 			fprintf(stderr, "ERROR: fragment_ipv4_packet\n");
-			return 1;
+			return -1;
 		}
 
-		total_fragments += num_fragments;
+		total += num;
 	}
 
 	/* Shuffle the fragments around so they aren't necessarily in order */
-	printf("\n= Shuffling %d fragments...\n", total_fragments);
-	shuffle(fragment_buffer, total_fragments);
+	shuffle(frags, total);
 
-	/* Insert the fragments into a queue for consumption */
-	for (i = 0; i < total_fragments; ++i) {
-		ev = odp_packet_to_event(fragment_buffer[i]);
+	return total;
+}
 
-		if (odp_queue_enq(fragments, ev) < 0) {
-			fprintf(stderr, "ERROR: odp_queue_enq\n");
-			return 1;
-		}
+/**
+ * Assign fragments to workers
+ *
+ * Fragments are shuffled, so each worker gets a consecutive range of those.
+ * Fragments of a packet are spread over multiple workers.
+ */
+static void assign_fragments(odp_packet_t frags[], int num, int num_workers)
+{
+	int i, first = 0;
+
+	for (i = 0; i < num_workers; i++) {
+		int last = (int)(((uint64_t)num * (i + 1)) / num_workers);
+
+		g.worker[i].frags = &frags[first];
+		g.worker[i].num_frags = last - first;
+		first = last;
+	}
+}
+
+/**
+ * Run reassembly rounds with a number of worker threads
+ *
+ * @param num_workers Number of workers
+ * @param num_frags   Number of fragments per packet, or 0 for random
+ * @param orig        Copy of original packets for checking, or NULL
+ * @param[out] nsec   Time spent in reassembly
+ *
+ * @return 0 on success, -1 otherwise
+ */
+static int run_rounds(odp_instance_t instance, int num_workers, int num_frags,
+		      odp_packet_t orig[], uint64_t *nsec)
+{
+	odph_thread_t thread_tbl[MAX_WORKERS];
+	odph_thread_common_param_t thr_common;
+	odph_thread_param_t thr_param[MAX_WORKERS];
+	odp_cpumask_t cpumask;
+	odp_packet_t *frags;
+	int max_frags = num_frags ? num_frags : MAX_FRAGS_PER_PKT;
+	int rnd, num, i;
+	int ret = 0;
+
+	frags = malloc(sizeof(odp_packet_t) * g.opt.num_pkts * max_frags);
+	if (frags == NULL) {
+		fprintf(stderr, "ERROR: malloc\n");
+		return -1;
+	}
+
+	num_workers = odp_cpumask_default_worker(&cpumask, num_workers);
+	g.active_workers = num_workers;
+	g.rounds = g.opt.bench ? g.opt.rounds : 1;
+	odp_barrier_init(&g.barrier, num_workers + 1);
+
+	for (i = 0; i < num_workers; i++) {
+		worker_t *w = &g.worker[i];
+
+		w->num_out = 0;
+		w->reassembled = 0;
+		w->frags_done = 0;
+		w->num_frags = 0;
+
+		odph_thread_param_init(&thr_param[i]);
+		thr_param[i].start = run_worker;
+		thr_param[i].arg = w;
+		thr_param[i].thr_type = ODP_THREAD_WORKER;
 	}
 
-	/* Spawn the worker threads for reassembly */
 	odph_thread_common_param_init(&thr_common);
 	thr_common.instance = instance;
 	thr_common.cpumask = &cpumask;
-	thr_common.share_param = 1;
-
-	odph_thread_param_init(&thr_param);
-	thr_param.start = run_worker;
-	thr_param.arg = 0;
-	thr_param.thr_type = ODP_THREAD_WORKER;
 
 	memset(thread_tbl, 0, sizeof(thread_tbl));
-	odph_thread_create(thread_tbl, &thr_common, &thr_param, num_workers);
+	if (odph_thread_create(thread_tbl, &thr_common, thr_param,
+			       num_workers) != num_workers) {
+		fprintf(stderr, "ERROR: odph_thread_create\n");
+		free(frags);
+		return -1;
+	}
 
-	/* Go! */
-	printf("\n= Starting reassembly...\n");
-	odp_barrier_wait(&barrier);
+	*nsec = 0;
 
-	/* Wait for all threads to complete and output statistics */
-	odph_thread_join(thread_tbl, num_workers);
-	for (i = 0; i < num_workers; ++i)
-		printf("=== Thread %02d processed %3d fragments\n", i,
-		       thread_stats[i].frags);
+	for (rnd = 0; rnd < g.rounds; rnd++) {
+		odp_time_t start;
+
+		/* Generation is not included in the measured time */
+		num = generate_fragments(g.opt.num_pkts, num_frags, frags,
+					 orig);
+		if (num < 0) {
+			ret = -1;
+			num = 0;
+		}
+
+		assign_fragments(frags, num, num_workers);
 
-	/* Dequeue the reassembled packets */
-	for (reassembled = 0; (ev = odp_queue_deq(reassembled_pkts)) !=
-	     ODP_EVENT_INVALID; ++reassembled) {
-		assert(reassembled < NUM_PACKETS);
-		assert(odp_event_type(ev) == ODP_EVENT_PACKET);
-		dequeued_pkts[reassembled] = odp_packet_from_event(ev);
+		odp_barrier_wait(&g.barrier);
+		start = odp_time_local();
+		odp_barrier_wait(&g.barrier);
+		*nsec += odp_time_diff_ns(odp_time_local(), start);
 	}
 
-	/* Check reassembled packets against the originals */
+	odph_thread_join(thread_tbl, num_workers);
+	free(frags);
+
+	return ret;
+}
+
+/**
+ * Check reassembled packets against the originals
+ */
+static int check_packets(int num_workers, odp_packet_t orig[])
+{
+	int num_pkts = g.opt.num_pkts;
+	int reassembled = 0;
+	int i, k;
+
 	printf("\n= Checking reassembled packets...\n");
-	for (i = 0; i < reassembled; ++i) {
-		int j = -1;
-		int k;
-		odp_packet_t packet = dequeued_pkts[i];
-		uint32_t len = odp_packet_len(packet);
-		odph_ipv4hdr_t hdr;
-		odph_ipv4hdr_t reassembled_hdr;
-
-		reassembled_hdr = *(odph_ipv4hdr_t *)odp_packet_data(packet);
-		for (k = 0; k < reassembled; ++k) {
-			hdr = *(odph_ipv4hdr_t *)odp_packet_data(orig_pkts[k]);
-			if (hdr.src_addr == reassembled_hdr.src_addr &&
-			    hdr.dst_addr == reassembled_hdr.dst_addr &&
-			    hdr.id	 == reassembled_hdr.id &&
-			    hdr.proto	 == reassembled_hdr.proto) {
-				assert(j < 0);
-				j = k;
-			}
-		}
-		assert(j >= 0);
 
-		assert(odp_packet_is_valid(packet));
-		assert(len == odp_packet_len(orig_pkts[j]));
-		assert(!packet_memcmp(orig_pkts[j], packet, 0, 0, len));
+	for (i = 0; i < num_workers; ++i) {
+		worker_t *w = &g.worker[i];
+
+		printf("=== Thread %02d processed %3" PRIu64 " fragments\n", i,
+		       w->frags_done);
+
+		for (k = 0; k < w->num_out; k++) {
+			odp_packet_t packet = w->out[k];
+			odph_ipv4hdr_t *hdr = odp_packet_data(packet);
+			int j = odp_be_to_cpu_16(hdr->id);
+			uint32_t len = odp_packet_len(packet);
+
+			assert(j < num_pkts && orig[j] != ODP_PACKET_INVALID);
+			assert(odp_packet_is_valid(packet));
+			assert(len == odp_packet_len(orig[j]));
+			assert(!packet_memcmp(orig[j], packet, 0, 0, len));
+
+			/* Each packet is reassembled only once */
+			odp_packet_free(orig[j]);
+			orig[j] = ODP_PACKET_INVALID;
+			odp_packet_free(packet);
+			reassembled++;
+		}
 	}
+
 	printf("=== Successfully reassembled %d of %d packets\n", reassembled,
-	       NUM_PACKETS);
-	assert(reassembled == NUM_PACKETS);
-	printf("\n= Complete!\n");
+	       num_pkts);
+
+	return reassembled == num_pkts ? 0 : -1;
+}
 
-	/* Free packets */
-	for (i = 0; i < reassembled; ++i)
-		odp_packet_free(dequeued_pkts[i]);
-	for (i = 0; i < NUM_PACKETS; ++i)
-		odp_packet_free(orig_pkts[i]);
-	garbage_collect_fraglists(fraglists, FRAGLISTS, reassembled_pkts, 1);
+static int run_check(odp_instance_t instance)
+{
+	odp_packet_t *orig;
+	uint64_t nsec;
+	int num_workers = g.opt.num_workers;
+	int i, ret;
+
+	orig = malloc(sizeof(odp_packet_t) * g.opt.num_pkts);
+	if (orig == NULL) {
+		fprintf(stderr, "ERROR: malloc\n");
+		return -1;
+	}
+
+	for (i = 0; i < MAX_WORKERS; i++) {
+		g.worker[i].out = malloc(sizeof(odp_packet_t) *
+					 g.opt.num_pkts);
+		if (g.worker[i].out == NULL) {
+			fprintf(stderr, "ERROR: malloc\n");
+			return -1;
+		}
+	}
+
+	printf("\n= Reassembling %d packets...\n", g.opt.num_pkts);
+	ret = run_rounds(instance, num_workers, g.opt.num_frags, orig, &nsec);
+
+	if (ret == 0)
+		ret = check_packets(g.active_workers, orig);
+
+	for (i = 0; i < g.opt.num_pkts; i++) {
+		if (orig[i] != ODP_PACKET_INVALID)
+			odp_packet_free(orig[i]);
+	}
+
+	for (i = 0; i < MAX_WORKERS; i++)
+		free(g.worker[i].out);
+
+	free(orig);
+	return ret;
+}
+
+/**
+ * Measure reassembly rate with increasing number of workers and fragments
+ */
+static int run_bench(odp_instance_t instance)
+{
+	int frag_list[ARRAY_SIZE(bench_frags)];
+	int num_frag_list = ARRAY_SIZE(bench_frags);
+	int worker_list[MAX_WORKERS];
+	int num_worker_list = 0;
+	uint64_t rate[ARRAY_SIZE(bench_frags)][MAX_WORKERS];
+	int max_workers = g.opt.num_workers;
+	int num_workers, i, j;
+	odp_cpumask_t cpumask;
+
+	if (g.opt.num_frags) {
+		frag_list[0] = g.opt.num_frags;
+		num_frag_list = 1;
+	} else {
+		memcpy(frag_list, bench_frags, sizeof(bench_frags));
+	}
+
+	max_workers = odp_cpumask_default_worker(&cpumask, max_workers);
+	for (num_workers = 1; num_workers < max_workers; num_workers *= 2)
+		worker_list[num_worker_list++] = num_workers;
+	worker_list[num_worker_list++] = max_workers;
+
+	for (i = 0; i < num_frag_list; i++) {
+		for (j = 0; j < num_worker_list; j++) {
+			uint64_t nsec, pkts = 0;
+			int k;
+
+			if (run_rounds(instance, worker_list[j], frag_list[i],
+				       NULL, &nsec))
+				return -1;
+
+			for (k = 0; k < g.active_workers; k++)
+				pkts += g.worker[k].reassembled;
+
+			rate[i][j] = nsec ? (pkts * ODP_TIME_SEC_IN_NS) / nsec : 0;
+
+			printf("=== %2d fragments, %2d workers: %" PRIu64
+			       " packets in %.3f ms, %" PRIu64 " packets/s\n",
+			       frag_list[i], g.active_workers, pkts,
+			       nsec / 1000000.0, rate[i][j]);
+		}
+	}
+
+	/* Reassembled packets per second vs. workers and fragments */
+	printf("\n= Reassembled packets per second (thousands)\n\n");
+	printf("  fragments");
+	for (j = 0; j < num_worker_list; j++)
+		printf("  %3d wrk", worker_list[j]);
+	printf("\n");
+
+	for (i = 0; i < num_frag_list; i++) {
+		printf("  %9d", frag_list[i]);
+		for (j = 0; j < num_worker_list; j++)
+			printf("  %7" PRIu64, rate[i][j] / 1000);
+		printf("\n");
+	}
+
+	printf("\n= Flows evicted: %" PRIu64 "\n",
+	       odp_atomic_load_u64(&g.tbl->evicted));
+
+	return 0;
+}
+
+/**
+ * ODP fragmentation and reassembly example main function
+ */
+int main(int argc, char *argv[])
+{
+	odp_instance_t instance;
+	int ret;
+
+	if (parse_options(argc, argv, &g.opt))
+		return 1;
+
+	init(&instance);
+
+	if (g.opt.bench)
+		ret = run_bench(instance);
+	else
+		ret = run_check(instance);
+
+	if (ret) {
+		fprintf(stderr, "ERROR: reassembly failed\n");
+		return 1;
+	}
+
+	printf("\n= Complete!\n");
 
 	/* ODP cleanup and termination */
-	assert(!odp_queue_destroy(fragments));
-	assert(!odp_queue_destroy(reassembled_pkts));
-	assert(!odp_shm_free(shm));
-	if (odp_pool_destroy(fragment_pool)) {
+	reass_table_destroy(g.tbl);
+	term_timers();
+
+	if (odp_pool_destroy(g.pool)) {
 		fprintf(stderr,
 			"ERROR: fragment_pool destruction failed\n");
 		return 1;
@@ -13,169 +13,130 @@
 #include "odp_ipfragreass_ip.h"
 #include "odp_ipfragreass_helpers.h"
 
-ODP_STATIC_ASSERT(__SIZEOF_POINTER__ <= 8, "ODP_REASS_PTR__SIZE_ERROR");
-
 /**
  * The time in nanoseconds after reception of the earliest fragment that a
  * flow of traffic is considered to be stale
  */
 #define FLOW_TIMEOUT_NS 15000000000ULL
 
-/** Convert nanoseconds into a unit for packet.arrival */
-#define TS_RES_NS ((uint64_t)1000000)    /**< ns -> 1ms */
-
-/**
- * The maximum value of the packet.arrival field.
- */
-#define EARLIEST_MAX UINT32_MAX
-
-/**
- * The time in packet.arrival ticks that indications of the time "now" are
- * permitted to be off by.
- */
-#define TS_NOW_TOLERANCE 5000
-
-/**
- * The timestamp format used for fragments. Sadly, this has to be a structure
- * as we may need a bit field.
- */
-struct flts {
-	uint32_t t;
-};
-
 /**
- * Metadata for reassembly, to be stored alongside each fragment
+ * Metadata for reassembly, to be stored alongside each fragment (in the
+ * packet user area)
  */
 struct packet {
-	odp_packet_t handle; /**< The ODP packet handle for this fragment  */
-	struct packet *prev; /**< Pointer to the fragment "before" this one */
-	struct flts arrival; /**< Arrival timestamp for this fragment */
+	odp_packet_t handle;  /**< The ODP packet handle for this fragment */
+	struct packet *next;  /**< The next fragment in offset order */
+	uint16_t offset;      /**< Fragment offset in bytes */
+	uint16_t len;	      /**< Payload length in bytes */
+	uint16_t hdr_len;     /**< IP header length in bytes */
 };
 
 /**
- * A list of IP fragments associated with one or more traffic flows, along with
- * some related data
+ * Reassembly context of one datagram (flow)
  *
- * This is used as an atomically-updated hash map bucket in reassembly, and is
- * assumed to be packed with no padding.
+ * Fragments are kept in a chain sorted by fragment offset. Fragment data is
+ * not touched until the datagram is complete.
  */
-union fraglist {
-	struct {
-		/**
-		 * The timestamp of the earliest arriving fragment in this
-		 * fraglist
-		 */
-		uint32_t earliest;
-
-		/**
-		 * The sum of the payloads of the fragments in this list
-		 *
-		 * That is, the size of reassembling all the fragments in this
-		 * list into one big packet (minus the header).
-		 */
-		uint32_t part_len:14;
-
-		/**
-		 * The smallest reassembled payload length upper bound from
-		 * all fragments in this list
-		 *
-		 * This is the threshold over which, given the right
-		 * circumstances, "part_len" might indicate that we are able
-		 * to reassemble a packet.
-		 */
-		uint32_t whole_len:14;
-
-		/**
-		 * The tail of a "reverse" linked list of fragments
-		 *
-		 * Each fragment element has a "prev" pointer to the element
-		 * before it in the list. When used in a multi-threaded
-		 * environment, new elements should be inserted atomically by
-		 * modifying this tail pointer.
-		 */
-		struct packet *tail;
-	};
-
-	odp_u128_t raw;
+struct flow {
+	uint32_t src_addr;     /**< Source address (network byte order) */
+	uint32_t dst_addr;     /**< Destination address (network byte order) */
+	uint16_t id;	       /**< IP identification */
+	uint8_t proto;	       /**< IP protocol */
+	uint32_t hash;	       /**< Hash of the above */
+	uint32_t next;	       /**< Next flow in bucket (index + 1), or 0 */
+	uint32_t age_prev;     /**< Previous flow in age list (index + 1) */
+	uint32_t age_next;     /**< Next flow in age list (index + 1) */
+	uint32_t rcvd_len;     /**< Sum of received payload lengths */
+	uint32_t total_len;    /**< Datagram payload length, or 0 when the
+				    last fragment has not been received */
+	uint64_t arrival_ns;   /**< Arrival time of the first fragment */
+	struct packet *frags;  /**< Fragments sorted by offset */
+	struct packet *last;   /**< Fragment with the largest offset */
 };
 
 /**
- * Initialise a fraglist structure
+ * A shard of the reassembly table
  *
- * @param fl The fraglist to initialise
+ * Flows are mapped into shards by hash. Each shard has its own lock, hash
+ * buckets and flow storage, so that threads reassembling different flows
+ * rarely access the same shard.
  */
-static inline void init_fraglist(union fraglist *fl)
-{
-	fl->earliest  = EARLIEST_MAX;
-	fl->part_len  = 0;
-	fl->whole_len = IP_OCTET_MAX;
-	fl->tail      = NULL;
-}
+struct ODP_ALIGNED_CACHE reass_shard {
+	odp_spinlock_t lock;	/**< Shard lock */
+	uint32_t bucket_mask;	/**< Number of buckets - 1 */
+	uint32_t free_flow;	/**< First free flow (index + 1), or 0 */
+	uint32_t age_head;	/**< Oldest flow (index + 1), or 0 */
+	uint32_t age_tail;	/**< Newest flow (index + 1), or 0 */
+	uint32_t num_flows;	/**< Number of flows in use */
+	uint32_t *bucket;	/**< Hash buckets (flow index + 1) */
+	struct flow *flow;	/**< Flow storage */
+};
 
 /**
- * Get the packet "before" a packet in a linked list
- *
- * @param packet The packet from which the previous should be located
- *
- * @return A pointer to the packet before the input packet (can be NULL)
+ * Reassembly table
  */
-static inline struct packet *prev_packet(struct packet packet)
-{
-	return packet.prev;
-}
+struct reass_table {
+	odp_shm_t shm;		  /**< Shared memory of the table */
+	uint32_t num_shards;	  /**< Number of shards (power of two) */
+	uint64_t timeout_ns;	  /**< Flow timeout */
+	odp_atomic_u64_t evicted; /**< Number of flows evicted */
+	struct reass_shard shard[]; /**< Shards */
+};
 
 /**
- * Get the address of the pointer to the packet "before" a packet in a linked
- * list
+ * Create a reassembly table
  *
- * @param packet The packet for which the previous pointer should be located
+ * @param name       Name of the table
+ * @param max_flows  Maximum number of datagrams under reassembly at a time.
+ *                   When a shard is full, its oldest flow is evicted.
+ * @param num_shards Number of shards. Rounded up to a power of two.
+ * @param timeout_ns Flow timeout
  *
- * @return A pointer to the "prev" packet pointer of the input packet
+ * @return Pointer to the table, or NULL on failure
  */
-static inline struct packet **prev_packet_ptr(struct packet *packet)
-{
-	return &packet->prev;
-}
+struct reass_table *reass_table_create(const char *name, uint32_t max_flows,
+				       uint32_t num_shards,
+				       uint64_t timeout_ns);
 
 /**
- * Set the packet "before" a packet in a linked list
+ * Destroy a reassembly table, freeing any remaining fragments
  *
- * @param packet The packet to set the previous packet from
- * @param prev   The packet to set as being before "packet"
+ * @param tbl The table to destroy
  */
-static inline void set_prev_packet(struct packet *packet, struct packet *prev)
-{
-	packet->prev = prev;
-}
+void reass_table_destroy(struct reass_table *tbl);
 
 /**
  * Attempt packet reassembly with the aid of a number of new fragments
  *
- * Add "num_fragments" fragments to a fraglist hash map (with "num_fraglist"
- * entries), attempting reassembly and writing any successfully reassembled
- * packets out to the "out" queue.
+ * Each fragment is added to the chain of its flow. When a flow is
+ * complete, its fragments are concatenated into a single packet, which is
+ * written into "out". Fragments that overlap previously received fragments
+ * of the same flow are dropped.
  *
- * @param fraglists	The hash map structure to add the fragments to
- * @param num_fraglists	The number of entries in the hash map
- * @param fragments	Pointer to the fragments to add
+ * @param tbl		The reassembly table to add the fragments to
+ * @param fragments	The fragments to add. IP header must be at the
+ *			start of packet data.
  * @param num_fragments	The number of fragments to add
- * @param out		The queue to which reassembled packets should be written
+ * @param[out] out	Array for reassembled packets (size "num_fragments")
  *
- * @return The number of packets successfully reassembled and written to "out"
+ * @return The number of packets reassembled and written to "out"
  */
-int reassemble_ipv4_packets(odp_atomic_u128_t *fraglists, int num_fraglists,
-			    struct packet *fragments, int num_fragments,
-			    odp_queue_t out);
+int reassemble_ipv4_packets(struct reass_table *tbl, odp_packet_t fragments[],
+			    int num_fragments, odp_packet_t out[]);
 
 /**
- * Clean up any stale flows within a fraglist hash map
+ * Evict stale flows from a range of shards
+ *
+ * Fragments of flows older than the table timeout are freed.
+ *
+ * @param tbl	      The reassembly table to clean flows from
+ * @param first_shard The first shard to clean
+ * @param stride      The distance between cleaned shards
+ * @param force	      Whether all flows should be considered stale
  *
- * @param fraglists	The hash map structure to clean flows from
- * @param num_fraglists	The number of entries in the hash map
- * @param out		The queue to which reassembled packets should be written
- * @param destroy_all	Whether all encountered flows should be cleaned up
+ * @return The number of flows evicted
  */
-void garbage_collect_fraglists(odp_atomic_u128_t *fraglists, int num_fraglists,
-			       odp_queue_t out, odp_bool_t destroy_all);
+int reass_table_evict(struct reass_table *tbl, uint32_t first_shard,
+		      uint32_t stride, odp_bool_t force);
 
 #endif
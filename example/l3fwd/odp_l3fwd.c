@@ -51,7 +51,9 @@ struct l3fwd_qconf_s {
 	uint8_t core_idx;	/* this core should handle traffic */
 };
 
-struct thread_arg_s {
+/* Per thread data. Statistics counters are updated only by the owner thread
+ * and are on their own cache line. */
+struct ODP_ALIGNED_CACHE thread_arg_s {
 	uint64_t packets;
 	uint64_t rx_drops;
 	uint64_t tx_drops;
@@ -92,7 +94,8 @@ typedef struct {
 	odp_atomic_u32_t exit_threads;
 
 	/* forward func, hash or lpm */
-	int (*fwd_func)(odp_packet_t pkt, int sif);
+	void (*fwd_func)(odp_packet_t pkt_tbl[], int num, int sif, int dif[],
+			 uint32_t thr_idx);
 } global_data_t;
 
 static global_data_t *global;
@@ -153,7 +156,7 @@ static void setup_fwd_db(void)
 
 	args = &global->cmd_args;
 	if (args->hash_mode)
-		init_fwd_hash_cache();
+		init_fwd_hash_cache(args->worker_count);
 	else
 		fib_tbl_init();
 
@@ -185,68 +188,81 @@ static inline void ipv4_dec_ttl_csum_update(odph_ipv4hdr_t *ip)
 		ip->chksum += odp_cpu_to_be_16(1 << 8);
 }
 
-static inline int l3fwd_pkt_hash(odp_packet_t pkt, int sif)
+/**
+ * Forward a burst of packets using the hash based lookup cache
+ *
+ * @param pkt_tbl  Array of IPv4 packets
+ * @param num      Number of packets
+ * @param sif      Source interface index
+ * @param[out] dif Array for destination interface indexes
+ * @param thr_idx  Thread index
+ */
+static inline void l3fwd_pkt_hash(odp_packet_t pkt_tbl[], int num, int sif,
+				  int dif[], uint32_t thr_idx)
 {
-	fwd_db_entry_t *entry;
-	ipv4_tuple5_t key;
+	fwd_db_entry_t *entry[MAX_PKT_BURST];
+	odph_ipv4hdr_t *ip[MAX_PKT_BURST];
+	uint32_t dst_ip[MAX_PKT_BURST] = { 0 };
 	odph_ethhdr_t *eth;
-	odph_udphdr_t  *udp;
-	odph_ipv4hdr_t *ip;
-	int dif;
-
-	ip = odp_packet_l3_ptr(pkt, NULL);
-	key.dst_ip = odp_be_to_cpu_32(ip->dst_addr);
-	key.src_ip = odp_be_to_cpu_32(ip->src_addr);
-	key.proto = ip->proto;
-
-	if (odp_packet_has_udp(pkt) ||
-	    odp_packet_has_tcp(pkt)) {
-		/* UDP or TCP*/
-		void *ptr = odp_packet_l4_ptr(pkt, NULL);
-
-		udp = (odph_udphdr_t *)ptr;
-		key.src_port = odp_be_to_cpu_16(udp->src_port);
-		key.dst_port = odp_be_to_cpu_16(udp->dst_port);
-	} else {
-		key.src_port = 0;
-		key.dst_port = 0;
-	}
-	entry = find_fwd_db_entry(&key);
-	ipv4_dec_ttl_csum_update(ip);
-	eth = odp_packet_l2_ptr(pkt, NULL);
-	if (entry) {
-		eth->src = entry->src_mac;
-		eth->dst = entry->dst_mac;
-		dif = entry->oif_id;
-	} else {
-		/* no route, send by src port */
-		eth->dst = eth->src;
-		dif = sif;
+	int i;
+
+	for (i = 0; i < num; i++) {
+		ip[i] = odp_packet_l3_ptr(pkt_tbl[i], NULL);
+		dst_ip[i] = odp_be_to_cpu_32(ip[i]->dst_addr);
 	}
 
-	return dif;
+	find_fwd_db_entry_multi(thr_idx, dst_ip, entry, num);
+
+	for (i = 0; i < num; i++) {
+		ipv4_dec_ttl_csum_update(ip[i]);
+		eth = odp_packet_l2_ptr(pkt_tbl[i], NULL);
+		if (entry[i]) {
+			eth->src = entry[i]->src_mac;
+			eth->dst = entry[i]->dst_mac;
+			dif[i] = entry[i]->oif_id;
+		} else {
+			/* no route, send by src port */
+			eth->dst = eth->src;
+			dif[i] = sif;
+		}
+	}
 }
 
-static inline int l3fwd_pkt_lpm(odp_packet_t pkt, int sif)
+/**
+ * Forward a burst of packets using LPM
+ *
+ * @param pkt_tbl  Array of IPv4 packets
+ * @param num      Number of packets
+ * @param sif      Source interface index
+ * @param[out] dif Array for destination interface indexes
+ * @param thr_idx  Thread index
+ */
+static inline void l3fwd_pkt_lpm(odp_packet_t pkt_tbl[], int num, int sif,
+				 int dif[], uint32_t thr_idx ODP_UNUSED)
 {
-	odph_ipv4hdr_t *ip;
+	odph_ipv4hdr_t *ip[MAX_PKT_BURST];
+	uint32_t dst_ip[MAX_PKT_BURST];
 	odph_ethhdr_t *eth;
-	int dif;
-	int ret;
+	uint64_t hit_mask;
+	int i;
 
-	ip = odp_packet_l3_ptr(pkt, NULL);
-	ipv4_dec_ttl_csum_update(ip);
-	eth = odp_packet_l2_ptr(pkt, NULL);
+	for (i = 0; i < num; i++) {
+		ip[i] = odp_packet_l3_ptr(pkt_tbl[i], NULL);
+		/* network byte order maybe different from host */
+		dst_ip[i] = odp_be_to_cpu_32(ip[i]->dst_addr);
+	}
 
-	/* network byte order maybe different from host */
-	ret = fib_tbl_lookup(odp_be_to_cpu_32(ip->dst_addr), &dif);
-	if (ret)
-		dif = sif;
+	fib_tbl_lookup_multi(dst_ip, dif, num, &hit_mask);
 
-	eth->dst = global->eth_dest_mac[dif];
-	eth->src = global->l3fwd_pktios[dif].mac_addr;
+	for (i = 0; i < num; i++) {
+		if (!(hit_mask & (1ULL << i)))
+			dif[i] = sif;
 
-	return dif;
+		ipv4_dec_ttl_csum_update(ip[i]);
+		eth = odp_packet_l2_ptr(pkt_tbl[i], NULL);
+		eth->dst = global->eth_dest_mac[dif[i]];
+		eth->src = global->l3fwd_pktios[dif[i]].mac_addr;
+	}
 }
 
 /**
@@ -294,18 +310,24 @@ static int run_worker(void *arg)
 	odp_pktin_queue_t input_queues[thr_arg->nb_pktio];
 	odp_pktout_queue_t output_queues[global->cmd_args.if_count];
 	odp_packet_t pkt_tbl[MAX_PKT_BURST];
-	odp_packet_t *tbl;
+	/* Packets grouped per output interface */
+	odp_packet_t out_tbl[global->cmd_args.if_count][MAX_PKT_BURST];
+	int num_out[global->cmd_args.if_count];
+	int out_ifs[MAX_PKT_BURST];
+	int dif[MAX_PKT_BURST];
 	int pkts, drop, sent;
-	int dst_port, dif;
+	int dst_port, num_out_ifs;
 	int i, j;
 	int pktio = 0;
 	int num_pktio = 0;
+	uint32_t thr_idx = thr_arg->thr_idx;
 
 	/* Copy all required handles to local memory */
 	for (i = 0; i < global->cmd_args.if_count; i++) {
 		int txq_idx = thr_arg->pktio[i].txq_idx;
 
 		output_queues[i] =  global->l3fwd_pktios[i].ifout[txq_idx];
+		num_out[i] = 0;
 
 		if_idx = thr_arg->pktio[i].if_idx;
 		for (j = 0; j < thr_arg->pktio[i].nb_rxq; j++) {
@@ -346,26 +368,34 @@ static int run_worker(void *arg)
 		if (odp_unlikely(pkts < 1))
 			continue;
 
-		dif = global->fwd_func(pkt_tbl[0], if_idx);
-		tbl = &pkt_tbl[0];
-		while (pkts) {
-			dst_port = dif;
-			for (i = 1; i < pkts; i++) {
-				dif = global->fwd_func(tbl[i], if_idx);
-				if (dif != dst_port)
-					break;
-			}
-			sent = odp_pktout_send(output_queues[dst_port], tbl, i);
-			if (odp_unlikely(sent < i)) {
-				sent = sent < 0 ? 0 : sent;
-				odp_packet_free_multi(&tbl[sent], i - sent);
-				thr_arg->tx_drops += i - sent;
-			}
+		/* Look up and modify the whole burst at once */
+		global->fwd_func(pkt_tbl, pkts, if_idx, dif, thr_idx);
 
-			if (i < pkts)
-				tbl += i;
+		/* Group packets per output interface */
+		num_out_ifs = 0;
+		for (i = 0; i < pkts; i++) {
+			dst_port = dif[i];
 
-			pkts -= i;
+			if (num_out[dst_port] == 0)
+				out_ifs[num_out_ifs++] = dst_port;
+
+			out_tbl[dst_port][num_out[dst_port]++] = pkt_tbl[i];
+		}
+
+		/* One send call per output interface */
+		for (i = 0; i < num_out_ifs; i++) {
+			dst_port = out_ifs[i];
+			pkts = num_out[dst_port];
+			num_out[dst_port] = 0;
+
+			sent = odp_pktout_send(output_queues[dst_port],
+					       out_tbl[dst_port], pkts);
+			if (odp_unlikely(sent < pkts)) {
+				sent = sent < 0 ? 0 : sent;
+				odp_packet_free_multi(&out_tbl[dst_port][sent],
+						      pkts - sent);
+				thr_arg->tx_drops += pkts - sent;
+			}
 		}
 	}
 
@@ -927,10 +957,16 @@ static int print_speed_stats(int num_workers, int duration, int timeout)
 		elapsed += timeout;
 	} while (loop_forever || (elapsed < duration));
 
-	if (stats_enabled)
+	if (stats_enabled) {
 		printf("TEST RESULT: %" PRIu64 " maximum packets per second.\n",
 		       maximum_pps);
 
+		for (i = 0; i < num_workers; i++)
+			printf("  thread %2i: %" PRIu64 " packets, %" PRIu64
+			       " pps\n", i, global->worker_args[i].packets,
+			       global->worker_args[i].packets / elapsed);
+	}
+
 	return pkts > 100 ? 0 : -1;
 }
 
@@ -1056,8 +1092,6 @@ int main(int argc, char **argv)
 		resolve_fwd_db(if_name, i, mac);
 		memcpy(port->mac_addr.addr, mac, ODPH_ETHADDR_LEN);
 	}
-	setup_fwd_db();
-	dump_fwd_db();
 
 	nb_worker = MAX_NB_WORKER;
 	if (args->worker_count && args->worker_count < MAX_NB_WORKER)
@@ -1065,6 +1099,9 @@ int main(int argc, char **argv)
 	nb_worker = odp_cpumask_default_worker(&cpumask, nb_worker);
 	args->worker_count = nb_worker;
 
+	setup_fwd_db();
+	dump_fwd_db();
+
 	/* Setup rx and tx queues for each port */
 	setup_worker_qconf(args);
 	print_qconf_table(args);
@@ -1137,22 +1174,16 @@ int main(int argc, char **argv)
 	for (i = 0; i < MAX_NB_ROUTE; i++)
 		free(args->route_str[i]);
 
-	shm = odp_shm_lookup("flow_table");
-	if (shm != ODP_SHM_INVALID && odp_shm_free(shm) != 0) {
-		printf("Error: shm free flow_table\n");
-		exit(EXIT_FAILURE);
-	}
+	if (args->hash_mode)
+		term_fwd_hash_cache();
+	else
+		fib_tbl_term();
+
 	shm = odp_shm_lookup("shm_fwd_db");
 	if (shm != ODP_SHM_INVALID && odp_shm_free(shm) != 0) {
 		printf("Error: shm free shm_fwd_db\n");
 		exit(EXIT_FAILURE);
 	}
-	shm = odp_shm_lookup("fib_lpm_sub");
-	if (shm != ODP_SHM_INVALID && odp_shm_free(shm) != 0) {
-		printf("Error: shm free fib_lpm_sub\n");
-		exit(EXIT_FAILURE);
-	}
-
 	if (odp_pool_destroy(pool)) {
 		printf("Error: pool destroy\n");
 		exit(EXIT_FAILURE);
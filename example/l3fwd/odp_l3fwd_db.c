@@ -16,52 +16,6 @@
 
 #include <odp_l3fwd_db.h>
 
-/** Jenkins hash support.
-  *
-  * Copyright (C) 2006 Bob Jenkins (bob_jenkins@burtleburtle.net)
-  *
-  * http://burtleburtle.net/bob/hash/
-  *
-  * These are the credits from Bob's sources:
-  *
-  * lookup3.c, by Bob Jenkins, May 2006, Public Domain.
-  *
-  * These are functions for producing 32-bit hashes for hash table lookup.
-  * hashword(), hashlittle(), hashlittle2(), hashbig(), mix(), and final()
-  * are externally useful functions.  Routines to test the hash are included
-  * if SELF_TEST is defined.  You can use this free for any purpose.  It's in
-  * the public domain.  It has no warranty.
-  *
-  * $FreeBSD$
-  */
-#define JHASH_GOLDEN_RATIO	0x9e3779b9
-#define rot(x, k) (((x) << (k)) | ((x) >> (32 - (k))))
-#define FWD_BJ3_MIX(a, b, c) \
-{ \
-	a -= c; a ^= rot(c, 4); c += b; \
-	b -= a; b ^= rot(a, 6); a += c; \
-	c -= b; c ^= rot(b, 8); b += a; \
-	a -= c; a ^= rot(c, 16); c += b; \
-	b -= a; b ^= rot(a, 19); a += c; \
-	c -= b; c ^= rot(b, 4); b += a; \
-}
-
-/**
- * Compute hash value from a flow
- */
-static inline
-uint64_t l3fwd_calc_hash(ipv4_tuple5_t *key)
-{
-	uint64_t l4_ports = 0;
-	uint32_t dst_ip, src_ip;
-
-	src_ip = key->src_ip;
-	dst_ip = key->dst_ip + JHASH_GOLDEN_RATIO;
-	FWD_BJ3_MIX(src_ip, dst_ip, l4_ports);
-
-	return l4_ports;
-}
-
 /**
  * Parse text string representing an IPv4 address or subnet
  *
@@ -147,194 +101,53 @@ char *mac_addr_str(char *b, odph_ethaddr_t *mac)
 }
 
 /**
- * Flow cache table entry
+ * Flow table name of the lookup cache
  */
-typedef struct flow_entry_s {
-	ipv4_tuple5_t key;		/**< match key */
-	struct flow_entry_s *next;	/**< next entry in the bucket */
-	fwd_db_entry_t *fwd_entry;	/**< entry info in db */
-} flow_entry_t;
+#define FWD_CACHE_NAME "l3fwd_fwd_cache"
 
 /**
- * Flow cache table bucket
+ * Forward lookup cache. Each worker thread has its own shard, so that
+ * lookups and inserts do not need locks.
  */
-typedef struct flow_bucket_s {
-	odp_rwlock_t	lock;	/**< Bucket lock*/
-	flow_entry_t	*next;	/**< First flow entry in bucket*/
-} flow_bucket_t;
+static odph_flow_table_t fwd_lookup_cache = ODPH_FLOW_TABLE_INVALID;
 
 /**
- * Flow hash table, fast lookup cache
+ * Per flow data in the lookup cache
  */
-typedef struct flow_table_s {
-	odp_rwlock_t flow_lock;	/**< flow table lock*/
-	flow_entry_t *flows;	/**< flow store */
-	flow_bucket_t *bucket;	/**< bucket store */
-	uint32_t bkt_cnt;
-	uint32_t flow_cnt;
-	uint32_t next_flow;	/**< next available flow in the store */
-} flow_table_t;
-
-static flow_table_t fwd_lookup_cache;
-
-static void create_fwd_hash_cache(void)
-{
-	odp_shm_t		hash_shm;
-	flow_bucket_t		*bucket = NULL;
-	flow_entry_t		*flows;
-	uint32_t		bucket_count, flow_count, size;
-	uint32_t		i;
-
-	flow_count = FWD_MAX_FLOW_COUNT;
-	bucket_count = flow_count / FWD_DEF_BUCKET_ENTRIES;
-
-	/*Reserve memory for Routing hash table*/
-	size = sizeof(flow_bucket_t) * bucket_count +
-		sizeof(flow_entry_t) * flow_count;
-	hash_shm = odp_shm_reserve("flow_table", size, ODP_CACHE_LINE_SIZE, 0);
-	if (hash_shm != ODP_SHM_INVALID)
-		bucket = odp_shm_addr(hash_shm);
-
-	if (!bucket) {
-		/* Try the second time with small request */
-		flow_count /= 4;
-		bucket_count = flow_count / FWD_DEF_BUCKET_ENTRIES;
-		size = sizeof(flow_bucket_t) * bucket_count +
-			sizeof(flow_entry_t) * flow_count;
-		hash_shm = odp_shm_reserve("flow_table", size,
-					   ODP_CACHE_LINE_SIZE, 0);
-		if (hash_shm == ODP_SHM_INVALID) {
-			ODPH_ERR("Error: shared mem reserve failed.\n");
-			exit(EXIT_FAILURE);
-		}
-
-		bucket = odp_shm_addr(hash_shm);
-		if (!bucket) {
-			ODPH_ERR("Error: shared mem alloc failed.\n");
-			exit(-1);
-		}
-	}
-
-	size = sizeof(flow_bucket_t) * bucket_count;
-	flows = (flow_entry_t *)(void *)((char *)bucket + size);
-
-	fwd_lookup_cache.bucket = bucket;
-	fwd_lookup_cache.bkt_cnt = bucket_count;
-	fwd_lookup_cache.flows = flows;
-	fwd_lookup_cache.flow_cnt = flow_count;
-
-	/*Initialize bucket locks*/
-	for (i = 0; i < bucket_count; i++) {
-		bucket = &fwd_lookup_cache.bucket[i];
-		odp_rwlock_init(&bucket->lock);
-		bucket->next = NULL;
-	}
-
-	memset(flows, 0, sizeof(flow_entry_t) * flow_count);
-	odp_rwlock_init(&fwd_lookup_cache.flow_lock);
-	fwd_lookup_cache.next_flow = 0;
-}
-
-static inline flow_entry_t *get_new_flow(void)
-{
-	uint32_t next;
-	flow_entry_t *flow = NULL;
-
-	odp_rwlock_write_lock(&fwd_lookup_cache.flow_lock);
-	next = fwd_lookup_cache.next_flow;
-	if (next < fwd_lookup_cache.flow_cnt) {
-		flow = &fwd_lookup_cache.flows[next];
-		fwd_lookup_cache.next_flow++;
-	}
-	odp_rwlock_write_unlock(&fwd_lookup_cache.flow_lock);
-
-	return flow;
-}
+typedef struct {
+	fwd_db_entry_t *fwd_entry;	/**< entry info in db */
+} fwd_cache_data_t;
 
-static inline
-int match_key_flow(ipv4_tuple5_t *key, flow_entry_t *flow)
+void init_fwd_hash_cache(uint32_t num_shards)
 {
-	if (key->hi64 == flow->key.hi64 && key->lo64 == flow->key.lo64)
-		return 1;
+	odph_flow_table_param_t param;
 
-	return 0;
-}
+	odph_flow_table_param_init(&param);
+	param.mode = ODPH_FLOW_TABLE_SHARDED;
+	param.num_shards = num_shards;
+	param.max_flows = FWD_MAX_FLOW_COUNT;
+	param.data_size = sizeof(fwd_cache_data_t);
 
-static inline
-flow_entry_t *lookup_fwd_cache(ipv4_tuple5_t *key, flow_bucket_t *bucket)
-{
-	flow_entry_t *rst;
-
-	odp_rwlock_read_lock(&bucket->lock);
-	for (rst = bucket->next; rst != NULL; rst = rst->next) {
-		if (match_key_flow(key, rst))
-			break;
+	fwd_lookup_cache = odph_flow_table_create(FWD_CACHE_NAME, &param);
+	if (fwd_lookup_cache == ODPH_FLOW_TABLE_INVALID) {
+		/* Try the second time with small request */
+		param.max_flows /= 4;
+		fwd_lookup_cache = odph_flow_table_create(FWD_CACHE_NAME,
+							  &param);
+		if (fwd_lookup_cache == ODPH_FLOW_TABLE_INVALID) {
+			ODPH_ERR("Error: flow table create failed.\n");
+			exit(EXIT_FAILURE);
+		}
 	}
-	odp_rwlock_read_unlock(&bucket->lock);
-
-	return rst;
 }
 
-static inline
-flow_entry_t *insert_fwd_cache(ipv4_tuple5_t *key,
-			       flow_bucket_t *bucket,
-			       fwd_db_entry_t *entry)
+void term_fwd_hash_cache(void)
 {
-	flow_entry_t *flow;
-
-	if (!entry)
-		return NULL;
+	if (fwd_lookup_cache != ODPH_FLOW_TABLE_INVALID &&
+	    odph_flow_table_destroy(fwd_lookup_cache))
+		ODPH_ERR("Error: flow table destroy failed.\n");
 
-	flow = get_new_flow();
-	if (!flow)
-		return NULL;
-
-	flow->key = *key;
-	flow->fwd_entry = entry;
-
-	odp_rwlock_write_lock(&bucket->lock);
-	if (bucket->next)
-		flow->next = bucket->next;
-	bucket->next = flow;
-	odp_rwlock_write_unlock(&bucket->lock);
-
-	return flow;
-}
-
-void init_fwd_hash_cache(void)
-{
-	fwd_db_entry_t *entry;
-	flow_entry_t *flow;
-	flow_bucket_t *bucket;
-	uint64_t hash;
-	uint32_t i, nb_hosts;
-	ipv4_tuple5_t key;
-
-	create_fwd_hash_cache();
-
-	/**
-	 * warm up the lookup cache with possible hosts.
-	 * with millions flows, save significant time during runtime.
-	 */
-	memset(&key, 0, sizeof(key));
-	for (entry = fwd_db->list; NULL != entry; entry = entry->next) {
-		nb_hosts = 1 << (32 - entry->subnet.depth);
-		for (i = 0; i < nb_hosts; i++) {
-			key.dst_ip = entry->subnet.addr + i;
-			hash = l3fwd_calc_hash(&key);
-			hash &= fwd_lookup_cache.bkt_cnt - 1;
-			bucket = &fwd_lookup_cache.bucket[hash];
-			flow = lookup_fwd_cache(&key, bucket);
-			if (flow)
-				return;
-
-			flow = insert_fwd_cache(&key, bucket, entry);
-			if (!flow)
-				goto out;
-		}
-	}
-out:
-	return;
+	fwd_lookup_cache = ODPH_FLOW_TABLE_INVALID;
 }
 
 /** Global pointer to fwd db */
@@ -472,26 +285,9 @@ void dump_fwd_db(void)
 	printf("\n");
 }
 
-fwd_db_entry_t *find_fwd_db_entry(ipv4_tuple5_t *key)
+static fwd_db_entry_t *find_fwd_db_entry(uint32_t dst_ip)
 {
 	fwd_db_entry_t *entry;
-	flow_entry_t *flow;
-	flow_bucket_t *bucket;
-	uint64_t hash;
-	ipv4_tuple5_t newkey;
-
-	newkey.hi64 = 0;
-	newkey.lo64 = 0;
-	newkey.dst_ip = key->dst_ip;
-	key = &newkey;
-
-	/* first find in cache */
-	hash = l3fwd_calc_hash(key);
-	hash &= fwd_lookup_cache.bkt_cnt - 1;
-	bucket = &fwd_lookup_cache.bucket[hash];
-	flow = lookup_fwd_cache(key, bucket);
-	if (flow)
-		return flow->fwd_entry;
 
 	for (entry = fwd_db->list; NULL != entry; entry = entry->next) {
 		uint32_t mask;
@@ -499,11 +295,44 @@ fwd_db_entry_t *find_fwd_db_entry(ipv4_tuple5_t *key)
 		mask = ((1u << entry->subnet.depth) - 1) <<
 			(32 - entry->subnet.depth);
 
-		if (entry->subnet.addr == (key->dst_ip & mask))
+		if (entry->subnet.addr == (dst_ip & mask))
 			break;
 	}
 
-	insert_fwd_cache(key, bucket, entry);
-
 	return entry;
 }
+
+void find_fwd_db_entry_multi(uint32_t shard, const uint32_t dst_ip[],
+			     fwd_db_entry_t *entry[], int num)
+{
+	odph_flow_key_t key[num];
+	void *data[num];
+	fwd_cache_data_t *flow;
+	int i;
+
+	memset(key, 0, sizeof(key));
+
+	/* Flows are identified by destination address only */
+	for (i = 0; i < num; i++)
+		key[i].dst_ip = dst_ip[i];
+
+	/* First find in cache, new flows are inserted with zeroed data */
+	if (odph_flow_table_lookup_insert_multi(fwd_lookup_cache, shard, key,
+						NULL, data, num, NULL) < 0)
+		memset(data, 0, sizeof(data));
+
+	for (i = 0; i < num; i++) {
+		flow = data[i];
+
+		if (odp_likely(flow && flow->fwd_entry)) {
+			entry[i] = flow->fwd_entry;
+			continue;
+		}
+
+		entry[i] = find_fwd_db_entry(dst_ip[i]);
+
+		/* Cache is full when flow is NULL */
+		if (flow)
+			flow->fwd_entry = entry[i];
+	}
+}
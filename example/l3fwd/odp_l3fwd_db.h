@@ -14,7 +14,7 @@ extern "C" {
 #include <odp_api.h>
 #include <odp/helper/odph_api.h>
 
-#define OIF_LEN 32
+#define OIF_LEN 64
 #define MAX_DB  32
 #define MAX_STRING  32
 
@@ -23,11 +23,6 @@ extern "C" {
  */
 #define FWD_MAX_FLOW_COUNT	(1 << 22)
 
-/**
- * Default hash entries in a bucket
- */
-#define FWD_DEF_BUCKET_ENTRIES	4
-
 /**
  * IP address range (subnet)
  */
@@ -36,27 +31,6 @@ typedef struct ip_addr_range_s {
 	uint32_t  depth;    /**< subnet bit width */
 } ip_addr_range_t;
 
-/**
- * TCP/UDP flow
- */
-typedef struct ODP_ALIGNED_CACHE ipv4_tuple5_s {
-	union {
-		struct {
-			int32_t src_ip;
-			int32_t dst_ip;
-			int16_t src_port;
-			int16_t dst_port;
-			int8_t  proto;
-			int8_t  pad1;
-			int16_t pad2;
-		};
-		struct {
-			int64_t hi64;
-			int64_t lo64;
-		};
-	};
-} ipv4_tuple5_t;
-
 /**
  * Forwarding data base entry
  */
@@ -88,8 +62,15 @@ void init_fwd_db(void);
 
 /**
  * Initialize forward lookup cache based on hash
+ *
+ * @param num_shards  Number of cache shards, one per worker thread
+ */
+void init_fwd_hash_cache(uint32_t num_shards);
+
+/**
+ * Destroy forward lookup cache
  */
-void init_fwd_hash_cache(void);
+void term_fwd_hash_cache(void);
 
 /**
  * Create a forwarding database entry
@@ -126,13 +107,19 @@ void dump_fwd_db_entry(fwd_db_entry_t *entry);
 void dump_fwd_db(void);
 
 /**
- * Find a matching forwarding database entry
+ * Find matching forwarding database entries for a burst of packets
  *
- * @param key  ipv4 tuple
+ * Looks up all destination addresses from the lookup cache at once, and
+ * adds the missing ones into the cache.
  *
- * @return pointer to forwarding DB entry else NULL
+ * @param shard   Lookup cache shard of the calling thread
+ * @param dst_ip  Array of destination IPv4 addresses, host endianness
+ * @param entry   Array for pointers to forwarding DB entries, NULL when
+ *                no entry matches
+ * @param num     Number of addresses, max ODPH_FLOW_TABLE_MULTI_MAX
  */
-fwd_db_entry_t *find_fwd_db_entry(ipv4_tuple5_t *key);
+void find_fwd_db_entry_multi(uint32_t shard, const uint32_t dst_ip[],
+			     fwd_db_entry_t *entry[], int num);
 
 #ifdef __cplusplus
 }
@@ -16,214 +16,83 @@
 #include <odp_l3fwd_lpm.h>
 
 /**
- * This is a simple implementation of lpm based on patricia tree.
+ * LPM based on the helper IP lookup table (DIR-24-8).
  *
- * Tradeoff exists between memory consumption and lookup time.
- * Currently it prefers 5 levels: {16, 4, 4, 4, 4}, could be 3
- * levels: {16, 8, 8} by defining FIB_NEXT_STRIDE as 8. Other
- * levels are also possible.
+ * Lookups do not take locks. A burst of addresses is looked up with
+ * fib_tbl_lookup_multi(), which prefetches table entries of all addresses
+ * before reading any of them.
  *
- * the ip here is host endian, when doing init or lookup, the
+ * The ip here is host endian, when doing init or lookup, the
  * caller should do endianness conversion if needed.
  */
 
-#define FIB_IP_WIDTH 32
-#define FIB_FIRST_STRIDE 16
-#define FIB_NEXT_STRIDE 4
-#define FIB_NEXT_SIZE (1 << FIB_NEXT_STRIDE)
-#define FIB_SUB_COUNT 16384
-#define DEPTH_TO_MASK(depth) ((1 << (depth)) - 1)
-
-typedef struct fib_node_s {
-	union {
-		uint32_t next_hop;
-		struct fib_node_s *next; /* next level table */
-	};
-	uint8_t valid	:1; /* 1, this node has a valid next hop */
-	uint8_t end	:1; /* 0, next points to the extended table */
-	uint8_t depth	:6; /* bit length of subnet mask */
-} fib_node_t;
-
-typedef struct fib_sub_tbl_s {
-	fib_node_t *fib_nodes;
-	uint32_t fib_count;
-	uint32_t fib_idx;
-} fib_sub_tbl_t;
-
-static fib_node_t fib_rt_tbl[1 << FIB_FIRST_STRIDE];
-static fib_sub_tbl_t fib_lpm_cache;
-
-static inline fib_node_t *fib_alloc_sub(void)
-{
-	fib_node_t *sub_tbl = NULL;
-	uint32_t i, nb_entry;
-
-	/* extend to next level */
-	if (fib_lpm_cache.fib_idx < fib_lpm_cache.fib_count) {
-		nb_entry = (fib_lpm_cache.fib_idx + 1) * FIB_NEXT_SIZE;
-		sub_tbl = &fib_lpm_cache.fib_nodes[nb_entry];
-		fib_lpm_cache.fib_idx++;
-		for (i = 0; i < nb_entry; i++) {
-			sub_tbl[i].valid = 0;
-			sub_tbl[i].end = 1;
-		}
-	}
+#define FIB_TBL_NAME	"l3fwd_fib"
 
-	return sub_tbl;
-}
+static odph_table_t fib_tbl;
 
-static void fib_update_node(fib_node_t *fe, int port, int depth)
+void fib_tbl_init(void)
 {
-	fib_node_t *p;
-	int i;
-
-	if (fe->end) {
-		if (!fe->valid) {
-			fe->depth = depth;
-			fe->next_hop = port;
-			fe->valid = 1;
-		} else if (fe->depth <= depth) {
-			fe->next_hop = port;
-			fe->depth = depth;
-		}
-
-		return;
-	}
-
-	for (i = 0; i < FIB_NEXT_SIZE; i++) {
-		p = &fe->next[i];
-		if (p->end)
-			fib_update_node(p, port, depth);
+	fib_tbl = odph_iplookup_table_create(FIB_TBL_NAME, 0, 0,
+					     sizeof(uintptr_t));
+	if (fib_tbl == NULL) {
+		ODPH_ERR("Error: FIB table create failed.\n");
+		exit(EXIT_FAILURE);
 	}
 }
 
-static void fib_insert_node(fib_node_t *fe, uint32_t ip, uint32_t next_hop,
-			    int ip_width, int eat_bits, int depth)
+void fib_tbl_term(void)
 {
-	int i;
-	uint32_t idx, port;
-	fib_node_t *p;
-
-	if (fe->end) {
-		port = fe->next_hop;
-		p = fib_alloc_sub();
-		if (!p)
-			return;
-
-		fe->next = p;
-		fe->end = 0;
-		if (fe->valid) {
-			for (i = 0; i < FIB_NEXT_SIZE; i++) {
-				p = &fe->next[i];
-				p->next_hop = port;
-				p->depth = fe->depth;
-			}
-		}
-	}
-	if (depth - eat_bits <= FIB_NEXT_STRIDE) {
-		ip_width -= depth - eat_bits;
-		idx = ip >> ip_width;
-		ip &= DEPTH_TO_MASK(ip_width);
-		p = &fe->next[idx];
-		fib_update_node(p, next_hop, depth);
-	} else {
-		ip_width -= FIB_NEXT_STRIDE;
-		idx = ip >> ip_width;
-		p = &fe->next[idx];
-		ip &= DEPTH_TO_MASK(ip_width);
-		eat_bits += FIB_NEXT_STRIDE;
-		fib_insert_node(p, ip, next_hop, ip_width, eat_bits, depth);
-	}
+	if (fib_tbl != NULL && odph_iplookup_table_destroy(fib_tbl))
+		ODPH_ERR("Error: FIB table destroy failed.\n");
+
+	fib_tbl = NULL;
 }
 
-void fib_tbl_init(void)
+void fib_tbl_insert(uint32_t ip, int port, int depth)
 {
-	int i;
-	fib_node_t *fe;
-	uint32_t size;
-	odp_shm_t lpm_shm;
-
-	for (i = 0; i < (1 << FIB_FIRST_STRIDE); i++) {
-		fe = &fib_rt_tbl[i];
-		fe->valid = 0;
-		fe->end = 1;
-		fe->depth = 0;
-		fe->next_hop = 0;
-	}
+	odph_iplookup_prefix_t prefix;
+	uintptr_t value = port;
 
-	size = FIB_NEXT_SIZE * FIB_SUB_COUNT;
-	/*Reserve memory for Routing hash table*/
-	lpm_shm = odp_shm_reserve("fib_lpm_sub", size, ODP_CACHE_LINE_SIZE, 0);
-	if (lpm_shm == ODP_SHM_INVALID) {
-		ODPH_ERR("Error: shared mem reserve failed.\n");
-		exit(EXIT_FAILURE);
-	}
-
-	fe = odp_shm_addr(lpm_shm);
-	if (!fe) {
-		ODPH_ERR("Error: shared mem alloc failed for lpm cache.\n");
-		exit(-1);
-	}
+	prefix.ip = ip;
+	prefix.cidr = depth;
 
-	fib_lpm_cache.fib_nodes = fe;
-	fib_lpm_cache.fib_count = FIB_SUB_COUNT;
-	fib_lpm_cache.fib_idx = 0;
+	if (odph_iplookup_table_put_value(fib_tbl, &prefix, &value) < 0)
+		ODPH_ERR("Error: FIB insert failed.\n");
 }
 
-void fib_tbl_insert(uint32_t ip, int port, int depth)
+int fib_tbl_lookup(uint32_t ip, int *port)
 {
-	fib_node_t *fe, *p;
-	uint32_t idx;
-	int i, j;
-	int nb_bits;
-
-	nb_bits = FIB_FIRST_STRIDE;
-	idx = ip >> (FIB_IP_WIDTH - nb_bits);
-	fe = &fib_rt_tbl[idx];
-	if (depth <= nb_bits) {
-		if (fe->end) {
-			fe->next_hop = port;
-			fe->depth = depth;
-			fe->valid = 1;
-			return;
-		}
-
-		for (i = 0; i < FIB_NEXT_SIZE; i++) {
-			p = &fe->next[i];
-			if (p->end)
-				fib_update_node(p, port, depth);
-			else
-				for (j = 0; j < FIB_NEXT_SIZE; j++)
-					fib_update_node(&p->next[j], port,
-							depth);
-		}
-
-		return;
-	}
+	uint64_t hit_mask;
+
+	if (fib_tbl_lookup_multi(&ip, port, 1, &hit_mask) < 1)
+		return -1;
 
-	/* need to check sub table */
-	ip &= DEPTH_TO_MASK(FIB_IP_WIDTH - nb_bits);
-	fib_insert_node(fe, ip, port, FIB_IP_WIDTH - nb_bits, nb_bits, depth);
+	return 0;
 }
 
-int fib_tbl_lookup(uint32_t ip, int *port)
+int fib_tbl_lookup_multi(uint32_t ip[], int port[], int num,
+			 uint64_t *hit_mask)
 {
-	fib_node_t *fe;
-	uint32_t idx;
-	int nb_bits;
-
-	nb_bits = FIB_IP_WIDTH - FIB_FIRST_STRIDE;
-	idx = ip >> nb_bits;
-	fe = &fib_rt_tbl[idx];
-
-	ip &= DEPTH_TO_MASK(nb_bits);
-	while (!fe->end) {
-		nb_bits -= FIB_NEXT_STRIDE;
-		idx = ip >> nb_bits;
-		fe = &fe->next[idx];
-		ip &= DEPTH_TO_MASK(nb_bits);
+	void *key[num];
+	void *buf[num];
+	uintptr_t value[num];
+	int i, ret;
+
+	for (i = 0; i < num; i++) {
+		key[i] = &ip[i];
+		buf[i] = &value[i];
 	}
-	*port = fe->next_hop;
 
-	return fe->valid ? 0 : -1;
+	ret = odph_iplookup_table_get_value_multi(fib_tbl, key, buf,
+						  sizeof(uintptr_t), num,
+						  hit_mask);
+	if (odp_unlikely(ret < 0)) {
+		*hit_mask = 0;
+		return ret;
+	}
+
+	for (i = 0; i < num; i++)
+		port[i] = (int)value[i];
+
+	return ret;
 }
@@ -11,8 +11,20 @@
 extern "C" {
 #endif
 void fib_tbl_init(void);
+void fib_tbl_term(void);
 void fib_tbl_insert(uint32_t ip, int port, int depth);
 int fib_tbl_lookup(uint32_t ip, int *port);
+
+/**
+ * Look up a burst of addresses
+ *
+ * Writes output port of each matched address into 'port' and sets
+ * a bit in 'hit_mask' for it (bit 0 for ip[0], etc.).
+ *
+ * @return Number of matched addresses, or <0 on failure
+ */
+int fib_tbl_lookup_multi(uint32_t ip[], int port[], int num,
+			 uint64_t *hit_mask);
 #ifdef __cplusplus
 }
 #endif
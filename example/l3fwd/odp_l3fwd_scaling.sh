@@ -0,0 +1,75 @@
+#!/bin/sh
+#
+# Copyright (c) 2022, Nokia
+# All rights reserved.
+#
+# SPDX-License-Identifier:	BSD-3-Clause
+#
+# Script that runs odp_l3fwd with an increasing number of worker threads and
+# reports the forwarding rate (Mpps) for each worker count.
+#
+# Usage: odp_l3fwd_scaling.sh [IF0 IF1]
+#
+# By default, both interfaces are pcap interfaces, which replay PCAP_IN
+# from memory in a loop and drop transmitted packets. Received packets are
+# spread over input queues with the flow hash, so for meaningful results
+# the input file should contain many flows, or real interfaces should be
+# used instead.
+#
+# Environment variables:
+#   PCAP_IN   Input pcap file (default: udp64.pcap)
+#   ROUTE     Route of packets received from both interfaces
+#             (default: 10.0.0.0/8 via IF1)
+#   WORKERS   Worker counts to test (default: 1 2 4 ... up to CPU count)
+#   DURATION  Seconds to run each test (default: 5)
+#   STYLE     Lookup style, lpm or hash (default: lpm)
+
+TEST_DIR="${TEST_DIR:-$(dirname $0)}"
+PCAP_IN="${PCAP_IN:-$(find . ${TEST_DIR} -name udp64.pcap -print -quit)}"
+DURATION="${DURATION:-5}"
+STYLE="${STYLE:-lpm}"
+
+if [ $# -ge 2 ]; then
+	IF0=$1
+	IF1=$2
+else
+	IF0=pcap:in=${PCAP_IN}:mem=1:loops=0
+	IF1=pcap:in=${PCAP_IN}:mem=1:loops=0
+fi
+
+ROUTE="${ROUTE:-10.0.0.0/8,$IF1}"
+
+if [ -z "${WORKERS}" ]; then
+	MAX=$(($(nproc) - 1))
+	[ ${MAX} -lt 1 ] && MAX=1
+	WORKERS=1
+	NUM=2
+	while [ ${NUM} -le ${MAX} ]; do
+		WORKERS="${WORKERS} ${NUM}"
+		NUM=$((NUM * 2))
+	done
+fi
+
+RESULTS=""
+
+for NUM in ${WORKERS}; do
+	echo odp_l3fwd_scaling starts with ${NUM} worker threads
+	echo ===================================================
+
+	PPS=$(${TEST_DIR}/odp_l3fwd${EXEEXT} -i $IF0,$IF1 -r "$ROUTE" \
+	      -s ${STYLE} -t ${NUM} -d ${DURATION} | tee /dev/stderr | \
+	      sed -n 's/^TEST RESULT: \([0-9]*\) .*/\1/p')
+
+	if [ -z "${PPS}" ]; then
+		echo "Error: odp_l3fwd failed with ${NUM} workers"
+		exit 1
+	fi
+
+	RESULTS="${RESULTS}${NUM} ${PPS}\n"
+done
+
+echo
+echo "workers    Mpps"
+printf "${RESULTS}" | awk '{ printf "%7d  %6.2f\n", $1, $2 / 1000000 }'
+
+exit 0
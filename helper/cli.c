@@ -10,14 +10,22 @@
 #include <libcli.h>
 #include <sys/types.h>
 #include <sys/socket.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
 #include <arpa/inet.h>
 #include <netinet/in.h>
 #include <unistd.h>
 #include <errno.h>
 #include <poll.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <ctype.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <strings.h>
 #include <inttypes.h>
+#include <time.h>
 
 /* Socketpair socket roles. */
 enum {
@@ -27,6 +35,16 @@ enum {
 
 #define MAX_NAME_LEN 20
 #define MAX_HELP_LEN 100
+#define MAX_COUNTER_NAME_LEN 32
+
+/* Maximum number of attempts to read a consistent counter snapshot */
+#define STATS_READ_RETRY 8
+/* Maximum length of a statistics request line */
+#define STATS_REQ_LEN 64
+#define STATS_MAX_EVENTS 16
+/* Epoll user data of the statistics server descriptors other than clients */
+#define STATS_EV_STOP UINT32_MAX
+#define STATS_EV_LISTEN (UINT32_MAX - 1)
 
 typedef struct {
 	odph_cli_user_cmd_func_t fn;
@@ -34,6 +52,26 @@ typedef struct {
 	char help[MAX_HELP_LEN];
 } user_cmd_t;
 
+/*
+ * Counter snapshot of one thread. Written only by the owner thread and read
+ * by the CLI and statistics server threads. The sequence number is odd
+ * while the owner is updating the counters, readers retry if it changes
+ * during the read.
+ */
+typedef struct ODP_ALIGNED_CACHE {
+	odp_atomic_u32_t seq;
+	uint32_t num;
+	uint64_t counter[ODPH_CLI_STATS_MAX_COUNTERS];
+} stats_slot_t;
+
+/* Consistent copy of a counter snapshot */
+typedef struct {
+	/* Number of counters, 0 if none published, -1 if busy */
+	int num;
+	uint32_t updates;
+	uint64_t counter[ODPH_CLI_STATS_MAX_COUNTERS];
+} stats_copy_t;
+
 typedef struct {
 	volatile int cli_fd;
 	/* Server will exit if this is false. */
@@ -46,6 +84,11 @@ typedef struct {
 	odp_spinlock_t api_lock;
 	odph_cli_param_t cli_param;
 	struct sockaddr_in addr;
+	struct sockaddr_in stats_addr;
+	int stats_listen_fd;
+	uint32_t num_counters;
+	char counter_name[ODPH_CLI_STATS_MAX_COUNTERS][MAX_COUNTER_NAME_LEN];
+	stats_slot_t stats[ODP_THREAD_COUNT_MAX];
 	uint32_t num_user_commands;
 	user_cmd_t user_cmd[];
 } cli_shm_t;
@@ -57,8 +100,16 @@ static const odph_cli_param_t param_default = {
 	.port = 55555,
 	.max_user_commands = 50,
 	.hostname = "ODP",
+	.stats_port = 0,
+	.stats_max_clients = 16,
 };
 
+/*
+ * Process local CLI shm pointer for odph_cli_stats_publish(). Set in
+ * odph_cli_init(), or looked up on first use in processes created before it.
+ */
+static cli_shm_t *stats_shm;
+
 void odph_cli_param_init(odph_cli_param_t *param)
 {
 	*param = param_default;
@@ -86,7 +137,7 @@ int odph_cli_init(const odph_cli_param_t *param)
 	int shm_size = sizeof(cli_shm_t) +
 		param->max_user_commands * sizeof(user_cmd_t);
 	odp_shm_t shm_hdl =
-		odp_shm_reserve(shm_name, shm_size, 64, 0);
+		odp_shm_reserve(shm_name, shm_size, ODP_CACHE_LINE_SIZE, 0);
 
 	if (shm_hdl != ODP_SHM_INVALID)
 		shm = (cli_shm_t *)odp_shm_addr(shm_hdl);
@@ -101,6 +152,10 @@ int odph_cli_init(const odph_cli_param_t *param)
 	odp_spinlock_init(&shm->api_lock);
 	shm->listen_fd = -1;
 	shm->cli_fd = -1;
+	shm->stats_listen_fd = -1;
+
+	for (int i = 0; i < ODP_THREAD_COUNT_MAX; i++)
+		odp_atomic_init_u32(&shm->stats[i].seq, 0);
 
 	shm->addr.sin_family = AF_INET;
 	shm->addr.sin_port = htons(param->port);
@@ -116,12 +171,16 @@ int odph_cli_init(const odph_cli_param_t *param)
 		break;
 	}
 
+	shm->stats_addr = shm->addr;
+	shm->stats_addr.sin_port = htons(param->stats_port);
+
 	if (socketpair(PF_LOCAL, SOCK_STREAM, 0, shm->sp)) {
 		ODPH_ERR("Error: socketpair(): %s\n", strerror(errno));
 		return -1;
 	}
 
 	shm->cli_param = *param;
+	stats_shm = shm;
 
 	return 0;
 }
@@ -176,6 +235,241 @@ error:
 	return -1;
 }
 
+int odph_cli_stats_register(const char *name)
+{
+	cli_shm_t *shm = shm_lookup();
+	int idx = -1;
+
+	if (!shm) {
+		ODPH_ERR("Error: shm %s not found\n", shm_name);
+		return -1;
+	}
+
+	if (strlen(name) == 0 || strlen(name) >= MAX_COUNTER_NAME_LEN) {
+		ODPH_ERR("Error: bad counter name length\n");
+		return -1;
+	}
+
+	/* Names are printed in JSON without escaping */
+	for (const char *c = name; *c; c++) {
+		if (!isalnum((unsigned char)*c) && *c != '_' && *c != '-' && *c != '.') {
+			ODPH_ERR("Error: bad character in counter name\n");
+			return -1;
+		}
+	}
+
+	odp_spinlock_lock(&shm->api_lock);
+
+	odp_spinlock_lock(&shm->lock);
+	if (shm->run) {
+		odp_spinlock_unlock(&shm->lock);
+		ODPH_ERR("Error: cannot register counters while cli server is running\n");
+		goto out;
+	}
+	odp_spinlock_unlock(&shm->lock);
+
+	if (shm->num_counters >= ODPH_CLI_STATS_MAX_COUNTERS) {
+		ODPH_ERR("Error: maximum number of counters already registered\n");
+		goto out;
+	}
+
+	idx = shm->num_counters++;
+	strcpy(shm->counter_name[idx], name);
+
+out:
+	odp_spinlock_unlock(&shm->api_lock);
+	return idx;
+}
+
+void odph_cli_stats_publish(const uint64_t counter[], uint32_t num)
+{
+	cli_shm_t *shm = stats_shm;
+
+	if (odp_unlikely(!shm)) {
+		shm = shm_lookup();
+		if (!shm)
+			return;
+		stats_shm = shm;
+	}
+
+	stats_slot_t *slot = &shm->stats[odp_thread_id()];
+	uint32_t seq = odp_atomic_load_u32(&slot->seq);
+
+	if (odp_unlikely(num > ODPH_CLI_STATS_MAX_COUNTERS))
+		num = ODPH_CLI_STATS_MAX_COUNTERS;
+
+	/* Odd sequence number must be visible before any counter update */
+	odp_atomic_store_u32(&slot->seq, seq + 1);
+	odp_mb_release();
+
+	memcpy(slot->counter, counter, num * sizeof(uint64_t));
+	slot->num = num;
+
+	odp_atomic_store_rel_u32(&slot->seq, seq + 2);
+}
+
+/*
+ * Take a consistent copy of a counter snapshot. Gives up after a few
+ * attempts, so that readers never wait for a thread which is updating its
+ * counters.
+ */
+static void stats_read(cli_shm_t *shm, int thr, stats_copy_t *copy)
+{
+	stats_slot_t *slot = &shm->stats[thr];
+
+	copy->num = -1;
+
+	for (int i = 0; i < STATS_READ_RETRY; i++) {
+		uint32_t seq = odp_atomic_load_acq_u32(&slot->seq);
+		uint32_t num;
+
+		if (seq == 0) {
+			copy->num = 0;
+			return;
+		}
+
+		if (seq & 1) {
+			odp_cpu_pause();
+			continue;
+		}
+
+		num = slot->num;
+		memcpy(copy->counter, slot->counter, sizeof(copy->counter));
+		odp_mb_acquire();
+
+		if (odp_atomic_load_u32(&slot->seq) == seq) {
+			copy->num = num < shm->num_counters ? num : shm->num_counters;
+			copy->updates = seq / 2;
+			return;
+		}
+	}
+}
+
+typedef struct {
+	char *buf;
+	size_t size;
+	size_t len;
+	/* Set when buffer could not be grown */
+	int error;
+} strbuf_t;
+
+ODP_PRINTF_FORMAT(2, 3)
+static void strbuf_printf(strbuf_t *sb, const char *fmt, ...)
+{
+	va_list args;
+	int n;
+
+	if (sb->error)
+		return;
+
+	va_start(args, fmt);
+	n = vsnprintf(sb->buf + sb->len, sb->size - sb->len, fmt, args);
+	va_end(args);
+
+	if (n < 0)
+		return;
+
+	if ((size_t)n >= sb->size - sb->len) {
+		size_t size = sb->size;
+		char *buf;
+
+		while ((size_t)n >= size - sb->len)
+			size *= 2;
+
+		buf = realloc(sb->buf, size);
+		if (!buf) {
+			sb->error = 1;
+			return;
+		}
+
+		sb->buf = buf;
+		sb->size = size;
+
+		va_start(args, fmt);
+		n = vsnprintf(sb->buf + sb->len, sb->size - sb->len, fmt, args);
+		va_end(args);
+	}
+
+	sb->len += n;
+}
+
+/*
+ * Format a snapshot of all published counters as a single JSON line. Returns
+ * a string allocated with malloc(), or NULL on failure.
+ */
+static char *stats_json(cli_shm_t *shm, size_t *len)
+{
+	uint64_t total[ODPH_CLI_STATS_MAX_COUNTERS] = { 0 };
+	size_t counters_len = shm->num_counters * (MAX_COUNTER_NAME_LEN + 24);
+	strbuf_t sb;
+	stats_copy_t copy;
+	struct timespec ts;
+	int first = 1;
+	int num_thr = 0;
+
+	/* Size the buffer for the threads that have published counters. The
+	 * buffer grows, if more threads publish during formatting. */
+	for (int thr = 0; thr < ODP_THREAD_COUNT_MAX; thr++) {
+		if (odp_atomic_load_u32(&shm->stats[thr].seq))
+			num_thr++;
+	}
+
+	sb.size = 96 + counters_len + num_thr * (64 + counters_len);
+	sb.len = 0;
+	sb.error = 0;
+	sb.buf = malloc(sb.size);
+
+	if (!sb.buf)
+		return NULL;
+
+	clock_gettime(CLOCK_REALTIME, &ts);
+	strbuf_printf(&sb, "{\"time_ns\":%" PRIu64 ",\"threads\":[",
+		      (uint64_t)(ts.tv_sec * ODP_TIME_SEC_IN_NS + ts.tv_nsec));
+
+	for (int thr = 0; thr < ODP_THREAD_COUNT_MAX; thr++) {
+		stats_read(shm, thr, &copy);
+
+		if (copy.num == 0)
+			continue;
+
+		strbuf_printf(&sb, "%s{\"thread\":%d", first ? "" : ",", thr);
+		first = 0;
+
+		if (copy.num < 0) {
+			strbuf_printf(&sb, ",\"busy\":true}");
+			continue;
+		}
+
+		strbuf_printf(&sb, ",\"updates\":%" PRIu32 ",\"counters\":{",
+			      copy.updates);
+
+		for (int i = 0; i < copy.num; i++) {
+			strbuf_printf(&sb, "%s\"%s\":%" PRIu64, i ? "," : "",
+				      shm->counter_name[i], copy.counter[i]);
+			total[i] += copy.counter[i];
+		}
+
+		strbuf_printf(&sb, "}}");
+	}
+
+	strbuf_printf(&sb, "],\"total\":{");
+
+	for (uint32_t i = 0; i < shm->num_counters; i++)
+		strbuf_printf(&sb, "%s\"%s\":%" PRIu64, i ? "," : "",
+			      shm->counter_name[i], total[i]);
+
+	strbuf_printf(&sb, "}}\n");
+
+	if (sb.error) {
+		free(sb.buf);
+		return NULL;
+	}
+
+	*len = sb.len;
+
+	return sb.buf;
+}
+
 /*
  * Check that number of given arguments matches required number of
  * arguments. Print error messages if this is not the case. Return 0
@@ -319,6 +613,30 @@ static int cmd_call_odp_ipsec_print(struct cli_def *cli,
 	return CLI_OK;
 }
 
+static int cmd_call_odp_schedule_print(struct cli_def *cli,
+				       const char *command ODP_UNUSED,
+				       char *argv[] ODP_UNUSED, int argc)
+{
+	if (check_num_args(cli, argc, 0))
+		return CLI_ERROR;
+
+	odp_schedule_print();
+
+	return CLI_OK;
+}
+
+static int cmd_call_odp_schedule_stats_print(struct cli_def *cli,
+					     const char *command ODP_UNUSED,
+					     char *argv[] ODP_UNUSED, int argc)
+{
+	if (check_num_args(cli, argc, 0))
+		return CLI_ERROR;
+
+	odp_schedule_stats_print();
+
+	return CLI_OK;
+}
+
 static int cmd_call_odp_shm_print_all(struct cli_def *cli,
 				      const char *command ODP_UNUSED,
 				      char *argv[] ODP_UNUSED, int argc)
@@ -647,6 +965,109 @@ static int cmd_pktio_event_queue_stats_print(struct cli_def *cli, const char *co
 	return CLI_OK;
 }
 
+static int cmd_stats_print(struct cli_def *cli, const char *command ODP_UNUSED, char *argv[],
+			   int argc)
+{
+	cli_shm_t *shm = shm_lookup();
+
+	if (!shm) {
+		ODPH_ERR("Error: shm %s not found\n", shm_name);
+		return CLI_ERROR;
+	}
+
+	if (argc > 1 || (argc == 1 && strcasecmp(argv[0], "json"))) {
+		cli_error(cli, "%% Invalid parameter.");
+		return CLI_ERROR;
+	}
+
+	if (argc == 1) {
+		size_t len;
+		char *str = stats_json(shm, &len);
+
+		if (!str) {
+			cli_error(cli, "%% Out of memory.");
+			return CLI_ERROR;
+		}
+
+		cli_log(ODP_LOG_PRINT, "%s", str);
+		free(str);
+
+		return CLI_OK;
+	}
+
+	uint64_t total[ODPH_CLI_STATS_MAX_COUNTERS] = { 0 };
+	stats_copy_t copy;
+
+	cli_log(ODP_LOG_PRINT, "Thread statistics\n-----------------\n");
+
+	for (int thr = 0; thr < ODP_THREAD_COUNT_MAX; thr++) {
+		stats_read(shm, thr, &copy);
+
+		if (copy.num == 0)
+			continue;
+
+		cli_log(ODP_LOG_PRINT, "Thread: %d:\n", thr);
+
+		if (copy.num < 0) {
+			cli_log(ODP_LOG_PRINT, "  (Busy, skipping)\n");
+			continue;
+		}
+
+		cli_log(ODP_LOG_PRINT, "  updates: %" PRIu32 "\n", copy.updates);
+
+		for (int i = 0; i < copy.num; i++) {
+			cli_log(ODP_LOG_PRINT, "  %s: %" PRIu64 "\n", shm->counter_name[i],
+				copy.counter[i]);
+			total[i] += copy.counter[i];
+		}
+	}
+
+	cli_log(ODP_LOG_PRINT, "Total:\n");
+
+	for (uint32_t i = 0; i < shm->num_counters; i++)
+		cli_log(ODP_LOG_PRINT, "  %s: %" PRIu64 "\n", shm->counter_name[i], total[i]);
+
+	cli_log(ODP_LOG_PRINT, "\n");
+
+	return CLI_OK;
+}
+
+static int cmd_thread_poll_stats_print(struct cli_def *cli, const char *command ODP_UNUSED,
+				       char *argv[] ODP_UNUSED, int argc)
+{
+	odph_thread_poll_stats_t stats;
+
+	if (check_num_args(cli, argc, 0))
+		return CLI_ERROR;
+
+	if (odph_thread_poll_stats(0, &stats)) {
+		cli_error(cli, "%% Poll statistics not initialized.");
+		return CLI_ERROR;
+	}
+
+	cli_log(ODP_LOG_PRINT, "Thread poll statistics\n----------------------\n");
+
+	for (int thr = 0; thr < ODP_THREAD_COUNT_MAX; thr++) {
+		if (odph_thread_poll_stats(thr, &stats) ||
+		    (stats.busy_polls == 0 && stats.idle_polls == 0))
+			continue;
+
+		uint64_t cycles = stats.busy_cycles + stats.idle_cycles;
+
+		cli_log(ODP_LOG_PRINT, "Thread: %d:\n", thr);
+		cli_log(ODP_LOG_PRINT, "  busy_cycles: %" PRIu64 "\n", stats.busy_cycles);
+		cli_log(ODP_LOG_PRINT, "  idle_cycles: %" PRIu64 "\n", stats.idle_cycles);
+		cli_log(ODP_LOG_PRINT, "  busy_polls: %" PRIu64 "\n", stats.busy_polls);
+		cli_log(ODP_LOG_PRINT, "  idle_polls: %" PRIu64 "\n", stats.idle_polls);
+		cli_log(ODP_LOG_PRINT, "  utilization: %.1f%%\n",
+			cycles ? 100.0 * stats.busy_cycles / cycles : 0.0);
+	}
+
+	cli_log(ODP_LOG_PRINT, "\n");
+
+	return CLI_OK;
+}
+
 static int cmd_user_cmd(struct cli_def *cli ODP_UNUSED, const char *command,
 			char *argv[], int argc)
 {
@@ -700,6 +1121,12 @@ static struct cli_def *create_cli(cli_shm_t *shm)
 	cli_register_command(cli, c, "odp_queue_print_all",
 			     cmd_call_odp_queue_print_all,
 			     PRIVILEGE_UNPRIVILEGED, MODE_EXEC, NULL);
+	cli_register_command(cli, c, "odp_schedule_print",
+			     cmd_call_odp_schedule_print,
+			     PRIVILEGE_UNPRIVILEGED, MODE_EXEC, NULL);
+	cli_register_command(cli, c, "odp_schedule_stats_print",
+			     cmd_call_odp_schedule_stats_print,
+			     PRIVILEGE_UNPRIVILEGED, MODE_EXEC, NULL);
 	cli_register_command(cli, c, "odp_shm_print_all",
 			     cmd_call_odp_shm_print_all,
 			     PRIVILEGE_UNPRIVILEGED, MODE_EXEC, NULL);
@@ -721,6 +1148,13 @@ static struct cli_def *create_cli(cli_shm_t *shm)
 	cli_register_command(cli, NULL, "pktio_event_queue_stats_print",
 			     cmd_pktio_event_queue_stats_print,
 			     PRIVILEGE_UNPRIVILEGED, MODE_EXEC, "<name>");
+	cli_register_command(cli, NULL, "stats",
+			     cmd_stats_print,
+			     PRIVILEGE_UNPRIVILEGED, MODE_EXEC,
+			     "Print thread statistics counters. [json]");
+	cli_register_command(cli, NULL, "thread_poll_stats_print",
+			     cmd_thread_poll_stats_print,
+			     PRIVILEGE_UNPRIVILEGED, MODE_EXEC, NULL);
 
 	for (uint32_t i = 0; i < shm->num_user_commands; i++) {
 		cli_register_command(cli, NULL, shm->user_cmd[i].name,
@@ -779,6 +1213,354 @@ static int msg_send(int fd)
 	return 0;
 }
 
+typedef struct {
+	int fd;
+	uint32_t idx;
+	uint32_t events;
+	uint32_t in_len;
+	char in[STATS_REQ_LEN];
+	/* Response which has not been completely sent yet */
+	char *out;
+	size_t out_len;
+	size_t out_pos;
+} stats_client_t;
+
+/* Not shared, used only in the server and statistics server threads. */
+static pthread_t stats_thread;
+static int stats_stop_fd = -1;
+
+static int stats_client_events(int epfd, stats_client_t *c, uint32_t events)
+{
+	struct epoll_event ev = { .events = events, .data.u32 = c->idx };
+
+	if (c->events == events)
+		return 0;
+
+	if (epoll_ctl(epfd, EPOLL_CTL_MOD, c->fd, &ev)) {
+		ODPH_ERR("Error: epoll_ctl(): %s\n", strerror(errno));
+		return -1;
+	}
+
+	c->events = events;
+
+	return 0;
+}
+
+static void stats_client_close(stats_client_t *c)
+{
+	/* Closing the socket removes it from the epoll set */
+	close(c->fd);
+	free(c->out);
+	c->fd = -1;
+	c->out = NULL;
+}
+
+/*
+ * Send as much of the pending response as the socket accepts. While a
+ * response is pending, the client waits for EPOLLOUT and further requests
+ * are not read.
+ */
+static int stats_client_flush(int epfd, stats_client_t *c)
+{
+	while (c->out_pos < c->out_len) {
+		ssize_t num = send(c->fd, c->out + c->out_pos, c->out_len - c->out_pos,
+				   MSG_DONTWAIT | MSG_NOSIGNAL);
+
+		if (num < 0) {
+			if (errno == EINTR)
+				continue;
+
+			if (errno == EAGAIN || errno == EWOULDBLOCK)
+				return stats_client_events(epfd, c, EPOLLOUT);
+
+			return -1;
+		}
+
+		c->out_pos += num;
+	}
+
+	free(c->out);
+	c->out = NULL;
+
+	return stats_client_events(epfd, c, EPOLLIN);
+}
+
+static int stats_client_recv(stats_client_t *c)
+{
+	ssize_t num = recv(c->fd, c->in + c->in_len, sizeof(c->in) - c->in_len,
+			   MSG_DONTWAIT);
+
+	if (num < 0)
+		return (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) ? 0 : -1;
+
+	/* Connection closed by the client */
+	if (num == 0)
+		return -1;
+
+	c->in_len += num;
+
+	return 0;
+}
+
+static char *stats_request(cli_shm_t *shm, const char *req, size_t *len)
+{
+	static const char unknown[] = "{\"error\":\"unknown request\"}\n";
+	char *str;
+
+	if (!strcmp(req, "stats"))
+		return stats_json(shm, len);
+
+	str = malloc(sizeof(unknown));
+	if (str) {
+		memcpy(str, unknown, sizeof(unknown));
+		*len = sizeof(unknown) - 1;
+	}
+
+	return str;
+}
+
+/* Respond to complete request lines received from a client. */
+static int stats_client_process(cli_shm_t *shm, int epfd, stats_client_t *c)
+{
+	while (!c->out) {
+		char *nl = memchr(c->in, '\n', c->in_len);
+		uint32_t consumed;
+
+		if (!nl) {
+			/* Request too long */
+			if (c->in_len == sizeof(c->in))
+				return -1;
+
+			return 0;
+		}
+
+		consumed = nl - c->in + 1;
+		*nl = 0;
+
+		if (nl > c->in && nl[-1] == '\r')
+			nl[-1] = 0;
+
+		if (c->in[0]) {
+			c->out = stats_request(shm, c->in, &c->out_len);
+			c->out_pos = 0;
+
+			if (!c->out) {
+				ODPH_ERR("Error: malloc failed\n");
+				return -1;
+			}
+		}
+
+		c->in_len -= consumed;
+		memmove(c->in, c->in + consumed, c->in_len);
+
+		if (c->out && stats_client_flush(epfd, c))
+			return -1;
+	}
+
+	return 0;
+}
+
+static void stats_accept(int epfd, int listen_fd, stats_client_t client[],
+			 uint32_t max_clients)
+{
+	while (1) {
+		int fd = accept(listen_fd, NULL, 0);
+		uint32_t i;
+
+		if (fd < 0) {
+			if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+				ODPH_ERR("Error: accept(): %s\n", strerror(errno));
+			return;
+		}
+
+		for (i = 0; i < max_clients; i++)
+			if (client[i].fd < 0)
+				break;
+
+		if (i == max_clients) {
+			ODPH_DBG("Too many statistics clients\n");
+			close(fd);
+			continue;
+		}
+
+		struct epoll_event ev = { .events = EPOLLIN, .data.u32 = i };
+
+		if (epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &ev)) {
+			ODPH_ERR("Error: epoll_ctl(): %s\n", strerror(errno));
+			close(fd);
+			continue;
+		}
+
+		client[i].fd = fd;
+		client[i].events = EPOLLIN;
+		client[i].in_len = 0;
+		client[i].out = NULL;
+	}
+}
+
+/*
+ * Statistics server thread. Serves all clients from a single epoll loop.
+ * Reads only counter snapshots and does not call any ODP API functions
+ * which would need an ODP thread.
+ */
+static void *stats_server(void *arg)
+{
+	cli_shm_t *shm = arg;
+	uint32_t max_clients = shm->cli_param.stats_max_clients;
+	stats_client_t *client = calloc(max_clients, sizeof(stats_client_t));
+	struct epoll_event ev[STATS_MAX_EVENTS];
+	int epfd = epoll_create1(EPOLL_CLOEXEC);
+	int run = 1;
+
+	if (!client || epfd < 0) {
+		ODPH_ERR("Error: statistics server init failed\n");
+		goto out;
+	}
+
+	for (uint32_t i = 0; i < max_clients; i++) {
+		client[i].fd = -1;
+		client[i].idx = i;
+	}
+
+	ev[0].events = EPOLLIN;
+	ev[0].data.u32 = STATS_EV_STOP;
+	ev[1].events = EPOLLIN;
+	ev[1].data.u32 = STATS_EV_LISTEN;
+
+	if (epoll_ctl(epfd, EPOLL_CTL_ADD, stats_stop_fd, &ev[0]) ||
+	    epoll_ctl(epfd, EPOLL_CTL_ADD, shm->stats_listen_fd, &ev[1])) {
+		ODPH_ERR("Error: epoll_ctl(): %s\n", strerror(errno));
+		goto out;
+	}
+
+	while (run) {
+		int num = epoll_wait(epfd, ev, STATS_MAX_EVENTS, -1);
+
+		if (num < 0) {
+			if (errno == EINTR)
+				continue;
+
+			ODPH_ERR("Error: epoll_wait(): %s\n", strerror(errno));
+			break;
+		}
+
+		for (int i = 0; i < num; i++) {
+			uint32_t idx = ev[i].data.u32;
+			stats_client_t *c;
+			int ret;
+
+			if (idx == STATS_EV_STOP) {
+				run = 0;
+				break;
+			}
+
+			if (idx == STATS_EV_LISTEN) {
+				stats_accept(epfd, shm->stats_listen_fd, client, max_clients);
+				continue;
+			}
+
+			c = &client[idx];
+
+			if (c->fd < 0)
+				continue;
+
+			if (c->out)
+				ret = stats_client_flush(epfd, c);
+			else
+				ret = stats_client_recv(c);
+
+			if (!ret)
+				ret = stats_client_process(shm, epfd, c);
+
+			if (ret)
+				stats_client_close(c);
+		}
+	}
+
+out:
+	if (client) {
+		for (uint32_t i = 0; i < max_clients; i++)
+			if (client[i].fd >= 0)
+				stats_client_close(&client[i]);
+	}
+
+	free(client);
+
+	if (epfd >= 0)
+		close(epfd);
+
+	return NULL;
+}
+
+static int stats_server_start(cli_shm_t *shm)
+{
+	int ret;
+
+	stats_stop_fd = eventfd(0, EFD_CLOEXEC);
+	if (stats_stop_fd < 0) {
+		ODPH_ERR("Error: eventfd(): %s\n", strerror(errno));
+		return -1;
+	}
+
+	ret = pthread_create(&stats_thread, NULL, stats_server, shm);
+	if (ret) {
+		ODPH_ERR("Error: pthread_create(): %s\n", strerror(ret));
+		close(stats_stop_fd);
+		stats_stop_fd = -1;
+		return -1;
+	}
+
+	return 0;
+}
+
+static void stats_server_stop(void)
+{
+	uint64_t val = 1;
+
+	if (stats_stop_fd < 0)
+		return;
+
+	if (write(stats_stop_fd, &val, sizeof(val)) != sizeof(val))
+		ODPH_ERR("Error: write(): %s\n", strerror(errno));
+	else
+		pthread_join(stats_thread, NULL);
+
+	close(stats_stop_fd);
+	stats_stop_fd = -1;
+}
+
+static int create_listen_socket(struct sockaddr_in *addr, int backlog)
+{
+	int fd = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+	int on = 1;
+
+	if (fd < 0) {
+		ODPH_ERR("Error: socket(): %s\n", strerror(errno));
+		return -1;
+	}
+
+	if (setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on))) {
+		ODPH_ERR("Error: setsockopt(): %s\n", strerror(errno));
+		goto error;
+	}
+
+	if (bind(fd, (struct sockaddr *)addr, sizeof(*addr))) {
+		ODPH_ERR("Error: bind(): %s\n", strerror(errno));
+		goto error;
+	}
+
+	if (listen(fd, backlog)) {
+		ODPH_ERR("Error: listen(): %s\n", strerror(errno));
+		goto error;
+	}
+
+	return fd;
+
+error:
+	close(fd);
+	return -1;
+}
+
 static int cli_server(cli_shm_t *shm)
 {
 	cli = create_cli(shm);
@@ -878,6 +1660,13 @@ static int cli_server(cli_shm_t *shm)
 
 	cli_done(cli);
 
+	stats_server_stop();
+
+	if (shm->stats_listen_fd >= 0) {
+		close(shm->stats_listen_fd);
+		shm->stats_listen_fd = -1;
+	}
+
 	if (msg_send(shm->sp[SP_SERVER]))
 		return -1;
 
@@ -905,30 +1694,26 @@ int odph_cli_run(void)
 	shm->cli_fd = -1;
 	odp_spinlock_unlock(&shm->lock);
 
-	/* Create listening socket. */
+	/* Create listening sockets. */
 
-	shm->listen_fd = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
-	if (shm->listen_fd < 0) {
-		ODPH_ERR("Error: socket(): %s\n", strerror(errno));
+	shm->listen_fd = create_listen_socket(&shm->addr, 1);
+	if (shm->listen_fd < 0)
 		goto error;
-	}
-
-	int on = 1;
 
-	if (setsockopt(shm->listen_fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on))) {
-		ODPH_ERR("Error: setsockopt(): %s\n", strerror(errno));
-		goto error;
-	}
+	if (shm->cli_param.stats_port) {
+		shm->stats_listen_fd = create_listen_socket(&shm->stats_addr,
+							    SOMAXCONN);
+		if (shm->stats_listen_fd < 0)
+			goto error;
 
-	if (bind(shm->listen_fd, (struct sockaddr *)&shm->addr,
-		 sizeof(shm->addr))) {
-		ODPH_ERR("Error: bind(): %s\n", strerror(errno));
-		goto error;
-	}
+		/* Statistics server accepts until EAGAIN */
+		if (fcntl(shm->stats_listen_fd, F_SETFL, O_NONBLOCK)) {
+			ODPH_ERR("Error: fcntl(): %s\n", strerror(errno));
+			goto error;
+		}
 
-	if (listen(shm->listen_fd, 1)) {
-		ODPH_ERR("Error: listen(): %s\n", strerror(errno));
-		goto error;
+		if (stats_server_start(shm))
+			goto error;
 	}
 
 	odp_spinlock_unlock(&shm->api_lock);
@@ -939,6 +1724,10 @@ error:
 	shm->run = 0;
 	if (shm->listen_fd >= 0)
 		close(shm->listen_fd);
+	if (shm->stats_listen_fd >= 0) {
+		close(shm->stats_listen_fd);
+		shm->stats_listen_fd = -1;
+	}
 	if (shm->cli_fd >= 0)
 		close(shm->cli_fd);
 	odp_spinlock_unlock(&shm->api_lock);
@@ -1011,6 +1800,7 @@ int odph_cli_term(void)
 
 	close(shm->sp[SP_SERVER]);
 	close(shm->sp[SP_CONTROL]);
+	stats_shm = NULL;
 
 	if (odp_shm_free(shm_hdl)) {
 		ODPH_ERR("Error: odp_shm_free() failed\n");
@@ -46,11 +46,6 @@
 #include <odp/helper/odph_debug.h>
 #include <odp_api.h>
 
-/* More efficient access to a map of single ullong */
-#define ULLONG_FOR_EACH_1(IDX, MAP)	\
-	for (; MAP && (((IDX) = __builtin_ctzll(MAP)), true); \
-		 MAP = (MAP & (MAP - 1)))
-
 /** @magic word, write to the first byte of the memory block
  *   to indicate this block is used by a cuckoo hash table
  */
@@ -60,49 +55,37 @@
 #define HASH_BUCKET_ENTRIES		4
 
 #define NULL_SIGNATURE			0
-#define KEY_ALIGNMENT			16
+
+/** Alignment of key-value slots */
+#define KV_ALIGNMENT			8
 
 /** Maximum size of hash table that can be created. */
 #define HASH_ENTRIES_MAX        1048576
 
-/** @internal signature struct
- *   Structure storing both primary and secondary hashes
- */
-struct cuckoo_table_signatures {
-	union {
-		struct {
-			uint32_t current;
-			uint32_t alt;
-		};
-		uint64_t sig;
-	};
-};
-
-/** @internal kay-value struct
- *   Structure that stores key-value pair
- */
-struct cuckoo_table_key_value {
-	uint8_t *key;
-	uint8_t *value;
-};
+/** Maximum number of entries pushed to alternative buckets on insert */
+#define MAX_PUSH_DEPTH			128
 
 /** @internal bucket structure
  *  Put the elements with defferent keys but a same signature
  *  into a bucket, and each bucket has at most HASH_BUCKET_ENTRIES
  *  elements.
+ *
+ *  Readers access buckets without locks. Writer increments bucket version
+ *  before and after modifying the bucket, so the version is odd during
+ *  an update. A reader retries when it sees an odd or changed version.
  */
 struct ODP_ALIGNED_CACHE cuckoo_table_bucket {
-	struct cuckoo_table_signatures signatures[HASH_BUCKET_ENTRIES];
-	/* Includes dummy key index that always contains index 0 */
-	odp_buffer_t key_buf[HASH_BUCKET_ENTRIES + 1];
+	odp_atomic_u32_t version;
+	/* Signature of this bucket, NULL_SIGNATURE when entry is empty */
+	uint32_t sig[HASH_BUCKET_ENTRIES];
+	/* Signature of the alternative bucket */
+	uint32_t alt[HASH_BUCKET_ENTRIES];
+	/* Index into key-value slot table */
+	uint32_t slot[HASH_BUCKET_ENTRIES];
+	/* Used only by writer while pushing entries */
 	uint8_t flag[HASH_BUCKET_ENTRIES];
 };
 
-/* More efficient access to a map of single ullong */
-#define ULLONG_FOR_EACH_1(IDX, MAP)	\
-	for (; MAP && (((IDX) = __builtin_ctzll(MAP)), true); \
-		 MAP = (MAP & (MAP - 1)))
-
 /** A hash table structure. */
 typedef struct ODP_ALIGNED_CACHE {
 	/**< for check */
@@ -117,13 +100,23 @@ typedef struct ODP_ALIGNED_CACHE {
 	uint32_t key_len;
 	/**< Length of value. */
 	uint32_t value_len;
+	/**< Size of a key-value slot */
+	uint32_t kv_size;
 	/**< Bitmask for getting bucket index from hash signature. */
 	uint32_t bucket_bitmask;
-	/**< Queue that stores all free key-value slots*/
-	odp_queue_t free_slots;
+	/**< Number of free key-value slots */
+	uint32_t num_free;
+	/**< Serializes writers */
+	odp_spinlock_t lock;
+	/**< Incremented when an entry is moved to its alternative bucket */
+	odp_atomic_u32_t chng_cnt;
 	/** Table with buckets storing all the hash values and key indexes
 	  to the key table*/
 	struct cuckoo_table_bucket *buckets;
+	/**< Key-value slots. Value is stored after the key. */
+	uint8_t *kv;
+	/**< Stack of free key-value slot indexes */
+	uint32_t *free_slots;
 } odph_cuckoo_table_impl;
 
 /**
@@ -176,40 +169,8 @@ odph_cuckoo_table_create(
 {
 	odph_cuckoo_table_impl *tbl;
 	odp_shm_t shm_tbl;
-
-	odp_pool_t pool;
-	odp_pool_param_t param;
-
-	odp_queue_t queue;
-	odp_queue_param_t qparam;
-	odp_queue_capability_t qcapa;
-	odp_pool_capability_t pcapa;
-
-	char pool_name[ODPH_TABLE_NAME_LEN + 3],
-		 queue_name[ODPH_TABLE_NAME_LEN + 3];
-	unsigned i;
-	uint32_t impl_size, kv_entry_size,
-			 bucket_num, bucket_size;
-
-	if (odp_queue_capability(&qcapa)) {
-		ODPH_DBG("queue capa failed\n");
-		return NULL;
-	}
-
-	if (qcapa.plain.max_size && qcapa.plain.max_size < capacity) {
-		ODPH_DBG("queue max_size too small\n");
-		return NULL;
-	}
-
-	if (odp_pool_capability(&pcapa)) {
-		ODPH_DBG("pool capa failed\n");
-		return NULL;
-	}
-
-	if (pcapa.buf.max_num && pcapa.buf.max_num < capacity) {
-		ODPH_DBG("pool max_num too small\n");
-		return NULL;
-	}
+	uint32_t i, impl_size, kv_size, bucket_num, bucket_size;
+	uint64_t kv_tbl_size, free_size, shm_size;
 
 	/* Check for valid parameters */
 	if (
@@ -230,14 +191,20 @@ odph_cuckoo_table_create(
 
 	/* Calculate the sizes of different parts of cuckoo hash table */
 	impl_size = sizeof(odph_cuckoo_table_impl);
-	kv_entry_size = sizeof(struct cuckoo_table_key_value)
-					+ key_size + value_size;
 
 	bucket_num = align32pow2(capacity) / HASH_BUCKET_ENTRIES;
 	bucket_size = bucket_num * sizeof(struct cuckoo_table_bucket);
 
-	shm_tbl = odp_shm_reserve(name, impl_size + bucket_size,
-				  ODP_CACHE_LINE_SIZE, 0);
+	kv_size = key_size + value_size;
+	kv_size = (kv_size + KV_ALIGNMENT - 1) & ~(KV_ALIGNMENT - 1);
+	kv_tbl_size = (uint64_t)capacity * kv_size;
+	kv_tbl_size = (kv_tbl_size + ODP_CACHE_LINE_SIZE - 1) &
+		      ~((uint64_t)ODP_CACHE_LINE_SIZE - 1);
+
+	free_size = (uint64_t)capacity * sizeof(uint32_t);
+	shm_size = impl_size + bucket_size + kv_tbl_size + free_size;
+
+	shm_tbl = odp_shm_reserve(name, shm_size, ODP_CACHE_LINE_SIZE, 0);
 
 	if (shm_tbl == ODP_SHM_INVALID) {
 		ODPH_DBG(
@@ -247,79 +214,37 @@ odph_cuckoo_table_create(
 	}
 
 	tbl = (odph_cuckoo_table_impl *)odp_shm_addr(shm_tbl);
-	memset(tbl, 0, impl_size + bucket_size);
+	memset(tbl, 0, shm_size);
 
 	/* header of this mem block is the table impl struct,
-	 * then the bucket pool.
+	 * then the bucket table, key-value slots and free slot stack.
 	 */
 	tbl->buckets = (void *)((char *)tbl + impl_size);
+	tbl->kv = (uint8_t *)tbl->buckets + bucket_size;
+	tbl->free_slots = (uint32_t *)(void *)(tbl->kv + kv_tbl_size);
 
-	/* initialize key-value buffer pool */
-	snprintf(pool_name, sizeof(pool_name), "kv_%s", name);
-	pool = odp_pool_lookup(pool_name);
-
-	if (pool != ODP_POOL_INVALID)
-		if (odp_pool_destroy(pool)) {
-			odp_shm_free(shm_tbl);
-			ODPH_DBG("failed to destroy pre-existing pool\n");
-			return NULL;
-		}
+	for (i = 0; i < bucket_num; i++)
+		odp_atomic_init_u32(&tbl->buckets[i].version, 0);
 
-	odp_pool_param_init(&param);
-	param.type = ODP_POOL_BUFFER;
-	param.buf.size = kv_entry_size;
-	if (pcapa.buf.max_align >= ODP_CACHE_LINE_SIZE)
-		param.buf.align = ODP_CACHE_LINE_SIZE;
-	param.buf.num = capacity;
-
-	pool = odp_pool_create(pool_name, &param);
-
-	if (pool == ODP_POOL_INVALID) {
-		ODPH_DBG("failed to create key-value pool\n");
-		odp_shm_free(shm_tbl);
-		return NULL;
-	}
-
-	/* initialize free_slots queue */
-	odp_queue_param_init(&qparam);
-	qparam.type = ODP_QUEUE_TYPE_PLAIN;
-	qparam.size = capacity;
-
-	snprintf(queue_name, sizeof(queue_name), "fs_%s", name);
-	queue = odp_queue_create(queue_name, &qparam);
-	if (queue == ODP_QUEUE_INVALID) {
-		ODPH_DBG("failed to create free_slots queue\n");
-		(void)odp_pool_destroy(pool);
-		odp_shm_free(shm_tbl);
-		return NULL;
-	}
+	/* Slots are allocated from the top of the stack, starting from
+	 * index 0 */
+	for (i = 0; i < capacity; i++)
+		tbl->free_slots[i] = capacity - 1 - i;
 
 	/* Setup hash context */
 	snprintf(tbl->name, sizeof(tbl->name), "%s", name);
-	tbl->magicword = ODPH_CUCKOO_TABLE_MAGIC_WORD;
 	tbl->entries = capacity;
 	tbl->key_len = key_size;
 	tbl->value_len = value_size;
+	tbl->kv_size = kv_size;
 	tbl->num_buckets = bucket_num;
 	tbl->bucket_bitmask = bucket_num - 1;
-	tbl->free_slots = queue;
-
-	/* generate all free buffers, and put into queue */
-	for (i = 0; i < capacity; i++) {
-		odp_event_t ev = odp_buffer_to_event(
-				odp_buffer_alloc(pool));
-		if (ev == ODP_EVENT_INVALID) {
-			ODPH_DBG("failed to generate free slots\n");
-			odph_cuckoo_table_destroy((odph_table_t)tbl);
-			return NULL;
-		}
+	tbl->num_free = capacity;
+	odp_spinlock_init(&tbl->lock);
+	odp_atomic_init_u32(&tbl->chng_cnt, 0);
 
-		if (odp_queue_enq(queue, ev) < 0) {
-			ODPH_DBG("failed to enqueue free slots\n");
-			odph_cuckoo_table_destroy((odph_table_t)tbl);
-			return NULL;
-		}
-	}
+	odp_mb_full();
+	tbl->magicword = ODPH_CUCKOO_TABLE_MAGIC_WORD;
 
 	return (odph_table_t)tbl;
 }
@@ -327,13 +252,8 @@ odph_cuckoo_table_create(
 int
 odph_cuckoo_table_destroy(odph_table_t tbl)
 {
-	int ret;
 	odph_cuckoo_table_impl *impl = NULL;
-	char pool_name[ODPH_TABLE_NAME_LEN + 3];
-	odp_event_t ev;
 	odp_shm_t shm;
-	odp_pool_t pool;
-	uint32_t i, j;
 
 	if (tbl == NULL)
 		return -1;
@@ -346,40 +266,6 @@ odph_cuckoo_table_destroy(odph_table_t tbl)
 		return -1;
 	}
 
-	/* free all used buffers*/
-	for (i = 0; i < impl->num_buckets; i++) {
-		for (j = 0; j < HASH_BUCKET_ENTRIES; j++) {
-			if (impl->buckets[i].signatures[j].current
-					!= NULL_SIGNATURE)
-				odp_buffer_free(impl->buckets[i].key_buf[j]);
-		}
-	}
-
-	/* free all free buffers */
-	while ((ev = odp_queue_deq(impl->free_slots))
-			!= ODP_EVENT_INVALID) {
-		odp_buffer_free(odp_buffer_from_event(ev));
-	}
-
-	/* destroy free_slots queue */
-	ret = odp_queue_destroy(impl->free_slots);
-	if (ret < 0)
-		ODPH_DBG("failed to destroy free_slots queue\n");
-
-	/* destroy key-value pool */
-	snprintf(pool_name, sizeof(pool_name), "kv_%s", impl->name);
-	pool = odp_pool_lookup(pool_name);
-	if (pool == ODP_POOL_INVALID) {
-		ODPH_DBG("invalid pool\n");
-		return -1;
-	}
-
-	ret = odp_pool_destroy(pool);
-	if (ret != 0) {
-		ODPH_DBG("failed to destroy key-value buffer pool\n");
-		return -1;
-	}
-
 	/* free impl */
 	shm = odp_shm_lookup(impl->name);
 	if (shm == ODP_SHM_INVALID) {
@@ -387,13 +273,21 @@ odph_cuckoo_table_destroy(odph_table_t tbl)
 		return -1;
 	}
 
+	impl->magicword = 0;
+
 	return odp_shm_free(shm);
 }
 
-static uint32_t hash(const odph_cuckoo_table_impl *h, const void *key)
+/* Signature value NULL_SIGNATURE marks an empty bucket entry */
+static inline uint32_t sig_valid(uint32_t sig)
+{
+	return sig == NULL_SIGNATURE ? 1 : sig;
+}
+
+static inline uint32_t hash(const odph_cuckoo_table_impl *h, const void *key)
 {
 	/* calc hash result by key */
-	return odp_hash_crc32c(key, h->key_len, 0);
+	return sig_valid(odp_hash_crc32c(key, h->key_len, 0));
 }
 
 /* Calc the secondary hash value from the primary hash value of a given key */
@@ -405,18 +299,150 @@ hash_secondary(const uint32_t primary_hash)
 
 	uint32_t tag = primary_hash >> all_bits_shift;
 
-	return (primary_hash ^ ((tag + 1) * alt_bits_xor));
+	return sig_valid(primary_hash ^ ((tag + 1) * alt_bits_xor));
 }
 
-/* Search for an entry that can be pushed to its alternative location */
-static inline int
+static inline struct cuckoo_table_bucket *
+bucket_from_sig(const odph_cuckoo_table_impl *h, uint32_t sig)
+{
+	return &h->buckets[sig & h->bucket_bitmask];
+}
+
+static inline uint8_t *kv_slot(const odph_cuckoo_table_impl *h, uint32_t slot)
+{
+	return h->kv + (uint64_t)slot * h->kv_size;
+}
+
+/* Compare signature to all entries of a bucket. Returns a bit mask of
+ * matching entries. The loop has no branches, so that compiler can use
+ * a single vector compare for all entries. */
+static inline uint32_t sig_match(const struct cuckoo_table_bucket *bkt,
+				 uint32_t sig)
+{
+	uint32_t i;
+	uint32_t mask = 0;
+
+	for (i = 0; i < HASH_BUCKET_ENTRIES; i++)
+		mask |= (uint32_t)(bkt->sig[i] == sig) << i;
+
+	return mask;
+}
+
+static inline void bucket_write_begin(struct cuckoo_table_bucket *bkt)
+{
+	odp_atomic_store_u32(&bkt->version,
+			     odp_atomic_load_u32(&bkt->version) + 1);
+
+	/* Odd version must be visible before bucket content changes */
+	odp_mb_release();
+}
+
+static inline void bucket_write_end(struct cuckoo_table_bucket *bkt)
+{
+	odp_atomic_store_rel_u32(&bkt->version,
+				 odp_atomic_load_u32(&bkt->version) + 1);
+}
+
+static inline void bucket_set(struct cuckoo_table_bucket *bkt, int i,
+			      uint32_t sig, uint32_t alt, uint32_t slot)
+{
+	bucket_write_begin(bkt);
+	bkt->sig[i] = sig;
+	bkt->alt[i] = alt;
+	bkt->slot[i] = slot;
+	bucket_write_end(bkt);
+}
+
+/* Compare key against bucket entries selected by the signature match mask.
+ * Copies value into buffer and returns 1 when the key was found. Caller
+ * validates bucket version. */
+static inline int bucket_compare(const odph_cuckoo_table_impl *h,
+				 const struct cuckoo_table_bucket *bkt,
+				 uint32_t mask, const void *key, void *buffer)
+{
+	uint32_t i;
+	const uint8_t *kv;
+
+	while (mask) {
+		i = __builtin_ctz(mask);
+		mask &= mask - 1;
+
+		kv = kv_slot(h, bkt->slot[i]);
+		if (memcmp(key, kv, h->key_len) == 0) {
+			if (buffer != NULL && h->value_len > 0)
+				memcpy(buffer, kv + h->key_len, h->value_len);
+
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+/* Lock-free key search from a bucket */
+static inline int bucket_lookup(const odph_cuckoo_table_impl *h,
+				struct cuckoo_table_bucket *bkt, uint32_t sig,
+				const void *key, void *buffer)
+{
+	uint32_t ver;
+	int found;
+
+	while (1) {
+		ver = odp_atomic_load_acq_u32(&bkt->version);
+
+		if (odp_unlikely(ver & 1)) {
+			odp_cpu_pause();
+			continue;
+		}
+
+		found = bucket_compare(h, bkt, sig_match(bkt, sig), key, buffer);
+
+		odp_mb_acquire();
+		if (odp_likely(odp_atomic_load_u32(&bkt->version) == ver))
+			return found;
+	}
+}
+
+/* Key search for writers. Bucket content is stable while the writer lock
+ * is held. */
+static inline int bucket_find(const odph_cuckoo_table_impl *h,
+			      const struct cuckoo_table_bucket *bkt,
+			      uint32_t sig, const void *key)
+{
+	uint32_t i;
+	uint32_t mask = sig_match(bkt, sig);
+
+	while (mask) {
+		i = __builtin_ctz(mask);
+		mask &= mask - 1;
+
+		if (memcmp(key, kv_slot(h, bkt->slot[i]), h->key_len) == 0)
+			return i;
+	}
+
+	return -1;
+}
+
+static inline int bucket_free_entry(const struct cuckoo_table_bucket *bkt)
+{
+	uint32_t mask = sig_match(bkt, NULL_SIGNATURE);
+
+	if (mask == 0)
+		return -1;
+
+	return __builtin_ctz(mask);
+}
+
+/* Search for an entry that can be pushed to its alternative location.
+ * The pushed entry is copied to its alternative bucket, and caller
+ * overwrites the entry in the original bucket. */
+static int
 make_space_bucket(
-	const odph_cuckoo_table_impl *impl,
-	struct cuckoo_table_bucket *bkt)
+	odph_cuckoo_table_impl *impl,
+	struct cuckoo_table_bucket *bkt, int depth)
 {
-	unsigned i, j;
-	int ret;
-	uint32_t next_bucket_idx;
+	unsigned i;
+	int j, ret;
 	struct cuckoo_table_bucket *next_bkt[HASH_BUCKET_ENTRIES];
 
 	/*
@@ -425,25 +451,26 @@ make_space_bucket(
 	 */
 	for (i = 0; i < HASH_BUCKET_ENTRIES; i++) {
 		/* Search for space in alternative locations */
-		next_bucket_idx = bkt->signatures[i].alt & impl->bucket_bitmask;
-		next_bkt[i] = &impl->buckets[next_bucket_idx];
-		for (j = 0; j < HASH_BUCKET_ENTRIES; j++) {
-			if (next_bkt[i]->signatures[j].sig == NULL_SIGNATURE)
-				break;
-		}
+		next_bkt[i] = bucket_from_sig(impl, bkt->alt[i]);
+		j = bucket_free_entry(next_bkt[i]);
 
-		if (j != HASH_BUCKET_ENTRIES)
+		if (j >= 0)
 			break;
 	}
 
 	/* Alternative location has spare room (end of recursive function) */
 	if (i != HASH_BUCKET_ENTRIES) {
-		next_bkt[i]->signatures[j].alt = bkt->signatures[i].current;
-		next_bkt[i]->signatures[j].current = bkt->signatures[i].alt;
-		next_bkt[i]->key_buf[j] = bkt->key_buf[i];
+		bucket_set(next_bkt[i], j, bkt->alt[i], bkt->sig[i],
+			   bkt->slot[i]);
+		/* Entry is now in both buckets. Readers that miss the entry
+		 * while caller overwrites the old location retry the lookup. */
+		odp_atomic_add_rel_u32(&impl->chng_cnt, 1);
 		return i;
 	}
 
+	if (depth >= MAX_PUSH_DEPTH)
+		return -ENOSPC;
+
 	/* Pick entry that has not been pushed yet */
 	for (i = 0; i < HASH_BUCKET_ENTRIES; i++)
 		if (bkt->flag[i] == 0)
@@ -456,7 +483,7 @@ make_space_bucket(
 	/* Set flag to indicate that this entry is going to be pushed */
 	bkt->flag[i] = 1;
 	/* Need room in alternative bucket to insert the pushed entry */
-	ret = make_space_bucket(impl, next_bkt[i]);
+	ret = make_space_bucket(impl, next_bkt[i], depth + 1);
 	/*
 	 * After recursive function.
 	 * Clear flags and insert the pushed entry
@@ -465,133 +492,95 @@ make_space_bucket(
 	 */
 	bkt->flag[i] = 0;
 	if (ret >= 0) {
-		next_bkt[i]->signatures[ret].alt = bkt->signatures[i].current;
-		next_bkt[i]->signatures[ret].current = bkt->signatures[i].alt;
-		next_bkt[i]->key_buf[ret] = bkt->key_buf[i];
+		bucket_set(next_bkt[i], ret, bkt->alt[i], bkt->sig[i],
+			   bkt->slot[i]);
+		odp_atomic_add_rel_u32(&impl->chng_cnt, 1);
 		return i;
 	}
 
 	return ret;
 }
 
-static inline int32_t
+static int
 cuckoo_table_add_key_with_hash(
-	const odph_cuckoo_table_impl *h, const void *key,
-	uint32_t sig, void *data)
+	odph_cuckoo_table_impl *h, const void *key,
+	uint32_t sig, const void *data)
 {
-	uint32_t alt_hash;
-	uint32_t prim_bucket_idx, sec_bucket_idx;
-	unsigned i;
-	struct cuckoo_table_bucket *prim_bkt, *sec_bkt;
-	struct cuckoo_table_key_value *new_kv, *kv;
-
-	odp_buffer_t new_buf;
-	int ret;
+	uint32_t alt_hash, slot;
+	int i;
+	struct cuckoo_table_bucket *prim_bkt, *sec_bkt, *bkt;
+	uint8_t *kv;
 
-	prim_bucket_idx = sig & h->bucket_bitmask;
-	prim_bkt = &h->buckets[prim_bucket_idx];
-	__builtin_prefetch((const void *)(uintptr_t)prim_bkt, 0, 3);
+	prim_bkt = bucket_from_sig(h, sig);
+	odp_prefetch(prim_bkt);
 
 	alt_hash = hash_secondary(sig);
-	sec_bucket_idx = alt_hash & h->bucket_bitmask;
-	sec_bkt = &h->buckets[sec_bucket_idx];
-	__builtin_prefetch((const void *)(uintptr_t)sec_bkt, 0, 3);
+	sec_bkt = bucket_from_sig(h, alt_hash);
+	odp_prefetch(sec_bkt);
 
-	/* Get a new slot for storing the new key */
-	new_buf = odp_buffer_from_event(odp_queue_deq(h->free_slots));
-	if (new_buf == ODP_BUFFER_INVALID)
-		return -ENOSPC;
+	/* Check if key is already inserted in primary or secondary location */
+	bkt = prim_bkt;
+	i = bucket_find(h, prim_bkt, sig, key);
 
-	/* Check if key is already inserted in primary location */
-	for (i = 0; i < HASH_BUCKET_ENTRIES; i++) {
-		if (
-			prim_bkt->signatures[i].current == sig &&
-			prim_bkt->signatures[i].alt == alt_hash)  {
-			kv = (struct cuckoo_table_key_value *)odp_buffer_addr(
-					prim_bkt->key_buf[i]);
-			if (memcmp(key, kv->key, h->key_len) == 0) {
-				odp_queue_enq(
-						h->free_slots,
-						odp_buffer_to_event(new_buf));
-				/* Update data */
-				if (kv->value != NULL)
-					memcpy(kv->value, data, h->value_len);
-
-				/* Return bucket index */
-				return prim_bucket_idx;
-			}
-		}
+	if (i < 0) {
+		bkt = sec_bkt;
+		i = bucket_find(h, sec_bkt, alt_hash, key);
 	}
 
-	/* Check if key is already inserted in secondary location */
-	for (i = 0; i < HASH_BUCKET_ENTRIES; i++) {
-		if (
-			sec_bkt->signatures[i].alt == sig &&
-			sec_bkt->signatures[i].current == alt_hash)  {
-			kv = (struct cuckoo_table_key_value *)odp_buffer_addr(
-					sec_bkt->key_buf[i]);
-			if (memcmp(key, kv->key, h->key_len) == 0) {
-				odp_queue_enq(
-						h->free_slots,
-						odp_buffer_to_event(new_buf));
-				/* Update data */
-				if (kv->value != NULL)
-					memcpy(kv->value, data, h->value_len);
-
-				/* Return bucket index */
-				return sec_bucket_idx;
-			}
+	if (i >= 0) {
+		/* Update data */
+		if (h->value_len > 0) {
+			kv = kv_slot(h, bkt->slot[i]);
+			bucket_write_begin(bkt);
+			memcpy(kv + h->key_len, data, h->value_len);
+			bucket_write_end(bkt);
 		}
+
+		return 0;
 	}
 
-	new_kv = (struct cuckoo_table_key_value *)odp_buffer_addr(new_buf);
-	__builtin_prefetch((const void *)(uintptr_t)new_kv, 0, 3);
+	/* Get a new slot for storing the new key */
+	if (h->num_free == 0)
+		return -ENOSPC;
 
-	/* Copy key and value.
-	 * key-value mem block : struct cuckoo_table_key_value
-	 *		+ key (key_len) + value (value_len)
-	 */
-	new_kv->key = (uint8_t *)new_kv
-					+ sizeof(struct cuckoo_table_key_value);
-	memcpy(new_kv->key, key, h->key_len);
-
-	if (h->value_len > 0) {
-		new_kv->value = new_kv->key + h->key_len;
-		memcpy(new_kv->value, data, h->value_len);
-	} else {
-		new_kv->value = NULL;
+	slot = h->free_slots[h->num_free - 1];
+	kv = kv_slot(h, slot);
+
+	/* Copy key and value. Free slot is not referenced by any bucket. */
+	memcpy(kv, key, h->key_len);
+	if (h->value_len > 0)
+		memcpy(kv + h->key_len, data, h->value_len);
+
+	/* Insert new entry if there is room in the primary or secondary
+	 * bucket */
+	i = bucket_free_entry(prim_bkt);
+	if (i >= 0) {
+		bucket_set(prim_bkt, i, sig, alt_hash, slot);
+		h->num_free--;
+		return 0;
 	}
 
-	/* Insert new entry is there is room in the primary bucket */
-	for (i = 0; i < HASH_BUCKET_ENTRIES; i++) {
-		/* Check if slot is available */
-		if (odp_likely(prim_bkt->signatures[i].sig == NULL_SIGNATURE)) {
-			prim_bkt->signatures[i].current = sig;
-			prim_bkt->signatures[i].alt = alt_hash;
-			prim_bkt->key_buf[i] = new_buf;
-			return prim_bucket_idx;
-		}
+	i = bucket_free_entry(sec_bkt);
+	if (i >= 0) {
+		bucket_set(sec_bkt, i, alt_hash, sig, slot);
+		h->num_free--;
+		return 0;
 	}
 
-	/* Primary bucket is full, so we need to make space for new entry */
-	ret = make_space_bucket(h, prim_bkt);
+	/* Both buckets are full, so we need to make space for new entry */
+	i = make_space_bucket(h, prim_bkt, 0);
 
 	/*
 	 * After recursive function.
 	 * Insert the new entry in the position of the pushed entry
-	 * if successful or return error and
-	 * store the new slot back in the pool
+	 * if successful or return error. The slot remains free.
 	 */
-	if (ret >= 0) {
-		prim_bkt->signatures[ret].current = sig;
-		prim_bkt->signatures[ret].alt = alt_hash;
-		prim_bkt->key_buf[ret] = new_buf;
-		return prim_bucket_idx;
-	}
+	if (i < 0)
+		return i;
 
-	/* Error in addition, store new slot back in the free_slots */
-	odp_queue_enq(h->free_slots, odp_buffer_to_event(new_buf));
-	return ret;
+	bucket_set(prim_bkt, i, sig, alt_hash, slot);
+	h->num_free--;
+	return 0;
 }
 
 int
@@ -604,8 +593,11 @@ odph_cuckoo_table_put_value(odph_table_t tbl, void *key, void *value)
 		return -EINVAL;
 
 	impl = (odph_cuckoo_table_impl *)(void *)tbl;
+
+	odp_spinlock_lock(&impl->lock);
 	ret = cuckoo_table_add_key_with_hash(
 			impl, key, hash(impl, key), value);
+	odp_spinlock_unlock(&impl->lock);
 
 	if (ret < 0)
 		return -1;
@@ -613,63 +605,66 @@ odph_cuckoo_table_put_value(odph_table_t tbl, void *key, void *value)
 	return 0;
 }
 
-static inline int32_t
-cuckoo_table_lookup_with_hash(
-	const odph_cuckoo_table_impl *h, const void *key,
-	uint32_t sig, void **data_ptr)
+int odph_cuckoo_table_put_value_multi(odph_table_t tbl, void *key[],
+				      void *value[], int num)
 {
-	uint32_t bucket_idx;
-	uint32_t alt_hash;
-	unsigned i;
-	struct cuckoo_table_bucket *bkt;
-	struct cuckoo_table_key_value *kv;
+	odph_cuckoo_table_impl *impl = (odph_cuckoo_table_impl *)(void *)tbl;
+	uint32_t sig[ODPH_CUCKOO_TABLE_MULTI_MAX];
+	int i;
 
-	bucket_idx = sig & h->bucket_bitmask;
-	bkt = &h->buckets[bucket_idx];
+	if (tbl == NULL || key == NULL || num < 0 ||
+	    num > ODPH_CUCKOO_TABLE_MULTI_MAX)
+		return -EINVAL;
 
-	/* Check if key is in primary location */
-	for (i = 0; i < HASH_BUCKET_ENTRIES; i++) {
-		if (
-			bkt->signatures[i].current == sig &&
-			bkt->signatures[i].sig != NULL_SIGNATURE) {
-			kv = (struct cuckoo_table_key_value *)odp_buffer_addr(
-					bkt->key_buf[i]);
-			if (memcmp(key, kv->key, h->key_len) == 0) {
-				if (data_ptr != NULL)
-					*data_ptr = kv->value;
-				/*
-				 * Return index where key is stored,
-				 * subtracting the first dummy index
-				 */
-				return bucket_idx;
-			}
-		}
+	/* Calculate hashes and prefetch primary buckets before taking
+	 * the lock */
+	for (i = 0; i < num; i++) {
+		sig[i] = hash(impl, key[i]);
+		odp_prefetch_store(bucket_from_sig(impl, sig[i]));
 	}
 
-	/* Calculate secondary hash */
-	alt_hash = hash_secondary(sig);
-	bucket_idx = alt_hash & h->bucket_bitmask;
-	bkt = &h->buckets[bucket_idx];
+	odp_spinlock_lock(&impl->lock);
 
-	/* Check if key is in secondary location */
-	for (i = 0; i < HASH_BUCKET_ENTRIES; i++) {
-		if (
-			bkt->signatures[i].current == alt_hash &&
-			bkt->signatures[i].alt == sig) {
-			kv = (struct cuckoo_table_key_value *)odp_buffer_addr(
-					bkt->key_buf[i]);
-			if (memcmp(key, kv->key, h->key_len) == 0) {
-				if (data_ptr != NULL)
-					*data_ptr = kv->value;
-				/*
-				 * Return index where key is stored,
-				 * subtracting the first dummy index
-				 */
-				return bucket_idx;
-			}
-		}
+	for (i = 0; i < num; i++) {
+		if (cuckoo_table_add_key_with_hash(impl, key[i], sig[i],
+						   value ? value[i] : NULL) < 0)
+			break;
 	}
 
+	odp_spinlock_unlock(&impl->lock);
+
+	if (i == 0 && num > 0)
+		return -1;
+
+	return i;
+}
+
+static inline int
+cuckoo_table_lookup_with_hash(
+	odph_cuckoo_table_impl *h, const void *key,
+	uint32_t sig, void *buffer)
+{
+	uint32_t alt_hash, cnt;
+	struct cuckoo_table_bucket *prim_bkt, *sec_bkt;
+
+	alt_hash = hash_secondary(sig);
+	prim_bkt = bucket_from_sig(h, sig);
+	sec_bkt = bucket_from_sig(h, alt_hash);
+
+	/* Entry may move from secondary to primary location between
+	 * the two bucket reads. Retry when a miss overlaps with a move. */
+	do {
+		cnt = odp_atomic_load_acq_u32(&h->chng_cnt);
+
+		if (bucket_lookup(h, prim_bkt, sig, key, buffer))
+			return 0;
+
+		if (bucket_lookup(h, sec_bkt, alt_hash, key, buffer))
+			return 0;
+
+		odp_mb_acquire();
+	} while (odp_atomic_load_u32(&h->chng_cnt) != cnt);
+
 	return -ENOENT;
 }
 
@@ -677,79 +672,148 @@ int odph_cuckoo_table_get_value(odph_table_t tbl, void *key,
 				void *buffer, uint32_t buffer_size ODP_UNUSED)
 {
 	odph_cuckoo_table_impl *impl = (odph_cuckoo_table_impl *)(void *)tbl;
-	void *tmp = NULL;
 	int ret;
 
 	if ((tbl == NULL) || (key == NULL))
 		return -EINVAL;
 
-	ret = cuckoo_table_lookup_with_hash(impl, key, hash(impl, key), &tmp);
+	ret = cuckoo_table_lookup_with_hash(impl, key, hash(impl, key), buffer);
 
 	if (ret < 0)
 		return -1;
 
-	if (impl->value_len > 0)
-		memcpy(buffer, tmp, impl->value_len);
-
 	return 0;
 }
 
+int odph_cuckoo_table_get_value_multi(odph_table_t tbl, void *key[],
+				      void *buffer[],
+				      uint32_t buffer_size ODP_UNUSED,
+				      int num, uint64_t *hit_mask)
+{
+	odph_cuckoo_table_impl *impl = (odph_cuckoo_table_impl *)(void *)tbl;
+	uint32_t sig[ODPH_CUCKOO_TABLE_MULTI_MAX];
+	uint32_t alt_hash[ODPH_CUCKOO_TABLE_MULTI_MAX];
+	uint32_t prim_mask[ODPH_CUCKOO_TABLE_MULTI_MAX];
+	uint32_t sec_mask[ODPH_CUCKOO_TABLE_MULTI_MAX];
+	uint32_t prim_ver[ODPH_CUCKOO_TABLE_MULTI_MAX];
+	uint32_t sec_ver[ODPH_CUCKOO_TABLE_MULTI_MAX];
+	struct cuckoo_table_bucket *prim_bkt[ODPH_CUCKOO_TABLE_MULTI_MAX];
+	struct cuckoo_table_bucket *sec_bkt[ODPH_CUCKOO_TABLE_MULTI_MAX];
+	uint64_t hits = 0;
+	uint32_t cnt, slot;
+	void *buf;
+	int i, found;
+
+	if (tbl == NULL || key == NULL || num < 0 ||
+	    num > ODPH_CUCKOO_TABLE_MULTI_MAX)
+		return -EINVAL;
+
+	/* Calculate hashes and prefetch both candidate buckets of all keys */
+	for (i = 0; i < num; i++) {
+		sig[i] = hash(impl, key[i]);
+		alt_hash[i] = hash_secondary(sig[i]);
+		prim_bkt[i] = bucket_from_sig(impl, sig[i]);
+		sec_bkt[i] = bucket_from_sig(impl, alt_hash[i]);
+		odp_prefetch(prim_bkt[i]);
+		odp_prefetch(sec_bkt[i]);
+	}
+
+	cnt = odp_atomic_load_acq_u32(&impl->chng_cnt);
+
+	/* Compare signatures and prefetch the first matching key-value slot
+	 * of both buckets */
+	for (i = 0; i < num; i++) {
+		prim_ver[i] = odp_atomic_load_acq_u32(&prim_bkt[i]->version);
+		sec_ver[i] = odp_atomic_load_acq_u32(&sec_bkt[i]->version);
+		prim_mask[i] = sig_match(prim_bkt[i], sig[i]);
+		sec_mask[i] = sig_match(sec_bkt[i], alt_hash[i]);
+
+		if (prim_mask[i]) {
+			slot = prim_bkt[i]->slot[__builtin_ctz(prim_mask[i])];
+			odp_prefetch(kv_slot(impl, slot));
+		}
+
+		if (sec_mask[i]) {
+			slot = sec_bkt[i]->slot[__builtin_ctz(sec_mask[i])];
+			odp_prefetch(kv_slot(impl, slot));
+		}
+	}
+
+	/* Compare keys */
+	for (i = 0; i < num; i++) {
+		buf = buffer ? buffer[i] : NULL;
+
+		found = bucket_compare(impl, prim_bkt[i], prim_mask[i], key[i], buf);
+
+		if (!found)
+			found = bucket_compare(impl, sec_bkt[i], sec_mask[i], key[i], buf);
+
+		odp_mb_acquire();
+
+		/* Bucket was modified during the lookup. Retry the key. */
+		if (odp_unlikely(((prim_ver[i] | sec_ver[i]) & 1) ||
+				 odp_atomic_load_u32(&prim_bkt[i]->version) != prim_ver[i] ||
+				 odp_atomic_load_u32(&sec_bkt[i]->version) != sec_ver[i])) {
+			buf = buffer ? buffer[i] : NULL;
+			found = !cuckoo_table_lookup_with_hash(impl, key[i], sig[i], buf);
+		}
+
+		if (found)
+			hits |= 1ULL << i;
+	}
+
+	/* Entries moved during the lookup. Retry missed keys. */
+	if (odp_unlikely(odp_atomic_load_u32(&impl->chng_cnt) != cnt)) {
+		for (i = 0; i < num; i++) {
+			if (hits & (1ULL << i))
+				continue;
+
+			buf = buffer ? buffer[i] : NULL;
+			if (!cuckoo_table_lookup_with_hash(impl, key[i], sig[i], buf))
+				hits |= 1ULL << i;
+		}
+	}
+
+	if (hit_mask)
+		*hit_mask = hits;
+
+	return __builtin_popcountll(hits);
+}
+
 static inline int32_t
 cuckoo_table_del_key_with_hash(
-	const odph_cuckoo_table_impl *h,
+	odph_cuckoo_table_impl *h,
 	const void *key, uint32_t sig)
 {
-	uint32_t bucket_idx;
-	uint32_t alt_hash;
-	unsigned i;
+	uint32_t alt_hash, slot;
+	int i;
 	struct cuckoo_table_bucket *bkt;
-	struct cuckoo_table_key_value *kv;
-
-	bucket_idx = sig & h->bucket_bitmask;
-	bkt = &h->buckets[bucket_idx];
 
 	/* Check if key is in primary location */
-	for (i = 0; i < HASH_BUCKET_ENTRIES; i++) {
-		if (
-			bkt->signatures[i].current == sig &&
-			bkt->signatures[i].sig != NULL_SIGNATURE) {
-			kv = (struct cuckoo_table_key_value *)odp_buffer_addr(
-					bkt->key_buf[i]);
-			if (memcmp(key, kv->key, h->key_len) == 0) {
-				bkt->signatures[i].sig = NULL_SIGNATURE;
-				odp_queue_enq(
-						h->free_slots,
-						odp_buffer_to_event(
-							bkt->key_buf[i]));
-				return bucket_idx;
-			}
-		}
+	bkt = bucket_from_sig(h, sig);
+	i = bucket_find(h, bkt, sig, key);
+
+	if (i < 0) {
+		/* Check if key is in secondary location */
+		alt_hash = hash_secondary(sig);
+		bkt = bucket_from_sig(h, alt_hash);
+		i = bucket_find(h, bkt, alt_hash, key);
 	}
 
-	/* Calculate secondary hash */
-	alt_hash = hash_secondary(sig);
-	bucket_idx = alt_hash & h->bucket_bitmask;
-	bkt = &h->buckets[bucket_idx];
+	if (i < 0)
+		return -ENOENT;
 
-	/* Check if key is in secondary location */
-	for (i = 0; i < HASH_BUCKET_ENTRIES; i++) {
-		if (
-			bkt->signatures[i].current == alt_hash &&
-			bkt->signatures[i].sig != NULL_SIGNATURE) {
-			kv = (struct cuckoo_table_key_value *)odp_buffer_addr(
-					bkt->key_buf[i]);
-			if (memcmp(key, kv->key, h->key_len) == 0) {
-				bkt->signatures[i].sig = NULL_SIGNATURE;
-				odp_queue_enq(
-						h->free_slots,
-						odp_buffer_to_event(
-							bkt->key_buf[i]));
-				return bucket_idx;
-			}
-		}
-	}
+	slot = bkt->slot[i];
 
-	return -ENOENT;
+	bucket_write_begin(bkt);
+	bkt->sig[i] = NULL_SIGNATURE;
+	bucket_write_end(bkt);
+
+	/* Readers still comparing the slot see the version change */
+	h->free_slots[h->num_free] = slot;
+	h->num_free++;
+
+	return 0;
 }
 
 int
@@ -761,18 +825,56 @@ odph_cuckoo_table_remove_value(odph_table_t tbl, void *key)
 	if ((tbl == NULL) || (key == NULL))
 		return -EINVAL;
 
+	odp_spinlock_lock(&impl->lock);
 	ret = cuckoo_table_del_key_with_hash(impl, key, hash(impl, key));
+	odp_spinlock_unlock(&impl->lock);
+
 	if (ret < 0)
 		return -1;
 
 	return 0;
 }
 
+int odph_cuckoo_table_remove_value_multi(odph_table_t tbl, void *key[],
+					 int num, uint64_t *hit_mask)
+{
+	odph_cuckoo_table_impl *impl = (odph_cuckoo_table_impl *)(void *)tbl;
+	uint32_t sig[ODPH_CUCKOO_TABLE_MULTI_MAX];
+	uint64_t hits = 0;
+	int i;
+
+	if (tbl == NULL || key == NULL || num < 0 ||
+	    num > ODPH_CUCKOO_TABLE_MULTI_MAX)
+		return -EINVAL;
+
+	for (i = 0; i < num; i++) {
+		sig[i] = hash(impl, key[i]);
+		odp_prefetch_store(bucket_from_sig(impl, sig[i]));
+	}
+
+	odp_spinlock_lock(&impl->lock);
+
+	for (i = 0; i < num; i++) {
+		if (cuckoo_table_del_key_with_hash(impl, key[i], sig[i]) == 0)
+			hits |= 1ULL << i;
+	}
+
+	odp_spinlock_unlock(&impl->lock);
+
+	if (hit_mask)
+		*hit_mask = hits;
+
+	return __builtin_popcountll(hits);
+}
+
 odph_table_ops_t odph_cuckoo_table_ops = {
 	odph_cuckoo_table_create,
 	odph_cuckoo_table_lookup,
 	odph_cuckoo_table_destroy,
 	odph_cuckoo_table_put_value,
 	odph_cuckoo_table_get_value,
-	odph_cuckoo_table_remove_value
+	odph_cuckoo_table_remove_value,
+	odph_cuckoo_table_put_value_multi,
+	odph_cuckoo_table_get_value_multi,
+	odph_cuckoo_table_remove_value_multi
 };
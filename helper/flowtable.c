@@ -0,0 +1,644 @@
+/* Copyright (c) 2022, Nokia
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier:     BSD-3-Clause
+ */
+
+#include <odp_api.h>
+
+#include <odp/helper/odph_flowtable.h>
+#include <odp/helper/odph_debug.h>
+
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#define FLOW_TABLE_MAGIC_WORD	0xF10FF10F
+
+#define FLOW_TABLE_DEFAULT_FLOWS (64 * 1024)
+
+/* In shared mode, removed entries are reused after this grace period, so
+ * that lock-free lookups in progress do not see them reused. */
+#define FLOW_REUSE_GRACE_NS	(10 * ODP_TIME_MSEC_IN_NS)
+
+#define CACHE_ROUNDUP(x) \
+	(((x) + ODP_CACHE_LINE_SIZE - 1) & ~((uint64_t)ODP_CACHE_LINE_SIZE - 1))
+
+/* Hash chain head. In shared mode, writer increments the version before
+ * and after it modifies the chain, so the version is odd during an update.
+ * Readers retry when the version changes during a search. */
+typedef struct {
+	odp_atomic_u32_t version;
+	/* Entry index + 1 of the first entry, or 0 */
+	uint32_t head;
+} flow_bucket_t;
+
+typedef struct {
+	odph_flow_key_t key;
+	uint32_t hash;
+	/* Entry index + 1 of the next entry in the chain, or 0 */
+	uint32_t next;
+	uint32_t used;
+	uint32_t pad;
+	/* Last lookup time, or free time when not used */
+	odp_atomic_u64_t time;
+	uint8_t data[];
+} flow_entry_t;
+
+typedef struct ODP_ALIGNED_CACHE {
+	/* Writer lock in shared mode */
+	odp_spinlock_t lock;
+	uint32_t num_buckets;
+	uint32_t num_entries;
+	uint32_t num_used;
+	/* Free entries are reused in FIFO order */
+	uint32_t free_head;
+	uint32_t num_free;
+	/* Next entry to be checked by aging */
+	uint32_t age_pos;
+	flow_bucket_t *bucket;
+	uint8_t *entry;
+	uint32_t *free_ring;
+} flow_shard_t;
+
+typedef struct {
+	uint32_t magicword;
+	char name[ODPH_TABLE_NAME_LEN];
+	odph_flow_table_param_t param;
+	int shared;
+	uint32_t num_shards;
+	uint32_t entry_size;
+	odp_shm_t shm;
+	flow_shard_t shard[];
+} flow_table_t;
+
+static inline flow_table_t *flow_table(odph_flow_table_t table)
+{
+	return (flow_table_t *)(uintptr_t)table;
+}
+
+static inline flow_entry_t *entry_ptr(const flow_table_t *tbl,
+				      const flow_shard_t *shard, uint32_t idx)
+{
+	return (flow_entry_t *)(void *)(shard->entry +
+					(uint64_t)idx * tbl->entry_size);
+}
+
+static inline flow_shard_t *shard_ptr(flow_table_t *tbl, uint32_t shard)
+{
+	if (tbl->shared)
+		return &tbl->shard[0];
+
+	return &tbl->shard[shard];
+}
+
+/* Bucket of a flow hash. The same hash may have selected the shard, e.g.
+ * when the shard index is the RSS hashed input queue index. Then the low
+ * bits of the hash are equal in a shard, so the hash is mixed with a
+ * multiplication and the high bits select the bucket. */
+static inline flow_bucket_t *bucket_ptr(const flow_shard_t *shard,
+					uint32_t hash)
+{
+	uint32_t mix = hash * 0x9e3779b1;
+
+	return &shard->bucket[((uint64_t)mix * shard->num_buckets) >> 32];
+}
+
+static inline int key_equal(const odph_flow_key_t *a, const odph_flow_key_t *b)
+{
+	uint64_t a0, a1, b0, b1;
+
+	memcpy(&a0, a, 8);
+	memcpy(&a1, (const uint8_t *)a + 8, 8);
+	memcpy(&b0, b, 8);
+	memcpy(&b1, (const uint8_t *)b + 8, 8);
+
+	return ((a0 ^ b0) | (a1 ^ b1)) == 0;
+}
+
+static inline uint64_t time_now(void)
+{
+	return odp_time_to_ns(odp_time_global());
+}
+
+static inline void bucket_write_begin(flow_table_t *tbl, flow_bucket_t *b)
+{
+	if (!tbl->shared)
+		return;
+
+	odp_atomic_store_u32(&b->version, odp_atomic_load_u32(&b->version) + 1);
+
+	/* Odd version must be visible before the chain changes */
+	odp_mb_release();
+}
+
+static inline void bucket_write_end(flow_table_t *tbl, flow_bucket_t *b)
+{
+	if (!tbl->shared)
+		return;
+
+	odp_atomic_store_rel_u32(&b->version,
+				 odp_atomic_load_u32(&b->version) + 1);
+}
+
+/* Search a hash chain. Number of steps is limited, since in shared mode
+ * a chain may change during the search. */
+static inline flow_entry_t *chain_search(const flow_table_t *tbl,
+					 const flow_shard_t *shard,
+					 uint32_t next,
+					 const odph_flow_key_t *key,
+					 uint32_t hash)
+{
+	flow_entry_t *e;
+	uint32_t num = 0;
+
+	while (next && num < shard->num_entries) {
+		e = entry_ptr(tbl, shard, next - 1);
+
+		if (e->hash == hash && key_equal(&e->key, key))
+			return e;
+
+		next = e->next;
+		num++;
+	}
+
+	return NULL;
+}
+
+static inline flow_entry_t *flow_find(flow_table_t *tbl, flow_shard_t *shard,
+				      const odph_flow_key_t *key, uint32_t hash)
+{
+	flow_bucket_t *b = bucket_ptr(shard, hash);
+	flow_entry_t *e;
+	uint32_t ver;
+
+	if (!tbl->shared)
+		return chain_search(tbl, shard, b->head, key, hash);
+
+	while (1) {
+		ver = odp_atomic_load_acq_u32(&b->version);
+
+		if (odp_unlikely(ver & 1)) {
+			odp_cpu_pause();
+			continue;
+		}
+
+		e = chain_search(tbl, shard, b->head, key, hash);
+
+		odp_mb_acquire();
+
+		if (odp_likely(odp_atomic_load_u32(&b->version) == ver))
+			return e;
+	}
+}
+
+static int entry_alloc(flow_table_t *tbl, flow_shard_t *shard, uint64_t now)
+{
+	uint64_t free_time;
+	uint32_t idx;
+
+	if (shard->num_free == 0)
+		return -1;
+
+	idx = shard->free_ring[shard->free_head];
+
+	/* Entries are freed with the writer lock held and the current time,
+	 * so the free ring is in free time order. When the oldest free entry
+	 * is within the grace period, all other free entries are too. */
+	if (tbl->shared) {
+		free_time = odp_atomic_load_u64(&entry_ptr(tbl, shard, idx)->time);
+
+		if ((int64_t)(now - free_time) < (int64_t)FLOW_REUSE_GRACE_NS)
+			return -1;
+	}
+
+	shard->free_head++;
+	if (shard->free_head == shard->num_entries)
+		shard->free_head = 0;
+
+	shard->num_free--;
+	return idx;
+}
+
+static void entry_free(flow_table_t *tbl, flow_shard_t *shard, uint32_t idx,
+		       uint64_t now)
+{
+	uint32_t tail = shard->free_head + shard->num_free;
+
+	if (tail >= shard->num_entries)
+		tail -= shard->num_entries;
+
+	odp_atomic_store_u64(&entry_ptr(tbl, shard, idx)->time, now);
+	shard->free_ring[tail] = idx;
+	shard->num_free++;
+}
+
+/* Insert a new flow. Called by the shard owner, or with the writer lock in
+ * shared mode. */
+static flow_entry_t *flow_insert(flow_table_t *tbl, flow_shard_t *shard,
+				 const odph_flow_key_t *key, uint32_t hash,
+				 uint64_t now)
+{
+	flow_bucket_t *b = bucket_ptr(shard, hash);
+	flow_entry_t *e;
+	int idx;
+
+	idx = entry_alloc(tbl, shard, now);
+	if (idx < 0)
+		return NULL;
+
+	e = entry_ptr(tbl, shard, idx);
+	e->key = *key;
+	e->hash = hash;
+	e->used = 1;
+	e->next = b->head;
+	odp_atomic_store_u64(&e->time, now);
+	memset(e->data, 0, tbl->param.data_size);
+
+	bucket_write_begin(tbl, b);
+	b->head = idx + 1;
+	bucket_write_end(tbl, b);
+
+	shard->num_used++;
+	return e;
+}
+
+/* Remove a flow from its chain and free the entry */
+static void flow_unlink(flow_table_t *tbl, flow_shard_t *shard,
+			flow_entry_t *e, uint64_t now)
+{
+	flow_bucket_t *b = bucket_ptr(shard, e->hash);
+	uint32_t idx = ((uint8_t *)e - shard->entry) / tbl->entry_size;
+	uint32_t *prev = &b->head;
+
+	while (*prev != idx + 1)
+		prev = &entry_ptr(tbl, shard, *prev - 1)->next;
+
+	/* Next pointer of the removed entry is not changed, so that readers
+	 * currently on the entry may continue the search */
+	bucket_write_begin(tbl, b);
+	*prev = e->next;
+	bucket_write_end(tbl, b);
+
+	e->used = 0;
+	shard->num_used--;
+	entry_free(tbl, shard, idx, now);
+}
+
+void odph_flow_table_param_init(odph_flow_table_param_t *param)
+{
+	memset(param, 0, sizeof(odph_flow_table_param_t));
+	param->mode = ODPH_FLOW_TABLE_SHARED;
+	param->num_shards = 1;
+	param->max_flows = FLOW_TABLE_DEFAULT_FLOWS;
+}
+
+odph_flow_table_t odph_flow_table_create(const char *name,
+					 const odph_flow_table_param_t *param)
+{
+	flow_table_t *tbl;
+	flow_shard_t *shard;
+	odp_shm_t shm;
+	uint32_t num_shards, num_entries, num_buckets, entry_size, i, j;
+	uint64_t hdr_size, shard_size, size;
+	uint8_t *ptr;
+
+	if (name == NULL || strlen(name) == 0 ||
+	    strlen(name) >= ODPH_TABLE_NAME_LEN || param == NULL) {
+		ODPH_ERR("Bad flow table name\n");
+		return ODPH_FLOW_TABLE_INVALID;
+	}
+
+	num_shards = param->mode == ODPH_FLOW_TABLE_SHARDED ?
+		     param->num_shards : 1;
+
+	if (num_shards == 0 || param->max_flows < num_shards ||
+	    param->max_flows > (UINT32_MAX / 2)) {
+		ODPH_ERR("Bad flow table parameters\n");
+		return ODPH_FLOW_TABLE_INVALID;
+	}
+
+	if (odp_shm_lookup(name) != ODP_SHM_INVALID) {
+		ODPH_ERR("Flow table %s already exists\n", name);
+		return ODPH_FLOW_TABLE_INVALID;
+	}
+
+	num_entries = param->max_flows / num_shards;
+	num_buckets = 1;
+	while (num_buckets < num_entries)
+		num_buckets *= 2;
+
+	entry_size = (sizeof(flow_entry_t) + param->data_size + 7) & ~7;
+
+	/* Align small entries to cache lines, so that a lookup touches
+	 * a single line of an entry */
+	if (entry_size <= ODP_CACHE_LINE_SIZE)
+		entry_size = ODP_CACHE_LINE_SIZE;
+
+	hdr_size = CACHE_ROUNDUP(sizeof(flow_table_t) +
+				 num_shards * sizeof(flow_shard_t));
+	shard_size = CACHE_ROUNDUP((uint64_t)num_buckets *
+				   sizeof(flow_bucket_t)) +
+		     CACHE_ROUNDUP((uint64_t)num_entries * entry_size) +
+		     CACHE_ROUNDUP((uint64_t)num_entries * sizeof(uint32_t));
+	size = hdr_size + num_shards * shard_size;
+
+	shm = odp_shm_reserve(name, size, ODP_CACHE_LINE_SIZE, 0);
+	if (shm == ODP_SHM_INVALID) {
+		ODPH_ERR("Flow table shm reserve failed (%" PRIu64 " bytes)\n",
+			 size);
+		return ODPH_FLOW_TABLE_INVALID;
+	}
+
+	tbl = odp_shm_addr(shm);
+	memset(tbl, 0, hdr_size);
+
+	snprintf(tbl->name, sizeof(tbl->name), "%s", name);
+	tbl->param = *param;
+	tbl->shared = param->mode != ODPH_FLOW_TABLE_SHARDED;
+	tbl->num_shards = num_shards;
+	tbl->entry_size = entry_size;
+	tbl->shm = shm;
+
+	ptr = (uint8_t *)tbl + hdr_size;
+
+	for (i = 0; i < num_shards; i++) {
+		shard = &tbl->shard[i];
+
+		odp_spinlock_init(&shard->lock);
+		shard->num_buckets = num_buckets;
+		shard->num_entries = num_entries;
+		shard->num_free = num_entries;
+
+		shard->bucket = (flow_bucket_t *)(void *)ptr;
+		ptr += CACHE_ROUNDUP((uint64_t)num_buckets *
+				     sizeof(flow_bucket_t));
+		shard->entry = ptr;
+		ptr += CACHE_ROUNDUP((uint64_t)num_entries * entry_size);
+		shard->free_ring = (uint32_t *)(void *)ptr;
+		ptr += CACHE_ROUNDUP((uint64_t)num_entries * sizeof(uint32_t));
+
+		for (j = 0; j < num_buckets; j++) {
+			odp_atomic_init_u32(&shard->bucket[j].version, 0);
+			shard->bucket[j].head = 0;
+		}
+
+		for (j = 0; j < num_entries; j++) {
+			flow_entry_t *e = entry_ptr(tbl, shard, j);
+
+			e->used = 0;
+			odp_atomic_init_u64(&e->time, 0);
+			shard->free_ring[j] = j;
+		}
+	}
+
+	tbl->magicword = FLOW_TABLE_MAGIC_WORD;
+
+	return (odph_flow_table_t)tbl;
+}
+
+odph_flow_table_t odph_flow_table_lookup(const char *name)
+{
+	flow_table_t *tbl;
+	odp_shm_t shm;
+
+	if (name == NULL || strlen(name) >= ODPH_TABLE_NAME_LEN)
+		return ODPH_FLOW_TABLE_INVALID;
+
+	shm = odp_shm_lookup(name);
+	if (shm == ODP_SHM_INVALID)
+		return ODPH_FLOW_TABLE_INVALID;
+
+	tbl = odp_shm_addr(shm);
+	if (tbl == NULL || tbl->magicword != FLOW_TABLE_MAGIC_WORD ||
+	    strcmp(tbl->name, name))
+		return ODPH_FLOW_TABLE_INVALID;
+
+	return (odph_flow_table_t)tbl;
+}
+
+int odph_flow_table_destroy(odph_flow_table_t table)
+{
+	flow_table_t *tbl = flow_table(table);
+
+	if (tbl == NULL || tbl->magicword != FLOW_TABLE_MAGIC_WORD)
+		return -1;
+
+	tbl->magicword = 0;
+
+	return odp_shm_free(tbl->shm);
+}
+
+uint32_t odph_flow_hash(const odph_flow_key_t *key)
+{
+	return odp_hash_crc32c(key, sizeof(odph_flow_key_t), 0);
+}
+
+int odph_flow_table_lookup_insert_multi(odph_flow_table_t table,
+					uint32_t shard_idx,
+					const odph_flow_key_t key[],
+					const uint32_t hash_in[], void *data[],
+					int num, uint64_t *new_mask)
+{
+	flow_table_t *tbl = flow_table(table);
+	flow_shard_t *shard;
+	flow_entry_t *e;
+	flow_bucket_t *b;
+	uint32_t hash[ODPH_FLOW_TABLE_MULTI_MAX];
+	uint64_t miss = 0, new = 0, now = 0;
+	int aging, i, num_found = 0;
+
+	if (odp_unlikely(tbl == NULL || num < 0 ||
+			 num > ODPH_FLOW_TABLE_MULTI_MAX ||
+			 (!tbl->shared && shard_idx >= tbl->num_shards)))
+		return -1;
+
+	shard = shard_ptr(tbl, shard_idx);
+	aging = tbl->param.idle_timeout_ns != 0;
+
+	if (aging)
+		now = time_now();
+
+	/* Calculate hashes and prefetch buckets of all flows */
+	for (i = 0; i < num; i++) {
+		hash[i] = hash_in ? hash_in[i] : odph_flow_hash(&key[i]);
+		odp_prefetch(bucket_ptr(shard, hash[i]));
+	}
+
+	/* Prefetch the first entry of each chain */
+	for (i = 0; i < num; i++) {
+		b = bucket_ptr(shard, hash[i]);
+
+		if (b->head)
+			odp_prefetch(entry_ptr(tbl, shard, b->head - 1));
+	}
+
+	for (i = 0; i < num; i++) {
+		e = flow_find(tbl, shard, &key[i], hash[i]);
+
+		if (e == NULL) {
+			data[i] = NULL;
+			miss |= 1ULL << i;
+			continue;
+		}
+
+		if (aging)
+			odp_atomic_store_u64(&e->time, now);
+
+		data[i] = e->data;
+		num_found++;
+	}
+
+	if (miss) {
+		if (tbl->shared) {
+			odp_spinlock_lock(&shard->lock);
+
+			/* Read after the lock, so that the time is not older
+			 * than free times of entries */
+			now = time_now();
+		}
+
+		for (i = 0; i < num; i++) {
+			if (!(miss & (1ULL << i)))
+				continue;
+
+			e = NULL;
+
+			/* Another thread, or an earlier key of this call, may
+			 * have inserted the flow */
+			if (tbl->shared || (new & ((1ULL << i) - 1)))
+				e = flow_find(tbl, shard, &key[i], hash[i]);
+
+			if (e == NULL) {
+				e = flow_insert(tbl, shard, &key[i], hash[i],
+						now);
+				if (e == NULL)
+					continue;
+
+				new |= 1ULL << i;
+			}
+
+			data[i] = e->data;
+			num_found++;
+		}
+
+		if (tbl->shared)
+			odp_spinlock_unlock(&shard->lock);
+	}
+
+	if (new_mask)
+		*new_mask = new;
+
+	return num_found;
+}
+
+void *odph_flow_table_find(odph_flow_table_t table, uint32_t shard_idx,
+			   const odph_flow_key_t *key, const uint32_t *hash)
+{
+	flow_table_t *tbl = flow_table(table);
+	flow_entry_t *e;
+
+	if (odp_unlikely(tbl == NULL || key == NULL ||
+			 (!tbl->shared && shard_idx >= tbl->num_shards)))
+		return NULL;
+
+	e = flow_find(tbl, shard_ptr(tbl, shard_idx), key,
+		      hash ? *hash : odph_flow_hash(key));
+
+	return e ? e->data : NULL;
+}
+
+int odph_flow_table_remove(odph_flow_table_t table, uint32_t shard_idx,
+			   const odph_flow_key_t *key, const uint32_t *hash)
+{
+	flow_table_t *tbl = flow_table(table);
+	flow_shard_t *shard;
+	flow_entry_t *e;
+	int ret = -1;
+
+	if (tbl == NULL || key == NULL ||
+	    (!tbl->shared && shard_idx >= tbl->num_shards))
+		return -1;
+
+	shard = shard_ptr(tbl, shard_idx);
+
+	if (tbl->shared)
+		odp_spinlock_lock(&shard->lock);
+
+	e = flow_find(tbl, shard, key, hash ? *hash : odph_flow_hash(key));
+	if (e) {
+		flow_unlink(tbl, shard, e, tbl->shared ? time_now() : 0);
+		ret = 0;
+	}
+
+	if (tbl->shared)
+		odp_spinlock_unlock(&shard->lock);
+
+	return ret;
+}
+
+int odph_flow_table_age(odph_flow_table_t table, uint32_t shard_idx,
+			uint32_t max_scan)
+{
+	flow_table_t *tbl = flow_table(table);
+	const odph_flow_table_param_t *param;
+	flow_shard_t *shard;
+	flow_entry_t *e;
+	uint64_t now;
+	uint32_t i;
+	int num = 0;
+
+	if (tbl == NULL || (!tbl->shared && shard_idx >= tbl->num_shards))
+		return -1;
+
+	param = &tbl->param;
+	if (param->idle_timeout_ns == 0)
+		return 0;
+
+	shard = shard_ptr(tbl, shard_idx);
+
+	if (max_scan > shard->num_entries)
+		max_scan = shard->num_entries;
+
+	if (tbl->shared)
+		odp_spinlock_lock(&shard->lock);
+
+	now = time_now();
+
+	for (i = 0; i < max_scan; i++) {
+		e = entry_ptr(tbl, shard, shard->age_pos);
+
+		shard->age_pos++;
+		if (shard->age_pos == shard->num_entries)
+			shard->age_pos = 0;
+
+		/* Lookups may update time concurrently, and to a later time
+		 * than 'now' */
+		if (!e->used ||
+		    (int64_t)(now - odp_atomic_load_u64(&e->time)) <=
+		    (int64_t)param->idle_timeout_ns)
+			continue;
+
+		if (param->evict_fn)
+			param->evict_fn(&e->key, e->data, param->evict_arg);
+
+		flow_unlink(tbl, shard, e, now);
+		num++;
+	}
+
+	if (tbl->shared)
+		odp_spinlock_unlock(&shard->lock);
+
+	return num;
+}
+
+uint32_t odph_flow_table_count(odph_flow_table_t table, uint32_t shard_idx)
+{
+	flow_table_t *tbl = flow_table(table);
+
+	if (tbl == NULL || (!tbl->shared && shard_idx >= tbl->num_shards))
+		return 0;
+
+	return shard_ptr(tbl, shard_idx)->num_used;
+}
@@ -5,12 +5,11 @@
  */
 
 #include <stdio.h>
+#include <stdint.h>
 #include <string.h>
-#include <malloc.h>
 
 #include <odp/helper/odph_hashtable.h>
 #include <odp/helper/odph_debug.h>
-#include "odph_list_internal.h"
 #include <odp_api.h>
 
 #define    ODPH_SUCCESS	0
@@ -21,56 +20,244 @@
  */
 #define    ODPH_HASH_TABLE_MAGIC_WORD	0xABABBABA
 
-/** @support 64k buckets. Bucket is a list that composed of
- * elements with the same HASH-value but different keys
- */
-#define    ODPH_MAX_BUCKET_NUM			0x10000
+/** Number of nodes in the first table size */
+#define    ODPH_HASH_INIT_NODES		1024
+
+/** Maximum number of indexes (table resizes + 1) */
+#define    ODPH_HASH_MAX_ARRAYS		32
+
+#define CACHE_ROUNDUP(x) \
+	(((x) + ODP_CACHE_LINE_SIZE - 1) & ~((uint64_t)ODP_CACHE_LINE_SIZE - 1))
+
+/** Empty index slot. Other values include node index + 1. */
+#define    SLOT_EMPTY			0
 
 /** @inner element structure of hash table
- * To resolve the hash confict:
- * we put the elements with different keys but a same HASH-value
- * into a list
+ * Writer increments node version before and after it modifies the node,
+ * so the version is odd during an update. Readers copy the value without
+ * locks and retry when the version changes.
  */
 typedef struct odph_hash_node {
-	/** list structure,for list opt */
-	odph_list_object list_node;
+	odp_atomic_u32_t version;
 	/** Flexible Array,memory will be alloced when table has been created
 	 * Its length is key_size + value_size,
 	 * suppose key_size = m; value_size = n;
 	 * its structure is like:
 	 * k_byte1 k_byte2...k_byten v_byte1...v_bytem
 	 */
-	char content[];
+	uint8_t content[];
 } odph_hash_node;
 
+/** Open addressing index of a table
+ * Index slot stores hash value (upper 32 bits) and node index + 1
+ * (lower 32 bits). Collisions are resolved with linear probing. When an
+ * entry is removed, following entries of the probe sequence are shifted
+ * backwards, so that the index does not collect removed entry markers.
+ * An index covers the first 'num_nodes' nodes of the node pool.
+ */
+typedef struct {
+	/** number of nodes covered by the index */
+	uint32_t num_nodes;
+	/** number of index slots, a power of two */
+	uint32_t num_slots;
+	/** offset of the first index slot from the start of the table */
+	uint64_t slot_offset;
+} odph_hash_array;
+
+/** Table memory is reserved at create and contains the table header,
+ * a free node stack and a node pool for the maximum number of nodes, and
+ * an index for each table size. Free nodes are kept in a stack, so insert
+ * does not search for a node. Memory is referred with offsets, so that
+ * table works also when processes map it to different addresses.
+ */
 typedef struct {
 	uint32_t magicword; /**< for check */
 	uint32_t key_size; /**< input param when create,in Bytes */
 	uint32_t value_size; /**< input param when create,in Bytes */
-	uint32_t init_cap; /**< input param when create,in Bytes */
-	/** multi-process support,every list has one rw lock */
-	odp_rwlock_t *lock_pool;
-	/** table bucket pool,every hash value has one list head */
-	odph_list_head *list_head_pool;
-	/** number of the list head in list_head_pool */
-	uint32_t head_num;
-	/** table element pool */
-	odph_hash_node *hash_node_pool;
-	/** number of element in the hash_node_pool */
-	uint32_t hash_node_num;
-	char rsv[7]; /**< Reserved,for alignment */
+	uint32_t init_cap; /**< input param when create,in MBytes */
+	uint32_t node_size; /**< node size in bytes */
+	uint32_t max_nodes; /**< max number of nodes with init_cap memory */
+	/** writers are serialized, readers do not lock */
+	odp_spinlock_t lock;
+	/** current index (odph_hash_array index) */
+	odp_atomic_u32_t cur;
+	/** incremented when an entry is shifted to another index slot */
+	odp_atomic_u32_t chng_cnt;
+	/** number of nodes in the free node stack */
+	uint32_t num_free;
+	/** number of indexes, one per table size */
+	uint32_t num_arrays;
+	/** offset of the free node stack */
+	uint64_t free_offset;
+	/** offset of the node pool */
+	uint64_t node_offset;
+	/** indexes of all table sizes. Readers may still access an index
+	 * after it has been replaced, so indexes are not reused. */
+	odph_hash_array array[ODPH_HASH_MAX_ARRAYS];
 	char name[ODPH_TABLE_NAME_LEN]; /**< table name */
 } odph_hash_table_imp;
 
+static inline odph_hash_node *node_ptr(odph_hash_table_imp *tbl,
+				       uint32_t idx)
+{
+	return (odph_hash_node *)(void *)((uint8_t *)tbl + tbl->node_offset +
+					  (uint64_t)idx * tbl->node_size);
+}
+
+static inline uint32_t *free_stack(odph_hash_table_imp *tbl)
+{
+	return (uint32_t *)(void *)((uint8_t *)tbl + tbl->free_offset);
+}
+
+static inline odp_atomic_u64_t *slot_ptr(odph_hash_table_imp *tbl,
+					 odph_hash_array *arr)
+{
+	return (odp_atomic_u64_t *)(void *)((uint8_t *)tbl + arr->slot_offset);
+}
+
+static inline uint64_t slot_val(uint32_t hash, uint32_t node)
+{
+	return ((uint64_t)hash << 32) | node;
+}
+
+static inline odph_hash_array *cur_array(odph_hash_table_imp *tbl)
+{
+	return &tbl->array[odp_atomic_load_acq_u32(&tbl->cur)];
+}
+
+static inline void node_write_begin(odph_hash_node *node)
+{
+	odp_atomic_store_u32(&node->version,
+			     odp_atomic_load_u32(&node->version) + 1);
+
+	/* Odd version must be visible before node content changes */
+	odp_mb_release();
+}
+
+static inline void node_write_end(odph_hash_node *node)
+{
+	odp_atomic_store_rel_u32(&node->version,
+				 odp_atomic_load_u32(&node->version) + 1);
+}
+
+/* Calculate table memory size with 'max_nodes' nodes. Table starts with
+ * ODPH_HASH_INIT_NODES nodes and doubles the number of nodes on every
+ * resize. Index has at least twice as many slots as there are nodes. When
+ * 'tbl' is not NULL, table memory layout is stored into it. */
+static uint64_t table_size(odph_hash_table_imp *tbl, uint32_t node_size,
+			   uint32_t max_nodes)
+{
+	uint64_t size, num_slots;
+	uint32_t num_nodes = ODPH_HASH_INIT_NODES;
+	uint32_t i = 0;
+
+	size = CACHE_ROUNDUP(sizeof(odph_hash_table_imp));
+	if (tbl)
+		tbl->free_offset = size;
+
+	size += CACHE_ROUNDUP((uint64_t)max_nodes * sizeof(uint32_t));
+	if (tbl)
+		tbl->node_offset = size;
+
+	size += CACHE_ROUNDUP((uint64_t)max_nodes * node_size);
+
+	while (1) {
+		if (num_nodes > max_nodes)
+			num_nodes = max_nodes;
+
+		num_slots = ODPH_HASH_INIT_NODES;
+		while (num_slots < 2 * (uint64_t)num_nodes)
+			num_slots *= 2;
+
+		if (tbl) {
+			tbl->array[i].num_nodes = num_nodes;
+			tbl->array[i].num_slots = num_slots;
+			tbl->array[i].slot_offset = size;
+		}
+
+		size += num_slots * sizeof(odp_atomic_u64_t);
+		i++;
+
+		if (num_nodes == max_nodes)
+			break;
+
+		num_nodes *= 2;
+	}
+
+	if (tbl)
+		tbl->num_arrays = i;
+
+	return size;
+}
+
+/* Add nodes [first, last) to the free node stack. Lower nodes are
+ * allocated first. */
+static void nodes_free(odph_hash_table_imp *tbl, uint32_t first,
+		       uint32_t last)
+{
+	uint32_t *free_node = free_stack(tbl);
+	uint32_t i;
+
+	for (i = last; i > first; i--) {
+		odp_atomic_init_u32(&node_ptr(tbl, i - 1)->version, 0);
+		free_node[tbl->num_free++] = i - 1;
+	}
+}
+
+/* Move all entries from the current index into the next one, and add
+ * nodes of the next table size into the free node stack. Entries keep
+ * their node index. */
+static odph_hash_array *array_resize(odph_hash_table_imp *tbl,
+				     odph_hash_array *old)
+{
+	odph_hash_array *arr;
+	odp_atomic_u64_t *old_slot, *slot;
+	uint32_t i, idx, node, mask, next;
+	uint64_t val;
+
+	next = odp_atomic_load_u32(&tbl->cur) + 1;
+	if (next == tbl->num_arrays)
+		return NULL;
+
+	arr = &tbl->array[next];
+	old_slot = slot_ptr(tbl, old);
+	slot = slot_ptr(tbl, arr);
+	mask = arr->num_slots - 1;
+
+	for (i = 0; i < arr->num_slots; i++)
+		odp_atomic_init_u64(&slot[i], SLOT_EMPTY);
+
+	for (i = 0; i < old->num_slots; i++) {
+		val = odp_atomic_load_u64(&old_slot[i]);
+		node = (uint32_t)val;
+
+		if (node == SLOT_EMPTY)
+			continue;
+
+		idx = (val >> 32) & mask;
+		while (odp_atomic_load_u64(&slot[idx]) != SLOT_EMPTY)
+			idx = (idx + 1) & mask;
+
+		odp_atomic_store_u64(&slot[idx], val);
+	}
+
+	nodes_free(tbl, old->num_nodes, arr->num_nodes);
+
+	odp_atomic_store_rel_u32(&tbl->cur, next);
+
+	return arr;
+}
+
 odph_table_t odph_hash_table_create(const char *name, uint32_t capacity,
 				    uint32_t key_size,
 				    uint32_t value_size)
 {
-	int i;
-	uint32_t node_num;
+	uint32_t i, node_size, min, max, mid;
+	uint64_t mem_size;
 	odph_hash_table_imp *tbl;
+	odph_hash_array *arr;
+	odp_atomic_u64_t *slot;
 	odp_shm_t shmem;
-	uint32_t node_mem;
 
 	if (strlen(name) >= ODPH_TABLE_NAME_LEN || capacity < 1 ||
 	    capacity >= 0x1000 || key_size == 0 || value_size == 0) {
@@ -81,47 +268,61 @@ odph_table_t odph_hash_table_create(const char *name, uint32_t capacity,
 		ODPH_DBG("name already exist\n");
 		return NULL;
 	}
-	shmem = odp_shm_reserve(name, capacity << 20, 64, 0);
+
+	node_size = (sizeof(odph_hash_node) + key_size + value_size +
+		     sizeof(uint32_t) - 1) & ~(sizeof(uint32_t) - 1);
+
+	/* Find the maximum number of nodes that fit into 'capacity' MB */
+	mem_size = (uint64_t)capacity << 20;
+	min = 0;
+	max = UINT32_MAX / 4;
+	while (min < max) {
+		mid = min + (max - min + 1) / 2;
+		if (table_size(NULL, node_size, mid) <= mem_size)
+			min = mid;
+		else
+			max = mid - 1;
+	}
+
+	if (min == 0) {
+		ODPH_DBG("too small capacity\n");
+		return NULL;
+	}
+
+	/* All memory is reserved here. Memory reserved later would not be
+	 * mapped in other processes. */
+	mem_size = table_size(NULL, node_size, min);
+	shmem = odp_shm_reserve(name, mem_size, ODP_CACHE_LINE_SIZE, 0);
 	if (shmem == ODP_SHM_INVALID) {
 		ODPH_DBG("shm reserve fail\n");
 		return NULL;
 	}
 	tbl = (odph_hash_table_imp *)odp_shm_addr(shmem);
 
-	/* clean this block of memory */
-	memset(tbl, 0, capacity << 20);
+	/* clean table header, other memory is initialized when taken into
+	 * use */
+	memset(tbl, 0, sizeof(odph_hash_table_imp));
 
-	tbl->init_cap = capacity << 20;
+	tbl->init_cap = capacity;
 	strncpy(tbl->name, name, ODPH_TABLE_NAME_LEN - 1);
 	tbl->key_size = key_size;
 	tbl->value_size = value_size;
+	tbl->node_size = node_size;
+	tbl->max_nodes = min;
+	table_size(tbl, node_size, min);
 
-	/* header of this mem block is the table control struct,
-	 * then the lock pool, then the list header pool
-	 * the last part is the element node pool
-	 */
+	odp_spinlock_init(&tbl->lock);
+	odp_atomic_init_u32(&tbl->chng_cnt, 0);
+	odp_atomic_init_u32(&tbl->cur, 0);
 
-	tbl->lock_pool = (odp_rwlock_t *)(void *)((char *)tbl
-			+ sizeof(odph_hash_table_imp));
-	tbl->list_head_pool = (odph_list_head *)(void *)((char *)tbl->lock_pool
-			+ ODPH_MAX_BUCKET_NUM * sizeof(odp_rwlock_t));
-
-	node_mem = tbl->init_cap - sizeof(odph_hash_table_imp)
-		- ODPH_MAX_BUCKET_NUM * sizeof(odph_list_head)
-		- ODPH_MAX_BUCKET_NUM * sizeof(odp_rwlock_t);
-
-	node_num = node_mem / (sizeof(odph_hash_node) + key_size + value_size);
-	tbl->hash_node_num = node_num;
-	tbl->hash_node_pool =
-		(odph_hash_node *)(void *)((char *)tbl->list_head_pool
-		+ ODPH_MAX_BUCKET_NUM * sizeof(odph_list_head));
-
-	/* init every list head and rw lock */
-	for (i = 0; i < ODPH_MAX_BUCKET_NUM; i++) {
-		ODPH_INIT_LIST_HEAD(&tbl->list_head_pool[i]);
-		odp_rwlock_init((odp_rwlock_t *)&tbl->lock_pool[i]);
-	}
+	arr = &tbl->array[0];
+	slot = slot_ptr(tbl, arr);
+	for (i = 0; i < arr->num_slots; i++)
+		odp_atomic_init_u64(&slot[i], SLOT_EMPTY);
 
+	nodes_free(tbl, 0, arr->num_nodes);
+
+	odp_mb_full();
 	tbl->magicword = ODPH_HASH_TABLE_MAGIC_WORD;
 	return (odph_table_t)tbl;
 }
@@ -137,6 +338,8 @@ int odph_hash_table_destroy(odph_table_t table)
 		if (hash_tbl->magicword != ODPH_HASH_TABLE_MAGIC_WORD)
 			return ODPH_FAIL;
 
+		hash_tbl->magicword = 0;
+
 		ret = odp_shm_free(odp_shm_lookup(hash_tbl->name));
 		if (ret != 0) {
 			ODPH_DBG("free fail\n");
@@ -159,121 +362,217 @@ odph_table_t odph_hash_table_lookup(const char *name)
 	shm = odp_shm_lookup(name);
 	if (shm != ODP_SHM_INVALID)
 		hash_tbl = (odph_hash_table_imp *)odp_shm_addr(shm);
-	if (hash_tbl != NULL && strcmp(hash_tbl->name, name) == 0)
+	if (hash_tbl != NULL &&
+	    hash_tbl->magicword == ODPH_HASH_TABLE_MAGIC_WORD &&
+	    strcmp(hash_tbl->name, name) == 0)
 		return (odph_table_t)hash_tbl;
 	return NULL;
 }
 
 /**
- * Calculate has value by the input key and key_size
- * This hash algorithm is the most simple one, so we choose it as an DEMO
- * User can use any other algorithm, like CRC...
+ * Calculate hash value of the input key
  */
-static uint16_t odp_key_hash(void *key, uint32_t key_size)
+static inline uint32_t odp_key_hash(odph_hash_table_imp *tbl, const void *key)
 {
-	register uint32_t hash = 0;
-	uint32_t idx = (key_size == 0 ? 1 : key_size);
-	uint32_t ch;
-
-	while (idx != 0) {
-		ch = (uint32_t)(*(char *)key);
-		hash = hash * 131 + ch;
-		idx--;
-	}
-	return (uint16_t)(hash & 0x0000FFFF);
+	return odp_hash_crc32c(key, tbl->key_size, 0);
 }
 
 /**
- * Get an available node from pool
+ * Search a key from the index. Called with the writer lock. Returns slot
+ * index of the key or -1 when not found. The empty slot, which ended
+ * the search, is written to 'ins_idx'.
  */
-static odph_hash_node *hashnode_take(odph_table_t table)
+static int64_t key_find(odph_hash_table_imp *tbl, odph_hash_array *arr,
+			uint32_t hash, const void *key, uint32_t *ins_idx)
 {
-	odph_hash_table_imp *tbl;
-	uint32_t idx;
-	odph_hash_node *node;
+	odp_atomic_u64_t *slot = slot_ptr(tbl, arr);
+	uint32_t mask = arr->num_slots - 1;
+	uint32_t idx = hash & mask;
+	uint64_t val;
+	uint32_t node;
 
-	tbl = (odph_hash_table_imp *)(void *)table;
-	for (idx = 0; idx < tbl->hash_node_num; idx++) {
-		/** notice: memory of one hash_node is
-		 * not only sizeof(odph_hash_node)
-		 * should add the size of Flexible Array
-		 */
-		node = (odph_hash_node *)(void *)((char *)tbl->hash_node_pool
-				+ idx * (sizeof(odph_hash_node)
-						+ tbl->key_size
-						+ tbl->value_size));
-		if (node->list_node.next == NULL &&
-		    node->list_node.prev == NULL) {
-			ODPH_INIT_LIST_HEAD(&node->list_node);
-			return node;
-		}
+	while (1) {
+		val = odp_atomic_load_u64(&slot[idx]);
+		node = (uint32_t)val;
+
+		if (node == SLOT_EMPTY)
+			break;
+
+		if ((uint32_t)(val >> 32) == hash &&
+		    memcmp(node_ptr(tbl, node - 1)->content, key,
+			   tbl->key_size) == 0)
+			return idx;
+
+		idx = (idx + 1) & mask;
 	}
-	return NULL;
+
+	*ins_idx = idx;
+	return -1;
 }
 
-/**
- * Release an node to the pool
- */
-static void hashnode_give(odph_table_t table, odph_hash_node *node)
+/* Insert or update a key. Called with the writer lock. */
+static int hash_put(odph_hash_table_imp *tbl, uint32_t hash, const void *key,
+		    const void *value)
 {
-	odph_hash_table_imp *tbl;
+	odph_hash_array *arr;
+	odph_hash_node *node;
+	uint32_t idx, ins_idx;
+	int64_t found;
 
-	if (node == NULL)
-		return;
+	arr = cur_array(tbl);
 
-	tbl = (odph_hash_table_imp *)(void *)table;
+	/* First, check if the key already exist */
+	found = key_find(tbl, arr, hash, key, &ins_idx);
+
+	if (found >= 0) {
+		/* copy value content to hash node*/
+		idx = (uint32_t)odp_atomic_load_u64(&slot_ptr(tbl, arr)[found]) - 1;
+		node = node_ptr(tbl, idx);
+		node_write_begin(node);
+		memcpy(node->content + tbl->key_size, value, tbl->value_size);
+		node_write_end(node);
+		return ODPH_SUCCESS;
+	}
 
-	odph_list_del(&node->list_node);
-	memset(node, 0,
-	       (sizeof(odph_hash_node) + tbl->key_size + tbl->value_size));
+	/* Grow when all nodes are in use. Index is at most half full. */
+	if (tbl->num_free == 0) {
+		arr = array_resize(tbl, arr);
+		if (arr == NULL)
+			return ODPH_FAIL;
+
+		key_find(tbl, arr, hash, key, &ins_idx);
+	}
+
+	/* if the key is a new one, get a new hash node from the free stack */
+	idx = free_stack(tbl)[--tbl->num_free];
+	node = node_ptr(tbl, idx);
+
+	/* copy both key and value content to the hash node. Readers may
+	 * still access the node, if it was removed recently. */
+	node_write_begin(node);
+	memcpy(node->content, key, tbl->key_size);
+	memcpy(node->content + tbl->key_size, value, tbl->value_size);
+	node_write_end(node);
+
+	/* add the node to index */
+	odp_atomic_store_rel_u64(&slot_ptr(tbl, arr)[ins_idx],
+				 slot_val(hash, idx + 1));
+
+	return ODPH_SUCCESS;
 }
 
 /* should make sure the input table exists and is available */
 int odph_hash_put_value(odph_table_t table, void *key, void *value)
 {
 	odph_hash_table_imp *tbl;
-	uint16_t hash = 0;
-	odph_hash_node *node = NULL;
-	char *tmp = NULL;
+	uint32_t hash;
+	int ret;
 
 	if (table == NULL || key == NULL || value == NULL)
 		return ODPH_FAIL;
 
 	tbl = (odph_hash_table_imp *)(void *)table;
-	/* hash value is just the index of the list head in pool */
-	hash = odp_key_hash(key, tbl->key_size);
+	hash = odp_key_hash(tbl, key);
 
-	odp_rwlock_write_lock(&tbl->lock_pool[hash]);
-	/* First, check if the key already exist */
-	ODPH_LIST_FOR_EACH(node, &tbl->list_head_pool[hash], odph_hash_node,
-			   list_node)
-	{
-		if (memcmp(node->content, key, tbl->key_size) == 0) {
-			/* copy value content to hash node*/
-			tmp = (void *)((char *)node->content + tbl->key_size);
-			memcpy(tmp, value, tbl->value_size);
-			odp_rwlock_write_unlock(&tbl->lock_pool[hash]);
-			return ODPH_SUCCESS;
-		}
-	}
+	odp_spinlock_lock(&tbl->lock);
+	ret = hash_put(tbl, hash, key, value);
+	odp_spinlock_unlock(&tbl->lock);
+
+	return ret;
+}
 
-	/*if the key is a new one, get a new hash node form the pool */
-	node = hashnode_take(table);
-	if (node == NULL) {
-		odp_rwlock_write_unlock(&tbl->lock_pool[hash]);
+int odph_hash_put_value_multi(odph_table_t table, void *key[],
+			      void *value[], int num)
+{
+	odph_hash_table_imp *tbl;
+	uint32_t hash[ODPH_TABLE_MULTI_MAX];
+	int i;
+
+	if (table == NULL || key == NULL || value == NULL || num < 0 ||
+	    num > ODPH_TABLE_MULTI_MAX)
 		return ODPH_FAIL;
+
+	tbl = (odph_hash_table_imp *)(void *)table;
+
+	/* Calculate hashes before taking the lock */
+	for (i = 0; i < num; i++)
+		hash[i] = odp_key_hash(tbl, key[i]);
+
+	odp_spinlock_lock(&tbl->lock);
+
+	for (i = 0; i < num; i++) {
+		if (hash_put(tbl, hash[i], key[i], value[i]))
+			break;
 	}
 
-	/* copy both key and value content to the hash node */
-	memcpy(node->content, key, tbl->key_size);
-	tmp = (void *)((char *)node->content + tbl->key_size);
-	memcpy(tmp, value, tbl->value_size);
+	odp_spinlock_unlock(&tbl->lock);
 
-	/* add the node to list */
-	odph_list_add(&node->list_node, &tbl->list_head_pool[hash]);
+	if (i == 0 && num > 0)
+		return ODPH_FAIL;
 
-	odp_rwlock_write_unlock(&tbl->lock_pool[hash]);
-	return ODPH_SUCCESS;
+	return i;
+}
+
+/* Lock-free lookup of a key */
+static inline int hash_get(odph_hash_table_imp *tbl, uint32_t hash,
+			   const void *key, void *buffer)
+{
+	odph_hash_array *arr;
+	odph_hash_node *node;
+	odp_atomic_u64_t *slot;
+	uint32_t mask, idx, node_idx, ver, num, cnt;
+	uint64_t val;
+	int match;
+
+retry:
+	cnt = odp_atomic_load_acq_u32(&tbl->chng_cnt);
+	arr = cur_array(tbl);
+	slot = slot_ptr(tbl, arr);
+	mask = arr->num_slots - 1;
+	idx = hash & mask;
+
+	for (num = 0; num < arr->num_slots; ) {
+		val = odp_atomic_load_acq_u64(&slot[idx]);
+		node_idx = (uint32_t)val;
+
+		if (node_idx == SLOT_EMPTY)
+			break;
+
+		if ((uint32_t)(val >> 32) == hash) {
+			node = node_ptr(tbl, node_idx - 1);
+			ver = odp_atomic_load_acq_u32(&node->version);
+
+			/* in case of hash conflict, compare the whole key */
+			match = !(ver & 1) &&
+				memcmp(node->content, key, tbl->key_size) == 0;
+			if (match)
+				memcpy(buffer, node->content + tbl->key_size,
+				       tbl->value_size);
+
+			odp_mb_acquire();
+
+			/* Node was modified, read the slot again */
+			if (odp_unlikely((ver & 1) ||
+					 odp_atomic_load_u32(&node->version) != ver)) {
+				odp_cpu_pause();
+				continue;
+			}
+
+			if (match)
+				return ODPH_SUCCESS;
+		}
+
+		idx = (idx + 1) & mask;
+		num++;
+	}
+
+	/* Entries were shifted during the search. The key may have been
+	 * moved to a slot that was already passed. */
+	odp_mb_acquire();
+	if (odp_atomic_load_u32(&tbl->chng_cnt) != cnt)
+		goto retry;
+
+	return ODPH_FAIL;
 }
 
 /* should make sure the input table exists and is available */
@@ -281,9 +580,6 @@ int odph_hash_get_value(odph_table_t table, void *key, void *buffer,
 			uint32_t buffer_size)
 {
 	odph_hash_table_imp *tbl;
-	uint16_t hash = 0;
-	odph_hash_node *node;
-	char *tmp = NULL;
 
 	tbl = (odph_hash_table_imp *)(void *)table;
 
@@ -291,61 +587,165 @@ int odph_hash_get_value(odph_table_t table, void *key, void *buffer,
 	    buffer_size < tbl->value_size)
 		return ODPH_FAIL;
 
-	/* hash value is just the index of the list head in pool */
-	hash = odp_key_hash(key, tbl->key_size);
+	return hash_get(tbl, odp_key_hash(tbl, key), key, buffer);
+}
 
-	odp_rwlock_read_lock(&tbl->lock_pool[hash]);
+int odph_hash_get_value_multi(odph_table_t table, void *key[],
+			      void *buffer[], uint32_t buffer_size,
+			      int num, uint64_t *hit_mask)
+{
+	odph_hash_table_imp *tbl;
+	odph_hash_array *arr;
+	uint32_t hash[ODPH_TABLE_MULTI_MAX];
+	odp_atomic_u64_t *slot;
+	uint32_t mask, node_idx;
+	uint64_t val, hits = 0;
+	int i, num_hit = 0;
 
-	ODPH_LIST_FOR_EACH(node, &tbl->list_head_pool[hash],
-			   odph_hash_node, list_node)
-	{
-		/* in case of hash conflict, compare the whole key */
-		if (memcmp(node->content, key, tbl->key_size) == 0) {
-			/* find the target */
-			tmp = (void *)((char *)node->content + tbl->key_size);
-			memcpy(buffer, tmp, tbl->value_size);
+	tbl = (odph_hash_table_imp *)(void *)table;
 
-			odp_rwlock_read_unlock(&tbl->lock_pool[hash]);
+	if (table == NULL || key == NULL || buffer == NULL ||
+	    buffer_size < tbl->value_size || num < 0 ||
+	    num > ODPH_TABLE_MULTI_MAX)
+		return ODPH_FAIL;
+
+	arr = cur_array(tbl);
+	slot = slot_ptr(tbl, arr);
+	mask = arr->num_slots - 1;
+
+	/* Calculate hashes and prefetch home slots of all keys */
+	for (i = 0; i < num; i++) {
+		hash[i] = odp_key_hash(tbl, key[i]);
+		odp_prefetch(&slot[hash[i] & mask]);
+	}
+
+	/* Prefetch nodes of home slots with matching hash */
+	for (i = 0; i < num; i++) {
+		val = odp_atomic_load_u64(&slot[hash[i] & mask]);
+		node_idx = (uint32_t)val;
 
-			return ODPH_SUCCESS;
+		if (node_idx != SLOT_EMPTY && (uint32_t)(val >> 32) == hash[i])
+			odp_prefetch(node_ptr(tbl, node_idx - 1));
+	}
+
+	/* Search keys. Table may have been resized after prefetching, which
+	 * slows down but does not break the search. */
+	for (i = 0; i < num; i++) {
+		if (hash_get(tbl, hash[i], key[i], buffer[i]) == ODPH_SUCCESS) {
+			hits |= 1ULL << i;
+			num_hit++;
 		}
 	}
 
-	odp_rwlock_read_unlock(&tbl->lock_pool[hash]);
+	if (hit_mask)
+		*hit_mask = hits;
 
-	return ODPH_FAIL;
+	return num_hit;
+}
+
+/* Remove a key. Called with the writer lock. Returns 1 when the key was
+ * found and removed, 0 otherwise. */
+static int hash_remove(odph_hash_table_imp *tbl, uint32_t hash,
+		       const void *key)
+{
+	odph_hash_array *arr;
+	odp_atomic_u64_t *slot;
+	uint32_t ins_idx, node_idx, i, j, home, mask;
+	uint64_t val;
+	int64_t found;
+
+	arr = cur_array(tbl);
+	slot = slot_ptr(tbl, arr);
+
+	found = key_find(tbl, arr, hash, key, &ins_idx);
+	if (found >= 0) {
+		mask = arr->num_slots - 1;
+		i = found;
+		j = found;
+		node_idx = (uint32_t)odp_atomic_load_u64(&slot[i]);
+
+		/* Shift following entries of the probe sequence into the
+		 * free slot. An entry can be moved from slot j to slot i,
+		 * when its home slot is not cyclically within (i, j]. */
+		while (1) {
+			j = (j + 1) & mask;
+			val = odp_atomic_load_u64(&slot[j]);
+
+			if ((uint32_t)val == SLOT_EMPTY)
+				break;
+
+			home = (val >> 32) & mask;
+			if (((j - home) & mask) < ((j - i) & mask))
+				continue;
+
+			odp_atomic_store_rel_u64(&slot[i], val);
+
+			/* Entry is now in both slots. Readers that miss it
+			 * when slot j is overwritten retry the search. */
+			odp_atomic_add_rel_u32(&tbl->chng_cnt, 1);
+			odp_mb_release();
+			i = j;
+		}
+
+		odp_atomic_store_rel_u64(&slot[i], SLOT_EMPTY);
+		free_stack(tbl)[tbl->num_free++] = node_idx - 1;
+		return 1;
+	}
+
+	return 0;
 }
 
 /* should make sure the input table exists and is available */
 int odph_hash_remove_value(odph_table_t table, void *key)
 {
 	odph_hash_table_imp *tbl;
-	uint16_t hash = 0;
-	odph_hash_node *node;
+	uint32_t hash;
 
 	if (table == NULL || key == NULL)
 		return ODPH_FAIL;
 
+	tbl = (odph_hash_table_imp *)(void *)table;
+	hash = odp_key_hash(tbl, key);
+
+	odp_spinlock_lock(&tbl->lock);
+	hash_remove(tbl, hash, key);
+	odp_spinlock_unlock(&tbl->lock);
+
+	return ODPH_SUCCESS;
+}
+
+int odph_hash_remove_value_multi(odph_table_t table, void *key[], int num,
+				 uint64_t *hit_mask)
+{
+	odph_hash_table_imp *tbl;
+	uint32_t hash[ODPH_TABLE_MULTI_MAX];
+	uint64_t hits = 0;
+	int i, num_hit = 0;
+
+	if (table == NULL || key == NULL || num < 0 ||
+	    num > ODPH_TABLE_MULTI_MAX)
+		return ODPH_FAIL;
+
 	tbl = (odph_hash_table_imp *)(void *)table;
 
-	/* hash value is just the index of the list head in pool */
-	hash = odp_key_hash(key, tbl->key_size);
+	for (i = 0; i < num; i++)
+		hash[i] = odp_key_hash(tbl, key[i]);
 
-	odp_rwlock_write_lock(&tbl->lock_pool[hash]);
+	odp_spinlock_lock(&tbl->lock);
 
-	ODPH_LIST_FOR_EACH(node, &tbl->list_head_pool[hash], odph_hash_node,
-			   list_node)
-	{
-		if (memcmp(node->content, key, tbl->key_size) == 0) {
-			hashnode_give(table, node);
-			odp_rwlock_write_unlock(&tbl->lock_pool[hash]);
-			return ODPH_SUCCESS;
+	for (i = 0; i < num; i++) {
+		if (hash_remove(tbl, hash[i], key[i])) {
+			hits |= 1ULL << i;
+			num_hit++;
 		}
 	}
 
-	odp_rwlock_write_unlock(&tbl->lock_pool[hash]);
+	odp_spinlock_unlock(&tbl->lock);
 
-	return ODPH_SUCCESS;
+	if (hit_mask)
+		*hit_mask = hits;
+
+	return num_hit;
 }
 
 odph_table_ops_t odph_hash_table_ops = {
@@ -354,5 +754,7 @@ odph_table_ops_t odph_hash_table_ops = {
 	odph_hash_table_destroy,
 	odph_hash_put_value,
 	odph_hash_get_value,
-	odph_hash_remove_value};
-
+	odph_hash_remove_value,
+	odph_hash_put_value_multi,
+	odph_hash_get_value_multi,
+	odph_hash_remove_value_multi};
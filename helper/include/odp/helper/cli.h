@@ -12,6 +12,30 @@
  * This API allows control of ODP CLI server, which may be connected to
  * using a telnet client. CLI commands may be used to get information
  * from an ODP instance, for debugging purposes.
+ *
+ * Optionally, the CLI server also runs a statistics server, which serves
+ * counters published by application threads (see odph_cli_stats_publish())
+ * to any number of concurrently connected clients. Each line sent by a
+ * client is a request, and each response is a single line of JSON (JSON
+ * lines format). The only request currently supported is "stats", which
+ * returns a snapshot of the counters of all threads and their totals, for
+ * example:
+ *
+ * {"time_ns":1666170000000000000,"threads":[{"thread":1,"updates":42,
+ * "counters":{"rx":100,"tx":99}}],"total":{"rx":100,"tx":99}}
+ *
+ * (without the line break). Unknown requests return an object with an
+ * "error" member. Snapshots are read without locks or ODP API calls, so
+ * statistics may be polled frequently without disturbing the threads
+ * publishing them.
+ *
+ * Only counters published with odph_cli_stats_publish() are read from
+ * snapshots. Other CLI commands, e.g. "pktio_stats_print",
+ * "pktio_queue_stats_print" and the "call" commands, call ODP statistics
+ * and print functions directly from the CLI thread, which may disturb
+ * worker threads. Applications that need to poll packet IO or queue
+ * statistics frequently should read them in worker threads and publish
+ * the values as counters.
  */
 
 #ifndef ODPH_CLI_H_
@@ -29,6 +53,9 @@ extern "C" {
  * @{
  */
 
+/** Maximum number of statistics counters */
+#define ODPH_CLI_STATS_MAX_COUNTERS 32
+
 /**
  * User defined command function type. See odph_cli_register_command().
  *
@@ -53,6 +80,17 @@ typedef struct {
 	uint32_t max_user_commands;
 	/** Hostname to be displayed as the first part of the prompt. */
 	const char *hostname;
+	/**
+	 * TCP port of the statistics server. The statistics server listens
+	 * on the same address as the CLI server. Zero disables the
+	 * statistics server. Default is 0.
+	 */
+	uint16_t stats_port;
+	/**
+	 * Maximum number of concurrently connected statistics clients.
+	 * Default is 16.
+	 */
+	uint32_t stats_max_clients;
 } odph_cli_param_t;
 
 /**
@@ -104,11 +142,50 @@ int odph_cli_init(const odph_cli_param_t *param);
 int odph_cli_register_command(const char *name, odph_cli_user_cmd_func_t func,
 			      const char *help);
 
+/**
+ * Register a statistics counter
+ *
+ * Register a counter name. Counters are published by threads with
+ * odph_cli_stats_publish() in registration order, i.e. the first registered
+ * counter is the first element of the published counter array. Counter names
+ * may contain only alphanumeric characters and the characters '_', '-'
+ * and '.'.
+ *
+ * This function should be called after odph_cli_init() and before
+ * odph_cli_run().
+ *
+ * @param name Counter name
+ * @return Index of the counter in the published counter array
+ * @retval <0 Failure
+ */
+int odph_cli_stats_register(const char *name);
+
+/**
+ * Publish statistics counters of the calling thread
+ *
+ * Update the counter snapshot of the calling thread. The snapshot is
+ * displayed by the "stats" CLI command and returned to statistics server
+ * clients. The values of 'num' first registered counters are copied from
+ * 'counter' array. Only the counters of the calling thread are updated.
+ *
+ * This function does not block or take locks, and may be called frequently
+ * from worker threads, e.g. once per a few hundred packets. It may be called
+ * any time between odph_cli_init() and odph_cli_term(), also while the CLI
+ * server is not running. Each ODP thread has its own snapshot, indexed by
+ * odp_thread_id().
+ *
+ * @param counter Array of counter values
+ * @param num     Number of counter values, at most ODPH_CLI_STATS_MAX_COUNTERS
+ */
+void odph_cli_stats_publish(const uint64_t counter[], uint32_t num);
+
 /**
  * Run CLI server
  *
  * When executing this function, the CLI is accepting client connections and
- * running commands from a client, if one is connected.
+ * running commands from a client, if one is connected. If the statistics
+ * server is enabled (see odph_cli_param_t::stats_port), it is run in a
+ * separate helper internal thread, which does not call ODP API functions.
  *
  * This function should be called after odph_cli_init() and after any
  * odph_cli_register_command() calls. After calling this function,
@@ -124,7 +201,8 @@ int odph_cli_run(void);
 /**
  * Stop CLI server
  *
- * Stop accepting new client connections and disconnect any connected client.
+ * Stop accepting new client connections and disconnect any connected client,
+ * including statistics clients.
  *
  * @retval 0 Success
  * @retval <0 Failure
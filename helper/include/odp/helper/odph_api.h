@@ -24,6 +24,7 @@ extern "C" {
 #include <odp/helper/chksum.h>
 #include <odp/helper/odph_cuckootable.h>
 #include <odp/helper/eth.h>
+#include <odp/helper/odph_flowtable.h>
 #include <odp/helper/gtp.h>
 #include <odp/helper/odph_hashtable.h>
 #include <odp/helper/icmp.h>
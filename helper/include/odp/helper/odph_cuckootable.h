@@ -55,8 +55,15 @@ extern "C" {
 /**
  * @addtogroup odph_cuckootable ODPH CUCKOO TABLE
  * @{
+ *
+ * Lookups (odph_cuckoo_table_get_value(), odph_cuckoo_table_get_value_multi())
+ * do not take locks and may run concurrently with each other and with
+ * a writer. Writes (put and remove) are serialized with a table lock.
  */
 
+/** Maximum number of keys in a single multi key call */
+#define ODPH_CUCKOO_TABLE_MULTI_MAX ODPH_TABLE_MULTI_MAX
+
 /**
  * Create a cuckoo table
  *
@@ -122,6 +129,47 @@ int odph_cuckoo_table_get_value(odph_table_t table,
 				void *key, void *buffer,
 				uint32_t buffer_size);
 
+/**
+ * Retrieve values of multiple keys from a cuckoo table
+ *
+ * Looks up 'num' keys with interleaved hash calculations and memory
+ * prefetches, which is faster than looking up keys one by one. A bit is
+ * set in 'hit_mask' for each key that was found (bit 0 for key[0],
+ * etc.) and the value of the key is copied into the corresponding buffer.
+ *
+ * @param table       Table from which values are to be retrieved
+ * @param key         Array of key addresses
+ * @param[out] buffer Array of buffer addresses to receive resulting values.
+ *                    May be NULL when value size is zero.
+ * @param buffer_size Size of each supplied buffer
+ * @param num         Number of keys, max ODPH_CUCKOO_TABLE_MULTI_MAX
+ * @param[out] hit_mask Bit mask of found keys. Ignored when NULL.
+ *
+ * @return Number of keys found
+ * @retval < 0 Failure
+ */
+int odph_cuckoo_table_get_value_multi(odph_table_t table, void *key[],
+				      void *buffer[], uint32_t buffer_size,
+				      int num, uint64_t *hit_mask);
+
+/**
+ * Insert multiple key/value pairs into a cuckoo table
+ *
+ * Hashes of all keys are calculated before taking the table lock, and
+ * pairs are inserted in order while holding the lock once.
+ *
+ * @param table Table into which values are to be stored
+ * @param key   Array of key addresses
+ * @param value Array of value addresses. May be NULL when value size is
+ *              zero.
+ * @param num   Number of pairs, max ODPH_CUCKOO_TABLE_MULTI_MAX
+ *
+ * @return Number of pairs inserted
+ * @retval < 0 Failure
+ */
+int odph_cuckoo_table_put_value_multi(odph_table_t table, void *key[],
+				      void *value[], int num);
+
 /**
  * Remove a value from a cuckoo table
  *
@@ -133,6 +181,20 @@ int odph_cuckoo_table_get_value(odph_table_t table,
  */
 int odph_cuckoo_table_remove_value(odph_table_t table, void *key);
 
+/**
+ * Remove multiple keys from a cuckoo table
+ *
+ * @param table Table from which keys are to be removed
+ * @param key   Array of key addresses
+ * @param num   Number of keys, max ODPH_CUCKOO_TABLE_MULTI_MAX
+ * @param[out] hit_mask Bit mask of removed keys. Ignored when NULL.
+ *
+ * @return Number of keys removed
+ * @retval < 0 Failure
+ */
+int odph_cuckoo_table_remove_value_multi(odph_table_t table, void *key[],
+					 int num, uint64_t *hit_mask);
+
 extern odph_table_ops_t odph_cuckoo_table_ops; /**< @internal */
 
 /**
@@ -0,0 +1,295 @@
+/* Copyright (c) 2022, Nokia
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier:    BSD-3-Clause
+ */
+
+/**
+ * @file
+ *
+ * ODP Flow Table
+ *
+ * Flow table keeps per flow state of stateful applications. Flows are
+ * identified with IPv4 5-tuples. Each flow has a fixed size user data area,
+ * which is returned to the application when a flow is looked up.
+ *
+ * A table is divided into shards. In sharded mode
+ * (ODPH_FLOW_TABLE_SHARDED), each shard is owned by a single thread and no
+ * locks are taken. This suits applications where packets of a flow are
+ * always processed by the same thread, e.g. when each thread receives
+ * packets from its own RSS hashed packet input queue and uses the queue
+ * index as the shard index. In shared mode (ODPH_FLOW_TABLE_SHARED), there
+ * is a single shard, which all threads access. Lookups do not take locks,
+ * while inserts, removes and aging are serialized with a lock.
+ *
+ * Flows that have been idle longer than the idle timeout are removed with
+ * odph_flow_table_age(), which calls an optional eviction callback for each
+ * removed flow.
+ */
+
+#ifndef ODPH_FLOW_TABLE_H_
+#define ODPH_FLOW_TABLE_H_
+
+#include <odp/helper/strong_types.h>
+#include <odp/helper/table.h>
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @addtogroup odph_flowtable ODPH FLOW TABLE
+ * @{
+ */
+
+/** @internal Flow table handle */
+typedef ODPH_HANDLE_T(odph_flow_table_t);
+
+/** Invalid flow table handle */
+#define ODPH_FLOW_TABLE_INVALID ((odph_flow_table_t)NULL)
+
+/** Maximum number of keys in a single multi key call */
+#define ODPH_FLOW_TABLE_MULTI_MAX ODPH_TABLE_MULTI_MAX
+
+/**
+ * Flow key (IPv4 5-tuple)
+ *
+ * Unused pad bytes must be zero.
+ */
+typedef struct odph_flow_key_t {
+	uint32_t src_ip;   /**< Source IPv4 address */
+	uint32_t dst_ip;   /**< Destination IPv4 address */
+	uint16_t src_port; /**< Source port */
+	uint16_t dst_port; /**< Destination port */
+	uint8_t  proto;    /**< IP protocol */
+	uint8_t  pad[3];   /**< Padding, must be zero */
+} odph_flow_key_t;
+
+/** Flow table mode */
+typedef enum odph_flow_table_mode_t {
+	/** Single shard, which all threads may access */
+	ODPH_FLOW_TABLE_SHARED = 0,
+
+	/** Multiple shards, each accessed by a single thread at a time */
+	ODPH_FLOW_TABLE_SHARDED
+
+} odph_flow_table_mode_t;
+
+/**
+ * Flow eviction callback
+ *
+ * Called by odph_flow_table_age() for each flow that is removed due to
+ * idle timeout. Flow data may be accessed only during the call.
+ *
+ * @param key   Flow key
+ * @param data  Flow data
+ * @param arg   User argument from table parameters
+ */
+typedef void (*odph_flow_evict_fn_t)(const odph_flow_key_t *key, void *data,
+				     void *arg);
+
+/** Flow table parameters */
+typedef struct odph_flow_table_param_t {
+	/** Table mode. The default value is ODPH_FLOW_TABLE_SHARED. */
+	odph_flow_table_mode_t mode;
+
+	/** Number of shards in sharded mode. Ignored in shared mode.
+	 *  The default value is 1. */
+	uint32_t num_shards;
+
+	/** Maximum number of flows in the table. Flows are divided evenly
+	 *  between shards. The default value is 65536. */
+	uint32_t max_flows;
+
+	/** Size of flow data in bytes. The default value is 0. */
+	uint32_t data_size;
+
+	/** Idle timeout in nanoseconds. Flows that have not been looked up
+	 *  for this long are removed by odph_flow_table_age(). Zero disables
+	 *  aging. The default value is 0. */
+	uint64_t idle_timeout_ns;
+
+	/** Eviction callback, or NULL. The default value is NULL. */
+	odph_flow_evict_fn_t evict_fn;
+
+	/** User argument of the eviction callback */
+	void *evict_arg;
+
+} odph_flow_table_param_t;
+
+/**
+ * Initialize flow table parameters to default values
+ *
+ * @param[out] param  Parameters to be initialized
+ */
+void odph_flow_table_param_init(odph_flow_table_param_t *param);
+
+/**
+ * Create a flow table
+ *
+ * @param name   Name of the table, max ODPH_TABLE_NAME_LEN - 1 characters
+ * @param param  Table parameters
+ *
+ * @return Flow table handle
+ * @retval ODPH_FLOW_TABLE_INVALID on failure
+ */
+odph_flow_table_t odph_flow_table_create(const char *name,
+					 const odph_flow_table_param_t *param);
+
+/**
+ * Find a flow table by name
+ *
+ * @param name  Name of the table
+ *
+ * @return Flow table handle
+ * @retval ODPH_FLOW_TABLE_INVALID when not found
+ */
+odph_flow_table_t odph_flow_table_lookup(const char *name);
+
+/**
+ * Destroy a flow table
+ *
+ * Eviction callback is not called for flows that remain in the table.
+ *
+ * @param table  Flow table
+ *
+ * @retval 0 on success
+ * @retval <0 on failure
+ */
+int odph_flow_table_destroy(odph_flow_table_t table);
+
+/**
+ * Calculate flow hash
+ *
+ * This is the hash that the table uses when the application does not
+ * provide one.
+ *
+ * @param key  Flow key
+ *
+ * @return Hash value
+ */
+uint32_t odph_flow_hash(const odph_flow_key_t *key);
+
+/**
+ * Look up flows and insert the missing ones
+ *
+ * Looks up 'num' flows from a shard. Flows that are not found are inserted.
+ * Memory accesses are prefetched for all flows before any of them is read.
+ * A pointer to the flow data is written into 'data' for each flow. Data of
+ * new flows is zeroed; a bit is set in 'new_mask' for each new flow (bit 0
+ * for key[0], etc.), so that the application may initialize it. When the
+ * shard is full, NULL is written into 'data' for flows that could not be
+ * inserted.
+ *
+ * In shared mode, other threads may find a new flow before the inserting
+ * thread has initialized its data. Those threads may see the data zeroed,
+ * partially initialized or initialized. The application should publish
+ * initialized data with an atomic store (e.g. a release store of a state
+ * field that is zero until the data is valid), and readers should check it
+ * with an atomic load before using the rest of the data.
+ *
+ * When aging is enabled, the idle time of all found and inserted flows is
+ * reset.
+ *
+ * Flow data pointer is valid until the flow is removed. In shared mode,
+ * memory of a removed flow is reused only after a grace period (10 ms), so
+ * that concurrent lookups do not see it reused. Removed entries are reused
+ * in removal order. Inserts fail when all free entries have been removed
+ * within the grace period, even if the shard is not full. Applications that
+ * remove and insert flows at a high rate should reserve 'max_flows' with
+ * room for the flows removed during one grace period.
+ *
+ * @param table     Flow table
+ * @param shard     Shard index. Ignored in shared mode.
+ * @param key       Array of flow keys
+ * @param hash      Array of flow hashes, or NULL when the table should
+ *                  calculate hashes with odph_flow_hash(). Application may
+ *                  use any hash function, but it must use the same one
+ *                  for all calls on the table. The hash may be the same
+ *                  one that selected the shard, e.g. the packet RSS hash.
+ * @param[out] data Array for flow data pointers
+ * @param num       Number of flows, max ODPH_FLOW_TABLE_MULTI_MAX
+ * @param[out] new_mask Bit mask of inserted flows. Ignored when NULL.
+ *
+ * @return Number of flows found or inserted
+ * @retval <0 on failure
+ */
+int odph_flow_table_lookup_insert_multi(odph_flow_table_t table,
+					uint32_t shard,
+					const odph_flow_key_t key[],
+					const uint32_t hash[], void *data[],
+					int num, uint64_t *new_mask);
+
+/**
+ * Find a flow
+ *
+ * Does not insert the flow when it is not found, and does not reset the
+ * idle time of the flow.
+ *
+ * @param table  Flow table
+ * @param shard  Shard index. Ignored in shared mode.
+ * @param key    Flow key
+ * @param hash   Pointer to flow hash, or NULL when calculated by the table
+ *
+ * @return Pointer to flow data
+ * @retval NULL when flow was not found
+ */
+void *odph_flow_table_find(odph_flow_table_t table, uint32_t shard,
+			   const odph_flow_key_t *key, const uint32_t *hash);
+
+/**
+ * Remove a flow
+ *
+ * Eviction callback is not called.
+ *
+ * @param table  Flow table
+ * @param shard  Shard index. Ignored in shared mode.
+ * @param key    Flow key
+ * @param hash   Pointer to flow hash, or NULL when calculated by the table
+ *
+ * @retval 0 on success
+ * @retval <0 when flow was not found
+ */
+int odph_flow_table_remove(odph_flow_table_t table, uint32_t shard,
+			   const odph_flow_key_t *key, const uint32_t *hash);
+
+/**
+ * Remove idle flows
+ *
+ * Scans up to 'max_scan' flow entries of a shard and removes the flows that
+ * have been idle longer than the idle timeout. Scan continues from where
+ * the previous call stopped, so that aging work can be spread over
+ * multiple calls (e.g. a few entries per receive burst). Eviction callback
+ * is called for each removed flow.
+ *
+ * @param table     Flow table
+ * @param shard     Shard index. Ignored in shared mode.
+ * @param max_scan  Maximum number of entries to scan
+ *
+ * @return Number of removed flows
+ * @retval <0 on failure
+ */
+int odph_flow_table_age(odph_flow_table_t table, uint32_t shard,
+			uint32_t max_scan);
+
+/**
+ * Number of flows in a shard
+ *
+ * @param table  Flow table
+ * @param shard  Shard index. Ignored in shared mode.
+ *
+ * @return Number of flows
+ */
+uint32_t odph_flow_table_count(odph_flow_table_t table, uint32_t shard);
+
+/**
+ * @}
+ */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
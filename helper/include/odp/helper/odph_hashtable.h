@@ -22,13 +22,20 @@ extern "C" {
 /**
  * @addtogroup odph_hash_table ODPH HASH TABLE
  * @{
+ *
+ * Hash table uses open addressing with CRC32C hash. All table memory is
+ * reserved on creation, so that the table can be shared by processes that
+ * are forked before or after the creation. The table starts small and grows
+ * on demand within that memory. Lookups do
+ * not take locks and may run concurrently with each other and with
+ * a writer. Writes (put and remove) are serialized with a table lock.
  */
 
 /**
  * Create a hash table
  *
  * @param name       Name of the hash table to be created.
- * @param capacity   Number of elements table may store
+ * @param capacity   Memory reserved for the table in MBytes
  * @param key_size   Size of the key for each element
  * @param value_size Size of the value stored for each element
  *
@@ -98,6 +105,56 @@ int odph_hash_get_value(odph_table_t table, void *key, void *buffer,
  */
 int odph_hash_remove_value(odph_table_t table, void *key);
 
+/**
+ * Insert multiple key/value pairs into a hash table
+ *
+ * Pairs are inserted in order while holding the table lock once.
+ *
+ * @param table Table into which values are to be stored
+ * @param key   Array of key addresses
+ * @param value Array of value addresses
+ * @param num   Number of pairs, max ODPH_TABLE_MULTI_MAX
+ *
+ * @return Number of pairs inserted
+ * @retval < 0 Failure
+ */
+int odph_hash_put_value_multi(odph_table_t table, void *key[],
+			      void *value[], int num);
+
+/**
+ * Retrieve values of multiple keys from a hash table
+ *
+ * Hashes of all keys are calculated and index slots and nodes prefetched
+ * before any key is compared.
+ *
+ * @param table       Table from which values are to be retrieved
+ * @param key         Array of key addresses
+ * @param[out] buffer Array of buffer addresses to receive resulting values
+ * @param buffer_size Size of each supplied buffer
+ * @param num         Number of keys, max ODPH_TABLE_MULTI_MAX
+ * @param[out] hit_mask Bit mask of found keys. Ignored when NULL.
+ *
+ * @return Number of keys found
+ * @retval < 0 Failure
+ */
+int odph_hash_get_value_multi(odph_table_t table, void *key[],
+			      void *buffer[], uint32_t buffer_size,
+			      int num, uint64_t *hit_mask);
+
+/**
+ * Remove values of multiple keys from a hash table
+ *
+ * @param table Table from which values are to be removed
+ * @param key   Array of key addresses
+ * @param num   Number of keys, max ODPH_TABLE_MULTI_MAX
+ * @param[out] hit_mask Bit mask of removed keys. Ignored when NULL.
+ *
+ * @return Number of keys removed
+ * @retval < 0 Failure
+ */
+int odph_hash_remove_value_multi(odph_table_t table, void *key[], int num,
+				 uint64_t *hit_mask);
+
 extern odph_table_ops_t odph_hash_table_ops; /**< @internal */
 
 /**
@@ -9,10 +9,15 @@
  *
  * ODP IP Lookup Table
  *
- * This is an implementation of the IP lookup table. The key of
- * this table is IPv4 address (32 bits), and the value can be
- * defined by user. This table uses the 16,8,8 ip lookup (longest
- * prefix matching) algorithm.
+ * This is an implementation of the IP lookup (longest prefix matching)
+ * tables. The key of a table is an IPv4 address (32 bits) or an IPv6
+ * address (128 bits). IPv4 tables use the DIR-24-8 algorithm: a 24 bit
+ * direct indexed first level and 8 bit groups of entries for longer
+ * prefixes. IPv6 tables use a multibit trie with a 16 bit first level and
+ * 8 bit strides after that.
+ *
+ * Table values are odp_buffer_t sized handles (e.g. pointers), which are
+ * stored into the table by value.
  */
 
 #ifndef ODPH_IPLOOKUP_TABLE_H_
@@ -27,8 +32,17 @@ extern "C" {
 /**
  * @addtogroup odph_iplookuptable ODPH IP LOOKUP TABLE
  * @{
+ *
+ * Lookups (get_value and get_value_multi) do not take locks and may run
+ * concurrently with each other and with a writer. Writes (put and remove)
+ * are serialized with a table lock. Table memory released by a write is
+ * reused only after a grace period, so that lookups in progress do not
+ * see it modified.
  */
 
+/** Maximum number of keys in a single multi key call */
+#define ODPH_IPLOOKUP_TABLE_MULTI_MAX ODPH_TABLE_MULTI_MAX
+
 /**
  * IP Lookup Prefix
  */
@@ -37,20 +51,32 @@ typedef struct {
 	uint8_t cidr; /**< CIDR value for prefix matching */
 } odph_iplookup_prefix_t;
 
+/**
+ * IPv6 Lookup Prefix
+ */
+typedef struct {
+	uint8_t ip[16]; /**< IPv6 address in network byte order */
+	uint8_t cidr;   /**< CIDR value for prefix matching */
+} odph_iplookup6_prefix_t;
+
 /**
  * Create an IP lookup table
  *
- * @param name Name of the table to be created
- * @param ODP_IGNORED_1 Unused
- * @param ODP_IGNORED_2 Unused
- * @param value_size Byte size of each entry in the table
+ * @param name       Name of the table to be created
+ * @param max_routes Maximum number of prefixes in the table.
+ *                   Zero selects the default (64k).
+ * @param max_groups Maximum number of 256 entry groups used for prefixes
+ *                   longer than 24 bits. Each group takes 1 kB of memory.
+ *                   Zero selects the default (4k).
+ * @param value_size Byte size of each entry in the table. Values are stored
+ *                   as odp_buffer_t sized handles.
  *
  * @return Handle of the created ip lookup table
  * @retval NULL If table create failed
  */
 odph_table_t odph_iplookup_table_create(const char *name,
-					uint32_t ODP_IGNORED_1,
-					uint32_t ODP_IGNORED_2,
+					uint32_t max_routes,
+					uint32_t max_groups,
 					uint32_t value_size);
 
 /**
@@ -85,11 +111,31 @@ int odph_iplookup_table_destroy(odph_table_t table);
  */
 int odph_iplookup_table_put_value(odph_table_t table, void *key, void *value);
 
+/**
+ * Insert multiple key/value pairs into an iplookup table
+ *
+ * Pairs are inserted in order while holding the table lock once.
+ * Insertion stops at the first invalid or failed prefix.
+ *
+ * @param table Table into which values are to be stored
+ * @param key   Array of odph_iplookup_prefix_t addresses
+ * @param value Array of value addresses
+ * @param num   Number of pairs, max ODPH_IPLOOKUP_TABLE_MULTI_MAX
+ *
+ * @return Number of pairs inserted
+ * @retval < 0 Failure
+ */
+int odph_iplookup_table_put_value_multi(odph_table_t table, void *key[],
+					void *value[], int num);
+
 /**
  * Retrieve a value from an iplookup table
  *
+ * When no prefix matches the address, ODP_BUFFER_INVALID is written into
+ * the buffer.
+ *
  * @param table Table from which value is to be retrieved
- * @param key   Address of an odph_iplookup_prefix_t to be used as key
+ * @param key   Address of an IPv4 address (uint32_t) to be looked up
  * @param[out] buffer Address of buffer to receive resulting value
  * @param buffer_size Size of supplied buffer
  *
@@ -100,6 +146,30 @@ int odph_iplookup_table_put_value(odph_table_t table, void *key, void *value);
 int odph_iplookup_table_get_value(odph_table_t table, void *key,
 				  void *buffer, uint32_t buffer_size);
 
+/**
+ * Retrieve values of multiple addresses from an iplookup table
+ *
+ * Looks up 'num' addresses in stages, prefetching the entries of the next
+ * stage for all addresses before reading any of them. This hides memory
+ * latency and is faster than looking up addresses one by one. A bit is set
+ * in 'hit_mask' for each address that matched a prefix (bit 0 for key[0],
+ * etc.). For addresses that did not match, ODP_BUFFER_INVALID is written
+ * into the buffer.
+ *
+ * @param table       Table from which values are to be retrieved
+ * @param key         Array of IPv4 address (uint32_t) addresses
+ * @param[out] buffer Array of buffer addresses to receive resulting values
+ * @param buffer_size Size of each supplied buffer
+ * @param num         Number of addresses, max ODPH_IPLOOKUP_TABLE_MULTI_MAX
+ * @param[out] hit_mask Bit mask of matched addresses. Ignored when NULL.
+ *
+ * @return Number of addresses that matched a prefix
+ * @retval < 0 Failure
+ */
+int odph_iplookup_table_get_value_multi(odph_table_t table, void *key[],
+					void *buffer[], uint32_t buffer_size,
+					int num, uint64_t *hit_mask);
+
 /**
  * Remove a value from an iplookup table
  *
@@ -112,8 +182,154 @@ int odph_iplookup_table_get_value(odph_table_t table, void *key,
  */
 int odph_iplookup_table_remove_value(odph_table_t table, void *key);
 
+/**
+ * Remove multiple key/value pairs from an iplookup table
+ *
+ * @param table Table from which values are to be removed
+ * @param key   Array of odph_iplookup_prefix_t addresses
+ * @param num   Number of keys, max ODPH_IPLOOKUP_TABLE_MULTI_MAX
+ * @param[out] hit_mask Bit mask of removed keys. Ignored when NULL.
+ *
+ * @return Number of keys removed
+ * @retval < 0 Failure
+ */
+int odph_iplookup_table_remove_value_multi(odph_table_t table, void *key[],
+					   int num, uint64_t *hit_mask);
+
 extern odph_table_ops_t odph_iplookup_table_ops; /**< @internal */
 
+/**
+ * Create an IPv6 lookup table
+ *
+ * @param name       Name of the table to be created
+ * @param max_routes Maximum number of prefixes in the table.
+ *                   Zero selects the default (64k).
+ * @param max_groups Maximum number of 256 entry groups used for prefixes
+ *                   longer than 16 bits. Each group takes 1 kB of memory.
+ *                   Zero selects the default (16k).
+ * @param value_size Byte size of each entry in the table. Values are stored
+ *                   as odp_buffer_t sized handles.
+ *
+ * @return Handle of the created ip lookup table
+ * @retval NULL If table create failed
+ */
+odph_table_t odph_iplookup6_table_create(const char *name,
+					 uint32_t max_routes,
+					 uint32_t max_groups,
+					 uint32_t value_size);
+
+/**
+ * Lookup an IPv6 lookup table by name
+ *
+ * @param name Name of the table to be located
+ *
+ * @return Handle of the located ip lookup table
+ * @retval NULL No table matching supplied name found
+ */
+odph_table_t odph_iplookup6_table_lookup(const char *name);
+
+/**
+ * Destroy an IPv6 lookup table
+ *
+ * @param table Handle of the ip lookup table to be destroyed
+ *
+ * @retval 0 Success
+ * @retval < 0 Failure
+ */
+int odph_iplookup6_table_destroy(odph_table_t table);
+
+/**
+ * Insert a key/value pair into an IPv6 lookup table
+ *
+ * @param table Table into which value is to be stored
+ * @param key   Address of an odph_iplookup6_prefix_t to be used as key
+ * @param value Value to be associated with specified key
+ *
+ * @retval >= 0 Success
+ * @retval < 0  Failure
+ */
+int odph_iplookup6_table_put_value(odph_table_t table, void *key, void *value);
+
+/**
+ * Insert multiple key/value pairs into an IPv6 lookup table
+ *
+ * Pairs are inserted in order while holding the table lock once.
+ * Insertion stops at the first invalid or failed prefix.
+ *
+ * @param table Table into which values are to be stored
+ * @param key   Array of odph_iplookup6_prefix_t addresses
+ * @param value Array of value addresses
+ * @param num   Number of pairs, max ODPH_IPLOOKUP_TABLE_MULTI_MAX
+ *
+ * @return Number of pairs inserted
+ * @retval < 0 Failure
+ */
+int odph_iplookup6_table_put_value_multi(odph_table_t table, void *key[],
+					 void *value[], int num);
+
+/**
+ * Retrieve a value from an IPv6 lookup table
+ *
+ * When no prefix matches the address, ODP_BUFFER_INVALID is written into
+ * the buffer.
+ *
+ * @param table Table from which value is to be retrieved
+ * @param key   Address of a 16 byte IPv6 address in network byte order
+ * @param[out] buffer Address of buffer to receive resulting value
+ * @param buffer_size Size of supplied buffer
+ *
+ * @retval 0 Success
+ * @retval < 0 Failure
+ */
+int odph_iplookup6_table_get_value(odph_table_t table, void *key,
+				   void *buffer, uint32_t buffer_size);
+
+/**
+ * Retrieve values of multiple addresses from an IPv6 lookup table
+ *
+ * Same as odph_iplookup_table_get_value_multi(), but for IPv6 addresses.
+ *
+ * @param table       Table from which values are to be retrieved
+ * @param key         Array of 16 byte IPv6 address addresses
+ * @param[out] buffer Array of buffer addresses to receive resulting values
+ * @param buffer_size Size of each supplied buffer
+ * @param num         Number of addresses, max ODPH_IPLOOKUP_TABLE_MULTI_MAX
+ * @param[out] hit_mask Bit mask of matched addresses. Ignored when NULL.
+ *
+ * @return Number of addresses that matched a prefix
+ * @retval < 0 Failure
+ */
+int odph_iplookup6_table_get_value_multi(odph_table_t table, void *key[],
+					 void *buffer[], uint32_t buffer_size,
+					 int num, uint64_t *hit_mask);
+
+/**
+ * Remove a value from an IPv6 lookup table
+ *
+ * @param table Table from which value is to be removed
+ * @param key   Address of odph_iplookup6_prefix_t to be used as key
+ *
+ * @retval >= 0 Success
+ * @retval < 0  Failure
+ */
+int odph_iplookup6_table_remove_value(odph_table_t table, void *key);
+
+/**
+ * Remove multiple key/value pairs from an IPv6 lookup table
+ *
+ * @param table Table from which values are to be removed
+ * @param key   Array of odph_iplookup6_prefix_t addresses
+ * @param num   Number of keys, max ODPH_IPLOOKUP_TABLE_MULTI_MAX
+ * @param[out] hit_mask Bit mask of removed keys. Ignored when NULL.
+ *
+ * @return Number of keys removed
+ * @retval < 0 Failure
+ */
+int odph_iplookup6_table_remove_value_multi(odph_table_t table, void *key[],
+					    int num, uint64_t *hit_mask);
+
+extern odph_table_ops_t odph_iplookup6_table_ops; /**< @internal */
+
 /**
  * @}
  */
@@ -88,6 +88,39 @@ int odph_linear_put_value(odph_table_t table, void *key, void *value);
 int odph_linear_get_value(odph_table_t table, void *key, void *buffer,
 			  uint32_t buffer_size);
 
+/**
+ * Insert multiple values into a linear table
+ *
+ * @param table Table into which values are to be stored
+ * @param key   Array of index value addresses used as keys
+ * @param value Array of value addresses
+ * @param num   Number of values, max ODPH_TABLE_MULTI_MAX
+ *
+ * @return Number of values inserted
+ * @retval < 0 Failure
+ */
+int odph_linear_put_value_multi(odph_table_t table, void *key[],
+				void *value[], int num);
+
+/**
+ * Retrieve multiple values from a linear table
+ *
+ * All entries are prefetched before any of them is read.
+ *
+ * @param table       Table from which values are to be retrieved
+ * @param key         Array of index value addresses used as keys
+ * @param[out] buffer Array of buffer addresses to receive resulting values
+ * @param buffer_size Size of each supplied buffer
+ * @param num         Number of keys, max ODPH_TABLE_MULTI_MAX
+ * @param[out] hit_mask Bit mask of valid keys. Ignored when NULL.
+ *
+ * @return Number of values retrieved
+ * @retval < 0 Failure
+ */
+int odph_linear_get_value_multi(odph_table_t table, void *key[],
+				void *buffer[], uint32_t buffer_size,
+				int num, uint64_t *hit_mask);
+
 extern odph_table_ops_t odph_linear_table_ops; /**< @internal */
 
 /**
@@ -93,6 +93,12 @@ extern "C" {
  */
 #define ODPH_TABLE_NAME_LEN      32
 
+/**
+ * @def ODPH_TABLE_MULTI_MAX
+ * Max number of keys in a single multi key operation
+ */
+#define ODPH_TABLE_MULTI_MAX     64
+
 #include <odp/helper/strong_types.h>
 /** @internal ODPH table handle @return */
 typedef ODPH_HANDLE_T(odph_table_t);
@@ -218,6 +224,55 @@ typedef int (*odph_table_get_value)(odph_table_t table, void *key,
  */
 typedef int (*odph_table_remove_value)(odph_table_t table, void *key);
 
+/**
+ * Add multiple (key,associated data) pairs into the specific table.
+ * Pairs are added in order, as with odph_table_put_value(). Writer
+ * synchronization is done once per call, instead of once per pair.
+ * @param table  Handle of the table that the elements be added
+ * @param key    array of 'key' addresses
+ * @param value  array of 'value' addresses
+ * @param num    number of pairs, max ODPH_TABLE_MULTI_MAX
+ * @return Number of pairs added (0 ... num). Less than 'num' when adding
+ *         a pair failed. Following pairs were not added.
+ * @retval <0 Failure, no pairs were added
+ */
+typedef int (*odph_table_put_value_multi)(odph_table_t table, void *key[],
+					  void *value[], int num);
+
+/**
+ * Lookup the associated data of multiple keys.
+ * Lookups of all keys are interleaved: memory accesses of a lookup stage
+ * are prefetched for all keys before any of them is read. This hides
+ * memory latency, and is faster than looking up keys one by one.
+ * @param table  Handle of the table
+ * @param key    array of 'key' addresses
+ * @param buffer output array of buffer addresses. Value of a found key
+ *               is copied to the buffer of the same index.
+ * @param buffer_size  size of each buffer
+ * @param num    number of keys, max ODPH_TABLE_MULTI_MAX
+ * @param hit_mask output bit mask of found keys: bit 0 for key[0], etc.
+ *                 Ignored when NULL.
+ * @return Number of found keys
+ * @retval <0 Failure
+ */
+typedef int (*odph_table_get_value_multi)(odph_table_t table, void *key[],
+					  void *buffer[],
+					  uint32_t buffer_size,
+					  int num, uint64_t *hit_mask);
+
+/**
+ * Delete the associations specified by multiple keys.
+ * @param table  Handle of the table
+ * @param key    array of 'key' addresses
+ * @param num    number of keys, max ODPH_TABLE_MULTI_MAX
+ * @param hit_mask output bit mask of keys that were found and deleted:
+ *                 bit 0 for key[0], etc. Ignored when NULL.
+ * @return Number of deleted keys
+ * @retval <0 Failure
+ */
+typedef int (*odph_table_remove_value_multi)(odph_table_t table, void *key[],
+					     int num, uint64_t *hit_mask);
+
 /**
  * Table interface set. Defining the table operations.
  */
@@ -231,6 +286,12 @@ typedef struct odph_table_ops_t {
 	odph_table_get_value     f_get;
 	/** delete the association specified by key */
 	odph_table_remove_value  f_remove;
+	/** add multiple (key,associated data) pairs */
+	odph_table_put_value_multi    f_put_multi;
+	/** lookup the associated data of multiple keys */
+	odph_table_get_value_multi    f_get_multi;
+	/** delete the associations specified by multiple keys */
+	odph_table_remove_value_multi f_remove_multi;
 } odph_table_ops_t;
 
 /**
@@ -78,6 +78,19 @@ typedef struct {
 	 */
 	uint64_t stack_size;
 
+	/**
+	 * Real-time scheduling priority
+	 *
+	 * When non-zero, the thread switches to SCHED_FIFO scheduling policy
+	 * with this priority after ODP local initialization. If real-time
+	 * scheduling is not permitted (e.g. missing CAP_SYS_NICE), the thread
+	 * continues with the default policy. A busy polling thread with
+	 * real-time priority starves other tasks on its CPU, so it should be
+	 * used only on isolated CPUs (see odph_cpumask_default_worker_isolated()).
+	 * Ignored by odph_odpthreads_create(). Default value is 0.
+	 */
+	int rt_prio;
+
 } odph_thread_param_t;
 
 /** Helper internal thread start arguments. Used both in process and thread
@@ -125,6 +138,22 @@ typedef struct {
 
 } odph_thread_t;
 
+/** Poll loop statistics of a thread. See odph_thread_poll_update(). */
+typedef struct {
+	/** CPU cycles spent in loop iterations which processed work */
+	uint64_t busy_cycles;
+
+	/** CPU cycles spent in loop iterations which found no work */
+	uint64_t idle_cycles;
+
+	/** Number of polls which returned work */
+	uint64_t busy_polls;
+
+	/** Number of polls which returned no work */
+	uint64_t idle_polls;
+
+} odph_thread_poll_stats_t;
+
 /** Linux helper options */
 typedef struct {
 	odp_mem_model_t mem_model; /**< Process or thread */
@@ -337,6 +366,96 @@ int odph_odpthread_setaffinity(const int cpu);
  */
 int odph_odpthread_getaffinity(void);
 
+/**
+ * Get isolated CPUs
+ *
+ * Reads the CPUs isolated from the kernel scheduler (isolcpus) and the CPUs
+ * running in adaptive-tick mode (nohz_full) from sysfs, and outputs their
+ * union. Only CPUs available to the ODP instance (see
+ * odp_cpumask_all_available()) are included. Note that isolcpus CPUs are not
+ * in the default CPU affinity of a process, so those are available only when
+ * the application has been started with an affinity including them (e.g. with
+ * taskset).
+ *
+ * @param[out] mask     CPU mask for output
+ *
+ * @return Number of CPUs in the mask
+ */
+int odph_cpumask_isolated(odp_cpumask_t *mask);
+
+/**
+ * Default CPU mask for worker threads, preferring isolated CPUs
+ *
+ * Like odp_cpumask_default_worker(), but isolated CPUs (see
+ * odph_cpumask_isolated()) of the default worker CPU set are selected first.
+ * If there are fewer than 'num' isolated worker CPUs, the rest are selected
+ * from other worker CPUs. CPUs are allocated down from the highest numbered
+ * CPU.
+ *
+ * @param[out] mask     CPU mask for output
+ * @param      num      Number of CPUs to select. 0 selects all worker CPUs.
+ *
+ * @return Number of CPUs in the mask
+ */
+int odph_cpumask_default_worker_isolated(odp_cpumask_t *mask, int num);
+
+/**
+ * Initialize poll loop statistics
+ *
+ * Reserves memory for poll loop statistics of all ODP threads. Call once, in
+ * process mode before creating the threads which update the statistics.
+ *
+ * @retval 0 on success
+ * @retval <0 on failure
+ *
+ * @see odph_thread_poll_update()
+ */
+int odph_thread_poll_stats_init(void);
+
+/**
+ * Terminate poll loop statistics
+ *
+ * Frees memory reserved by odph_thread_poll_stats_init(). Threads must not
+ * call odph_thread_poll_update() after this.
+ *
+ * @retval 0 on success
+ * @retval <0 on failure
+ */
+int odph_thread_poll_stats_term(void);
+
+/**
+ * Update poll loop statistics of the calling thread
+ *
+ * A poll mode thread calls this once per loop iteration, right after polling
+ * for work (e.g. odp_schedule_multi() or odp_pktin_recv()), with the number of
+ * events or packets the poll returned. CPU cycles (odp_cpu_cycles()) spent
+ * since the previous call are accounted as busy, when the previous poll
+ * returned work (and the cycles were spent processing it), and otherwise as
+ * idle. The ratio of busy cycles to all cycles is the utilization of the
+ * thread, which may be used to size the number of worker CPUs.
+ *
+ * Does nothing if poll loop statistics have not been initialized.
+ *
+ * @param num   Number of events or packets returned by the poll
+ *
+ * @see odph_thread_poll_stats()
+ */
+void odph_thread_poll_update(int num);
+
+/**
+ * Read poll loop statistics of a thread
+ *
+ * Counters are updated by the thread without synchronization, so different
+ * counters may be from slightly different points in time.
+ *
+ * @param      thr      ODP thread ID (see odp_thread_id())
+ * @param[out] stats    Statistics for output
+ *
+ * @retval 0 on success
+ * @retval <0 on failure
+ */
+int odph_thread_poll_stats(int thr, odph_thread_poll_stats_t *stats);
+
 /**
  * Parse linux helper options
  *
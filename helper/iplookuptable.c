@@ -10,441 +10,531 @@
 #include <stdio.h>
 
 #include <odp/helper/odph_iplookuptable.h>
+#include <odp/helper/odph_hashtable.h>
 #include <odp/helper/odph_debug.h>
-#include "odph_list_internal.h"
 #include <odp_api.h>
 
 /** @magic word, write to the first byte of the memory block
  *   to indicate this block is used by a ip lookup table
  */
-#define ODPH_IP_LOOKUP_TABLE_MAGIC_WORD 0xCFCFFCFC
-
-/* The length(bit) of the IPv4 address */
-#define IP_LENGTH 32
-
-/* The number of L1 entries */
-#define ENTRY_NUM_L1		(1 << 16)
-/* The size of one L2\L3 subtree */
-#define ENTRY_NUM_SUBTREE	(1 << 8)
-
-#define WHICH_CHILD(ip, cidr) ((ip >> (IP_LENGTH - cidr)) & 0x00000001)
-
-/** @internal entry struct
- *   Structure store an entry of the ip prefix table.
- *   Because of the leaf pushing, each entry of the table must have
- *   either a child entry, or a nexthop info.
- *   If child == 0 and index != ODP_BUFFER_INVALID, this entry has
- *		a nexthop info, index indicates the buffer that stores the
- *		nexthop value, and ptr points to the address of the buffer.
- *   If child == 1, this entry has a subtree, index indicates
- *		the buffer that stores the subtree, and ptr points to the
- *		address of the buffer.
+#define ODPH_IP_LOOKUP_TABLE_MAGIC_WORD  0xCFCFFCFC
+#define ODPH_IP6_LOOKUP_TABLE_MAGIC_WORD 0xCFCFFCFD
+
+/** @internal Table entry format (32 bits)
+ *   bit 31      Valid: entry has a route (or a group)
+ *   bit 30      Ext: entry points to a group of the next level
+ *   bits 29-22  Prefix length of the route
+ *   bits 21-0   Route index, or group index when Ext is set
+ *
+ *   Prefixes are leaf pushed: an entry that points to a group does not
+ *   have a route, but the route is copied into the group entries.
  */
+#define ENTRY_VALID		0x80000000
+#define ENTRY_EXT		0x40000000
+#define ENTRY_DEPTH_SHIFT	22
+#define ENTRY_DEPTH_MASK	0xff
+#define ENTRY_INDEX_MASK	0x3fffff
+
+/* Maximum number of routes and groups per table */
+#define MAX_INDEX		(ENTRY_INDEX_MASK + 1)
+
+/* Number of entries in a group (8 bit stride) */
+#define GROUP_SIZE		256
+
+/* First level size in bits */
+#define IPV4_L1_BITS		24
+#define IPV6_L1_BITS		16
+
+#define IPV4_DEFAULT_ROUTES	(64 * 1024)
+#define IPV4_DEFAULT_GROUPS	(4 * 1024)
+#define IPV6_DEFAULT_ROUTES	(64 * 1024)
+#define IPV6_DEFAULT_GROUPS	(16 * 1024)
+
+#define CACHE_ROUNDUP(x) \
+	(((x) + ODP_CACHE_LINE_SIZE - 1) & ~((uint64_t)ODP_CACHE_LINE_SIZE - 1))
+
+/* Deleted routes and groups are reused after this grace period. Lookups
+ * do not synchronize with writers, so a lookup may still read a deleted
+ * group or route value for a (short) while. */
+#define RETIRE_GRACE_NS		(100 * ODP_TIME_MSEC_IN_NS)
+
+/** @internal Rule key: prefix in network byte order */
 typedef struct {
-	union {
-		odp_buffer_t nexthop;
-		void *ptr;
-	};
-	union {
-		uint8_t u8;
-		struct {
-#if ODP_BYTE_ORDER == ODP_BIG_ENDIAN
-			uint8_t child : 1;
-			uint8_t cidr  : 7;
-#else
-			uint8_t cidr  : 7;
-			uint8_t child : 1;
-#endif
-		};
-	};
-} prefix_entry_t;
-
-#define ENTRY_SIZE (sizeof(prefix_entry_t) + sizeof(odp_buffer_t))
-#define ENTRY_BUFF_ARR(x) ((odp_buffer_t *)(void *)((char *)x \
-			+ sizeof(prefix_entry_t) * ENTRY_NUM_SUBTREE))
-
-/** @internal trie node struct
- *  In this IP lookup algorithm, we use a
- *  binary tire to detect the overlap prefix.
- */
-typedef struct trie_node {
-	/* tree structure */
-	struct trie_node *parent;
-	struct trie_node *left;
-	struct trie_node *right;
-	/* IP prefix length */
+	uint8_t ip[16];
 	uint8_t cidr;
-	/* Nexthop buffer index */
-	odp_buffer_t nexthop;
-	/* Buffer that stores this node */
-	odp_buffer_t buffer;
-} trie_node_t;
-
-/** Number of L2\L3 entries(subtrees) per cache cube. */
-#define CACHE_NUM_SUBTREE	(4 * 1024)
-/** Number of trie nodes per cache cube. */
-#define CACHE_NUM_TRIE		(4 * 1024)
-
-/** @typedef cache_type_t
- *	Cache node type
- */
-typedef enum {
-	CACHE_TYPE_SUBTREE = 0,
-	CACHE_TYPE_TRIE
-} cache_type_t;
+	uint8_t pad[3];
+} rule_key_t;
+
+/** @internal Deleted route or group, waiting for reuse */
+typedef struct {
+	uint64_t time;
+	uint32_t index;
+	uint32_t is_group;
+} retired_t;
 
 /** A IP lookup table structure. */
 typedef struct ODP_ALIGNED_CACHE {
 	/**< for check */
 	uint32_t magicword;
-	/** Name of the hash. */
+	/** Name of the table. */
 	char name[ODPH_TABLE_NAME_LEN];
-	/** Total L1 entries. */
-	prefix_entry_t *l1e;
-	/** Root node of the binary trie */
-	trie_node_t *trie;
+	/** Address length in bits (32 or 128) */
+	uint32_t addr_bits;
+	/** First level length in bits */
+	uint32_t l1_bits;
 	/** Length of value. */
 	uint32_t nexthop_len;
-	/** Queues of free slots (caches)
-	 *  There are two queues:
-	 *  - free_slots[CACHE_TYPE_SUBTREE] is used for L2 and
-	 *    L3 entries (subtrees). Each entry stores an 8-bit
-	 *    subtree.
-	 *  - free_slots[CACHE_TYPE_TRIE] is used for the binary
-	 *    trie. Each entry contains a trie node.
-	 */
-	odp_queue_t free_slots[2];
-	/** The number of pool used by each queue. */
-	uint32_t cache_count[2];
+	uint32_t max_routes;
+	uint32_t max_groups;
+	/** Serializes writers */
+	odp_spinlock_t lock;
+	/** Rules (prefix -> route index) */
+	odph_table_t rule_tbl;
+	/** First level entries */
+	odp_atomic_u32_t *l1;
+	/** Groups of entries for the next levels */
+	odp_atomic_u32_t *group;
+	/** Route values */
+	odp_atomic_u64_t *value;
+	/** Stacks of free route and group indexes */
+	uint32_t *free_route;
+	uint32_t *free_group;
+	uint32_t num_free_route;
+	uint32_t num_free_group;
+	/** Ring of retired routes and groups, oldest first */
+	retired_t *retired;
+	uint32_t retire_size;
+	uint32_t retire_head;
+	uint32_t retire_num;
 } odph_iplookup_table_impl;
 
-/***********************************************************
- *****************   Cache management   ********************
- ***********************************************************/
+static inline uint32_t entry_depth(uint32_t e)
+{
+	return (e >> ENTRY_DEPTH_SHIFT) & ENTRY_DEPTH_MASK;
+}
 
-/** Destroy all caches */
-static void
-cache_destroy(odph_iplookup_table_impl *impl)
+static inline uint32_t entry_index(uint32_t e)
 {
-	odp_queue_t queue;
-	odp_event_t ev;
-	uint32_t i = 0, count = 0;
-	char pool_name[ODPH_TABLE_NAME_LEN + 8];
+	return e & ENTRY_INDEX_MASK;
+}
 
-	/* free all buffers in the queue */
-	for (; i < 2; i++) {
-		queue = impl->free_slots[i];
-		if (queue == ODP_QUEUE_INVALID)
-			continue;
+static inline uint32_t entry_route(uint32_t depth, uint32_t route)
+{
+	return ENTRY_VALID | (depth << ENTRY_DEPTH_SHIFT) | route;
+}
 
-		while ((ev = odp_queue_deq(queue))
-				!= ODP_EVENT_INVALID) {
-			odp_buffer_free(odp_buffer_from_event(ev));
-		}
-		odp_queue_destroy(queue);
+static inline odp_atomic_u32_t *group_ptr(odph_iplookup_table_impl *tbl,
+					  uint32_t idx)
+{
+	return &tbl->group[(uint64_t)idx * GROUP_SIZE];
+}
+
+static inline uint32_t l1_index(odph_iplookup_table_impl *tbl,
+				const uint8_t ip[])
+{
+	if (tbl->l1_bits == IPV4_L1_BITS)
+		return (ip[0] << 16) | (ip[1] << 8) | ip[2];
+
+	return (ip[0] << 8) | ip[1];
+}
+
+static inline void value_copy(odph_iplookup_table_impl *tbl, uint32_t e,
+			      void *buffer)
+{
+	odp_buffer_t nexthop = ODP_BUFFER_INVALID;
+	uint64_t val;
+
+	if (e & ENTRY_VALID) {
+		val = odp_atomic_load_u64(&tbl->value[entry_index(e)]);
+		memcpy(&nexthop, &val, sizeof(odp_buffer_t));
 	}
 
-	/* destroy all cache pools */
-	for (i = 0; i < 2; i++) {
-		for (count = 0; count < impl->cache_count[i]; count++) {
-			sprintf(
-					pool_name, "%s_%d_%d",
-					impl->name, i, count);
-			(void)odp_pool_destroy(odp_pool_lookup(pool_name));
-		}
+	*(odp_buffer_t *)buffer = nexthop;
+}
+
+static void prefix_mask(uint8_t ip[], uint32_t bytes, uint32_t cidr)
+{
+	uint32_t i;
+
+	for (i = 0; i < bytes; i++) {
+		if (i * 8 >= cidr)
+			ip[i] = 0;
+		else if (i * 8 + 8 > cidr)
+			ip[i] &= 0xff << (8 - (cidr - i * 8));
 	}
 }
 
-/** According to the type of cahce, set the value of
- *  a buffer to the initial value.
- */
-static void
-cache_init_buffer(odp_buffer_t buffer, cache_type_t type, uint32_t size)
+/***********************************************************
+ ************   Route and group index management   *********
+ ***********************************************************/
+
+static void retire(odph_iplookup_table_impl *tbl, uint32_t idx,
+		   uint32_t is_group)
 {
-	int i = 0;
-	void *addr = odp_buffer_addr(buffer);
+	retired_t *r;
+
+	r = &tbl->retired[(tbl->retire_head + tbl->retire_num) %
+			  tbl->retire_size];
+	r->time = odp_time_to_ns(odp_time_global());
+	r->index = idx;
+	r->is_group = is_group;
+	tbl->retire_num++;
+}
 
-	memset(addr, 0, size);
-	if (type == CACHE_TYPE_SUBTREE) {
-		prefix_entry_t *entry = (prefix_entry_t *)addr;
+/* Move retired indexes, which have passed the grace period, to free
+ * stacks */
+static void reclaim(odph_iplookup_table_impl *tbl)
+{
+	retired_t *r;
+	uint64_t now;
 
-		for (i = 0; i < ENTRY_NUM_SUBTREE; i++, entry++)
-			entry->nexthop = ODP_BUFFER_INVALID;
-	} else if (type == CACHE_TYPE_TRIE) {
-		trie_node_t *node = (trie_node_t *)addr;
+	if (tbl->retire_num == 0)
+		return;
 
-		node->buffer = buffer;
-		node->nexthop = ODP_BUFFER_INVALID;
+	now = odp_time_to_ns(odp_time_global());
+
+	while (tbl->retire_num) {
+		r = &tbl->retired[tbl->retire_head];
+
+		if (now - r->time < RETIRE_GRACE_NS)
+			break;
+
+		if (r->is_group)
+			tbl->free_group[tbl->num_free_group++] = r->index;
+		else
+			tbl->free_route[tbl->num_free_route++] = r->index;
+
+		tbl->retire_head = (tbl->retire_head + 1) % tbl->retire_size;
+		tbl->retire_num--;
 	}
 }
 
-/** Create a new buffer pool, and insert its buffer into the queue. */
-static int
-cache_alloc_new_pool(
-		odph_iplookup_table_impl *tbl, cache_type_t type)
+static int route_alloc(odph_iplookup_table_impl *tbl)
 {
-	odp_pool_t pool;
-	odp_pool_param_t param;
-	odp_pool_capability_t pool_capa;
-	odp_queue_t queue = tbl->free_slots[type];
+	if (tbl->num_free_route == 0)
+		return -1;
+
+	return tbl->free_route[--tbl->num_free_route];
+}
 
-	odp_buffer_t buffer;
-	char pool_name[ODPH_TABLE_NAME_LEN + 8];
-	uint32_t size = 0, num = 0;
+/* Allocate a group and initialize all its entries to 'init' */
+static int group_alloc(odph_iplookup_table_impl *tbl, uint32_t init)
+{
+	odp_atomic_u32_t *g;
+	uint32_t idx, i;
 
-	if (odp_pool_capability(&pool_capa)) {
-		ODPH_ERR("pool capa failed\n");
+	if (tbl->num_free_group == 0)
 		return -1;
+
+	idx = tbl->free_group[--tbl->num_free_group];
+	g = group_ptr(tbl, idx);
+
+	for (i = 0; i < GROUP_SIZE; i++)
+		odp_atomic_store_u32(&g[i], init);
+
+	return idx;
+}
+
+/***********************************************************
+ *******************   Table updates   *********************
+ ***********************************************************/
+
+/* Set 'num' entries to 'new', unless an entry has a longer prefix. Groups
+ * are updated recursively. */
+static void range_add(odph_iplookup_table_impl *tbl, odp_atomic_u32_t *e,
+		      uint32_t num, uint32_t depth, uint32_t new)
+{
+	uint32_t i, val;
+
+	for (i = 0; i < num; i++) {
+		val = odp_atomic_load_u32(&e[i]);
+
+		if (val & ENTRY_EXT)
+			range_add(tbl, group_ptr(tbl, entry_index(val)),
+				  GROUP_SIZE, depth, new);
+		else if (!(val & ENTRY_VALID) || entry_depth(val) <= depth)
+			odp_atomic_store_u32(&e[i], new);
 	}
+}
 
-	if (pool_capa.buf.max_num) {
-		if (pool_capa.buf.max_num < CACHE_NUM_TRIE ||
-		    pool_capa.buf.max_num < CACHE_NUM_SUBTREE) {
-			ODPH_ERR("pool size too small\n");
-			return -1;
-		}
+/* Return the group of an entry. If the entry does not have a group yet,
+ * a new group is created and the route of the entry pushed into it. */
+static odp_atomic_u32_t *entry_group(odph_iplookup_table_impl *tbl,
+				     odp_atomic_u32_t *e)
+{
+	uint32_t val = odp_atomic_load_u32(e);
+	int idx;
+
+	if (val & ENTRY_EXT)
+		return group_ptr(tbl, entry_index(val));
+
+	idx = group_alloc(tbl, val);
+	if (idx < 0) {
+		ODPH_DBG("no free groups\n");
+		return NULL;
 	}
 
-	if (pool_capa.buf.max_size) {
-		if (pool_capa.buf.max_size < ENTRY_SIZE * ENTRY_NUM_SUBTREE ||
-		    pool_capa.buf.max_size < sizeof(trie_node_t)) {
-			ODPH_ERR("buffer size too small\n");
+	/* Group entries must be visible before the group is linked */
+	odp_atomic_store_rel_u32(e, ENTRY_VALID | ENTRY_EXT | idx);
+
+	return group_ptr(tbl, idx);
+}
+
+static int lpm_add(odph_iplookup_table_impl *tbl, const uint8_t ip[],
+		   uint32_t depth, uint32_t route)
+{
+	uint32_t new = entry_route(depth, route);
+	uint32_t bits = tbl->l1_bits;
+	uint32_t byte = bits / 8;
+	odp_atomic_u32_t *e, *g;
+
+	e = &tbl->l1[l1_index(tbl, ip)];
+
+	if (depth <= bits) {
+		range_add(tbl, e, 1 << (bits - depth), depth, new);
+		return 0;
+	}
+
+	while (1) {
+		g = entry_group(tbl, e);
+		if (g == NULL)
 			return -1;
+
+		if (depth <= bits + 8) {
+			range_add(tbl, &g[ip[byte]], 1 << (bits + 8 - depth),
+				  depth, new);
+			return 0;
 		}
+
+		e = &g[ip[byte]];
+		bits += 8;
+		byte++;
 	}
+}
 
-	/* Create new pool (new free buffers). */
-	odp_pool_param_init(&param);
-	param.type = ODP_POOL_BUFFER;
-	if (pool_capa.buf.max_align >= ODP_CACHE_LINE_SIZE)
-		param.buf.align = ODP_CACHE_LINE_SIZE;
-	if (type == CACHE_TYPE_SUBTREE) {
-		num = CACHE_NUM_SUBTREE;
-		size = ENTRY_SIZE * ENTRY_NUM_SUBTREE;
-	} else if (type == CACHE_TYPE_TRIE) {
-		num = CACHE_NUM_TRIE;
-		size = sizeof(trie_node_t);
-	} else {
-		ODPH_DBG("wrong cache_type_t.\n");
-		return -1;
+/* Replace group pointer of an entry with a route, when all group entries
+ * have the same route and the route prefix fits into the entry. 'bits' is
+ * the prefix length that the entry covers. */
+static void group_collapse(odph_iplookup_table_impl *tbl, odp_atomic_u32_t *e,
+			   uint32_t bits)
+{
+	uint32_t val = odp_atomic_load_u32(e);
+	uint32_t idx, first, i;
+	odp_atomic_u32_t *g;
+
+	if (!(val & ENTRY_EXT))
+		return;
+
+	idx = entry_index(val);
+	g = group_ptr(tbl, idx);
+	first = odp_atomic_load_u32(&g[0]);
+
+	if (first & ENTRY_EXT)
+		return;
+
+	if ((first & ENTRY_VALID) && entry_depth(first) > bits)
+		return;
+
+	for (i = 1; i < GROUP_SIZE; i++)
+		if (odp_atomic_load_u32(&g[i]) != first)
+			return;
+
+	odp_atomic_store_rel_u32(e, first);
+	retire(tbl, idx, 1);
+}
+
+/* Replace entries of a route with 'repl'. 'bits' is the prefix length that
+ * the entries cover. */
+static void range_del(odph_iplookup_table_impl *tbl, odp_atomic_u32_t *e,
+		      uint32_t num, uint32_t route, uint32_t repl,
+		      uint32_t bits)
+{
+	uint32_t i, val;
+
+	for (i = 0; i < num; i++) {
+		val = odp_atomic_load_u32(&e[i]);
+
+		if (val & ENTRY_EXT) {
+			range_del(tbl, group_ptr(tbl, entry_index(val)),
+				  GROUP_SIZE, route, repl, bits + 8);
+			group_collapse(tbl, &e[i], bits);
+		} else if ((val & ENTRY_VALID) && entry_index(val) == route) {
+			odp_atomic_store_u32(&e[i], repl);
+		}
 	}
-	param.buf.size = size;
-	param.buf.num = num;
+}
 
-	sprintf(
-			pool_name, "%s_%d_%d",
-			tbl->name, type, tbl->cache_count[type]);
-	pool = odp_pool_create(pool_name, &param);
-	if (pool == ODP_POOL_INVALID) {
-		ODPH_DBG("failed to create a new pool.\n");
-		return -1;
+static void lpm_del(odph_iplookup_table_impl *tbl, const uint8_t ip[],
+		    uint32_t depth, uint32_t route, uint32_t repl)
+{
+	odp_atomic_u32_t *path[16];
+	uint32_t path_bits[16];
+	uint32_t bits = tbl->l1_bits;
+	uint32_t byte = bits / 8;
+	odp_atomic_u32_t *e, *g;
+	uint32_t val;
+	int n = 0;
+
+	e = &tbl->l1[l1_index(tbl, ip)];
+
+	if (depth <= bits) {
+		range_del(tbl, e, 1 << (bits - depth), route, repl, bits);
+		return;
 	}
 
-	/* insert new free buffers into queue */
-	while ((buffer = odp_buffer_alloc(pool))
-			!= ODP_BUFFER_INVALID) {
-		cache_init_buffer(buffer, type, size);
-		if (odp_queue_enq(queue, odp_buffer_to_event(buffer))) {
-			ODPH_DBG("queue enqueue failed\n");
-			odp_buffer_free(buffer);
+	while (1) {
+		val = odp_atomic_load_u32(e);
+		if (!(val & ENTRY_EXT))
+			break;
+
+		g = group_ptr(tbl, entry_index(val));
+		path[n] = e;
+		path_bits[n] = bits;
+		n++;
+
+		if (depth <= bits + 8) {
+			range_del(tbl, &g[ip[byte]], 1 << (bits + 8 - depth),
+				  route, repl, bits + 8);
 			break;
 		}
+
+		e = &g[ip[byte]];
+		bits += 8;
+		byte++;
 	}
 
-	tbl->cache_count[type]++;
-	return 0;
+	/* Collapse groups that became uniform, starting from the deepest */
+	while (n--)
+		group_collapse(tbl, path[n], path_bits[n]);
 }
 
-/** Get a new buffer from a cache list. If there is no
- *  available buffer, allocate a new pool.
- */
-static odp_buffer_t
-cache_get_buffer(odph_iplookup_table_impl *tbl, cache_type_t type)
+/* Return table entry of the longest rule that covers the prefix, or zero
+ * if there is none */
+static uint32_t covering_entry(odph_iplookup_table_impl *tbl,
+			       const rule_key_t *key)
 {
-	odp_buffer_t buffer = ODP_BUFFER_INVALID;
-	odp_queue_t queue = tbl->free_slots[type];
+	rule_key_t cover = *key;
+	uint32_t route, depth;
 
-	/* get free buffer from queue */
-	buffer = odp_buffer_from_event(
-				odp_queue_deq(queue));
+	for (depth = key->cidr - 1; depth > 0; depth--) {
+		prefix_mask(cover.ip, sizeof(cover.ip), depth);
+		cover.cidr = depth;
 
-	/* If there is no free buffer available, allocate new pool */
-	if (buffer == ODP_BUFFER_INVALID) {
-		cache_alloc_new_pool(tbl, type);
-		buffer = odp_buffer_from_event(odp_queue_deq(queue));
+		if (odph_hash_get_value(tbl->rule_tbl, &cover, &route,
+					sizeof(route)) == 0)
+			return entry_route(depth, route);
 	}
 
-	return buffer;
+	return 0;
 }
 
-/***********************************************************
- ******************     Binary trie     ********************
- ***********************************************************/
-
-/* Initialize the root node of the trie */
-static int
-trie_init(odph_iplookup_table_impl *tbl)
+/* Add a rule or update value of an existing rule. Called with the writer
+ * lock. */
+static int rule_add(odph_iplookup_table_impl *tbl, const rule_key_t *key,
+		    const void *value)
 {
-	trie_node_t *root = NULL;
-	odp_buffer_t buffer = cache_get_buffer(tbl, CACHE_TYPE_TRIE);
+	uint64_t val = 0;
+	uint32_t route;
+	int idx;
+
+	memcpy(&val, value, sizeof(odp_buffer_t));
 
-	if (buffer != ODP_BUFFER_INVALID) {
-		root = (trie_node_t *)odp_buffer_addr(buffer);
-		root->cidr = 0;
-		tbl->trie = root;
+	/* Existing prefix: update the value only */
+	if (odph_hash_get_value(tbl->rule_tbl, (void *)(uintptr_t)key,
+				&route, sizeof(route)) == 0) {
+		odp_atomic_store_u64(&tbl->value[route], val);
 		return 0;
 	}
 
-	return -1;
-}
+	idx = route_alloc(tbl);
+	if (idx < 0) {
+		ODPH_DBG("no free routes\n");
+		return -1;
+	}
 
-/* Destroy the whole trie (recursively) */
-static void
-trie_destroy(odph_iplookup_table_impl *tbl, trie_node_t *trie)
-{
-	if (trie->left != NULL)
-		trie_destroy(tbl, trie->left);
-	if (trie->right != NULL)
-		trie_destroy(tbl, trie->right);
+	route = idx;
+	odp_atomic_store_u64(&tbl->value[route], val);
 
-	/* destroy this node */
-	odp_queue_enq(
-			tbl->free_slots[CACHE_TYPE_TRIE],
-			odp_buffer_to_event(trie->buffer));
-}
+	if (odph_hash_put_value(tbl->rule_tbl, (void *)(uintptr_t)key,
+				&route) < 0) {
+		tbl->free_route[tbl->num_free_route++] = route;
+		ODPH_DBG("failed to insert rule\n");
+		return -1;
+	}
 
-/* Insert a new prefix node into the trie
- * If the node is already existed, update its nexthop info,
- *   Return 0 and set nexthop pointer to INVALID.
- * If the node is not exitsed, create this target node and
- *   all nodes along the path from root to the target node.
- *   Then return 0 and set nexthop pointer points to the
- *   new buffer.
- * Return -1 for error.
- */
-static int
-trie_insert_node(
-		odph_iplookup_table_impl *tbl, trie_node_t *root,
-		uint32_t ip, uint8_t cidr, odp_buffer_t nexthop)
-{
-	uint8_t level = 0, child;
-	odp_buffer_t buf;
-	trie_node_t *node = root, *prev = root;
-
-	/* create/update all nodes along the path
-	 * from root to the new node. */
-	for (level = 1; level <= cidr; level++) {
-		child = WHICH_CHILD(ip, level);
-
-		node = child == 0 ? prev->left : prev->right;
-		/* If the child node doesn't exit, create it. */
-		if (node == NULL) {
-			buf = cache_get_buffer(tbl, CACHE_TYPE_TRIE);
-			if (buf == ODP_BUFFER_INVALID)
-				return -1;
-
-			node = (trie_node_t *)odp_buffer_addr(buf);
-			node->cidr = level;
-			node->parent = prev;
-
-			if (child == 0)
-				prev->left = node;
-			else
-				prev->right = node;
-		}
-		prev = node;
+	if (lpm_add(tbl, key->ip, key->cidr, route)) {
+		/* Undo the partially added route */
+		odph_hash_remove_value(tbl->rule_tbl, (void *)(uintptr_t)key);
+		lpm_del(tbl, key->ip, key->cidr, route,
+			covering_entry(tbl, key));
+		retire(tbl, route, 0);
+		return -1;
 	}
 
-	/* The final one is the target. */
-	node->nexthop = nexthop;
 	return 0;
 }
 
-/* Delete a node */
-static int
-trie_delete_node(
-		odph_iplookup_table_impl *tbl,
-		trie_node_t *root, uint32_t ip, uint8_t cidr)
+/* Remove a rule. Called with the writer lock. */
+static int rule_remove(odph_iplookup_table_impl *tbl, const rule_key_t *key)
 {
-	if (root == NULL)
-		return -1;
+	uint32_t route;
 
-	/* The default prefix (root node) cannot be deleted. */
-	if (cidr == 0)
+	if (odph_hash_get_value(tbl->rule_tbl, (void *)(uintptr_t)key,
+				&route, sizeof(route)))
 		return -1;
 
-	trie_node_t *node = root, *prev = NULL;
-	uint8_t level = 1, child = 0;
-	odp_buffer_t tmp;
+	odph_hash_remove_value(tbl->rule_tbl, (void *)(uintptr_t)key);
+	lpm_del(tbl, key->ip, key->cidr, route, covering_entry(tbl, key));
+	retire(tbl, route, 0);
 
-	/* Find the target node. */
-	for (level = 1; level <= cidr; level++) {
-		child = WHICH_CHILD(ip, level);
-		node = (child == 0) ? node->left : node->right;
-		if (node == NULL) {
-			ODPH_DBG("Trie node is not existed\n");
-			return -1;
-		}
-	}
-
-	node->nexthop = ODP_BUFFER_INVALID;
+	return 0;
+}
 
-	/* Delete all redundant nodes along the path. */
-	for (level = cidr; level > 0; level--) {
-		if (
-			node->left != NULL || node->right != NULL ||
-			node->nexthop != ODP_BUFFER_INVALID)
-			break;
+/* Add rules in order. Returns number of rules added. */
+static int lpm_put_multi(odph_iplookup_table_impl *tbl, const rule_key_t key[],
+			 void *value[], int num)
+{
+	int i;
 
-		child = WHICH_CHILD(ip, level);
-		prev = node->parent;
+	odp_spinlock_lock(&tbl->lock);
 
-		/* free trie node */
-		tmp = node->buffer;
-		cache_init_buffer(
-				tmp, CACHE_TYPE_TRIE, sizeof(trie_node_t));
-		odp_queue_enq(
-				tbl->free_slots[CACHE_TYPE_TRIE],
-				odp_buffer_to_event(tmp));
+	reclaim(tbl);
 
-		if (child == 0)
-			prev->left = NULL;
-		else
-			prev->right = NULL;
-		node = prev;
+	for (i = 0; i < num; i++) {
+		if (rule_add(tbl, &key[i], value[i]))
+			break;
 	}
-	return 0;
+
+	odp_spinlock_unlock(&tbl->lock);
+	return i;
 }
 
-/* Detect the longest overlapping prefix. */
-static int
-trie_detect_overlap(
-		trie_node_t *trie, uint32_t ip, uint8_t cidr,
-		uint8_t leaf_push, uint8_t *over_cidr,
-		odp_buffer_t *over_nexthop)
+/* Remove rules that have a bit set in 'valid'. Returns mask of removed
+ * rules. */
+static uint64_t lpm_remove_multi(odph_iplookup_table_impl *tbl,
+				 const rule_key_t key[], uint64_t valid,
+				 int num)
 {
-	uint8_t child = 0;
-	uint32_t level, limit = cidr > leaf_push ? leaf_push + 1 : cidr;
-	trie_node_t *node = trie, *longest = trie;
+	uint64_t removed = 0;
+	int i;
+
+	odp_spinlock_lock(&tbl->lock);
 
-	for (level = 1; level < limit; level++) {
-		child = WHICH_CHILD(ip, level);
-		node = (child == 0) ? node->left : node->right;
-		if (node->nexthop != ODP_BUFFER_INVALID)
-			longest = node;
+	for (i = 0; i < num; i++) {
+		if (((valid >> i) & 1) && rule_remove(tbl, &key[i]) == 0)
+			removed |= 1ULL << i;
 	}
 
-	*over_cidr = longest->cidr;
-	*over_nexthop = longest->nexthop;
-	return 0;
+	odp_spinlock_unlock(&tbl->lock);
+	return removed;
 }
 
 /***********************************************************
- ***************   IP prefix lookup table   ****************
+ *****************   Create and destroy   ******************
  ***********************************************************/
 
-odph_table_t
-odph_iplookup_table_lookup(const char *name)
+static odph_iplookup_table_impl *table_lookup(const char *name,
+					      uint32_t magic)
 {
 	odph_iplookup_table_impl *tbl = NULL;
 	odp_shm_t shm;
@@ -456,64 +546,60 @@ odph_iplookup_table_lookup(const char *name)
 	if (shm != ODP_SHM_INVALID)
 		tbl = (odph_iplookup_table_impl *)odp_shm_addr(shm);
 
-	if (
-		tbl != NULL &&
-		tbl->magicword == ODPH_IP_LOOKUP_TABLE_MAGIC_WORD &&
-		strcmp(tbl->name, name) == 0)
-		return (odph_table_t)tbl;
+	if (tbl != NULL && tbl->magicword == magic &&
+	    strcmp(tbl->name, name) == 0)
+		return tbl;
 
 	return NULL;
 }
 
-odph_table_t odph_iplookup_table_create(const char *name,
-					uint32_t p1 ODP_UNUSED,
-					uint32_t p2 ODP_UNUSED,
-					uint32_t value_size)
+static void *mem_carve(char **ptr, uint64_t size)
 {
-	odph_iplookup_table_impl *tbl;
-	odp_shm_t shm_tbl;
-	odp_queue_t queue;
-	odp_queue_param_t qparam;
-	odp_queue_capability_t queue_capa;
-	unsigned i;
-	uint32_t impl_size, l1_size, queue_size;
-	char queue_name[ODPH_TABLE_NAME_LEN + 2];
-
-	if (odp_queue_capability(&queue_capa)) {
-		ODPH_ERR("queue capa failed\n");
-		return NULL;
-	}
+	void *mem = *ptr;
 
-	if (queue_capa.plain.max_size) {
-		if (queue_capa.plain.max_size < CACHE_NUM_TRIE ||
-		    queue_capa.plain.max_size < CACHE_NUM_SUBTREE) {
-			ODPH_ERR("queue size too small\n");
-			return NULL;
-		}
-	}
+	*ptr += CACHE_ROUNDUP(size);
+	return mem;
+}
 
-	queue_size = CACHE_NUM_TRIE;
-	if (CACHE_NUM_SUBTREE > CACHE_NUM_TRIE)
-		queue_size = CACHE_NUM_SUBTREE;
+static odph_table_t table_create(const char *name, uint32_t magic,
+				 uint32_t addr_bits, uint32_t l1_bits,
+				 uint32_t max_routes, uint32_t max_groups,
+				 uint32_t value_size)
+{
+	odph_iplookup_table_impl *tbl;
+	odp_shm_t shm_tbl;
+	char rule_name[ODPH_TABLE_NAME_LEN];
+	uint64_t l1_num = 1ull << l1_bits;
+	uint64_t size, rule_cap;
+	uint32_t i;
+	char *ptr;
 
 	/* Check for valid parameters */
-	if (strlen(name) == 0) {
+	if (name == NULL || strlen(name) == 0 ||
+	    strlen(name) >= ODPH_TABLE_NAME_LEN ||
+	    max_routes > MAX_INDEX || max_groups > MAX_INDEX) {
 		ODPH_DBG("invalid parameters\n");
 		return NULL;
 	}
 
 	/* Guarantee there's no existing */
-	tbl = (void *)odph_iplookup_table_lookup(name);
-	if (tbl != NULL) {
+	if (odp_shm_lookup(name) != ODP_SHM_INVALID) {
 		ODPH_DBG("IP prefix table %s already exists\n", name);
 		return NULL;
 	}
 
 	/* Calculate the sizes of different parts of IP prefix table */
-	impl_size = sizeof(odph_iplookup_table_impl);
-	l1_size = ENTRY_SIZE * ENTRY_NUM_L1;
-
-	shm_tbl = odp_shm_reserve(name, impl_size + l1_size, ODP_CACHE_LINE_SIZE, 0);
+	size = CACHE_ROUNDUP(sizeof(odph_iplookup_table_impl)) +
+	       CACHE_ROUNDUP(l1_num * sizeof(odp_atomic_u32_t)) +
+	       CACHE_ROUNDUP((uint64_t)max_groups * GROUP_SIZE *
+			     sizeof(odp_atomic_u32_t)) +
+	       CACHE_ROUNDUP((uint64_t)max_routes * sizeof(odp_atomic_u64_t)) +
+	       CACHE_ROUNDUP((uint64_t)max_routes * sizeof(uint32_t)) +
+	       CACHE_ROUNDUP((uint64_t)max_groups * sizeof(uint32_t)) +
+	       CACHE_ROUNDUP(((uint64_t)max_routes + max_groups) *
+			     sizeof(retired_t));
+
+	shm_tbl = odp_shm_reserve(name, size, ODP_CACHE_LINE_SIZE, 0);
 
 	if (shm_tbl == ODP_SHM_INVALID) {
 		ODPH_DBG(
@@ -522,189 +608,125 @@ odph_table_t odph_iplookup_table_create(const char *name,
 		return NULL;
 	}
 
-	tbl = (odph_iplookup_table_impl *)odp_shm_addr(shm_tbl);
-	memset(tbl, 0, impl_size + l1_size);
-
-	/* header of this mem block is the table impl struct,
-	 * then the l1 entries array.
-	 */
-	tbl->l1e = (prefix_entry_t *)(void *)((char *)tbl + impl_size);
-	for (i = 0; i < ENTRY_NUM_L1; i++)
-		tbl->l1e[i].nexthop = ODP_BUFFER_INVALID;
-
-	/* Setup table context. */
-	snprintf(tbl->name, sizeof(tbl->name), "%s", name);
-	tbl->magicword = ODPH_IP_LOOKUP_TABLE_MAGIC_WORD;
-	tbl->nexthop_len = value_size;
-
-	/* Initialize cache */
-	for (i = 0; i < 2; i++) {
-		tbl->cache_count[i] = 0;
-
-		odp_queue_param_init(&qparam);
-		qparam.type = ODP_QUEUE_TYPE_PLAIN;
-		qparam.size = queue_size;
-		sprintf(queue_name, "%s_%d", name, i);
-		queue = odp_queue_create(queue_name, &qparam);
-		if (queue == ODP_QUEUE_INVALID) {
-			ODPH_DBG("failed to create queue");
-			cache_destroy(tbl);
-			return NULL;
-		}
-		tbl->free_slots[i] = queue;
-		cache_alloc_new_pool(tbl, i);
+	ptr = (char *)odp_shm_addr(shm_tbl);
+	tbl = mem_carve(&ptr, sizeof(odph_iplookup_table_impl));
+	memset(tbl, 0, sizeof(odph_iplookup_table_impl));
+
+	tbl->l1 = mem_carve(&ptr, l1_num * sizeof(odp_atomic_u32_t));
+	tbl->group = mem_carve(&ptr, (uint64_t)max_groups * GROUP_SIZE *
+			       sizeof(odp_atomic_u32_t));
+	tbl->value = mem_carve(&ptr, (uint64_t)max_routes *
+			       sizeof(odp_atomic_u64_t));
+	tbl->free_route = mem_carve(&ptr, (uint64_t)max_routes *
+				    sizeof(uint32_t));
+	tbl->free_group = mem_carve(&ptr, (uint64_t)max_groups *
+				    sizeof(uint32_t));
+	tbl->retired = mem_carve(&ptr, ((uint64_t)max_routes + max_groups) *
+				 sizeof(retired_t));
+
+	for (i = 0; i < l1_num; i++)
+		odp_atomic_init_u32(&tbl->l1[i], 0);
+
+	for (i = 0; i < max_routes; i++) {
+		odp_atomic_init_u64(&tbl->value[i], 0);
+		tbl->free_route[i] = max_routes - 1 - i;
 	}
 
-	/* Initialize tire */
-	if (trie_init(tbl) < 0) {
+	for (i = 0; i < max_groups; i++)
+		tbl->free_group[i] = max_groups - 1 - i;
+
+	tbl->num_free_route = max_routes;
+	tbl->num_free_group = max_groups;
+	tbl->retire_size = max_routes + max_groups;
+
+	/* Rules are needed only by writers. Reserve hash table capacity
+	 * (in MB) for about 64 bytes per rule. */
+	rule_cap = (((uint64_t)max_routes * 64) >> 20) + 1;
+	snprintf(rule_name, sizeof(rule_name), "%.*s_r",
+		 ODPH_TABLE_NAME_LEN - 3, name);
+	tbl->rule_tbl = odph_hash_table_create(rule_name, rule_cap,
+					       sizeof(rule_key_t),
+					       sizeof(uint32_t));
+	if (tbl->rule_tbl == NULL) {
+		ODPH_DBG("failed to create rule table\n");
 		odp_shm_free(shm_tbl);
 		return NULL;
 	}
 
+	/* Setup table context. */
+	snprintf(tbl->name, sizeof(tbl->name), "%s", name);
+	tbl->addr_bits = addr_bits;
+	tbl->l1_bits = l1_bits;
+	tbl->nexthop_len = value_size;
+	tbl->max_routes = max_routes;
+	tbl->max_groups = max_groups;
+	odp_spinlock_init(&tbl->lock);
+	tbl->magicword = magic;
+
 	return (odph_table_t)tbl;
 }
 
-int
-odph_iplookup_table_destroy(odph_table_t tbl)
+static int table_destroy(odph_table_t tbl, uint32_t magic)
 {
-	int i, j;
-	odph_iplookup_table_impl *impl = NULL;
-	prefix_entry_t *subtree = NULL;
-	odp_buffer_t *buff1 = NULL, *buff2 = NULL;
+	odph_iplookup_table_impl *impl = (odph_iplookup_table_impl *)tbl;
 
 	if (tbl == NULL)
 		return -1;
 
-	impl = (odph_iplookup_table_impl *)(void *)tbl;
-
 	/* check magic word */
-	if (impl->magicword != ODPH_IP_LOOKUP_TABLE_MAGIC_WORD) {
+	if (impl->magicword != magic) {
 		ODPH_DBG("wrong magicword for IP prefix table\n");
 		return -1;
 	}
 
-	/* destroy trie */
-	trie_destroy(impl, impl->trie);
-
-	/* free all L2 and L3 entries */
-	buff1 = ENTRY_BUFF_ARR(impl->l1e);
-	for (i = 0; i < ENTRY_NUM_L1; i++) {
-		if ((impl->l1e[i]).child == 0)
-			continue;
-
-		subtree = (prefix_entry_t *)impl->l1e[i].ptr;
-		buff2 = ENTRY_BUFF_ARR(subtree);
-		/* destroy all l3 subtrees of this l2 subtree */
-		for (j = 0; j < ENTRY_NUM_SUBTREE; j++) {
-			if (subtree[j].child == 0)
-				continue;
-			odp_queue_enq(
-					impl->free_slots[CACHE_TYPE_TRIE],
-					odp_buffer_to_event(buff2[j]));
-		}
-		/* destroy this l2 subtree */
-		odp_queue_enq(
-				impl->free_slots[CACHE_TYPE_TRIE],
-				odp_buffer_to_event(buff1[i]));
-	}
-
-	/* destroy all cache */
-	cache_destroy(impl);
+	odph_hash_table_destroy(impl->rule_tbl);
+	impl->magicword = 0;
 
 	/* free impl */
 	odp_shm_free(odp_shm_lookup(impl->name));
 	return 0;
 }
 
-/* Insert the prefix into level x
- * Return:
- *   -1	error
- *   0	the table is unmodified
- *   1	the table is modified
- */
-static int
-prefix_insert_into_lx(
-		odph_iplookup_table_impl *tbl, prefix_entry_t *entry,
-		uint8_t cidr, odp_buffer_t nexthop, uint8_t level)
-{
-	int ret = 0;
-	uint32_t i = 0, limit = (1 << (level - cidr));
-	prefix_entry_t *e = entry, *ne = NULL;
-
-	for (i = 0; i < limit; i++, e++) {
-		if (e->cidr > cidr)
-			continue;
+/***********************************************************
+ ***************   IP prefix lookup table   ****************
+ ***********************************************************/
 
-		if (e->child == 1) {
-			e->cidr = cidr;
-			/* push to next level */
-			ne = (prefix_entry_t *)e->ptr;
-			ret = prefix_insert_into_lx(
-					tbl, ne, cidr, nexthop, cidr + 8);
-			if (ret == -1)
-				return -1;
-			if (ret == 0)
-				return ret;
-		} else {
-			e->child = 0;
-			e->cidr = cidr;
-			e->nexthop = nexthop;
-			ret = 1;
-		}
-	}
-	return ret;
+odph_table_t
+odph_iplookup_table_lookup(const char *name)
+{
+	return (odph_table_t)table_lookup(name,
+					  ODPH_IP_LOOKUP_TABLE_MAGIC_WORD);
 }
 
-static int
-prefix_insert_iter(
-		odph_iplookup_table_impl *tbl, prefix_entry_t *entry,
-		odp_buffer_t *buff, uint32_t ip, uint8_t cidr,
-		odp_buffer_t nexthop, uint8_t level, uint8_t depth)
+odph_table_t odph_iplookup_table_create(const char *name,
+					uint32_t max_routes,
+					uint32_t max_groups,
+					uint32_t value_size)
 {
-	uint8_t state = 0;
-	prefix_entry_t *ne = NULL;
-	odp_buffer_t *nbuff = NULL;
-
-	/* If child subtree is existed, get it. */
-	if (entry->child) {
-		ne = (prefix_entry_t *)entry->ptr;
-		nbuff = ENTRY_BUFF_ARR(ne);
-	} else {
-		/* If the child is not existed, create a new subtree. */
-		odp_buffer_t buf, push = entry->nexthop;
-
-		buf = cache_get_buffer(tbl, CACHE_TYPE_SUBTREE);
-		if (buf == ODP_BUFFER_INVALID) {
-			ODPH_DBG("failed to get subtree buffer from cache.\n");
-			return -1;
-		}
-		ne = (prefix_entry_t *)odp_buffer_addr(buf);
-		nbuff = ENTRY_BUFF_ARR(ne);
-
-		entry->child = 1;
-		entry->ptr = ne;
-		*buff = buf;
+	if (max_routes == 0)
+		max_routes = IPV4_DEFAULT_ROUTES;
+	if (max_groups == 0)
+		max_groups = IPV4_DEFAULT_GROUPS;
 
-		/* If this entry contains a nexthop and a small cidr,
-		 * push it to the next level.
-		 */
-		if (entry->cidr > 0)
-			(void)prefix_insert_into_lx(tbl, ne, entry->cidr,
-						    push, entry->cidr + 8);
-	}
+	return table_create(name, ODPH_IP_LOOKUP_TABLE_MAGIC_WORD, 32,
+			    IPV4_L1_BITS, max_routes, max_groups, value_size);
+}
 
-	ne += (ip >> 24);
-	nbuff += (ip >> 24);
-	if (cidr <= 8) {
-		state = prefix_insert_into_lx(
-				tbl, ne, cidr + depth * 8, nexthop, level);
-	} else {
-		state = prefix_insert_iter(
-				tbl, ne, nbuff, ip << 8, cidr - 8,
-				nexthop, level + 8, depth + 1);
-	}
+int
+odph_iplookup_table_destroy(odph_table_t tbl)
+{
+	return table_destroy(tbl, ODPH_IP_LOOKUP_TABLE_MAGIC_WORD);
+}
 
-	return state;
+static void ipv4_rule_key(rule_key_t *key, uint32_t ip, uint8_t cidr)
+{
+	memset(key, 0, sizeof(rule_key_t));
+	key->ip[0] = ip >> 24;
+	key->ip[1] = ip >> 16;
+	key->ip[2] = ip >> 8;
+	key->ip[3] = ip;
+	key->cidr = cidr;
+	prefix_mask(key->ip, 4, cidr);
 }
 
 int
@@ -712,281 +734,439 @@ odph_iplookup_table_put_value(odph_table_t tbl, void *key, void *value)
 {
 	odph_iplookup_table_impl *impl = (void *)tbl;
 	odph_iplookup_prefix_t *prefix = (odph_iplookup_prefix_t *)key;
-	prefix_entry_t *l1e = NULL;
-	odp_buffer_t nexthop;
-	int ret = 0;
+	rule_key_t rule;
 
 	if ((tbl == NULL) || (key == NULL) || (value == NULL))
 		return -1;
 
-	nexthop = *((odp_buffer_t *)value);
-
 	if (prefix->cidr == 0 || prefix->cidr > 32)
 		return -1;
 
-	prefix->ip = prefix->ip & (0xffffffff << (IP_LENGTH - prefix->cidr));
+	ipv4_rule_key(&rule, prefix->ip, prefix->cidr);
 
-	/* insert into trie */
-	ret = trie_insert_node(
-				impl, impl->trie,
-				prefix->ip, prefix->cidr, nexthop);
+	return lpm_put_multi(impl, &rule, &value, 1) == 1 ? 0 : -1;
+}
 
-	if (ret < 0) {
-		ODPH_DBG("failed to insert into trie\n");
+int odph_iplookup_table_put_value_multi(odph_table_t tbl, void *key[],
+					void *value[], int num)
+{
+	odph_iplookup_table_impl *impl = (void *)tbl;
+	rule_key_t rule[ODPH_IPLOOKUP_TABLE_MULTI_MAX] = { 0 };
+	odph_iplookup_prefix_t *prefix;
+	int i, ret;
+
+	if (tbl == NULL || key == NULL || value == NULL || num < 0 ||
+	    num > ODPH_IPLOOKUP_TABLE_MULTI_MAX)
 		return -1;
-	}
 
-	/* get L1 entry */
-	l1e = &impl->l1e[prefix->ip >> 16];
-	odp_buffer_t *buff = ENTRY_BUFF_ARR(impl->l1e) + (prefix->ip >> 16);
+	/* Prefixes up to the first invalid one are added */
+	for (i = 0; i < num; i++) {
+		prefix = key[i];
+		if (value[i] == NULL || prefix->cidr == 0 || prefix->cidr > 32)
+			break;
 
-	if (prefix->cidr <= 16) {
-		ret = prefix_insert_into_lx(
-				impl, l1e, prefix->cidr, nexthop, 16);
-	} else {
-		ret = prefix_insert_iter(
-				impl, l1e, buff,
-				((prefix->ip) << 16), prefix->cidr - 16,
-				nexthop, 24, 2);
+		ipv4_rule_key(&rule[i], prefix->ip, prefix->cidr);
 	}
 
+	ret = lpm_put_multi(impl, rule, value, i);
+
+	if (ret == 0 && num > 0)
+		return -1;
+
 	return ret;
 }
 
+static inline uint32_t ipv4_lookup(odph_iplookup_table_impl *tbl, uint32_t ip)
+{
+	uint32_t e = odp_atomic_load_u32(&tbl->l1[ip >> 8]);
+
+	/* Group entry address depends on the loaded entry, which orders
+	 * the loads */
+	if (e & ENTRY_EXT)
+		e = odp_atomic_load_u32(&group_ptr(tbl, entry_index(e))[ip &
+									0xff]);
+
+	return e;
+}
+
 int odph_iplookup_table_get_value(odph_table_t tbl, void *key,
-				  void *buffer ODP_UNUSED,
+				  void *buffer,
 				  uint32_t buffer_size ODP_UNUSED)
 {
 	odph_iplookup_table_impl *impl = (void *)tbl;
-	uint32_t ip;
-	prefix_entry_t *entry;
-	odp_buffer_t *buff = (odp_buffer_t *)buffer;
 
 	if ((tbl == NULL) || (key == NULL) || (buffer == NULL))
 		return -EINVAL;
 
-	ip = *((uint32_t *)key);
-	entry = &impl->l1e[ip >> 16];
+	value_copy(impl, ipv4_lookup(impl, *((uint32_t *)key)), buffer);
 
-	if (entry == NULL) {
-		ODPH_DBG("failed to get L1 entry.\n");
-		return -1;
+	return 0;
+}
+
+int odph_iplookup_table_get_value_multi(odph_table_t tbl, void *key[],
+					void *buffer[],
+					uint32_t buffer_size ODP_UNUSED,
+					int num, uint64_t *hit_mask)
+{
+	odph_iplookup_table_impl *impl = (void *)tbl;
+	uint32_t ip[ODPH_IPLOOKUP_TABLE_MULTI_MAX];
+	uint32_t e[ODPH_IPLOOKUP_TABLE_MULTI_MAX];
+	uint64_t hits = 0;
+	int i, num_hit = 0;
+
+	if (tbl == NULL || key == NULL || buffer == NULL || num < 0 ||
+	    num > ODPH_IPLOOKUP_TABLE_MULTI_MAX)
+		return -EINVAL;
+
+	/* Stage 1: prefetch first level entries */
+	for (i = 0; i < num; i++) {
+		ip[i] = *((uint32_t *)key[i]);
+		odp_prefetch(&impl->l1[ip[i] >> 8]);
 	}
 
-	ip <<= 16;
-	while (entry->child) {
-		entry = (prefix_entry_t *)entry->ptr;
-		entry += ip >> 24;
-		ip <<= 8;
+	/* Stage 2: read first level entries, prefetch group entries */
+	for (i = 0; i < num; i++) {
+		e[i] = odp_atomic_load_u32(&impl->l1[ip[i] >> 8]);
+
+		if (e[i] & ENTRY_EXT)
+			odp_prefetch(&group_ptr(impl, entry_index(e[i]))[ip[i] &
+									 0xff]);
 	}
 
-	/* copy data */
-	if (entry->nexthop == ODP_BUFFER_INVALID) {
-		/* ONLY match the default prefix */
-		printf("only match the default prefix\n");
-		*buff = ODP_BUFFER_INVALID;
-	} else {
-		*buff = entry->nexthop;
+	/* Stage 3: read group entries, prefetch values */
+	for (i = 0; i < num; i++) {
+		if (e[i] & ENTRY_EXT)
+			e[i] = odp_atomic_load_u32(&group_ptr(impl,
+						   entry_index(e[i]))[ip[i] &
+								      0xff]);
+
+		if (e[i] & ENTRY_VALID)
+			odp_prefetch(&impl->value[entry_index(e[i])]);
 	}
 
-	return 0;
+	/* Stage 4: copy values */
+	for (i = 0; i < num; i++) {
+		value_copy(impl, e[i], buffer[i]);
+
+		if (e[i] & ENTRY_VALID) {
+			hits |= 1ull << i;
+			num_hit++;
+		}
+	}
+
+	if (hit_mask)
+		*hit_mask = hits;
+
+	return num_hit;
 }
 
-static int
-prefix_delete_lx(
-		odph_iplookup_table_impl *tbl, prefix_entry_t *l1e,
-		odp_buffer_t *buff, uint8_t cidr, uint8_t over_cidr,
-		odp_buffer_t over_nexthop, uint8_t level)
+int
+odph_iplookup_table_remove_value(odph_table_t tbl, void *key)
 {
-	uint8_t ret, flag = 1;
-	prefix_entry_t *e = l1e;
-	odp_buffer_t *b = buff;
-	uint32_t i = 0, limit = 1 << (level - cidr);
+	odph_iplookup_table_impl *impl = (void *)tbl;
+	odph_iplookup_prefix_t *prefix = (odph_iplookup_prefix_t *)key;
+	rule_key_t rule;
 
-	for (i = 0; i < limit; i++, e++, b++) {
-		if (e->child == 1) {
-			if (e->cidr > cidr) {
-				flag = 0;
-				continue;
-			}
+	if ((tbl == NULL) || (key == NULL))
+		return -EINVAL;
 
-			prefix_entry_t *ne = (prefix_entry_t *)e->ptr;
-			odp_buffer_t *nbuff = ENTRY_BUFF_ARR(ne);
-
-			e->cidr = over_cidr;
-			ret = prefix_delete_lx(
-					tbl, ne, nbuff, cidr, over_cidr,
-					over_nexthop, cidr + 8);
-
-			/* If ret == 1, the next 2^8 entries equal to
-			 * (over_cidr, over_nexthop). In this case, we
-			 * should not push the (over_cidr, over_nexthop)
-			 * to the next level. In fact, we should recycle
-			 * the next 2^8 entries.
-			 */
-			if (ret) {
-				/* destroy subtree */
-				cache_init_buffer(
-					*b, CACHE_TYPE_SUBTREE,
-					ENTRY_SIZE * ENTRY_NUM_SUBTREE);
-				odp_queue_enq(
-					tbl->free_slots[CACHE_TYPE_SUBTREE],
-					odp_buffer_to_event(*b));
-				e->child = 0;
-				e->nexthop = over_nexthop;
-			} else {
-				flag = 0;
-			}
-		} else {
-			if (e->cidr > cidr) {
-				flag = 0;
-				continue;
-			} else {
-				e->cidr = over_cidr;
-				e->nexthop = over_nexthop;
-			}
-		}
+	if (prefix->cidr == 0 || prefix->cidr > 32)
+		return -EINVAL;
+
+	ipv4_rule_key(&rule, prefix->ip, prefix->cidr);
+
+	return lpm_remove_multi(impl, &rule, 1, 1) ? 0 : -1;
+}
+
+int odph_iplookup_table_remove_value_multi(odph_table_t tbl, void *key[],
+					   int num, uint64_t *hit_mask)
+{
+	odph_iplookup_table_impl *impl = (void *)tbl;
+	rule_key_t rule[ODPH_IPLOOKUP_TABLE_MULTI_MAX];
+	odph_iplookup_prefix_t *prefix;
+	uint64_t valid = 0, removed;
+	int i;
+
+	if (tbl == NULL || key == NULL || num < 0 ||
+	    num > ODPH_IPLOOKUP_TABLE_MULTI_MAX)
+		return -EINVAL;
+
+	for (i = 0; i < num; i++) {
+		prefix = key[i];
+		if (prefix->cidr == 0 || prefix->cidr > 32)
+			continue;
+
+		ipv4_rule_key(&rule[i], prefix->ip, prefix->cidr);
+		valid |= 1ULL << i;
 	}
-	return flag;
+
+	removed = lpm_remove_multi(impl, rule, valid, num);
+
+	if (hit_mask)
+		*hit_mask = removed;
+
+	return __builtin_popcountll(removed);
 }
 
-/* Check if the entry can be recycled.
- * An entry can be recycled duo to two reasons:
- * - all children of the entry are the same,
- * - all children of the entry have a cidr smaller than the level
- *   bottom bound.
- */
-static uint8_t
-can_recycle(prefix_entry_t *e, uint32_t level)
+odph_table_ops_t odph_iplookup_table_ops = {
+	odph_iplookup_table_create,
+	odph_iplookup_table_lookup,
+	odph_iplookup_table_destroy,
+	odph_iplookup_table_put_value,
+	odph_iplookup_table_get_value,
+	odph_iplookup_table_remove_value,
+	odph_iplookup_table_put_value_multi,
+	odph_iplookup_table_get_value_multi,
+	odph_iplookup_table_remove_value_multi
+};
+
+/***********************************************************
+ **************   IPv6 prefix lookup table   ***************
+ ***********************************************************/
+
+odph_table_t odph_iplookup6_table_lookup(const char *name)
 {
-	uint8_t recycle = 1;
-	int i = 1;
-	prefix_entry_t *ne = (prefix_entry_t *)e->ptr;
+	return (odph_table_t)table_lookup(name,
+					  ODPH_IP6_LOOKUP_TABLE_MAGIC_WORD);
+}
 
-	if (ne->child)
-		return 0;
+odph_table_t odph_iplookup6_table_create(const char *name,
+					 uint32_t max_routes,
+					 uint32_t max_groups,
+					 uint32_t value_size)
+{
+	if (max_routes == 0)
+		max_routes = IPV6_DEFAULT_ROUTES;
+	if (max_groups == 0)
+		max_groups = IPV6_DEFAULT_GROUPS;
 
-	uint8_t cidr = ne->cidr;
-	odp_buffer_t index = ne->nexthop;
+	return table_create(name, ODPH_IP6_LOOKUP_TABLE_MAGIC_WORD, 128,
+			    IPV6_L1_BITS, max_routes, max_groups, value_size);
+}
 
-	if (cidr > level)
-		return 0;
+int odph_iplookup6_table_destroy(odph_table_t tbl)
+{
+	return table_destroy(tbl, ODPH_IP6_LOOKUP_TABLE_MAGIC_WORD);
+}
+
+static void ipv6_rule_key(rule_key_t *key, const odph_iplookup6_prefix_t *p)
+{
+	memset(key, 0, sizeof(rule_key_t));
+	memcpy(key->ip, p->ip, sizeof(key->ip));
+	key->cidr = p->cidr;
+	prefix_mask(key->ip, sizeof(key->ip), p->cidr);
+}
+
+int odph_iplookup6_table_put_value(odph_table_t tbl, void *key, void *value)
+{
+	odph_iplookup_table_impl *impl = (void *)tbl;
+	odph_iplookup6_prefix_t *prefix = (odph_iplookup6_prefix_t *)key;
+	rule_key_t rule;
+
+	if ((tbl == NULL) || (key == NULL) || (value == NULL))
+		return -1;
 
-	ne++;
-	for (; i < 256; i++, ne++) {
-		if (
-				ne->child != 0 || ne->cidr != cidr ||
-				ne->nexthop != index) {
-			recycle = 0;
+	if (prefix->cidr == 0 || prefix->cidr > 128)
+		return -1;
+
+	ipv6_rule_key(&rule, prefix);
+
+	return lpm_put_multi(impl, &rule, &value, 1) == 1 ? 0 : -1;
+}
+
+int odph_iplookup6_table_put_value_multi(odph_table_t tbl, void *key[],
+					 void *value[], int num)
+{
+	odph_iplookup_table_impl *impl = (void *)tbl;
+	rule_key_t rule[ODPH_IPLOOKUP_TABLE_MULTI_MAX] = { 0 };
+	odph_iplookup6_prefix_t *prefix;
+	int i, ret;
+
+	if (tbl == NULL || key == NULL || value == NULL || num < 0 ||
+	    num > ODPH_IPLOOKUP_TABLE_MULTI_MAX)
+		return -1;
+
+	/* Prefixes up to the first invalid one are added */
+	for (i = 0; i < num; i++) {
+		prefix = key[i];
+		if (value[i] == NULL || prefix->cidr == 0 ||
+		    prefix->cidr > 128)
 			break;
+
+		ipv6_rule_key(&rule[i], prefix);
+	}
+
+	ret = lpm_put_multi(impl, rule, value, i);
+
+	if (ret == 0 && num > 0)
+		return -1;
+
+	return ret;
+}
+
+static inline uint32_t ipv6_lookup(odph_iplookup_table_impl *tbl,
+				   const uint8_t ip[])
+{
+	uint32_t e = odp_atomic_load_u32(&tbl->l1[(ip[0] << 8) | ip[1]]);
+	int byte = 2;
+
+	/* Prefixes are at most 128 bits, so groups end at the last byte */
+	while (e & ENTRY_EXT) {
+		e = odp_atomic_load_u32(&group_ptr(tbl,
+						   entry_index(e))[ip[byte]]);
+		byte++;
+	}
+
+	return e;
+}
+
+int odph_iplookup6_table_get_value(odph_table_t tbl, void *key,
+				   void *buffer,
+				   uint32_t buffer_size ODP_UNUSED)
+{
+	odph_iplookup_table_impl *impl = (void *)tbl;
+
+	if ((tbl == NULL) || (key == NULL) || (buffer == NULL))
+		return -EINVAL;
+
+	value_copy(impl, ipv6_lookup(impl, key), buffer);
+
+	return 0;
+}
+
+int odph_iplookup6_table_get_value_multi(odph_table_t tbl, void *key[],
+					 void *buffer[],
+					 uint32_t buffer_size ODP_UNUSED,
+					 int num, uint64_t *hit_mask)
+{
+	odph_iplookup_table_impl *impl = (void *)tbl;
+	uint32_t e[ODPH_IPLOOKUP_TABLE_MULTI_MAX];
+	uint8_t ext[ODPH_IPLOOKUP_TABLE_MULTI_MAX];
+	const uint8_t *ip;
+	uint64_t hits = 0;
+	int i, num_ext, num_hit = 0;
+	int byte = 2;
+
+	if (tbl == NULL || key == NULL || buffer == NULL || num < 0 ||
+	    num > ODPH_IPLOOKUP_TABLE_MULTI_MAX)
+		return -EINVAL;
+
+	for (i = 0; i < num; i++) {
+		ip = key[i];
+		odp_prefetch(&impl->l1[(ip[0] << 8) | ip[1]]);
+	}
+
+	num_ext = 0;
+	for (i = 0; i < num; i++) {
+		ip = key[i];
+		e[i] = odp_atomic_load_u32(&impl->l1[(ip[0] << 8) | ip[1]]);
+
+		if (e[i] & ENTRY_EXT) {
+			ext[num_ext++] = i;
+			odp_prefetch(&group_ptr(impl,
+						entry_index(e[i]))[ip[byte]]);
 		}
 	}
-	return recycle;
-}
-
-static uint8_t
-prefix_delete_iter(
-		odph_iplookup_table_impl *tbl, prefix_entry_t *e,
-		odp_buffer_t *buff, uint32_t ip, uint8_t cidr,
-		uint8_t level, uint8_t depth)
-{
-	uint8_t ret = 0, over_cidr;
-	odp_buffer_t over_nexthop;
-
-	trie_detect_overlap(
-			tbl->trie, ip, cidr + 8 * depth, level,
-			&over_cidr, &over_nexthop);
-	if (cidr > 8) {
-		prefix_entry_t *ne =
-			(prefix_entry_t *)e->ptr;
-		odp_buffer_t *nbuff = ENTRY_BUFF_ARR(ne);
-
-		ne += ((uint32_t)(ip << level) >> 24);
-		nbuff += ((uint32_t)(ip << level) >> 24);
-		ret = prefix_delete_iter(
-				tbl, ne, nbuff, ip, cidr - 8,
-				level + 8, depth + 1);
-
-		if (ret && can_recycle(e, level)) {
-			/* destroy subtree */
-			cache_init_buffer(
-				*buff, CACHE_TYPE_SUBTREE,
-				ENTRY_SIZE * ENTRY_NUM_SUBTREE);
-			odp_queue_enq(
-				tbl->free_slots[CACHE_TYPE_SUBTREE],
-				odp_buffer_to_event(*buff));
-			e->child = 0;
-			e->nexthop = over_nexthop;
-			e->cidr = over_cidr;
-			return 1;
+
+	/* Walk down the levels with all addresses that still point to
+	 * a group. Entries of the next level are prefetched before reading
+	 * any of them. */
+	while (num_ext) {
+		int n = 0;
+
+		for (i = 0; i < num_ext; i++) {
+			int k = ext[i];
+
+			ip = key[k];
+			e[k] = odp_atomic_load_u32(&group_ptr(impl,
+						   entry_index(e[k]))[ip[byte]]);
+
+			if (e[k] & ENTRY_EXT) {
+				ext[n++] = k;
+				odp_prefetch(&group_ptr(impl, entry_index(e[k]))
+					     [ip[byte + 1]]);
+			}
 		}
-		return 0;
+
+		num_ext = n;
+		byte++;
 	}
 
-	ret = prefix_delete_lx(
-			tbl, e, buff, cidr + 8 * depth,
-			over_cidr, over_nexthop, level);
-	return ret;
+	for (i = 0; i < num; i++) {
+		if (e[i] & ENTRY_VALID)
+			odp_prefetch(&impl->value[entry_index(e[i])]);
+	}
+
+	for (i = 0; i < num; i++) {
+		value_copy(impl, e[i], buffer[i]);
+
+		if (e[i] & ENTRY_VALID) {
+			hits |= 1ull << i;
+			num_hit++;
+		}
+	}
+
+	if (hit_mask)
+		*hit_mask = hits;
+
+	return num_hit;
 }
 
-int
-odph_iplookup_table_remove_value(odph_table_t tbl, void *key)
+int odph_iplookup6_table_remove_value(odph_table_t tbl, void *key)
 {
 	odph_iplookup_table_impl *impl = (void *)tbl;
-	odph_iplookup_prefix_t *prefix = (odph_iplookup_prefix_t *)key;
-	uint32_t ip;
-	uint8_t cidr;
+	odph_iplookup6_prefix_t *prefix = (odph_iplookup6_prefix_t *)key;
+	rule_key_t rule;
 
 	if ((tbl == NULL) || (key == NULL))
 		return -EINVAL;
 
-	ip   = prefix->ip;
-	cidr = prefix->cidr;
+	if (prefix->cidr == 0 || prefix->cidr > 128)
+		return -EINVAL;
+
+	ipv6_rule_key(&rule, prefix);
+
+	return lpm_remove_multi(impl, &rule, 1, 1) ? 0 : -1;
+}
+
+int odph_iplookup6_table_remove_value_multi(odph_table_t tbl, void *key[],
+					    int num, uint64_t *hit_mask)
+{
+	odph_iplookup_table_impl *impl = (void *)tbl;
+	rule_key_t rule[ODPH_IPLOOKUP_TABLE_MULTI_MAX];
+	odph_iplookup6_prefix_t *prefix;
+	uint64_t valid = 0, removed;
+	int i;
 
-	if (cidr == 0 || cidr > 32)
+	if (tbl == NULL || key == NULL || num < 0 ||
+	    num > ODPH_IPLOOKUP_TABLE_MULTI_MAX)
 		return -EINVAL;
 
-	prefix_entry_t *entry = &impl->l1e[ip >> 16];
-	odp_buffer_t *buff = ENTRY_BUFF_ARR(impl->l1e) + (ip >> 16);
-	uint8_t over_cidr, ret;
-	odp_buffer_t over_nexthop;
-
-	trie_detect_overlap(
-			impl->trie, ip, cidr, 16, &over_cidr, &over_nexthop);
-
-	if (cidr <= 16) {
-		prefix_delete_lx(
-			impl, entry, buff, cidr, over_cidr, over_nexthop, 16);
-	} else {
-		prefix_entry_t *ne = (prefix_entry_t *)entry->ptr;
-		odp_buffer_t *nbuff = ENTRY_BUFF_ARR(ne);
-
-		ne += ((uint32_t)(ip << 16) >> 24);
-		nbuff += ((uint32_t)(ip << 16) >> 24);
-		ret = prefix_delete_iter(impl, ne, nbuff, ip, cidr - 16, 24, 2);
-
-		if (ret && can_recycle(entry, 16)) {
-			/* destroy subtree */
-			cache_init_buffer(
-				*buff, CACHE_TYPE_SUBTREE,
-				sizeof(prefix_entry_t) * ENTRY_NUM_SUBTREE);
-			odp_queue_enq(
-				impl->free_slots[CACHE_TYPE_SUBTREE],
-				odp_buffer_to_event(*buff));
-			entry->child = 0;
-			entry->cidr = over_cidr;
-			entry->nexthop = over_nexthop;
-		}
+	for (i = 0; i < num; i++) {
+		prefix = key[i];
+		if (prefix->cidr == 0 || prefix->cidr > 128)
+			continue;
+
+		ipv6_rule_key(&rule[i], prefix);
+		valid |= 1ULL << i;
 	}
 
-	return trie_delete_node(impl, impl->trie, ip, cidr);
+	removed = lpm_remove_multi(impl, rule, valid, num);
+
+	if (hit_mask)
+		*hit_mask = removed;
+
+	return __builtin_popcountll(removed);
 }
 
-odph_table_ops_t odph_iplookup_table_ops = {
-	odph_iplookup_table_create,
-	odph_iplookup_table_lookup,
-	odph_iplookup_table_destroy,
-	odph_iplookup_table_put_value,
-	odph_iplookup_table_get_value,
-	odph_iplookup_table_remove_value
+odph_table_ops_t odph_iplookup6_table_ops = {
+	odph_iplookup6_table_create,
+	odph_iplookup6_table_lookup,
+	odph_iplookup6_table_destroy,
+	odph_iplookup6_table_put_value,
+	odph_iplookup6_table_get_value,
+	odph_iplookup6_table_remove_value,
+	odph_iplookup6_table_put_value_multi,
+	odph_iplookup6_table_get_value_multi,
+	odph_iplookup6_table_remove_value_multi
 };
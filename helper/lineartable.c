@@ -147,8 +147,7 @@ odph_table_t odph_linear_table_lookup(const char *name)
 }
 
 /* should make sure the input table exists and is available */
-static int odph_lineartable_put_value(odph_table_t table,
-				      void *key, void *value)
+int odph_linear_put_value(odph_table_t table, void *key, void *value)
 {
 	odph_linear_table_imp *tbl;
 	uint32_t ikey = 0;
@@ -177,9 +176,8 @@ static int odph_lineartable_put_value(odph_table_t table,
 }
 
 /* should make sure the input table exists and is available */
-static int odph_lineartable_get_value(odph_table_t table,
-				      void *key, void *buffer,
-				      uint32_t buffer_size ODP_UNUSED)
+int odph_linear_get_value(odph_table_t table, void *key, void *buffer,
+			  uint32_t buffer_size ODP_UNUSED)
 {
 	odph_linear_table_imp *tbl;
 	uint32_t ikey = 0;
@@ -207,12 +205,88 @@ static int odph_lineartable_get_value(odph_table_t table,
 	return ODPH_SUCCESS;
 }
 
+int odph_linear_put_value_multi(odph_table_t table, void *key[],
+				void *value[], int num)
+{
+	int i;
+
+	if (table == NULL || key == NULL || value == NULL || num < 0 ||
+	    num > ODPH_TABLE_MULTI_MAX)
+		return ODPH_FAIL;
+
+	for (i = 0; i < num; i++) {
+		if (odph_linear_put_value(table, key[i], value[i]))
+			break;
+	}
+
+	if (i == 0 && num > 0)
+		return ODPH_FAIL;
+
+	return i;
+}
+
+/* should make sure the input table exists and is available */
+int odph_linear_get_value_multi(odph_table_t table, void *key[],
+				void *buffer[], uint32_t buffer_size ODP_UNUSED,
+				int num, uint64_t *hit_mask)
+{
+	odph_linear_table_imp *tbl;
+	void *entry[ODPH_TABLE_MULTI_MAX];
+	uint32_t ikey;
+	uint64_t hits = 0;
+	odp_rwlock_t *lock;
+	int i, num_hit = 0;
+
+	if (table == NULL || key == NULL || buffer == NULL || num < 0 ||
+	    num > ODPH_TABLE_MULTI_MAX)
+		return ODPH_FAIL;
+
+	tbl = (odph_linear_table_imp *)(void *)table;
+
+	/* Prefetch all entries before reading any of them */
+	for (i = 0; i < num; i++) {
+		ikey = *(uint32_t *)key[i];
+		entry[i] = NULL;
+		if (ikey >= tbl->node_sum)
+			continue;
+
+		entry[i] = (void *)((char *)tbl->value_array +
+				    ikey * tbl->value_size);
+		odp_prefetch(entry[i]);
+	}
+
+	for (i = 0; i < num; i++) {
+		if (entry[i] == NULL)
+			continue;
+
+		lock = (odp_rwlock_t *)entry[i];
+
+		odp_rwlock_read_lock(lock);
+
+		memcpy(buffer[i], (char *)entry[i] + sizeof(odp_rwlock_t),
+		       tbl->value_size - sizeof(odp_rwlock_t));
+
+		odp_rwlock_read_unlock(lock);
+
+		hits |= 1ULL << i;
+		num_hit++;
+	}
+
+	if (hit_mask)
+		*hit_mask = hits;
+
+	return num_hit;
+}
+
 odph_table_ops_t odph_linear_table_ops = {
 	odph_linear_table_create,
 	odph_linear_table_lookup,
 	odph_linear_table_destroy,
-	odph_lineartable_put_value,
-	odph_lineartable_get_value,
+	odph_linear_put_value,
+	odph_linear_get_value,
+	NULL,
+	odph_linear_put_value_multi,
+	odph_linear_get_value_multi,
 	NULL,
 	};
 
@@ -7,6 +7,19 @@
 #include <odp_api.h>
 #include <odp/helper/odph_api.h>
 
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define CONNECT_RETRIES 10
+
 static int cli_server(void *arg ODP_UNUSED)
 {
 	if (odph_cli_run()) {
@@ -17,6 +30,142 @@ static int cli_server(void *arg ODP_UNUSED)
 	return 0;
 }
 
+/* Connect to the statistics server. The server thread may not be listening
+ * yet, so retry for a while. */
+static int stats_connect(const char *address, uint16_t port)
+{
+	struct sockaddr_in addr;
+	struct timeval tv = { .tv_sec = 1, .tv_usec = 0 };
+	int fd, i;
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_port = htons(port);
+
+	if (inet_pton(AF_INET, address, &addr.sin_addr) != 1)
+		return -1;
+
+	for (i = 0; i < CONNECT_RETRIES; i++) {
+		fd = socket(AF_INET, SOCK_STREAM, 0);
+		if (fd < 0)
+			return -1;
+
+		if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) == 0) {
+			setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+			return fd;
+		}
+
+		close(fd);
+		odp_time_wait_ns(ODP_TIME_SEC_IN_NS / 10);
+	}
+
+	return -1;
+}
+
+/* Send a request line and receive a response line. Returns the length of the
+ * response, or -1 on failure. */
+static int stats_request(int fd, const char *req, char *buf, int size)
+{
+	int len = 0;
+	int req_len = strlen(req);
+
+	if (send(fd, req, req_len, 0) != req_len)
+		return -1;
+
+	while (len < size - 1) {
+		ssize_t num = recv(fd, buf + len, size - 1 - len, 0);
+
+		if (num <= 0)
+			return -1;
+
+		len += num;
+		buf[len] = 0;
+
+		if (buf[len - 1] == '\n')
+			return len;
+	}
+
+	return -1;
+}
+
+/* Read an unsigned integer member from the first JSON object that starts with
+ * 'obj'. Nested objects are not supported. */
+static int json_u64(const char *str, const char *obj, const char *name, uint64_t *val)
+{
+	char key[64];
+	const char *start, *end, *pos;
+	char *num_end;
+
+	start = strstr(str, obj);
+	if (start == NULL)
+		return -1;
+
+	end = strchr(start + strlen(obj), '}');
+	if (end == NULL)
+		return -1;
+
+	snprintf(key, sizeof(key), "\"%s\":", name);
+	pos = strstr(start, key);
+	if (pos == NULL || pos > end)
+		return -1;
+
+	pos += strlen(key);
+	*val = strtoull(pos, &num_end, 10);
+
+	return num_end == pos ? -1 : 0;
+}
+
+static int stats_test(const char *address, uint16_t port, uint64_t counter)
+{
+	char buf[4096];
+	uint64_t val;
+	int fd, len;
+	int ret = -1;
+
+	fd = stats_connect(address, port);
+	if (fd < 0) {
+		ODPH_ERR("Error: connecting to statistics server failed.\n");
+		return -1;
+	}
+
+	len = stats_request(fd, "stats\n", buf, sizeof(buf));
+	if (len < 0) {
+		ODPH_ERR("Error: no response to stats request.\n");
+		goto out;
+	}
+
+	if (buf[0] != '{' || len < 3 || buf[len - 2] != '}') {
+		ODPH_ERR("Error: response is not a JSON object: %s", buf);
+		goto out;
+	}
+
+	if (json_u64(buf, "{", "time_ns", &val) || val == 0) {
+		ODPH_ERR("Error: bad time_ns in response: %s", buf);
+		goto out;
+	}
+
+	if (json_u64(buf, "\"counters\":{", "counter", &val) || val != counter) {
+		ODPH_ERR("Error: bad thread counter in response: %s", buf);
+		goto out;
+	}
+
+	if (json_u64(buf, "\"total\":{", "counter", &val) || val != counter) {
+		ODPH_ERR("Error: bad total counter in response: %s", buf);
+		goto out;
+	}
+
+	len = stats_request(fd, "foo\n", buf, sizeof(buf));
+	if (len < 0 || strstr(buf, "\"error\":") == NULL) {
+		ODPH_ERR("Error: no error response to unknown request.\n");
+		goto out;
+	}
+
+	ret = 0;
+out:
+	close(fd);
+	return ret;
+}
+
 int main(int argc, char *argv[])
 {
 	odp_instance_t instance;
@@ -47,12 +196,27 @@ int main(int argc, char *argv[])
 	odph_cli_param_t cli_param;
 
 	odph_cli_param_init(&cli_param);
+	cli_param.stats_port = cli_param.port + 1;
 
 	if (odph_cli_init(&cli_param)) {
 		ODPH_ERR("Error: odph_cli_init() failed.\n");
 		exit(EXIT_FAILURE);
 	}
 
+	if (odph_cli_stats_register("counter") != 0) {
+		ODPH_ERR("Error: odph_cli_stats_register() failed.\n");
+		exit(EXIT_FAILURE);
+	}
+
+	if (odph_cli_stats_register("bad name") >= 0) {
+		ODPH_ERR("Error: odph_cli_stats_register() accepted a bad name.\n");
+		exit(EXIT_FAILURE);
+	}
+
+	uint64_t counter = 1;
+
+	odph_cli_stats_publish(&counter, 1);
+
 	odp_cpumask_t cpumask;
 	odph_thread_common_param_t thr_common;
 	odph_thread_param_t thr_param;
@@ -83,6 +247,11 @@ int main(int argc, char *argv[])
 	 */
 	odp_time_wait_ns(ODP_TIME_SEC_IN_NS / 10);
 
+	if (stats_test(cli_param.address, cli_param.stats_port, counter)) {
+		ODPH_ERR("Error: statistics server test failed.\n");
+		exit(EXIT_FAILURE);
+	}
+
 	if (odph_cli_stop()) {
 		ODPH_ERR("Error: odph_cli_stop() failed.\n");
 		exit(EXIT_FAILURE);
@@ -39,6 +39,7 @@
 
 #include <stdio.h>
 #include <stdint.h>
+#include <inttypes.h>
 #include <string.h>
 #include <stdlib.h>
 #include <stdarg.h>
@@ -389,6 +390,294 @@ static int test_five_keys(void)
 	return 0;
 }
 
+/*
+ * Bulk lookup of 5 keys, when 3 keys have been inserted
+ *	- put keys 0-2 with values
+ *	- get all keys: hit 0-2, miss 3-4
+ *	- check values
+ */
+static int test_multi_lookup(void)
+{
+	odph_table_t table;
+	uint32_t val[5];
+	void *key_ptr[5];
+	void *val_ptr[5];
+	uint64_t hit_mask = 0;
+	unsigned i;
+	int ret;
+
+	table = odph_cuckoo_table_create(
+			"multi_lookup", 10, sizeof(struct flow_key),
+			sizeof(uint32_t));
+	if (table == NULL) {
+		printf("failed to create table\n");
+		return -1;
+	}
+
+	for (i = 0; i < 5; i++) {
+		val[i] = 100 + i;
+		key_ptr[i] = &keys[i];
+		val_ptr[i] = &val[i];
+	}
+
+	ret = odph_cuckoo_table_ops.f_put_multi(table, key_ptr, val_ptr, 3);
+	if (ret != 3) {
+		printf("failed to add keys: %i\n", ret);
+		odph_cuckoo_table_destroy(table);
+		return -1;
+	}
+
+	for (i = 0; i < 5; i++)
+		val[i] = 0;
+
+	ret = odph_cuckoo_table_get_value_multi(table, key_ptr, val_ptr,
+						sizeof(uint32_t), 5, &hit_mask);
+	if (ret != 3 || hit_mask != 0x7) {
+		printf("bad bulk lookup result: %i hits, mask 0x%" PRIx64 "\n",
+		       ret, hit_mask);
+		odph_cuckoo_table_destroy(table);
+		return -1;
+	}
+
+	for (i = 0; i < 3; i++) {
+		if (val[i] != 100 + i) {
+			printf("bad value %u for key %u\n", val[i], i);
+			odph_cuckoo_table_destroy(table);
+			return -1;
+		}
+	}
+
+	/* Remove keys 1 ... 4, of which 1 and 2 exist */
+	ret = odph_cuckoo_table_ops.f_remove_multi(table, &key_ptr[1], 4,
+						   &hit_mask);
+	if (ret != 2 || hit_mask != 0x3) {
+		printf("bad bulk remove result: %i removed, mask 0x%" PRIx64
+		       "\n", ret, hit_mask);
+		odph_cuckoo_table_destroy(table);
+		return -1;
+	}
+
+	ret = odph_cuckoo_table_get_value_multi(table, key_ptr, val_ptr,
+						sizeof(uint32_t), 5, &hit_mask);
+	if (ret != 1 || hit_mask != 0x1) {
+		printf("bad bulk lookup result after remove: %i hits, mask 0x%"
+		       PRIx64 "\n", ret, hit_mask);
+		odph_cuckoo_table_destroy(table);
+		return -1;
+	}
+
+	odph_cuckoo_table_destroy(table);
+	return 0;
+}
+
+#define MT_STABLE_KEYS 256
+#define MT_CHURN_KEYS  1024
+#define MT_ROUNDS      200
+
+/* State shared between the writer and the reader thread */
+static struct {
+	odph_table_t table;
+	odp_atomic_u32_t ready;
+	odp_atomic_u32_t stop;
+	odp_atomic_u64_t lookups;
+	odp_atomic_u64_t errors;
+} mt;
+
+static void mt_key(struct flow_key *key, uint32_t i)
+{
+	memset(key, 0, sizeof(*key));
+	key->ip_src = 0x0a000000 + i;
+	key->ip_dst = 0xc0a80000 + (i * 7);
+	key->port_src = i;
+	key->port_dst = 80;
+	key->proto = 17;
+}
+
+static uint32_t mt_value(uint32_t i)
+{
+	return 3 * i + 1;
+}
+
+/*
+ * Reader thread: stable keys must always be found with the correct value.
+ * Keys that the writer puts and removes may be missed, but a hit must
+ * return the value of that key.
+ */
+static int mt_reader(void *arg ODP_UNUSED)
+{
+	struct flow_key key[ODPH_CUCKOO_TABLE_MULTI_MAX];
+	uint32_t val[ODPH_CUCKOO_TABLE_MULTI_MAX];
+	void *key_ptr[ODPH_CUCKOO_TABLE_MULTI_MAX];
+	void *val_ptr[ODPH_CUCKOO_TABLE_MULTI_MAX];
+	uint64_t hit_mask, lookups = 0, errors = 0;
+	uint32_t i, j, num;
+	int ret;
+
+	for (j = 0; j < ODPH_CUCKOO_TABLE_MULTI_MAX; j++) {
+		key_ptr[j] = &key[j];
+		val_ptr[j] = &val[j];
+	}
+
+	odp_atomic_store_u32(&mt.ready, 1);
+
+	while (!odp_atomic_load_u32(&mt.stop)) {
+		/* Single key lookups of all keys */
+		for (i = 0; i < MT_STABLE_KEYS + MT_CHURN_KEYS; i++) {
+			mt_key(&key[0], i);
+			val[0] = 0;
+			ret = odph_cuckoo_table_get_value(mt.table, &key[0], &val[0],
+							  sizeof(uint32_t));
+			lookups++;
+
+			if (ret < 0) {
+				if (i < MT_STABLE_KEYS)
+					errors++;
+			} else if (val[0] != mt_value(i)) {
+				errors++;
+			}
+		}
+
+		/* Bulk lookups of stable keys */
+		for (i = 0; i < MT_STABLE_KEYS; i += num) {
+			num = MT_STABLE_KEYS - i;
+			if (num > ODPH_CUCKOO_TABLE_MULTI_MAX)
+				num = ODPH_CUCKOO_TABLE_MULTI_MAX;
+
+			for (j = 0; j < num; j++) {
+				mt_key(&key[j], i + j);
+				val[j] = 0;
+			}
+
+			ret = odph_cuckoo_table_get_value_multi(mt.table, key_ptr, val_ptr,
+								sizeof(uint32_t), num,
+								&hit_mask);
+			lookups += num;
+
+			if (ret != (int)num)
+				errors++;
+
+			for (j = 0; j < num; j++) {
+				if (val[j] != mt_value(i + j))
+					errors++;
+			}
+		}
+	}
+
+	odp_atomic_add_u64(&mt.lookups, lookups);
+	odp_atomic_add_u64(&mt.errors, errors);
+
+	return 0;
+}
+
+/*
+ * Concurrent reader and writer
+ *	- put stable keys
+ *	- start a reader thread, which looks up all keys continuously
+ *	- put and remove churn keys repeatedly, which also moves stable keys
+ *	  between their buckets
+ *	- check that the reader did not find wrong values or miss stable keys
+ */
+static int test_concurrent(odp_instance_t instance)
+{
+	odp_cpumask_t cpumask;
+	odph_thread_common_param_t thr_common;
+	odph_thread_param_t thr_param;
+	odph_thread_t thr_reader;
+	struct flow_key key;
+	uint32_t i, val, rnd;
+	int ret = 0;
+
+	/* Churn keys do not all fit, which keeps the table full and forces
+	 * entries to move between buckets */
+	mt.table = odph_cuckoo_table_create("concurrent", 2 * MT_STABLE_KEYS,
+					    sizeof(struct flow_key),
+					    sizeof(uint32_t));
+	if (mt.table == NULL) {
+		printf("failed to create table\n");
+		return -1;
+	}
+
+	odp_atomic_init_u32(&mt.ready, 0);
+	odp_atomic_init_u32(&mt.stop, 0);
+	odp_atomic_init_u64(&mt.lookups, 0);
+	odp_atomic_init_u64(&mt.errors, 0);
+
+	for (i = 0; i < MT_STABLE_KEYS; i++) {
+		mt_key(&key, i);
+		val = mt_value(i);
+		if (odph_cuckoo_table_put_value(mt.table, &key, &val) < 0) {
+			printf("failed to add key %u\n", i);
+			odph_cuckoo_table_destroy(mt.table);
+			return -1;
+		}
+	}
+
+	odp_cpumask_default_worker(&cpumask, 1);
+
+	odph_thread_common_param_init(&thr_common);
+	thr_common.instance = instance;
+	thr_common.cpumask = &cpumask;
+
+	odph_thread_param_init(&thr_param);
+	thr_param.start = mt_reader;
+	thr_param.thr_type = ODP_THREAD_WORKER;
+
+	memset(&thr_reader, 0, sizeof(thr_reader));
+
+	if (odph_thread_create(&thr_reader, &thr_common, &thr_param, 1) != 1) {
+		printf("failed to create reader thread\n");
+		odph_cuckoo_table_destroy(mt.table);
+		return -1;
+	}
+
+	while (!odp_atomic_load_u32(&mt.ready))
+		odp_cpu_pause();
+
+	for (rnd = 0; rnd < MT_ROUNDS && ret == 0; rnd++) {
+		for (i = MT_STABLE_KEYS; i < MT_STABLE_KEYS + MT_CHURN_KEYS; i++) {
+			mt_key(&key, i);
+			val = mt_value(i);
+
+			/* Table may be full, which is not an error */
+			odph_cuckoo_table_put_value(mt.table, &key, &val);
+		}
+
+		for (i = MT_STABLE_KEYS; i < MT_STABLE_KEYS + MT_CHURN_KEYS; i++) {
+			mt_key(&key, i);
+			odph_cuckoo_table_remove_value(mt.table, &key);
+		}
+
+		/* Stable keys must not be lost by the writer either */
+		for (i = 0; i < MT_STABLE_KEYS; i++) {
+			mt_key(&key, i);
+			if (odph_cuckoo_table_get_value(mt.table, &key, &val,
+							sizeof(uint32_t)) < 0 ||
+			    val != mt_value(i)) {
+				printf("stable key %u lost in round %u\n", i, rnd);
+				ret = -1;
+				break;
+			}
+		}
+	}
+
+	odp_atomic_store_u32(&mt.stop, 1);
+
+	if (odph_thread_join(&thr_reader, 1) != 1) {
+		printf("failed to join reader thread\n");
+		ret = -1;
+	}
+
+	if (odp_atomic_load_u64(&mt.errors)) {
+		printf("reader found %" PRIu64 " inconsistent results in %"
+		       PRIu64 " lookups\n", odp_atomic_load_u64(&mt.errors),
+		       odp_atomic_load_u64(&mt.lookups));
+		ret = -1;
+	}
+
+	odph_cuckoo_table_destroy(mt.table);
+	return ret;
+}
+
 #define BUCKET_ENTRIES 4
 #define HASH_ENTRIES_MAX 1048576
 /*
@@ -427,35 +716,42 @@ static int test_creation_with_bad_parameters(void)
 }
 
 #define PERFORMANCE_CAPACITY 4000
+/* Default number of keys in percents of the capacity */
+#define PERFORMANCE_LOAD_PCT 95
+#define PERFORMANCE_ROUNDS   10
+#define PERFORMANCE_BURST    32
 
 /*
  * Test the performance of cuckoo hash table.
- *   table capacity : 1,000,000
+ *   table capacity : 'capacity' (default 4000)
  *   key size : 4 bytes
  *   value size : 0
  * Insert at most number random keys into the table. If one
  * insertion is failed, the rest insertions will be cancelled.
  * The table utilization of the report will show actual number
  * of items inserted.
- * Then search all inserted items.
+ * Then search all inserted items one by one, and in bursts of
+ * PERFORMANCE_BURST keys.
  */
-static int test_performance(int number)
+static int test_performance(int number, unsigned capacity)
 {
 	odph_table_t table;
 
 	/* generate random keys */
 	uint8_t *key_space = NULL;
-	const void **key_ptr = NULL;
-	unsigned key_len = 4, j;
-	unsigned elem_num = (number > PERFORMANCE_CAPACITY) ?
-						PERFORMANCE_CAPACITY : number;
+	void **key_ptr = NULL;
+	unsigned key_len = 4, j, r;
+	unsigned elem_num = ((unsigned)number > capacity) ?
+						capacity : (unsigned)number;
 	unsigned key_num = key_len * elem_num;
+	uint64_t hits;
+	double time;
 
 	key_space = (uint8_t *)malloc(key_num);
 	if (key_space == NULL)
 		return -ENOENT;
 
-	key_ptr = (const void **)malloc(sizeof(void *) * elem_num);
+	key_ptr = (void **)malloc(sizeof(void *) * elem_num);
 	if (key_ptr == NULL) {
 		free(key_space);
 		return -ENOENT;
@@ -474,7 +770,7 @@ static int test_performance(int number)
 
 	fflush(stdout);
 	table = odph_cuckoo_table_create(
-			"performance_test", PERFORMANCE_CAPACITY, key_len, 0);
+			"performance_test", capacity, key_len, 0);
 	if (table == NULL) {
 		printf("cuckoo table creation failed\n");
 		free(key_ptr);
@@ -495,22 +791,46 @@ static int test_performance(int number)
 	add_time = get_time_diff(&start, &end);
 	printf(
 		"add %u/%u (%.2f) items, time = %.9lfs\n",
-		num, PERFORMANCE_CAPACITY,
-		(double)num / PERFORMANCE_CAPACITY, add_time);
+		num, capacity, (double)num / capacity, add_time);
 
 	/* search (get) */
+	ret = 0;
 	gettimeofday(&start, 0);
-	for (j = 0; j < num; j++) {
-		ret = odph_cuckoo_table_get_value(
-				table, &key_space[j * key_len], NULL, 0);
+	for (r = 0; r < PERFORMANCE_ROUNDS; r++) {
+		for (j = 0; j < num; j++) {
+			if (odph_cuckoo_table_get_value(
+					table, &key_space[j * key_len], NULL, 0) < 0)
+				ret = -1;
+		}
+	}
+	gettimeofday(&end, 0);
+	time = get_time_diff(&start, &end);
+	if (ret < 0)
+		printf("lookup error\n");
+	printf(
+			"lookup %u items, time = %.9lfs, %.2f M lookups/s\n",
+			num, time / PERFORMANCE_ROUNDS,
+			(double)num * PERFORMANCE_ROUNDS / time / 1000000);
 
-		if (ret < 0)
-			printf("lookup error\n");
+	/* bulk search (get multi) */
+	gettimeofday(&start, 0);
+	for (r = 0; r < PERFORMANCE_ROUNDS; r++) {
+		for (j = 0; j + PERFORMANCE_BURST <= num; j += PERFORMANCE_BURST) {
+			if (odph_cuckoo_table_get_value_multi(
+					table, &key_ptr[j], NULL, 0,
+					PERFORMANCE_BURST, &hits) != PERFORMANCE_BURST)
+				ret = -1;
+		}
 	}
 	gettimeofday(&end, 0);
+	time = get_time_diff(&start, &end);
+	num = j;
+	if (ret < 0)
+		printf("bulk lookup error\n");
 	printf(
-			"lookup %u items, time = %.9lfs\n",
-			num, get_time_diff(&start, &end));
+			"bulk lookup %u items, time = %.9lfs, %.2f M lookups/s\n",
+			num, time / PERFORMANCE_ROUNDS,
+			(double)num * PERFORMANCE_ROUNDS / time / 1000000);
 
 	odph_cuckoo_table_destroy(table);
 	free(key_ptr);
@@ -522,7 +842,8 @@ static int test_performance(int number)
  * Do all unit and performance tests.
  */
 static int
-test_cuckoo_hash_table(void)
+test_cuckoo_hash_table(odp_instance_t instance, unsigned capacity,
+		       unsigned num_keys)
 {
 	if (test_put_remove() < 0)
 		return -1;
@@ -532,19 +853,40 @@ test_cuckoo_hash_table(void)
 		return -1;
 	if (test_five_keys() < 0)
 		return -1;
+	if (test_multi_lookup() < 0)
+		return -1;
+	if (test_concurrent(instance) < 0)
+		return -1;
 	if (test_creation_with_bad_parameters() < 0)
 		return -1;
-	if (test_performance(950000) < 0)
+	if (test_performance(num_keys, capacity) < 0)
 		return -1;
 
 	return 0;
 }
 
-int main(int argc ODP_UNUSED, char *argv[] ODP_UNUSED)
+/* Performance test table capacity and number of keys can be given as
+ * arguments, e.g. 'cuckootable 1000000 950000'. The number of keys
+ * defaults to PERFORMANCE_LOAD_PCT percent of the capacity. */
+int main(int argc, char *argv[])
 {
 	odp_instance_t instance;
+	unsigned capacity = PERFORMANCE_CAPACITY;
+	unsigned num_keys;
 	int ret = 0;
 
+	if (argc > 1)
+		capacity = atoi(argv[1]);
+
+	num_keys = (uint64_t)capacity * PERFORMANCE_LOAD_PCT / 100;
+	if (argc > 2)
+		num_keys = atoi(argv[2]);
+
+	if (capacity == 0 || num_keys == 0 || num_keys > INT32_MAX) {
+		fprintf(stderr, "Usage: %s [capacity [num_keys]]\n", argv[0]);
+		exit(EXIT_FAILURE);
+	}
+
 	ret = odp_init_global(&instance, NULL, NULL);
 	if (ret != 0) {
 		fprintf(stderr, "Error: ODP global init failed.\n");
@@ -558,7 +900,7 @@ int main(int argc ODP_UNUSED, char *argv[] ODP_UNUSED)
 	}
 
 	srand(time(0));
-	ret = test_cuckoo_hash_table();
+	ret = test_cuckoo_hash_table(instance, capacity, num_keys);
 
 	if (ret < 0)
 		printf("cuckoo hash table test fail!!\n");
@@ -0,0 +1,457 @@
+/* Copyright (c) 2022, Nokia
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier:     BSD-3-Clause
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdlib.h>
+#include <inttypes.h>
+#include <time.h>
+
+#include <odp_api.h>
+#include <odp/helper/odph_api.h>
+
+/* Flow counts of the performance test. The largest count can be given as
+ * the first argument, e.g. 10000000. */
+#define PERFORMANCE_MIN_FLOWS	10000
+#define PERFORMANCE_MAX_FLOWS	1000000
+#define PERFORMANCE_LOOKUPS	(4 * 1024 * 1024)
+#define PERFORMANCE_BURST	32
+
+typedef struct {
+	uint64_t packets;
+	uint32_t id;
+} flow_data_t;
+
+typedef struct {
+	int num_evict;
+	int bad_data;
+} evict_ctx_t;
+
+static void make_key(odph_flow_key_t *key, uint32_t i)
+{
+	memset(key, 0, sizeof(odph_flow_key_t));
+	key->src_ip = 0x0a000000 + i;
+	key->dst_ip = 0xc0a80001;
+	key->src_port = 1024 + (i & 0x7fff);
+	key->dst_port = 80;
+	key->proto = 17;
+}
+
+static void evict_cb(const odph_flow_key_t *key, void *data, void *arg)
+{
+	evict_ctx_t *ctx = arg;
+	flow_data_t *flow = data;
+
+	if (flow->id != key->src_ip - 0x0a000000)
+		ctx->bad_data++;
+
+	ctx->num_evict++;
+}
+
+/*
+ * Insert, find and remove flows:
+ *	- insert flows in bursts, check new_mask
+ *	- look up the same flows, check that none are new and data is kept
+ *	- insert until the table is full
+ *	- remove half of the flows, check that the rest are found
+ */
+static int test_basic(odph_flow_table_mode_t mode)
+{
+	odph_flow_table_param_t param;
+	odph_flow_table_t table;
+	odph_flow_key_t key[ODPH_FLOW_TABLE_MULTI_MAX];
+	void *data[ODPH_FLOW_TABLE_MULTI_MAX];
+	flow_data_t *flow;
+	uint64_t new_mask;
+	uint32_t i, j, num_flows = 256;
+	int ret = -1;
+
+	odph_flow_table_param_init(&param);
+	param.mode = mode;
+	param.max_flows = num_flows;
+	param.data_size = sizeof(flow_data_t);
+
+	table = odph_flow_table_create("flow_test", &param);
+	if (table == ODPH_FLOW_TABLE_INVALID) {
+		printf("Flow table creation failed\n");
+		return -1;
+	}
+
+	if (odph_flow_table_lookup("flow_test") != table) {
+		printf("Flow table lookup by name failed\n");
+		goto out;
+	}
+
+	for (i = 0; i < num_flows; i += ODPH_FLOW_TABLE_MULTI_MAX) {
+		for (j = 0; j < ODPH_FLOW_TABLE_MULTI_MAX; j++)
+			make_key(&key[j], i + j);
+
+		if (odph_flow_table_lookup_insert_multi(
+				table, 0, key, NULL, data,
+				ODPH_FLOW_TABLE_MULTI_MAX, &new_mask) !=
+		    ODPH_FLOW_TABLE_MULTI_MAX || new_mask != UINT64_MAX) {
+			printf("Flow insert failed\n");
+			goto out;
+		}
+
+		for (j = 0; j < ODPH_FLOW_TABLE_MULTI_MAX; j++) {
+			flow = data[j];
+			flow->id = i + j;
+			flow->packets = 1;
+		}
+	}
+
+	if (odph_flow_table_count(table, 0) != num_flows) {
+		printf("Bad flow count\n");
+		goto out;
+	}
+
+	for (i = 0; i < num_flows; i += ODPH_FLOW_TABLE_MULTI_MAX) {
+		for (j = 0; j < ODPH_FLOW_TABLE_MULTI_MAX; j++)
+			make_key(&key[j], i + j);
+
+		if (odph_flow_table_lookup_insert_multi(
+				table, 0, key, NULL, data,
+				ODPH_FLOW_TABLE_MULTI_MAX, &new_mask) !=
+		    ODPH_FLOW_TABLE_MULTI_MAX || new_mask != 0) {
+			printf("Flow lookup failed\n");
+			goto out;
+		}
+
+		for (j = 0; j < ODPH_FLOW_TABLE_MULTI_MAX; j++) {
+			flow = data[j];
+			if (flow->id != i + j) {
+				printf("Bad flow data\n");
+				goto out;
+			}
+		}
+	}
+
+	/* Table is full */
+	make_key(&key[0], num_flows);
+	if (odph_flow_table_lookup_insert_multi(table, 0, key, NULL, data, 1,
+						&new_mask) != 0 ||
+	    data[0] != NULL || new_mask != 0) {
+		printf("Insert into a full table succeeded\n");
+		goto out;
+	}
+
+	for (i = 0; i < num_flows; i += 2) {
+		make_key(&key[0], i);
+		if (odph_flow_table_remove(table, 0, &key[0], NULL)) {
+			printf("Flow remove failed\n");
+			goto out;
+		}
+	}
+
+	make_key(&key[0], 0);
+	if (odph_flow_table_remove(table, 0, &key[0], NULL) == 0) {
+		printf("Removed a flow twice\n");
+		goto out;
+	}
+
+	for (i = 0; i < num_flows; i++) {
+		make_key(&key[0], i);
+		flow = odph_flow_table_find(table, 0, &key[0], NULL);
+
+		if ((i & 1) && (flow == NULL || flow->id != i)) {
+			printf("Flow not found after remove\n");
+			goto out;
+		}
+
+		if (!(i & 1) && flow != NULL) {
+			printf("Removed flow found\n");
+			goto out;
+		}
+	}
+
+	if (odph_flow_table_count(table, 0) != num_flows / 2) {
+		printf("Bad flow count after remove\n");
+		goto out;
+	}
+
+	ret = 0;
+out:
+	odph_flow_table_destroy(table);
+	return ret;
+}
+
+/* Same key is inserted into two shards, and into the same shard twice
+ * within a burst */
+static int test_shards(void)
+{
+	odph_flow_table_param_t param;
+	odph_flow_table_t table;
+	odph_flow_key_t key[2];
+	void *data[2];
+	uint64_t new_mask;
+	int ret = -1;
+
+	odph_flow_table_param_init(&param);
+	param.mode = ODPH_FLOW_TABLE_SHARDED;
+	param.num_shards = 4;
+	param.max_flows = 64;
+	param.data_size = sizeof(flow_data_t);
+
+	table = odph_flow_table_create("flow_shard_test", &param);
+	if (table == ODPH_FLOW_TABLE_INVALID) {
+		printf("Flow table creation failed\n");
+		return -1;
+	}
+
+	make_key(&key[0], 1);
+	make_key(&key[1], 1);
+
+	if (odph_flow_table_lookup_insert_multi(table, 1, key, NULL, data, 2,
+						&new_mask) != 2 ||
+	    new_mask != 1 || data[0] != data[1]) {
+		printf("Duplicate key insert failed\n");
+		goto out;
+	}
+
+	if (odph_flow_table_find(table, 2, &key[0], NULL) != NULL) {
+		printf("Flow found from another shard\n");
+		goto out;
+	}
+
+	if (odph_flow_table_lookup_insert_multi(table, 2, key, NULL, data, 1,
+						&new_mask) != 1 ||
+	    new_mask != 1) {
+		printf("Insert into another shard failed\n");
+		goto out;
+	}
+
+	if (odph_flow_table_count(table, 1) != 1 ||
+	    odph_flow_table_count(table, 2) != 1 ||
+	    odph_flow_table_count(table, 3) != 0) {
+		printf("Bad shard flow count\n");
+		goto out;
+	}
+
+	if (odph_flow_table_find(table, 4, &key[0], NULL) != NULL) {
+		printf("Bad shard index accepted\n");
+		goto out;
+	}
+
+	ret = 0;
+out:
+	odph_flow_table_destroy(table);
+	return ret;
+}
+
+/* Idle flows are evicted, active flows are kept */
+static int test_aging(odph_flow_table_mode_t mode)
+{
+	odph_flow_table_param_t param;
+	odph_flow_table_t table;
+	odph_flow_key_t key;
+	void *data;
+	flow_data_t *flow;
+	evict_ctx_t ctx;
+	uint32_t i, num_flows = 64;
+	int ret = -1;
+
+	memset(&ctx, 0, sizeof(ctx));
+
+	odph_flow_table_param_init(&param);
+	param.mode = mode;
+	param.max_flows = num_flows;
+	param.data_size = sizeof(flow_data_t);
+	param.idle_timeout_ns = 50 * ODP_TIME_MSEC_IN_NS;
+	param.evict_fn = evict_cb;
+	param.evict_arg = &ctx;
+
+	table = odph_flow_table_create("flow_age_test", &param);
+	if (table == ODPH_FLOW_TABLE_INVALID) {
+		printf("Flow table creation failed\n");
+		return -1;
+	}
+
+	for (i = 0; i < num_flows; i++) {
+		make_key(&key, i);
+		if (odph_flow_table_lookup_insert_multi(table, 0, &key, NULL,
+							&data, 1, NULL) != 1) {
+			printf("Flow insert failed\n");
+			goto out;
+		}
+
+		flow = data;
+		flow->id = i;
+	}
+
+	if (odph_flow_table_age(table, 0, num_flows) != 0) {
+		printf("Active flows evicted\n");
+		goto out;
+	}
+
+	odp_time_wait_ns(param.idle_timeout_ns / 2);
+
+	/* Keep odd flows active */
+	for (i = 1; i < num_flows; i += 2) {
+		make_key(&key, i);
+		odph_flow_table_lookup_insert_multi(table, 0, &key, NULL,
+						    &data, 1, NULL);
+	}
+
+	odp_time_wait_ns(param.idle_timeout_ns * 3 / 4);
+
+	/* Aging work may be split into multiple calls */
+	for (i = 0; i < num_flows; i += 8)
+		odph_flow_table_age(table, 0, 8);
+
+	if (ctx.num_evict != (int)num_flows / 2 || ctx.bad_data) {
+		printf("Bad number of evicted flows: %i\n", ctx.num_evict);
+		goto out;
+	}
+
+	if (odph_flow_table_count(table, 0) != num_flows / 2) {
+		printf("Bad flow count after aging\n");
+		goto out;
+	}
+
+	ret = 0;
+out:
+	odph_flow_table_destroy(table);
+	return ret;
+}
+
+static double time_diff_sec(odp_time_t t1, odp_time_t t2)
+{
+	return (double)odp_time_diff_ns(t2, t1) / ODP_TIME_SEC_IN_NS;
+}
+
+/* Bulk lookup rate of existing flows with random access pattern */
+static int test_performance(odph_flow_table_mode_t mode, uint32_t num_flows)
+{
+	odph_flow_table_param_t param;
+	odph_flow_table_t table;
+	odph_flow_key_t *key;
+	void *data[PERFORMANCE_BURST];
+	uint32_t i, j, num;
+	odp_time_t t1, t2;
+	double time;
+	int ret = 0;
+
+	key = malloc(PERFORMANCE_LOOKUPS * sizeof(odph_flow_key_t));
+	if (key == NULL)
+		return -1;
+
+	odph_flow_table_param_init(&param);
+	param.mode = mode;
+	param.max_flows = num_flows;
+	param.data_size = sizeof(flow_data_t);
+	param.idle_timeout_ns = 10 * ODP_TIME_SEC_IN_NS;
+
+	table = odph_flow_table_create("flow_perf_test", &param);
+	if (table == ODPH_FLOW_TABLE_INVALID) {
+		printf("Flow table creation failed\n");
+		free(key);
+		return -1;
+	}
+
+	t1 = odp_time_local();
+	for (i = 0; i < num_flows; i += num) {
+		num = num_flows - i;
+		if (num > PERFORMANCE_BURST)
+			num = PERFORMANCE_BURST;
+
+		for (j = 0; j < num; j++)
+			make_key(&key[j], i + j);
+
+		if (odph_flow_table_lookup_insert_multi(table, 0, key, NULL,
+							data, num, NULL) !=
+		    (int)num) {
+			printf("Flow insert failed\n");
+			ret = -1;
+			goto out;
+		}
+	}
+	t2 = odp_time_local();
+	time = time_diff_sec(t1, t2);
+	printf("%s, %u flows: insert %.2f M flows/s", mode ==
+	       ODPH_FLOW_TABLE_SHARED ? "shared " : "sharded", num_flows,
+	       num_flows / time / 1000000);
+
+	for (i = 0; i < PERFORMANCE_LOOKUPS; i++)
+		make_key(&key[i], ((uint32_t)rand() << 16 ^ rand()) %
+			 num_flows);
+
+	t1 = odp_time_local();
+	for (i = 0; i < PERFORMANCE_LOOKUPS; i += PERFORMANCE_BURST) {
+		if (odph_flow_table_lookup_insert_multi(
+				table, 0, &key[i], NULL, data,
+				PERFORMANCE_BURST, NULL) != PERFORMANCE_BURST)
+			ret = -1;
+	}
+	t2 = odp_time_local();
+	time = time_diff_sec(t1, t2);
+	printf(", lookup %.2f M lookups/s\n",
+	       PERFORMANCE_LOOKUPS / time / 1000000);
+
+	if (ret < 0)
+		printf("lookup error\n");
+
+out:
+	odph_flow_table_destroy(table);
+	free(key);
+	return ret;
+}
+
+int main(int argc, char *argv[])
+{
+	odp_instance_t instance;
+	uint32_t num, max_flows = PERFORMANCE_MAX_FLOWS;
+	int ret = 0;
+
+	if (argc > 1)
+		max_flows = atoi(argv[1]);
+
+	ret = odp_init_global(&instance, NULL, NULL);
+	if (ret != 0) {
+		fprintf(stderr, "Error: ODP global init failed.\n");
+		exit(EXIT_FAILURE);
+	}
+
+	ret = odp_init_local(instance, ODP_THREAD_WORKER);
+	if (ret != 0) {
+		fprintf(stderr, "Error: ODP local init failed.\n");
+		exit(EXIT_FAILURE);
+	}
+
+	srand(time(0));
+
+	if (test_basic(ODPH_FLOW_TABLE_SHARED) < 0 ||
+	    test_basic(ODPH_FLOW_TABLE_SHARDED) < 0 ||
+	    test_shards() < 0 ||
+	    test_aging(ODPH_FLOW_TABLE_SHARED) < 0 ||
+	    test_aging(ODPH_FLOW_TABLE_SHARDED) < 0)
+		ret = -1;
+
+	for (num = PERFORMANCE_MIN_FLOWS; ret == 0 && num <= max_flows;
+	     num *= 10) {
+		if (test_performance(ODPH_FLOW_TABLE_SHARED, num) < 0 ||
+		    test_performance(ODPH_FLOW_TABLE_SHARDED, num) < 0)
+			ret = -1;
+	}
+
+	if (ret < 0)
+		printf("Test failed\n");
+	else
+		printf("All tests passed\n");
+
+	if (odp_term_local()) {
+		fprintf(stderr, "Error: ODP local term failed.\n");
+		exit(EXIT_FAILURE);
+	}
+
+	if (odp_term_global(instance)) {
+		fprintf(stderr, "Error: ODP global term failed.\n");
+		exit(EXIT_FAILURE);
+	}
+
+	return ret;
+}
@@ -9,10 +9,30 @@
 #include <string.h>
 #include <stdlib.h>
 #include <errno.h>
+#include <inttypes.h>
+#include <time.h>
 
 #include <odp_api.h>
 #include <odp/helper/odph_api.h>
 
+/* Number of routes in random route tests */
+#define RANDOM_ROUTES		1000
+/* Number of addresses in random route tests */
+#define RANDOM_ADDRS		4096
+/* Default number of routes in performance test */
+#define PERFORMANCE_ROUTES	100000
+/* Number of lookup addresses in performance test */
+#define PERFORMANCE_ADDRS	(1024 * 1024)
+#define PERFORMANCE_ROUNDS	10
+#define PERFORMANCE_BURST	32
+
+typedef struct {
+	uint8_t ip[16];
+	uint8_t cidr;
+	uint8_t removed;
+	uint64_t value;
+} test_route_t;
+
 static void print_prefix_info(
 		const char *msg, uint32_t ip, uint8_t cidr)
 {
@@ -136,11 +156,469 @@ static int test_ip_lookup_table(void)
 	return 0;
 }
 
-int main(int argc ODP_UNUSED, char *argv[] ODP_UNUSED)
+static uint32_t rand32(void)
+{
+	return ((uint32_t)rand() << 16) ^ (uint32_t)rand();
+}
+
+static void rand_bytes(uint8_t *data, int len)
+{
+	int i;
+
+	for (i = 0; i < len; i++)
+		data[i] = rand();
+}
+
+static uint32_t ip4_from_bytes(const uint8_t ip[])
+{
+	return ((uint32_t)ip[0] << 24) | (ip[1] << 16) | (ip[2] << 8) | ip[3];
+}
+
+static int prefix_match(const uint8_t ip[], const uint8_t prefix[],
+			int cidr)
+{
+	int i;
+
+	for (i = 0; i < cidr; i++) {
+		int bit = 7 - (i % 8);
+
+		if (((ip[i / 8] >> bit) & 1) != ((prefix[i / 8] >> bit) & 1))
+			return 0;
+	}
+
+	return 1;
+}
+
+/* Reference longest prefix match with linear search */
+static uint64_t ref_lookup(const test_route_t route[], int num,
+			   const uint8_t ip[])
+{
+	int i, cidr = -1;
+	uint64_t value = 0;
+
+	for (i = 0; i < num; i++) {
+		if (route[i].removed || route[i].cidr <= cidr)
+			continue;
+
+		if (prefix_match(ip, route[i].ip, route[i].cidr)) {
+			cidr = route[i].cidr;
+			value = route[i].value;
+		}
+	}
+
+	return value;
+}
+
+/* Compare single and bulk lookups to the reference. Addresses are
+ * generated close to the routes, so that most of them match. */
+static int check_lookups(odph_table_t table, int ipv6,
+			 const test_route_t route[], int num)
+{
+	static uint8_t addr[RANDOM_ADDRS][16];
+	static uint32_t addr4[RANDOM_ADDRS];
+	static uint64_t result[RANDOM_ADDRS];
+	void *key[ODPH_IPLOOKUP_TABLE_MULTI_MAX];
+	void *buf[ODPH_IPLOOKUP_TABLE_MULTI_MAX];
+	uint64_t ref, single, hits;
+	int i, j, len = ipv6 ? 16 : 4;
+	int ret, burst = ODPH_IPLOOKUP_TABLE_MULTI_MAX;
+
+	for (i = 0; i < RANDOM_ADDRS; i++) {
+		const test_route_t *r = &route[rand() % num];
+
+		rand_bytes(addr[i], 16);
+		/* Copy a random number of leading bytes from a route */
+		memcpy(addr[i], r->ip, rand() % (r->cidr / 8 + 2) % (len + 1));
+		addr4[i] = ip4_from_bytes(addr[i]);
+	}
+
+	for (i = 0; i < RANDOM_ADDRS; i += burst) {
+		for (j = 0; j < burst; j++) {
+			key[j] = ipv6 ? (void *)addr[i + j] :
+					(void *)&addr4[i + j];
+			buf[j] = &result[i + j];
+		}
+
+		if (ipv6)
+			ret = odph_iplookup6_table_get_value_multi(
+					table, key, buf, sizeof(uint64_t),
+					burst, &hits);
+		else
+			ret = odph_iplookup_table_get_value_multi(
+					table, key, buf, sizeof(uint64_t),
+					burst, &hits);
+		if (ret < 0) {
+			printf("Bulk lookup failed\n");
+			return -1;
+		}
+
+		for (j = 0; j < burst; j++) {
+			if (((hits >> j) & 1) != (result[i + j] != 0)) {
+				printf("Bad hit mask\n");
+				return -1;
+			}
+		}
+	}
+
+	for (i = 0; i < RANDOM_ADDRS; i++) {
+		ref = ref_lookup(route, num, addr[i]);
+
+		if (ipv6)
+			ret = odph_iplookup6_table_get_value(table, addr[i],
+							     &single, 0);
+		else
+			ret = odph_iplookup_table_get_value(table, &addr4[i],
+							    &single, 0);
+
+		if (ret < 0 || single != ref || result[i] != ref) {
+			printf("Lookup mismatch: %" PRIu64 " %" PRIu64 " %"
+			       PRIu64 "\n", ref, single, result[i]);
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+static int put_route(odph_table_t table, int ipv6, test_route_t *r)
+{
+	odph_iplookup_prefix_t prefix;
+	odph_iplookup6_prefix_t prefix6;
+
+	if (ipv6) {
+		memcpy(prefix6.ip, r->ip, 16);
+		prefix6.cidr = r->cidr;
+		return odph_iplookup6_table_put_value(table, &prefix6,
+						      &r->value);
+	}
+
+	prefix.ip = ip4_from_bytes(r->ip);
+	prefix.cidr = r->cidr;
+	return odph_iplookup_table_put_value(table, &prefix, &r->value);
+}
+
+static int remove_route(odph_table_t table, int ipv6, test_route_t *r)
+{
+	odph_iplookup_prefix_t prefix;
+	odph_iplookup6_prefix_t prefix6;
+
+	if (ipv6) {
+		memcpy(prefix6.ip, r->ip, 16);
+		prefix6.cidr = r->cidr;
+		return odph_iplookup6_table_remove_value(table, &prefix6);
+	}
+
+	prefix.ip = ip4_from_bytes(r->ip);
+	prefix.cidr = r->cidr;
+	return odph_iplookup_table_remove_value(table, &prefix);
+}
+
+/*
+ * Random routes of all prefix lengths:
+ *	- put routes, compare lookups to reference
+ *	- remove every other route, compare lookups to reference
+ *	- remove the rest with multi key calls, all lookups miss
+ */
+static int test_random_routes(int ipv6)
+{
+	static test_route_t route[RANDOM_ROUTES];
+	odph_iplookup_prefix_t prefix[ODPH_TABLE_MULTI_MAX];
+	odph_iplookup6_prefix_t prefix6[ODPH_TABLE_MULTI_MAX];
+	void *key[ODPH_TABLE_MULTI_MAX];
+	odph_table_ops_t *ops = ipv6 ? &odph_iplookup6_table_ops :
+				       &odph_iplookup_table_ops;
+	odph_table_t table;
+	int i, j, num, len = ipv6 ? 16 : 4;
+	int ret = -1;
+
+	if (ipv6)
+		table = odph_iplookup6_table_create("random_test6", 0, 0,
+						    sizeof(uint64_t));
+	else
+		table = odph_iplookup_table_create("random_test", 0, 0,
+						   sizeof(uint64_t));
+	if (table == NULL) {
+		printf("IP prefix lookup table creation failed\n");
+		return -1;
+	}
+
+	for (i = 0; i < RANDOM_ROUTES; i++) {
+		test_route_t *r = &route[i];
+
+		memset(r, 0, sizeof(test_route_t));
+		r->cidr = 1 + rand() % (len * 8);
+		/* Share leading bytes with an earlier route to create
+		 * overlapping prefixes */
+		if (i && rand() % 2)
+			memcpy(r->ip, route[rand() % i].ip, len);
+		rand_bytes(&r->ip[r->cidr / 8], len - r->cidr / 8);
+		for (j = r->cidr; j < len * 8; j++)
+			r->ip[j / 8] &= ~(1 << (7 - j % 8));
+
+		/* Skip duplicates */
+		for (j = 0; j < i; j++)
+			if (route[j].cidr == r->cidr &&
+			    !memcmp(route[j].ip, r->ip, len))
+				break;
+		if (j < i) {
+			i--;
+			continue;
+		}
+
+		r->value = i + 1;
+		if (put_route(table, ipv6, r) < 0) {
+			printf("Failed to add ip prefix\n");
+			goto out;
+		}
+	}
+
+	if (check_lookups(table, ipv6, route, RANDOM_ROUTES))
+		goto out;
+
+	for (i = 0; i < RANDOM_ROUTES; i += 2) {
+		route[i].removed = 1;
+		if (remove_route(table, ipv6, &route[i]) < 0) {
+			printf("Failed to delete ip prefix\n");
+			goto out;
+		}
+	}
+
+	if (check_lookups(table, ipv6, route, RANDOM_ROUTES))
+		goto out;
+
+	/* Remove the rest with multi key calls */
+	for (i = 1; i < RANDOM_ROUTES; i += 2 * num) {
+		num = 0;
+		for (j = i; j < RANDOM_ROUTES && num < ODPH_TABLE_MULTI_MAX;
+		     j += 2) {
+			route[j].removed = 1;
+			prefix[num].ip = ip4_from_bytes(route[j].ip);
+			prefix[num].cidr = route[j].cidr;
+			memcpy(prefix6[num].ip, route[j].ip, 16);
+			prefix6[num].cidr = route[j].cidr;
+			key[num] = ipv6 ? (void *)&prefix6[num] :
+					  (void *)&prefix[num];
+			num++;
+		}
+
+		if (ops->f_remove_multi(table, key, num, NULL) != num) {
+			printf("Failed to delete ip prefixes\n");
+			goto out;
+		}
+	}
+
+	if (check_lookups(table, ipv6, route, RANDOM_ROUTES))
+		goto out;
+
+	/* Removed prefix */
+	if (remove_route(table, ipv6, &route[0]) >= 0) {
+		printf("Removed a prefix twice\n");
+		goto out;
+	}
+
+	printf("%s random routes: OK\n", ipv6 ? "IPv6" : "IPv4");
+	ret = 0;
+out:
+	if (ipv6)
+		odph_iplookup6_table_destroy(table);
+	else
+		odph_iplookup_table_destroy(table);
+	return ret;
+}
+
+static double time_diff_sec(odp_time_t t1, odp_time_t t2)
+{
+	return (double)odp_time_diff_ns(t2, t1) / ODP_TIME_SEC_IN_NS;
+}
+
+/*
+ * IPv4 lookup rate with a large route table. Prefix length distribution
+ * follows roughly an Internet routing table: most prefixes are /24, some
+ * shorter, and a few longer than 24 bits.
+ */
+static int test_performance(uint32_t num_routes)
+{
+	odph_iplookup_prefix_t prefix;
+	odph_table_t table;
+	uint32_t *addr;
+	void **key;
+	void *buf[PERFORMANCE_BURST];
+	uint64_t value, result[PERFORMANCE_BURST], hits;
+	uint32_t i, j, r, num = 0;
+	odp_time_t t1, t2;
+	double time;
+	int ret = 0;
+
+	addr = malloc(PERFORMANCE_ADDRS * sizeof(uint32_t));
+	key = malloc(PERFORMANCE_ADDRS * sizeof(void *));
+	if (addr == NULL || key == NULL) {
+		free(addr);
+		free(key);
+		return -1;
+	}
+
+	table = odph_iplookup_table_create("performance_test", num_routes,
+					   num_routes / 50 + 1024,
+					   sizeof(uint64_t));
+	if (table == NULL) {
+		printf("IP prefix lookup table creation failed\n");
+		free(addr);
+		free(key);
+		return -1;
+	}
+
+	t1 = odp_time_local();
+	for (i = 0; i < num_routes; i++) {
+		int d = rand() % 100;
+
+		if (d < 60)
+			prefix.cidr = 24;
+		else if (d < 99)
+			prefix.cidr = 16 + rand() % 8;
+		else
+			prefix.cidr = 25 + rand() % 8;
+
+		prefix.ip = rand32();
+		value = i + 1;
+		if (odph_iplookup_table_put_value(table, &prefix, &value) < 0)
+			break;
+	}
+	t2 = odp_time_local();
+	num = i;
+	time = time_diff_sec(t1, t2);
+	printf("add %u/%u routes, time = %.3fs, %.2f M routes/s\n",
+	       num, num_routes, time, num / time / 1000000);
+
+	for (i = 0; i < PERFORMANCE_ADDRS; i++) {
+		addr[i] = rand32();
+		key[i] = &addr[i];
+	}
+
+	t1 = odp_time_local();
+	for (r = 0; r < PERFORMANCE_ROUNDS; r++) {
+		for (i = 0; i < PERFORMANCE_ADDRS; i++) {
+			if (odph_iplookup_table_get_value(table, &addr[i],
+							  &value, 0) < 0)
+				ret = -1;
+		}
+	}
+	t2 = odp_time_local();
+	time = time_diff_sec(t1, t2);
+	printf("lookup %u addresses, %.2f M lookups/s\n", PERFORMANCE_ADDRS,
+	       (double)PERFORMANCE_ADDRS * PERFORMANCE_ROUNDS / time / 1000000);
+
+	for (j = 0; j < PERFORMANCE_BURST; j++)
+		buf[j] = &result[j];
+
+	t1 = odp_time_local();
+	for (r = 0; r < PERFORMANCE_ROUNDS; r++) {
+		for (i = 0; i < PERFORMANCE_ADDRS; i += PERFORMANCE_BURST) {
+			if (odph_iplookup_table_get_value_multi(
+					table, &key[i], buf, sizeof(uint64_t),
+					PERFORMANCE_BURST, &hits) < 0)
+				ret = -1;
+		}
+	}
+	t2 = odp_time_local();
+	time = time_diff_sec(t1, t2);
+	printf("bulk lookup %u addresses, burst %u, %.2f M lookups/s\n",
+	       PERFORMANCE_ADDRS, PERFORMANCE_BURST,
+	       (double)PERFORMANCE_ADDRS * PERFORMANCE_ROUNDS / time / 1000000);
+
+	if (ret < 0)
+		printf("lookup error\n");
+
+	odph_iplookup_table_destroy(table);
+	free(addr);
+	free(key);
+	return ret;
+}
+
+/*
+ * Basic sequence of operations for IPv6:
+ *	- put short prefix
+ *	- put long prefix
+ *	- get (hit long prefix)
+ *	- remove long prefix
+ *	- get (hit short prefix)
+ *	- remove short prefix
+ *	- get (miss)
+ */
+static int test_ip6_lookup_table(void)
+{
+	odph_iplookup6_prefix_t prefix1, prefix2;
+	odph_table_t table;
+	uint64_t value1 = 1, value2 = 2, result = 0;
+	/* 2001:db8::/32, 2001:db8:0:1::/64, 2001:db8:0:1::1 */
+	uint8_t addr1[16] = {0x20, 0x01, 0x0d, 0xb8};
+	uint8_t addr2[16] = {0x20, 0x01, 0x0d, 0xb8, 0, 0, 0, 1};
+	uint8_t lkp_ip[16] = {0x20, 0x01, 0x0d, 0xb8, 0, 0, 0, 1,
+			      0, 0, 0, 0, 0, 0, 0, 1};
+	int ret = -1;
+
+	table = odph_iplookup6_table_create("prefix_test6", 0, 0,
+					    sizeof(uint64_t));
+	if (table == NULL) {
+		printf("IPv6 prefix lookup table creation failed\n");
+		return -1;
+	}
+
+	memcpy(prefix1.ip, addr1, 16);
+	prefix1.cidr = 32;
+	memcpy(prefix2.ip, addr2, 16);
+	prefix2.cidr = 64;
+
+	if (odph_iplookup6_table_put_value(table, &prefix1, &value1) < 0 ||
+	    odph_iplookup6_table_put_value(table, &prefix2, &value2) < 0) {
+		printf("Failed to add ip prefix\n");
+		goto out;
+	}
+
+	if (odph_iplookup6_table_get_value(table, lkp_ip, &result, 0) < 0 ||
+	    result != 2) {
+		printf("Failed to find longest prefix\n");
+		goto out;
+	}
+
+	if (odph_iplookup6_table_remove_value(table, &prefix2) < 0) {
+		printf("Failed to delete ip prefix\n");
+		goto out;
+	}
+
+	if (odph_iplookup6_table_get_value(table, lkp_ip, &result, 0) < 0 ||
+	    result != 1) {
+		printf("Error: found result after deleting\n");
+		goto out;
+	}
+
+	if (odph_iplookup6_table_remove_value(table, &prefix1) < 0) {
+		printf("Failed to delete prefix\n");
+		goto out;
+	}
+
+	if (odph_iplookup6_table_get_value(table, lkp_ip, &result, 0) < 0 ||
+	    result != 0) {
+		printf("Error: found result after deleting\n");
+		goto out;
+	}
+
+	ret = 0;
+out:
+	odph_iplookup6_table_destroy(table);
+	return ret;
+}
+
+/* Number of routes in performance test can be given as the first argument,
+ * e.g. 1000000 */
+int main(int argc, char *argv[])
 {
 	odp_instance_t instance;
+	uint32_t num_routes = PERFORMANCE_ROUTES;
 	int ret = 0;
 
+	if (argc > 1)
+		num_routes = atoi(argv[1]);
+
 	ret = odp_init_global(&instance, NULL, NULL);
 	if (ret != 0) {
 		fprintf(stderr, "Error: ODP global init failed.\n");
@@ -153,7 +631,14 @@ int main(int argc ODP_UNUSED, char *argv[] ODP_UNUSED)
 		exit(EXIT_FAILURE);
 	}
 
-	if (test_ip_lookup_table() < 0)
+	srand(time(0));
+
+	if (test_ip_lookup_table() < 0 || test_ip6_lookup_table() < 0 ||
+	    test_random_routes(0) < 0 || test_random_routes(1) < 0 ||
+	    test_performance(num_routes) < 0)
+		ret = -1;
+
+	if (ret < 0)
 		printf("Test failed\n");
 	else
 		printf("All tests passed\n");
@@ -23,6 +23,7 @@
 #include <odp/helper/odph_api.h>
 
 #define NUMBER_WORKERS 16
+#define NUM_POLLS      1000
 
 /* register odp_term_local/global() calls atexit() */
 static void main_exit(void);
@@ -64,6 +65,28 @@ static int worker_fn(void *arg ODP_UNUSED)
 	return 0;
 }
 
+static int poll_worker_fn(void *arg ODP_UNUSED)
+{
+	odph_thread_poll_stats_t stats;
+
+	/* Every other poll returns work */
+	for (int i = 0; i < NUM_POLLS; i++)
+		odph_thread_poll_update(i & 1);
+
+	if (odph_thread_poll_stats(odp_thread_id(), &stats)) {
+		printf("Reading poll statistics failed\n");
+		return -1;
+	}
+
+	if (stats.busy_polls != NUM_POLLS / 2 || stats.idle_polls != NUM_POLLS / 2) {
+		printf("Bad poll counts: busy %" PRIu64 ", idle %" PRIu64 "\n",
+		       stats.busy_polls, stats.idle_polls);
+		return -1;
+	}
+
+	return 0;
+}
+
 /* Create additional dataplane opdthreads */
 int main(int argc, char *argv[])
 {
@@ -203,6 +226,32 @@ int main(int argc, char *argv[])
 	if (odph_thread_join(thread_tbl, num_workers) != num_workers)
 		exit(EXIT_FAILURE);
 
+	/* Test poll statistics and real-time priority (if permitted). */
+
+	num_workers = odph_cpumask_isolated(&cpu_mask);
+	printf("\n");
+	printf("isolated CPUs:                    %i\n", num_workers);
+
+	num_workers = odph_cpumask_default_worker_isolated(&cpu_mask, NUMBER_WORKERS);
+	(void)odp_cpumask_to_str(&cpu_mask, cpumaskstr, sizeof(cpumaskstr));
+	printf("isolated worker cpu mask:         %s\n", cpumaskstr);
+
+	if (odph_thread_poll_stats_init())
+		exit(EXIT_FAILURE);
+
+	thr_param.start = poll_worker_fn;
+	thr_param.stack_size = 0;
+	thr_param.rt_prio = 1;
+
+	if (odph_thread_create(thread_tbl, &thr_common, &thr_param, num_workers) != num_workers)
+		exit(EXIT_FAILURE);
+
+	if (odph_thread_join(thread_tbl, num_workers) != num_workers)
+		exit(EXIT_FAILURE);
+
+	if (odph_thread_poll_stats_term())
+		exit(EXIT_FAILURE);
+
 	return 0;
 }
 
@@ -7,6 +7,10 @@
 #include <odp_api.h>
 #include <odp/helper/odph_api.h>
 
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+
 /**
  * Address Resolution Protocol (ARP)
  * Description: Once a route has been identified for an IP packet (so the
@@ -23,6 +27,176 @@
  * value (data): MAC address of the next hop station (6 bytes).
  */
 
+#define NUM_MANY_KEYS 20000
+
+/**
+ * Insert, lookup and remove many keys. Table grows during the test.
+ */
+static int test_many_keys(odph_table_ops_t *ops)
+{
+	odph_table_t table;
+	odp_time_t t1, t2;
+	uint32_t i, key, value;
+	int ret;
+
+	table = ops->f_create("test_many", 2, sizeof(key), sizeof(value));
+	if (table == NULL) {
+		printf("table create fail\n");
+		return -1;
+	}
+
+	t1 = odp_time_local();
+	for (i = 0; i < NUM_MANY_KEYS; i++) {
+		key = i * 2654435761u;
+		value = i;
+		if (ops->f_put(table, &key, &value)) {
+			printf("put value %u fail\n", i);
+			ops->f_des(table);
+			return -1;
+		}
+	}
+	t2 = odp_time_local();
+	printf("\t   put %i keys: %" PRIu64 " nsec/key\n", NUM_MANY_KEYS,
+	       odp_time_diff_ns(t2, t1) / NUM_MANY_KEYS);
+
+	t1 = odp_time_local();
+	for (i = 0; i < NUM_MANY_KEYS; i++) {
+		key = i * 2654435761u;
+		if (ops->f_get(table, &key, &value, sizeof(value)) ||
+		    value != i) {
+			printf("get value %u fail\n", i);
+			ops->f_des(table);
+			return -1;
+		}
+	}
+	t2 = odp_time_local();
+	printf("\t   get %i keys: %" PRIu64 " nsec/key\n", NUM_MANY_KEYS,
+	       odp_time_diff_ns(t2, t1) / NUM_MANY_KEYS);
+
+	for (i = 0; i < NUM_MANY_KEYS; i += 2) {
+		key = i * 2654435761u;
+		if (ops->f_remove(table, &key)) {
+			printf("remove value %u fail\n", i);
+			ops->f_des(table);
+			return -1;
+		}
+	}
+
+	for (i = 0; i < NUM_MANY_KEYS; i++) {
+		key = i * 2654435761u;
+		ret = ops->f_get(table, &key, &value, sizeof(value));
+		if ((i % 2 == 0 && ret == 0) ||
+		    (i % 2 == 1 && (ret != 0 || value != i))) {
+			printf("get value %u after remove fail\n", i);
+			ops->f_des(table);
+			return -1;
+		}
+	}
+
+	return ops->f_des(table);
+}
+
+/**
+ * Insert, lookup and remove keys with multi key operations
+ */
+static int test_multi(odph_table_ops_t *ops)
+{
+	odph_table_t table;
+	uint32_t key[ODPH_TABLE_MULTI_MAX], value[ODPH_TABLE_MULTI_MAX];
+	void *key_ptr[ODPH_TABLE_MULTI_MAX], *value_ptr[ODPH_TABLE_MULTI_MAX];
+	uint64_t hit_mask;
+	int i, ret, num = ODPH_TABLE_MULTI_MAX;
+
+	table = ops->f_create("test_multi", 2, sizeof(uint32_t),
+			      sizeof(uint32_t));
+	if (table == NULL) {
+		printf("table create fail\n");
+		return -1;
+	}
+
+	for (i = 0; i < num; i++) {
+		key[i] = i * 2654435761u;
+		value[i] = i;
+		key_ptr[i] = &key[i];
+		value_ptr[i] = &value[i];
+	}
+
+	/* Put every other key */
+	for (i = 0; i < num; i += 2) {
+		if (ops->f_put(table, &key[i], &value[i])) {
+			printf("put value %i fail\n", i);
+			ops->f_des(table);
+			return -1;
+		}
+	}
+
+	for (i = 0; i < num; i++)
+		value[i] = 0;
+
+	ret = ops->f_get_multi(table, key_ptr, value_ptr, sizeof(uint32_t),
+			       num, &hit_mask);
+	if (ret != num / 2 || hit_mask != 0x5555555555555555ULL) {
+		printf("get multi fail: %i, 0x%" PRIx64 "\n", ret, hit_mask);
+		ops->f_des(table);
+		return -1;
+	}
+
+	for (i = 0; i < num; i += 2) {
+		if (value[i] != (uint32_t)i) {
+			printf("get multi value %i fail\n", i);
+			ops->f_des(table);
+			return -1;
+		}
+	}
+
+	/* Put all keys */
+	for (i = 0; i < num; i++)
+		value[i] = i + 1;
+
+	ret = ops->f_put_multi(table, key_ptr, value_ptr, num);
+	if (ret != num) {
+		printf("put multi fail: %i\n", ret);
+		ops->f_des(table);
+		return -1;
+	}
+
+	ret = ops->f_get_multi(table, key_ptr, value_ptr, sizeof(uint32_t),
+			       num, &hit_mask);
+	if (ret != num || hit_mask != UINT64_MAX) {
+		printf("get multi after put fail: %i, 0x%" PRIx64 "\n", ret,
+		       hit_mask);
+		ops->f_des(table);
+		return -1;
+	}
+
+	/* Remove first half of keys twice */
+	ret = ops->f_remove_multi(table, key_ptr, num / 2, &hit_mask);
+	if (ret != num / 2 || hit_mask != 0xffffffff) {
+		printf("remove multi fail: %i, 0x%" PRIx64 "\n", ret,
+		       hit_mask);
+		ops->f_des(table);
+		return -1;
+	}
+
+	ret = ops->f_remove_multi(table, key_ptr, num / 2, &hit_mask);
+	if (ret != 0 || hit_mask != 0) {
+		printf("repeat remove multi fail: %i\n", ret);
+		ops->f_des(table);
+		return -1;
+	}
+
+	ret = ops->f_get_multi(table, key_ptr, value_ptr, sizeof(uint32_t),
+			       num, &hit_mask);
+	if (ret != num / 2 || hit_mask != 0xffffffff00000000ULL) {
+		printf("get multi after remove fail: %i, 0x%" PRIx64 "\n",
+		       ret, hit_mask);
+		ops->f_des(table);
+		return -1;
+	}
+
+	return ops->f_des(table);
+}
+
 int main(int argc ODP_UNUSED, char *argv[] ODP_UNUSED)
 {
 	odp_instance_t instance;
@@ -116,6 +290,18 @@ int main(int argc ODP_UNUSED, char *argv[] ODP_UNUSED)
 	}
 	printf("\t5  destroy table success!\n");
 
+	if (test_many_keys(test_ops)) {
+		printf("many keys test fail!!!\n");
+		exit(EXIT_FAILURE);
+	}
+	printf("\t6  many keys test success!\n");
+
+	if (test_multi(test_ops)) {
+		printf("multi test fail!!!\n");
+		exit(EXIT_FAILURE);
+	}
+	printf("\t7  multi test success!\n");
+
 	printf("all test finished success!!\n");
 
 	if (odp_term_local()) {
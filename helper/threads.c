@@ -9,6 +9,7 @@
 #define _GNU_SOURCE
 #endif
 #include <sched.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
@@ -32,8 +33,57 @@
 #define INIT_DONE   2
 #define STARTED     3
 
+#define POLL_STATS_SHM_NAME "_odph_thread_poll"
+
+#define SYSFS_CPU_ISOLATED  "/sys/devices/system/cpu/isolated"
+#define SYSFS_CPU_NOHZ_FULL "/sys/devices/system/cpu/nohz_full"
+
+/* Poll loop statistics of a thread. Written only by the owner thread. */
+typedef struct ODP_ALIGNED_CACHE {
+	odp_atomic_u64_t busy_cycles;
+	odp_atomic_u64_t idle_cycles;
+	odp_atomic_u64_t busy_polls;
+	odp_atomic_u64_t idle_polls;
+} poll_stats_slot_t;
+
+typedef struct {
+	poll_stats_slot_t slot[ODP_THREAD_COUNT_MAX];
+} poll_stats_shm_t;
+
 static odph_helper_options_t helper_options;
 
+/*
+ * Process local pointer to poll loop statistics. Set in
+ * odph_thread_poll_stats_init(), or looked up on first use in processes
+ * created before it.
+ */
+static poll_stats_shm_t *poll_stats;
+
+/* Poll loop state of the calling thread */
+static __thread struct {
+	poll_stats_slot_t *slot;
+	uint64_t cycles;
+	/* ODP thread ID + 1 of the state, 0 when not initialized */
+	int thr;
+	int busy;
+} poll_state;
+
+static void set_rt_prio(int prio)
+{
+	struct sched_param param;
+	int ret;
+
+	memset(&param, 0, sizeof(param));
+	param.sched_priority = prio;
+
+	ret = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+
+	if (ret == EPERM)
+		ODPH_DBG("helper: real-time scheduling not permitted\n");
+	else if (ret)
+		ODPH_ERR("pthread_setschedparam() failed: %s\n", strerror(ret));
+}
+
 /*
  * Run a thread, either as Linux pthread or process.
  * In process mode, if start_routine returns NULL, the process return FAILURE.
@@ -65,6 +115,9 @@ static void *run_thread(void *arg)
 		 "pthread" : "process",
 		 (int)getpid());
 
+	if (thr_params->rt_prio)
+		set_rt_prio(thr_params->rt_prio);
+
 	if (odp_atomic_load_u32(&start_args->status) == SYNC_INIT)
 		odp_atomic_store_rel_u32(&start_args->status, INIT_DONE);
 
@@ -424,8 +477,10 @@ int ODPH_DEPRECATE(odph_odpthreads_create)(
 
 		start_args = &thread_tbl[i].start_args;
 
-		/* Copy thread parameters */
+		/* Copy thread parameters. Real-time priority is not supported
+		 * by the deprecated API. */
 		start_args->thr_params = *thr_params;
+		start_args->thr_params.rt_prio = 0;
 		start_args->instance   = thr_params->ODPH_DEPRECATE(instance);
 
 		if (helper_options.mem_model == ODP_MEM_MODEL_THREAD) {
@@ -569,6 +624,209 @@ int odph_odpthread_getaffinity(void)
 	return -1;
 }
 
+/*
+ * Add CPUs of a sysfs CPU list (e.g. "2-5,8") to a mask. A missing file is
+ * treated as an empty list.
+ */
+static void read_cpulist(const char *path, odp_cpumask_t *mask)
+{
+	char buf[4096];
+	char *p, *end;
+	FILE *file = fopen(path, "r");
+
+	if (!file)
+		return;
+
+	if (!fgets(buf, sizeof(buf), file)) {
+		fclose(file);
+		return;
+	}
+
+	fclose(file);
+	p = buf;
+
+	while (*p && *p != '\n') {
+		long first, last;
+
+		first = strtol(p, &end, 10);
+		if (end == p || first < 0)
+			break;
+
+		last = first;
+		if (*end == '-') {
+			p = end + 1;
+			last = strtol(p, &end, 10);
+			if (end == p || last < first)
+				break;
+		}
+
+		for (long cpu = first; cpu <= last && cpu < (long)ODP_CPUMASK_SIZE; cpu++)
+			odp_cpumask_set(mask, (int)cpu);
+
+		if (*end == ',')
+			end++;
+
+		p = end;
+	}
+}
+
+int odph_cpumask_isolated(odp_cpumask_t *mask)
+{
+	odp_cpumask_t avail;
+
+	odp_cpumask_zero(mask);
+	read_cpulist(SYSFS_CPU_ISOLATED, mask);
+	read_cpulist(SYSFS_CPU_NOHZ_FULL, mask);
+
+	odp_cpumask_all_available(&avail);
+	odp_cpumask_and(mask, mask, &avail);
+
+	return odp_cpumask_count(mask);
+}
+
+int odph_cpumask_default_worker_isolated(odp_cpumask_t *mask, int num)
+{
+	odp_cpumask_t worker, isolated;
+	int cpu, pass;
+	int ret = 0;
+
+	odp_cpumask_default_worker(&worker, 0);
+	odph_cpumask_isolated(&isolated);
+	odp_cpumask_zero(mask);
+
+	/* Isolated CPUs on the first pass, other worker CPUs on the second */
+	for (pass = 0; pass < 2; pass++) {
+		cpu = odp_cpumask_last(&worker);
+
+		for (; cpu >= 0 && (num == 0 || ret < num); cpu--) {
+			if (!odp_cpumask_isset(&worker, cpu) ||
+			    odp_cpumask_isset(mask, cpu))
+				continue;
+
+			if (pass == 0 && !odp_cpumask_isset(&isolated, cpu))
+				continue;
+
+			odp_cpumask_set(mask, cpu);
+			ret++;
+		}
+	}
+
+	return ret;
+}
+
+int odph_thread_poll_stats_init(void)
+{
+	odp_shm_t shm;
+
+	if (odp_shm_lookup(POLL_STATS_SHM_NAME) != ODP_SHM_INVALID) {
+		ODPH_ERR("Poll statistics already initialized\n");
+		return -1;
+	}
+
+	shm = odp_shm_reserve(POLL_STATS_SHM_NAME, sizeof(poll_stats_shm_t),
+			      ODP_CACHE_LINE_SIZE, 0);
+	if (shm == ODP_SHM_INVALID) {
+		ODPH_ERR("Shm reserve failed\n");
+		return -1;
+	}
+
+	poll_stats = odp_shm_addr(shm);
+
+	for (int i = 0; i < ODP_THREAD_COUNT_MAX; i++) {
+		poll_stats_slot_t *slot = &poll_stats->slot[i];
+
+		odp_atomic_init_u64(&slot->busy_cycles, 0);
+		odp_atomic_init_u64(&slot->idle_cycles, 0);
+		odp_atomic_init_u64(&slot->busy_polls, 0);
+		odp_atomic_init_u64(&slot->idle_polls, 0);
+	}
+
+	return 0;
+}
+
+int odph_thread_poll_stats_term(void)
+{
+	odp_shm_t shm = odp_shm_lookup(POLL_STATS_SHM_NAME);
+
+	if (shm == ODP_SHM_INVALID) {
+		ODPH_ERR("Poll statistics not initialized\n");
+		return -1;
+	}
+
+	poll_stats = NULL;
+
+	if (odp_shm_free(shm)) {
+		ODPH_ERR("Shm free failed\n");
+		return -1;
+	}
+
+	return 0;
+}
+
+static poll_stats_shm_t *poll_stats_lookup(void)
+{
+	if (!poll_stats) {
+		odp_shm_t shm = odp_shm_lookup(POLL_STATS_SHM_NAME);
+
+		if (shm != ODP_SHM_INVALID)
+			poll_stats = odp_shm_addr(shm);
+	}
+
+	return poll_stats;
+}
+
+static inline void counter_add(odp_atomic_u64_t *counter, uint64_t val)
+{
+	/* Single writer, no need for an atomic read-modify-write */
+	odp_atomic_store_u64(counter, odp_atomic_load_u64(counter) + val);
+}
+
+void odph_thread_poll_update(int num)
+{
+	uint64_t cycles = odp_cpu_cycles();
+	int thr = odp_thread_id();
+	poll_stats_slot_t *slot = poll_state.slot;
+
+	/* Also detects state inherited from the parent of a forked process */
+	if (odp_unlikely(poll_state.thr != thr + 1)) {
+		poll_stats_shm_t *ps = poll_stats_lookup();
+
+		slot = ps ? &ps->slot[thr] : NULL;
+		poll_state.slot = slot;
+		poll_state.thr = thr + 1;
+	} else if (odp_likely(slot != NULL)) {
+		uint64_t diff = odp_cpu_cycles_diff(cycles, poll_state.cycles);
+
+		counter_add(poll_state.busy ? &slot->busy_cycles : &slot->idle_cycles,
+			    diff);
+	}
+
+	if (odp_unlikely(slot == NULL))
+		return;
+
+	poll_state.cycles = cycles;
+	poll_state.busy = num > 0;
+
+	counter_add(num > 0 ? &slot->busy_polls : &slot->idle_polls, 1);
+}
+
+int odph_thread_poll_stats(int thr, odph_thread_poll_stats_t *stats)
+{
+	poll_stats_shm_t *ps = poll_stats_lookup();
+	poll_stats_slot_t *slot;
+
+	if (!ps || thr < 0 || thr >= ODP_THREAD_COUNT_MAX)
+		return -1;
+
+	slot = &ps->slot[thr];
+	stats->busy_cycles = odp_atomic_load_u64(&slot->busy_cycles);
+	stats->idle_cycles = odp_atomic_load_u64(&slot->idle_cycles);
+	stats->busy_polls = odp_atomic_load_u64(&slot->busy_polls);
+	stats->idle_polls = odp_atomic_load_u64(&slot->idle_polls);
+
+	return 0;
+}
+
 int odph_parse_options(int argc, char *argv[])
 {
 	char *env;
@@ -569,6 +569,17 @@ void odp_schedule_order_wait(void);
  */
 void odp_schedule_print(void);
 
+/**
+ * Print scheduler statistics
+ *
+ * Print implementation defined scheduler statistics to the ODP log. Statistics
+ * may include e.g. per thread counters of schedule calls and returned events.
+ * The call does not stop or synchronize scheduling threads, so counters of
+ * concurrently scheduling threads may be printed with a small delay. The
+ * information is intended to be used for debugging and monitoring.
+ */
+void odp_schedule_stats_print(void);
+
 /**
  * @}
  */
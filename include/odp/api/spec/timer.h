@@ -275,6 +275,51 @@ int odp_timer_start(odp_timer_t timer, const odp_timer_start_t *start_param);
  */
 int odp_timer_restart(odp_timer_t timer, const odp_timer_start_t *start_param);
 
+/**
+ * Start multiple timers
+ *
+ * Otherwise like odp_timer_start(), but starts multiple timers. Timers are started in array
+ * order, each with the start parameters of the same array index. The call stops on the first
+ * failure. Timers before the failed one remain started, and timers after it are not modified.
+ *
+ * @param timer               Array of timers to be started
+ * @param start_param         Array of timer start parameters
+ * @param num                 Number of timers to start
+ *
+ * @return Number of timers started (1 ... num)
+ * @retval ODP_TIMER_TOO_NEAR Failure to start the first timer. The expiration time passed
+ *                            already, or is too near to the current time.
+ * @retval ODP_TIMER_TOO_FAR  Failure to start the first timer. The expiration time is too far
+ *                            from the current time.
+ * @retval ODP_TIMER_FAIL     Failure to start the first timer. Other failure.
+ */
+int odp_timer_start_multi(const odp_timer_t timer[], const odp_timer_start_t start_param[],
+			  int num);
+
+/**
+ * Restart multiple timers
+ *
+ * Otherwise like odp_timer_restart(), but restarts multiple timers. Timers are restarted in
+ * array order, each with the start parameters of the same array index. The call stops on the
+ * first failure. Timers before the failed one remain restarted, and timers after it are not
+ * modified.
+ *
+ * @param timer               Array of timers to be restarted
+ * @param start_param         Array of timer start parameters. Values of 'tmo_ev' parameters are
+ *                            ignored.
+ * @param num                 Number of timers to restart
+ *
+ * @return Number of timers restarted (1 ... num)
+ * @retval ODP_TIMER_TOO_NEAR Failure to restart the first timer. The new expiration time passed
+ *                            already, or is too near to the current time.
+ * @retval ODP_TIMER_TOO_FAR  Failure to restart the first timer. The new expiration time is too
+ *                            far from the current time.
+ * @retval ODP_TIMER_FAIL     Failure to restart the first timer. The timer expired already, or
+ *                            other failure.
+ */
+int odp_timer_restart_multi(const odp_timer_t timer[], const odp_timer_start_t start_param[],
+			    int num);
+
 /**
  * Start a periodic timer
  *
@@ -437,6 +482,22 @@ int odp_timer_set_rel(odp_timer_t timer, uint64_t rel_tick, odp_event_t *tmo_ev)
  */
 int odp_timer_cancel(odp_timer_t timer, odp_event_t *tmo_ev);
 
+/**
+ * Cancel multiple timers
+ *
+ * Otherwise like odp_timer_cancel(), but attempts to cancel all timers of the array. Timeout
+ * events of successfully cancelled timers are output into 'tmo_ev' array, into the same index
+ * as the timer handle. ODP_EVENT_INVALID is output for timers that were inactive or expired
+ * already.
+ *
+ * @param      timer  Array of timers
+ * @param[out] tmo_ev Array of event handles for output
+ * @param      num    Number of timers to cancel
+ *
+ * @return Number of timers cancelled (0 ... num)
+ */
+int odp_timer_cancel_multi(const odp_timer_t timer[], odp_event_t tmo_ev[], int num);
+
 /**
  * Get timeout handle from a ODP_EVENT_TIMEOUT type event
  *
@@ -115,13 +115,18 @@ typedef union {
 	uint32_t all_flags;
 
 	struct {
-		uint32_t reserved1:      7;
+		uint32_t reserved1:      4;
 
 	/*
 	 * Init flags
 	 */
 		uint32_t user_ptr_set:   1; /* User has set a non-NULL value */
 
+	/*
+	 * Packet input flags
+	 */
+		uint32_t reass_status:   2; /* Reassembly status */
+
 	/*
 	 * Packet output flags
 	 */
@@ -134,6 +139,7 @@ typedef union {
 		uint32_t ts_set:         1; /* Set Tx timestamp */
 		uint32_t tx_compl:       1; /* Tx completion event requested */
 		uint32_t tx_aging:       1; /* Packet aging at Tx requested */
+		uint32_t proto_stats:    1; /* Proto stats update requested */
 		uint32_t shaper_len_adj: 8; /* Adjustment for traffic mgr */
 
 	/*
@@ -150,8 +156,8 @@ typedef union {
 
 	/* Flag groups */
 	struct {
-		uint32_t reserved2:      7;
-		uint32_t other:         18; /* All other flags */
+		uint32_t reserved2:      4;
+		uint32_t other:         21; /* All other flags */
 		uint32_t error:          7; /* All error flags */
 	} all;
 
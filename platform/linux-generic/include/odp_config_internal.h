@@ -37,10 +37,19 @@ extern "C" {
 /*
  * Maximum number of scheduled ODP queues
  *
- * Must be a power of two.
+ * Must be a power of two. The basic queue and scheduler implementations use
+ * this only as the default value, the number of scheduled queues is configured
+ * at run-time (queue_basic.max_sched_queues).
  */
 #define CONFIG_MAX_SCHED_QUEUES 1024
 
+/*
+ * Upper limit for run-time configured number of scheduled ODP queues
+ *
+ * Must be a power of two.
+ */
+#define CONFIG_MAX_SCHED_QUEUES_LIMIT (256 * 1024)
+
 /*
  * Maximum number of queues
  */
@@ -172,6 +181,9 @@ extern "C" {
 /* Enable pool statistics collection */
 #define CONFIG_POOL_STATISTICS 1
 
+/* Enable per thread scheduler and queue enqueue failure statistics collection */
+#define CONFIG_SCHED_STATISTICS 1
+
 /*
  * Maximum number of IPsec SAs. The actual maximum number can be further
  * limited by the number of sessions supported by the crypto subsystem and
@@ -190,6 +190,7 @@ struct ipsec_sa_s {
 
 			/* Only for inbound */
 			unsigned	antireplay : 1;
+			unsigned	reass : 1;
 		};
 	};
 
@@ -303,6 +304,32 @@ typedef struct ODP_PACKED {
 	};
 } ipsec_aad_t;
 
+/* Number of SAs cached per packet input queue */
+#define IPSEC_SA_CACHE_SIZE 4
+
+/* Inline inbound SA cache entry */
+typedef struct {
+	ipsec_sa_t *sa;
+	uint32_t spi;
+	uint8_t proto;
+	uint8_t ver;
+	/* SA use count is held for the current burst */
+	uint8_t held;
+	uint8_t dst_addr[_ODP_IPV6ADDR_LEN];
+} ipsec_sa_cache_entry_t;
+
+/*
+ * Inline inbound (SPI, destination address) to SA cache. A cache is owned by
+ * a packet input queue and used by one thread at a time. Entries are valid
+ * while the SA generation counter stays the same. SA use count is taken once
+ * per burst for each cached SA and released at the end of the burst.
+ */
+typedef struct {
+	uint32_t gen;
+	uint32_t next;
+	ipsec_sa_cache_entry_t entry[IPSEC_SA_CACHE_SIZE];
+} _odp_ipsec_sa_cache_t;
+
 /* Return IV length required for the cipher for IPsec use */
 uint32_t _odp_ipsec_cipher_iv_len(odp_cipher_alg_t cipher);
 
@@ -332,6 +359,11 @@ void _odp_ipsec_sa_unuse(ipsec_sa_t *ipsec_sa);
  */
 ipsec_sa_t *_odp_ipsec_sa_lookup(const ipsec_sa_lookup_t *lookup);
 
+/**
+ * Current SA generation. Generation changes when an SA is created or disabled.
+ */
+uint32_t _odp_ipsec_sa_gen(void);
+
 /**
  * Run pre-check on SA usage statistics.
  *
@@ -375,6 +407,40 @@ uint16_t _odp_ipsec_sa_alloc_ipv4_id(ipsec_sa_t *ipsec_sa);
  */
 int _odp_ipsec_try_inline(odp_packet_t *pkt);
 
+/**
+ * Try inline IPsec processing of a burst of received packets. Packets that
+ * are processed are replaced in the table. SA lookups are done through
+ * the SA cache of the packet input queue.
+ */
+void _odp_ipsec_try_inline_multi(odp_packet_t pkt[], int num,
+				 _odp_ipsec_sa_cache_t *cache);
+
+/**
+ * Initialize inline inbound SA cache
+ */
+void _odp_ipsec_sa_cache_init(_odp_ipsec_sa_cache_t *cache);
+
+/**
+ * Get post-IPsec reassembly configuration of inline inbound processing.
+ *
+ * @retval 1 if reassembly after inline processing is enabled
+ * @retval 0 otherwise
+ */
+int _odp_ipsec_reass_inline_config(odp_reass_config_t *config);
+
+/**
+ * Get reassembly context of an inline processed packet.
+ *
+ * @return Non-zero context (SA specific) if the packet is a candidate for
+ *         post-IPsec reassembly, zero otherwise
+ */
+uint32_t _odp_ipsec_reass_tag(odp_packet_t pkt);
+
+/**
+ * Parse a packet reassembled after inline IPsec processing
+ */
+void _odp_ipsec_reass_parse(odp_packet_t pkt);
+
 /**
  * Populate number of packets and bytes of data successfully processed by the SA
  * in the odp_ipsec_stats_t structure passed.
@@ -153,6 +153,16 @@ typedef struct ODP_ALIGNED_CACHE odp_packet_hdr_t {
 	/* Pktio where packet is used as a memory source */
 	uint8_t ms_pktio_idx;
 
+	/* Number of fragments in a reassembled packet */
+	uint16_t reass_num_frags;
+
+	/* Proto stats object index */
+	uint16_t proto_stats_idx;
+
+	/* Proto stats octet counter adjustments */
+	int32_t proto_stats_adj0;
+	int32_t proto_stats_adj1;
+
 	union {
 		/* Result for crypto packet op */
 		odp_crypto_packet_result_t crypto_op_result;
@@ -333,6 +343,12 @@ static inline void _odp_packet_copy_md(odp_packet_hdr_t *dst_hdr,
 	if (src_hdr->p.flags.payload_off)
 		dst_hdr->payload_offset = src_hdr->payload_offset;
 
+	if (src_hdr->p.flags.proto_stats) {
+		dst_hdr->proto_stats_idx  = src_hdr->proto_stats_idx;
+		dst_hdr->proto_stats_adj0 = src_hdr->proto_stats_adj0;
+		dst_hdr->proto_stats_adj1 = src_hdr->proto_stats_adj1;
+	}
+
 	dst_hdr->p = src_hdr->p;
 
 	if (src_hdr->uarea_addr) {
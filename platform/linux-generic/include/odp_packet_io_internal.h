@@ -18,8 +18,10 @@
 extern "C" {
 #endif
 
+#include <odp/api/atomic.h>
 #include <odp/api/hints.h>
 #include <odp/api/packet_io.h>
+#include <odp/api/proto_stats.h>
 #include <odp/api/spinlock.h>
 #include <odp/api/ticketlock.h>
 
@@ -32,6 +34,7 @@ extern "C" {
 #include <odp_macros_internal.h>
 #include <odp_packet_io_stats_common.h>
 #include <odp_queue_if.h>
+#include <odp_reass_internal.h>
 
 #include <inttypes.h>
 #include <linux/if_ether.h>
@@ -49,6 +52,12 @@ extern "C" {
 
 ODP_STATIC_ASSERT(PKTIO_LSO_PROFILES < UINT8_MAX, "PKTIO_LSO_PROFILES_ERROR");
 
+/* Maximum number of proto stats objects */
+#define PKTIO_PROTO_STATS_MAX 256
+#define PKTIO_PROTO_STATS_NAME_LEN 32
+
+ODP_STATIC_ASSERT(PKTIO_PROTO_STATS_MAX <= UINT16_MAX, "PKTIO_PROTO_STATS_MAX_ERROR");
+
 #define PKTIO_NAME_LEN 256
 
 #define PKTIN_INVALID  ((odp_pktin_queue_t) {ODP_PKTIO_INVALID, 0})
@@ -100,6 +109,10 @@ typedef struct ODP_ALIGNED_CACHE {
 				uint8_t tx_compl : 1;
 				/* Packet aging */
 				uint8_t tx_aging : 1;
+				/* IP reassembly at packet input or after inline IPsec */
+				uint8_t reass : 1;
+				/* Proto stats update at packet output */
+				uint8_t proto_stats : 1;
 			};
 		};
 	} enabled;
@@ -149,6 +162,15 @@ typedef struct ODP_ALIGNED_CACHE {
 	/* Pool for Tx completion events */
 	odp_pool_t tx_compl_pool;
 
+	/* IP reassembly tables per input queue */
+	struct {
+		odp_shm_t shm;
+		_odp_reass_tbl_t *tbl[PKTIO_MAX_QUEUES];
+		_odp_reass_tbl_t *ipsec_tbl[PKTIO_MAX_QUEUES];
+		/* Input queues may be polled concurrently */
+		uint8_t use_lock;
+	} reass;
+
 	/* Storage for queue handles
 	 * Multi-queue support is pktio driver specific */
 	uint32_t num_in_queue;
@@ -182,6 +204,25 @@ typedef struct {
 
 } lso_profile_t;
 
+typedef struct {
+	char name[PKTIO_PROTO_STATS_NAME_LEN];
+	odp_proto_stats_param_t param;
+	int used;
+
+} proto_stats_t;
+
+/* Proto stats counters. Each thread updates only its own copy of the counters (single writer),
+ * other threads only read them. */
+typedef struct {
+	odp_atomic_u64_t tx_pkts;
+	odp_atomic_u64_t tx_pkt_drops;
+	odp_atomic_u64_t tx_oct_count0;
+	odp_atomic_u64_t tx_oct_count0_drops;
+	odp_atomic_u64_t tx_oct_count1;
+	odp_atomic_u64_t tx_oct_count1_drops;
+
+} proto_stats_cnt_t;
+
 /* Global variables */
 typedef struct {
 	odp_spinlock_t lock;
@@ -192,6 +233,10 @@ typedef struct {
 		uint16_t pktin_frame_offset;
 		/* Pool size for potential completion events */
 		uint32_t tx_compl_pool_size;
+		/* IP reassembly options */
+		uint32_t reass_max_flows;
+		uint16_t reass_max_num_frags;
+		uint64_t reass_max_wait_ns;
 	} config;
 
 	pktio_entry_t entries[ODP_CONFIG_PKTIO_ENTRIES];
@@ -199,6 +244,12 @@ typedef struct {
 	lso_profile_t lso_profile[PKTIO_LSO_PROFILES];
 	int num_lso_profiles;
 
+	proto_stats_t proto_stats[PKTIO_PROTO_STATS_MAX];
+
+	/* Per thread proto stats counters: PKTIO_PROTO_STATS_MAX counter sets per thread */
+	odp_shm_t proto_stats_shm;
+	proto_stats_cnt_t *proto_stats_cnt;
+
 } pktio_global_t;
 
 typedef struct pktio_if_ops {
@@ -298,6 +349,11 @@ static inline int _odp_pktio_tx_aging_enabled(pktio_entry_t *entry)
 	return entry->enabled.tx_aging;
 }
 
+static inline int _odp_pktio_proto_stats_enabled(const pktio_entry_t *entry)
+{
+	return entry->enabled.proto_stats;
+}
+
 static inline void _odp_pktio_tx_ts_set(pktio_entry_t *entry)
 {
 	odp_time_t ts_val = odp_time_global();
@@ -343,6 +399,9 @@ int _odp_sock_recv_mq_tmo_try_int_driven(const struct odp_pktin_queue_t queues[]
 int _odp_pktio_pktout_tm_config(odp_pktio_t pktio_hdl,
 				odp_pktout_queue_t *queue, bool reconf);
 
+/* IP reassembly capability shared with IPsec */
+void _odp_pktio_reass_capability(odp_reass_capability_t *capa);
+
 /* LSO functions shared with TM */
 odp_lso_profile_t _odp_lso_prof_from_idx(uint8_t idx);
 
@@ -356,6 +415,9 @@ int _odp_lso_create_packets(odp_packet_t packet, const odp_packet_lso_opt_t *lso
 void _odp_pktio_allocate_and_send_tx_compl_events(const pktio_entry_t *entry,
 						  const odp_packet_t packets[], int num);
 
+/* Update proto stats drop counters of packets that are dropped at packet output */
+void _odp_pktio_proto_stats_drop(const odp_packet_t packets[], int num);
+
 static inline int _odp_pktio_packet_to_pool(odp_packet_t *pkt,
 					    odp_packet_hdr_t **pkt_hdr,
 					    odp_pool_t new_pool)
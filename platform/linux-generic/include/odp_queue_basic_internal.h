@@ -12,6 +12,7 @@ extern "C" {
 #endif
 
 #include <odp/api/plat/strong_types.h>
+#include <odp/api/plat/thread_inlines.h>
 #include <odp/api/queue.h>
 #include <odp/api/shared_memory.h>
 #include <odp_forward_typedefs_internal.h>
@@ -24,7 +25,6 @@ extern "C" {
 #include <odp_config_internal.h>
 #include <odp_macros_internal.h>
 #include <odp_ring_mpmc_internal.h>
-#include <odp_ring_st_internal.h>
 #include <odp_ring_spsc_internal.h>
 #include <odp_queue_lf.h>
 
@@ -50,10 +50,7 @@ typedef struct ODP_ALIGNED_CACHE queue_entry_s {
 	ring_mpmc_t          ring_mpmc;
 
 	odp_ticketlock_t     lock;
-	union {
-		ring_st_t    ring_st;
-		ring_spsc_t  ring_spsc;
-	};
+	ring_spsc_t          ring_spsc;
 
 	odp_atomic_u64_t     num_timers;
 	int                  status;
@@ -67,8 +64,14 @@ typedef struct ODP_ALIGNED_CACHE queue_entry_s {
 	char              name[ODP_QUEUE_NAME_LEN];
 } queue_entry_t;
 
+/* Per thread queue statistics. Updated only by the owner thread. */
+typedef struct ODP_ALIGNED_CACHE {
+	/* Number of events that could not be enqueued */
+	uint64_t enq_fail;
+
+} queue_thr_stat_t;
+
 typedef struct queue_global_t {
-	queue_entry_t   queue[CONFIG_MAX_QUEUES];
 	uint32_t        *ring_data;
 	uint32_t        queue_lf_num;
 	uint32_t        queue_lf_size;
@@ -79,8 +82,17 @@ typedef struct queue_global_t {
 	struct {
 		uint32_t max_queue_size;
 		uint32_t default_queue_size;
+		uint32_t max_sched_queues;
+		/* Total number of queues (internal, plain and scheduled) */
+		uint32_t max_queues;
 	} config;
 
+	queue_thr_stat_t thr_stat[ODP_THREAD_COUNT_MAX];
+
+	/* Queue entries. Scheduled queues use indexes from zero to
+	 * config.max_sched_queues - 1. */
+	queue_entry_t   queue[];
+
 } queue_global_t;
 
 extern queue_global_t *_odp_queue_glb;
@@ -107,6 +119,14 @@ static inline queue_entry_t *qentry_from_handle(odp_queue_t handle)
 	return (queue_entry_t *)(uintptr_t)handle;
 }
 
+/* Count events that could not be enqueued. Enqueues from non-ODP threads
+ * (e.g. timer threads) are not counted, as those do not have a thread id. */
+static inline void _odp_queue_enq_fail_stat(int num)
+{
+	if (CONFIG_SCHED_STATISTICS && _odp_this_thread)
+		_odp_queue_glb->thr_stat[_odp_this_thread->thr].enq_fail += num;
+}
+
 void _odp_queue_spsc_init(queue_entry_t *queue, uint32_t queue_size);
 
 /* Functions for schedulers */
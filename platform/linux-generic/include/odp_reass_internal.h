@@ -0,0 +1,186 @@
+/* Copyright (c) 2022, Nokia
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier:     BSD-3-Clause
+ */
+
+/**
+ * @file
+ *
+ * ODP IP fragment reassembly - implementation internal
+ */
+
+#ifndef ODP_REASS_INTERNAL_H_
+#define ODP_REASS_INTERNAL_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <odp/api/hints.h>
+#include <odp/api/packet.h>
+#include <odp/api/reassembly.h>
+#include <odp/api/spinlock.h>
+
+#include <stdint.h>
+
+/* Result of offering a packet to a reassembly table */
+typedef enum {
+	/* Packet is not a fragment or cannot be reassembled, deliver it as is */
+	_ODP_REASS_PASS = 0,
+
+	/* Fragment was stored into the table */
+	_ODP_REASS_STORED,
+
+	/* Fragment completed a datagram. Packet handle was replaced by the
+	 * reassembled packet. */
+	_ODP_REASS_COMPLETE,
+
+	/* Fragment and the datagram it belongs to were freed due to an error
+	 * (overlap, bad length, too many fragments, out of resources). */
+	_ODP_REASS_DROP
+
+} _odp_reass_result_t;
+
+/* Stored fragment */
+typedef struct {
+	odp_packet_t pkt;
+
+	/* Payload offset and length within the original datagram */
+	uint32_t offset;
+	uint32_t len;
+
+	/* Payload start offset from packet start */
+	uint16_t hdr_len;
+
+} _odp_reass_frag_t;
+
+/* Datagram key */
+typedef struct {
+	/* IPv4 addresses are stored into the first word */
+	uint32_t src[4];
+	uint32_t dst[4];
+	uint32_t id;
+
+	/* Extra key context, e.g. SA index for post-IPsec reassembly */
+	uint32_t tag;
+
+	uint8_t  proto;
+	uint8_t  ipv6;
+
+} _odp_reass_key_t;
+
+/* Datagram under reassembly */
+typedef struct {
+	_odp_reass_key_t key;
+
+	/* Reception time of the first received fragment */
+	uint64_t first_ns;
+
+	/* Hash chain and age list links (flow indexes) */
+	uint32_t next;
+	uint32_t age_prev;
+	uint32_t age_next;
+
+	/* Datagram payload length. Zero until the last fragment is seen. */
+	uint32_t total_len;
+
+	/* Sum of received payload bytes */
+	uint32_t recv_len;
+
+	uint16_t num_frags;
+
+} _odp_reass_flow_t;
+
+/* Fragment table. A table is used by one packet input queue at a time, so
+ * normally no synchronization is needed. The lock is taken only when the
+ * input queue may be polled by multiple threads concurrently. */
+typedef struct {
+	odp_spinlock_t lock;
+	uint8_t use_lock;
+	uint8_t en_ipv4;
+	uint8_t en_ipv6;
+
+	uint32_t max_flows;
+	uint32_t max_frags;
+	uint32_t hash_mask;
+	uint64_t wait_ns;
+
+	/* Number of flows in use */
+	uint32_t num_active;
+
+	/* Expiry time of the oldest datagram, UINT64_MAX when there is none.
+	 * May be read without the lock. */
+	uint64_t expire_ns;
+
+	/* Free flow stack and age list (oldest first) */
+	uint32_t free_head;
+	uint32_t age_head;
+	uint32_t age_tail;
+
+	uint32_t *bucket;
+	_odp_reass_flow_t *flow;
+	_odp_reass_frag_t *frag;
+
+} _odp_reass_tbl_t;
+
+/* Data of an incomplete reassembly result packet */
+typedef struct {
+	/* Reception time of the first received fragment */
+	uint64_t first_ns;
+
+	uint16_t num_frags;
+
+	odp_packet_t frag[];
+
+} _odp_reass_partial_t;
+
+/* Memory needed for a table */
+uint64_t _odp_reass_tbl_size(uint32_t max_flows, uint32_t max_frags);
+
+/* Initialize a table. Table memory must be at least _odp_reass_tbl_size()
+ * bytes. */
+void _odp_reass_tbl_init(_odp_reass_tbl_t *tbl, uint32_t max_flows,
+			 const odp_reass_config_t *config, uint64_t max_wait_ns,
+			 int use_lock);
+
+/* Free all stored fragments */
+void _odp_reass_tbl_flush(_odp_reass_tbl_t *tbl);
+
+/* Offer a packet to reassembly. Caller holds the table lock (if used) and
+ * has checked that the packet is an IP packet with valid L3 offset. */
+_odp_reass_result_t _odp_reass_packet(_odp_reass_tbl_t *tbl, odp_packet_t *pkt,
+				      uint32_t tag, uint64_t now_ns);
+
+/* Output incomplete reassembly packets for datagrams that have waited too
+ * long. Outputs up to 'num' packets. Number of datagrams dropped due to
+ * packet allocation failures is added into 'num_drop'. */
+int _odp_reass_expire(_odp_reass_tbl_t *tbl, uint64_t now_ns,
+		      odp_packet_t pkt[], int num, uint32_t *num_drop);
+
+/* Check if there are datagrams to be expired */
+static inline int _odp_reass_expire_pending(const _odp_reass_tbl_t *tbl,
+					    uint64_t now_ns)
+{
+	/* Time stamp may be older than the oldest datagram when the table is
+	 * shared between threads */
+	return now_ns >= tbl->expire_ns;
+}
+
+static inline void _odp_reass_lock(_odp_reass_tbl_t *tbl)
+{
+	if (odp_unlikely(tbl->use_lock))
+		odp_spinlock_lock(&tbl->lock);
+}
+
+static inline void _odp_reass_unlock(_odp_reass_tbl_t *tbl)
+{
+	if (odp_unlikely(tbl->use_lock))
+		odp_spinlock_unlock(&tbl->lock);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
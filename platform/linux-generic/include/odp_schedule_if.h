@@ -133,6 +133,7 @@ typedef struct {
 	void (*schedule_order_lock_wait)(uint32_t lock_index);
 	void (*schedule_order_wait)(void);
 	void (*schedule_print)(void);
+	void (*schedule_stats_print)(void);
 
 } schedule_api_t;
 
@@ -10,6 +10,7 @@
 #include <odp/api/chksum.h>
 
 #include <odp/api/plat/packet_inlines.h>
+#include <odp/api/plat/packet_flag_inlines.h>
 #include <odp/api/plat/byteorder_inlines.h>
 #include <odp/api/plat/queue_inlines.h>
 
@@ -178,11 +179,9 @@ int odp_ipsec_capability(odp_ipsec_capability_t *capa)
 
 	capa->test.sa_operations.seq_num = 1;
 
-	capa->reassembly.ip = false;
-	capa->reassembly.ipv4 = false;
-	capa->reassembly.ipv6 = false;
+	_odp_pktio_reass_capability(&capa->reassembly);
 	capa->reass_async = false;
-	capa->reass_inline = false;
+	capa->reass_inline = true;
 
 	return 0;
 }
@@ -296,9 +295,26 @@ void odp_ipsec_config_init(odp_ipsec_config_t *config)
 
 int odp_ipsec_config(const odp_ipsec_config_t *config)
 {
+	const odp_reass_config_t *reass = &config->inbound.reassembly;
+	odp_reass_capability_t reass_capa;
+
 	if (config->max_num_sa > _odp_ipsec_max_num_sa())
 		return -1;
 
+	/* Reassembly is supported only in inline mode */
+	if (config->inbound.reass_async)
+		return -1;
+
+	_odp_pktio_reass_capability(&reass_capa);
+
+	if (config->inbound.reass_inline && (reass->en_ipv4 || reass->en_ipv6) &&
+	    (reass->max_num_frags < 2 ||
+	     reass->max_num_frags > reass_capa.max_num_frags ||
+	     reass->max_wait_time > reass_capa.max_wait_time)) {
+		ODP_ERR("Bad reassembly configuration\n");
+		return -1;
+	}
+
 	*ipsec_config = *config;
 
 	return 0;
@@ -400,6 +416,8 @@ typedef struct {
 		} esp;
 	};
 	uint8_t	iv[IPSEC_MAX_IV_LEN];
+	/* Inline inbound SA cache or NULL */
+	_odp_ipsec_sa_cache_t *sa_cache;
 } ipsec_state_t;
 
 /*
@@ -492,11 +510,96 @@ static int ipsec_parse_ipv6(ipsec_state_t *state, odp_packet_t pkt)
 	return 0;
 }
 
+void _odp_ipsec_sa_cache_init(_odp_ipsec_sa_cache_t *cache)
+{
+	memset(cache, 0, sizeof(_odp_ipsec_sa_cache_t));
+}
+
+static inline int ipsec_sa_cache_match(const ipsec_sa_cache_entry_t *entry,
+				       const ipsec_sa_lookup_t *lookup)
+{
+	return entry->sa != NULL &&
+	       entry->spi == lookup->spi &&
+	       entry->proto == lookup->proto &&
+	       entry->ver == lookup->ver &&
+	       !memcmp(entry->dst_addr, lookup->dst_addr,
+		       lookup->ver == ODP_IPSEC_IPV4 ?
+				_ODP_IPV4ADDR_LEN : _ODP_IPV6ADDR_LEN);
+}
+
+/* Lookup SA from the cache. SA use count is taken on the first hit of the
+ * burst and held until the end of the burst. */
+static ipsec_sa_t *ipsec_sa_cache_lookup(_odp_ipsec_sa_cache_t *cache,
+					 const ipsec_sa_lookup_t *lookup)
+{
+	for (int i = 0; i < IPSEC_SA_CACHE_SIZE; i++) {
+		ipsec_sa_cache_entry_t *entry = &cache->entry[i];
+
+		if (!ipsec_sa_cache_match(entry, lookup))
+			continue;
+
+		if (odp_likely(entry->held))
+			return entry->sa;
+
+		if (_odp_ipsec_sa_use(entry->sa->ipsec_sa_hdl) == NULL) {
+			entry->sa = NULL;
+			return NULL;
+		}
+
+		/* SA table may have changed after the burst was started */
+		if (odp_unlikely(_odp_ipsec_sa_gen() != cache->gen)) {
+			_odp_ipsec_sa_unuse(entry->sa);
+			entry->sa = NULL;
+			return NULL;
+		}
+
+		entry->held = 1;
+		return entry->sa;
+	}
+
+	return NULL;
+}
+
+/* Insert a looked up SA into the cache. Cache takes over the SA reference. */
+static void ipsec_sa_cache_insert(_odp_ipsec_sa_cache_t *cache,
+				  const ipsec_sa_lookup_t *lookup,
+				  ipsec_sa_t *ipsec_sa)
+{
+	ipsec_sa_cache_entry_t *entry = &cache->entry[cache->next];
+
+	cache->next = (cache->next + 1) % IPSEC_SA_CACHE_SIZE;
+
+	if (entry->sa != NULL && entry->held)
+		_odp_ipsec_sa_unuse(entry->sa);
+
+	entry->sa = ipsec_sa;
+	entry->spi = lookup->spi;
+	entry->proto = lookup->proto;
+	entry->ver = lookup->ver;
+	entry->held = 1;
+	memcpy(entry->dst_addr, lookup->dst_addr,
+	       lookup->ver == ODP_IPSEC_IPV4 ? _ODP_IPV4ADDR_LEN : _ODP_IPV6ADDR_LEN);
+}
+
+/* Release SA references held by the cache */
+static void ipsec_sa_cache_release(_odp_ipsec_sa_cache_t *cache)
+{
+	for (int i = 0; i < IPSEC_SA_CACHE_SIZE; i++) {
+		ipsec_sa_cache_entry_t *entry = &cache->entry[i];
+
+		if (entry->held) {
+			_odp_ipsec_sa_unuse(entry->sa);
+			entry->held = 0;
+		}
+	}
+}
+
 static inline ipsec_sa_t *ipsec_get_sa(odp_ipsec_sa_t sa,
 				       odp_ipsec_protocol_t proto,
 				       uint32_t spi,
 				       odp_ipsec_ip_version_t ver,
 				       void *dst_addr,
+				       _odp_ipsec_sa_cache_t *cache,
 				       odp_ipsec_op_status_t *status)
 {
 	ipsec_sa_t *ipsec_sa;
@@ -509,11 +612,20 @@ static inline ipsec_sa_t *ipsec_get_sa(odp_ipsec_sa_t sa,
 		lookup.ver = ver;
 		lookup.dst_addr = dst_addr;
 
+		if (cache) {
+			ipsec_sa = ipsec_sa_cache_lookup(cache, &lookup);
+			if (odp_likely(ipsec_sa))
+				return ipsec_sa;
+		}
+
 		ipsec_sa = _odp_ipsec_sa_lookup(&lookup);
 		if (NULL == ipsec_sa) {
 			status->error.sa_lookup = 1;
 			return NULL;
 		}
+
+		if (cache)
+			ipsec_sa_cache_insert(cache, &lookup, ipsec_sa);
 	} else {
 		ipsec_sa = _odp_ipsec_sa_entry_from_hdl(sa);
 		ODP_ASSERT(NULL != ipsec_sa);
@@ -592,7 +704,7 @@ static int ipsec_in_esp(odp_packet_t *pkt,
 				odp_be_to_cpu_32(esp.spi),
 				state->is_ipv4 ? ODP_IPSEC_IPV4 :
 						ODP_IPSEC_IPV6,
-				&state->ipv4_addr, status);
+				&state->ipv4_addr, state->sa_cache, status);
 	*_ipsec_sa = ipsec_sa;
 	if (status->error.all)
 		return -1;
@@ -719,7 +831,7 @@ static int ipsec_in_ah(odp_packet_t *pkt,
 				odp_be_to_cpu_32(ah.spi),
 				state->is_ipv4 ? ODP_IPSEC_IPV4 :
 						ODP_IPSEC_IPV6,
-				&state->ipv4_addr, status);
+				&state->ipv4_addr, state->sa_cache, status);
 	*_ipsec_sa = ipsec_sa;
 	if (status->error.all)
 		return -1;
@@ -864,7 +976,8 @@ static ipsec_sa_t *ipsec_in_single(odp_packet_t pkt,
 				   odp_packet_t *pkt_out,
 				   odp_bool_t enqueue_op,
 				   odp_ipsec_op_status_t *status,
-				   uint32_t *orig_ip_len)
+				   uint32_t *orig_ip_len,
+				   _odp_ipsec_sa_cache_t *sa_cache)
 {
 	ipsec_state_t state;
 	ipsec_sa_t *ipsec_sa = NULL;
@@ -878,6 +991,8 @@ static ipsec_sa_t *ipsec_in_single(odp_packet_t pkt,
 	state.ip = odp_packet_l3_ptr(pkt, NULL);
 	ODP_ASSERT(NULL != state.ip);
 
+	state.sa_cache = sa_cache;
+
 	/* Initialize parameters block */
 	memset(&param, 0, sizeof(param));
 
@@ -1689,24 +1804,34 @@ static void ipsec_out_checksums(odp_packet_t pkt,
 		   sctp_chksum_pkt;
 	odp_packet_hdr_t *pkt_hdr = packet_hdr(pkt);
 	odp_ipsec_outbound_config_t outbound = ipsec_config->outbound;
+	uint8_t l4_proto = state->ip_next_hdr;
+
+	/* L4 checksum of a fragmented datagram cannot be calculated from a
+	 * single fragment */
+	if (state->is_ipv4) {
+		_odp_ipv4hdr_t *ipv4hdr = state->ip;
+
+		if (_ODP_IPV4HDR_IS_FRAGMENT(odp_be_to_cpu_16(ipv4hdr->frag_offset)))
+			l4_proto = _ODP_IPPROTO_NO_NEXT;
+	}
 
 	ipv4_chksum_pkt = OL_TX_CHKSUM_PKT(outbound.chksum.inner_ipv4,
 					   state->is_ipv4,
 					   pkt_hdr->p.flags.l3_chksum_set,
 					   pkt_hdr->p.flags.l3_chksum);
 	udp_chksum_pkt =  OL_TX_CHKSUM_PKT(outbound.chksum.inner_udp,
-					   state->ip_next_hdr ==
+					   l4_proto ==
 					   _ODP_IPPROTO_UDP,
 					   pkt_hdr->p.flags.l4_chksum_set,
 					   pkt_hdr->p.flags.l4_chksum);
 	tcp_chksum_pkt =  OL_TX_CHKSUM_PKT(outbound.chksum.inner_tcp,
-					   state->ip_next_hdr ==
+					   l4_proto ==
 					   _ODP_IPPROTO_TCP,
 					   pkt_hdr->p.flags.l4_chksum_set,
 					   pkt_hdr->p.flags.l4_chksum);
 
 	sctp_chksum_pkt =  OL_TX_CHKSUM_PKT(outbound.chksum.inner_sctp,
-					    state->ip_next_hdr ==
+					    l4_proto ==
 					    _ODP_IPPROTO_SCTP,
 					    pkt_hdr->p.flags.l4_chksum_set,
 					    pkt_hdr->p.flags.l4_chksum);
@@ -1937,7 +2062,7 @@ int odp_ipsec_in(const odp_packet_t pkt_in[], int num_in,
 			ODP_ASSERT(ODP_IPSEC_SA_INVALID != sa);
 		}
 
-		ipsec_sa = ipsec_in_single(pkt, sa, &pkt, false, &status, &dummy);
+		ipsec_sa = ipsec_in_single(pkt, sa, &pkt, false, &status, &dummy, NULL);
 
 		packet_subtype_set(pkt, ODP_EVENT_PACKET_IPSEC);
 		result = ipsec_pkt_result(pkt);
@@ -2051,7 +2176,8 @@ int odp_ipsec_in_enq(const odp_packet_t pkt_in[], int num_in,
 			ODP_ASSERT(ODP_IPSEC_SA_INVALID != sa);
 		}
 
-		ipsec_sa = ipsec_in_single(pkt, sa, &pkt, true, &status, &orig_ip_len);
+		ipsec_sa = ipsec_in_single(pkt, sa, &pkt, true, &status, &orig_ip_len,
+					   NULL);
 
 		packet_subtype_set(pkt, ODP_EVENT_PACKET_IPSEC);
 		result = ipsec_pkt_result(pkt);
@@ -2145,7 +2271,7 @@ int odp_ipsec_out_enq(const odp_packet_t pkt_in[], int num_in,
 	return in_pkt;
 }
 
-int _odp_ipsec_try_inline(odp_packet_t *pkt)
+static int ipsec_try_inline(odp_packet_t *pkt, _odp_ipsec_sa_cache_t *sa_cache)
 {
 	odp_ipsec_op_status_t status;
 	ipsec_sa_t *ipsec_sa;
@@ -2153,13 +2279,10 @@ int _odp_ipsec_try_inline(odp_packet_t *pkt)
 	odp_ipsec_packet_result_t *result;
 	odp_packet_hdr_t *pkt_hdr;
 
-	if (odp_global_ro.disable.ipsec)
-		return -1;
-
 	memset(&status, 0, sizeof(status));
 
 	ipsec_sa = ipsec_in_single(*pkt, ODP_IPSEC_SA_INVALID, pkt, false,
-				   &status, &orig_ip_len);
+				   &status, &orig_ip_len, sa_cache);
 	/*
 	 * Route packet back in case of lookup failure or early error before
 	 * lookup
@@ -2181,12 +2304,102 @@ int _odp_ipsec_try_inline(odp_packet_t *pkt)
 	/* Distinguish inline IPsec packets from classifier packets */
 	pkt_hdr->cos = CLS_COS_IDX_NONE;
 
-	/* Last thing */
-	_odp_ipsec_sa_unuse(ipsec_sa);
+	/* Last thing. SA references of cached lookups are released at the end
+	 * of the burst. */
+	if (sa_cache == NULL)
+		_odp_ipsec_sa_unuse(ipsec_sa);
 
 	return 0;
 }
 
+int _odp_ipsec_try_inline(odp_packet_t *pkt)
+{
+	if (odp_global_ro.disable.ipsec)
+		return -1;
+
+	return ipsec_try_inline(pkt, NULL);
+}
+
+void _odp_ipsec_try_inline_multi(odp_packet_t pkt[], int num,
+				 _odp_ipsec_sa_cache_t *cache)
+{
+	uint32_t gen;
+
+	if (odp_global_ro.disable.ipsec)
+		return;
+
+	/* Cached SAs are not held between bursts. Flush the cache if SAs have
+	 * been created or disabled since the previous burst. */
+	gen = _odp_ipsec_sa_gen();
+	if (odp_unlikely(gen != cache->gen)) {
+		memset(cache->entry, 0, sizeof(cache->entry));
+		cache->gen = gen;
+	}
+
+	for (int i = 0; i < num; i++) {
+		odp_packet_hdr_t *pkt_hdr = packet_hdr(pkt[i]);
+
+		if (pkt_hdr->p.flags.ip_err || !odp_packet_has_ipsec(pkt[i]))
+			continue;
+
+		ipsec_try_inline(&pkt[i], cache);
+	}
+
+	ipsec_sa_cache_release(cache);
+}
+
+int _odp_ipsec_reass_inline_config(odp_reass_config_t *config)
+{
+	const odp_reass_config_t *reass = &ipsec_config->inbound.reassembly;
+
+	if (odp_global_ro.disable.ipsec || !ipsec_config->inbound.reass_inline ||
+	    !(reass->en_ipv4 || reass->en_ipv6))
+		return 0;
+
+	*config = *reass;
+	return 1;
+}
+
+uint32_t _odp_ipsec_reass_tag(odp_packet_t pkt)
+{
+	odp_ipsec_packet_result_t *result = ipsec_pkt_result(pkt);
+	ipsec_sa_t *ipsec_sa;
+
+	if (!result->flag.inline_mode || result->status.all != ODP_IPSEC_OK)
+		return 0;
+
+	ipsec_sa = _odp_ipsec_sa_entry_from_hdl(result->sa);
+	if (!ipsec_sa->reass)
+		return 0;
+
+	/* Fragments are reassembled only with other fragments of the same SA */
+	return ipsec_sa->ipsec_sa_idx + 1;
+}
+
+void _odp_ipsec_reass_parse(odp_packet_t pkt)
+{
+	odp_packet_hdr_t *pkt_hdr = packet_hdr(pkt);
+	uint32_t l3_offset = pkt_hdr->p.l3_offset;
+	odp_packet_parse_param_t parse_param;
+	odp_queue_t dst_queue = pkt_hdr->dst_queue;
+	uint8_t ver_ihl;
+
+	if (odp_packet_copy_to_mem(pkt, l3_offset, 1, &ver_ihl))
+		return;
+
+	parse_param.proto = _ODP_IPV4HDR_VER(ver_ihl) == _ODP_IPV4 ?
+		ODP_PROTO_IPV4 : ODP_PROTO_IPV6;
+	parse_param.last_layer = ipsec_config->inbound.parse_level;
+	parse_param.chksums = ipsec_config->inbound.chksums;
+
+	if (odp_packet_parse(pkt, l3_offset, &parse_param))
+		pkt_hdr->p.l3_offset = l3_offset;
+
+	/* Parsing resets input flags */
+	pkt_hdr->p.input_flags.dst_queue = 1;
+	pkt_hdr->dst_queue = dst_queue;
+}
+
 #define MAX_HDR_LEN 100 /* Enough for VxLAN over IPv6 */
 
 int odp_ipsec_out_inline(const odp_packet_t pkt_in[], int num_in,
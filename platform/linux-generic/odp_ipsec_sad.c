@@ -111,6 +111,8 @@ typedef struct ipsec_sa_table_t {
 	} sa_freelist;
 	uint32_t max_num_sa;
 	odp_shm_t shm;
+	/* Incremented when SA lookup results may change */
+	odp_atomic_u32_t sa_gen ODP_ALIGNED_CACHE;
 	ipsec_thread_local_t per_thread[];
 } ipsec_sa_table_t;
 
@@ -189,6 +191,7 @@ int _odp_ipsec_sad_init_global(void)
 	memset(ipsec_sa_tbl, 0, sizeof(ipsec_sa_table_t));
 	ipsec_sa_tbl->shm = shm;
 	ipsec_sa_tbl->max_num_sa = max_num_sa;
+	odp_atomic_init_u32(&ipsec_sa_tbl->sa_gen, 0);
 
 	ring_mpmc_init(&ipsec_sa_tbl->hot.ipv4_id_ring);
 	for (i = 0; i < thread_count_max; i++) {
@@ -297,6 +300,12 @@ static void ipsec_sa_release(ipsec_sa_t *ipsec_sa)
 static void ipsec_sa_publish(ipsec_sa_t *ipsec_sa)
 {
 	odp_atomic_store_rel_u32(&ipsec_sa->state, IPSEC_SA_STATE_ACTIVE);
+	odp_atomic_inc_u32(&ipsec_sa_tbl->sa_gen);
+}
+
+uint32_t _odp_ipsec_sa_gen(void)
+{
+	return odp_atomic_load_acq_u32(&ipsec_sa_tbl->sa_gen);
 }
 
 static int ipsec_sa_lock(ipsec_sa_t *ipsec_sa)
@@ -533,6 +542,8 @@ odp_ipsec_sa_t odp_ipsec_sa_create(const odp_ipsec_sa_param_t *param)
 
 		if (ipsec_antireplay_init(ipsec_sa, param))
 			goto error;
+
+		ipsec_sa->reass = !!param->inbound.reassembly_en;
 	} else {
 		ipsec_sa->lookup_mode = ODP_IPSEC_LOOKUP_DISABLED;
 		odp_atomic_init_u64(&ipsec_sa->hot.out.seq, 1);
@@ -780,6 +791,9 @@ int odp_ipsec_sa_disable(odp_ipsec_sa_t sa)
 					     state | IPSEC_SA_STATE_DISABLE);
 	}
 
+	/* Invalidate inline SA caches */
+	odp_atomic_inc_u32(&ipsec_sa_tbl->sa_gen);
+
 	if (ODP_QUEUE_INVALID != ipsec_sa->queue) {
 		odp_ipsec_warn_t warn = { .all = 0 };
 
@@ -1206,7 +1220,7 @@ static void ipsec_in_sa_info(ipsec_sa_t *ipsec_sa, odp_ipsec_sa_info_t *sa_info)
 	sa_info->param.inbound.antireplay_ws = ipsec_sa->sa_info.in.antireplay_ws;
 	sa_info->param.inbound.pipeline = ODP_IPSEC_PIPELINE_NONE;
 	sa_info->param.inbound.dest_cos = ODP_COS_INVALID;
-	sa_info->param.inbound.reassembly_en = false;
+	sa_info->param.inbound.reassembly_en = ipsec_sa->reass;
 
 	if (ipsec_sa->lookup_mode == ODP_IPSEC_LOOKUP_DSTADDR_SPI) {
 		if (ipsec_sa->in.lookup_ver == ODP_IPSEC_IPV4)
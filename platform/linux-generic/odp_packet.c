@@ -14,6 +14,7 @@
 #include <odp/api/packet_flags.h>
 #include <odp/api/packet_io.h>
 #include <odp/api/proto_stats.h>
+#include <odp/api/time.h>
 #include <odp/api/timer.h>
 
 #include <odp_parse_internal.h>
@@ -1798,6 +1799,7 @@ static inline int packet_ipv4_chksum(odp_packet_t pkt,
 #define _ODP_IPV4HDR_CSUM_OFFSET ODP_OFFSETOF(_odp_ipv4hdr_t, chksum)
 #define _ODP_UDP_LEN_OFFSET ODP_OFFSETOF(_odp_udphdr_t, length)
 #define _ODP_UDP_CSUM_OFFSET ODP_OFFSETOF(_odp_udphdr_t, chksum)
+#define _ODP_TCP_CSUM_OFFSET ODP_OFFSETOF(_odp_tcphdr_t, cksm)
 
 /**
  * Calculate and fill in IPv4 checksum
@@ -1868,7 +1870,7 @@ static int _odp_packet_tcp_udp_chksum_insert(odp_packet_t pkt, uint16_t proto)
 	if (proto == _ODP_IPPROTO_TCP) {
 		sum += odp_cpu_to_be_16(pkt_hdr->frame_len -
 					 pkt_hdr->p.l4_offset);
-		chksum_offset = pkt_hdr->p.l4_offset + _ODP_UDP_CSUM_OFFSET;
+		chksum_offset = pkt_hdr->p.l4_offset + _ODP_TCP_CSUM_OFFSET;
 	} else {
 		sum += packet_sum_partial(pkt_hdr,
 					  pkt_hdr->p.l3_offset,
@@ -2411,25 +2413,39 @@ void *odp_packet_tx_compl_user_ptr(odp_packet_tx_compl_t tx_compl)
 odp_packet_reass_status_t
 odp_packet_reass_status(odp_packet_t pkt)
 {
-	(void)pkt;
-	return ODP_PACKET_REASS_NONE;
+	return packet_hdr(pkt)->p.flags.reass_status;
 }
 
 int odp_packet_reass_info(odp_packet_t pkt, odp_packet_reass_info_t *info)
 {
-	(void)pkt;
-	(void)info;
-	return -1;
+	odp_packet_hdr_t *pkt_hdr = packet_hdr(pkt);
+
+	if (pkt_hdr->p.flags.reass_status != ODP_PACKET_REASS_COMPLETE)
+		return -1;
+
+	info->num_frags = pkt_hdr->reass_num_frags;
+	return 0;
 }
 
 int
 odp_packet_reass_partial_state(odp_packet_t pkt, odp_packet_t frags[],
 			       odp_packet_reass_partial_state_t *res)
 {
-	(void)pkt;
-	(void)frags;
-	(void)res;
-	return -ENOTSUP;
+	odp_packet_hdr_t *pkt_hdr = packet_hdr(pkt);
+	_odp_reass_partial_t partial;
+
+	if (pkt_hdr->p.flags.reass_status != ODP_PACKET_REASS_INCOMPLETE)
+		return -1;
+
+	odp_packet_copy_to_mem(pkt, 0, sizeof(partial), &partial);
+	odp_packet_copy_to_mem(pkt, sizeof(partial), partial.num_frags * sizeof(odp_packet_t),
+			       frags);
+
+	res->num_frags    = partial.num_frags;
+	res->elapsed_time = odp_time_global_ns() - partial.first_ns;
+
+	odp_packet_free(pkt);
+	return 0;
 }
 
 static inline odp_packet_hdr_t *packet_buf_to_hdr(odp_packet_buf_t pkt_buf)
@@ -2590,13 +2606,25 @@ odp_packet_t odp_packet_reassemble(odp_pool_t pool_hdl, odp_packet_buf_t pkt_buf
 
 void odp_packet_proto_stats_request(odp_packet_t pkt, odp_packet_proto_stats_opt_t *opt)
 {
-	(void)pkt;
-	(void)opt;
+	odp_packet_hdr_t *pkt_hdr = packet_hdr(pkt);
+
+	if (opt == NULL || opt->stat == ODP_PROTO_STATS_INVALID) {
+		pkt_hdr->p.flags.proto_stats = 0;
+		return;
+	}
+
+	pkt_hdr->p.flags.proto_stats = 1;
+	pkt_hdr->proto_stats_idx = _odp_typeval(opt->stat) - 1;
+	pkt_hdr->proto_stats_adj0 = opt->oct_count0_adj;
+	pkt_hdr->proto_stats_adj1 = opt->oct_count1_adj;
 }
 
 odp_proto_stats_t odp_packet_proto_stats(odp_packet_t pkt)
 {
-	(void)pkt;
+	odp_packet_hdr_t *pkt_hdr = packet_hdr(pkt);
+
+	if (!pkt_hdr->p.flags.proto_stats)
+		return ODP_PROTO_STATS_INVALID;
 
-	return ODP_PROTO_STATS_INVALID;
+	return _odp_cast_scalar(odp_proto_stats_t, pkt_hdr->proto_stats_idx + 1);
 }
@@ -9,10 +9,12 @@
 
 #include <odp/api/buffer.h>
 #include <odp/api/packet.h>
+#include <odp/api/packet_flags.h>
 #include <odp/api/packet_io.h>
 #include <odp/api/proto_stats.h>
 #include <odp/api/shared_memory.h>
 #include <odp/api/spinlock.h>
+#include <odp/api/thread.h>
 #include <odp/api/ticketlock.h>
 #include <odp/api/time.h>
 
@@ -27,10 +29,13 @@
 #include <odp_debug_internal.h>
 #include <odp_errno_define.h>
 #include <odp_event_vector_internal.h>
+#include <odp_global_data.h>
 #include <odp_init_internal.h>
+#include <odp_ipsec_internal.h>
 #include <odp_libconfig_internal.h>
 #include <odp_packet_internal.h>
 #include <odp_packet_io_internal.h>
+#include <odp_parse_internal.h>
 #include <odp_pcapng.h>
 #include <odp_queue_if.h>
 #include <odp_schedule_if.h>
@@ -63,6 +68,14 @@ typedef struct {
 	uint16_t idx;
 } tx_compl_info_t;
 
+typedef struct {
+	/* Octet counts including adjustments */
+	int64_t oct_count0;
+	int64_t oct_count1;
+	uint16_t stat_idx;
+	uint16_t idx;
+} proto_stats_info_t;
+
 /* Global variables */
 static pktio_global_t *pktio_global;
 
@@ -114,6 +127,48 @@ static int read_config_file(pktio_global_t *pktio_glb)
 	pktio_glb->config.tx_compl_pool_size = val;
 	ODP_PRINT("  %s: %i\n", str, val);
 
+	str = "pktio.reassembly.max_flows";
+	if (!_odp_libconfig_lookup_int(str, &val)) {
+		ODP_ERR("Config option '%s' not found.\n", str);
+		return -1;
+	}
+
+	if (val < 1) {
+		ODP_ERR("Bad value %s = %i\n", str, val);
+		return -1;
+	}
+
+	pktio_glb->config.reass_max_flows = val;
+	ODP_PRINT("  %s: %i\n", str, val);
+
+	str = "pktio.reassembly.max_num_frags";
+	if (!_odp_libconfig_lookup_int(str, &val)) {
+		ODP_ERR("Config option '%s' not found.\n", str);
+		return -1;
+	}
+
+	if (val < 2 || val > UINT16_MAX) {
+		ODP_ERR("Bad value %s = %i\n", str, val);
+		return -1;
+	}
+
+	pktio_glb->config.reass_max_num_frags = val;
+	ODP_PRINT("  %s: %i\n", str, val);
+
+	str = "pktio.reassembly.max_wait_time_us";
+	if (!_odp_libconfig_lookup_int(str, &val)) {
+		ODP_ERR("Config option '%s' not found.\n", str);
+		return -1;
+	}
+
+	if (val < 1) {
+		ODP_ERR("Bad value %s = %i\n", str, val);
+		return -1;
+	}
+
+	pktio_glb->config.reass_max_wait_ns = (uint64_t)val * ODP_TIME_USEC_IN_NS;
+	ODP_PRINT("  %s: %i\n", str, val);
+
 	ODP_PRINT("\n");
 
 	return 0;
@@ -143,6 +198,18 @@ int _odp_pktio_init_global(void)
 		return -1;
 	}
 
+	shm = odp_shm_reserve("_odp_pktio_proto_stats", sizeof(proto_stats_cnt_t) *
+			      PKTIO_PROTO_STATS_MAX * odp_thread_count_max(),
+			      ODP_CACHE_LINE_SIZE, 0);
+	if (shm == ODP_SHM_INVALID) {
+		odp_shm_free(pktio_global->shm);
+		pktio_global = NULL;
+		return -1;
+	}
+
+	pktio_global->proto_stats_shm = shm;
+	pktio_global->proto_stats_cnt = odp_shm_addr(shm);
+
 	for (i = 0; i < ODP_CONFIG_PKTIO_ENTRIES; ++i) {
 		pktio_entry = &pktio_global->entries[i];
 
@@ -276,6 +343,9 @@ static void init_pktio_entry(pktio_entry_t *entry)
 
 	entry->tx_compl_pool = ODP_POOL_INVALID;
 
+	memset(&entry->reass, 0, sizeof(entry->reass));
+	entry->reass.shm = ODP_SHM_INVALID;
+
 	odp_atomic_init_u64(&entry->stats_extra.in_discards, 0);
 	odp_atomic_init_u64(&entry->stats_extra.in_errors, 0);
 	odp_atomic_init_u64(&entry->stats_extra.out_discards, 0);
@@ -421,6 +491,100 @@ odp_pktio_t odp_pktio_open(const char *name, odp_pool_t pool,
 	return hdl;
 }
 
+static void reass_tbl_destroy(pktio_entry_t *entry)
+{
+	int i;
+
+	if (entry->reass.shm == ODP_SHM_INVALID)
+		return;
+
+	for (i = 0; i < PKTIO_MAX_QUEUES; i++) {
+		if (entry->reass.tbl[i])
+			_odp_reass_tbl_flush(entry->reass.tbl[i]);
+
+		if (entry->reass.ipsec_tbl[i])
+			_odp_reass_tbl_flush(entry->reass.ipsec_tbl[i]);
+
+		entry->reass.tbl[i] = NULL;
+		entry->reass.ipsec_tbl[i] = NULL;
+	}
+
+	if (odp_shm_free(entry->reass.shm))
+		ODP_ERR("SHM free failed: %s\n", entry->name);
+
+	entry->reass.shm = ODP_SHM_INVALID;
+	entry->enabled.reass = 0;
+}
+
+/* Reserve fragment tables for all input queues. Reassembly at packet input
+ * and after inline IPsec processing use separate tables. */
+static int reass_tbl_create(pktio_entry_t *entry)
+{
+	const odp_reass_config_t *config = &entry->config.reassembly;
+	odp_reass_config_t ipsec_config;
+	uint32_t max_flows = pktio_global->config.reass_max_flows;
+	uint64_t max_wait_ns = pktio_global->config.reass_max_wait_ns;
+	uint32_t num = entry->num_in_queue;
+	uint64_t tbl_size = 0;
+	uint64_t ipsec_tbl_size = 0;
+	uint32_t shm_flags = 0;
+	char name[ODP_SHM_NAME_LEN];
+	uint8_t *addr;
+	uint32_t i;
+	int pktin, ipsec;
+
+	reass_tbl_destroy(entry);
+
+	pktin = config->en_ipv4 || config->en_ipv6;
+	ipsec = entry->config.inbound_ipsec && _odp_ipsec_reass_inline_config(&ipsec_config);
+
+	if (!(pktin || ipsec) || num == 0)
+		return 0;
+
+	if (pktin)
+		tbl_size = _ODP_ROUNDUP_CACHE_LINE(_odp_reass_tbl_size(max_flows,
+								       config->max_num_frags));
+
+	if (ipsec)
+		ipsec_tbl_size = _ODP_ROUNDUP_CACHE_LINE(_odp_reass_tbl_size(max_flows,
+									     ipsec_config.max_num_frags));
+
+	snprintf(name, sizeof(name), "_odp_pktio_reass_%i", odp_pktio_index(entry->handle));
+
+	if (odp_global_ro.shm_single_va)
+		shm_flags |= ODP_SHM_SINGLE_VA;
+
+	entry->reass.shm = odp_shm_reserve(name, num * (tbl_size + ipsec_tbl_size),
+					   ODP_CACHE_LINE_SIZE, shm_flags);
+
+	if (entry->reass.shm == ODP_SHM_INVALID) {
+		ODP_ERR("Reassembly table reserve failed: %s\n", entry->name);
+		return -1;
+	}
+
+	addr = odp_shm_addr(entry->reass.shm);
+
+	for (i = 0; i < num; i++) {
+		if (pktin) {
+			entry->reass.tbl[i] = (_odp_reass_tbl_t *)(uintptr_t)addr;
+			_odp_reass_tbl_init(entry->reass.tbl[i], max_flows, config, max_wait_ns,
+					    entry->reass.use_lock);
+			addr += tbl_size;
+		}
+
+		if (ipsec) {
+			entry->reass.ipsec_tbl[i] = (_odp_reass_tbl_t *)(uintptr_t)addr;
+			_odp_reass_tbl_init(entry->reass.ipsec_tbl[i], max_flows, &ipsec_config,
+					    max_wait_ns, entry->reass.use_lock);
+			addr += ipsec_tbl_size;
+		}
+	}
+
+	entry->enabled.reass = 1;
+
+	return 0;
+}
+
 static int _pktio_close(pktio_entry_t *entry)
 {
 	int ret;
@@ -523,6 +687,8 @@ int odp_pktio_close(odp_pktio_t hdl)
 	entry->num_in_queue  = 0;
 	entry->num_out_queue = 0;
 
+	reass_tbl_destroy(entry);
+
 	if (entry->tx_compl_pool != ODP_POOL_INVALID) {
 		if (odp_pool_destroy(entry->tx_compl_pool)) {
 			unlock_entry(entry);
@@ -604,6 +770,20 @@ int odp_pktio_config(odp_pktio_t hdl, const odp_pktio_config_t *config)
 		return -1;
 	}
 
+	if ((config->reassembly.en_ipv4 && !capa.reassembly.ipv4) ||
+	    (config->reassembly.en_ipv6 && !capa.reassembly.ipv6)) {
+		ODP_ERR("Reassembly not supported\n");
+		return -1;
+	}
+
+	if ((config->reassembly.en_ipv4 || config->reassembly.en_ipv6) &&
+	    (config->reassembly.max_num_frags < 2 ||
+	     config->reassembly.max_num_frags > capa.reassembly.max_num_frags ||
+	     config->reassembly.max_wait_time > capa.reassembly.max_wait_time)) {
+		ODP_ERR("Bad reassembly configuration\n");
+		return -1;
+	}
+
 	lock_entry(entry);
 	if (entry->state == PKTIO_STATE_STARTED) {
 		unlock_entry(entry);
@@ -624,6 +804,7 @@ int odp_pktio_config(odp_pktio_t hdl, const odp_pktio_config_t *config)
 		}
 
 	entry->enabled.tx_aging = config->pktout.bit.aging_ena;
+	entry->enabled.proto_stats = config->pktout.bit.proto_stats_ena;
 
 	if (entry->ops->config)
 		res = entry->ops->config(entry, config);
@@ -654,6 +835,17 @@ int odp_pktio_start(odp_pktio_t hdl)
 	entry->parse_layer = pktio_cls_enabled(entry) ?
 				       ODP_PROTO_LAYER_ALL :
 				       entry->config.parser.layer;
+
+	/* Fragments are detected from L3 parse results */
+	if ((entry->config.reassembly.en_ipv4 || entry->config.reassembly.en_ipv6) &&
+	    entry->parse_layer < ODP_PROTO_LAYER_L3)
+		entry->parse_layer = ODP_PROTO_LAYER_L3;
+
+	if (entry->param.in_mode != ODP_PKTIN_MODE_DISABLED && reass_tbl_create(entry)) {
+		unlock_entry(entry);
+		return -1;
+	}
+
 	if (entry->ops->start)
 		res = entry->ops->start(entry);
 	if (!res)
@@ -870,6 +1062,170 @@ static inline odp_packet_vector_t packet_vector_create(odp_packet_t packets[], u
 	return pktv;
 }
 
+/* Parse, classify and IPsec process a reassembled packet as if it was received
+ * as such */
+static int pktin_reass_parse(pktio_entry_t *entry, odp_packet_t *pkt)
+{
+	odp_packet_hdr_t *pkt_hdr = packet_hdr(*pkt);
+	const odp_proto_layer_t layer = entry->parse_layer;
+	const odp_pktin_config_opt_t opt = entry->config.pktin;
+	uint32_t pkt_len = odp_packet_len(*pkt);
+	uint32_t seg_len = odp_packet_seg_len(*pkt);
+	uint8_t buf[PARSE_BYTES];
+	uint8_t *pkt_addr;
+	int ret;
+
+	/* Make sure there is enough data for the packet parser in the case of
+	 * a segmented packet. */
+	if (odp_unlikely(seg_len < PARSE_BYTES && pkt_len > seg_len)) {
+		seg_len = _ODP_MIN(pkt_len, PARSE_BYTES);
+		odp_packet_copy_to_mem(*pkt, 0, seg_len, buf);
+		pkt_addr = buf;
+	} else {
+		pkt_addr = odp_packet_data(*pkt);
+	}
+
+	/* Keep reassembly status */
+	packet_parse_reset(pkt_hdr, 0);
+	ret = _odp_packet_parse_common(pkt_hdr, pkt_addr, pkt_len, seg_len, layer, opt);
+	if (ret)
+		odp_atomic_inc_u64(&entry->stats_extra.in_errors);
+
+	if (ret < 0) {
+		odp_packet_free(*pkt);
+		return -1;
+	}
+
+	if (pktio_cls_enabled(entry)) {
+		odp_pool_t new_pool;
+
+		ret = _odp_cls_classify_packet(entry, pkt_addr, &new_pool, pkt_hdr);
+		if (ret < 0)
+			odp_atomic_inc_u64(&entry->stats_extra.in_discards);
+
+		if (ret) {
+			odp_packet_free(*pkt);
+			return -1;
+		}
+
+		if (odp_unlikely(_odp_pktio_packet_to_pool(pkt, &pkt_hdr, new_pool))) {
+			odp_packet_free(*pkt);
+			odp_atomic_inc_u64(&entry->stats_extra.in_discards);
+			return -1;
+		}
+	}
+
+	if (entry->config.inbound_ipsec && !pkt_hdr->p.flags.ip_err &&
+	    odp_packet_has_ipsec(*pkt))
+		_odp_ipsec_try_inline(pkt);
+
+	return 0;
+}
+
+static inline int pktin_reass_expire(_odp_reass_tbl_t *tbl, uint64_t *now_ns,
+				     odp_packet_t packets[], int num, uint32_t *num_drop)
+{
+	int ret;
+
+	if (tbl == NULL || odp_likely(tbl->num_active == 0) || num <= 0)
+		return 0;
+
+	if (*now_ns == 0)
+		*now_ns = odp_time_global_ns();
+
+	/* Check without the lock first. When the table is shared, the check
+	 * may see an old state, but is repeated with the lock held. */
+	if (!_odp_reass_expire_pending(tbl, *now_ns))
+		return 0;
+
+	_odp_reass_lock(tbl);
+	ret = _odp_reass_expire(tbl, *now_ns, packets, num, num_drop);
+	_odp_reass_unlock(tbl);
+
+	return ret;
+}
+
+/* Pass received packets through fragment reassembly. Stored fragments are
+ * removed from the array, completed and timed out datagrams are added into
+ * it. Returns the new number of packets (max 'num'). */
+static int pktin_reass_process(pktio_entry_t *entry, int index, odp_packet_t packets[],
+			       int num_pkt, int num)
+{
+	_odp_reass_tbl_t *tbl = entry->reass.tbl[index];
+	_odp_reass_tbl_t *ipsec_tbl = entry->reass.ipsec_tbl[index];
+	/* Time is read only when needed */
+	uint64_t now_ns = 0;
+	uint32_t num_drop = 0;
+	int i, num_out = 0;
+
+	for (i = 0; i < num_pkt; i++) {
+		odp_packet_t pkt = packets[i];
+		odp_packet_hdr_t *pkt_hdr = packet_hdr(pkt);
+		_odp_reass_tbl_t *cur_tbl = NULL;
+		_odp_reass_result_t res;
+		uint32_t tag = 0;
+
+		if (odp_unlikely(pkt_hdr->subtype == ODP_EVENT_PACKET_IPSEC)) {
+			/* Inner fragments of inline processed IPsec packets */
+			if (ipsec_tbl) {
+				tag = _odp_ipsec_reass_tag(pkt);
+				if (tag)
+					cur_tbl = ipsec_tbl;
+			}
+		} else if (pkt_hdr->p.input_flags.ipfrag && !pkt_hdr->p.flags.all.error) {
+			cur_tbl = tbl;
+		}
+
+		if (odp_likely(cur_tbl == NULL)) {
+			packets[num_out++] = pkt;
+			continue;
+		}
+
+		if (now_ns == 0)
+			now_ns = odp_time_global_ns();
+
+		_odp_reass_lock(cur_tbl);
+		res = _odp_reass_packet(cur_tbl, &pkt, tag, now_ns);
+		_odp_reass_unlock(cur_tbl);
+
+		if (res == _ODP_REASS_STORED)
+			continue;
+
+		if (res == _ODP_REASS_DROP) {
+			num_drop++;
+			continue;
+		}
+
+		if (res == _ODP_REASS_COMPLETE) {
+			if (tag)
+				_odp_ipsec_reass_parse(pkt);
+			else if (pktin_reass_parse(entry, &pkt))
+				continue;
+		}
+
+		packets[num_out++] = pkt;
+	}
+
+	/* Output incomplete datagrams that have waited too long */
+	num_out += pktin_reass_expire(tbl, &now_ns, &packets[num_out], num - num_out, &num_drop);
+	num_out += pktin_reass_expire(ipsec_tbl, &now_ns, &packets[num_out], num - num_out,
+				      &num_drop);
+
+	if (odp_unlikely(num_drop))
+		odp_atomic_add_u64(&entry->stats_extra.in_discards, num_drop);
+
+	return num_out;
+}
+
+static inline int pktin_reass(pktio_entry_t *entry, int index, odp_packet_t packets[],
+			      int num_pkt, int num)
+{
+	if (odp_likely(!entry->enabled.reass) || num_pkt < 0)
+		return num_pkt;
+
+	return pktin_reass_process(entry, index, packets, num_pkt, num);
+}
+
 static inline int pktin_recv_buf(pktio_entry_t *entry, int pktin_index,
 				 _odp_event_hdr_t *event_hdrs[], int num)
 {
@@ -902,6 +1258,7 @@ static inline int pktin_recv_buf(pktio_entry_t *entry, int pktin_index,
 	cur_queue = ODP_QUEUE_INVALID;
 
 	pkts = entry->ops->recv(entry, pktin_index, packets, num);
+	pkts = pktin_reass(entry, pktin_index, packets, pkts, num);
 
 	for (i = 0; i < pkts; i++) {
 		pkt = packets[i];
@@ -1733,6 +2090,9 @@ int _odp_pktio_term_global(void)
 			ODP_ERR("Failed to terminate pcapng\n");
 	}
 
+	if (odp_shm_free(pktio_global->proto_stats_shm))
+		ODP_ERR("shm free failed\n");
+
 	shm = pktio_global->shm;
 	ret = odp_shm_free(shm);
 	if (ret != 0)
@@ -1794,6 +2154,8 @@ int odp_pktio_capability(odp_pktio_t pktio, odp_pktio_capability_t *capa)
 		capa->lso.max_payload_offset     = PKTIO_LSO_MAX_PAYLOAD_OFFSET;
 		capa->lso.max_num_custom         = ODP_LSO_MAX_CUSTOM;
 		capa->lso.proto.ipv4             = 1;
+		capa->lso.proto.tcp_ipv4         = 1;
+		capa->lso.proto.tcp_ipv6         = 1;
 		capa->lso.proto.custom           = 1;
 		capa->lso.mod_op.add_segment_num = 1;
 
@@ -1804,6 +2166,9 @@ int odp_pktio_capability(odp_pktio_t pktio, odp_pktio_capability_t *capa)
 
 		capa->config.pktout.bit.aging_ena = 1;
 		capa->max_tx_aging_tmo_ns = MAX_TX_AGING_TMO_NS;
+
+		/* Proto stats implementation is common to all pktios */
+		capa->config.pktout.bit.proto_stats_ena = 1;
 	}
 
 	/* Packet vector generation is common for all pktio types */
@@ -1816,13 +2181,21 @@ int odp_pktio_capability(odp_pktio_t pktio, odp_pktio_capability_t *capa)
 		capa->vector.min_tmo_ns = 0;
 	}
 
-	capa->reassembly.ip = false;
-	capa->reassembly.ipv4 = false;
-	capa->reassembly.ipv6 = false;
+	_odp_pktio_reass_capability(&capa->reassembly);
 
 	return ret;
 }
 
+void _odp_pktio_reass_capability(odp_reass_capability_t *capa)
+{
+	/* Reassembly is implemented in software for all pktio types */
+	capa->ip = true;
+	capa->ipv4 = true;
+	capa->ipv6 = true;
+	capa->max_wait_time = pktio_global->config.reass_max_wait_ns;
+	capa->max_num_frags = pktio_global->config.reass_max_num_frags;
+}
+
 unsigned int odp_pktio_max_index(void)
 {
 	return ODP_CONFIG_PKTIO_ENTRIES - 1;
@@ -2316,6 +2689,12 @@ int odp_pktin_queue_config(odp_pktio_t pktio,
 
 	entry->num_in_queue = num_queues;
 
+	/* Plain input queues and multi-thread safe direct input queues may be
+	 * polled concurrently */
+	entry->reass.use_lock = mode == ODP_PKTIN_MODE_QUEUE ||
+				(mode == ODP_PKTIN_MODE_DIRECT &&
+				 param->op_mode == ODP_PKTIO_OP_MT);
+
 	if (entry->ops->input_queues_config)
 		return entry->ops->input_queues_config(entry, param);
 
@@ -2693,6 +3072,7 @@ int odp_pktin_recv(odp_pktin_queue_t queue, odp_packet_t packets[], int num)
 		return 0;
 
 	ret = entry->ops->recv(entry, queue.index, packets, num);
+	ret = pktin_reass(entry, queue.index, packets, ret, num);
 	if (_ODP_PCAPNG)
 		_odp_dump_pcapng_pkts(entry, queue.index, packets, ret);
 
@@ -2724,6 +3104,7 @@ int odp_pktin_recv_tmo(odp_pktin_queue_t queue, odp_packet_t packets[], int num,
 	if (entry->ops->recv_tmo && wait != ODP_PKTIN_NO_WAIT) {
 		ret = entry->ops->recv_tmo(entry, queue.index, packets, num,
 					      wait);
+		ret = pktin_reass(entry, queue.index, packets, ret, num);
 		if (_ODP_PCAPNG)
 			_odp_dump_pcapng_pkts(entry, queue.index, packets, ret);
 
@@ -2732,6 +3113,7 @@ int odp_pktin_recv_tmo(odp_pktin_queue_t queue, odp_packet_t packets[], int num,
 
 	while (1) {
 		ret = entry->ops->recv(entry, queue.index, packets, num);
+		ret = pktin_reass(entry, queue.index, packets, ret, num);
 		if (_ODP_PCAPNG)
 			_odp_dump_pcapng_pkts(entry, queue.index, packets, ret);
 
@@ -2796,11 +3178,13 @@ int odp_pktin_recv_mq_tmo(const odp_pktin_queue_t queues[], uint32_t num_q, uint
 	if (ret > 0 && from)
 		*from = lfrom;
 	if (trial_successful) {
-		if (_ODP_PCAPNG) {
-			pktio_entry_t *entry;
+		pktio_entry_t *entry;
 
-			entry = get_pktio_entry(queues[lfrom].pktio);
-			if (entry)
+		entry = get_pktio_entry(queues[lfrom].pktio);
+		if (entry) {
+			ret = pktin_reass(entry, queues[lfrom].index, packets,
+					  ret, num);
+			if (_ODP_PCAPNG)
 				_odp_dump_pcapng_pkts(entry, lfrom, packets,
 						      ret);
 		}
@@ -2900,6 +3284,68 @@ static void send_tx_compl_events(tx_compl_info_t *info, uint16_t num, odp_buffer
 	}
 }
 
+static inline proto_stats_cnt_t *proto_stats_cnt(int thr, uint32_t stat_idx)
+{
+	return &pktio_global->proto_stats_cnt[(uint32_t)thr * PKTIO_PROTO_STATS_MAX + stat_idx];
+}
+
+/* Each counter has a single writer: a thread updates only the counters indexed by its own thread
+ * ID. So, an atomic load and store are enough, and no atomic RMW operation is needed. Readers see
+ * the value before or after an update. */
+static inline void proto_stats_add(odp_atomic_u64_t *cnt, uint64_t val)
+{
+	odp_atomic_store_u64(cnt, odp_atomic_load_u64(cnt) + val);
+}
+
+static inline uint16_t proto_stats_collect(const odp_packet_t packets[], int num,
+					   proto_stats_info_t *info)
+{
+	uint16_t num_info = 0;
+
+	for (int i = 0; i < num; i++) {
+		const odp_packet_hdr_t *hdr = packet_hdr(packets[i]);
+
+		if (odp_likely(!hdr->p.flags.proto_stats))
+			continue;
+
+		info[num_info].oct_count0 = (int64_t)hdr->frame_len + hdr->proto_stats_adj0;
+		info[num_info].oct_count1 = (int64_t)hdr->frame_len + hdr->proto_stats_adj1;
+		info[num_info].stat_idx = hdr->proto_stats_idx;
+		info[num_info].idx = i;
+		num_info++;
+	}
+
+	return num_info;
+}
+
+static inline void proto_stats_update(const proto_stats_info_t *info, uint16_t num, int num_sent)
+{
+	const int thr = odp_thread_id();
+
+	for (int i = 0; i < num && info[i].idx < num_sent; i++) {
+		proto_stats_cnt_t *cnt = proto_stats_cnt(thr, info[i].stat_idx);
+
+		proto_stats_add(&cnt->tx_pkts, 1);
+		proto_stats_add(&cnt->tx_oct_count0, info[i].oct_count0);
+		proto_stats_add(&cnt->tx_oct_count1, info[i].oct_count1);
+	}
+}
+
+void _odp_pktio_proto_stats_drop(const odp_packet_t packets[], int num)
+{
+	proto_stats_info_t info[num];
+	uint16_t num_info = proto_stats_collect(packets, num, info);
+	const int thr = odp_thread_id();
+
+	for (int i = 0; i < num_info; i++) {
+		proto_stats_cnt_t *cnt = proto_stats_cnt(thr, info[i].stat_idx);
+
+		proto_stats_add(&cnt->tx_pkt_drops, 1);
+		proto_stats_add(&cnt->tx_oct_count0_drops, info[i].oct_count0);
+		proto_stats_add(&cnt->tx_oct_count1_drops, info[i].oct_count1);
+	}
+}
+
 int odp_pktout_send(odp_pktout_queue_t queue, const odp_packet_t packets[],
 		    int num)
 {
@@ -2908,6 +3354,8 @@ int odp_pktout_send(odp_pktout_queue_t queue, const odp_packet_t packets[],
 	uint16_t num_tx_cevs = 0;
 	tx_compl_info_t tx_compl_info[num];
 	odp_buffer_t bufs[num];
+	uint16_t num_stats = 0;
+	proto_stats_info_t stats_info[num];
 	int num_to_send = num, num_sent;
 
 	entry = get_pktio_entry(pktio);
@@ -2940,11 +3388,18 @@ int odp_pktout_send(odp_pktout_queue_t queue, const odp_packet_t packets[],
 		}
 	}
 
+	/* Packets may be freed during send, collect stats data beforehand */
+	if (odp_unlikely(_odp_pktio_proto_stats_enabled(entry)))
+		num_stats = proto_stats_collect(packets, num_to_send, stats_info);
+
 	num_sent = entry->ops->send(entry, queue.index, packets, num_to_send);
 
 	if (odp_unlikely(num_tx_cevs))
 		send_tx_compl_events(tx_compl_info, num_tx_cevs, bufs, num_sent);
 
+	if (odp_unlikely(num_stats && num_sent > 0))
+		proto_stats_update(stats_info, num_stats, num_sent);
+
 	return num_sent;
 }
 
@@ -2989,8 +3444,10 @@ odp_lso_profile_t odp_lso_profile_create(odp_pktio_t pktio, const odp_lso_profil
 	lso_profile_t *lso_prof = NULL;
 	(void)pktio;
 
-	/* Currently only IPv4 and custom implemented */
+	/* Currently IPv4 fragmentation, TCP segmentation and custom implemented */
 	if (param->lso_proto != ODP_LSO_PROTO_IPV4 &&
+	    param->lso_proto != ODP_LSO_PROTO_TCP_IPV4 &&
+	    param->lso_proto != ODP_LSO_PROTO_TCP_IPV6 &&
 	    param->lso_proto != ODP_LSO_PROTO_CUSTOM) {
 		ODP_ERR("Protocol not supported\n");
 		return ODP_LSO_PROFILE_INVALID;
@@ -3142,6 +3599,47 @@ static int lso_update_ipv4(odp_packet_t pkt, int index, int num_pkt,
 	return ret;
 }
 
+static int lso_update_tcp(odp_packet_t pkt, int index, int num_pkt, uint32_t l3_offset,
+			  uint32_t l4_offset, uint32_t payload_len, int is_ipv4)
+{
+	_odp_tcphdr_t *tcp;
+	uint32_t pkt_len = odp_packet_len(pkt);
+	uint32_t seq_no;
+
+	odp_packet_l3_offset_set(pkt, l3_offset);
+	odp_packet_l4_offset_set(pkt, l4_offset);
+
+	if (is_ipv4) {
+		_odp_ipv4hdr_t *ipv4 = odp_packet_l3_ptr(pkt, NULL);
+
+		/* Consecutive IP identification values are used for the segments */
+		ipv4->tot_len = odp_cpu_to_be_16(pkt_len - l3_offset);
+		ipv4->id = odp_cpu_to_be_16(odp_be_to_cpu_16(ipv4->id) + index);
+
+		if (_odp_packet_ipv4_chksum_insert(pkt))
+			return -1;
+	} else {
+		_odp_ipv6hdr_t *ipv6 = odp_packet_l3_ptr(pkt, NULL);
+
+		ipv6->payload_len = odp_cpu_to_be_16(pkt_len - l3_offset - _ODP_IPV6HDR_LEN);
+	}
+
+	tcp = odp_packet_l4_ptr(pkt, NULL);
+	seq_no = odp_be_to_cpu_32(tcp->seq_no) + (uint32_t)index * payload_len;
+	tcp->seq_no = odp_cpu_to_be_32(seq_no);
+
+	/* FIN and PSH flags are set only on the last segment, CWR only on the first segment */
+	if (index < (num_pkt - 1)) {
+		tcp->fin = 0;
+		tcp->psh = 0;
+	}
+
+	if (index > 0)
+		tcp->cwr = 0;
+
+	return _odp_packet_tcp_chksum_insert(pkt);
+}
+
 static int lso_update_custom(lso_profile_t *lso_prof, odp_packet_t pkt, int segnum)
 {
 	void *ptr;
@@ -3196,7 +3694,7 @@ static int lso_update_custom(lso_profile_t *lso_prof, odp_packet_t pkt, int segn
 int _odp_lso_num_packets(odp_packet_t packet, const odp_packet_lso_opt_t *lso_opt,
 			 uint32_t *len_out, uint32_t *left_over_out)
 {
-	uint32_t num_pkt, left_over, l3_offset, iphdr_len;
+	uint32_t num_pkt, left_over, l3_offset, l4_offset, iphdr_len;
 	odp_lso_profile_t lso_profile = lso_opt->lso_profile;
 	lso_profile_t *lso_prof = lso_profile_ptr(lso_profile);
 	uint32_t payload_len = lso_opt->max_payload_len;
@@ -3238,6 +3736,21 @@ int _odp_lso_num_packets(odp_packet_t packet, const odp_packet_lso_opt_t *lso_op
 
 		/* Round down payload len to a multiple of 8 (on other than the last fragment). */
 		payload_len = (payload_len / 8) * 8;
+	} else if (lso_prof->param.lso_proto == ODP_LSO_PROTO_TCP_IPV4 ||
+		   lso_prof->param.lso_proto == ODP_LSO_PROTO_TCP_IPV6) {
+		l3_offset = odp_packet_l3_offset(packet);
+		l4_offset = odp_packet_l4_offset(packet);
+
+		if (l3_offset == ODP_PACKET_OFFSET_INVALID ||
+		    l4_offset == ODP_PACKET_OFFSET_INVALID) {
+			ODP_ERR("Invalid L3 or L4 offset\n");
+			return -1;
+		}
+
+		if (l4_offset < l3_offset || hdr_len < l4_offset + _ODP_TCPHDR_LEN) {
+			ODP_ERR("Bad payload, L3 or L4 offset\n");
+			return -1;
+		}
 	}
 
 	num_pkt = pkt_payload / payload_len;
@@ -3306,6 +3819,20 @@ int _odp_lso_create_packets(odp_packet_t packet, const odp_packet_lso_opt_t *lso
 		}
 	}
 
+	/* Segments inherit proto stats object of the original packet */
+	if (odp_unlikely(packet_hdr(packet)->p.flags.proto_stats)) {
+		odp_packet_hdr_t *pkt_hdr = packet_hdr(packet);
+
+		for (i = 0; i < num_pkt; i++) {
+			odp_packet_hdr_t *hdr = packet_hdr(pkt_out[i]);
+
+			hdr->p.flags.proto_stats = 1;
+			hdr->proto_stats_idx  = pkt_hdr->proto_stats_idx;
+			hdr->proto_stats_adj0 = pkt_hdr->proto_stats_adj0;
+			hdr->proto_stats_adj1 = pkt_hdr->proto_stats_adj1;
+		}
+	}
+
 	/* Copy payload */
 	for (i = 0; i < num_full; i++) {
 		offset = hdr_len + (i * payload_len);
@@ -3339,6 +3866,25 @@ int _odp_lso_create_packets(odp_packet_t packet, const odp_packet_lso_opt_t *lso
 				goto error;
 			}
 		}
+	} else if (lso_prof->param.lso_proto == ODP_LSO_PROTO_TCP_IPV4 ||
+		   lso_prof->param.lso_proto == ODP_LSO_PROTO_TCP_IPV6) {
+		int is_ipv4 = lso_prof->param.lso_proto == ODP_LSO_PROTO_TCP_IPV4;
+		uint32_t l4_offset = odp_packet_l4_offset(packet);
+
+		offset = odp_packet_l3_offset(packet);
+
+		if (offset == ODP_PACKET_OFFSET_INVALID || l4_offset == ODP_PACKET_OFFSET_INVALID) {
+			ODP_ERR("Invalid L3 or L4 offset\n");
+			goto error;
+		}
+
+		for (i = 0; i < num_pkt; i++) {
+			if (lso_update_tcp(pkt_out[i], i, num_pkt, offset, l4_offset, payload_len,
+					   is_ipv4)) {
+				ODP_ERR("TCP header update failed. Packet %i.\n", i);
+				goto error;
+			}
+		}
 	} else {
 		/* Update custom fields */
 		int num_custom = lso_prof->param.custom.num_custom;
@@ -3396,8 +3942,15 @@ static int pktout_send_lso(odp_pktout_queue_t queue, odp_packet_t packet,
 		ODP_DBG("Packet send failed %i\n", ret);
 
 		if (ret > 0) {
+			pktio_entry_t *entry = get_pktio_entry(queue.pktio);
+
 			first_free = ret;
 			num_free = num_pkt - ret;
+
+			/* Rest of the segments are dropped as the original packet cannot be
+			 * returned anymore */
+			if (odp_unlikely(_odp_pktio_proto_stats_enabled(entry)))
+				_odp_pktio_proto_stats_drop(&pkt_out[first_free], num_free);
 		}
 
 		odp_packet_free_multi(&pkt_out[first_free], num_free);
@@ -3494,30 +4047,120 @@ odp_proto_stats_capability(odp_pktio_t pktio, odp_proto_stats_capability_t *capa
 
 	memset(capa, 0, sizeof(*capa));
 
+	/* Proto stats are updated in the common packet output path for all pktio types */
+	capa->tx.counters.bit.tx_pkts = 1;
+	capa->tx.counters.bit.tx_pkt_drops = 1;
+	capa->tx.counters.bit.tx_oct_count0 = 1;
+	capa->tx.counters.bit.tx_oct_count0_drops = 1;
+	capa->tx.counters.bit.tx_oct_count1 = 1;
+	capa->tx.counters.bit.tx_oct_count1_drops = 1;
+	capa->tx.oct_count0_adj = true;
+	capa->tx.oct_count1_adj = true;
+
 	return 0;
 }
 
+static inline odp_proto_stats_t proto_stats_handle(uint32_t idx)
+{
+	return _odp_cast_scalar(odp_proto_stats_t, idx + 1);
+}
+
+static inline proto_stats_t *proto_stats_entry(odp_proto_stats_t stat)
+{
+	uint32_t idx = _odp_typeval(stat) - 1;
+
+	if (odp_unlikely(stat == ODP_PROTO_STATS_INVALID || idx >= PKTIO_PROTO_STATS_MAX))
+		return NULL;
+
+	return &pktio_global->proto_stats[idx];
+}
+
 odp_proto_stats_t
 odp_proto_stats_lookup(const char *name)
 {
-	(void)name;
+	odp_proto_stats_t stat = ODP_PROTO_STATS_INVALID;
+	uint32_t i;
+
+	if (name == NULL)
+		return ODP_PROTO_STATS_INVALID;
+
+	odp_spinlock_lock(&pktio_global->lock);
+
+	for (i = 0; i < PKTIO_PROTO_STATS_MAX; i++) {
+		proto_stats_t *entry = &pktio_global->proto_stats[i];
+
+		if (entry->used && strcmp(entry->name, name) == 0) {
+			stat = proto_stats_handle(i);
+			break;
+		}
+	}
+
+	odp_spinlock_unlock(&pktio_global->lock);
 
-	return ODP_PROTO_STATS_INVALID;
+	return stat;
 }
 
 odp_proto_stats_t
 odp_proto_stats_create(const char *name, const odp_proto_stats_param_t *param)
 {
-	(void)name;
-	(void)param;
+	proto_stats_t *entry = NULL;
+	const int thread_count_max = odp_thread_count_max();
+	uint32_t i;
+
+	odp_spinlock_lock(&pktio_global->lock);
+
+	for (i = 0; i < PKTIO_PROTO_STATS_MAX; i++) {
+		if (pktio_global->proto_stats[i].used == 0) {
+			entry = &pktio_global->proto_stats[i];
+			break;
+		}
+	}
+
+	if (entry == NULL) {
+		odp_spinlock_unlock(&pktio_global->lock);
+		ODP_ERR("All proto stats objects used already: %u\n", PKTIO_PROTO_STATS_MAX);
+		return ODP_PROTO_STATS_INVALID;
+	}
+
+	/* Initialize the entry with the lock held, so that concurrent lookup
+	 * does not see a partially written name */
+	memset(entry->name, 0, PKTIO_PROTO_STATS_NAME_LEN);
+	if (name)
+		strncpy(entry->name, name, PKTIO_PROTO_STATS_NAME_LEN - 1);
+
+	entry->param = *param;
+
+	for (int thr = 0; thr < thread_count_max; thr++) {
+		proto_stats_cnt_t *cnt = proto_stats_cnt(thr, i);
+
+		odp_atomic_init_u64(&cnt->tx_pkts, 0);
+		odp_atomic_init_u64(&cnt->tx_pkt_drops, 0);
+		odp_atomic_init_u64(&cnt->tx_oct_count0, 0);
+		odp_atomic_init_u64(&cnt->tx_oct_count0_drops, 0);
+		odp_atomic_init_u64(&cnt->tx_oct_count1, 0);
+		odp_atomic_init_u64(&cnt->tx_oct_count1_drops, 0);
+	}
 
-	return ODP_PROTO_STATS_INVALID;
+	entry->used = 1;
+
+	odp_spinlock_unlock(&pktio_global->lock);
+
+	return proto_stats_handle(i);
 }
 
 int
 odp_proto_stats_destroy(odp_proto_stats_t stat)
 {
-	(void)stat;
+	proto_stats_t *entry = proto_stats_entry(stat);
+
+	if (entry == NULL || entry->used == 0) {
+		ODP_ERR("Bad proto stats handle\n");
+		return -1;
+	}
+
+	odp_spinlock_lock(&pktio_global->lock);
+	entry->used = 0;
+	odp_spinlock_unlock(&pktio_global->lock);
 
 	return 0;
 }
@@ -3525,15 +4168,50 @@ odp_proto_stats_destroy(odp_proto_stats_t stat)
 int
 odp_proto_stats(odp_proto_stats_t stat, odp_proto_stats_data_t *data)
 {
-	(void)stat;
+	proto_stats_t *entry = proto_stats_entry(stat);
+	const int thread_count_max = odp_thread_count_max();
+	uint32_t idx;
 
+	if (entry == NULL || entry->used == 0 || data == NULL) {
+		ODP_ERR("Bad proto stats handle\n");
+		return -1;
+	}
+
+	idx = entry - pktio_global->proto_stats;
 	memset(data, 0, sizeof(odp_proto_stats_data_t));
 
+	for (int thr = 0; thr < thread_count_max; thr++) {
+		proto_stats_cnt_t *cnt = proto_stats_cnt(thr, idx);
+
+		data->tx_pkts             += odp_atomic_load_u64(&cnt->tx_pkts);
+		data->tx_pkt_drops        += odp_atomic_load_u64(&cnt->tx_pkt_drops);
+		data->tx_oct_count0       += odp_atomic_load_u64(&cnt->tx_oct_count0);
+		data->tx_oct_count0_drops += odp_atomic_load_u64(&cnt->tx_oct_count0_drops);
+		data->tx_oct_count1       += odp_atomic_load_u64(&cnt->tx_oct_count1);
+		data->tx_oct_count1_drops += odp_atomic_load_u64(&cnt->tx_oct_count1_drops);
+	}
+
 	return 0;
 }
 
 void
 odp_proto_stats_print(odp_proto_stats_t stat)
 {
-	(void)stat;
+	proto_stats_t *entry = proto_stats_entry(stat);
+	odp_proto_stats_data_t data;
+
+	if (entry == NULL || odp_proto_stats(stat, &data))
+		return;
+
+	ODP_PRINT("\nProto stats info\n");
+	ODP_PRINT("----------------\n");
+	ODP_PRINT("  name                 %s\n", entry->name);
+	ODP_PRINT("  handle               %p\n", (void *)stat);
+	ODP_PRINT("  counters             0x%" PRIx64 "\n", entry->param.counters.all_bits);
+	ODP_PRINT("  tx_pkts              %" PRIu64 "\n", data.tx_pkts);
+	ODP_PRINT("  tx_pkt_drops         %" PRIu64 "\n", data.tx_pkt_drops);
+	ODP_PRINT("  tx_oct_count0        %" PRIu64 "\n", data.tx_oct_count0);
+	ODP_PRINT("  tx_oct_count0_drops  %" PRIu64 "\n", data.tx_oct_count0_drops);
+	ODP_PRINT("  tx_oct_count1        %" PRIu64 "\n", data.tx_oct_count1);
+	ODP_PRINT("  tx_oct_count1_drops  %" PRIu64 "\n\n", data.tx_oct_count1_drops);
 }
@@ -175,6 +175,36 @@ static inline uint8_t parse_ipv4(packet_parser_t *prs, const uint8_t **parseptr,
 	return ipv4->proto;
 }
 
+/**
+ * Parser helper function for IPv6 fragment header
+ *
+ * Only the first fragment contains the upper layer header. The fragment header
+ * of the first fragment is skipped, so that L4 type and offset refer to the
+ * upper layer header as with IPv4 fragments.
+ */
+static inline uint8_t parse_ipv6_frag(packet_parser_t *prs,
+				      const uint8_t **parseptr,
+				      uint32_t *offset, uint32_t seg_len)
+{
+	const _odp_ipv6hdr_ext_t *frag = (const _odp_ipv6hdr_ext_t *)*parseptr;
+	uint16_t frag_offset;
+
+	prs->input_flags.ipfrag = 1;
+
+	if (odp_unlikely(*offset + sizeof(_odp_ipv6hdr_ext_t) > seg_len))
+		return _ODP_IPPROTO_FRAG;
+
+	/* Fragment offset is in the first two filler bytes */
+	frag_offset = ((uint16_t)frag->filler[0] << 8) | frag->filler[1];
+	if (frag_offset & 0xfff8)
+		return _ODP_IPPROTO_FRAG;
+
+	*offset   += sizeof(_odp_ipv6hdr_ext_t);
+	*parseptr += sizeof(_odp_ipv6hdr_ext_t);
+
+	return frag->next_hdr;
+}
+
 /**
  * Parser helper function for IPv6
  *
@@ -235,14 +265,14 @@ static inline uint8_t parse_ipv6(packet_parser_t *prs, const uint8_t **parseptr,
 		}
 
 		if (ipv6ext->next_hdr == _ODP_IPPROTO_FRAG)
-			prs->input_flags.ipfrag = 1;
+			return parse_ipv6_frag(prs, parseptr, offset, seg_len);
 
 		return ipv6ext->next_hdr;
 	}
 
 	if (odp_unlikely(ipv6->next_hdr == _ODP_IPPROTO_FRAG)) {
 		prs->input_flags.ipopt = 1;
-		prs->input_flags.ipfrag = 1;
+		return parse_ipv6_frag(prs, parseptr, offset, seg_len);
 	}
 
 	return ipv6->next_hdr;
@@ -31,6 +31,7 @@
 #include <odp_macros_internal.h>
 
 #include <odp/api/plat/ticketlock_inlines.h>
+#include <odp/api/plat/thread_inlines.h>
 #define LOCK(queue_ptr)      odp_ticketlock_lock(&((queue_ptr)->lock))
 #define UNLOCK(queue_ptr)    odp_ticketlock_unlock(&((queue_ptr)->lock))
 #define LOCK_INIT(queue_ptr) odp_ticketlock_init(&((queue_ptr)->lock))
@@ -52,12 +53,18 @@ static int queue_capa(odp_queue_capability_t *capa, int sched ODP_UNUSED)
 	memset(capa, 0, sizeof(odp_queue_capability_t));
 
 	/* Reserve some queues for internal use */
-	capa->max_queues        = CONFIG_MAX_QUEUES - CONFIG_INTERNAL_QUEUES;
+	capa->max_queues        = _odp_queue_glb->config.max_queues - CONFIG_INTERNAL_QUEUES;
 	capa->plain.max_num     = CONFIG_MAX_PLAIN_QUEUES;
 	capa->plain.max_size    = _odp_queue_glb->config.max_queue_size;
 	capa->plain.lockfree.max_num  = _odp_queue_glb->queue_lf_num;
 	capa->plain.lockfree.max_size = _odp_queue_glb->queue_lf_size;
 
+	/* Only plain queues with MT unsafe enqueue and dequeue are wait-free.
+	 * Those use the single-producer / single-consumer ring. Lock-free
+	 * rings are not wait-free. */
+	capa->plain.waitfree.max_num  = CONFIG_MAX_PLAIN_QUEUES;
+	capa->plain.waitfree.max_size = _odp_queue_glb->config.max_queue_size;
+
 	return 0;
 }
 
@@ -102,6 +109,25 @@ static int read_config_file(queue_global_t *_odp_queue_glb)
 	}
 
 	_odp_queue_glb->config.default_queue_size = val_u32;
+	ODP_PRINT("  %s: %u\n", str, val_u32);
+
+	str = "queue_basic.max_sched_queues";
+	if (!_odp_libconfig_lookup_int(str, &val)) {
+		ODP_ERR("Config option '%s' not found.\n", str);
+		return -1;
+	}
+
+	val_u32 = val;
+
+	if (val <= 0 || val_u32 > CONFIG_MAX_SCHED_QUEUES_LIMIT ||
+	    !_ODP_CHECK_IS_POWER2(val_u32)) {
+		ODP_ERR("Bad value %s = %u\n", str, val_u32);
+		return -1;
+	}
+
+	_odp_queue_glb->config.max_sched_queues = val_u32;
+	_odp_queue_glb->config.max_queues = CONFIG_INTERNAL_QUEUES + CONFIG_MAX_PLAIN_QUEUES +
+					    val_u32;
 	ODP_PRINT("  %s: %u\n\n", str, val_u32);
 
 	return 0;
@@ -115,6 +141,7 @@ static int queue_init_global(void)
 	queue_lf_func_t *lf_func;
 	odp_queue_capability_t capa;
 	uint64_t mem_size;
+	queue_global_t cfg;
 
 	ODP_DBG("Starts...\n");
 
@@ -124,8 +151,15 @@ static int queue_init_global(void)
 	_odp_queue_inline_offset.context = offsetof(queue_entry_t,
 						    param.context);
 
+	/* Number of queue entries depends on configuration */
+	memset(&cfg, 0, sizeof(queue_global_t));
+	if (read_config_file(&cfg))
+		return -1;
+
+	mem_size = sizeof(queue_global_t) + cfg.config.max_queues * sizeof(queue_entry_t);
+
 	shm = odp_shm_reserve("_odp_queue_basic_global",
-			      sizeof(queue_global_t),
+			      mem_size,
 			      sizeof(queue_entry_t),
 			      0);
 	if (shm == ODP_SHM_INVALID)
@@ -133,9 +167,10 @@ static int queue_init_global(void)
 
 	_odp_queue_glb = odp_shm_addr(shm);
 
-	memset(_odp_queue_glb, 0, sizeof(queue_global_t));
+	memset(_odp_queue_glb, 0, mem_size);
+	_odp_queue_glb->config = cfg.config;
 
-	for (i = 0; i < CONFIG_MAX_QUEUES; i++) {
+	for (i = 0; i < _odp_queue_glb->config.max_queues; i++) {
 		/* init locks */
 		queue_entry_t *queue = qentry_from_index(i);
 
@@ -144,13 +179,8 @@ static int queue_init_global(void)
 		queue->handle = (odp_queue_t)queue;
 	}
 
-	if (read_config_file(_odp_queue_glb)) {
-		odp_shm_free(shm);
-		return -1;
-	}
-
 	_odp_queue_glb->queue_gbl_shm = shm;
-	mem_size = sizeof(uint32_t) * CONFIG_MAX_QUEUES *
+	mem_size = sizeof(uint32_t) * _odp_queue_glb->config.max_queues *
 		   (uint64_t)_odp_queue_glb->config.max_queue_size;
 
 	shm = odp_shm_reserve("_odp_queue_basic_rings", mem_size,
@@ -183,6 +213,8 @@ static int queue_init_global(void)
 
 static int queue_init_local(void)
 {
+	memset(&_odp_queue_glb->thr_stat[odp_thread_id()], 0, sizeof(queue_thr_stat_t));
+
 	return 0;
 }
 
@@ -195,9 +227,9 @@ static int queue_term_global(void)
 {
 	int ret = 0;
 	queue_entry_t *queue;
-	int i;
+	uint32_t i;
 
-	for (i = 0; i < CONFIG_MAX_QUEUES; i++) {
+	for (i = 0; i < _odp_queue_glb->config.max_queues; i++) {
 		queue = qentry_from_index(i);
 		LOCK(queue);
 		if (queue->status != QUEUE_STATUS_FREE) {
@@ -285,25 +317,30 @@ static odp_queue_t queue_create(const char *name,
 		if (param->size > _odp_queue_glb->config.max_queue_size)
 			return ODP_QUEUE_INVALID;
 	} else if (param->nonblocking == ODP_NONBLOCKING_LF) {
-		/* Only plain type lock-free queues supported */
-		if (type != ODP_QUEUE_TYPE_PLAIN)
-			return ODP_QUEUE_INVALID;
 		if (param->size > _odp_queue_glb->queue_lf_size)
 			return ODP_QUEUE_INVALID;
 	} else {
-		/* Wait-free queues not supported */
-		return ODP_QUEUE_INVALID;
+		/* Only single-producer / single-consumer plain queues are
+		 * wait-free */
+		if (type != ODP_QUEUE_TYPE_PLAIN ||
+		    param->enq_mode != ODP_QUEUE_OP_MT_UNSAFE ||
+		    param->deq_mode != ODP_QUEUE_OP_MT_UNSAFE) {
+			ODP_ERR("Wait-free queues must be plain and MT unsafe\n");
+			return ODP_QUEUE_INVALID;
+		}
+		if (param->size > _odp_queue_glb->config.max_queue_size)
+			return ODP_QUEUE_INVALID;
 	}
 
 	if (type == ODP_QUEUE_TYPE_SCHED) {
 		/* Start scheduled queue indices from zero to enable direct
 		 * mapping to scheduler implementation indices. */
 		i = 0;
-		max_idx = CONFIG_MAX_SCHED_QUEUES;
+		max_idx = _odp_queue_glb->config.max_sched_queues;
 	} else {
-		i = CONFIG_MAX_SCHED_QUEUES;
+		i = _odp_queue_glb->config.max_sched_queues;
 		/* All internal queues are of type plain */
-		max_idx = CONFIG_MAX_QUEUES;
+		max_idx = _odp_queue_glb->config.max_queues;
 	}
 
 	for (; i < max_idx; i++) {
@@ -333,11 +370,15 @@ static odp_queue_t queue_create(const char *name,
 				}
 				queue->queue_lf = queue_lf;
 
-				queue->enqueue       = lf_fn->enq;
-				queue->enqueue_multi = lf_fn->enq_multi;
-				queue->dequeue       = lf_fn->deq;
-				queue->dequeue_multi = lf_fn->deq_multi;
-				queue->orig_dequeue_multi = lf_fn->deq_multi;
+				/* Scheduled queue uses lock-free ring through
+				 * the scheduled queue functions */
+				if (type == ODP_QUEUE_TYPE_PLAIN) {
+					queue->enqueue       = lf_fn->enq;
+					queue->enqueue_multi = lf_fn->enq_multi;
+					queue->dequeue       = lf_fn->deq;
+					queue->dequeue_multi = lf_fn->deq_multi;
+					queue->orig_dequeue_multi = lf_fn->deq_multi;
+				}
 			}
 
 			if (type == ODP_QUEUE_TYPE_SCHED)
@@ -367,15 +408,33 @@ static odp_queue_t queue_create(const char *name,
 	return handle;
 }
 
+/* Status of a scheduled queue is updated also without holding the queue lock */
+static inline int status_load(queue_entry_t *queue)
+{
+	return __atomic_load_n(&queue->status, __ATOMIC_ACQUIRE);
+}
+
+static inline int status_cas(queue_entry_t *queue, int old_status, int new_status)
+{
+	return __atomic_compare_exchange_n(&queue->status, &old_status, new_status,
+					   0 /* strong */,
+					   __ATOMIC_ACQ_REL,
+					   __ATOMIC_RELAXED);
+}
+
 void _odp_sched_queue_set_status(uint32_t queue_index, int status)
 {
 	queue_entry_t *queue = qentry_from_index(queue_index);
 
-	LOCK(queue);
+	__atomic_store_n(&queue->status, status, __ATOMIC_RELEASE);
+}
 
-	queue->status = status;
+static inline int sched_queue_is_empty(queue_entry_t *queue)
+{
+	if (queue->queue_lf)
+		return _odp_queue_lf_length(queue->queue_lf) == 0;
 
-	UNLOCK(queue);
+	return ring_mpmc_is_empty(&queue->ring_mpmc);
 }
 
 static int queue_destroy(odp_queue_t handle)
@@ -403,7 +462,7 @@ static int queue_destroy(odp_queue_t handle)
 	if (queue->spsc)
 		empty = ring_spsc_is_empty(&queue->ring_spsc);
 	else if (queue->type == ODP_QUEUE_TYPE_SCHED)
-		empty = ring_st_is_empty(&queue->ring_st);
+		empty = sched_queue_is_empty(queue);
 	else
 		empty = ring_mpmc_is_empty(&queue->ring_mpmc);
 
@@ -413,20 +472,26 @@ static int queue_destroy(odp_queue_t handle)
 		return -1;
 	}
 
-	switch (queue->status) {
-	case QUEUE_STATUS_READY:
-		queue->status = QUEUE_STATUS_FREE;
-		break;
-	case QUEUE_STATUS_NOTSCHED:
-		queue->status = QUEUE_STATUS_FREE;
-		_odp_sched_fn->destroy_queue(queue->index);
-		break;
-	case QUEUE_STATUS_SCHED:
-		/* Queue is still in scheduling */
-		queue->status = QUEUE_STATUS_DESTROYED;
-		break;
-	default:
-		ODP_ABORT("Unexpected queue status\n");
+	/* Scheduler may change scheduled queue status concurrently */
+	while (1) {
+		int status = status_load(queue);
+
+		if (status == QUEUE_STATUS_READY) {
+			if (status_cas(queue, status, QUEUE_STATUS_FREE))
+				break;
+		} else if (status == QUEUE_STATUS_NOTSCHED) {
+			if (!status_cas(queue, status, QUEUE_STATUS_FREE))
+				continue;
+
+			_odp_sched_fn->destroy_queue(queue->index);
+			break;
+		} else if (status == QUEUE_STATUS_SCHED) {
+			/* Queue is still in scheduling */
+			if (status_cas(queue, status, QUEUE_STATUS_DESTROYED))
+				break;
+		} else {
+			ODP_ABORT("Unexpected queue status\n");
+		}
 	}
 
 	if (queue->queue_lf)
@@ -450,7 +515,7 @@ static odp_queue_t queue_lookup(const char *name)
 {
 	uint32_t i;
 
-	for (i = 0; i < CONFIG_MAX_QUEUES; i++) {
+	for (i = 0; i < _odp_queue_glb->config.max_queues; i++) {
 		queue_entry_t *queue = qentry_from_index(i);
 
 		if (queue->status == QUEUE_STATUS_FREE ||
@@ -508,6 +573,9 @@ static inline int _plain_queue_enq_multi(odp_queue_t handle,
 	num_enq = ring_mpmc_enq_multi(ring_mpmc, queue->ring_data,
 				      queue->ring_mask, event_idx, num);
 
+	if (odp_unlikely(num_enq < num))
+		_odp_queue_enq_fail_stat(num - num_enq);
+
 	return num_enq;
 }
 
@@ -638,7 +706,7 @@ static int queue_info(odp_queue_t handle, odp_queue_info_t *info)
 
 	queue_id = queue_to_index(handle);
 
-	if (odp_unlikely(queue_id >= CONFIG_MAX_QUEUES)) {
+	if (odp_unlikely(queue_id >= _odp_queue_glb->config.max_queues)) {
 		ODP_ERR("Invalid queue handle: 0x%" PRIx64 "\n",
 			odp_queue_to_u64(handle));
 		return -1;
@@ -674,7 +742,7 @@ static void queue_print(odp_queue_t handle)
 
 	queue_id = queue_to_index(handle);
 
-	if (odp_unlikely(queue_id >= CONFIG_MAX_QUEUES)) {
+	if (odp_unlikely(queue_id >= _odp_queue_glb->config.max_queues)) {
 		ODP_ERR("Invalid queue handle: 0x%" PRIx64 "\n",
 			odp_queue_to_u64(handle));
 		return;
@@ -751,10 +819,6 @@ static void queue_print(odp_queue_t handle)
 		ODP_PRINT("  implementation  ring_spsc\n");
 		ODP_PRINT("  length          %" PRIu32 "/%" PRIu32 "\n",
 			  ring_spsc_length(&queue->ring_spsc), queue->ring_mask + 1);
-	} else if (queue->type == ODP_QUEUE_TYPE_SCHED) {
-		ODP_PRINT("  implementation  ring_st\n");
-		ODP_PRINT("  length          %" PRIu32 "/%" PRIu32 "\n",
-			  ring_st_length(&queue->ring_st), queue->ring_mask + 1);
 	} else {
 		ODP_PRINT("  implementation  ring_mpmc\n");
 		ODP_PRINT("  length          %" PRIu32 "/%" PRIu32 "\n",
@@ -792,7 +856,7 @@ static void queue_print_all(void)
 	else
 		ODP_PRINT("\n");
 
-	for (i = 0; i < CONFIG_MAX_QUEUES; i++) {
+	for (i = 0; i < _odp_queue_glb->config.max_queues; i++) {
 		queue_entry_t *queue = qentry_from_index(i);
 
 		if (queue->status < QUEUE_STATUS_READY)
@@ -816,7 +880,7 @@ static void queue_print_all(void)
 			len     = ring_spsc_length(&queue->ring_spsc);
 			max_len = queue->ring_mask + 1;
 		} else if (type == ODP_QUEUE_TYPE_SCHED) {
-			len     = ring_st_length(&queue->ring_st);
+			len     = ring_mpmc_length(&queue->ring_mpmc);
 			max_len = queue->ring_mask + 1;
 			prio    = queue->param.sched.prio;
 			grp     = queue->param.sched.group;
@@ -871,92 +935,138 @@ static void queue_print_all(void)
 	ODP_PRINT("\n");
 }
 
+/* Enqueue into lock-free ring of a scheduled queue */
+static inline int sched_queue_lf_enq(queue_entry_t *queue, _odp_event_hdr_t *event_hdr[], int num)
+{
+	queue_lf_func_t *lf_fn = &_odp_queue_glb->queue_lf_func;
+
+	return lf_fn->enq_multi(queue->handle, event_hdr, num);
+}
+
+static inline int sched_queue_lf_deq(queue_entry_t *queue, _odp_event_hdr_t *event_hdr[], int num)
+{
+	queue_lf_func_t *lf_fn = &_odp_queue_glb->queue_lf_func;
+
+	return lf_fn->deq_multi(queue->handle, event_hdr, num);
+}
+
+/* Scheduled queues are enqueued without the queue lock. Scheduler dequeues
+ * events from a queue by one thread at a time. Enqueue adds a queue to
+ * scheduling when the queue status changes from not scheduled to scheduled.
+ * Dequeue changes the status back after finding the queue empty, and
+ * re-checks the queue after that, as producers may have missed the change. */
 static inline int _sched_queue_enq_multi(odp_queue_t handle,
 					 _odp_event_hdr_t *event_hdr[], int num)
 {
-	int sched = 0;
 	int ret;
 	queue_entry_t *queue;
 	int num_enq;
-	ring_st_t *ring_st;
 	uint32_t event_idx[num];
 
 	queue = qentry_from_handle(handle);
-	ring_st = &queue->ring_st;
 
 	if (_odp_sched_fn->ord_enq_multi(handle, (void **)event_hdr, num, &ret))
 		return ret;
 
-	event_index_from_hdr(event_idx, event_hdr, num);
-
-	LOCK(queue);
+	if (queue->queue_lf) {
+		/* Lock-free ring counts enqueue failures */
+		num_enq = sched_queue_lf_enq(queue, event_hdr, num);
+	} else {
+		event_index_from_hdr(event_idx, event_hdr, num);
 
-	num_enq = ring_st_enq_multi(ring_st, queue->ring_data,
-				    queue->ring_mask, event_idx, num);
+		num_enq = ring_mpmc_enq_multi(&queue->ring_mpmc, queue->ring_data,
+					      queue->ring_mask, event_idx, num);
 
-	if (odp_unlikely(num_enq == 0)) {
-		UNLOCK(queue);
-		return 0;
+		if (odp_unlikely(num_enq < num))
+			_odp_queue_enq_fail_stat(num - num_enq);
 	}
 
-	if (queue->status == QUEUE_STATUS_NOTSCHED) {
-		queue->status = QUEUE_STATUS_SCHED;
-		sched = 1;
-	}
+	if (odp_unlikely(num_enq == 0))
+		return 0;
 
-	UNLOCK(queue);
+	/* Status load must not move above enqueue. Pairs with the barrier in
+	 * dequeue. */
+	odp_mb_full();
 
 	/* Add queue to scheduling */
-	if (sched && _odp_sched_fn->sched_queue(queue->index))
-		ODP_ABORT("schedule_queue failed\n");
+	if (status_load(queue) == QUEUE_STATUS_NOTSCHED &&
+	    status_cas(queue, QUEUE_STATUS_NOTSCHED, QUEUE_STATUS_SCHED)) {
+		if (_odp_sched_fn->sched_queue(queue->index))
+			ODP_ABORT("schedule_queue failed\n");
+	}
 
 	return num_enq;
 }
 
+static inline int sched_queue_deq(queue_entry_t *queue, odp_event_t ev[], int num)
+{
+	uint32_t event_idx[num];
+	int num_deq;
+
+	if (queue->queue_lf)
+		return sched_queue_lf_deq(queue, (_odp_event_hdr_t **)ev, num);
+
+	num_deq = ring_mpmc_deq_multi(&queue->ring_mpmc, queue->ring_data,
+				      queue->ring_mask, event_idx, num);
+
+	if (num_deq)
+		event_index_to_hdr((_odp_event_hdr_t **)ev, event_idx, num_deq);
+
+	return num_deq;
+}
+
+/* Free a destroyed queue. Returns -1. */
+static int sched_queue_destroyed(queue_entry_t *queue, uint32_t queue_index)
+{
+	LOCK(queue);
+
+	/* Inform scheduler about a destroyed queue */
+	if (queue->status == QUEUE_STATUS_DESTROYED) {
+		queue->status = QUEUE_STATUS_FREE;
+		_odp_sched_fn->destroy_queue(queue_index);
+	}
+
+	UNLOCK(queue);
+	return -1;
+}
+
 int _odp_sched_queue_deq(uint32_t queue_index, odp_event_t ev[], int max_num,
 			 int update_status)
 {
 	int num_deq, status;
-	ring_st_t *ring_st;
 	queue_entry_t *queue = qentry_from_index(queue_index);
-	uint32_t event_idx[max_num];
-
-	ring_st = &queue->ring_st;
-
-	LOCK(queue);
 
-	status = queue->status;
+	status = status_load(queue);
 
-	if (odp_unlikely(status < QUEUE_STATUS_READY)) {
-		/* Bad queue, or queue has been destroyed.
-		 * Inform scheduler about a destroyed queue. */
-		if (queue->status == QUEUE_STATUS_DESTROYED) {
-			queue->status = QUEUE_STATUS_FREE;
-			_odp_sched_fn->destroy_queue(queue_index);
-		}
+	/* Bad queue, or queue has been destroyed */
+	if (odp_unlikely(status < QUEUE_STATUS_READY))
+		return sched_queue_destroyed(queue, queue_index);
 
-		UNLOCK(queue);
-		return -1;
-	}
+	while (1) {
+		num_deq = sched_queue_deq(queue, ev, max_num);
 
-	num_deq = ring_st_deq_multi(ring_st, queue->ring_data,
-				    queue->ring_mask, event_idx, max_num);
+		if (num_deq || !update_status)
+			return num_deq;
 
-	if (num_deq == 0) {
 		/* Already empty queue */
-		if (update_status && status == QUEUE_STATUS_SCHED)
-			queue->status = QUEUE_STATUS_NOTSCHED;
-
-		UNLOCK(queue);
+		if (!status_cas(queue, QUEUE_STATUS_SCHED, QUEUE_STATUS_NOTSCHED)) {
+			if (odp_unlikely(status_load(queue) < QUEUE_STATUS_READY))
+				return sched_queue_destroyed(queue, queue_index);
 
-		return 0;
-	}
+			return 0;
+		}
 
-	UNLOCK(queue);
+		/* Check the queue again after the status change. Pairs with
+		 * the barrier in enqueue. */
+		odp_mb_full();
 
-	event_index_to_hdr((_odp_event_hdr_t **)ev, event_idx, num_deq);
+		if (sched_queue_is_empty(queue))
+			return 0;
 
-	return num_deq;
+		/* Enqueue may have already added the queue back to scheduling */
+		if (!status_cas(queue, QUEUE_STATUS_NOTSCHED, QUEUE_STATUS_SCHED))
+			return 0;
+	}
 }
 
 static int sched_queue_enq_multi(odp_queue_t handle,
@@ -980,27 +1090,26 @@ static int sched_queue_enq(odp_queue_t handle, _odp_event_hdr_t *event_hdr)
 int _odp_sched_queue_empty(uint32_t queue_index)
 {
 	queue_entry_t *queue = qentry_from_index(queue_index);
-	int ret = 0;
-
-	LOCK(queue);
 
-	if (odp_unlikely(queue->status < QUEUE_STATUS_READY)) {
-		/* Bad queue, or queue has been destroyed. */
-		UNLOCK(queue);
+	/* Bad queue, or queue has been destroyed. */
+	if (odp_unlikely(status_load(queue) < QUEUE_STATUS_READY))
 		return -1;
-	}
 
-	if (ring_st_is_empty(&queue->ring_st)) {
-		/* Already empty queue. Update status. */
-		if (queue->status == QUEUE_STATUS_SCHED)
-			queue->status = QUEUE_STATUS_NOTSCHED;
+	if (!sched_queue_is_empty(queue))
+		return 0;
 
-		ret = 1;
-	}
+	/* Already empty queue. Update status. */
+	if (!status_cas(queue, QUEUE_STATUS_SCHED, QUEUE_STATUS_NOTSCHED))
+		return 1;
 
-	UNLOCK(queue);
+	odp_mb_full();
 
-	return ret;
+	/* Enqueue may have already added the queue back to scheduling */
+	if (!sched_queue_is_empty(queue) &&
+	    status_cas(queue, QUEUE_STATUS_NOTSCHED, QUEUE_STATUS_SCHED))
+		return 0;
+
+	return 1;
 }
 
 static int queue_init(queue_entry_t *queue, const char *name,
@@ -1085,7 +1194,7 @@ static int queue_init(queue_entry_t *queue, const char *name,
 
 			queue->ring_data = &_odp_queue_glb->ring_data[offset];
 			queue->ring_mask = queue_size - 1;
-			ring_st_init(&queue->ring_st);
+			ring_mpmc_init(&queue->ring_mpmc);
 		}
 	}
 
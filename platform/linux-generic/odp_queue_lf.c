@@ -18,10 +18,8 @@
 #include <string.h>
 #include <stdio.h>
 
-#define RING_LF_SIZE   32
-#define QUEUE_LF_NUM   128
-#define ENQ_RETRIES    (RING_LF_SIZE / 4)
-#define DEQ_RETRIES    (RING_LF_SIZE / 8)
+#define RING_LF_SIZE   128
+#define QUEUE_LF_NUM   1024
 
 #ifdef __SIZEOF_INT128__
 
@@ -77,8 +75,9 @@ typedef union {
 	_odp_u128_t u128;
 
 	struct {
-		/* Data with lowest counter value is the head. Empty node has
-		 * counter value 0. */
+		/* Counter value of the enqueue or dequeue operation that
+		 * the node is waiting for. Node with data waits for dequeue,
+		 * empty node (ptr == 0) waits for enqueue. */
 		uint64_t counter;
 
 		/* Data pointer */
@@ -87,11 +86,23 @@ typedef union {
 
 } ring_lf_node_t;
 
-/* Lock-free ring */
+/* Lock-free ring
+ *
+ * Enqueue counter (tail) and dequeue counter (head) select the node to
+ * operate on: counter value N uses node N % RING_LF_SIZE. A node is
+ * updated with a single 16 byte CAS, which checks the counter value and
+ * writes both counter and data. Enqueue writes data into an empty node,
+ * which waits for the enqueue counter value. Dequeue empties a node, which
+ * waits for the dequeue counter value, and sets it to wait for the enqueue
+ * counter value of the next round. After a successful node update, the
+ * thread increments the counter with a CAS. Other threads help to
+ * increment a counter, which was left behind, so no thread waits for
+ * another thread to finish its operation. */
 typedef struct ODP_ALIGNED_CACHE {
 	ring_lf_node_t   node[RING_LF_SIZE];
 	int              used;
 	odp_atomic_u64_t enq_counter;
+	odp_atomic_u64_t deq_counter;
 
 } queue_lf_t;
 
@@ -104,155 +115,149 @@ typedef struct ODP_ALIGNED_CACHE {
 
 static queue_lf_global_t *queue_lf_glb;
 
-static inline int next_idx(int idx)
+static inline ring_lf_node_t *ring_node(queue_lf_t *queue_lf, uint64_t counter)
 {
-	int next = idx + 1;
-
-	if (next == RING_LF_SIZE)
-		next = 0;
+	return &queue_lf->node[counter % RING_LF_SIZE];
+}
 
-	return next;
+/* Increment counter from 'old' to 'old + 1', unless another thread has
+ * done it already */
+static inline void counter_inc(odp_atomic_u64_t *counter, uint64_t old)
+{
+	odp_atomic_cas_rel_u64(counter, &old, old + 1);
 }
 
-static int queue_lf_enq(odp_queue_t handle, _odp_event_hdr_t *event_hdr)
+/* Enqueue one event. Returns 0 on success, -1 when the ring is full. */
+static inline int ring_lf_enq(queue_lf_t *queue_lf, _odp_event_hdr_t *event_hdr)
 {
-	queue_entry_t *queue;
-	queue_lf_t *queue_lf;
-	int i, j, idx;
-	int found;
-	ring_lf_node_t node_val;
-	ring_lf_node_t new_val;
+	ring_lf_node_t node_val, new_val;
 	ring_lf_node_t *node;
+	uint64_t tail;
+
+	new_val.s.ptr = (uintptr_t)event_hdr;
+
+	while (1) {
+		tail = odp_atomic_load_acq_u64(&queue_lf->enq_counter);
+		node = ring_node(queue_lf, tail);
+		node_val.u128 = lockfree_load_u128(&node->u128);
 
-	queue    = qentry_from_handle(handle);
-	queue_lf = queue->queue_lf;
+		if (node_val.s.counter == tail && node_val.s.ptr == 0) {
+			new_val.s.counter = tail;
 
-	new_val.s.ptr     = (uintptr_t)event_hdr;
-	new_val.s.counter = odp_atomic_fetch_inc_u64(&queue_lf->enq_counter);
+			if (lockfree_cas_acq_rel_u128(&node->u128, node_val.u128,
+						      new_val.u128)) {
+				counter_inc(&queue_lf->enq_counter, tail);
+				return 0;
+			}
 
-	idx = 0;
+			/* Another thread enqueued into the node */
+			continue;
+		}
 
-	for (j = 0; j < ENQ_RETRIES; j++) {
-		found = 0;
+		/* Data of the previous round has not been dequeued */
+		if (node_val.s.counter < tail)
+			return -1;
 
-		/* Find empty node */
-		for (i = 0; i < RING_LF_SIZE; i++) {
-			node = &queue_lf->node[idx];
-			idx  = next_idx(idx);
+		/* Enqueue 'tail' has been done, but the counter has not been
+		 * incremented yet */
+		counter_inc(&queue_lf->enq_counter, tail);
+	}
+}
 
-			node_val.u128 = lockfree_load_u128(&node->u128);
+/* Dequeue one event. Returns NULL when the ring is empty. */
+static inline _odp_event_hdr_t *ring_lf_deq(queue_lf_t *queue_lf)
+{
+	ring_lf_node_t node_val, new_val;
+	ring_lf_node_t *node;
+	uint64_t head;
 
-			if (node_val.s.counter == 0) {
-				found = 1;
-				break;
+	new_val.s.ptr = 0;
+
+	while (1) {
+		head = odp_atomic_load_acq_u64(&queue_lf->deq_counter);
+		node = ring_node(queue_lf, head);
+		node_val.u128 = lockfree_load_u128(&node->u128);
+
+		if (node_val.s.counter == head) {
+			/* Enqueue 'head' has not been done */
+			if (node_val.s.ptr == 0)
+				return NULL;
+
+			new_val.s.counter = head + RING_LF_SIZE;
+
+			if (lockfree_cas_acq_rel_u128(&node->u128, node_val.u128,
+						      new_val.u128)) {
+				counter_inc(&queue_lf->deq_counter, head);
+				return (void *)(uintptr_t)node_val.s.ptr;
 			}
+
+			/* Another thread dequeued the node */
+			continue;
 		}
 
-		/* Queue is full */
-		if (found == 0)
-			return -1;
+		/* Dequeue 'head' has been done, but the counter has not been
+		 * incremented yet */
+		if (node_val.s.counter > head)
+			counter_inc(&queue_lf->deq_counter, head);
+	}
+}
+
+static int queue_lf_enq(odp_queue_t handle, _odp_event_hdr_t *event_hdr)
+{
+	queue_entry_t *queue = qentry_from_handle(handle);
 
-		/* Try to insert data */
-		if (lockfree_cas_acq_rel_u128(&node->u128, node_val.u128,
-					    new_val.u128))
-			return 0;
+	if (odp_unlikely(ring_lf_enq(queue->queue_lf, event_hdr))) {
+		_odp_queue_enq_fail_stat(1);
+		return -1;
 	}
 
-	return -1;
+	return 0;
 }
 
 static int queue_lf_enq_multi(odp_queue_t handle, _odp_event_hdr_t **event_hdr,
 			      int num)
 {
-	(void)num;
+	queue_entry_t *queue = qentry_from_handle(handle);
+	queue_lf_t *queue_lf = queue->queue_lf;
+	int num_enq;
+
+	/* Events get consecutive counter values, unless other threads
+	 * enqueue at the same time */
+	for (num_enq = 0; num_enq < num; num_enq++) {
+		if (ring_lf_enq(queue_lf, event_hdr[num_enq]))
+			break;
+	}
 
-	if (queue_lf_enq(handle, event_hdr[0]) == 0)
-		return 1;
+	if (odp_unlikely(num_enq < num))
+		_odp_queue_enq_fail_stat(num - num_enq);
 
-	return 0;
+	return num_enq;
 }
 
 static _odp_event_hdr_t *queue_lf_deq(odp_queue_t handle)
 {
-	queue_entry_t *queue;
-	queue_lf_t *queue_lf;
-	int i, j, i_lowest;
-	int found;
-	ring_lf_node_t node_val, old_val, new_val;
-	ring_lf_node_t *node, *old;
-	uint64_t lowest, counter;
-	_odp_event_hdr_t *event_hdr;
-
-	queue    = qentry_from_handle(handle);
-	queue_lf = queue->queue_lf;
-	new_val.s.counter = 0;
-	new_val.s.ptr     = 0;
-	old = NULL;
-
-	for (j = 0; j < DEQ_RETRIES; j++) {
-		found  = 0;
-		lowest = -1;
-
-		/* Find the head node. The one with data and
-		 * the lowest counter. */
-		for (i = 0; i < RING_LF_SIZE; i++) {
-			node          = &queue_lf->node[i];
-			node_val.u128 = lockfree_load_u128(&node->u128);
-			counter       = node_val.s.counter;
-
-			if (counter && counter < lowest) {
-				old          = node;
-				old_val.u128 = node_val.u128;
-				lowest       = counter;
-				i_lowest     = i;
-				found        = 1;
-			}
-		}
+	queue_entry_t *queue = qentry_from_handle(handle);
 
-		/* Queue is empty */
-		if (found == 0)
-			return NULL;
-
-		/* New data may have been written to the area we searched before
-		 * finding the current lowest. Check that there are no lower
-		 * values. */
-		for (i = 0; i < i_lowest; i++) {
-			node          = &queue_lf->node[i];
-			node_val.u128 = lockfree_load_u128(&node->u128);
-			counter       = node_val.s.counter;
-
-			if (counter && counter < lowest) {
-				old          = node;
-				old_val.u128 = node_val.u128;
-				lowest       = counter;
-			}
-		}
-
-		event_hdr = (void *)(uintptr_t)old_val.s.ptr;
-
-		/* Try to remove data */
-		if (lockfree_cas_acq_rel_u128(&old->u128, old_val.u128,
-					    new_val.u128))
-			return event_hdr;
-	}
-
-	return NULL;
+	return ring_lf_deq(queue->queue_lf);
 }
 
 static int queue_lf_deq_multi(odp_queue_t handle, _odp_event_hdr_t **event_hdr,
 			      int num)
 {
-	_odp_event_hdr_t *buf;
-
-	(void)num;
-
-	buf = queue_lf_deq(handle);
+	queue_entry_t *queue = qentry_from_handle(handle);
+	queue_lf_t *queue_lf = queue->queue_lf;
+	_odp_event_hdr_t *hdr;
+	int num_deq;
+
+	for (num_deq = 0; num_deq < num; num_deq++) {
+		hdr = ring_lf_deq(queue_lf);
+		if (hdr == NULL)
+			break;
 
-	if (buf == NULL)
-		return 0;
+		event_hdr[num_deq] = hdr;
+	}
 
-	event_hdr[0] = buf;
-	return 1;
+	return num_deq;
 }
 
 uint32_t _odp_queue_lf_init_global(uint32_t *queue_lf_size,
@@ -309,13 +314,17 @@ static void init_queue(queue_lf_t *queue_lf)
 {
 	int i;
 
-	odp_atomic_init_u64(&queue_lf->enq_counter, 1);
+	odp_atomic_init_u64(&queue_lf->enq_counter, 0);
+	odp_atomic_init_u64(&queue_lf->deq_counter, 0);
 
-	for (i = 0; i < RING_LF_SIZE; i++)
+	/* Node i waits for enqueue i */
+	for (i = 0; i < RING_LF_SIZE; i++) {
 		lockfree_zero_u128(&queue_lf->node[i].u128);
+		queue_lf->node[i].s.counter = i;
+	}
 }
 
-void *_odp_queue_lf_create(queue_entry_t *queue)
+void *_odp_queue_lf_create(queue_entry_t *queue ODP_UNUSED)
 {
 	int i;
 	queue_lf_t *queue_lf = NULL;
@@ -325,9 +334,6 @@ void *_odp_queue_lf_create(queue_entry_t *queue)
 		return NULL;
 	}
 
-	if (queue->type != ODP_QUEUE_TYPE_PLAIN)
-		return NULL;
-
 	for (i = 0; i < QUEUE_LF_NUM; i++) {
 		if (queue_lf_glb->queue_lf[i].used == 0) {
 			queue_lf = &queue_lf_glb->queue_lf[i];
@@ -351,16 +357,19 @@ void _odp_queue_lf_destroy(void *queue_lf_ptr)
 uint32_t _odp_queue_lf_length(void *queue_lf_ptr)
 {
 	queue_lf_t *queue_lf = queue_lf_ptr;
-	ring_lf_node_t node_val;
-	uint32_t i;
-	uint32_t num = 0;
+	uint64_t head, tail;
 
-	for (i = 0; i < RING_LF_SIZE; i++) {
-		node_val.u128 =  lockfree_load_u128(&queue_lf->node[i].u128);
-		if (node_val.s.counter)
-			num++;
-	}
-	return num;
+	/* Counters may lag behind by the number of concurrent operations */
+	head = odp_atomic_load_u64(&queue_lf->deq_counter);
+	tail = odp_atomic_load_u64(&queue_lf->enq_counter);
+
+	if (tail <= head)
+		return 0;
+
+	if (tail - head > RING_LF_SIZE)
+		return RING_LF_SIZE;
+
+	return tail - head;
 }
 
 uint32_t _odp_queue_lf_max_length(void)
@@ -39,6 +39,7 @@ static inline int spsc_enq_multi(odp_queue_t handle,
 	queue_entry_t *queue;
 	ring_spsc_t *ring_spsc;
 	uint32_t buf_idx[num];
+	int num_enq;
 
 	queue = qentry_from_handle(handle);
 	ring_spsc = &queue->ring_spsc;
@@ -50,8 +51,13 @@ static inline int spsc_enq_multi(odp_queue_t handle,
 		return -1;
 	}
 
-	return ring_spsc_enq_multi(ring_spsc, queue->ring_data,
-				   queue->ring_mask, buf_idx, num);
+	num_enq = ring_spsc_enq_multi(ring_spsc, queue->ring_data,
+				      queue->ring_mask, buf_idx, num);
+
+	if (odp_unlikely(num_enq < num))
+		_odp_queue_enq_fail_stat(num - num_enq);
+
+	return num_enq;
 }
 
 static inline int spsc_deq_multi(odp_queue_t handle,
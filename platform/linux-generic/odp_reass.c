@@ -0,0 +1,631 @@
+/* Copyright (c) 2022, Nokia
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier:     BSD-3-Clause
+ */
+
+/*
+ * Software IP fragment reassembly
+ *
+ * Fragments are collected into a fixed size table of datagrams. A table is
+ * private to a packet input queue, which makes lookups and updates lock free
+ * in the common case. Fragments are stored as packets (no data copy) and
+ * sorted by offset. When all fragments of a datagram have been received,
+ * fragment headers are removed and the payload segments are chained to the
+ * first fragment with odp_packet_concat().
+ *
+ * Datagrams are kept in an age list in the order of the first fragment
+ * reception. Since all datagrams of a table have the same maximum wait time,
+ * the oldest datagram is always at the head of the list and expiration check
+ * is a single comparison.
+ */
+
+#include <odp/api/byteorder.h>
+#include <odp/api/hints.h>
+#include <odp/api/packet.h>
+#include <odp/api/spinlock.h>
+
+#include <odp_debug_internal.h>
+#include <odp_macros_internal.h>
+#include <odp_packet_internal.h>
+#include <odp_reass_internal.h>
+#include <protocols/ip.h>
+
+#include <stdint.h>
+#include <string.h>
+
+#define NULL_IDX UINT32_MAX
+
+/* Maximum IPv4 total length and IPv6 payload length */
+#define MAX_IP_LEN 65535
+
+/* Fragment header information */
+typedef struct {
+	_odp_reass_key_t key;
+
+	/* Payload offset and length within the datagram */
+	uint32_t offset;
+	uint32_t len;
+
+	/* Payload start offset from packet start */
+	uint32_t hdr_len;
+
+	/* Length of IP header(s) that are not removed from the first fragment */
+	uint32_t ip_hdr_len;
+
+	/* More fragments flag */
+	int more;
+
+} frag_info_t;
+
+/* IPv6 fragment extension header */
+typedef struct ODP_PACKED {
+	uint8_t     next_hdr;
+	uint8_t     reserved;
+	odp_u16be_t frag_off;
+	odp_u32be_t id;
+} ipv6_frag_hdr_t;
+
+#define IPV6_FRAG_HDR_LEN 8
+#define IPV6_FRAG_OFFSET_MASK 0xfff8
+#define IPV6_FRAG_MORE 0x0001
+
+ODP_STATIC_ASSERT(sizeof(ipv6_frag_hdr_t) == IPV6_FRAG_HDR_LEN, "IPV6_FRAG_HDR_SIZE_ERROR");
+
+static inline uint32_t key_hash(const _odp_reass_key_t *key)
+{
+	uint32_t hash = key->id * 0x9e3779b1;
+	int i;
+
+	for (i = 0; i < 4; i++)
+		hash ^= key->src[i] + key->dst[i] + (hash << 6) + (hash >> 2);
+
+	hash ^= key->tag + key->proto;
+
+	return hash ^ (hash >> 16);
+}
+
+static inline int key_equal(const _odp_reass_key_t *a, const _odp_reass_key_t *b)
+{
+	return a->id == b->id && a->tag == b->tag && a->proto == b->proto &&
+	       a->ipv6 == b->ipv6 &&
+	       a->src[0] == b->src[0] && a->dst[0] == b->dst[0] &&
+	       a->src[1] == b->src[1] && a->dst[1] == b->dst[1] &&
+	       a->src[2] == b->src[2] && a->dst[2] == b->dst[2] &&
+	       a->src[3] == b->src[3] && a->dst[3] == b->dst[3];
+}
+
+static inline _odp_reass_frag_t *flow_frags(_odp_reass_tbl_t *tbl, uint32_t idx)
+{
+	return &tbl->frag[(uint64_t)idx * tbl->max_frags];
+}
+
+uint64_t _odp_reass_tbl_size(uint32_t max_flows, uint32_t max_frags)
+{
+	uint32_t num_bucket = _ODP_ROUNDUP_POWER2_U32(max_flows);
+
+	return _ODP_ROUNDUP_CACHE_LINE(sizeof(_odp_reass_tbl_t)) +
+	       _ODP_ROUNDUP_CACHE_LINE(sizeof(uint32_t) * num_bucket) +
+	       _ODP_ROUNDUP_CACHE_LINE(sizeof(_odp_reass_flow_t) * max_flows) +
+	       (uint64_t)sizeof(_odp_reass_frag_t) * max_flows * max_frags;
+}
+
+void _odp_reass_tbl_init(_odp_reass_tbl_t *tbl, uint32_t max_flows,
+			 const odp_reass_config_t *config, uint64_t max_wait_ns,
+			 int use_lock)
+{
+	uint32_t num_bucket = _ODP_ROUNDUP_POWER2_U32(max_flows);
+	uint8_t *ptr = (uint8_t *)tbl;
+	uint32_t i;
+
+	memset(tbl, 0, sizeof(_odp_reass_tbl_t));
+	odp_spinlock_init(&tbl->lock);
+	tbl->use_lock  = !!use_lock;
+	tbl->en_ipv4   = config->en_ipv4;
+	tbl->en_ipv6   = config->en_ipv6;
+	tbl->max_flows = max_flows;
+	tbl->max_frags = config->max_num_frags;
+	tbl->hash_mask = num_bucket - 1;
+	tbl->wait_ns   = max_wait_ns;
+
+	if (config->max_wait_time && config->max_wait_time < max_wait_ns)
+		tbl->wait_ns = config->max_wait_time;
+
+	ptr += _ODP_ROUNDUP_CACHE_LINE(sizeof(_odp_reass_tbl_t));
+	tbl->bucket = (uint32_t *)(uintptr_t)ptr;
+	ptr += _ODP_ROUNDUP_CACHE_LINE(sizeof(uint32_t) * num_bucket);
+	tbl->flow = (_odp_reass_flow_t *)(uintptr_t)ptr;
+	ptr += _ODP_ROUNDUP_CACHE_LINE(sizeof(_odp_reass_flow_t) * max_flows);
+	tbl->frag = (_odp_reass_frag_t *)(uintptr_t)ptr;
+
+	for (i = 0; i < num_bucket; i++)
+		tbl->bucket[i] = NULL_IDX;
+
+	/* Free flows are linked through 'next' */
+	for (i = 0; i < max_flows; i++)
+		tbl->flow[i].next = i + 1;
+
+	tbl->flow[max_flows - 1].next = NULL_IDX;
+	tbl->free_head = 0;
+	tbl->age_head  = NULL_IDX;
+	tbl->age_tail  = NULL_IDX;
+	tbl->expire_ns = UINT64_MAX;
+}
+
+/* Read fragment information from IP header. Returns 1 for a fragment, 0 for
+ * a non-fragment and -1 for a fragment that cannot be reassembled. */
+static int frag_info(_odp_reass_tbl_t *tbl, odp_packet_t pkt, odp_packet_hdr_t *pkt_hdr,
+		     frag_info_t *info)
+{
+	uint32_t l3_off = pkt_hdr->p.l3_offset;
+	uint32_t frame_len = pkt_hdr->frame_len;
+	uint32_t seg_len;
+	const uint8_t *l3;
+
+	if (odp_unlikely(l3_off == ODP_PACKET_OFFSET_INVALID))
+		return 0;
+
+	l3 = odp_packet_offset(pkt, l3_off, &seg_len, NULL);
+	if (odp_unlikely(l3 == NULL || seg_len < _ODP_IPV4HDR_LEN))
+		return 0;
+
+	memset(&info->key, 0, sizeof(info->key));
+
+	if (_ODP_IPV4HDR_VER(l3[0]) == _ODP_IPV4) {
+		const _odp_ipv4hdr_t *ipv4 = (const _odp_ipv4hdr_t *)(uintptr_t)l3;
+		uint16_t frag = odp_be_to_cpu_16(ipv4->frag_offset);
+		uint32_t ihl = _ODP_IPV4HDR_IHL(ipv4->ver_ihl) * 4;
+		uint32_t tot_len = odp_be_to_cpu_16(ipv4->tot_len);
+
+		if (odp_likely(!_ODP_IPV4HDR_IS_FRAGMENT(frag)) || !tbl->en_ipv4)
+			return 0;
+
+		if (odp_unlikely(ihl < _ODP_IPV4HDR_LEN || tot_len <= ihl ||
+				 l3_off + tot_len > frame_len || ihl > seg_len))
+			return -1;
+
+		info->key.src[0] = ipv4->src_addr;
+		info->key.dst[0] = ipv4->dst_addr;
+		info->key.id     = ipv4->id;
+		info->key.proto  = ipv4->proto;
+		info->offset     = _ODP_IPV4HDR_FRAG_OFFSET(frag) * 8;
+		info->len        = tot_len - ihl;
+		info->more       = !!(frag & _ODP_IPV4HDR_FRAG_OFFSET_MORE_FRAGS);
+		info->hdr_len    = l3_off + ihl;
+		info->ip_hdr_len = ihl;
+
+		if (odp_unlikely(ihl + info->offset + info->len > MAX_IP_LEN))
+			return -1;
+	} else if (_ODP_IPV4HDR_VER(l3[0]) == _ODP_IPV6) {
+		const _odp_ipv6hdr_t *ipv6 = (const _odp_ipv6hdr_t *)(uintptr_t)l3;
+		const ipv6_frag_hdr_t *frag_hdr;
+		uint32_t payload_len, offset, unfrag_len;
+		uint16_t frag_off;
+		uint8_t next_hdr;
+
+		if (!tbl->en_ipv6 || seg_len < _ODP_IPV6HDR_LEN)
+			return 0;
+
+		payload_len = odp_be_to_cpu_16(ipv6->payload_len);
+		next_hdr = ipv6->next_hdr;
+		offset = _ODP_IPV6HDR_LEN;
+
+		/* Skip extension headers of the unfragmentable part */
+		while (next_hdr == _ODP_IPPROTO_HOPOPTS ||
+		       next_hdr == _ODP_IPPROTO_ROUTE ||
+		       next_hdr == _ODP_IPPROTO_DEST) {
+			const _odp_ipv6hdr_ext_t *ext;
+
+			if (offset + sizeof(_odp_ipv6hdr_ext_t) > seg_len)
+				return 0;
+
+			ext = (const _odp_ipv6hdr_ext_t *)(uintptr_t)(l3 + offset);
+			next_hdr = ext->next_hdr;
+			offset += 8 + ext->ext_len * 8;
+		}
+
+		if (odp_likely(next_hdr != _ODP_IPPROTO_FRAG))
+			return 0;
+
+		if (odp_unlikely(offset + IPV6_FRAG_HDR_LEN > seg_len ||
+				 offset + IPV6_FRAG_HDR_LEN > _ODP_IPV6HDR_LEN + payload_len ||
+				 l3_off + _ODP_IPV6HDR_LEN + payload_len > frame_len))
+			return -1;
+
+		frag_hdr = (const ipv6_frag_hdr_t *)(uintptr_t)(l3 + offset);
+		frag_off = odp_be_to_cpu_16(frag_hdr->frag_off);
+
+		/* Atomic fragment (RFC 6946) is processed as a normal packet */
+		if ((frag_off & (IPV6_FRAG_OFFSET_MASK | IPV6_FRAG_MORE)) == 0)
+			return 0;
+
+		unfrag_len = offset - _ODP_IPV6HDR_LEN;
+
+		memcpy(info->key.src, ipv6->src_addr.u8, _ODP_IPV6ADDR_LEN);
+		memcpy(info->key.dst, ipv6->dst_addr.u8, _ODP_IPV6ADDR_LEN);
+		info->key.id     = frag_hdr->id;
+		info->key.ipv6   = 1;
+		info->offset     = frag_off & IPV6_FRAG_OFFSET_MASK;
+		info->len        = _ODP_IPV6HDR_LEN + payload_len - offset - IPV6_FRAG_HDR_LEN;
+		info->more       = !!(frag_off & IPV6_FRAG_MORE);
+		info->hdr_len    = l3_off + offset + IPV6_FRAG_HDR_LEN;
+		info->ip_hdr_len = offset;
+
+		if (odp_unlikely(info->len == 0 ||
+				 unfrag_len + info->offset + info->len > MAX_IP_LEN))
+			return -1;
+	} else {
+		return 0;
+	}
+
+	/* All but the last fragment must be multiple of 8 bytes */
+	if (odp_unlikely(info->more && (info->len & 7)))
+		return -1;
+
+	return 1;
+}
+
+static inline uint32_t flow_lookup(_odp_reass_tbl_t *tbl, const _odp_reass_key_t *key,
+				   uint32_t hash)
+{
+	uint32_t idx = tbl->bucket[hash & tbl->hash_mask];
+
+	while (idx != NULL_IDX) {
+		if (key_equal(&tbl->flow[idx].key, key))
+			return idx;
+
+		idx = tbl->flow[idx].next;
+	}
+
+	return NULL_IDX;
+}
+
+static inline uint32_t flow_alloc(_odp_reass_tbl_t *tbl, const _odp_reass_key_t *key,
+				  uint32_t hash, uint64_t now_ns)
+{
+	uint32_t idx = tbl->free_head;
+	uint32_t *bucket = &tbl->bucket[hash & tbl->hash_mask];
+	_odp_reass_flow_t *flow;
+
+	if (odp_unlikely(idx == NULL_IDX))
+		return NULL_IDX;
+
+	flow = &tbl->flow[idx];
+	tbl->free_head = flow->next;
+
+	flow->key       = *key;
+	flow->first_ns  = now_ns;
+	flow->total_len = 0;
+	flow->recv_len  = 0;
+	flow->num_frags = 0;
+
+	/* Link to hash chain */
+	flow->next = *bucket;
+	*bucket = idx;
+
+	/* Link to age list tail */
+	flow->age_next = NULL_IDX;
+	flow->age_prev = tbl->age_tail;
+
+	if (tbl->age_tail == NULL_IDX) {
+		tbl->age_head = idx;
+		tbl->expire_ns = now_ns + tbl->wait_ns;
+	} else {
+		tbl->flow[tbl->age_tail].age_next = idx;
+	}
+
+	tbl->age_tail = idx;
+	tbl->num_active++;
+
+	return idx;
+}
+
+static void flow_release(_odp_reass_tbl_t *tbl, uint32_t idx)
+{
+	_odp_reass_flow_t *flow = &tbl->flow[idx];
+	uint32_t *prev = &tbl->bucket[key_hash(&flow->key) & tbl->hash_mask];
+
+	/* Unlink from hash chain */
+	while (*prev != idx)
+		prev = &tbl->flow[*prev].next;
+
+	*prev = flow->next;
+
+	/* Unlink from age list */
+	if (flow->age_prev == NULL_IDX) {
+		tbl->age_head = flow->age_next;
+		tbl->expire_ns = flow->age_next == NULL_IDX ? UINT64_MAX :
+				 tbl->flow[flow->age_next].first_ns + tbl->wait_ns;
+	} else {
+		tbl->flow[flow->age_prev].age_next = flow->age_next;
+	}
+
+	if (flow->age_next == NULL_IDX)
+		tbl->age_tail = flow->age_prev;
+	else
+		tbl->flow[flow->age_next].age_prev = flow->age_prev;
+
+	flow->next = tbl->free_head;
+	tbl->free_head = idx;
+	tbl->num_active--;
+}
+
+static void flow_drop(_odp_reass_tbl_t *tbl, uint32_t idx)
+{
+	_odp_reass_flow_t *flow = &tbl->flow[idx];
+	_odp_reass_frag_t *frag = flow_frags(tbl, idx);
+	uint32_t i;
+
+	for (i = 0; i < flow->num_frags; i++)
+		odp_packet_free(frag[i].pkt);
+
+	flow_release(tbl, idx);
+}
+
+/* Remove IPv6 fragment header from the first fragment. Headers up to and
+ * including the fragment header are in the first segment. */
+static void ipv6_frag_hdr_remove(odp_packet_t pkt, uint32_t l3_off, uint32_t frag_hdr_off,
+				 uint32_t unfrag_len, uint32_t total_len)
+{
+	uint8_t *data = odp_packet_data(pkt);
+	_odp_ipv6hdr_t *ipv6 = (_odp_ipv6hdr_t *)(uintptr_t)(data + l3_off);
+	const ipv6_frag_hdr_t *frag_hdr = (const ipv6_frag_hdr_t *)(uintptr_t)(data + frag_hdr_off);
+	uint8_t next_hdr = frag_hdr->next_hdr;
+	uint8_t *prev_next_hdr = &ipv6->next_hdr;
+	uint32_t offset = _ODP_IPV6HDR_LEN;
+
+	/* Find the next header field that points to the fragment header */
+	while (l3_off + offset < frag_hdr_off) {
+		_odp_ipv6hdr_ext_t *ext = (_odp_ipv6hdr_ext_t *)(uintptr_t)(data + l3_off + offset);
+
+		prev_next_hdr = &ext->next_hdr;
+		offset += 8 + ext->ext_len * 8;
+	}
+
+	*prev_next_hdr = next_hdr;
+	ipv6->payload_len = odp_cpu_to_be_16(unfrag_len + total_len);
+
+	/* Move headers over the fragment header */
+	memmove(data + IPV6_FRAG_HDR_LEN, data, frag_hdr_off);
+	odp_packet_pull_head(pkt, IPV6_FRAG_HDR_LEN);
+}
+
+/* Chain payload of all fragments to the first one. Returns 0 on success. */
+static int flow_assemble(_odp_reass_tbl_t *tbl, uint32_t idx, odp_packet_t *pkt_out)
+{
+	_odp_reass_flow_t *flow = &tbl->flow[idx];
+	_odp_reass_frag_t *frag = flow_frags(tbl, idx);
+	uint32_t num = flow->num_frags;
+	uint32_t total_len = flow->total_len;
+	odp_packet_t pkt = frag[0].pkt;
+	odp_packet_hdr_t *pkt_hdr = packet_hdr(pkt);
+	uint32_t l3_off = pkt_hdr->p.l3_offset;
+	uint32_t orig_ip_len = 0;
+	uint32_t i, len;
+
+	if (flow->key.tag) {
+		for (i = 0; i < num; i++)
+			orig_ip_len += packet_hdr(frag[i].pkt)->ipsec_ctx.orig_ip_len;
+	}
+
+	/* Remove possible link layer padding */
+	len = frag[0].hdr_len + frag[0].len;
+	if (odp_packet_len(pkt) > len &&
+	    odp_packet_trunc_tail(&pkt, odp_packet_len(pkt) - len, NULL, NULL))
+		goto error;
+
+	frag[0].pkt = pkt;
+
+	for (i = 1; i < num; i++) {
+		odp_packet_t cur = frag[i].pkt;
+
+		len = frag[i].hdr_len + frag[i].len;
+		if (odp_packet_len(cur) > len &&
+		    odp_packet_trunc_tail(&cur, odp_packet_len(cur) - len, NULL, NULL))
+			goto error;
+
+		if (odp_packet_trunc_head(&cur, frag[i].hdr_len, NULL, NULL))
+			goto error;
+
+		frag[i].pkt = cur;
+
+		if (odp_packet_concat(&pkt, cur) < 0)
+			goto error;
+
+		frag[i].pkt = ODP_PACKET_INVALID;
+	}
+
+	pkt_hdr = packet_hdr(pkt);
+
+	if (!flow->key.ipv6) {
+		_odp_ipv4hdr_t *ipv4 = odp_packet_offset(pkt, l3_off, NULL, NULL);
+		uint32_t ihl = frag[0].hdr_len - l3_off;
+
+		ipv4->tot_len = odp_cpu_to_be_16(ihl + total_len);
+		ipv4->frag_offset &= odp_cpu_to_be_16(0x4000);
+		_odp_packet_ipv4_chksum_insert(pkt);
+	} else {
+		uint32_t frag_hdr_off = frag[0].hdr_len - IPV6_FRAG_HDR_LEN;
+
+		ipv6_frag_hdr_remove(pkt, l3_off, frag_hdr_off,
+				     frag_hdr_off - l3_off - _ODP_IPV6HDR_LEN, total_len);
+	}
+
+	if (flow->key.tag)
+		pkt_hdr->ipsec_ctx.orig_ip_len = orig_ip_len;
+
+	pkt_hdr->reass_num_frags = num;
+	pkt_hdr->p.flags.reass_status = ODP_PACKET_REASS_COMPLETE;
+
+	flow_release(tbl, idx);
+	*pkt_out = pkt;
+	return 0;
+
+error:
+	ODP_DBG("Reassembly failed\n");
+	odp_packet_free(pkt);
+
+	for (i = 1; i < num; i++)
+		if (frag[i].pkt != ODP_PACKET_INVALID)
+			odp_packet_free(frag[i].pkt);
+
+	flow_release(tbl, idx);
+	return -1;
+}
+
+_odp_reass_result_t _odp_reass_packet(_odp_reass_tbl_t *tbl, odp_packet_t *pkt,
+				      uint32_t tag, uint64_t now_ns)
+{
+	odp_packet_hdr_t *pkt_hdr = packet_hdr(*pkt);
+	_odp_reass_flow_t *flow;
+	_odp_reass_frag_t *frag;
+	frag_info_t info;
+	uint32_t hash, idx, pos, end;
+	int ret;
+
+	ret = frag_info(tbl, *pkt, pkt_hdr, &info);
+
+	if (odp_likely(ret == 0))
+		return _ODP_REASS_PASS;
+
+	if (odp_unlikely(ret < 0)) {
+		odp_packet_free(*pkt);
+		return _ODP_REASS_DROP;
+	}
+
+	info.key.tag = tag;
+	hash = key_hash(&info.key);
+	idx = flow_lookup(tbl, &info.key, hash);
+
+	if (idx == NULL_IDX) {
+		idx = flow_alloc(tbl, &info.key, hash, now_ns);
+
+		/* Table full, let the application see the fragment */
+		if (odp_unlikely(idx == NULL_IDX))
+			return _ODP_REASS_PASS;
+	}
+
+	flow = &tbl->flow[idx];
+	frag = flow_frags(tbl, idx);
+	end = info.offset + info.len;
+
+	/* Find position in offset order and check overlaps */
+	for (pos = 0; pos < flow->num_frags; pos++)
+		if (frag[pos].offset > info.offset)
+			break;
+
+	if (pos > 0 && frag[pos - 1].offset + frag[pos - 1].len > info.offset) {
+		/* Exact duplicate is dropped silently */
+		if (frag[pos - 1].offset == info.offset && frag[pos - 1].len == info.len) {
+			odp_packet_free(*pkt);
+			return _ODP_REASS_STORED;
+		}
+
+		goto drop;
+	}
+
+	if (pos < flow->num_frags && end > frag[pos].offset)
+		goto drop;
+
+	if (!info.more) {
+		if (flow->total_len)
+			goto drop;
+
+		if (flow->num_frags && frag[flow->num_frags - 1].offset +
+		    frag[flow->num_frags - 1].len > end)
+			goto drop;
+
+		flow->total_len = end;
+	} else if (flow->total_len && end > flow->total_len) {
+		goto drop;
+	}
+
+	if (odp_unlikely(flow->num_frags == tbl->max_frags))
+		goto drop;
+
+	memmove(&frag[pos + 1], &frag[pos], (flow->num_frags - pos) * sizeof(_odp_reass_frag_t));
+	frag[pos].pkt     = *pkt;
+	frag[pos].offset  = info.offset;
+	frag[pos].len     = info.len;
+	frag[pos].hdr_len = info.hdr_len;
+	flow->num_frags++;
+	flow->recv_len += info.len;
+
+	if (flow->total_len == 0 || flow->recv_len != flow->total_len)
+		return _ODP_REASS_STORED;
+
+	if (flow_assemble(tbl, idx, pkt))
+		return _ODP_REASS_DROP;
+
+	return _ODP_REASS_COMPLETE;
+
+drop:
+	odp_packet_free(*pkt);
+	flow_drop(tbl, idx);
+	return _ODP_REASS_DROP;
+}
+
+static odp_packet_t partial_create(_odp_reass_tbl_t *tbl, uint32_t idx)
+{
+	_odp_reass_flow_t *flow = &tbl->flow[idx];
+	_odp_reass_frag_t *frag = flow_frags(tbl, idx);
+	odp_packet_hdr_t *first_hdr = packet_hdr(frag[0].pkt);
+	odp_packet_hdr_t *pkt_hdr;
+	_odp_reass_partial_t partial;
+	odp_packet_t pkt;
+	uint32_t i, len;
+
+	len = sizeof(_odp_reass_partial_t) + flow->num_frags * sizeof(odp_packet_t);
+	pkt = odp_packet_alloc(odp_packet_pool(frag[0].pkt), len);
+	if (odp_unlikely(pkt == ODP_PACKET_INVALID))
+		return ODP_PACKET_INVALID;
+
+	partial.first_ns  = flow->first_ns;
+	partial.num_frags = flow->num_frags;
+	odp_packet_copy_from_mem(pkt, 0, sizeof(partial), &partial);
+
+	for (i = 0; i < flow->num_frags; i++)
+		odp_packet_copy_from_mem(pkt, sizeof(partial) + i * sizeof(odp_packet_t),
+					 sizeof(odp_packet_t), &frag[i].pkt);
+
+	pkt_hdr = packet_hdr(pkt);
+	pkt_hdr->input = first_hdr->input;
+	pkt_hdr->p.flags.reass_status = ODP_PACKET_REASS_INCOMPLETE;
+
+	/* Deliver to the same destination queue as the fragments */
+	if (first_hdr->p.input_flags.dst_queue) {
+		pkt_hdr->p.input_flags.dst_queue = 1;
+		pkt_hdr->dst_queue = first_hdr->dst_queue;
+		pkt_hdr->cos = first_hdr->cos;
+	}
+
+	return pkt;
+}
+
+int _odp_reass_expire(_odp_reass_tbl_t *tbl, uint64_t now_ns,
+		      odp_packet_t pkt[], int num, uint32_t *num_drop)
+{
+	int num_out = 0;
+
+	while (num_out < num && _odp_reass_expire_pending(tbl, now_ns)) {
+		uint32_t idx = tbl->age_head;
+		odp_packet_t partial = partial_create(tbl, idx);
+
+		if (odp_unlikely(partial == ODP_PACKET_INVALID)) {
+			flow_drop(tbl, idx);
+			(*num_drop)++;
+			continue;
+		}
+
+		flow_release(tbl, idx);
+		pkt[num_out++] = partial;
+	}
+
+	return num_out;
+}
+
+void _odp_reass_tbl_flush(_odp_reass_tbl_t *tbl)
+{
+	while (tbl->num_active)
+		flow_drop(tbl, tbl->age_head);
+}
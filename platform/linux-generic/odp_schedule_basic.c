@@ -5,14 +5,6 @@
  * SPDX-License-Identifier:     BSD-3-Clause
  */
 
-/*
- * Suppress bounds warnings about interior zero length arrays. Such an array
- * is used intentionally in prio_queue_t.
- */
-#if __GNUC__ >= 10
-#pragma GCC diagnostic ignored "-Wzero-length-bounds"
-#endif
-
 #include <odp/api/schedule.h>
 #include <odp_schedule_if.h>
 #include <odp/api/align.h>
@@ -34,20 +26,25 @@
 #include <odp_queue_basic_internal.h>
 #include <odp_libconfig_internal.h>
 #include <odp/api/plat/queue_inlines.h>
+#include <odp/api/plat/packet_inlines.h>
 #include <odp_global_data.h>
 #include <odp_event_internal.h>
 #include <odp_macros_internal.h>
 
+#include <inttypes.h>
 #include <string.h>
 
 /* No synchronization context */
 #define NO_SYNC_CONTEXT ODP_SCHED_SYNC_PARALLEL
 
-/* Number of priority levels  */
-#define NUM_PRIO 8
+/* Maximum number of priority levels. Actual number is configurable. */
+#define MAX_PRIO 32
 
-/* Number of scheduling groups */
-#define NUM_SCHED_GRPS 32
+/* Maximum number of scheduling groups. Actual number is configurable. */
+#define MAX_SCHED_GRPS 1024
+
+/* Number of 64 bit words in a scheduling group bitmap */
+#define GRP_MASK_WORDS (MAX_SCHED_GRPS / 64)
 
 /* Spread balancing frequency. Balance every BALANCE_ROUNDS_M1 + 1 scheduling rounds. */
 #define BALANCE_ROUNDS_M1 0xfffff
@@ -59,7 +56,8 @@
 #define QUEUE_LOAD_MARGIN 8
 
 /* Ensure that load calculation does not wrap around */
-ODP_STATIC_ASSERT((QUEUE_LOAD * CONFIG_MAX_SCHED_QUEUES) < UINT32_MAX, "Load_value_too_large");
+ODP_STATIC_ASSERT((QUEUE_LOAD * (uint64_t)CONFIG_MAX_SCHED_QUEUES_LIMIT) < UINT32_MAX,
+		  "Load_value_too_large");
 
 /* Maximum priority queue spread */
 #define MAX_SPREAD 8
@@ -87,12 +85,9 @@ ODP_STATIC_ASSERT((QUEUE_LOAD * CONFIG_MAX_SCHED_QUEUES) < UINT32_MAX, "Load_val
 
 /* Maximum priority queue ring size. A ring must be large enough to store all
  * queues in the worst case (all queues are scheduled, have the same priority
- * and no spreading). */
-#define MAX_RING_SIZE CONFIG_MAX_SCHED_QUEUES
-
-/* For best performance, the number of queues should be a power of two. */
-ODP_STATIC_ASSERT(_ODP_CHECK_IS_POWER2(CONFIG_MAX_SCHED_QUEUES),
-		  "Number_of_queues_is_not_power_of_two");
+ * and no spreading). Actual ring size depends on the configured number of
+ * scheduled queues. */
+#define MAX_RING_SIZE CONFIG_MAX_SCHED_QUEUES_LIMIT
 
 /* Ring size must be power of two, so that mask can be used. */
 ODP_STATIC_ASSERT(_ODP_CHECK_IS_POWER2(MAX_RING_SIZE),
@@ -134,6 +129,73 @@ typedef union {
 ODP_STATIC_ASSERT(sizeof(lock_called_t) == sizeof(uint32_t),
 		  "Lock_called_values_do_not_fit_in_uint32");
 
+/* Reorder window size in ordered contexts. A thread may release its ordered
+ * context without waiting, when it is less than this many contexts ahead of
+ * the current context. Must be a power of two. */
+#define RWIN_SIZE 32
+
+ODP_STATIC_ASSERT(_ODP_CHECK_IS_POWER2(RWIN_SIZE), "Reorder_window_size_is_not_power_of_two");
+
+/* Maximum number of enqueued events per ordered context in a reorder window */
+#define RWIN_MAX_EVENTS 64
+
+/* Number of reorder windows. Ordered queues created after all windows are in
+ * use release contexts by waiting for own turn. */
+#define NUM_RWIN 128
+
+/* Ordered context released out of order */
+typedef struct {
+	uint8_t valid;
+	uint16_t num;
+	lock_called_t lock_called;
+	odp_queue_t queue[RWIN_MAX_EVENTS];
+	_odp_event_hdr_t *event_hdr[RWIN_MAX_EVENTS];
+
+} rwin_slot_t;
+
+/* Reorder window of an ordered queue. Enqueues of contexts that are released
+ * before their turn are stored into the window, and the thread releasing the
+ * current context performs those in order. */
+typedef struct ODP_ALIGNED_CACHE {
+	odp_ticketlock_t lock;
+	uint8_t allocated;
+	rwin_slot_t slot[RWIN_SIZE];
+
+} reorder_window_t;
+
+/* Number of events per schedule call histogram bins: 1, 2-3, 4-7, 8-15,
+ * 16-31 and 32 or more events */
+#define STAT_HIST_SIZE 6
+
+/* Per thread scheduler statistics. Updated only by the owner thread. */
+typedef struct ODP_ALIGNED_CACHE {
+	/* Schedule API calls */
+	uint64_t calls;
+
+	/* Scheduling rounds that did not find events */
+	uint64_t empty_polls;
+
+	/* Events returned to the application */
+	uint64_t events;
+
+	/* Schedule calls that returned events from the thread local stash */
+	uint64_t stash_hits;
+
+	/* Packet input queue polls */
+	uint64_t pktin_polls;
+
+	/* Waits for own turn in an ordered context */
+	uint64_t ordered_waits;
+
+	/* Schedule calls that got events from a non-preferred spread after
+	 * the first spread was found empty */
+	uint64_t steal;
+
+	/* Schedule calls per number of events returned */
+	uint64_t hist[STAT_HIST_SIZE];
+
+} sched_thr_stat_t;
+
 /* Shuffled values from 0 to 127 */
 static uint8_t sched_random_u8[] = {
 	0x5B, 0x56, 0x21, 0x28, 0x77, 0x2C, 0x7E, 0x10,
@@ -165,6 +227,12 @@ typedef struct ODP_ALIGNED_CACHE {
 	uint8_t  balance_on;
 	uint16_t balance_start;
 	uint16_t spread_round;
+	uint8_t  prefetch_depth;
+	uint8_t  prefetch_data;
+	uint8_t  work_steal;
+
+	/* Statistics of this thread in global data */
+	sched_thr_stat_t *stat;
 
 	struct {
 		uint16_t    num_ev;
@@ -176,10 +244,15 @@ typedef struct ODP_ALIGNED_CACHE {
 	} stash;
 
 	uint32_t grp_epoch;
-	uint32_t grp_mask;
 	uint16_t num_grp;
-	uint8_t grp_idx;
-	uint8_t grp[NUM_SCHED_GRPS];
+	uint16_t grp_idx;
+	uint16_t num_grp_word;
+	uint16_t grp[MAX_SCHED_GRPS];
+
+	/* Non-zero words of the thread's group bitmap */
+	uint8_t  grp_word[GRP_MASK_WORDS];
+	uint64_t grp_word_mask[GRP_MASK_WORDS];
+
 	uint8_t spread_tbl[SPREAD_TBL_SIZE];
 
 	struct {
@@ -195,18 +268,18 @@ typedef struct ODP_ALIGNED_CACHE {
 
 } sched_local_t;
 
-#pragma GCC diagnostic push
-#pragma GCC diagnostic ignored "-Wpedantic"
-/* Priority queue */
-typedef struct ODP_ALIGNED_CACHE {
-	/* Ring header */
-	ring_u32_t ring;
-
-	/* Ring data: queue indexes */
-	uint32_t queue_index[MAX_RING_SIZE]; /* overlaps with ring.data[] */
-
-} prio_queue_t;
-#pragma GCC diagnostic pop
+/* Scheduler state of a queue */
+typedef struct {
+	uint16_t grp;
+	/* Inverted prio value (max = 0) vs API (min = 0)*/
+	uint8_t prio;
+	uint8_t spread;
+	uint8_t sync;
+	uint8_t order_lock_count;
+	uint8_t poll_pktin;
+	uint8_t pktio_index;
+	uint8_t pktin_index;
+} sched_queue_t;
 
 /* Order context of a queue */
 typedef struct ODP_ALIGNED_CACHE {
@@ -219,14 +292,23 @@ typedef struct ODP_ALIGNED_CACHE {
 	/* Array of ordered locks */
 	odp_atomic_u64_t lock[CONFIG_QUEUE_MAX_ORD_LOCKS];
 
+	/* Reorder window or NULL */
+	reorder_window_t *rwin;
+
 } order_context_t;
 
 typedef struct {
 	struct {
-		uint8_t burst_default[NUM_PRIO];
-		uint8_t burst_max[NUM_PRIO];
+		uint8_t burst_default[MAX_PRIO];
+		uint8_t burst_max[MAX_PRIO];
+		uint16_t num_grps;
+		uint8_t num_prio;
 		uint8_t num_spread;
 		uint8_t prefer_ratio;
+		uint8_t prefetch_depth;
+		uint8_t prefetch_data;
+		uint8_t work_steal;
+		uint8_t pktin_direct;
 	} config;
 
 	uint8_t          load_balance;
@@ -234,33 +316,28 @@ typedef struct {
 	uint32_t         ring_mask;
 	odp_atomic_u32_t grp_epoch;
 	odp_shm_t        shm;
-	odp_ticketlock_t mask_lock[NUM_SCHED_GRPS];
-	prio_q_mask_t    prio_q_mask[NUM_SCHED_GRPS][NUM_PRIO];
+	odp_ticketlock_t mask_lock[MAX_SCHED_GRPS];
 
-	/* Groups on a priority level that have queues created */
-	odp_atomic_u32_t prio_grp_mask[NUM_PRIO];
+	/* Bitmap of groups on a priority level that have queues created */
+	odp_atomic_u64_t prio_grp_mask[MAX_PRIO][GRP_MASK_WORDS];
 
-	struct {
-		uint8_t grp;
-		/* Inverted prio value (max = 0) vs API (min = 0)*/
-		uint8_t prio;
-		uint8_t spread;
-		uint8_t sync;
-		uint8_t order_lock_count;
-		uint8_t poll_pktin;
-		uint8_t pktio_index;
-		uint8_t pktin_index;
-	} queue[CONFIG_MAX_SCHED_QUEUES];
-
-	/* Scheduler priority queues */
-#pragma GCC diagnostic push
-#pragma GCC diagnostic ignored "-Wpedantic"
-	prio_queue_t prio_q[NUM_SCHED_GRPS][NUM_PRIO][MAX_SPREAD];
-#pragma GCC diagnostic pop
-	uint32_t prio_q_count[NUM_SCHED_GRPS][NUM_PRIO][MAX_SPREAD];
-
-	/* Number of queues per group and priority  */
-	uint32_t prio_grp_count[NUM_PRIO][NUM_SCHED_GRPS];
+	/* Per queue state, indexed by queue index */
+	sched_queue_t *queue;
+
+	/* Masks of spreads that have queues, indexed by group and priority */
+	prio_q_mask_t *prio_q_mask;
+
+	/* Number of queues per spread, indexed by group, priority and spread */
+	uint32_t *prio_q_count;
+
+	/* Number of queues per group, indexed by priority and group */
+	uint32_t *prio_grp_count;
+
+	/* Scheduler priority queues (rings of queue indexes). Rings of a group
+	 * and priority level are stored consecutively, num_spread rings
+	 * ring_stride bytes apart. */
+	uint8_t *prio_q_base;
+	uint64_t ring_stride;
 
 	odp_thrmask_t  mask_all;
 	odp_ticketlock_t grp_lock;
@@ -270,25 +347,34 @@ typedef struct {
 		odp_thrmask_t  mask;
 		uint16_t       spread_thrs[MAX_SPREAD];
 		uint8_t        allocated;
-	} sched_grp[NUM_SCHED_GRPS];
+	} sched_grp[MAX_SCHED_GRPS];
 
 	struct {
 		int num_pktin;
 	} pktio[NUM_PKTIO];
 	odp_ticketlock_t pktio_lock;
 
-	order_context_t order[CONFIG_MAX_SCHED_QUEUES];
+	/* Order contexts, indexed by queue index */
+	order_context_t *order;
+
+	reorder_window_t rwin[NUM_RWIN];
+	odp_ticketlock_t rwin_lock;
 
 	/* Scheduler interface config options (not used in fast path) */
 	schedule_config_t config_if;
 	uint32_t max_queues;
+	odp_shm_t queue_shm;
 	odp_atomic_u32_t next_rand;
 
+	sched_thr_stat_t thr_stat[ODP_THREAD_COUNT_MAX];
+
 } sched_global_t;
 
 /* Check that queue[] variables are large enough */
-ODP_STATIC_ASSERT(NUM_SCHED_GRPS  <= 32,  "Group mask is 32 bits");
-ODP_STATIC_ASSERT(NUM_PRIO        <= 256, "Prio_does_not_fit_8_bits");
+ODP_STATIC_ASSERT(MAX_SCHED_GRPS  <= 64 * 1024, "Group_does_not_fit_16_bits");
+ODP_STATIC_ASSERT((MAX_SCHED_GRPS % 64) == 0, "Group_bitmap_not_multiple_of_64_bits");
+ODP_STATIC_ASSERT(GRP_MASK_WORDS  <= 256, "Group_bitmap_word_does_not_fit_8_bits");
+ODP_STATIC_ASSERT(MAX_PRIO        <= 256, "Prio_does_not_fit_8_bits");
 ODP_STATIC_ASSERT(MAX_SPREAD      <= 256, "Spread_does_not_fit_8_bits");
 ODP_STATIC_ASSERT(CONFIG_QUEUE_MAX_ORD_LOCKS <= 256,
 		  "Ordered_lock_count_does_not_fit_8_bits");
@@ -300,15 +386,88 @@ static sched_global_t *sched;
 /* Thread local scheduler context */
 static __thread sched_local_t sched_local;
 
+/* Mask of spreads that have queues on a group and priority level */
+static inline prio_q_mask_t *prio_q_mask(int grp, int prio)
+{
+	return &sched->prio_q_mask[grp * sched->config.num_prio + prio];
+}
+
+/* Number of queues on a group, priority level and spread */
+static inline uint32_t *prio_q_count(int grp, int prio, int spr)
+{
+	uint32_t i = (grp * sched->config.num_prio + prio) * sched->config.num_spread + spr;
+
+	return &sched->prio_q_count[i];
+}
+
+/* Priority queue ring of a group, priority level and spread */
+static inline ring_u32_t *prio_q_ring(int grp, int prio, int spr)
+{
+	uint64_t i = (grp * sched->config.num_prio + prio) * sched->config.num_spread + spr;
+
+	return (ring_u32_t *)(uintptr_t)(sched->prio_q_base + i * sched->ring_stride);
+}
+
+/* Update statistics of a schedule call that returned 'num' events */
+static inline void stat_sched_call(int num)
+{
+	sched_thr_stat_t *stat = sched_local.stat;
+	int bin;
+
+	if (!CONFIG_SCHED_STATISTICS)
+		return;
+
+	stat->calls++;
+
+	if (num <= 0)
+		return;
+
+	bin = 31 - __builtin_clz(num);
+	if (bin >= STAT_HIST_SIZE)
+		bin = STAT_HIST_SIZE - 1;
+
+	stat->events += num;
+	stat->hist[bin]++;
+}
+
 static int read_config_file(sched_global_t *sched)
 {
 	const char *str;
-	int i;
-	int burst_val[NUM_PRIO];
+	int i, num;
+	int burst_val[MAX_PRIO];
 	int val = 0;
 
 	ODP_PRINT("Scheduler config:\n");
 
+	str = "sched_basic.num_groups";
+	if (!_odp_libconfig_lookup_int(str, &val)) {
+		ODP_ERR("Config option '%s' not found.\n", str);
+		return -1;
+	}
+
+	if (val > MAX_SCHED_GRPS || val < SCHED_GROUP_NAMED) {
+		ODP_ERR("Bad value %s = %i [min: %i, max: %i]\n", str, val,
+			SCHED_GROUP_NAMED, MAX_SCHED_GRPS);
+		return -1;
+	}
+
+	sched->config.num_grps = val;
+	ODP_PRINT("  %s: %i\n", str, val);
+
+	str = "sched_basic.num_prio";
+	if (!_odp_libconfig_lookup_int(str, &val)) {
+		ODP_ERR("Config option '%s' not found.\n", str);
+		return -1;
+	}
+
+	if (val > MAX_PRIO || val < 1) {
+		ODP_ERR("Bad value %s = %i [min: 1, max: %i]\n", str, val, MAX_PRIO);
+		return -1;
+	}
+
+	sched->config.num_prio = val;
+	ODP_PRINT("  %s: %i\n", str, val);
+
 	str = "sched_basic.prio_spread";
 	if (!_odp_libconfig_lookup_int(str, &val)) {
 		ODP_ERR("Config option '%s' not found.\n", str);
@@ -355,16 +514,17 @@ static int read_config_file(sched_global_t *sched)
 	if (val == 0 || sched->config.num_spread == 1)
 		sched->load_balance = 0;
 
+	/* Priority levels beyond the array length use the last value */
 	str = "sched_basic.burst_size_default";
-	if (_odp_libconfig_lookup_array(str, burst_val, NUM_PRIO) !=
-	    NUM_PRIO) {
+	num = _odp_libconfig_lookup_array(str, burst_val, MAX_PRIO);
+	if (num <= 0) {
 		ODP_ERR("Config option '%s' not found.\n", str);
 		return -1;
 	}
 
 	ODP_PRINT("  %s[] =", str);
-	for (i = 0; i < NUM_PRIO; i++) {
-		val = burst_val[i];
+	for (i = 0; i < sched->config.num_prio; i++) {
+		val = burst_val[i < num ? i : num - 1];
 		sched->config.burst_default[i] = val;
 		ODP_PRINT(" %3i", val);
 
@@ -376,15 +536,15 @@ static int read_config_file(sched_global_t *sched)
 	ODP_PRINT("\n");
 
 	str = "sched_basic.burst_size_max";
-	if (_odp_libconfig_lookup_array(str, burst_val, NUM_PRIO) !=
-	    NUM_PRIO) {
+	num = _odp_libconfig_lookup_array(str, burst_val, MAX_PRIO);
+	if (num <= 0) {
 		ODP_ERR("Config option '%s' not found.\n", str);
 		return -1;
 	}
 
 	ODP_PRINT("  %s[] =    ", str);
-	for (i = 0; i < NUM_PRIO; i++) {
-		val = burst_val[i];
+	for (i = 0; i < sched->config.num_prio; i++) {
+		val = burst_val[i < num ? i : num - 1];
 		sched->config.burst_max[i] = val;
 		ODP_PRINT(" %3i", val);
 
@@ -396,6 +556,62 @@ static int read_config_file(sched_global_t *sched)
 
 	ODP_PRINT("\n");
 
+	str = "sched_basic.prefetch_depth";
+	if (!_odp_libconfig_lookup_int(str, &val)) {
+		ODP_ERR("Config option '%s' not found.\n", str);
+		return -1;
+	}
+
+	if (val > STASH_SIZE || val < 0) {
+		ODP_ERR("Bad value %s = %i [min: 0, max: %i]\n", str, val, STASH_SIZE);
+		return -1;
+	}
+
+	sched->config.prefetch_depth = val;
+	ODP_PRINT("  %s: %i\n", str, val);
+
+	str = "sched_basic.prefetch_data";
+	if (!_odp_libconfig_lookup_int(str, &val)) {
+		ODP_ERR("Config option '%s' not found.\n", str);
+		return -1;
+	}
+
+	if (val > 1 || val < 0) {
+		ODP_ERR("Bad value %s = %i\n", str, val);
+		return -1;
+	}
+
+	sched->config.prefetch_data = val;
+	ODP_PRINT("  %s: %i\n", str, val);
+
+	str = "sched_basic.work_steal";
+	if (!_odp_libconfig_lookup_int(str, &val)) {
+		ODP_ERR("Config option '%s' not found.\n", str);
+		return -1;
+	}
+
+	if (val > 1 || val < 0) {
+		ODP_ERR("Bad value %s = %i\n", str, val);
+		return -1;
+	}
+
+	sched->config.work_steal = val;
+	ODP_PRINT("  %s: %i\n", str, val);
+
+	str = "sched_basic.pktin_direct";
+	if (!_odp_libconfig_lookup_int(str, &val)) {
+		ODP_ERR("Config option '%s' not found.\n", str);
+		return -1;
+	}
+
+	if (val > 1 || val < 0) {
+		ODP_ERR("Bad value %s = %i\n", str, val);
+		return -1;
+	}
+
+	sched->config.pktin_direct = val;
+	ODP_PRINT("  %s: %i\n", str, val);
+
 	str = "sched_basic.group_enable.all";
 	if (!_odp_libconfig_lookup_int(str, &val)) {
 		ODP_ERR("Config option '%s' not found.\n", str);
@@ -448,6 +664,12 @@ static void sched_local_init(void)
 	sched_local.thr         = odp_thread_id();
 	sched_local.sync_ctx    = NO_SYNC_CONTEXT;
 	sched_local.stash.queue = ODP_QUEUE_INVALID;
+	sched_local.prefetch_depth = sched->config.prefetch_depth;
+	sched_local.prefetch_data  = sched->config.prefetch_data;
+	sched_local.work_steal     = sched->config.work_steal && num_spread > 1;
+	sched_local.stat           = &sched->thr_stat[sched_local.thr];
+
+	memset(sched_local.stat, 0, sizeof(sched_thr_stat_t));
 
 	spread = spread_from_index(sched_local.thr);
 	prefer_ratio = sched->config.prefer_ratio;
@@ -469,7 +691,10 @@ static int schedule_init_global(void)
 	odp_shm_t shm;
 	int i, j, grp;
 	int prefer_ratio;
-	uint32_t ring_size, num_rings;
+	uint32_t ring_size, num_rings, num_queues, num_grp_prio, num_prio_q;
+	uint64_t ring_stride, order_size, queue_size, mask_size, count_size, grp_count_size;
+	uint64_t mem_size;
+	uint8_t *addr;
 
 	ODP_DBG("Schedule init ... ");
 
@@ -493,16 +718,19 @@ static int schedule_init_global(void)
 	sched->shm = shm;
 	prefer_ratio = sched->config.prefer_ratio;
 
+	/* Scheduled queue indexes are allocated by the queue implementation */
+	num_queues = _odp_queue_glb->config.max_sched_queues;
+
 	/* When num_spread == 1, only spread_tbl[0] is used. */
 	sched->max_spread = (sched->config.num_spread - 1) * prefer_ratio;
 
 	/* Dynamic load balance may move all queues into a single ring.
 	 * Ring size can be smaller with fixed spreading. */
 	if (sched->load_balance) {
-		ring_size = MAX_RING_SIZE;
+		ring_size = num_queues;
 		num_rings = 1;
 	} else {
-		ring_size = MAX_RING_SIZE / sched->config.num_spread;
+		ring_size = num_queues / sched->config.num_spread;
 		num_rings = sched->config.num_spread;
 	}
 
@@ -511,36 +739,76 @@ static int schedule_init_global(void)
 	sched->ring_mask = ring_size - 1;
 
 	/* Each ring can hold in maximum ring_size-1 queues. Due to ring size round up,
-	 * total capacity of rings may be larger than CONFIG_MAX_SCHED_QUEUES. */
+	 * total capacity of rings may be larger than the number of queues. */
 	sched->max_queues = sched->ring_mask * num_rings;
-	if (sched->max_queues > CONFIG_MAX_SCHED_QUEUES)
-		sched->max_queues = CONFIG_MAX_SCHED_QUEUES;
+	if (sched->max_queues > num_queues)
+		sched->max_queues = num_queues;
+
+	/* Queue state, order contexts and priority queue rings are sized
+	 * according to the number of queues. Per group and priority level
+	 * tables are sized according to the configured number of groups and
+	 * priorities. */
+	num_grp_prio   = sched->config.num_grps * sched->config.num_prio;
+	num_prio_q     = num_grp_prio * sched->config.num_spread;
+	queue_size     = _ODP_ROUNDUP_CACHE_LINE(num_queues * sizeof(sched_queue_t));
+	order_size     = (uint64_t)num_queues * sizeof(order_context_t);
+	mask_size      = _ODP_ROUNDUP_CACHE_LINE(num_grp_prio * sizeof(prio_q_mask_t));
+	count_size     = _ODP_ROUNDUP_CACHE_LINE(num_prio_q * sizeof(uint32_t));
+	grp_count_size = _ODP_ROUNDUP_CACHE_LINE(num_grp_prio * sizeof(uint32_t));
+	ring_stride    = _ODP_ROUNDUP_CACHE_LINE(sizeof(ring_u32_t) + ring_size * sizeof(uint32_t));
+	mem_size       = queue_size + order_size + mask_size + count_size + grp_count_size +
+			 ring_stride * num_prio_q;
+
+	shm = odp_shm_reserve("_odp_sched_basic_queues", mem_size,
+			      ODP_CACHE_LINE_SIZE, 0);
+	if (shm == ODP_SHM_INVALID) {
+		ODP_ERR("Schedule init: Shm reserve failed (%" PRIu64 " bytes)\n", mem_size);
+		odp_shm_free(sched->shm);
+		return -1;
+	}
 
-	for (grp = 0; grp < NUM_SCHED_GRPS; grp++) {
+	sched->queue_shm = shm;
+	addr = odp_shm_addr(shm);
+	memset(addr, 0, queue_size + order_size + mask_size + count_size + grp_count_size);
+
+	sched->queue = (sched_queue_t *)(uintptr_t)addr;
+	addr += queue_size;
+	sched->order = (order_context_t *)(uintptr_t)addr;
+	addr += order_size;
+	sched->prio_q_mask = (prio_q_mask_t *)(uintptr_t)addr;
+	addr += mask_size;
+	sched->prio_q_count = (uint32_t *)(uintptr_t)addr;
+	addr += count_size;
+	sched->prio_grp_count = (uint32_t *)(uintptr_t)addr;
+	addr += grp_count_size;
+	sched->prio_q_base = addr;
+	sched->ring_stride = ring_stride;
+
+	for (grp = 0; grp < sched->config.num_grps; grp++) {
 		odp_ticketlock_init(&sched->mask_lock[grp]);
 
-		for (i = 0; i < NUM_PRIO; i++) {
-			for (j = 0; j < MAX_SPREAD; j++) {
-				prio_queue_t *prio_q;
-
-				prio_q = &sched->prio_q[grp][i][j];
-				ring_u32_init(&prio_q->ring);
-			}
-		}
+		for (i = 0; i < sched->config.num_prio; i++)
+			for (j = 0; j < sched->config.num_spread; j++)
+				ring_u32_init(prio_q_ring(grp, i, j));
 	}
 
 	odp_ticketlock_init(&sched->pktio_lock);
 	for (i = 0; i < NUM_PKTIO; i++)
 		sched->pktio[i].num_pktin = 0;
 
+	odp_ticketlock_init(&sched->rwin_lock);
+	for (i = 0; i < NUM_RWIN; i++)
+		odp_ticketlock_init(&sched->rwin[i].lock);
+
 	odp_ticketlock_init(&sched->grp_lock);
 	odp_atomic_init_u32(&sched->grp_epoch, 0);
 	odp_atomic_init_u32(&sched->next_rand, 0);
 
-	for (i = 0; i < NUM_PRIO; i++)
-		odp_atomic_init_u32(&sched->prio_grp_mask[i], 0);
+	for (i = 0; i < MAX_PRIO; i++)
+		for (j = 0; j < GRP_MASK_WORDS; j++)
+			odp_atomic_init_u64(&sched->prio_grp_mask[i][j], 0);
 
-	for (i = 0; i < NUM_SCHED_GRPS; i++) {
+	for (i = 0; i < sched->config.num_grps; i++) {
 		memset(sched->sched_grp[i].name, 0, ODP_SCHED_GROUP_NAME_LEN);
 		odp_thrmask_zero(&sched->sched_grp[i].mask);
 	}
@@ -570,13 +838,13 @@ static int schedule_term_global(void)
 	int i, j, grp;
 	uint32_t ring_mask = sched->ring_mask;
 
-	for (grp = 0; grp < NUM_SCHED_GRPS; grp++) {
-		for (i = 0; i < NUM_PRIO; i++) {
-			for (j = 0; j < MAX_SPREAD; j++) {
+	for (grp = 0; grp < sched->config.num_grps; grp++) {
+		for (i = 0; i < sched->config.num_prio; i++) {
+			for (j = 0; j < sched->config.num_spread; j++) {
 				ring_u32_t *ring;
 				uint32_t qi;
 
-				ring = &sched->prio_q[grp][i][j].ring;
+				ring = prio_q_ring(grp, i, j);
 
 				while (ring_u32_deq(ring, ring_mask, &qi)) {
 					odp_event_t events[1];
@@ -591,6 +859,12 @@ static int schedule_term_global(void)
 		}
 	}
 
+	ret = odp_shm_free(sched->queue_shm);
+	if (ret < 0) {
+		ODP_ERR("Shm free failed for odp_scheduler queues");
+		rc = -1;
+	}
+
 	ret = odp_shm_free(sched->shm);
 	if (ret < 0) {
 		ODP_ERR("Shm free failed for odp_scheduler");
@@ -612,29 +886,44 @@ static inline void grp_update_mask(int grp, const odp_thrmask_t *new_mask)
 	odp_atomic_add_rel_u32(&sched->grp_epoch, 1);
 }
 
+/* Update the thread's list of groups and group bitmap words. Schedule calls
+ * iterate only these, so that the cost depends on the number of groups the
+ * thread has joined, not on the maximum number of groups. */
 static inline int grp_update_tbl(void)
 {
-	int i;
+	int i, w;
 	int num = 0;
+	int num_word = 0;
 	int thr = sched_local.thr;
-	uint32_t mask = 0;
+	uint64_t mask[GRP_MASK_WORDS];
+
+	memset(mask, 0, sizeof(mask));
 
 	odp_ticketlock_lock(&sched->grp_lock);
 
-	for (i = 0; i < NUM_SCHED_GRPS; i++) {
+	for (i = 0; i < sched->config.num_grps; i++) {
 		if (sched->sched_grp[i].allocated == 0)
 			continue;
 
 		if (odp_thrmask_isset(&sched->sched_grp[i].mask, thr)) {
 			sched_local.grp[num] = i;
 			num++;
-			mask |= 0x1u << i;
+			mask[i / 64] |= 0x1ull << (i % 64);
 		}
 	}
 
 	odp_ticketlock_unlock(&sched->grp_lock);
 
-	sched_local.grp_mask = mask;
+	for (w = 0; w < GRP_MASK_WORDS; w++) {
+		if (mask[w] == 0)
+			continue;
+
+		sched_local.grp_word[num_word] = w;
+		sched_local.grp_word_mask[num_word] = mask[w];
+		num_word++;
+	}
+
+	sched_local.num_grp_word = num_word;
 	sched_local.grp_idx = 0;
 	sched_local.num_grp = num;
 
@@ -643,28 +932,41 @@ static inline int grp_update_tbl(void)
 
 static inline void prio_grp_mask_set(int prio, int grp)
 {
-	uint32_t grp_mask = 0x1u << grp;
-	uint32_t mask = odp_atomic_load_u32(&sched->prio_grp_mask[prio]);
+	odp_atomic_u64_t *word = &sched->prio_grp_mask[prio][grp / 64];
+	uint64_t grp_mask = 0x1ull << (grp % 64);
+	uint64_t mask = odp_atomic_load_u64(word);
 
-	odp_atomic_store_u32(&sched->prio_grp_mask[prio], mask | grp_mask);
+	odp_atomic_store_u64(word, mask | grp_mask);
 
-	sched->prio_grp_count[prio][grp]++;
+	sched->prio_grp_count[prio * sched->config.num_grps + grp]++;
 }
 
 static inline void prio_grp_mask_clear(int prio, int grp)
 {
-	uint32_t grp_mask = 0x1u << grp;
-	uint32_t mask = odp_atomic_load_u32(&sched->prio_grp_mask[prio]);
+	odp_atomic_u64_t *word = &sched->prio_grp_mask[prio][grp / 64];
+	uint64_t grp_mask = 0x1ull << (grp % 64);
+	uint64_t mask = odp_atomic_load_u64(word);
+	uint32_t *count = &sched->prio_grp_count[prio * sched->config.num_grps + grp];
 
-	sched->prio_grp_count[prio][grp]--;
+	(*count)--;
 
-	if (sched->prio_grp_count[prio][grp] == 0)
-		odp_atomic_store_u32(&sched->prio_grp_mask[prio], mask &= (~grp_mask));
+	if (*count == 0)
+		odp_atomic_store_u64(word, mask & (~grp_mask));
 }
 
-static inline uint32_t prio_grp_mask_check(int prio, uint32_t grp_mask)
+/* Check if any of the thread's groups have queues on a priority level */
+static inline int prio_grp_mask_check(int prio)
 {
-	return odp_atomic_load_u32(&sched->prio_grp_mask[prio]) & grp_mask;
+	int i;
+	odp_atomic_u64_t *prio_mask = sched->prio_grp_mask[prio];
+
+	for (i = 0; i < sched_local.num_grp_word; i++) {
+		if (odp_atomic_load_u64(&prio_mask[sched_local.grp_word[i]]) &
+		    sched_local.grp_word_mask[i])
+			return 1;
+	}
+
+	return 0;
 }
 
 static uint32_t schedule_max_ordered_locks(void)
@@ -679,7 +981,7 @@ static int schedule_min_prio(void)
 
 static int schedule_max_prio(void)
 {
-	return NUM_PRIO - 1;
+	return sched->config.num_prio - 1;
 }
 
 static int schedule_default_prio(void)
@@ -689,7 +991,7 @@ static int schedule_default_prio(void)
 
 static int schedule_num_prio(void)
 {
-	return NUM_PRIO;
+	return sched->config.num_prio;
 }
 
 static inline int prio_level_from_api(int api_prio)
@@ -701,11 +1003,11 @@ static inline void dec_queue_count(int grp, int prio, int spr)
 {
 	odp_ticketlock_lock(&sched->mask_lock[grp]);
 
-	sched->prio_q_count[grp][prio][spr]--;
+	(*prio_q_count(grp, prio, spr))--;
 
 	/* Clear mask bit only when the last queue is removed */
-	if (sched->prio_q_count[grp][prio][spr] == 0)
-		sched->prio_q_mask[grp][prio] &= (uint8_t)(~(1 << spr));
+	if (*prio_q_count(grp, prio, spr) == 0)
+		*prio_q_mask(grp, prio) &= (uint8_t)(~(1 << spr));
 
 	odp_ticketlock_unlock(&sched->mask_lock[grp]);
 }
@@ -714,13 +1016,13 @@ static inline void update_queue_count(int grp, int prio, int old_spr, int new_sp
 {
 	odp_ticketlock_lock(&sched->mask_lock[grp]);
 
-	sched->prio_q_mask[grp][prio] |= 1 << new_spr;
-	sched->prio_q_count[grp][prio][new_spr]++;
+	*prio_q_mask(grp, prio) |= 1 << new_spr;
+	(*prio_q_count(grp, prio, new_spr))++;
 
-	sched->prio_q_count[grp][prio][old_spr]--;
+	(*prio_q_count(grp, prio, old_spr))--;
 
-	if (sched->prio_q_count[grp][prio][old_spr] == 0)
-		sched->prio_q_mask[grp][prio] &= (uint8_t)(~(1 << old_spr));
+	if (*prio_q_count(grp, prio, old_spr) == 0)
+		*prio_q_mask(grp, prio) &= (uint8_t)(~(1 << old_spr));
 
 	odp_ticketlock_unlock(&sched->mask_lock[grp]);
 }
@@ -740,7 +1042,7 @@ static uint8_t allocate_spread(int grp, int prio)
 
 	/* Find spread(s) with the minimum number of queues */
 	for (i = 0; i < num_spread; i++) {
-		num = sched->prio_q_count[grp][prio][i];
+		num = *prio_q_count(grp, prio, i);
 		if (num < min) {
 			min = num;
 			min_spr[0] = i;
@@ -761,14 +1063,41 @@ static uint8_t allocate_spread(int grp, int prio)
 		spr = min_spr[rand % num_min];
 	}
 
-	sched->prio_q_mask[grp][prio] |= 1 << spr;
-	sched->prio_q_count[grp][prio][spr]++;
+	*prio_q_mask(grp, prio) |= 1 << spr;
+	(*prio_q_count(grp, prio, spr))++;
 
 	odp_ticketlock_unlock(&sched->mask_lock[grp]);
 
 	return spr;
 }
 
+static reorder_window_t *rwin_alloc(void)
+{
+	reorder_window_t *rwin = NULL;
+	int i;
+
+	odp_ticketlock_lock(&sched->rwin_lock);
+
+	for (i = 0; i < NUM_RWIN; i++) {
+		if (sched->rwin[i].allocated == 0) {
+			rwin = &sched->rwin[i];
+			rwin->allocated = 1;
+			break;
+		}
+	}
+
+	odp_ticketlock_unlock(&sched->rwin_lock);
+
+	return rwin;
+}
+
+static void rwin_free(reorder_window_t *rwin)
+{
+	odp_ticketlock_lock(&sched->rwin_lock);
+	rwin->allocated = 0;
+	odp_ticketlock_unlock(&sched->rwin_lock);
+}
+
 static int schedule_create_queue(uint32_t queue_index,
 				 const odp_schedule_param_t *sched_param)
 {
@@ -782,7 +1111,12 @@ static int schedule_create_queue(uint32_t queue_index,
 		return -1;
 	}
 
-	if (grp < 0 || grp >= NUM_SCHED_GRPS) {
+	if (prio < 0 || prio >= sched->config.num_prio) {
+		ODP_ERR("Bad schedule priority %i\n", sched_param->prio);
+		return -1;
+	}
+
+	if (grp < 0 || grp >= sched->config.num_grps) {
 		ODP_ERR("Bad schedule group %i\n", grp);
 		return -1;
 	}
@@ -828,6 +1162,10 @@ static int schedule_create_queue(uint32_t queue_index,
 	for (i = 0; i < CONFIG_QUEUE_MAX_ORD_LOCKS; i++)
 		odp_atomic_init_u64(&sched->order[queue_index].lock[i], 0);
 
+	sched->order[queue_index].rwin = NULL;
+	if (sched_param->sync == ODP_SCHED_SYNC_ORDERED)
+		sched->order[queue_index].rwin = rwin_alloc();
+
 	return 0;
 }
 
@@ -856,6 +1194,11 @@ static void schedule_destroy_queue(uint32_t queue_index)
 	    odp_atomic_load_u64(&sched->order[queue_index].ctx) !=
 	    odp_atomic_load_u64(&sched->order[queue_index].next_ctx))
 		ODP_ERR("queue reorder incomplete\n");
+
+	if (sched->order[queue_index].rwin) {
+		rwin_free(sched->order[queue_index].rwin);
+		sched->order[queue_index].rwin = NULL;
+	}
 }
 
 static int schedule_sched_queue(uint32_t queue_index)
@@ -863,7 +1206,7 @@ static int schedule_sched_queue(uint32_t queue_index)
 	int grp      = sched->queue[queue_index].grp;
 	int prio     = sched->queue[queue_index].prio;
 	int spread   = sched->queue[queue_index].spread;
-	ring_u32_t *ring = &sched->prio_q[grp][prio][spread].ring;
+	ring_u32_t *ring = prio_q_ring(grp, prio, spread);
 
 	ring_u32_enq(ring, sched->ring_mask, queue_index);
 	return 0;
@@ -872,7 +1215,7 @@ static int schedule_sched_queue(uint32_t queue_index)
 static void schedule_pktio_start(int pktio_index, int num_pktin,
 				 int pktin_idx[], odp_queue_t queue[])
 {
-	int i;
+	int i, grp, prio, spr, new_spr;
 	uint32_t qi;
 
 	sched->pktio[pktio_index].num_pktin = num_pktin;
@@ -885,6 +1228,21 @@ static void schedule_pktio_start(int pktio_index, int num_pktin,
 
 		ODP_ASSERT(pktin_idx[i] <= MAX_PKTIN_INDEX);
 
+		/* Bind pktin queue to the spread preferred by threads with the
+		 * same index. Flows hashed (RSS) to a pktin queue are then
+		 * received by the same set of threads. */
+		if (sched->config.pktin_direct) {
+			grp  = sched->queue[qi].grp;
+			prio = sched->queue[qi].prio;
+			spr  = sched->queue[qi].spread;
+			new_spr = spread_from_index(pktin_idx[i]);
+
+			if (new_spr != spr) {
+				sched->queue[qi].spread = new_spr;
+				update_queue_count(grp, prio, spr, new_spr);
+			}
+		}
+
 		/* Start polling */
 		_odp_sched_queue_set_status(qi, QUEUE_STATUS_SCHED);
 		schedule_sched_queue(qi);
@@ -921,6 +1279,12 @@ static inline int ordered_own_turn(uint32_t queue_index)
 
 static inline void wait_for_order(uint32_t queue_index)
 {
+	if (ordered_own_turn(queue_index))
+		return;
+
+	if (CONFIG_SCHED_STATISTICS)
+		sched_local.stat->ordered_waits++;
+
 	/* Busy loop to synchronize ordered processing */
 	while (1) {
 		if (ordered_own_turn(queue_index))
@@ -929,6 +1293,22 @@ static inline void wait_for_order(uint32_t queue_index)
 	}
 }
 
+static inline void ordered_enq(odp_queue_t queue, _odp_event_hdr_t *event_hdr[], int num)
+{
+	int num_enq;
+
+	num_enq = odp_queue_enq_multi(queue, (odp_event_t *)event_hdr, num);
+
+	/* Drop packets that were not enqueued */
+	if (odp_unlikely(num_enq < num)) {
+		if (odp_unlikely(num_enq < 0))
+			num_enq = 0;
+
+		ODP_DBG("Dropped %i packets\n", num - num_enq);
+		_odp_event_free_multi(&event_hdr[num_enq], num - num_enq);
+	}
+}
+
 /**
  * Perform stashed enqueue operations
  *
@@ -938,45 +1318,114 @@ static inline void ordered_stash_release(void)
 {
 	int i;
 
-	for (i = 0; i < sched_local.ordered.stash_num; i++) {
-		odp_queue_t queue;
-		_odp_event_hdr_t **event_hdr;
-		int num, num_enq;
+	for (i = 0; i < sched_local.ordered.stash_num; i++)
+		ordered_enq(sched_local.ordered.stash[i].queue,
+			    sched_local.ordered.stash[i].event_hdr,
+			    sched_local.ordered.stash[i].num);
 
-		queue = sched_local.ordered.stash[i].queue;
-		event_hdr = sched_local.ordered.stash[i].event_hdr;
-		num = sched_local.ordered.stash[i].num;
+	sched_local.ordered.stash_num = 0;
+}
 
-		num_enq = odp_queue_enq_multi(queue,
-					      (odp_event_t *)event_hdr, num);
+/* Release ordered locks that were not called in an ordered context */
+static inline void ordered_locks_release(uint32_t qi, uint64_t ctx, lock_called_t lock_called)
+{
+	uint32_t i;
 
-		/* Drop packets that were not enqueued */
-		if (odp_unlikely(num_enq < num)) {
-			if (odp_unlikely(num_enq < 0))
-				num_enq = 0;
+	for (i = 0; i < sched->queue[qi].order_lock_count; i++) {
+		if (!lock_called.u8[i])
+			odp_atomic_store_rel_u64(&sched->order[qi].lock[i], ctx + 1);
+	}
+}
 
-			ODP_DBG("Dropped %i packets\n", num - num_enq);
-			_odp_event_free_multi(&event_hdr[num_enq], num - num_enq);
+/* Store stashed enqueue operations of the current context into the reorder
+ * window. Returns 0 when the context must be released in order instead: it is
+ * own turn already, the context is too far ahead or has too many events. */
+static inline int rwin_store(reorder_window_t *rwin, uint32_t qi)
+{
+	rwin_slot_t *slot;
+	uint64_t ctx = sched_local.ordered.ctx;
+	uint64_t cur;
+	int i, j, num = 0;
+
+	for (i = 0; i < sched_local.ordered.stash_num; i++)
+		num += sched_local.ordered.stash[i].num;
+
+	if (odp_unlikely(num > RWIN_MAX_EVENTS))
+		return 0;
+
+	odp_ticketlock_lock(&rwin->lock);
+
+	cur = odp_atomic_load_acq_u64(&sched->order[qi].ctx);
+
+	if (ctx == cur || (ctx - cur) >= RWIN_SIZE) {
+		odp_ticketlock_unlock(&rwin->lock);
+		return 0;
+	}
+
+	slot = &rwin->slot[ctx & (RWIN_SIZE - 1)];
+	num = 0;
+
+	for (i = 0; i < sched_local.ordered.stash_num; i++) {
+		ordered_stash_t *stash = &sched_local.ordered.stash[i];
+
+		for (j = 0; j < stash->num; j++) {
+			slot->queue[num] = stash->queue;
+			slot->event_hdr[num] = stash->event_hdr[j];
+			num++;
 		}
 	}
-	sched_local.ordered.stash_num = 0;
+
+	slot->num = num;
+	slot->lock_called = sched_local.ordered.lock_called;
+	slot->valid = 1;
+
+	odp_ticketlock_unlock(&rwin->lock);
+
+	return 1;
+}
+
+/* Perform enqueue operations of a reorder window slot in order */
+static inline void rwin_slot_release(rwin_slot_t *slot)
+{
+	int i = 0;
+
+	while (i < slot->num) {
+		odp_queue_t queue = slot->queue[i];
+		int first = i;
+
+		while (i < slot->num && slot->queue[i] == queue)
+			i++;
+
+		ordered_enq(queue, &slot->event_hdr[first], i - first);
+	}
+
+	slot->num = 0;
+	slot->valid = 0;
 }
 
 static inline void release_ordered(void)
 {
 	uint32_t qi;
-	uint32_t i;
+	uint64_t ctx;
+	reorder_window_t *rwin;
 
 	qi = sched_local.ordered.src_queue;
+	rwin = sched->order[qi].rwin;
+
+	/* Do not wait for own turn, if enqueues can be left into the reorder
+	 * window */
+	if (rwin && !ordered_own_turn(qi) && rwin_store(rwin, qi)) {
+		sched_local.ordered.stash_num = 0;
+		sched_local.ordered.lock_called.all = 0;
+		sched_local.ordered.in_order = 0;
+		sched_local.sync_ctx = NO_SYNC_CONTEXT;
+		return;
+	}
 
 	wait_for_order(qi);
 
 	/* Release all ordered locks */
-	for (i = 0; i < sched->queue[qi].order_lock_count; i++) {
-		if (!sched_local.ordered.lock_called.u8[i])
-			odp_atomic_store_rel_u64(&sched->order[qi].lock[i],
-						 sched_local.ordered.ctx + 1);
-	}
+	ordered_locks_release(qi, sched_local.ordered.ctx, sched_local.ordered.lock_called);
 
 	sched_local.ordered.lock_called.all = 0;
 	sched_local.ordered.in_order = 0;
@@ -986,8 +1435,29 @@ static inline void release_ordered(void)
 
 	ordered_stash_release();
 
+	if (rwin == NULL) {
+		/* Next thread can continue processing */
+		odp_atomic_add_rel_u64(&sched->order[qi].ctx, 1);
+		return;
+	}
+
+	/* Release following contexts that were completed out of order */
+	ctx = sched_local.ordered.ctx + 1;
+
+	odp_ticketlock_lock(&rwin->lock);
+
+	while (rwin->slot[ctx & (RWIN_SIZE - 1)].valid) {
+		rwin_slot_t *slot = &rwin->slot[ctx & (RWIN_SIZE - 1)];
+
+		ordered_locks_release(qi, ctx, slot->lock_called);
+		rwin_slot_release(slot);
+		ctx++;
+	}
+
 	/* Next thread can continue processing */
-	odp_atomic_add_rel_u64(&sched->order[qi].ctx, 1);
+	odp_atomic_store_rel_u64(&sched->order[qi].ctx, ctx);
+
+	odp_ticketlock_unlock(&rwin->lock);
 }
 
 static void schedule_release_ordered(void)
@@ -1064,7 +1534,7 @@ static inline uint32_t spread_load(int grp, int prio, int spr, int num)
 {
 	uint32_t num_q, num_thr;
 
-	num_q   = sched->prio_q_count[grp][prio][spr];
+	num_q   = *prio_q_count(grp, prio, spr);
 	num_thr = sched->sched_grp[grp].spread_thrs[spr];
 
 	if (num_thr == 0)
@@ -1099,6 +1569,35 @@ static inline int balance_spread(int grp, int prio, int cur_spr)
 	return new_spr;
 }
 
+static inline void prefetch_event_hdr(const odp_event_t ev[], int num)
+{
+	int i;
+
+	for (i = 0; i < num; i++)
+		odp_prefetch(_odp_event_hdr(ev[i]));
+}
+
+/* Prefetch the first cache line of packet data. Event headers should be in
+ * cache already. */
+static inline void prefetch_pkt_data(const odp_event_t ev[], int num)
+{
+	int i;
+
+	for (i = 0; i < num; i++) {
+		if (_odp_event_hdr(ev[i])->event_type == ODP_EVENT_PACKET)
+			odp_prefetch(odp_packet_data(odp_packet_from_event(ev[i])));
+	}
+}
+
+/* Prefetch headers of the next stashed events */
+static inline void prefetch_stash(uint32_t num)
+{
+	if (num > sched_local.stash.num_ev)
+		num = sched_local.stash.num_ev;
+
+	prefetch_event_hdr(&sched_local.stash.ev[sched_local.stash.ev_index], num);
+}
+
 static inline int copy_from_stash(odp_event_t out_ev[], uint32_t max)
 {
 	int i = 0;
@@ -1111,6 +1610,14 @@ static inline int copy_from_stash(odp_event_t out_ev[], uint32_t max)
 		i++;
 	}
 
+	/* Headers of these events were prefetched when previous events were
+	 * passed from the stash */
+	if (sched_local.prefetch_data)
+		prefetch_pkt_data(out_ev, i);
+
+	if (sched_local.prefetch_depth)
+		prefetch_stash(sched_local.prefetch_depth);
+
 	return i;
 }
 
@@ -1145,8 +1652,11 @@ static int schedule_ord_enq_multi(odp_queue_t dst_queue, void *event_hdr[],
 		return 0;
 	}
 
-	/* Pktout may drop packets, so the operation cannot be stashed. */
-	if (dst_qentry->pktout.pktio != ODP_PKTIO_INVALID ||
+	/* Pktout may drop packets, so the operation is stashed only when the
+	 * context can be released through a reorder window. Dropped packets
+	 * are freed at release. */
+	if ((dst_qentry->pktout.pktio != ODP_PKTIO_INVALID &&
+	     sched->order[src_queue].rwin == NULL) ||
 	    odp_unlikely(stash_num >=  MAX_ORDERED_STASH)) {
 		/* If the local stash is full, wait until it is our turn and
 		 * then release the stash and do enqueue directly. */
@@ -1196,6 +1706,9 @@ static inline int poll_pktin(uint32_t qi, int direct_recv,
 	pktio_index = sched->queue[qi].pktio_index;
 	pktin_index = sched->queue[qi].pktin_index;
 
+	if (CONFIG_SCHED_STATISTICS)
+		sched_local.stat->pktin_polls++;
+
 	num = _odp_sched_cb_pktin_poll(pktio_index, pktin_index, hdr_tbl, max_num);
 
 	if (num == 0)
@@ -1238,6 +1751,33 @@ static inline int poll_pktin(uint32_t qi, int direct_recv,
 	return ret;
 }
 
+/* Select the most loaded spread of a group and priority level. Load is the
+ * number of active queues in a spread ring. Returns 'cur_spr' when other
+ * spreads are empty. */
+static inline int steal_spread(int grp, int prio, int cur_spr)
+{
+	int spr;
+	uint32_t len;
+	uint32_t max_len = 0;
+	int max_spr = cur_spr;
+	int num_spread = sched->config.num_spread;
+	prio_q_mask_t mask = *prio_q_mask(grp, prio);
+
+	for (spr = 0; spr < num_spread; spr++) {
+		if (spr == cur_spr || (mask & (1 << spr)) == 0)
+			continue;
+
+		len = ring_u32_len(prio_q_ring(grp, prio, spr));
+
+		if (len > max_len) {
+			max_len = len;
+			max_spr = spr;
+		}
+	}
+
+	return max_spr;
+}
+
 static inline int schedule_grp_prio(odp_queue_t *out_queue, odp_event_t out_ev[], uint32_t max_num,
 				    int grp, int prio, int first_spr, int balance)
 {
@@ -1246,10 +1786,22 @@ static inline int schedule_grp_prio(odp_queue_t *out_queue, odp_event_t out_ev[]
 	int num_spread = sched->config.num_spread;
 	uint32_t ring_mask = sched->ring_mask;
 	uint16_t burst_def = sched->config.burst_default[prio];
+	int steal_spr = -1;
 
 	/* Select the first spread based on weights */
 	spr = first_spr;
 
+	/* When the first spread is empty, steal work from the most loaded
+	 * spread. Other spreads are checked in order after that. */
+	if (sched_local.work_steal &&
+	    ((*prio_q_mask(grp, prio) & (1 << spr)) == 0 ||
+	     ring_u32_len(prio_q_ring(grp, prio, spr)) == 0)) {
+		spr = steal_spread(grp, prio, spr);
+
+		if (spr != first_spr)
+			steal_spr = spr;
+	}
+
 	for (i = 0; i < num_spread;) {
 		int num;
 		uint8_t sync_ctx, ordered;
@@ -1264,13 +1816,13 @@ static inline int schedule_grp_prio(odp_queue_t *out_queue, odp_event_t out_ev[]
 			spr = 0;
 
 		/* No queues allocated to this spread */
-		if (odp_unlikely((sched->prio_q_mask[grp][prio] & (1 << spr)) == 0)) {
+		if (odp_unlikely((*prio_q_mask(grp, prio) & (1 << spr)) == 0)) {
 			i++;
 			spr++;
 			continue;
 		}
 
-		ring = &sched->prio_q[grp][prio][spr].ring;
+		ring = prio_q_ring(grp, prio, spr);
 
 		/* Get queue index from the spread queue */
 		if (ring_u32_deq(ring, ring_mask, &qi) == 0) {
@@ -1303,13 +1855,14 @@ static inline int schedule_grp_prio(odp_queue_t *out_queue, odp_event_t out_ev[]
 
 		/* Update queue spread before dequeue. Dequeue changes status of an empty
 		 * queue, which enables a following enqueue operation to insert the queue
-		 * back into scheduling (with new spread). */
-		if (odp_unlikely(balance)) {
+		 * back into scheduling (with new spread). Pktin queues bound to
+		 * a spread are not moved. */
+		if (odp_unlikely(balance) && !(pktin && sched->config.pktin_direct)) {
 			new_spr = balance_spread(grp, prio, spr);
 
 			if (new_spr != spr) {
 				sched->queue[qi].spread = new_spr;
-				ring = &sched->prio_q[grp][prio][new_spr].ring;
+				ring = prio_q_ring(grp, prio, new_spr);
 				update_queue_count(grp, prio, spr, new_spr);
 			}
 		}
@@ -1323,7 +1876,7 @@ static inline int schedule_grp_prio(odp_queue_t *out_queue, odp_event_t out_ev[]
 		}
 
 		if (num == 0) {
-			int direct_recv = !ordered;
+			int direct_recv = !ordered || sched->config.pktin_direct;
 			int num_pkt;
 
 			if (!pktin) {
@@ -1351,7 +1904,10 @@ static inline int schedule_grp_prio(odp_queue_t *out_queue, odp_event_t out_ev[]
 				continue;
 			}
 
-			/* Process packets from an atomic or parallel queue right away. */
+			/* Process packets right away. Packets of an ordered queue
+			 * share the ordered context allocated below. The queue is
+			 * out of the spread ring until then, so contexts are
+			 * allocated in receive order. */
 			num = num_pkt;
 		}
 
@@ -1389,12 +1945,20 @@ static inline int schedule_grp_prio(odp_queue_t *out_queue, odp_event_t out_ev[]
 		} else {
 			sched_local.stash.num_ev = 0;
 			ret = num;
+
+			if (sched_local.prefetch_depth)
+				prefetch_event_hdr(out_ev, _ODP_MIN(num, sched_local.prefetch_depth));
 		}
 
 		/* Output the source queue handle */
 		if (out_queue)
 			*out_queue = handle;
 
+		/* Count only events received from the stolen spread, not from
+		 * spreads checked in order after it */
+		if (CONFIG_SCHED_STATISTICS && spr == steal_spr)
+			sched_local.stat->steal++;
+
 		return ret;
 	}
 
@@ -1410,7 +1974,7 @@ static inline int do_schedule(odp_queue_t *out_q, odp_event_t out_ev[], uint32_t
 	uint32_t sched_round;
 	uint16_t spread_round;
 	uint32_t epoch;
-	uint32_t my_groups;
+	int num_prio;
 	int balance = 0;
 
 	if (sched_local.stash.num_ev) {
@@ -1419,6 +1983,9 @@ static inline int do_schedule(odp_queue_t *out_q, odp_event_t out_ev[], uint32_t
 		if (out_q)
 			*out_q = sched_local.stash.queue;
 
+		if (CONFIG_SCHED_STATISTICS)
+			sched_local.stat->stash_hits++;
+
 		return ret;
 	}
 
@@ -1471,14 +2038,14 @@ static inline int do_schedule(odp_queue_t *out_q, odp_event_t out_ev[], uint32_t
 	if (odp_unlikely(num_grp == 0))
 		return 0;
 
-	my_groups = sched_local.grp_mask;
+	num_prio = sched->config.num_prio;
 	first_id = sched_local.grp_idx;
 	sched_local.grp_idx = (first_id + 1) % num_grp;
 
-	for (prio = 0; prio < NUM_PRIO; prio++) {
+	for (prio = 0; prio < num_prio; prio++) {
 		grp_id = first_id;
 
-		if (prio_grp_mask_check(prio, my_groups) == 0) {
+		if (prio_grp_mask_check(prio) == 0) {
 			/* My groups do not have queues at this priority level, continue to
 			 * the next level.
 			 *
@@ -1496,7 +2063,7 @@ static inline int do_schedule(odp_queue_t *out_q, odp_event_t out_ev[], uint32_t
 			if (odp_unlikely(grp_id >= num_grp))
 				grp_id = 0;
 
-			if (sched->prio_q_mask[grp][prio] == 0) {
+			if (*prio_q_mask(grp, prio) == 0) {
 				/* Group does not have queues at this priority level */
 				continue;
 			}
@@ -1514,9 +2081,16 @@ static inline int do_schedule(odp_queue_t *out_q, odp_event_t out_ev[], uint32_t
 
 static inline int schedule_run(odp_queue_t *out_queue, odp_event_t out_ev[], uint32_t max_num)
 {
+	int ret;
+
 	timer_run(1);
 
-	return do_schedule(out_queue, out_ev, max_num);
+	ret = do_schedule(out_queue, out_ev, max_num);
+
+	if (CONFIG_SCHED_STATISTICS && ret <= 0)
+		sched_local.stat->empty_polls++;
+
+	return ret;
 }
 
 static inline int schedule_loop(odp_queue_t *out_queue, uint64_t wait,
@@ -1534,6 +2108,9 @@ static inline int schedule_loop(odp_queue_t *out_queue, uint64_t wait,
 		}
 		timer_run(1);
 
+		if (CONFIG_SCHED_STATISTICS)
+			sched_local.stat->empty_polls++;
+
 		if (wait == ODP_SCHED_WAIT)
 			continue;
 
@@ -1560,7 +2137,7 @@ static odp_event_t schedule(odp_queue_t *out_queue, uint64_t wait)
 
 	ev = ODP_EVENT_INVALID;
 
-	schedule_loop(out_queue, wait, &ev, 1);
+	stat_sched_call(schedule_loop(out_queue, wait, &ev, 1));
 
 	return ev;
 }
@@ -1568,13 +2145,21 @@ static odp_event_t schedule(odp_queue_t *out_queue, uint64_t wait)
 static int schedule_multi(odp_queue_t *out_queue, uint64_t wait,
 			  odp_event_t events[], int num)
 {
-	return schedule_loop(out_queue, wait, events, num);
+	int ret = schedule_loop(out_queue, wait, events, num);
+
+	stat_sched_call(ret);
+
+	return ret;
 }
 
 static int schedule_multi_no_wait(odp_queue_t *out_queue, odp_event_t events[],
 				  int num)
 {
-	return schedule_run(out_queue, events, num);
+	int ret = schedule_run(out_queue, events, num);
+
+	stat_sched_call(ret);
+
+	return ret;
 }
 
 static int schedule_multi_wait(odp_queue_t *out_queue, odp_event_t events[],
@@ -1586,6 +2171,8 @@ static int schedule_multi_wait(odp_queue_t *out_queue, odp_event_t events[],
 		ret = schedule_run(out_queue, events, num);
 	} while (ret == 0);
 
+	stat_sched_call(ret);
+
 	return ret;
 }
 
@@ -1743,7 +2330,7 @@ static odp_schedule_group_t schedule_group_create(const char *name,
 
 	odp_ticketlock_lock(&sched->grp_lock);
 
-	for (i = SCHED_GROUP_NAMED; i < NUM_SCHED_GRPS; i++) {
+	for (i = SCHED_GROUP_NAMED; i < sched->config.num_grps; i++) {
 		if (!sched->sched_grp[i].allocated) {
 			char *grp_name = sched->sched_grp[i].name;
 
@@ -1772,7 +2359,7 @@ static int schedule_group_destroy(odp_schedule_group_t group)
 	odp_thrmask_t zero;
 	int i;
 
-	if (group >= NUM_SCHED_GRPS || group < SCHED_GROUP_NAMED) {
+	if (group >= sched->config.num_grps || group < SCHED_GROUP_NAMED) {
 		ODP_ERR("Bad group %i\n", group);
 		return -1;
 	}
@@ -1806,7 +2393,7 @@ static odp_schedule_group_t schedule_group_lookup(const char *name)
 
 	odp_ticketlock_lock(&sched->grp_lock);
 
-	for (i = SCHED_GROUP_NAMED; i < NUM_SCHED_GRPS; i++) {
+	for (i = SCHED_GROUP_NAMED; i < sched->config.num_grps; i++) {
 		if (strcmp(name, sched->sched_grp[i].name) == 0) {
 			group = (odp_schedule_group_t)i;
 			break;
@@ -1822,7 +2409,7 @@ static int schedule_group_join(odp_schedule_group_t group, const odp_thrmask_t *
 	int i, count, thr;
 	odp_thrmask_t new_mask;
 
-	if (group >= NUM_SCHED_GRPS || group < SCHED_GROUP_NAMED) {
+	if (group >= sched->config.num_grps || group < SCHED_GROUP_NAMED) {
 		ODP_ERR("Bad group %i\n", group);
 		return -1;
 	}
@@ -1868,7 +2455,7 @@ static int schedule_group_leave(odp_schedule_group_t group, const odp_thrmask_t
 	int i, count, thr;
 	odp_thrmask_t new_mask;
 
-	if (group >= NUM_SCHED_GRPS || group < SCHED_GROUP_NAMED) {
+	if (group >= sched->config.num_grps || group < SCHED_GROUP_NAMED) {
 		ODP_ERR("Bad group %i\n", group);
 		return -1;
 	}
@@ -1918,7 +2505,7 @@ static int schedule_group_thrmask(odp_schedule_group_t group,
 
 	odp_ticketlock_lock(&sched->grp_lock);
 
-	if (group < NUM_SCHED_GRPS && sched->sched_grp[group].allocated) {
+	if (group < sched->config.num_grps && sched->sched_grp[group].allocated) {
 		*thrmask = sched->sched_grp[group].mask;
 		ret = 0;
 	} else {
@@ -1936,7 +2523,7 @@ static int schedule_group_info(odp_schedule_group_t group,
 
 	odp_ticketlock_lock(&sched->grp_lock);
 
-	if (group < NUM_SCHED_GRPS && sched->sched_grp[group].allocated) {
+	if (group < sched->config.num_grps && sched->sched_grp[group].allocated) {
 		info->name    = sched->sched_grp[group].name;
 		info->thrmask = sched->sched_grp[group].mask;
 		ret = 0;
@@ -2005,12 +2592,16 @@ static int schedule_thr_rem(odp_schedule_group_t group, int thr)
 
 static void schedule_prefetch(int num)
 {
-	(void)num;
+	if (num <= 0 || sched_local.stash.num_ev == 0)
+		return;
+
+	/* Packet data is prefetched when events are passed to the application */
+	prefetch_stash(num);
 }
 
 static int schedule_num_grps(void)
 {
-	return NUM_SCHED_GRPS - SCHED_GROUP_NAMED;
+	return sched->config.num_grps - SCHED_GROUP_NAMED;
 }
 
 static void schedule_get_config(schedule_config_t *config)
@@ -2029,6 +2620,7 @@ static int schedule_capability(odp_schedule_capability_t *capa)
 	capa->max_queue_size = _odp_queue_glb->config.max_queue_size;
 	capa->max_flow_id = BUF_HDR_MAX_FLOW_ID;
 	capa->order_wait = ODP_SUPPORT_YES;
+	capa->lockfree_queues = _odp_queue_glb->queue_lf_num ? ODP_SUPPORT_YES : ODP_SUPPORT_NO;
 
 	return 0;
 }
@@ -2040,6 +2632,8 @@ static void schedule_print(void)
 	ring_u32_t *ring;
 	odp_schedule_capability_t capa;
 	int num_spread = sched->config.num_spread;
+	int num_prio = sched->config.num_prio;
+	int num_grps = sched->config.num_grps;
 	const int col_width = 24;
 
 	(void)schedule_capability(&capa);
@@ -2062,29 +2656,29 @@ static void schedule_print(void)
 
 	ODP_PRINT("\n");
 
-	for (prio = 0; prio < NUM_PRIO; prio++) {
+	for (prio = 0; prio < num_prio; prio++) {
 		ODP_PRINT("  prio %i", prio);
 
-		for (grp = 0; grp < NUM_SCHED_GRPS; grp++)
-			if (sched->prio_q_mask[grp][prio])
+		for (grp = 0; grp < num_grps; grp++)
+			if (*prio_q_mask(grp, prio))
 				break;
 
-		if (grp == NUM_SCHED_GRPS) {
+		if (grp == num_grps) {
 			ODP_PRINT(":-\n");
 			continue;
 		}
 
 		ODP_PRINT("\n");
 
-		for (grp = 0; grp < NUM_SCHED_GRPS; grp++) {
+		for (grp = 0; grp < num_grps; grp++) {
 			if (sched->sched_grp[grp].allocated == 0)
 				continue;
 
 			ODP_PRINT("    group %i:", grp);
 
 			for (spr = 0; spr < num_spread; spr++) {
-				num_queues = sched->prio_q_count[grp][prio][spr];
-				ring = &sched->prio_q[grp][prio][spr].ring;
+				num_queues = *prio_q_count(grp, prio, spr);
+				ring = prio_q_ring(grp, prio, spr);
 				num_active = ring_u32_len(ring);
 				ODP_PRINT(" %3u/%3u", num_active, num_queues);
 			}
@@ -2095,7 +2689,7 @@ static void schedule_print(void)
 	ODP_PRINT("\n  Number of threads per schedule group:\n");
 	ODP_PRINT("             name                     spread\n");
 
-	for (grp = 0; grp < NUM_SCHED_GRPS; grp++) {
+	for (grp = 0; grp < num_grps; grp++) {
 		if (sched->sched_grp[grp].allocated == 0)
 			continue;
 
@@ -2110,6 +2704,73 @@ static void schedule_print(void)
 	ODP_PRINT("\n");
 }
 
+static void schedule_stats_print(void)
+{
+	int thr, i;
+	sched_thr_stat_t *stat;
+	uint64_t enq_fail;
+	sched_thr_stat_t sum;
+	uint64_t sum_enq_fail = 0;
+	uint64_t hist_sum = 0;
+	const char *hist_name[STAT_HIST_SIZE] = {"1", "2-3", "4-7", "8-15", "16-31", "32-"};
+
+	memset(&sum, 0, sizeof(sched_thr_stat_t));
+
+	ODP_PRINT("\nScheduler statistics\n");
+	ODP_PRINT("--------------------\n");
+
+	if (!CONFIG_SCHED_STATISTICS) {
+		ODP_PRINT("  Statistics collection disabled\n\n");
+		return;
+	}
+
+	ODP_PRINT("  work steal: %s\n", sched->config.work_steal ? "ON" : "OFF");
+	ODP_PRINT("  pktin direct: %s\n\n", sched->config.pktin_direct ? "ON" : "OFF");
+	ODP_PRINT("  thread      calls  empty polls       events  stash hits  pktin polls"
+		  "  ord waits     steals  enq fails\n");
+
+	for (thr = 0; thr < ODP_THREAD_COUNT_MAX; thr++) {
+		stat = &sched->thr_stat[thr];
+		enq_fail = _odp_queue_glb->thr_stat[thr].enq_fail;
+
+		if (stat->calls == 0 && enq_fail == 0)
+			continue;
+
+		ODP_PRINT("  %6i %10" PRIu64 " %12" PRIu64 " %12" PRIu64 " %11" PRIu64 " %12"
+			  PRIu64 " %10" PRIu64 " %10" PRIu64 " %10" PRIu64 "\n", thr, stat->calls,
+			  stat->empty_polls, stat->events, stat->stash_hits, stat->pktin_polls,
+			  stat->ordered_waits, stat->steal, enq_fail);
+
+		sum.calls         += stat->calls;
+		sum.empty_polls   += stat->empty_polls;
+		sum.events        += stat->events;
+		sum.stash_hits    += stat->stash_hits;
+		sum.pktin_polls   += stat->pktin_polls;
+		sum.ordered_waits += stat->ordered_waits;
+		sum.steal         += stat->steal;
+		sum_enq_fail      += enq_fail;
+
+		for (i = 0; i < STAT_HIST_SIZE; i++)
+			sum.hist[i] += stat->hist[i];
+	}
+
+	ODP_PRINT("   total %10" PRIu64 " %12" PRIu64 " %12" PRIu64 " %11" PRIu64 " %12"
+		  PRIu64 " %10" PRIu64 " %10" PRIu64 " %10" PRIu64 "\n\n", sum.calls,
+		  sum.empty_polls, sum.events, sum.stash_hits, sum.pktin_polls,
+		  sum.ordered_waits, sum.steal, sum_enq_fail);
+
+	for (i = 0; i < STAT_HIST_SIZE; i++)
+		hist_sum += sum.hist[i];
+
+	ODP_PRINT("  Schedule calls per number of events (all threads):\n");
+	ODP_PRINT("    %6s: %" PRIu64 "\n", "0", sum.calls - hist_sum);
+
+	for (i = 0; i < STAT_HIST_SIZE; i++)
+		ODP_PRINT("    %6s: %" PRIu64 "\n", hist_name[i], sum.hist[i]);
+
+	ODP_PRINT("\n");
+}
+
 /* Returns spread for queue debug prints */
 int _odp_sched_basic_get_spread(uint32_t queue_index)
 {
@@ -2168,5 +2829,6 @@ const schedule_api_t _odp_schedule_basic_api = {
 	.schedule_order_lock_start  = schedule_order_lock_start,
 	.schedule_order_lock_wait   = schedule_order_lock_wait,
 	.schedule_order_wait      = order_lock,
-	.schedule_print           = schedule_print
+	.schedule_print           = schedule_print,
+	.schedule_stats_print     = schedule_stats_print
 };
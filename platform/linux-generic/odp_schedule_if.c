@@ -213,6 +213,11 @@ void odp_schedule_print(void)
 	_odp_sched_api->schedule_print();
 }
 
+void odp_schedule_stats_print(void)
+{
+	_odp_sched_api->schedule_stats_print();
+}
+
 int _odp_schedule_init_global(void)
 {
 	const char *sched = getenv("ODP_SCHEDULER");
@@ -2186,6 +2186,13 @@ static void schedule_print(void)
 	ODP_PRINT("\n");
 }
 
+static void schedule_stats_print(void)
+{
+	ODP_PRINT("\nScheduler statistics\n");
+	ODP_PRINT("--------------------\n");
+	ODP_PRINT("  Not supported by scalable scheduler\n\n");
+}
+
 const schedule_fn_t _odp_schedule_scalable_fn = {
 	.pktio_start	= pktio_start,
 	.thr_add	= thr_add,
@@ -2235,5 +2242,6 @@ const schedule_api_t _odp_schedule_scalable_api = {
 	.schedule_order_lock_start	= schedule_order_lock_start,
 	.schedule_order_lock_wait	= schedule_order_lock_wait,
 	.schedule_order_wait		= order_lock,
-	.schedule_print			= schedule_print
+	.schedule_print			= schedule_print,
+	.schedule_stats_print		= schedule_stats_print
 };
@@ -24,6 +24,7 @@
 
 #include <odp_schedule_if.h>
 #include <odp_debug_internal.h>
+#include <odp_libconfig_internal.h>
 #include <odp_config_internal.h>
 #include <odp_event_internal.h>
 #include <odp_macros_internal.h>
@@ -32,6 +33,7 @@
 #include <odp_queue_basic_internal.h>
 #include <odp_global_data.h>
 
+#include <inttypes.h>
 #include <string.h>
 
 #define NUM_THREAD        ODP_THREAD_COUNT_MAX
@@ -39,7 +41,9 @@
 #define NUM_PKTIO         ODP_CONFIG_PKTIO_ENTRIES
 #define NUM_ORDERED_LOCKS 1
 #define NUM_STATIC_GROUP  3
-#define NUM_GROUP         (NUM_STATIC_GROUP + 9)
+/* Maximum number of groups, including the static groups. Actual number
+ * is configurable. */
+#define MAX_GROUP         256
 #define NUM_PKTIN         32
 #define NUM_PRIO          3
 #define MAX_API_PRIO      (NUM_PRIO - 2)
@@ -95,7 +99,7 @@ typedef struct thr_group_t {
 	int num_group;
 
 	/* The groups the thread belongs to */
-	int group[NUM_GROUP];
+	int group[MAX_GROUP];
 
 } thr_group_t;
 
@@ -108,7 +112,7 @@ typedef struct ODP_ALIGNED_CACHE sched_group_t {
 			char          name[ODP_SCHED_GROUP_NAME_LEN + 1];
 			odp_thrmask_t mask;
 			int           allocated;
-		} group[NUM_GROUP];
+		} group[MAX_GROUP];
 
 		/* Per thread group information */
 		thr_group_t thr[NUM_THREAD];
@@ -120,15 +124,19 @@ typedef struct ODP_ALIGNED_CACHE sched_group_t {
 typedef struct {
 	sched_cmd_t   queue_cmd[NUM_QUEUE];
 	sched_cmd_t   pktio_cmd[NUM_PKTIO];
-
-#pragma GCC diagnostic push
-#pragma GCC diagnostic ignored "-Wpedantic"
-	prio_queue_t  prio_queue[NUM_GROUP][NUM_PRIO];
-#pragma GCC diagnostic pop
 	sched_group_t sched_group;
 	odp_shm_t     shm;
+	/* Number of groups, including the static groups */
+	int           num_groups;
 	/* Scheduler interface config options (not used in fast path) */
 	schedule_config_t config_if;
+
+	/* Priority queues of num_groups groups, indexed by
+	 * group * NUM_PRIO + prio */
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpedantic"
+	prio_queue_t  prio_queue[];
+#pragma GCC diagnostic pop
 } sched_global_t;
 
 typedef struct {
@@ -137,7 +145,7 @@ typedef struct {
 	int          thr_id;
 	uint32_t     gen_cnt;
 	int          num_group;
-	int          group[NUM_GROUP];
+	int          group[MAX_GROUP];
 } sched_local_t;
 
 static sched_global_t *sched_global;
@@ -165,16 +173,49 @@ static inline uint32_t index_from_ring_idx(uint32_t *index, uint32_t ring_idx)
 	return pktio;
 }
 
+static int read_config_file(int *num_groups)
+{
+	const char *str;
+	int val = 0;
+
+	str = "sched_basic.num_groups";
+	if (!_odp_libconfig_lookup_int(str, &val)) {
+		ODP_ERR("Config option '%s' not found.\n", str);
+		return -1;
+	}
+
+	if (val < NUM_STATIC_GROUP) {
+		ODP_ERR("Bad value %s = %i [min: %i]\n", str, val,
+			NUM_STATIC_GROUP);
+		return -1;
+	}
+
+	/* Larger values are valid for the basic scheduler */
+	if (val > MAX_GROUP)
+		val = MAX_GROUP;
+
+	*num_groups = val;
+	return 0;
+}
+
 static int init_global(void)
 {
-	int i, j;
+	int i, j, num_groups;
 	odp_shm_t shm;
+	uint64_t size;
 	sched_group_t *sched_group = NULL;
 
 	ODP_DBG("Using SP scheduler\n");
 
-	shm = odp_shm_reserve("_odp_sched_sp_global",
-			      sizeof(sched_global_t),
+	if (read_config_file(&num_groups))
+		return -1;
+
+	ODP_DBG("  num groups: %i\n", num_groups);
+
+	size = sizeof(sched_global_t) +
+	       (uint64_t)num_groups * NUM_PRIO * sizeof(prio_queue_t);
+
+	shm = odp_shm_reserve("_odp_sched_sp_global", size,
 			      ODP_CACHE_LINE_SIZE, 0);
 
 	sched_global = odp_shm_addr(shm);
@@ -184,8 +225,9 @@ static int init_global(void)
 		return -1;
 	}
 
-	memset(sched_global, 0, sizeof(sched_global_t));
+	memset(sched_global, 0, size);
 	sched_global->shm = shm;
+	sched_global->num_groups = num_groups;
 
 	for (i = 0; i < NUM_QUEUE; i++) {
 		sched_global->queue_cmd[i].type     = CMD_QUEUE;
@@ -201,9 +243,9 @@ static int init_global(void)
 		sched_global->pktio_cmd[i].group    = GROUP_PKTIN;
 	}
 
-	for (i = 0; i < NUM_GROUP; i++)
+	for (i = 0; i < num_groups; i++)
 		for (j = 0; j < NUM_PRIO; j++)
-			ring_u32_init(&sched_global->prio_queue[i][j].ring);
+			ring_u32_init(&sched_global->prio_queue[i * NUM_PRIO + j].ring);
 
 	sched_group = &sched_global->sched_group;
 	odp_ticketlock_init(&sched_group->s.lock);
@@ -355,7 +397,7 @@ static void remove_group(sched_group_t *sched_group, int thr, int group)
 	num = thr_group->num_group;
 
 	/* Extra array bounds check to suppress warning on GCC 7.4 with -O3 */
-	if (num >= NUM_GROUP) {
+	if (num >= MAX_GROUP) {
 		ODP_ERR("Too many groups");
 		return;
 	}
@@ -430,7 +472,7 @@ static int thr_rem(odp_schedule_group_t group, int thr)
 
 static int num_grps(void)
 {
-	return NUM_GROUP - NUM_STATIC_GROUP;
+	return sched_global->num_groups - NUM_STATIC_GROUP;
 }
 
 static int create_queue(uint32_t qi, const odp_schedule_param_t *sched_param)
@@ -444,7 +486,13 @@ static int create_queue(uint32_t qi, const odp_schedule_param_t *sched_param)
 		return -1;
 	}
 
-	if (group < 0 || group >= NUM_GROUP)
+	/* Queue implementation may be configured with more scheduled queues */
+	if (qi >= NUM_QUEUE) {
+		ODP_ERR("Bad queue index %u\n", qi);
+		return -1;
+	}
+
+	if (group < 0 || group >= sched_global->num_groups)
 		return -1;
 
 	if (!sched_group->s.group[group].allocated)
@@ -474,7 +522,7 @@ static inline void add_tail(sched_cmd_t *cmd)
 	int prio     = cmd->prio;
 	uint32_t idx = cmd->ring_idx;
 
-	prio_queue = &sched_global->prio_queue[group][prio];
+	prio_queue = &sched_global->prio_queue[group * NUM_PRIO + prio];
 	ring_u32_enq(&prio_queue->ring, RING_MASK, idx);
 }
 
@@ -484,7 +532,7 @@ static inline sched_cmd_t *rem_head(int group, int prio)
 	uint32_t ring_idx, index;
 	int pktio;
 
-	prio_queue = &sched_global->prio_queue[group][prio];
+	prio_queue = &sched_global->prio_queue[group * NUM_PRIO + prio];
 
 	if (ring_u32_deq(&prio_queue->ring, RING_MASK, &ring_idx) == 0)
 		return NULL;
@@ -796,7 +844,7 @@ static odp_schedule_group_t schedule_group_create(const char *name,
 
 	odp_ticketlock_lock(&sched_group->s.lock);
 
-	for (i = NUM_STATIC_GROUP; i < NUM_GROUP; i++) {
+	for (i = NUM_STATIC_GROUP; i < sched_global->num_groups; i++) {
 		if (!sched_group->s.group[i].allocated) {
 			char *grp_name = sched_group->s.group[i].name;
 
@@ -832,7 +880,7 @@ static int schedule_group_destroy(odp_schedule_group_t group)
 	int thr;
 	const odp_thrmask_t *thrmask;
 
-	if (group < NUM_STATIC_GROUP || group >= NUM_GROUP)
+	if (group < NUM_STATIC_GROUP || group >= sched_global->num_groups)
 		return -1;
 
 	odp_ticketlock_lock(&sched_group->s.lock);
@@ -866,7 +914,7 @@ static odp_schedule_group_t schedule_group_lookup(const char *name)
 
 	odp_ticketlock_lock(&sched_group->s.lock);
 
-	for (i = NUM_STATIC_GROUP; i < NUM_GROUP; i++) {
+	for (i = NUM_STATIC_GROUP; i < sched_global->num_groups; i++) {
 		if (sched_group->s.group[i].allocated &&
 		    strcmp(sched_group->s.group[i].name, name) == 0) {
 			group = i;
@@ -884,7 +932,7 @@ static int schedule_group_join(odp_schedule_group_t group,
 	int thr;
 	sched_group_t *sched_group = &sched_global->sched_group;
 
-	if (group < 0 || group >= NUM_GROUP)
+	if (group < 0 || group >= sched_global->num_groups)
 		return -1;
 
 	thr = odp_thrmask_first(thrmask);
@@ -918,7 +966,7 @@ static int schedule_group_leave(odp_schedule_group_t group,
 	odp_thrmask_t *all = &sched_group->s.group[GROUP_ALL].mask;
 	odp_thrmask_t not;
 
-	if (group < 0 || group >= NUM_GROUP)
+	if (group < 0 || group >= sched_global->num_groups)
 		return -1;
 
 	thr = odp_thrmask_first(thrmask);
@@ -950,7 +998,7 @@ static int schedule_group_thrmask(odp_schedule_group_t group,
 {
 	sched_group_t *sched_group = &sched_global->sched_group;
 
-	if (group < 0 || group >= NUM_GROUP)
+	if (group < 0 || group >= sched_global->num_groups)
 		return -1;
 
 	odp_ticketlock_lock(&sched_group->s.lock);
@@ -972,7 +1020,7 @@ static int schedule_group_info(odp_schedule_group_t group,
 {
 	sched_group_t *sched_group = &sched_global->sched_group;
 
-	if (group < 0 || group >= NUM_GROUP)
+	if (group < 0 || group >= sched_global->num_groups)
 		return -1;
 
 	odp_ticketlock_lock(&sched_group->s.lock);
@@ -1036,6 +1084,7 @@ static int schedule_capability(odp_schedule_capability_t *capa)
 	capa->max_prios = schedule_num_prio();
 	capa->max_queues = CONFIG_MAX_SCHED_QUEUES;
 	capa->max_queue_size = _odp_queue_glb->config.max_queue_size;
+	capa->lockfree_queues = _odp_queue_glb->queue_lf_num ? ODP_SUPPORT_YES : ODP_SUPPORT_NO;
 
 	return 0;
 }
@@ -1054,6 +1103,31 @@ static void schedule_print(void)
 	ODP_PRINT("\n");
 }
 
+static void schedule_stats_print(void)
+{
+	int thr;
+	uint64_t enq_fail;
+
+	ODP_PRINT("\nScheduler statistics\n");
+	ODP_PRINT("--------------------\n");
+
+	if (!CONFIG_SCHED_STATISTICS) {
+		ODP_PRINT("  Statistics collection disabled\n\n");
+		return;
+	}
+
+	ODP_PRINT("  thread  enq fails\n");
+
+	for (thr = 0; thr < ODP_THREAD_COUNT_MAX; thr++) {
+		enq_fail = _odp_queue_glb->thr_stat[thr].enq_fail;
+
+		if (enq_fail)
+			ODP_PRINT("  %6i %10" PRIu64 "\n", thr, enq_fail);
+	}
+
+	ODP_PRINT("\n");
+}
+
 static void get_config(schedule_config_t *config)
 {
 	*config = sched_global->config_if;
@@ -1111,5 +1185,6 @@ const schedule_api_t _odp_schedule_sp_api = {
 	.schedule_order_lock_start  = schedule_order_lock_start,
 	.schedule_order_lock_wait   = schedule_order_lock_wait,
 	.schedule_order_wait      = order_lock,
-	.schedule_print           = schedule_print
+	.schedule_print           = schedule_print,
+	.schedule_stats_print     = schedule_stats_print
 };
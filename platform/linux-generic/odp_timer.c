@@ -53,6 +53,8 @@
 
 #include <errno.h>
 #include <inttypes.h>
+#include <limits.h>
+#include <linux/futex.h>
 #include <pthread.h>
 #include <signal.h>
 #include <stdlib.h>
@@ -87,6 +89,20 @@
 /* Max inline timer resolution */
 #define MAX_INLINE_RES_NS 500
 
+/* Max number of timer service threads */
+#define MAX_SERVICE_THREADS 8
+
+/* Max sleep time of a timer service thread. Service threads are woken up when
+ * a timer pool is created, so this only bounds a single futex wait. */
+#define SERVICE_MAX_SLEEP_NS (10 * ODP_TIME_MSEC_IN_NS)
+
+/* Number of free timers cached per thread per timer pool */
+#define TIMER_CACHE_SIZE  16
+#define TIMER_CACHE_BURST (TIMER_CACHE_SIZE / 2)
+
+/* Number of expired timeouts enqueued in a batch */
+#define TMO_BATCH_SIZE 32
+
 /* Timer pool may be reused after this period */
 #define TIMER_POOL_REUSE_NS ODP_TIME_SEC_IN_NS
 
@@ -157,11 +173,15 @@ typedef struct timer_pool_s {
 	uint64_t max_rel_tck;
 	tick_buf_t *tick_buf; /* Expiration tick and timeout buffer */
 	_odp_timer_t *timers; /* User pointer and queue handle (and lock) */
-	odp_atomic_u32_t high_wm;/* High watermark of allocated timers */
+	odp_atomic_u32_t high_wm;/* High watermark of timers removed from free list */
+	odp_atomic_u32_t num_used;/* Current number of allocated timers */
+	odp_atomic_u32_t hwm_used;/* High watermark of allocated timers */
 	odp_spinlock_t lock;
-	uint32_t num_alloc;/* Current number of allocated timers */
+	uint32_t num_alloc;/* Number of timers removed from free list */
 	uint32_t first_free;/* 0..max_timers-1 => free timer */
+	uint32_t max_timers;/* Number of timers including thread cache space */
 	uint32_t tp_idx;/* Index into timer_pool array */
+	uint64_t gen;/* Generation number for validating thread caches */
 	odp_timer_pool_param_t param;
 	char name[ODP_TIMER_POOL_NAME_LEN];
 	timer_t timerid;
@@ -189,6 +209,18 @@ typedef struct timer_pool_s {
 #define TIMER_RES_TEST_LOOP_COUNT 10
 #define TIMER_RES_ROUNDUP_FACTOR 10
 
+/* Timer processing modes (timer.inline config option) */
+#define TIMER_MODE_POSIX   0
+#define TIMER_MODE_INLINE  1
+#define TIMER_MODE_SERVICE 2
+
+typedef struct timer_service_t {
+	pthread_t thr_pthread;
+	int idx;
+	int cpu;
+
+} timer_service_t;
+
 typedef struct timer_global_t {
 	odp_ticketlock_t lock;
 	odp_shm_t shm;
@@ -210,13 +242,41 @@ typedef struct timer_global_t {
 	int highest_tp_idx;
 	uint8_t thread_type;
 
+	/* Timer pool generation counter */
+	uint64_t tp_gen;
+
+	/* Timer service threads */
+	int num_service;
+	odp_atomic_u32_t service_exit;
+	/* Futex word, incremented to wake up service threads */
+	odp_atomic_u32_t service_wake;
+	timer_service_t service[MAX_SERVICE_THREADS];
+
 } timer_global_t;
 
+/* Expired timeouts waiting for enqueue */
+typedef struct tmo_batch_t {
+	int num;
+	odp_queue_t queue[TMO_BATCH_SIZE];
+	odp_event_t event[TMO_BATCH_SIZE];
+
+} tmo_batch_t;
+
+/* Free timers of a timer pool cached by a thread */
+typedef struct timer_cache_t {
+	uint64_t gen;
+	uint32_t num;
+	uint32_t idx[TIMER_CACHE_SIZE];
+
+} timer_cache_t;
+
 typedef struct timer_local_t {
 	odp_time_t last_run;
 	int        run_cnt;
 	uint8_t    poll_shared;
 
+	timer_cache_t cache[MAX_TIMER_POOLS];
+
 } timer_local_t;
 
 /* Points to timer global data */
@@ -228,6 +288,7 @@ static __thread timer_local_t timer_local;
 /* Forward declarations */
 static void itimer_init(timer_pool_t *tp);
 static void itimer_fini(timer_pool_t *tp);
+static void service_wake_up(void);
 
 static void timer_init(_odp_timer_t *tim, tick_buf_t *tb, odp_queue_t _q, const void *_up)
 {
@@ -342,6 +403,7 @@ static odp_timer_pool_t timer_pool_new(const char *name,
 	timer_pool_t *tp;
 	odp_time_t diff, time;
 	odp_time_t max_diff = ODP_TIME_NULL;
+	uint32_t max_timers;
 	double base_freq = 0.0;
 	uint64_t max_multiplier = 0;
 	uint32_t flags = 0;
@@ -429,9 +491,13 @@ static odp_timer_pool_t timer_pool_new(const char *name,
 		}
 	}
 
+	/* Reserve space for free timers in thread caches, so that the
+	 * requested number of timers can always be allocated */
+	max_timers = param->num_timers + odp_thread_count_max() * TIMER_CACHE_SIZE;
+
 	sz0 = _ODP_ROUNDUP_CACHE_LINE(sizeof(timer_pool_t));
-	sz1 = _ODP_ROUNDUP_CACHE_LINE(sizeof(tick_buf_t) * param->num_timers);
-	sz2 = _ODP_ROUNDUP_CACHE_LINE(sizeof(_odp_timer_t) * param->num_timers);
+	sz1 = _ODP_ROUNDUP_CACHE_LINE(sizeof(tick_buf_t) * max_timers);
+	sz2 = _ODP_ROUNDUP_CACHE_LINE(sizeof(_odp_timer_t) * max_timers);
 	tp_size = sz0 + sz1 + sz2;
 
 	shm = odp_shm_reserve(name, tp_size, ODP_CACHE_LINE_SIZE, flags);
@@ -474,7 +540,10 @@ static odp_timer_pool_t timer_pool_new(const char *name,
 	}
 	tp->num_alloc = 0;
 	odp_atomic_init_u32(&tp->high_wm, 0);
+	odp_atomic_init_u32(&tp->num_used, 0);
+	odp_atomic_init_u32(&tp->hwm_used, 0);
 	tp->first_free = 0;
+	tp->max_timers = max_timers;
 	tp->notify_overrun = 1;
 	tp->owner = -1;
 
@@ -490,7 +559,7 @@ static odp_timer_pool_t timer_pool_new(const char *name,
 #endif
 
 	/* Initialize all odp_timer entries */
-	for (i = 0; i < tp->param.num_timers; i++) {
+	for (i = 0; i < max_timers; i++) {
 		tp->timers[i].queue = ODP_QUEUE_INVALID;
 		set_next_free(&tp->timers[i], i + 1);
 		tp->timers[i].user_ptr = NULL;
@@ -503,6 +572,8 @@ static odp_timer_pool_t timer_pool_new(const char *name,
 
 	odp_ticketlock_lock(&timer_global->lock);
 
+	tp->gen = ++timer_global->tp_gen;
+
 	/* Inline timer scan may find the timer pool after this */
 	odp_mb_release();
 	timer_global->timer_pool[tp_idx] = tp;
@@ -524,7 +595,9 @@ static odp_timer_pool_t timer_pool_new(const char *name,
 
 	odp_ticketlock_unlock(&timer_global->lock);
 
-	if (!odp_global_rw->inline_timers)
+	if (timer_global->num_service)
+		service_wake_up();
+	else if (!odp_global_rw->inline_timers)
 		itimer_init(tp);
 
 	return timer_pool_to_hdl(tp);
@@ -566,13 +639,13 @@ static void odp_timer_pool_del(timer_pool_t *tp)
 
 	odp_spinlock_lock(&tp->lock);
 
-	if (!odp_global_rw->inline_timers) {
+	if (!odp_global_rw->inline_timers && !timer_global->num_service) {
 		/* Stop POSIX itimer signals */
 		itimer_fini(tp);
 		stop_timer_thread(tp);
 	}
 
-	if (tp->num_alloc != 0) {
+	if (odp_atomic_load_u32(&tp->num_used) != 0) {
 		/* It's a programming error to attempt to destroy a */
 		/* timer pool which is still in use */
 		odp_spinlock_unlock(&tp->lock);
@@ -605,36 +678,87 @@ static void odp_timer_pool_del(timer_pool_t *tp)
 	odp_ticketlock_unlock(&timer_global->lock);
 }
 
-static inline odp_timer_t timer_alloc(timer_pool_t *tp, odp_queue_t queue, const void *user_ptr)
+/* Thread local cache of a timer pool. Entries of a destroyed timer pool are
+ * dropped. */
+static inline timer_cache_t *timer_cache(timer_pool_t *tp)
+{
+	timer_cache_t *cache = &timer_local.cache[tp->tp_idx];
+
+	if (odp_unlikely(cache->gen != tp->gen)) {
+		cache->gen = tp->gen;
+		cache->num = 0;
+	}
+
+	return cache;
+}
+
+/* Move up to 'num' timers from pool free list into cache */
+static uint32_t timer_cache_fill(timer_pool_t *tp, timer_cache_t *cache, uint32_t num)
 {
-	odp_timer_t hdl;
+	uint32_t i;
 
 	odp_spinlock_lock(&tp->lock);
-	if (odp_likely(tp->num_alloc < tp->param.num_timers)) {
+
+	for (i = 0; i < num && tp->num_alloc < tp->max_timers; i++) {
+		ODP_ASSERT(tp->first_free != tp->max_timers);
+		cache->idx[cache->num++] = tp->first_free;
+		tp->first_free = get_next_free(&tp->timers[tp->first_free]);
 		tp->num_alloc++;
-		/* Remove first unused timer from free list */
-		ODP_ASSERT(tp->first_free != tp->param.num_timers);
-		uint32_t idx = tp->first_free;
-		_odp_timer_t *tim = &tp->timers[idx];
-
-		tp->first_free = get_next_free(tim);
-		/* Initialize timer */
-		timer_init(tim, &tp->tick_buf[idx], queue, user_ptr);
-		if (odp_unlikely(tp->num_alloc > odp_atomic_load_u32(&tp->high_wm))) {
-			/* Update high_wm last with release model to
-			 * ensure timer initialization is visible */
-			odp_atomic_store_rel_u32(&tp->high_wm, tp->num_alloc);
-		}
+	}
 
-		hdl = tp_idx_to_handle(tp, idx);
-		/* Add timer to queue */
-		_odp_queue_fn->timer_add(queue);
-	} else {
-		_odp_errno = ENFILE; /* Reusing file table overflow */
-		hdl = ODP_TIMER_INVALID;
+	/* Timers beyond the old high_wm are still unused (TMO_UNUSED), so
+	 * those are not expired before initialization. */
+	if (odp_unlikely(tp->num_alloc > odp_atomic_load_u32(&tp->high_wm)))
+		odp_atomic_store_rel_u32(&tp->high_wm, tp->num_alloc);
+
+	odp_spinlock_unlock(&tp->lock);
+
+	return i;
+}
+
+/* Move 'num' timers from cache into pool free list */
+static void timer_cache_flush(timer_pool_t *tp, timer_cache_t *cache, uint32_t num)
+{
+	uint32_t idx;
+
+	odp_spinlock_lock(&tp->lock);
+
+	while (num--) {
+		idx = cache->idx[--cache->num];
+		set_next_free(&tp->timers[idx], tp->first_free);
+		tp->first_free = idx;
+		ODP_ASSERT(tp->num_alloc != 0);
+		tp->num_alloc--;
 	}
+
 	odp_spinlock_unlock(&tp->lock);
-	return hdl;
+}
+
+static inline odp_timer_t timer_alloc(timer_pool_t *tp, odp_queue_t queue, const void *user_ptr)
+{
+	timer_cache_t *cache = timer_cache(tp);
+	uint32_t idx, num_used;
+
+	if (odp_unlikely(cache->num == 0)) {
+		if (timer_cache_fill(tp, cache, TIMER_CACHE_BURST) == 0) {
+			_odp_errno = ENFILE; /* Reusing file table overflow */
+			return ODP_TIMER_INVALID;
+		}
+	}
+
+	idx = cache->idx[--cache->num];
+
+	/* Initialize timer */
+	timer_init(&tp->timers[idx], &tp->tick_buf[idx], queue, user_ptr);
+
+	num_used = odp_atomic_fetch_inc_u32(&tp->num_used) + 1;
+	if (odp_unlikely(num_used > odp_atomic_load_u32(&tp->hwm_used)))
+		odp_atomic_max_u32(&tp->hwm_used, num_used);
+
+	/* Add timer to queue */
+	_odp_queue_fn->timer_add(queue);
+
+	return tp_idx_to_handle(tp, idx);
 }
 
 static odp_event_t timer_set_unused(timer_pool_t *tp, uint32_t idx);
@@ -653,13 +777,16 @@ static inline odp_event_t timer_free(timer_pool_t *tp, uint32_t idx)
 	/* Destroy timer */
 	timer_fini(tim, &tp->tick_buf[idx]);
 
-	/* Insert timer into free list */
-	odp_spinlock_lock(&tp->lock);
-	set_next_free(tim, tp->first_free);
-	tp->first_free = idx;
-	ODP_ASSERT(tp->num_alloc != 0);
-	tp->num_alloc--;
-	odp_spinlock_unlock(&tp->lock);
+	ODP_ASSERT(odp_atomic_load_u32(&tp->num_used) != 0);
+	odp_atomic_dec_u32(&tp->num_used);
+
+	/* Insert timer into thread cache */
+	timer_cache_t *cache = timer_cache(tp);
+
+	if (odp_unlikely(cache->num == TIMER_CACHE_SIZE))
+		timer_cache_flush(tp, cache, TIMER_CACHE_BURST);
+
+	cache->idx[cache->num++] = idx;
 
 	return old_event;
 }
@@ -877,7 +1004,39 @@ static odp_event_t timer_cancel(timer_pool_t *tp, uint32_t idx)
 	return old_event;
 }
 
-static inline void timer_expire(timer_pool_t *tp, uint32_t idx, uint64_t tick)
+static void tmo_batch_flush(tmo_batch_t *batch)
+{
+	int i = 0;
+	int num = batch->num;
+
+	/* Enqueue consecutive timeouts of the same destination queue together */
+	while (i < num) {
+		odp_queue_t queue = batch->queue[i];
+		int num_enq = 1;
+		int ret;
+
+		while (i + num_enq < num && batch->queue[i + num_enq] == queue)
+			num_enq++;
+
+		ret = odp_queue_enq_multi(queue, &batch->event[i], num_enq);
+
+		if (odp_unlikely(ret != num_enq)) {
+			if (ret < 0)
+				ret = 0;
+
+			_odp_event_free_multi((_odp_event_hdr_t **)&batch->event[i + ret],
+					      num - i - ret);
+			ODP_ABORT("Failed to enqueue timeout event (%d)\n", ret);
+		}
+
+		i += num_enq;
+	}
+
+	batch->num = 0;
+}
+
+static inline void timer_expire(timer_pool_t *tp, uint32_t idx, uint64_t tick,
+				tmo_batch_t *batch)
 {
 	_odp_timer_t *tim = &tp->timers[idx];
 	tick_buf_t *tb = &tp->tick_buf[idx];
@@ -951,13 +1110,12 @@ static inline void timer_expire(timer_pool_t *tp, uint32_t idx, uint64_t tick)
 		}
 		/* Else ignore events of other types */
 		/* Post the timeout to the destination queue */
-		int rc = odp_queue_enq(tim->queue, tmo_event);
+		batch->queue[batch->num] = tim->queue;
+		batch->event[batch->num] = tmo_event;
+		batch->num++;
 
-		if (odp_unlikely(rc != 0)) {
-			_odp_event_free(tmo_event);
-			ODP_ABORT("Failed to enqueue timeout event (%d)\n",
-				  rc);
-		}
+		if (batch->num == TMO_BATCH_SIZE)
+			tmo_batch_flush(batch);
 	}
 }
 
@@ -966,8 +1124,11 @@ static inline void timer_pool_scan(timer_pool_t *tp, uint64_t tick)
 	tick_buf_t *array = &tp->tick_buf[0];
 	uint32_t high_wm = odp_atomic_load_acq_u32(&tp->high_wm);
 	uint32_t i;
+	tmo_batch_t batch;
+
+	batch.num = 0;
 
-	ODP_ASSERT(high_wm <= tp->param.num_timers);
+	ODP_ASSERT(high_wm <= tp->max_timers);
 	for (i = 0; i < high_wm; i++) {
 		/* As a rare occurrence, we can outsmart the HW prefetcher
 		 * and the compiler (GCC -fprefetch-loop-arrays) with some
@@ -979,9 +1140,12 @@ static inline void timer_pool_scan(timer_pool_t *tp, uint64_t tick)
 
 		if (odp_unlikely(exp_tck <= tick)) {
 			/* Attempt to expire timer */
-			timer_expire(tp, i, tick);
+			timer_expire(tp, i, tick, &batch);
 		}
 	}
+
+	if (batch.num)
+		tmo_batch_flush(&batch);
 }
 
 /******************************************************************************
@@ -1004,11 +1168,42 @@ static inline uint64_t current_nsec(timer_pool_t *tp)
 	return time_nsec(tp, now);
 }
 
-static inline void timer_pool_scan_inline(int num, odp_time_t now)
+/* Scan a timer pool, if its current tick has passed. Returns nanoseconds
+ * until the next tick. */
+static inline uint64_t timer_pool_tick(timer_pool_t *tp, odp_time_t now)
 {
-	timer_pool_t *tp;
 	uint64_t new_tick, old_tick, nsec;
 	int64_t diff;
+
+	nsec     = time_nsec(tp, now);
+	new_tick = nsec / tp->nsec_per_scan;
+	old_tick = odp_atomic_load_u64(&tp->cur_tick);
+	diff = new_tick - old_tick;
+
+	if (diff < 1)
+		goto next_tick;
+
+	if (odp_atomic_cas_u64(&tp->cur_tick, &old_tick, new_tick)) {
+		if (tp->notify_overrun && diff > 1) {
+			if (old_tick == 0) {
+				ODP_DBG("Timer pool (%s) missed %" PRIi64 " scans in start up\n",
+					tp->name, diff - 1);
+			} else {
+				ODP_DBG("Timer pool (%s) resolution too high: %" PRIi64 " scans missed\n",
+					tp->name, diff - 1);
+				tp->notify_overrun = 0;
+			}
+		}
+		timer_pool_scan(tp, nsec);
+	}
+
+next_tick:
+	return (new_tick + 1) * tp->nsec_per_scan - nsec;
+}
+
+static inline void timer_pool_scan_inline(int num, odp_time_t now)
+{
+	timer_pool_t *tp;
 	int i;
 
 	for (i = 0; i < num; i++) {
@@ -1028,27 +1223,7 @@ static inline void timer_pool_scan_inline(int num, odp_time_t now)
 				continue;
 		}
 
-		nsec     = time_nsec(tp, now);
-		new_tick = nsec / tp->nsec_per_scan;
-		old_tick = odp_atomic_load_u64(&tp->cur_tick);
-		diff = new_tick - old_tick;
-
-		if (diff < 1)
-			continue;
-
-		if (odp_atomic_cas_u64(&tp->cur_tick, &old_tick, new_tick)) {
-			if (tp->notify_overrun && diff > 1) {
-				if (old_tick == 0) {
-					ODP_DBG("Timer pool (%s) missed %" PRIi64 " scans in start up\n",
-						tp->name, diff - 1);
-				} else {
-					ODP_DBG("Timer pool (%s) resolution too high: %" PRIi64 " scans missed\n",
-						tp->name, diff - 1);
-					tp->notify_overrun = 0;
-				}
-			}
-			timer_pool_scan(tp, nsec);
-		}
+		timer_pool_tick(tp, now);
 	}
 }
 
@@ -1085,6 +1260,115 @@ void _odp_timer_run_inline(int dec)
 	timer_pool_scan_inline(num, now);
 }
 
+/******************************************************************************
+ * Timer service threads
+ * Threads poll timer pools in a loop and sleep until the next timer tick
+ *****************************************************************************/
+
+static void service_wake_up(void)
+{
+	odp_atomic_add_rel_u32(&timer_global->service_wake, 1);
+	syscall(SYS_futex, &timer_global->service_wake.v, FUTEX_WAKE, INT_MAX,
+		NULL, NULL, 0);
+}
+
+static void *timer_service_thread(void *arg)
+{
+	timer_service_t *service = arg;
+	int num_service = timer_global->num_service;
+	struct timespec ts;
+	odp_time_t now;
+	uint64_t wait, min_wait;
+	timer_pool_t *tp;
+	uint32_t wake;
+	int i, num;
+
+	while (odp_atomic_load_u32(&timer_global->service_exit) == 0) {
+		/* Read before scanning, so that a timer pool created during
+		 * the scan interrupts the following sleep */
+		wake = odp_atomic_load_acq_u32(&timer_global->service_wake);
+		num = timer_global->highest_tp_idx + 1;
+		min_wait = SERVICE_MAX_SLEEP_NS;
+		now = odp_time_global();
+
+		/* Timer pools are divided between service threads */
+		for (i = service->idx; i < num; i += num_service) {
+			tp = timer_global->timer_pool[i];
+
+			if (tp == NULL)
+				continue;
+
+			wait = timer_pool_tick(tp, now);
+
+			if (wait < min_wait)
+				min_wait = wait;
+		}
+
+		/* Sleep until the next tick or a wake up. Time spent in
+		 * scanning is subtracted from the wait time. */
+		wait = odp_time_diff_ns(odp_time_global(), now);
+		if (wait >= min_wait)
+			continue;
+
+		wait = min_wait - wait;
+		ts.tv_sec  = wait / ODP_TIME_SEC_IN_NS;
+		ts.tv_nsec = wait % ODP_TIME_SEC_IN_NS;
+		syscall(SYS_futex, &timer_global->service_wake.v, FUTEX_WAIT,
+			wake, &ts, NULL, 0);
+	}
+
+	return NULL;
+}
+
+static int start_service_threads(void)
+{
+	timer_service_t *service;
+	pthread_attr_t attr;
+	cpu_set_t cpu_set;
+	int i, ret;
+
+	odp_atomic_init_u32(&timer_global->service_exit, 0);
+	odp_atomic_init_u32(&timer_global->service_wake, 0);
+
+	for (i = 0; i < timer_global->num_service; i++) {
+		service = &timer_global->service[i];
+		service->idx = i;
+
+		pthread_attr_init(&attr);
+
+		if (service->cpu >= 0) {
+			CPU_ZERO(&cpu_set);
+			CPU_SET(service->cpu, &cpu_set);
+			pthread_attr_setaffinity_np(&attr, sizeof(cpu_set_t), &cpu_set);
+		}
+
+		ret = pthread_create(&service->thr_pthread, &attr, timer_service_thread, service);
+		pthread_attr_destroy(&attr);
+
+		if (ret) {
+			ODP_ERR("Unable to create timer service thread: %d\n", ret);
+			timer_global->num_service = i;
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+static void stop_service_threads(void)
+{
+	int i, ret;
+
+	odp_atomic_store_u32(&timer_global->service_exit, 1);
+	service_wake_up();
+
+	for (i = 0; i < timer_global->num_service; i++) {
+		ret = pthread_join(timer_global->service[i].thr_pthread, NULL);
+		if (ret)
+			ODP_ERR("Unable to join timer service thread: %d\n", ret);
+	}
+}
+
 /******************************************************************************
  * POSIX timer support
  * Functions that use Linux/POSIX per-process timers and related facilities
@@ -1477,8 +1761,8 @@ int odp_timer_pool_info(odp_timer_pool_t tpid, odp_timer_pool_info_t *tp_info)
 
 	memset(tp_info, 0, sizeof(odp_timer_pool_info_t));
 	tp_info->param = tp->param;
-	tp_info->cur_timers = tp->num_alloc;
-	tp_info->hwm_timers = odp_atomic_load_u32(&tp->high_wm);
+	tp_info->cur_timers = odp_atomic_load_u32(&tp->num_used);
+	tp_info->hwm_timers = odp_atomic_load_u32(&tp->hwm_used);
 	tp_info->name = tp->name;
 
 	/* One API timer tick is one nsec. Leave source clock information to zero
@@ -1557,12 +1841,10 @@ int odp_timer_set_rel(odp_timer_t hdl,
 		return ODP_TIMER_FAIL;
 }
 
-int odp_timer_start(odp_timer_t timer, const odp_timer_start_t *start_param)
+static inline int timer_start(timer_pool_t *tp, uint32_t idx, uint64_t cur_tick,
+			      const odp_timer_start_t *start_param)
 {
 	uint64_t abs_tick, rel_tick;
-	timer_pool_t *tp = handle_to_tp(timer);
-	uint64_t cur_tick = current_nsec(tp);
-	uint32_t idx = handle_to_idx(timer, tp);
 	odp_event_t tmo_ev = start_param->tmo_ev;
 
 	if (start_param->tick_type == ODP_TIMER_TICK_ABS) {
@@ -1594,12 +1876,10 @@ int odp_timer_start(odp_timer_t timer, const odp_timer_start_t *start_param)
 	return ODP_TIMER_SUCCESS;
 }
 
-int odp_timer_restart(odp_timer_t timer, const odp_timer_start_t *start_param)
+static inline int timer_restart(timer_pool_t *tp, uint32_t idx, uint64_t cur_tick,
+				const odp_timer_start_t *start_param)
 {
 	uint64_t abs_tick, rel_tick;
-	timer_pool_t *tp = handle_to_tp(timer);
-	uint64_t cur_tick = current_nsec(tp);
-	uint32_t idx = handle_to_idx(timer, tp);
 
 	if (start_param->tick_type == ODP_TIMER_TICK_ABS) {
 		abs_tick = start_param->tick;
@@ -1625,6 +1905,89 @@ int odp_timer_restart(odp_timer_t timer, const odp_timer_start_t *start_param)
 	return ODP_TIMER_SUCCESS;
 }
 
+/* Prefetch tick buffers of timers for modification */
+static inline void timer_prefetch_multi(const odp_timer_t timer[], int num)
+{
+	timer_pool_t *tp;
+	int i;
+
+	for (i = 0; i < num; i++) {
+		tp = handle_to_tp(timer[i]);
+		__builtin_prefetch(&tp->tick_buf[handle_to_idx(timer[i], tp)], 1, 3);
+	}
+}
+
+int odp_timer_start(odp_timer_t timer, const odp_timer_start_t *start_param)
+{
+	timer_pool_t *tp = handle_to_tp(timer);
+
+	return timer_start(tp, handle_to_idx(timer, tp), current_nsec(tp), start_param);
+}
+
+int odp_timer_restart(odp_timer_t timer, const odp_timer_start_t *start_param)
+{
+	timer_pool_t *tp = handle_to_tp(timer);
+
+	return timer_restart(tp, handle_to_idx(timer, tp), current_nsec(tp), start_param);
+}
+
+/* Multi-timer calls read the current time once per timer pool and prefetch
+ * all tick buffers before updating them. Each timer is still updated with its
+ * own atomic operation (or lock), as the tick buffers of different timers are
+ * independent and cannot be modified with a single atomic operation. */
+int odp_timer_start_multi(const odp_timer_t timer[], const odp_timer_start_t start_param[],
+			  int num)
+{
+	timer_pool_t *tp, *prev_tp = NULL;
+	uint64_t cur_tick = 0;
+	int i, ret;
+
+	timer_prefetch_multi(timer, num);
+
+	for (i = 0; i < num; i++) {
+		tp = handle_to_tp(timer[i]);
+
+		/* Read current time once per timer pool */
+		if (tp != prev_tp) {
+			cur_tick = current_nsec(tp);
+			prev_tp = tp;
+		}
+
+		ret = timer_start(tp, handle_to_idx(timer[i], tp), cur_tick, &start_param[i]);
+
+		if (odp_unlikely(ret != ODP_TIMER_SUCCESS))
+			return i ? i : ret;
+	}
+
+	return num;
+}
+
+int odp_timer_restart_multi(const odp_timer_t timer[], const odp_timer_start_t start_param[],
+			    int num)
+{
+	timer_pool_t *tp, *prev_tp = NULL;
+	uint64_t cur_tick = 0;
+	int i, ret;
+
+	timer_prefetch_multi(timer, num);
+
+	for (i = 0; i < num; i++) {
+		tp = handle_to_tp(timer[i]);
+
+		if (tp != prev_tp) {
+			cur_tick = current_nsec(tp);
+			prev_tp = tp;
+		}
+
+		ret = timer_restart(tp, handle_to_idx(timer[i], tp), cur_tick, &start_param[i]);
+
+		if (odp_unlikely(ret != ODP_TIMER_SUCCESS))
+			return i ? i : ret;
+	}
+
+	return num;
+}
+
 int odp_timer_periodic_start(odp_timer_t timer, const odp_timer_periodic_start_t *start_param)
 {
 	uint64_t abs_tick, period_ns;
@@ -1740,6 +2103,25 @@ int odp_timer_cancel(odp_timer_t hdl, odp_event_t *tmo_ev)
 	return -1;
 }
 
+int odp_timer_cancel_multi(const odp_timer_t timer[], odp_event_t tmo_ev[], int num)
+{
+	timer_pool_t *tp;
+	int i;
+	int num_cancel = 0;
+
+	timer_prefetch_multi(timer, num);
+
+	for (i = 0; i < num; i++) {
+		tp = handle_to_tp(timer[i]);
+		tmo_ev[i] = timer_cancel(tp, handle_to_idx(timer[i], tp));
+
+		if (tmo_ev[i] != ODP_EVENT_INVALID)
+			num_cancel++;
+	}
+
+	return num_cancel;
+}
+
 int odp_timer_periodic_cancel(odp_timer_t hdl)
 {
 	timer_pool_t *tp;
@@ -1842,9 +2224,10 @@ void odp_timer_pool_print(odp_timer_pool_t timer_pool)
 	ODP_PRINT("---------------\n");
 	ODP_PRINT("  timer pool     %p\n", (void *)tp);
 	ODP_PRINT("  tp index       %u\n", tp->tp_idx);
-	ODP_PRINT("  num timers     %u\n", tp->num_alloc);
+	ODP_PRINT("  num timers     %u\n", odp_atomic_load_u32(&tp->num_used));
 	ODP_PRINT("  num tp         %i\n", timer_global->num_timer_pools);
 	ODP_PRINT("  inline timers  %i\n", timer_global->use_inline_timers);
+	ODP_PRINT("  service thrs   %i\n", timer_global->num_service);
 	ODP_PRINT("  periodic       %i\n", tp->periodic);
 	ODP_PRINT("\n");
 }
@@ -1912,6 +2295,7 @@ int _odp_timer_init_global(const odp_init_t *params)
 	const char *conf_str;
 	uint32_t i;
 	int val = 0;
+	int mode, cpu;
 
 	if (params && params->not_used.feat.timer) {
 		ODP_DBG("Timers disabled\n");
@@ -1954,7 +2338,12 @@ int _odp_timer_init_global(const odp_init_t *params)
 		ODP_ERR("Config option '%s' not found.\n", conf_str);
 		goto error;
 	}
-	timer_global->use_inline_timers = val;
+	if (val < TIMER_MODE_POSIX || val > TIMER_MODE_SERVICE) {
+		ODP_ERR("Bad value %s = %i\n", conf_str, val);
+		goto error;
+	}
+	mode = val;
+	timer_global->use_inline_timers = (mode == TIMER_MODE_INLINE);
 	ODP_PRINT("  %s: %i\n", conf_str, val);
 
 	conf_str =  "timer.inline_poll_interval";
@@ -1982,9 +2371,36 @@ int _odp_timer_init_global(const odp_init_t *params)
 	}
 	timer_global->thread_type = val;
 	ODP_PRINT("  %s: %i\n", conf_str, val);
+
+	conf_str =  "timer.service_threads";
+	if (!_odp_libconfig_lookup_int(conf_str, &val)) {
+		ODP_ERR("Config option '%s' not found.\n", conf_str);
+		goto error;
+	}
+	if (val < 1 || val > MAX_SERVICE_THREADS) {
+		ODP_ERR("Bad value %s = %i\n", conf_str, val);
+		goto error;
+	}
+	if (mode == TIMER_MODE_SERVICE)
+		timer_global->num_service = val;
+	ODP_PRINT("  %s: %i\n", conf_str, val);
+
+	conf_str =  "timer.service_cpu";
+	if (!_odp_libconfig_lookup_int(conf_str, &cpu)) {
+		ODP_ERR("Config option '%s' not found.\n", conf_str);
+		goto error;
+	}
+	if (cpu >= 0 && cpu + timer_global->num_service > CPU_SETSIZE) {
+		ODP_ERR("Bad value %s = %i\n", conf_str, cpu);
+		goto error;
+	}
+	ODP_PRINT("  %s: %i\n", conf_str, cpu);
 	ODP_PRINT("\n");
 
-	if (!timer_global->use_inline_timers) {
+	for (i = 0; i < (uint32_t)timer_global->num_service; i++)
+		timer_global->service[i].cpu = cpu < 0 ? -1 : cpu + (int)i;
+
+	if (mode == TIMER_MODE_POSIX) {
 		timer_res_init();
 		block_sigalarm();
 	}
@@ -1993,6 +2409,11 @@ int _odp_timer_init_global(const odp_init_t *params)
 	timer_global->highest_res_hz = GIGA_HZ / timer_global->highest_res_ns;
 	timer_global->max_base_hz    = timer_global->highest_res_hz;
 
+	if (timer_global->num_service && start_service_threads()) {
+		stop_service_threads();
+		goto error;
+	}
+
 	return 0;
 
 error:
@@ -2008,6 +2429,9 @@ int _odp_timer_term_global(void)
 	if (timer_global == NULL)
 		return 0;
 
+	if (timer_global->num_service)
+		stop_service_threads();
+
 	for (i = 0; i < MAX_TIMER_POOLS; i++) {
 		shm = timer_global->tp_shm[i];
 		if (shm != ODP_SHM_INVALID) {
@@ -2034,6 +2458,7 @@ int _odp_timer_init_local(void)
 	timer_local.last_run = odp_time_global_from_ns(0);
 	timer_local.run_cnt = 1;
 	timer_local.poll_shared = 0;
+	memset(timer_local.cache, 0, sizeof(timer_local.cache));
 
 	/* Timer feature disabled */
 	if (timer_global == NULL)
@@ -2055,5 +2480,27 @@ int _odp_timer_init_local(void)
 
 int _odp_timer_term_local(void)
 {
+	timer_cache_t *cache;
+	timer_pool_t *tp;
+	int i;
+
+	if (timer_global == NULL)
+		return 0;
+
+	/* Return cached timers into free lists */
+	odp_ticketlock_lock(&timer_global->lock);
+
+	for (i = 0; i < MAX_TIMER_POOLS; i++) {
+		cache = &timer_local.cache[i];
+		tp = timer_global->timer_pool[i];
+
+		if (tp && cache->num && cache->gen == tp->gen)
+			timer_cache_flush(tp, cache, cache->num);
+
+		cache->num = 0;
+	}
+
+	odp_ticketlock_unlock(&timer_global->lock);
+
 	return 0;
 }
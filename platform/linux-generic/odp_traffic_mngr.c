@@ -2287,6 +2287,8 @@ static void tm_send_pkt(tm_system_t *tm_system, uint32_t max_sends)
 				if (odp_unlikely(_odp_pktio_tx_compl_enabled(pktio_entry)))
 					_odp_pktio_allocate_and_send_tx_compl_events(pktio_entry,
 										     &odp_pkt, 1);
+				if (odp_unlikely(_odp_pktio_proto_stats_enabled(pktio_entry)))
+					_odp_pktio_proto_stats_drop(&odp_pkt, 1);
 				odp_packet_free(odp_pkt);
 				if (odp_unlikely(ret < 0))
 					odp_atomic_inc_u64(&tm_queue_obj->stats.errors);
@@ -4607,6 +4609,23 @@ int odp_tm_enq_multi(odp_tm_queue_t tm_queue, const odp_packet_t packets[],
 	return i;
 }
 
+/* Count LSO segments that are dropped before reaching packet output */
+static void tm_proto_stats_drop(odp_tm_queue_t tm_queue, const odp_packet_t packets[], int num)
+{
+	tm_queue_obj_t *tm_queue_obj = GET_TM_QUEUE_OBJ(tm_queue);
+	tm_system_t *tm_system;
+
+	if (tm_queue_obj == NULL)
+		return;
+
+	tm_system = &tm_glb->system[tm_queue_obj->tm_idx];
+	if (tm_system->egress.egress_kind != ODP_TM_EGRESS_PKT_IO)
+		return;
+
+	if (odp_unlikely(_odp_pktio_proto_stats_enabled(get_pktio_entry(tm_system->pktout.pktio))))
+		_odp_pktio_proto_stats_drop(packets, num);
+}
+
 int odp_tm_enq_multi_lso(odp_tm_queue_t tm_queue, const odp_packet_t packets[], int num,
 			 const odp_packet_lso_opt_t *opt)
 {
@@ -4677,6 +4696,7 @@ int odp_tm_enq_multi_lso(odp_tm_queue_t tm_queue, const odp_packet_t packets[],
 			if (ret < 0)
 				ret = 0;
 
+			tm_proto_stats_drop(tm_queue, &pkt_out[ret], num_pkt - ret);
 			odp_packet_free_multi(&pkt_out[ret], num_pkt - ret);
 			goto error;
 		}
@@ -48,6 +48,7 @@
 
 typedef struct {
 	odp_queue_t loopq;		/**< loopback queue for "loop" device */
+	_odp_ipsec_sa_cache_t sa_cache;	/**< inline IPsec SA cache of the input queue */
 	uint16_t mtu;			/**< link MTU */
 	uint8_t idx;			/**< index of "loop" device */
 } pkt_loop_t;
@@ -87,6 +88,7 @@ static int loopback_open(odp_pktio_t id ODP_UNUSED, pktio_entry_t *pktio_entry,
 	pkt_loop->idx = idx;
 	pkt_loop->mtu = LOOP_MTU_MAX;
 	pkt_loop->loopq = ODP_QUEUE_INVALID;
+	_odp_ipsec_sa_cache_init(&pkt_loop->sa_cache);
 
 	loopback_stats_reset(pktio_entry);
 	loopback_init_capability(pktio_entry);
@@ -237,12 +239,6 @@ static int loopback_recv(pktio_entry_t *pktio_entry, int index ODP_UNUSED,
 		packet_set_ts(pkt_hdr, ts);
 		pkt_hdr->input = pktio_entry->handle;
 
-		/* Try IPsec inline processing */
-		if (pktio_entry->config.inbound_ipsec &&
-		    !pkt_hdr->p.flags.ip_err &&
-		    odp_packet_has_ipsec(pkt))
-			_odp_ipsec_try_inline(&pkt);
-
 		if (!pkt_hdr->p.flags.all.error) {
 			octets += pkt_len;
 			packets++;
@@ -251,6 +247,10 @@ static int loopback_recv(pktio_entry_t *pktio_entry, int index ODP_UNUSED,
 		pkts[num_rx++] = pkt;
 	}
 
+	/* Try IPsec inline processing for the whole burst */
+	if (pktio_entry->config.inbound_ipsec && num_rx)
+		_odp_ipsec_try_inline_multi(pkts, num_rx, &pkt_priv(pktio_entry)->sa_cache);
+
 	pktio_entry->stats.in_octets += octets;
 	pktio_entry->stats.in_packets += packets;
 
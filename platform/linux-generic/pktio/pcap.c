@@ -31,7 +31,21 @@
  *           be overwritten.
  *   loops   the number of times to iterate through the input file, set
  *           to 0 to loop indefinitely. The default value is 1. Looping is
- *           only supported in thread mode (ODP_MEM_MODEL_THREAD).
+ *           only supported in thread mode (ODP_MEM_MODEL_THREAD), unless
+ *           the input file is preloaded into memory.
+ *   mem     set to 1 to preload the input file into memory. Packets are
+ *           served in bursts from memory and may be spread over multiple
+ *           input queues using the input hash configuration. The following
+ *           pacing options are supported only in this mode and define
+ *           the receive rate of each input queue:
+ *   pps     packets per second
+ *   bps     bits per second, including Ethernet preamble, inter-frame gap
+ *           and FCS (line rate)
+ *   ts      set to 1 to replay packets with original capture time gaps
+ *
+ * For example:
+ *
+ * pcap:in=test.pcap:mem=1:pps=1000000:loops=0
  *
  * The total length of the string is limited by PKTIO_NAME_LEN.
  */
@@ -39,10 +53,12 @@
 #include <odp_posix_extensions.h>
 
 #include <odp/api/debug.h>
+#include <odp/api/hash.h>
 #include <odp/api/hints.h>
 #include <odp/api/packet.h>
 #include <odp/api/packet_io.h>
 #include <odp/api/ticketlock.h>
+#include <odp/api/time.h>
 
 #include <odp/api/plat/packet_inlines.h>
 
@@ -52,13 +68,64 @@
 #include <odp_global_data.h>
 #include <odp_packet_internal.h>
 #include <odp_packet_io_internal.h>
+#include <odp_queue_if.h>
 
 #include <protocols/eth.h>
+#include <protocols/ip.h>
+#include <protocols/tcp.h>
+#include <protocols/udp.h>
 
 #include <errno.h>
 #include <pcap/pcap.h>
 #include <pcap/bpf.h>
 #include <stdint.h>
+#include <stdlib.h>
+
+/* Ethernet preamble, inter-frame gap and FCS */
+#define PCAP_ETH_OVERHEAD 24
+
+/* Preloaded packet */
+typedef struct {
+	/* Data offset in preload buffer */
+	uint64_t offset;
+
+	/* Capture time stamp */
+	uint64_t ts_ns;
+
+	uint32_t len;
+
+	/* Packet is dropped when not in promiscuous mode */
+	uint8_t promisc_only;
+
+} pcap_rec_t;
+
+/* Input queue state in preload mode */
+typedef struct ODP_ALIGNED_CACHE {
+	odp_ticketlock_t lock;
+
+	/* Packets (record indexes) of this queue */
+	uint32_t *rec_idx;
+	uint32_t num_rec;
+
+	/* Next packet */
+	uint32_t next;
+
+	/* Number of loops completed */
+	int loop_cnt;
+
+	/* Pacing start time, and receive time of the next packet relative
+	 * to that */
+	uint64_t start_ns;
+	uint64_t pace_ns;
+	uint64_t pace_rem;
+
+	/* Time stamp offset of the current loop in time stamp pacing */
+	uint64_t ts_base;
+
+	uint64_t in_octets;
+	uint64_t in_packets;
+
+} pcap_rxq_t;
 
 typedef struct {
 	char *fname_rx;		/**< name of pcap file for rx */
@@ -71,6 +138,20 @@ typedef struct {
 	int loops;		/**< number of times to loop rx pcap */
 	int loop_cnt;		/**< number of loops completed */
 	odp_bool_t promisc;	/**< promiscuous mode state */
+
+	/* Preload mode */
+	struct {
+		uint8_t *data;		/**< packet data */
+		pcap_rec_t *rec;	/**< packet records */
+		uint32_t num_rec;	/**< number of packets */
+		uint32_t num_queue;	/**< number of input queues */
+		uint64_t pps;		/**< packets per second per queue */
+		uint64_t bps;		/**< bits per second per queue */
+		uint8_t ts;		/**< pace by capture time stamps */
+		uint8_t enable;		/**< preload enabled */
+		uint8_t lockless;	/**< input queues are not polled concurrently */
+		pcap_rxq_t *rxq;	/**< input queue state table */
+	} mem;
 } pkt_pcap_t;
 
 ODP_STATIC_ASSERT(PKTIO_PRIVATE_SIZE >= sizeof(pkt_pcap_t),
@@ -112,9 +193,250 @@ static int _pcapif_parse_devname(pkt_pcap_t *pcap, const char *devname)
 				ODP_ERR("invalid loop count\n");
 				return -1;
 			}
+		} else if (strncmp(tok, "mem=", 4) == 0) {
+			pcap->mem.enable = !!atoi(tok + 4);
+		} else if (strncmp(tok, "pps=", 4) == 0) {
+			pcap->mem.pps = strtoull(tok + 4, NULL, 10);
+		} else if (strncmp(tok, "bps=", 4) == 0) {
+			pcap->mem.bps = strtoull(tok + 4, NULL, 10);
+		} else if (strncmp(tok, "ts=", 3) == 0) {
+			pcap->mem.ts = !!atoi(tok + 3);
+		}
+	}
+
+	if ((pcap->mem.pps || pcap->mem.bps || pcap->mem.ts) && !pcap->mem.enable) {
+		ODP_ERR("pacing requires mem=1\n");
+		return -1;
+	}
+
+	if (!!pcap->mem.pps + !!pcap->mem.bps + pcap->mem.ts > 1) {
+		ODP_ERR("only one pacing option may be used\n");
+		return -1;
+	}
+
+	return 0;
+}
+
+static inline int pcap_pacing(const pkt_pcap_t *pcap)
+{
+	return pcap->mem.pps || pcap->mem.bps || pcap->mem.ts;
+}
+
+/* Read the whole input file into memory */
+static int _pcapif_preload(pkt_pcap_t *pcap)
+{
+	struct pcap_pkthdr *hdr;
+	const u_char *data;
+	uint64_t data_size = 0, data_max = 0;
+	uint32_t rec_max = 0;
+	int ret;
+
+	while ((ret = pcap_next_ex(pcap->rx, &hdr, &data)) == 1) {
+		pcap_rec_t *rec;
+
+		if (pcap->mem.num_rec == rec_max) {
+			uint32_t new_max = rec_max ? 2 * rec_max : 1024;
+			pcap_rec_t *new_rec = realloc(pcap->mem.rec, new_max * sizeof(pcap_rec_t));
+
+			if (new_rec == NULL)
+				goto nomem;
+
+			pcap->mem.rec = new_rec;
+			rec_max = new_max;
+		}
+
+		if (data_size + hdr->caplen > data_max) {
+			uint64_t new_max = data_max ? 2 * data_max : 1024 * 1024;
+			uint8_t *new_data;
+
+			while (new_max < data_size + hdr->caplen)
+				new_max *= 2;
+
+			new_data = realloc(pcap->mem.data, new_max);
+			if (new_data == NULL)
+				goto nomem;
+
+			pcap->mem.data = new_data;
+			data_max = new_max;
+		}
+
+		rec = &pcap->mem.rec[pcap->mem.num_rec++];
+		rec->offset = data_size;
+		rec->len = hdr->caplen;
+		rec->ts_ns = (uint64_t)hdr->ts.tv_sec * ODP_TIME_SEC_IN_NS +
+			     (uint64_t)hdr->ts.tv_usec * ODP_TIME_USEC_IN_NS;
+		rec->promisc_only = 0;
+
+		/* Same filter as with pcap_setfilter() in non-promiscuous mode */
+		if (hdr->caplen >= _ODP_ETHADDR_LEN &&
+		    memcmp(data, pcap_mac, _ODP_ETHADDR_LEN) && !(data[0] & 0x1))
+			rec->promisc_only = 1;
+
+		memcpy(&pcap->mem.data[data_size], data, hdr->caplen);
+		data_size += hdr->caplen;
+	}
+
+	if (ret != -2) {
+		ODP_ERR("failed to read pcap file %s (%s)\n", pcap->fname_rx,
+			pcap_geterr(pcap->rx));
+		return -1;
+	}
+
+	if (posix_memalign((void **)&pcap->mem.rxq, ODP_CACHE_LINE_SIZE,
+			   PKTIO_MAX_QUEUES * sizeof(pcap_rxq_t)))
+		goto nomem;
+
+	memset(pcap->mem.rxq, 0, PKTIO_MAX_QUEUES * sizeof(pcap_rxq_t));
+
+	return 0;
+
+nomem:
+	ODP_ERR("out of memory while loading pcap file %s\n", pcap->fname_rx);
+	return -1;
+}
+
+/* Input hash of a preloaded packet */
+static uint32_t pcap_rec_hash(const uint8_t *data, uint32_t len,
+			      odp_pktin_hash_proto_t hash_proto)
+{
+	packet_parser_t prs;
+	const uint8_t *parseptr = data;
+	uint32_t offset = 0;
+	uint64_t l4_part_sum = 0;
+	odp_pktin_config_opt_t opt = { .all_bits = 0 };
+	uint16_t ethtype;
+	uint32_t tuple[2 * 4 + 1];
+	uint32_t tuple_len = 0;
+	uint32_t addr_len = 0;
+	int l4 = 0;
+	uint8_t buf[PARSE_BYTES];
+
+	/* The parser may read up to PARSE_BYTES, but checks header lengths
+	 * against the real frame length. Pad short frames with zeros. */
+	if (len < PARSE_BYTES) {
+		memcpy(buf, data, len);
+		memset(buf + len, 0, PARSE_BYTES - len);
+		data = buf;
+		parseptr = buf;
+	}
+
+	memset(&prs, 0, sizeof(prs));
+	ethtype = _odp_parse_eth(&prs, &parseptr, &offset, len);
+	if (_odp_packet_parse_common_l3_l4(&prs, parseptr, offset, len, len,
+					   ODP_PROTO_LAYER_L4, ethtype,
+					   &l4_part_sum, opt) < 0)
+		return 0;
+
+	if (prs.input_flags.ipv4) {
+		const _odp_ipv4hdr_t *ipv4 = (const _odp_ipv4hdr_t *)(data + prs.l3_offset);
+
+		if (hash_proto.proto.ipv4 ||
+		    (hash_proto.proto.ipv4_udp && prs.input_flags.udp) ||
+		    (hash_proto.proto.ipv4_tcp && prs.input_flags.tcp)) {
+			tuple[0] = ipv4->src_addr;
+			tuple[1] = ipv4->dst_addr;
+			addr_len = 2;
+		}
+
+		l4 = (hash_proto.proto.ipv4_udp && prs.input_flags.udp) ||
+		     (hash_proto.proto.ipv4_tcp && prs.input_flags.tcp);
+	} else if (prs.input_flags.ipv6) {
+		const _odp_ipv6hdr_t *ipv6 = (const _odp_ipv6hdr_t *)(data + prs.l3_offset);
+
+		if (hash_proto.proto.ipv6 ||
+		    (hash_proto.proto.ipv6_udp && prs.input_flags.udp) ||
+		    (hash_proto.proto.ipv6_tcp && prs.input_flags.tcp)) {
+			memcpy(tuple, &ipv6->src_addr, _ODP_IPV6ADDR_LEN);
+			memcpy(&tuple[4], &ipv6->dst_addr, _ODP_IPV6ADDR_LEN);
+			addr_len = 8;
+		}
+
+		l4 = (hash_proto.proto.ipv6_udp && prs.input_flags.udp) ||
+		     (hash_proto.proto.ipv6_tcp && prs.input_flags.tcp);
+	}
+
+	tuple_len = addr_len;
+
+	/* Source and destination ports are in the same location in TCP and
+	 * UDP headers */
+	if (l4) {
+		const _odp_udphdr_t *udp = (const _odp_udphdr_t *)(data + prs.l4_offset);
+
+		memcpy(&tuple[tuple_len++], &udp->src_port, 2 * sizeof(uint16_t));
+	}
+
+	if (tuple_len == 0)
+		return 0;
+
+	return odp_hash_crc32c(tuple, tuple_len * sizeof(uint32_t), 0);
+}
+
+/* Spread preloaded packets to input queues */
+static int pcap_mem_queues_config(pkt_pcap_t *pcap, uint32_t num_queue,
+				  odp_bool_t hash_enable,
+				  odp_pktin_hash_proto_t hash_proto)
+{
+	uint32_t i, num_rec = pcap->mem.num_rec;
+	uint32_t *queue_of_rec;
+
+	queue_of_rec = malloc(sizeof(uint32_t) * (num_rec ? num_rec : 1));
+	if (queue_of_rec == NULL)
+		return -1;
+
+	for (i = 0; i < PKTIO_MAX_QUEUES; i++) {
+		pcap_rxq_t *rxq = &pcap->mem.rxq[i];
+
+		/* Statistics counters are kept over reconfiguration */
+		free(rxq->rec_idx);
+		rxq->rec_idx = NULL;
+		rxq->num_rec = 0;
+		rxq->next = 0;
+		rxq->loop_cnt = 1;
+		rxq->start_ns = 0;
+		rxq->pace_ns = 0;
+		rxq->pace_rem = 0;
+		rxq->ts_base = 0;
+		odp_ticketlock_init(&rxq->lock);
+	}
+
+	for (i = 0; i < num_rec; i++) {
+		const pcap_rec_t *rec = &pcap->mem.rec[i];
+		uint32_t queue = 0;
+
+		if (num_queue > 1 && hash_enable)
+			queue = pcap_rec_hash(&pcap->mem.data[rec->offset], rec->len,
+					      hash_proto) % num_queue;
+		else if (num_queue > 1)
+			queue = i % num_queue;
+
+		queue_of_rec[i] = queue;
+		pcap->mem.rxq[queue].num_rec++;
+	}
+
+	for (i = 0; i < num_queue; i++) {
+		pcap_rxq_t *rxq = &pcap->mem.rxq[i];
+
+		if (rxq->num_rec == 0)
+			continue;
+
+		rxq->rec_idx = malloc(sizeof(uint32_t) * rxq->num_rec);
+		if (rxq->rec_idx == NULL) {
+			free(queue_of_rec);
+			return -1;
 		}
+
+		rxq->num_rec = 0;
+	}
+
+	for (i = 0; i < num_rec; i++) {
+		pcap_rxq_t *rxq = &pcap->mem.rxq[queue_of_rec[i]];
+
+		rxq->rec_idx[rxq->num_rec++] = i;
 	}
 
+	free(queue_of_rec);
+	pcap->mem.num_queue = num_queue;
+
 	return 0;
 }
 
@@ -136,6 +458,15 @@ static int _pcapif_init_rx(pkt_pcap_t *pcap)
 		return -1;
 	}
 
+	if (pcap->mem.enable) {
+		odp_pktin_hash_proto_t hash_proto = { .all_bits = 0 };
+
+		if (_pcapif_preload(pcap))
+			return -1;
+
+		return pcap_mem_queues_config(pcap, 1, false, hash_proto);
+	}
+
 	return 0;
 }
 
@@ -172,7 +503,8 @@ static int pcapif_promisc_mode_set(pktio_entry_t *pktio_entry,
 	struct bpf_program bpf;
 	pkt_pcap_t *pcap = pkt_priv(pktio_entry);
 
-	if (!pcap->rx) {
+	/* Preloaded packets are filtered on receive */
+	if (!pcap->rx || pcap->mem.enable) {
 		pcap->promisc = enable;
 		return 0;
 	}
@@ -252,6 +584,14 @@ static int pcapif_close(pktio_entry_t *pktio_entry)
 	if (pcap->rx)
 		pcap_close(pcap->rx);
 
+	if (pcap->mem.rxq) {
+		for (int i = 0; i < PKTIO_MAX_QUEUES; i++)
+			free(pcap->mem.rxq[i].rec_idx);
+	}
+
+	free(pcap->mem.rxq);
+	free(pcap->mem.rec);
+	free(pcap->mem.data);
 	free(pcap->fname_rx);
 	free(pcap->fname_tx);
 
@@ -282,7 +622,282 @@ static int _pcapif_reopen(pkt_pcap_t *pcap)
 	return 0;
 }
 
-static int pcapif_recv_pkt(pktio_entry_t *pktio_entry, int index ODP_UNUSED,
+/* Parse and classify a received packet. Returns 0 when the packet is
+ * delivered, or <0 when it was dropped. */
+static inline int pcap_pkt_input(pktio_entry_t *pktio_entry, odp_packet_t *pkt,
+				 const uint8_t *data, uint32_t pkt_len, odp_time_t *ts)
+{
+	odp_packet_hdr_t *pkt_hdr = packet_hdr(*pkt);
+	const odp_proto_layer_t layer = pktio_entry->parse_layer;
+	const odp_pktin_config_opt_t opt = pktio_entry->config.pktin;
+	int ret;
+
+	if (layer) {
+		ret = _odp_packet_parse_common(pkt_hdr, data, pkt_len,
+					       pkt_len, layer, opt);
+		if (ret)
+			odp_atomic_inc_u64(&pktio_entry->stats_extra.in_errors);
+
+		if (ret < 0) {
+			odp_packet_free(*pkt);
+			return -1;
+		}
+
+		if (pktio_cls_enabled(pktio_entry)) {
+			odp_pool_t new_pool;
+
+			ret = _odp_cls_classify_packet(pktio_entry, data,
+						       &new_pool, pkt_hdr);
+			if (ret < 0)
+				odp_atomic_inc_u64(&pktio_entry->stats_extra.in_discards);
+
+			if (ret) {
+				odp_packet_free(*pkt);
+				return -1;
+			}
+
+			if (odp_unlikely(_odp_pktio_packet_to_pool(
+				    pkt, &pkt_hdr, new_pool))) {
+				odp_packet_free(*pkt);
+				odp_atomic_inc_u64(&pktio_entry->stats_extra.in_discards);
+				return -1;
+			}
+		}
+	}
+
+	packet_set_ts(pkt_hdr, ts);
+	pkt_hdr->input = pktio_entry->handle;
+
+	return 0;
+}
+
+/* Receive time of a preloaded packet */
+static inline uint64_t pcap_mem_due_ns(const pkt_pcap_t *pcap, const pcap_rxq_t *rxq,
+				       const pcap_rec_t *rec)
+{
+	if (pcap->mem.ts) {
+		uint64_t first_ts = pcap->mem.rec[rxq->rec_idx[0]].ts_ns;
+		uint64_t diff = rec->ts_ns > first_ts ? rec->ts_ns - first_ts : 0;
+
+		return rxq->start_ns + rxq->ts_base + diff;
+	}
+
+	return rxq->start_ns + rxq->pace_ns;
+}
+
+/* Advance packet or bit rate pacing by one packet */
+static inline void pcap_mem_pace(const pkt_pcap_t *pcap, pcap_rxq_t *rxq,
+				 const pcap_rec_t *rec)
+{
+	uint64_t units, rate;
+
+	if (pcap->mem.pps) {
+		units = ODP_TIME_SEC_IN_NS;
+		rate = pcap->mem.pps;
+	} else if (pcap->mem.bps) {
+		units = (uint64_t)(rec->len + PCAP_ETH_OVERHEAD) * 8 * ODP_TIME_SEC_IN_NS;
+		rate = pcap->mem.bps;
+	} else {
+		return;
+	}
+
+	units += rxq->pace_rem;
+	rxq->pace_ns += units / rate;
+	rxq->pace_rem = units % rate;
+}
+
+/* Read position of an input queue in preload mode */
+typedef struct {
+	uint32_t next;
+	int loop_cnt;
+	uint64_t pace_ns;
+	uint64_t pace_rem;
+	uint64_t ts_base;
+} pcap_rxq_pos_t;
+
+static inline void pcap_mem_pos_save(const pcap_rxq_t *rxq, pcap_rxq_pos_t *pos)
+{
+	pos->next = rxq->next;
+	pos->loop_cnt = rxq->loop_cnt;
+	pos->pace_ns = rxq->pace_ns;
+	pos->pace_rem = rxq->pace_rem;
+	pos->ts_base = rxq->ts_base;
+}
+
+static inline void pcap_mem_pos_restore(pcap_rxq_t *rxq, const pcap_rxq_pos_t *pos)
+{
+	rxq->next = pos->next;
+	rxq->loop_cnt = pos->loop_cnt;
+	rxq->pace_ns = pos->pace_ns;
+	rxq->pace_rem = pos->pace_rem;
+	rxq->ts_base = pos->ts_base;
+}
+
+/* Start the next loop. Returns 0 on success, or <0 when all loops have been
+ * completed. */
+static int pcap_mem_rewind(const pkt_pcap_t *pcap, pcap_rxq_t *rxq)
+{
+	if (rxq->num_rec == 0 || (pcap->loops != 0 && rxq->loop_cnt >= pcap->loops))
+		return -1;
+
+	if (pcap->mem.ts) {
+		uint64_t first_ts = pcap->mem.rec[rxq->rec_idx[0]].ts_ns;
+		uint64_t last_ts = pcap->mem.rec[rxq->rec_idx[rxq->num_rec - 1]].ts_ns;
+
+		/* Next loop starts right after the last packet */
+		if (last_ts > first_ts)
+			rxq->ts_base += last_ts - first_ts;
+	}
+
+	rxq->loop_cnt++;
+	rxq->next = 0;
+
+	return 0;
+}
+
+/* Select up to 'num' packets which are due to be received, and advance the
+ * queue past them. Returns the number of packets selected. */
+static inline int pcap_mem_select(const pkt_pcap_t *pcap, pcap_rxq_t *rxq,
+				  const pcap_rec_t *rec_tbl[], int num, int pacing,
+				  uint64_t now, uint32_t *max_len)
+{
+	int num_sel = 0;
+
+	*max_len = 0;
+
+	while (num_sel < num) {
+		const pcap_rec_t *rec;
+
+		if (odp_unlikely(rxq->next == rxq->num_rec) && pcap_mem_rewind(pcap, rxq))
+			break;
+
+		rec = &pcap->mem.rec[rxq->rec_idx[rxq->next]];
+
+		if (pacing && pcap_mem_due_ns(pcap, rxq, rec) > now)
+			break;
+
+		rxq->next++;
+		pcap_mem_pace(pcap, rxq, rec);
+
+		if (odp_unlikely(rec->promisc_only && !pcap->promisc))
+			continue;
+
+		if (rec->len > *max_len)
+			*max_len = rec->len;
+
+		rec_tbl[num_sel++] = rec;
+	}
+
+	return num_sel;
+}
+
+static int pcapif_recv_mem(pktio_entry_t *pktio_entry, int index,
+			   odp_packet_t pkts[], int num)
+{
+	pkt_pcap_t *pcap = pkt_priv(pktio_entry);
+	pcap_rxq_t *rxq = &pcap->mem.rxq[index];
+	const pcap_rec_t *rec_tbl[QUEUE_MULTI_MAX];
+	const int pacing = pcap_pacing(pcap);
+	const int lockless = pcap->mem.lockless;
+	uint16_t frame_offset = pktio_entry->pktin_frame_offset;
+	const odp_pktin_config_opt_t opt = pktio_entry->config.pktin;
+	odp_time_t ts_val;
+	odp_time_t *ts = NULL;
+	pcap_rxq_pos_t pos;
+	uint64_t now = 0;
+	uint32_t max_len, alloc_len;
+	uint64_t octets = 0;
+	int packets = 0;
+	int num_sel = 0;
+	int num_alloc, i;
+	int num_rx = 0;
+
+	if (odp_unlikely(num > QUEUE_MULTI_MAX))
+		num = QUEUE_MULTI_MAX;
+
+	if (!lockless)
+		odp_ticketlock_lock(&rxq->lock);
+
+	if (pacing) {
+		now = odp_time_global_ns();
+		if (odp_unlikely(rxq->start_ns == 0))
+			rxq->start_ns = now;
+	}
+
+	/* Select packets to be received */
+	pcap_mem_pos_save(rxq, &pos);
+	num_sel = pcap_mem_select(pcap, rxq, rec_tbl, num, pacing, now, &max_len);
+
+	if (num_sel == 0)
+		goto out;
+
+	alloc_len = max_len;
+	num_alloc = _odp_packet_alloc_multi(pcap->pool, alloc_len + frame_offset, pkts, num_sel);
+	if (odp_unlikely(num_alloc < num_sel)) {
+		if (num_alloc < 0)
+			num_alloc = 0;
+
+		/* Packets which could not be allocated are received on the
+		 * next call. Selection is repeated from the saved position, so
+		 * that the queue advances only past the allocated packets. */
+		pcap_mem_pos_restore(rxq, &pos);
+		pcap_mem_select(pcap, rxq, rec_tbl, num_alloc, pacing, now, &max_len);
+	}
+
+	if (opt.bit.ts_all || opt.bit.ts_ptp) {
+		ts_val = odp_time_global();
+		ts = &ts_val;
+	}
+
+	for (i = 0; i < num_alloc; i++) {
+		odp_packet_t pkt = pkts[i];
+		odp_packet_hdr_t *pkt_hdr = packet_hdr(pkt);
+		const uint8_t *data = &pcap->mem.data[rec_tbl[i]->offset];
+		uint32_t pkt_len = rec_tbl[i]->len;
+		uint32_t trunc_len = alloc_len - pkt_len;
+
+		if (frame_offset)
+			pull_head(pkt_hdr, frame_offset);
+
+		/* Packets were allocated with the maximum length of the burst */
+		if (trunc_len) {
+			if (odp_likely(trunc_len <= packet_last_seg(pkt_hdr)->seg_len)) {
+				pull_tail(pkt_hdr, trunc_len);
+			} else if (odp_packet_trunc_tail(&pkt, trunc_len, NULL, NULL) < 0) {
+				odp_packet_free(pkt);
+				odp_atomic_inc_u64(&pktio_entry->stats_extra.in_discards);
+				continue;
+			}
+		}
+
+		if (odp_packet_copy_from_mem(pkt, 0, pkt_len, data) != 0) {
+			ODP_ERR("failed to copy packet data\n");
+			odp_packet_free(pkt);
+			continue;
+		}
+
+		if (pcap_pkt_input(pktio_entry, &pkt, data, pkt_len, ts))
+			continue;
+
+		if (!packet_hdr(pkt)->p.flags.all.error) {
+			octets += pkt_len;
+			packets++;
+		}
+
+		pkts[num_rx++] = pkt;
+	}
+
+	rxq->in_octets += octets;
+	rxq->in_packets += packets;
+
+out:
+	if (!lockless)
+		odp_ticketlock_unlock(&rxq->lock);
+
+	return num_rx;
+}
+
+static int pcapif_recv_pkt(pktio_entry_t *pktio_entry, int index,
 			   odp_packet_t pkts[], int num)
 {
 	int i;
@@ -297,9 +912,11 @@ static int pcapif_recv_pkt(pktio_entry_t *pktio_entry, int index ODP_UNUSED,
 	int packets = 0;
 	uint32_t octets = 0;
 	uint16_t frame_offset = pktio_entry->pktin_frame_offset;
-	const odp_proto_layer_t layer = pktio_entry->parse_layer;
 	const odp_pktin_config_opt_t opt = pktio_entry->config.pktin;
 
+	if (pcap->mem.enable)
+		return pcapif_recv_mem(pktio_entry, index, pkts, num);
+
 	odp_ticketlock_lock(&pktio_entry->rxl);
 
 	if (odp_unlikely(!pcap->rx)) {
@@ -340,43 +957,10 @@ static int pcapif_recv_pkt(pktio_entry_t *pktio_entry, int index ODP_UNUSED,
 			break;
 		}
 
-		if (layer) {
-			ret = _odp_packet_parse_common(pkt_hdr, data, pkt_len,
-						       pkt_len, layer, opt);
-			if (ret)
-				odp_atomic_inc_u64(&pktio_entry->stats_extra.in_errors);
-
-			if (ret < 0) {
-				odp_packet_free(pkt);
-				continue;
-			}
-
-			if (pktio_cls_enabled(pktio_entry)) {
-				odp_pool_t new_pool;
-
-				ret = _odp_cls_classify_packet(pktio_entry, data,
-							       &new_pool, pkt_hdr);
-				if (ret < 0)
-					odp_atomic_inc_u64(&pktio_entry->stats_extra.in_discards);
-
-				if (ret) {
-					odp_packet_free(pkt);
-					continue;
-				}
-
-				if (odp_unlikely(_odp_pktio_packet_to_pool(
-					    &pkt, &pkt_hdr, new_pool))) {
-					odp_packet_free(pkt);
-					odp_atomic_inc_u64(&pktio_entry->stats_extra.in_discards);
-					continue;
-				}
-			}
-		}
-
-		packet_set_ts(pkt_hdr, ts);
-		pkt_hdr->input = pktio_entry->handle;
+		if (pcap_pkt_input(pktio_entry, &pkt, data, pkt_len, ts))
+			continue;
 
-		if (!pkt_hdr->p.flags.all.error) {
+		if (!packet_hdr(pkt)->p.flags.all.error) {
 			octets += pkt_len;
 			packets++;
 		}
@@ -478,12 +1062,14 @@ static int pcapif_mac_addr_get(pktio_entry_t *pktio_entry ODP_UNUSED,
 	return _ODP_ETHADDR_LEN;
 }
 
-static int pcapif_capability(pktio_entry_t *pktio_entry ODP_UNUSED,
+static int pcapif_capability(pktio_entry_t *pktio_entry,
 			     odp_pktio_capability_t *capa)
 {
+	pkt_pcap_t *pcap = pkt_priv(pktio_entry);
+
 	memset(capa, 0, sizeof(odp_pktio_capability_t));
 
-	capa->max_input_queues  = 1;
+	capa->max_input_queues  = pcap->mem.enable ? PKTIO_MAX_QUEUES : 1;
 	capa->max_output_queues = 1;
 	capa->set_op.op.promisc_mode = 1;
 	capa->set_op.op.maxlen = 1;
@@ -517,17 +1103,52 @@ static int pcapif_promisc_mode_get(pktio_entry_t *pktio_entry)
 
 static int pcapif_stats_reset(pktio_entry_t *pktio_entry)
 {
+	pkt_pcap_t *pcap = pkt_priv(pktio_entry);
+
 	memset(&pktio_entry->stats, 0, sizeof(odp_pktio_stats_t));
+
+	for (int i = 0; pcap->mem.rxq && i < PKTIO_MAX_QUEUES; i++) {
+		pcap->mem.rxq[i].in_octets = 0;
+		pcap->mem.rxq[i].in_packets = 0;
+	}
+
 	return 0;
 }
 
 static int pcapif_stats(pktio_entry_t *pktio_entry,
 			odp_pktio_stats_t *stats)
 {
+	pkt_pcap_t *pcap = pkt_priv(pktio_entry);
+
 	memcpy(stats, &pktio_entry->stats, sizeof(odp_pktio_stats_t));
+
+	/* Preload mode counts received packets per input queue */
+	for (int i = 0; pcap->mem.rxq && i < PKTIO_MAX_QUEUES; i++) {
+		stats->in_octets += pcap->mem.rxq[i].in_octets;
+		stats->in_packets += pcap->mem.rxq[i].in_packets;
+	}
+
 	return 0;
 }
 
+static int pcapif_input_queues_config(pktio_entry_t *pktio_entry,
+				      const odp_pktin_queue_param_t *param)
+{
+	pkt_pcap_t *pcap = pkt_priv(pktio_entry);
+	odp_pktin_mode_t mode = pktio_entry->param.in_mode;
+
+	/* Scheduler synchronizes input queue polls. Only single thread
+	 * at a time polls a queue */
+	pcap->mem.lockless = mode == ODP_PKTIN_MODE_SCHED ||
+			     param->op_mode == ODP_PKTIO_OP_MT_UNSAFE;
+
+	if (!pcap->mem.enable || !pcap->rx)
+		return 0;
+
+	return pcap_mem_queues_config(pcap, param->classifier_enable ? 1 : param->num_queues,
+				      param->hash_enable, param->hash_proto);
+}
+
 static int pcapif_init_global(void)
 {
 	ODP_PRINT("PKTIO: initialized pcap interface.\n");
@@ -576,7 +1197,7 @@ const pktio_if_ops_t _odp_pcap_pktio_ops = {
 	.pktio_ts_from_ns = NULL,
 	.pktio_time = NULL,
 	.config = NULL,
-	.input_queues_config = NULL,
+	.input_queues_config = pcapif_input_queues_config,
 	.output_queues_config = NULL,
 	.link_status = pcapif_link_status,
 	.link_info = pcapif_link_info
@@ -25,6 +25,7 @@ typedef struct test_options_t {
 	odp_nonblocking_t nonblock;
 	int single;
 	int num_cpu;
+	int queue_type;
 
 } test_options_t;
 
@@ -52,7 +53,7 @@ typedef struct test_global_t {
 static void print_usage(void)
 {
 	printf("\n"
-	       "Plain queue performance test\n"
+	       "Plain and scheduled queue performance test\n"
 	       "\n"
 	       "Usage: odp_queue_perf [options]\n"
 	       "\n"
@@ -64,6 +65,9 @@ static void print_usage(void)
 	       "  -l, --lockfree         Lockfree queues\n"
 	       "  -w, --waitfree         Waitfree queues\n"
 	       "  -s, --single           Single producer, single consumer\n"
+	       "  -t, --type             Queue type. Scheduled queues are dequeued with odp_schedule_multi()\n"
+	       "                         and events are enqueued back to the source queue.\n"
+	       "                         0: plain (default), 1: scheduled parallel, 2: scheduled atomic\n"
 	       "  -h, --help             This help\n"
 	       "\n");
 }
@@ -83,11 +87,12 @@ static int parse_options(int argc, char *argv[], test_options_t *test_options)
 		{"lockfree",   no_argument,       NULL, 'l'},
 		{"waitfree",   no_argument,       NULL, 'w'},
 		{"single",     no_argument,       NULL, 's'},
+		{"type",       required_argument, NULL, 't'},
 		{"help",       no_argument,       NULL, 'h'},
 		{NULL, 0, NULL, 0}
 	};
 
-	static const char *shortopts = "+c:q:e:b:r:lwsh";
+	static const char *shortopts = "+c:q:e:b:r:lwst:h";
 
 	test_options->num_cpu   = 1;
 	test_options->num_queue = 1;
@@ -96,6 +101,7 @@ static int parse_options(int argc, char *argv[], test_options_t *test_options)
 	test_options->num_round = 1000;
 	test_options->nonblock  = ODP_BLOCKING;
 	test_options->single    = 0;
+	test_options->queue_type = 0;
 
 	while (1) {
 		opt = getopt_long(argc, argv, shortopts, longopts, &long_index);
@@ -128,6 +134,9 @@ static int parse_options(int argc, char *argv[], test_options_t *test_options)
 		case 's':
 			test_options->single = 1;
 			break;
+		case 't':
+			test_options->queue_type = atoi(optarg);
+			break;
 		case 'h':
 			/* fall through */
 		default:
@@ -137,6 +146,11 @@ static int parse_options(int argc, char *argv[], test_options_t *test_options)
 		}
 	}
 
+	if (test_options->queue_type < 0 || test_options->queue_type > 2) {
+		printf("Bad queue type %i\n", test_options->queue_type);
+		return -1;
+	}
+
 	if (test_options->num_queue > MAX_QUEUES) {
 		printf("Too many queues %u. Test maximum %u.\n",
 		       test_options->num_queue, MAX_QUEUES);
@@ -150,6 +164,7 @@ static int create_queues(test_global_t *global)
 {
 	odp_pool_capability_t pool_capa;
 	odp_queue_capability_t queue_capa;
+	odp_schedule_capability_t sched_capa;
 	odp_pool_param_t pool_param;
 	odp_queue_param_t queue_param;
 	odp_pool_t pool;
@@ -161,13 +176,15 @@ static int create_queues(test_global_t *global)
 	uint32_t num_round = test_options->num_round;
 	uint32_t tot_event = num_queue * num_event;
 	int ret = 0;
+	int sched = test_options->queue_type != 0;
 	odp_queue_t *queue = global->queue;
 	odp_event_t event[tot_event];
 
-	printf("\nTesting %s queues\n",
+	printf("\nTesting %s %s queues\n",
 	       nonblock == ODP_BLOCKING ? "NORMAL" :
 	       (nonblock == ODP_NONBLOCKING_LF ? "LOCKFREE" :
-	       (nonblock == ODP_NONBLOCKING_WF ? "WAITFREE" : "???")));
+	       (nonblock == ODP_NONBLOCKING_WF ? "WAITFREE" : "???")),
+	       !sched ? "PLAIN" : (test_options->queue_type == 1 ? "PARALLEL" : "ATOMIC"));
 	printf("  num rounds           %u\n", num_round);
 	printf("  num queues           %u\n", num_queue);
 	printf("  num events per queue %u\n", num_event);
@@ -189,7 +206,31 @@ static int create_queues(test_global_t *global)
 		return -1;
 	}
 
-	if (nonblock == ODP_BLOCKING) {
+	if (sched) {
+		if (odp_schedule_capability(&sched_capa)) {
+			printf("Error: Schedule capa failed.\n");
+			return -1;
+		}
+
+		if (num_queue > sched_capa.max_queues) {
+			printf("Max scheduled queues supported %u\n", sched_capa.max_queues);
+			return -1;
+		}
+
+		max_size = sched_capa.max_queue_size;
+		if (max_size && num_event > max_size) {
+			printf("Max scheduled queue size supported %u\n", max_size);
+			return -1;
+		}
+
+		if ((nonblock == ODP_NONBLOCKING_LF &&
+		     sched_capa.lockfree_queues == ODP_SUPPORT_NO) ||
+		    (nonblock == ODP_NONBLOCKING_WF &&
+		     sched_capa.waitfree_queues == ODP_SUPPORT_NO)) {
+			printf("Non-blocking scheduled queues not supported\n");
+			return -1;
+		}
+	} else if (nonblock == ODP_BLOCKING) {
 		if (num_queue > queue_capa.plain.max_num) {
 			printf("Max queues supported %u\n",
 			       queue_capa.plain.max_num);
@@ -267,6 +308,12 @@ static int create_queues(test_global_t *global)
 	queue_param.nonblocking = nonblock;
 	queue_param.size        = num_event;
 
+	if (sched) {
+		queue_param.type = ODP_QUEUE_TYPE_SCHED;
+		queue_param.sched.sync = test_options->queue_type == 1 ?
+					 ODP_SCHED_SYNC_PARALLEL : ODP_SCHED_SYNC_ATOMIC;
+	}
+
 	if (test_options->single) {
 		queue_param.enq_mode = ODP_QUEUE_OP_MT_UNSAFE;
 		queue_param.deq_mode = ODP_QUEUE_OP_MT_UNSAFE;
@@ -326,13 +373,21 @@ static int destroy_queues(test_global_t *global)
 	odp_queue_t *queue = global->queue;
 	odp_pool_t pool    = global->pool;
 
+	/* Free events from scheduled queues */
+	if (test_options->queue_type) {
+		uint64_t wait = odp_schedule_wait_time(100 * ODP_TIME_MSEC_IN_NS);
+
+		while ((ev = odp_schedule(NULL, wait)) != ODP_EVENT_INVALID)
+			odp_event_free(ev);
+	}
+
 	for (i = 0; i < num_queue; i++) {
 		if (queue[i] == ODP_QUEUE_INVALID) {
 			printf("Error: Invalid queue handle (i: %u).\n", i);
 			break;
 		}
 
-		for (j = 0; j < num_event; j++) {
+		for (j = 0; j < num_event && !test_options->queue_type; j++) {
 			ev = odp_queue_deq(queue[i]);
 
 			if (ev != ODP_EVENT_INVALID)
@@ -421,6 +476,77 @@ error:
 	return ret;
 }
 
+static int run_test_sched(void *arg)
+{
+	uint64_t c1, c2, cycles, nsec;
+	odp_time_t t1, t2;
+	uint32_t rounds;
+	int num_ev;
+	test_stat_t *stat;
+	test_global_t *global = arg;
+	test_options_t *test_options = &global->options;
+	odp_queue_t queue;
+	uint64_t num_retry = 0;
+	uint64_t events = 0;
+	uint32_t num_round = test_options->num_round;
+	int thr = odp_thread_id();
+	int ret = 0;
+	uint32_t max_burst = test_options->max_burst;
+	odp_event_t ev[max_burst];
+
+	stat = &global->stat[thr];
+
+	/* Start all workers at the same time */
+	odp_barrier_wait(&global->barrier);
+
+	t1 = odp_time_local();
+	c1 = odp_cpu_cycles();
+
+	for (rounds = 0; rounds < num_round; rounds++) {
+		do {
+			num_ev = odp_schedule_multi(&queue, ODP_SCHED_NO_WAIT, ev, max_burst);
+
+			if (odp_unlikely(num_ev <= 0))
+				num_retry++;
+
+		} while (num_ev <= 0);
+
+		if (odp_queue_enq_multi(queue, ev, num_ev) != num_ev) {
+			printf("Error: Queue enq failed\n");
+			ret = -1;
+			goto error;
+		}
+
+		events += num_ev;
+	}
+
+	c2 = odp_cpu_cycles();
+	t2 = odp_time_local();
+
+	nsec   = odp_time_diff_ns(t2, t1);
+	cycles = odp_cpu_cycles_diff(c2, c1);
+
+	stat->rounds = rounds;
+	stat->events = events;
+	stat->nsec   = nsec;
+	stat->cycles = cycles;
+	stat->deq_retry = num_retry;
+
+error:
+	/* Return locally pre-scheduled events back to queues */
+	odp_schedule_pause();
+
+	while ((num_ev = odp_schedule_multi(&queue, ODP_SCHED_NO_WAIT, ev, max_burst)) > 0) {
+		if (odp_queue_enq_multi(queue, ev, num_ev) != num_ev) {
+			printf("Error: Queue enq failed\n");
+			ret = -1;
+			break;
+		}
+	}
+
+	return ret;
+}
+
 static int start_workers(test_global_t *global)
 {
 	odph_thread_common_param_t thr_common;
@@ -453,7 +579,7 @@ static int start_workers(test_global_t *global)
 	thr_common.share_param = 1;
 
 	odph_thread_param_init(&thr_param);
-	thr_param.start = run_test;
+	thr_param.start = test_options->queue_type ? run_test_sched : run_test;
 	thr_param.arg = global;
 	thr_param.thr_type = ODP_THREAD_WORKER;
 
@@ -551,7 +677,6 @@ int main(int argc, char **argv)
 	init.not_used.feat.compress = 1;
 	init.not_used.feat.crypto   = 1;
 	init.not_used.feat.ipsec    = 1;
-	init.not_used.feat.schedule = 1;
 	init.not_used.feat.timer    = 1;
 	init.not_used.feat.tm       = 1;
 
@@ -590,6 +715,11 @@ int main(int argc, char **argv)
 
 	global->instance = instance;
 
+	if (global->options.queue_type && odp_schedule_config(NULL)) {
+		printf("Error: Schedule config failed.\n");
+		return -1;
+	}
+
 	if (create_queues(global)) {
 		printf("Error: Create queues failed.\n");
 		goto destroy;
@@ -1091,6 +1091,7 @@ static int test_sched(void *arg)
 		if (test_options->verbose) {
 			odp_queue_print_all();
 			odp_schedule_print();
+			odp_schedule_stats_print();
 		}
 
 		while ((event = odp_schedule(NULL, sched_wait)) != ODP_EVENT_INVALID)
@@ -17,6 +17,7 @@
 
 #define MODE_SCHED_OVERH  0
 #define MODE_SET_CANCEL   1
+#define MODE_ALLOC_FREE   2
 #define MAX_TIMER_POOLS   32
 #define MAX_TIMERS        10000
 #define START_NS          (100 * ODP_TIME_MSEC_IN_NS)
@@ -30,6 +31,7 @@ typedef struct test_options_t {
 	int      shared;
 	int      mode;
 	uint64_t test_rounds;
+	uint32_t burst;
 
 } test_options_t;
 
@@ -48,6 +50,7 @@ typedef struct test_stat_t {
 
 	uint64_t cancels;
 	uint64_t sets;
+	uint64_t allocs;
 
 	time_stat_t before;
 	time_stat_t after;
@@ -62,6 +65,7 @@ typedef struct test_stat_sum_t {
 
 	uint64_t cancels;
 	uint64_t sets;
+	uint64_t allocs;
 
 	time_stat_t before;
 	time_stat_t after;
@@ -131,8 +135,11 @@ static void print_usage(void)
 	       "  -m, --mode             Select test mode. Default: 0\n"
 	       "                           0: Measure odp_schedule() overhead when using timers\n"
 	       "                           1: Measure timer set + cancel performance\n"
-	       "  -R, --rounds           Number of test rounds in timer set + cancel test.\n"
-	       "                           Default: 100000\n"
+	       "                           2: Measure timer alloc + free performance\n"
+	       "  -R, --rounds           Number of test rounds in timer set + cancel, and alloc + free\n"
+	       "                         tests. Default: 100000\n"
+	       "  -b, --burst            Number of timers per cancel and start call in timer set + cancel\n"
+	       "                         test. Multi-timer calls are used when larger than 1. Default: 1\n"
 	       "  -h, --help             This help\n"
 	       "\n");
 }
@@ -152,11 +159,12 @@ static int parse_options(int argc, char *argv[], test_options_t *test_options)
 		{"shared",    required_argument, NULL, 's'},
 		{"mode",      required_argument, NULL, 'm'},
 		{"rounds",    required_argument, NULL, 'R'},
+		{"burst",     required_argument, NULL, 'b'},
 		{"help",      no_argument,       NULL, 'h'},
 		{NULL, 0, NULL, 0}
 	};
 
-	static const char *shortopts = "+c:n:t:r:p:s:m:R:h";
+	static const char *shortopts = "+c:n:t:r:p:s:m:R:b:h";
 
 	test_options->num_cpu   = 1;
 	test_options->num_tp    = 1;
@@ -166,6 +174,7 @@ static int parse_options(int argc, char *argv[], test_options_t *test_options)
 	test_options->shared    = 1;
 	test_options->mode      = 0;
 	test_options->test_rounds = 100000;
+	test_options->burst     = 1;
 
 	while (1) {
 		opt = getopt_long(argc, argv, shortopts, longopts, &long_index);
@@ -198,6 +207,9 @@ static int parse_options(int argc, char *argv[], test_options_t *test_options)
 		case 'R':
 			test_options->test_rounds = atoll(optarg);
 			break;
+		case 'b':
+			test_options->burst = atoi(optarg);
+			break;
 		case 'h':
 			/* fall through */
 		default:
@@ -212,6 +224,11 @@ static int parse_options(int argc, char *argv[], test_options_t *test_options)
 		ret = -1;
 	}
 
+	if (test_options->burst == 0 || test_options->burst > MAX_TIMERS) {
+		ODPH_ERR("Bad burst size. Max %u\n", MAX_TIMERS);
+		ret = -1;
+	}
+
 	return ret;
 }
 
@@ -297,6 +314,8 @@ static int create_timer_pools(test_global_t *global)
 		printf("  test duration    %.2f sec\n", (double)max_tmo_ns / ODP_TIME_SEC_IN_NS);
 	else
 		printf("  test rounds      %" PRIu64 "\n", test_options->test_rounds);
+	if (mode == MODE_SET_CANCEL)
+		printf("  burst size       %u\n", test_options->burst);
 
 	for (i = 0; i < MAX_TIMER_POOLS; i++) {
 		global->timer_pool[i].tp = ODP_TIMER_POOL_INVALID;
@@ -645,6 +664,45 @@ static void cancel_timers(test_global_t *global, uint32_t worker_idx)
 	}
 }
 
+/* Cancel timers and set those again with multi-timer calls */
+static int cancel_set_multi(odp_timer_t timer[], uint32_t timer_idx[], uint32_t num,
+			    uint64_t tick, uint64_t period_tick, test_stat_t *stat)
+{
+	odp_event_t ev[num];
+	odp_timer_t start_timer[num];
+	odp_timer_start_t start_param[num];
+	uint32_t i;
+	int num_start = 0;
+	int ret;
+
+	odp_timer_cancel_multi(timer, ev, num);
+	stat->cancels += num;
+
+	for (i = 0; i < num; i++) {
+		if (ev[i] == ODP_EVENT_INVALID)
+			continue;
+
+		start_timer[num_start] = timer[i];
+		start_param[num_start].tick_type = ODP_TIMER_TICK_ABS;
+		start_param[num_start].tick      = tick + timer_idx[i] * period_tick;
+		start_param[num_start].tmo_ev    = ev[i];
+		num_start++;
+	}
+
+	if (num_start == 0)
+		return 0;
+
+	ret = odp_timer_start_multi(start_timer, start_param, num_start);
+	stat->sets += num_start;
+
+	if (ret != num_start) {
+		ODPH_ERR("Timer start multi failed (ret %i)\n", ret);
+		return -1;
+	}
+
+	return 0;
+}
+
 static int set_cancel_mode_worker(void *arg)
 {
 	uint64_t tick, start_tick, period_tick, nsec;
@@ -668,7 +726,13 @@ static int set_cancel_mode_worker(void *arg)
 	uint64_t num_tmo = 0;
 	uint64_t num_cancel = 0;
 	uint64_t num_set = 0;
+	uint32_t burst = test_options->burst;
+	odp_timer_t burst_timer[burst];
+	uint32_t burst_idx[burst];
+	uint32_t num_burst;
+	test_stat_t burst_stat;
 
+	memset(&burst_stat, 0, sizeof(test_stat_t));
 	thr = odp_thread_id();
 	worker_idx = thread_arg->worker_idx;
 	t1 = ODP_TIME_NULL;
@@ -732,6 +796,42 @@ static int set_cancel_mode_worker(void *arg)
 
 			tick = odp_timer_current_tick(tp) + start_tick;
 
+			if (burst > 1) {
+				num_burst = 0;
+
+				for (j = 0; j < num_timer; j++) {
+					if ((j % num_worker) != worker_idx)
+						continue;
+
+					timer = global->timer[i][j];
+					if (timer == ODP_TIMER_INVALID)
+						continue;
+
+					burst_timer[num_burst] = timer;
+					burst_idx[num_burst] = j;
+					num_burst++;
+
+					if (num_burst < burst)
+						continue;
+
+					ret = cancel_set_multi(burst_timer, burst_idx, num_burst, tick,
+							       period_tick, &burst_stat);
+					num_burst = 0;
+
+					if (ret)
+						break;
+				}
+
+				if (num_burst && ret == 0)
+					ret = cancel_set_multi(burst_timer, burst_idx, num_burst, tick,
+							       period_tick, &burst_stat);
+
+				if (ret)
+					break;
+
+				continue;
+			}
+
 			for (j = 0; j < num_timer; j++) {
 				if ((j % num_worker) != worker_idx)
 					continue;
@@ -779,8 +879,95 @@ static int set_cancel_mode_worker(void *arg)
 	global->stat[thr].nsec   = nsec;
 	global->stat[thr].cycles = diff;
 
-	global->stat[thr].cancels = num_cancel;
-	global->stat[thr].sets    = num_set;
+	global->stat[thr].cancels = num_cancel + burst_stat.cancels;
+	global->stat[thr].sets    = num_set + burst_stat.sets;
+
+	return ret;
+}
+
+static int alloc_free_mode_worker(void *arg)
+{
+	uint64_t c1, c2, nsec;
+	int thr;
+	uint32_t i, j, worker_idx;
+	odp_time_t t1, t2;
+	odp_timer_t timer;
+	odp_timer_pool_t tp;
+	odp_queue_t queue;
+	odp_event_t ev;
+	thread_arg_t *thread_arg = arg;
+	test_global_t *global = thread_arg->global;
+	test_options_t *test_options = &global->test_options;
+	uint32_t num_tp = test_options->num_tp;
+	uint32_t num_timer = test_options->num_timer;
+	uint32_t num_worker = test_options->num_cpu;
+	uint64_t test_rounds = test_options->test_rounds;
+	uint64_t rounds = 0;
+	uint64_t num_alloc = 0;
+	int ret = 0;
+
+	thr = odp_thread_id();
+	worker_idx = thread_arg->worker_idx;
+
+	/* Start all workers at the same time */
+	odp_barrier_wait(&global->barrier);
+
+	t1 = odp_time_local();
+	c1 = odp_cpu_cycles();
+
+	while (rounds < test_rounds && ret == 0) {
+		if (odp_unlikely(odp_atomic_load_u32(&global->exit_test)))
+			break;
+
+		/* Allocate all timers of this thread, and free those after that */
+		for (i = 0; i < num_tp; i++) {
+			tp    = global->timer_pool[i].tp;
+			queue = global->queue[i];
+
+			for (j = worker_idx; j < num_timer; j += num_worker) {
+				timer = odp_timer_alloc(tp, queue, &global->timer_ctx[i][j]);
+
+				if (timer == ODP_TIMER_INVALID) {
+					ODPH_ERR("Timer (%u/%u) alloc failed\n", i, j);
+					ret = -1;
+					break;
+				}
+
+				global->timer[i][j] = timer;
+				num_alloc++;
+			}
+
+			for (j = worker_idx; j < num_timer; j += num_worker) {
+				timer = global->timer[i][j];
+
+				if (timer == ODP_TIMER_INVALID)
+					break;
+
+				ev = odp_timer_free(timer);
+				global->timer[i][j] = ODP_TIMER_INVALID;
+
+				if (ev != ODP_EVENT_INVALID) {
+					ODPH_ERR("Timer (%u/%u) free returned an event\n", i, j);
+					odp_event_free(ev);
+				}
+			}
+
+			if (ret)
+				break;
+		}
+
+		rounds++;
+	}
+
+	c2 = odp_cpu_cycles();
+	t2 = odp_time_local();
+	nsec = odp_time_diff_ns(t2, t1);
+
+	/* Update stats */
+	global->stat[thr].rounds = rounds;
+	global->stat[thr].nsec   = nsec;
+	global->stat[thr].cycles = odp_cpu_cycles_diff(c2, c1);
+	global->stat[thr].allocs = num_alloc;
 
 	return ret;
 }
@@ -804,8 +991,10 @@ static int start_workers(test_global_t *global, odp_instance_t instance)
 
 		if (test_options->mode == MODE_SCHED_OVERH)
 			thr_param[i].start = sched_mode_worker;
-		else
+		else if (test_options->mode == MODE_SET_CANCEL)
 			thr_param[i].start = set_cancel_mode_worker;
+		else
+			thr_param[i].start = alloc_free_mode_worker;
 
 		thr_param[i].arg      = &global->thread_arg[i];
 		thr_param[i].thr_type = ODP_THREAD_WORKER;
@@ -840,6 +1029,7 @@ static void sum_stat(test_global_t *global)
 		sum->nsec    += global->stat[i].nsec;
 		sum->cancels += global->stat[i].cancels;
 		sum->sets    += global->stat[i].sets;
+		sum->allocs  += global->stat[i].allocs;
 
 		sum->before.num    += global->stat[i].before.num;
 		sum->before.sum_ns += global->stat[i].before.sum_ns;
@@ -942,6 +1132,44 @@ static void print_stat_set_cancel_mode(test_global_t *global)
 	printf("\n");
 }
 
+static void print_stat_alloc_free_mode(test_global_t *global)
+{
+	int i;
+	test_stat_sum_t *sum = &global->stat_sum;
+	double alloc_ave = 0.0;
+	int num = 0;
+
+	printf("\n");
+	printf("RESULTS - timer alloc + free cycles per thread:\n");
+	printf("-----------------------------------------------\n");
+	printf("        1      2      3      4      5      6      7      8      9     10");
+
+	for (i = 0; i < ODP_THREAD_COUNT_MAX; i++) {
+		if (global->stat[i].rounds) {
+			if ((num % 10) == 0)
+				printf("\n   ");
+
+			if (global->stat[i].allocs)
+				printf("%6.1f ", (double)global->stat[i].cycles / global->stat[i].allocs);
+			else
+				printf("%6.1f ", 0.0);
+
+			num++;
+		}
+	}
+
+	if (sum->num)
+		alloc_ave = (double)sum->allocs / sum->num;
+
+	printf("\n\n");
+	printf("TOTAL (%i workers)\n", sum->num);
+	printf("  rounds:              %" PRIu64 "\n", sum->rounds);
+	printf("  timer allocs:        %" PRIu64 "\n", sum->allocs);
+	printf("  ave time:            %.2f sec\n", sum->time_ave);
+	printf("  alloc+free per cpu:  %.2fM per sec\n", (alloc_ave / sum->time_ave) / 1000000.0);
+	printf("\n");
+}
+
 static void sig_handler(int signo)
 {
 	(void)signo;
@@ -1043,8 +1271,11 @@ int main(int argc, char **argv)
 		odp_time_wait_ns(ODP_TIME_MSEC_IN_NS);
 	}
 
-	/* Set timers. Force workers to exit on failure. */
-	if (set_timers(global))
+	/* Set timers. Force workers to exit on failure. Alloc + free test allocates timers
+	 * in workers. */
+	if (mode == MODE_ALLOC_FREE)
+		odp_atomic_store_rel_u32(&global->timers_started, 1);
+	else if (set_timers(global))
 		odp_atomic_add_u32(&global->exit_test, MAX_TIMER_POOLS);
 	else
 		odp_atomic_store_rel_u32(&global->timers_started, 1);
@@ -1056,11 +1287,16 @@ int main(int argc, char **argv)
 				ODPH_ERR("Sched_mode_worker failed\n");
 				return -1;
 			}
-		} else {
+		} else if (mode == MODE_SET_CANCEL) {
 			if (set_cancel_mode_worker(&global->thread_arg[0])) {
 				ODPH_ERR("Set_cancel_mode_worker failed\n");
 				return -1;
 			}
+		} else {
+			if (alloc_free_mode_worker(&global->thread_arg[0])) {
+				ODPH_ERR("Alloc_free_mode_worker failed\n");
+				return -1;
+			}
 		}
 	} else {
 		/* Wait workers to exit */
@@ -1072,8 +1308,10 @@ int main(int argc, char **argv)
 
 	if (mode == MODE_SCHED_OVERH)
 		print_stat_sched_mode(global);
-	else
+	else if (mode == MODE_SET_CANCEL)
 		print_stat_set_cancel_mode(global);
+	else
+		print_stat_alloc_free_mode(global);
 
 	destroy_timer_pool(global);
 
@@ -30,4 +30,26 @@ if [ $RET_VAL -ne 0 ]; then
 	exit $RET_VAL
 fi
 
+echo odp_timer_perf: timer set + cancel mode with multi-timer calls
+echo ===============================================
+
+$TEST_DIR/odp_timer_perf${EXEEXT} -m 1 -c 1 -t 10 -R 50 -b 4
+
+RET_VAL=$?
+if [ $RET_VAL -ne 0 ]; then
+	echo odp_timer_perf -m 1 -b 4: FAILED
+	exit $RET_VAL
+fi
+
+echo odp_timer_perf: timer alloc + free mode
+echo ===============================================
+
+$TEST_DIR/odp_timer_perf${EXEEXT} -m 2 -c 1 -t 100 -R 1000
+
+RET_VAL=$?
+if [ $RET_VAL -ne 0 ]; then
+	echo odp_timer_perf -m 2: FAILED
+	exit $RET_VAL
+fi
+
 exit 0
@@ -1905,6 +1905,65 @@ static void test_in_ipv4_esp_reass_success_four_frags_ooo(odp_ipsec_sa_t out_sa,
 			  ODP_PACKET_REASS_COMPLETE);
 }
 
+/*
+ * Fragments of two datagrams interleaved on the same SA. The second datagram
+ * completes before the first one.
+ */
+static void test_in_ipv4_esp_reass_success_interleaved(odp_ipsec_sa_t out_sa,
+						       odp_ipsec_sa_t in_sa)
+{
+	ipsec_test_packet *input_packets[] = {
+		&pkt_ipv4_udp_p1_f1,
+		&pkt_ipv4_udp_p2_f1,
+		&pkt_ipv4_udp_p2_f2,
+		&pkt_ipv4_udp_p2_f3,
+		&pkt_ipv4_udp_p2_f4,
+		&pkt_ipv4_udp_p1_f2,
+	};
+	/* Datagram of each input packet */
+	const int dgram[] = { 0, 1, 1, 1, 1, 0 };
+	ipsec_test_packet *result_packets[] = {
+		&pkt_ipv4_udp_p1,
+		&pkt_ipv4_udp_p2,
+	};
+	const int num_frags[] = { 2, 4 };
+	uint32_t orig_ip_len[] = { 0, 0 };
+	int num_seen[] = { 0, 0 };
+	uint32_t i;
+
+	for (i = 0; i < ARRAY_SIZE(input_packets); i++) {
+		ipsec_test_part test_out;
+		ipsec_test_part test_in;
+		ipsec_test_packet test_pkt;
+		odp_packet_t pkt = ODP_PACKET_INVALID;
+		int d = dgram[i];
+		uint32_t l3_off;
+
+		part_prep_esp(&test_out, 1, false);
+		test_out.pkt_in = input_packets[i];
+		CU_ASSERT_EQUAL(ipsec_check_out(&test_out, out_sa, &pkt), 1);
+
+		l3_off = odp_packet_l3_offset(pkt);
+		CU_ASSERT(ODP_PACKET_OFFSET_INVALID != l3_off);
+		orig_ip_len[d] += odp_packet_len(pkt) - l3_off;
+
+		/* Expect a result packet only for the last fragment of each
+		 * datagram */
+		memset(&test_in, 0, sizeof(test_in));
+		if (++num_seen[d] == num_frags[d]) {
+			part_prep_plain(&test_in, 1, false, true);
+			test_in.out[0].pkt_res = result_packets[d];
+			test_in.out[0].reass_status = ODP_PACKET_REASS_COMPLETE;
+			test_in.out[0].num_frags = num_frags[d];
+			test_in.out[0].orig_ip_len = orig_ip_len[d];
+		}
+		ipsec_test_packet_from_pkt(&test_pkt, &pkt);
+		test_in.pkt_in = &test_pkt;
+
+		ipsec_check_in_one(&test_in, in_sa);
+	}
+}
+
 static void test_in_ipv4_esp_reass_incomp_missing(odp_ipsec_sa_t out_sa,
 						  odp_ipsec_sa_t in_sa)
 {
@@ -1969,6 +2028,9 @@ static void test_in_ipv4_esp_reass_success(void)
 	printf("\n	IPv4 four frags out of order");
 	test_in_ipv4_esp_reass_success_four_frags_ooo(out_sa, in_sa);
 
+	printf("\n	IPv4 interleaved datagrams");
+	test_in_ipv4_esp_reass_success_interleaved(out_sa, in_sa);
+
 	printf("\n");
 
 	ipsec_sa_destroy(in_sa);
@@ -7,6 +7,7 @@
 #include <odp_api.h>
 #include <odp_cunit_common.h>
 #include <test_packet_ipv4.h>
+#include <test_packet_ipv6.h>
 #include <test_packet_custom.h>
 
 #include <odp/helper/odph_api.h>
@@ -160,6 +161,11 @@ static odp_pktio_t create_pktio(int idx, const char *name, odp_pool_t pool)
 			config.pktin.bit.ipv4_chksum = 1;
 		else
 			ODPH_DBG("IPv4 checksum not verified\n");
+
+		if (capa->config.pktin.bit.tcp_chksum)
+			config.pktin.bit.tcp_chksum = 1;
+		else
+			ODPH_DBG("TCP checksum not verified\n");
 	}
 
 	if (odp_pktio_config(pktio, &config)) {
@@ -219,7 +225,7 @@ static void pktio_pkt_set_macs(odp_packet_t pkt, odp_pktio_t src, odp_pktio_t ds
 
 static int send_packets(odp_lso_profile_t lso_profile, pktio_info_t *pktio_a, pktio_info_t *pktio_b,
 			const uint8_t *data, uint32_t len, uint32_t hdr_len, uint32_t max_payload,
-			uint32_t l3_offset, int use_opt)
+			uint32_t l3_offset, uint32_t l4_offset, int use_opt)
 {
 	odp_packet_t pkt;
 	int ret;
@@ -256,6 +262,9 @@ static int send_packets(odp_lso_profile_t lso_profile, pktio_info_t *pktio_a, pk
 	if (l3_offset)
 		odp_packet_l3_offset_set(pkt, l3_offset);
 
+	if (l4_offset)
+		odp_packet_l4_offset_set(pkt, l4_offset);
+
 	while (retries) {
 		ret = odp_pktout_send_lso(pktio_a->pktout, &pkt, 1, opt_ptr);
 
@@ -537,6 +546,56 @@ static int check_lso_ipv4_segs_3(void)
 	return check_lso_ipv4_segs(3);
 }
 
+static int check_lso_tcp(int ipv6)
+{
+	if (pktio_a->capa.lso.max_profiles == 0 || pktio_a->capa.lso.max_profiles_per_pktio == 0)
+		return ODP_TEST_INACTIVE;
+
+	if (ipv6 && pktio_a->capa.lso.proto.tcp_ipv6 == 0)
+		return ODP_TEST_INACTIVE;
+
+	if (!ipv6 && pktio_a->capa.lso.proto.tcp_ipv4 == 0)
+		return ODP_TEST_INACTIVE;
+
+	return ODP_TEST_ACTIVE;
+}
+
+static int check_lso_tcp_ipv4(void)
+{
+	return check_lso_tcp(0);
+}
+
+static int check_lso_tcp_ipv6(void)
+{
+	return check_lso_tcp(1);
+}
+
+static int check_lso_tcp_segs_3(int ipv6)
+{
+	if (check_lso_tcp(ipv6) == ODP_TEST_INACTIVE)
+		return ODP_TEST_INACTIVE;
+
+	if (pktio_a->capa.lso.max_segments < 3)
+		return ODP_TEST_INACTIVE;
+
+	if (disable_restart && num_starts > 0)
+		return ODP_TEST_INACTIVE;
+
+	num_starts++;
+
+	return ODP_TEST_ACTIVE;
+}
+
+static int check_lso_tcp_ipv4_segs_3(void)
+{
+	return check_lso_tcp_segs_3(0);
+}
+
+static int check_lso_tcp_ipv6_segs_3(void)
+{
+	return check_lso_tcp_segs_3(1);
+}
+
 static void lso_capability(void)
 {
 	/* LSO not supported when max_profiles is zero */
@@ -578,6 +637,30 @@ static void lso_create_ipv4_profile(void)
 	CU_ASSERT_FATAL(odp_lso_profile_destroy(profile) == 0);
 }
 
+static void lso_create_tcp_profile(odp_lso_protocol_t lso_proto)
+{
+	odp_lso_profile_param_t param;
+	odp_lso_profile_t profile;
+
+	odp_lso_profile_param_init(&param);
+	param.lso_proto = lso_proto;
+
+	profile = odp_lso_profile_create(pktio_a->hdl, &param);
+	CU_ASSERT_FATAL(profile != ODP_LSO_PROFILE_INVALID);
+
+	CU_ASSERT_FATAL(odp_lso_profile_destroy(profile) == 0);
+}
+
+static void lso_create_tcp_ipv4_profile(void)
+{
+	lso_create_tcp_profile(ODP_LSO_PROTO_TCP_IPV4);
+}
+
+static void lso_create_tcp_ipv6_profile(void)
+{
+	lso_create_tcp_profile(ODP_LSO_PROTO_TCP_IPV6);
+}
+
 static void lso_create_custom_profile(void)
 {
 	odp_lso_profile_param_t param_0, param_1;
@@ -684,7 +767,7 @@ static void lso_send_custom_eth(const uint8_t *test_packet, uint32_t pkt_len, ui
 	test_lso_request_clear(profile, test_packet, pkt_len, hdr_len, max_payload);
 
 	ret = send_packets(profile, pktio_a, pktio_b, test_packet, pkt_len, hdr_len,
-			   max_payload, 0, use_opt);
+			   max_payload, 0, 0, use_opt);
 	CU_ASSERT_FATAL(ret == 0);
 
 	ODPH_DBG("\n    Sent payload length:     %u bytes\n", sent_payload);
@@ -809,7 +892,7 @@ static void lso_send_ipv4(const uint8_t *test_packet, uint32_t pkt_len, uint32_t
 	test_lso_request_clear(profile, test_packet, pkt_len, hdr_len, max_payload);
 
 	ret = send_packets(profile, pktio_a, pktio_b, test_packet, pkt_len,
-			   hdr_len, max_payload, 14, use_opt);
+			   hdr_len, max_payload, 14, 0, use_opt);
 	CU_ASSERT_FATAL(ret == 0);
 
 	ODPH_DBG("\n    Sent payload length:     %u bytes\n", sent_payload);
@@ -918,9 +1001,164 @@ static void lso_send_ipv4_1500_700_opt(void)
 	lso_send_ipv4_udp_1500(700, 1);
 }
 
+static void lso_send_tcp(const uint8_t *test_packet, uint32_t pkt_len, uint32_t max_payload,
+			 int ipv6, int use_opt)
+{
+	int i, ret, num, num_seg;
+	odp_lso_profile_param_t param;
+	odp_lso_profile_t profile;
+	uint32_t offset, len, payload_len, payload_sum, seq_no, l3_len;
+	odp_packet_t packet[MAX_NUM_SEG];
+	odph_tcphdr_t *tcp;
+	const odph_tcphdr_t *orig_tcp;
+	uint32_t l3_offset = 14;
+	/* Ethernet 14B + IPv4 header 20B / IPv6 header 40B + TCP header 20B */
+	uint32_t l4_offset = ipv6 ? l3_offset + ODPH_IPV6HDR_LEN : l3_offset + ODPH_IPV4HDR_LEN;
+	uint32_t hdr_len = l4_offset + ODPH_TCPHDR_LEN;
+	uint32_t sent_payload = pkt_len - hdr_len;
+	uint16_t ip_id = 0;
+
+	orig_tcp = (const odph_tcphdr_t *)(uintptr_t)&test_packet[l4_offset];
+
+	odp_lso_profile_param_init(&param);
+	param.lso_proto = ipv6 ? ODP_LSO_PROTO_TCP_IPV6 : ODP_LSO_PROTO_TCP_IPV4;
+
+	profile = odp_lso_profile_create(pktio_a->hdl, &param);
+	CU_ASSERT_FATAL(profile != ODP_LSO_PROFILE_INVALID);
+
+	CU_ASSERT_FATAL(start_interfaces() == 0);
+
+	test_lso_request_clear(profile, test_packet, pkt_len, hdr_len, max_payload);
+
+	ret = send_packets(profile, pktio_a, pktio_b, test_packet, pkt_len,
+			   hdr_len, max_payload, l3_offset, l4_offset, use_opt);
+	CU_ASSERT_FATAL(ret == 0);
+
+	ODPH_DBG("\n    Sent payload length:     %u bytes\n", sent_payload);
+
+	/* Wait 1 sec to receive all created segments. Timeout and MAX_NUM_SEG values should be
+	 * large enough to ensure that we receive all created segments. */
+	num = recv_packets(pktio_b, ODP_TIME_SEC_IN_NS, packet, MAX_NUM_SEG);
+	CU_ASSERT(num > 0);
+	CU_ASSERT(num < MAX_NUM_SEG);
+
+	offset = hdr_len;
+	payload_sum = 0;
+	num_seg = 0;
+	for (i = 0; i < num; i++) {
+		/* Filter out possible non-test packets */
+		if (!odp_packet_has_tcp(packet[i]) ||
+		    odp_packet_l4_offset(packet[i]) != l4_offset)
+			continue;
+
+		tcp = odp_packet_l4_ptr(packet[i], NULL);
+		if (tcp->src_port != orig_tcp->src_port || tcp->dst_port != orig_tcp->dst_port)
+			continue;
+
+		len = odp_packet_len(packet[i]);
+		payload_len = len - hdr_len;
+		l3_len = len - l3_offset;
+
+		ODPH_DBG("    LSO segment[%i] payload:  %u bytes\n", i, payload_len);
+
+		CU_ASSERT(odp_packet_has_error(packet[i]) == 0);
+		CU_ASSERT(payload_len <= max_payload);
+
+		if (ipv6) {
+			odph_ipv6hdr_t *ip = odp_packet_l3_ptr(packet[i], NULL);
+
+			CU_ASSERT(odp_packet_has_ipv6(packet[i]));
+			CU_ASSERT(odp_be_to_cpu_16(ip->payload_len) == l3_len - ODPH_IPV6HDR_LEN);
+		} else {
+			odph_ipv4hdr_t *ip = odp_packet_l3_ptr(packet[i], NULL);
+
+			CU_ASSERT(odp_packet_has_ipv4(packet[i]));
+			CU_ASSERT(odp_packet_has_ipfrag(packet[i]) == 0);
+			CU_ASSERT(odp_be_to_cpu_16(ip->tot_len) == l3_len);
+			CU_ASSERT(odph_ipv4_csum_valid(packet[i]));
+
+			/* IP identification values must differ between segments */
+			if (num_seg)
+				CU_ASSERT(odp_be_to_cpu_16(ip->id) != ip_id);
+			ip_id = odp_be_to_cpu_16(ip->id);
+		}
+
+		CU_ASSERT(odph_tcp_chksum_verify(packet[i]) == 0);
+
+		/* Sequence number of a segment points to its first payload byte */
+		seq_no = odp_be_to_cpu_32(orig_tcp->seq_no) + (offset - hdr_len);
+		CU_ASSERT(odp_be_to_cpu_32(tcp->seq_no) == seq_no);
+		CU_ASSERT(tcp->ack_no == orig_tcp->ack_no);
+		CU_ASSERT(tcp->ack == orig_tcp->ack);
+
+		/* PSH flag of the original packet is set only on the last segment */
+		if (offset + payload_len < pkt_len) {
+			CU_ASSERT(tcp->psh == 0);
+		} else {
+			CU_ASSERT(tcp->psh == orig_tcp->psh);
+		}
+
+		if (compare_data(packet[i], hdr_len, test_packet + offset, payload_len) >= 0) {
+			ODPH_ERR("    Payload compare failed at offset %u\n", offset);
+			CU_FAIL("Payload compare failed\n");
+		}
+
+		offset      += payload_len;
+		payload_sum += payload_len;
+		num_seg++;
+	}
+
+	ODPH_DBG("    Received payload length: %u bytes\n", payload_sum);
+
+	CU_ASSERT(payload_sum == sent_payload);
+	CU_ASSERT(num_seg == (int)((sent_payload + max_payload - 1) / max_payload));
+
+	if (num > 0)
+		odp_packet_free_multi(packet, num);
+
+	CU_ASSERT_FATAL(stop_interfaces() == 0);
+
+	CU_ASSERT_FATAL(odp_lso_profile_destroy(profile) == 0);
+}
+
+static void lso_send_tcp_1500(int ipv6, uint32_t max_payload, int use_opt)
+{
+	const uint8_t *test_packet = ipv6 ? test_packet_ipv6_tcp_1500 : test_packet_ipv4_tcp_1500;
+	uint32_t pkt_len = ipv6 ? sizeof(test_packet_ipv6_tcp_1500) :
+				  sizeof(test_packet_ipv4_tcp_1500);
+
+	if (max_payload > pktio_a->capa.lso.max_payload_len)
+		max_payload = pktio_a->capa.lso.max_payload_len;
+
+	lso_send_tcp(test_packet, pkt_len, max_payload, ipv6, use_opt);
+}
+
+/* At least 3 segments: packet size 1500 bytes, LSO segment payload 500 bytes */
+static void lso_send_tcp_ipv4_1500_500_pkt_meta(void)
+{
+	lso_send_tcp_1500(0, 500, 0);
+}
+
+static void lso_send_tcp_ipv4_1500_500_opt(void)
+{
+	lso_send_tcp_1500(0, 500, 1);
+}
+
+static void lso_send_tcp_ipv6_1500_500_pkt_meta(void)
+{
+	lso_send_tcp_1500(1, 500, 0);
+}
+
+static void lso_send_tcp_ipv6_1500_500_opt(void)
+{
+	lso_send_tcp_1500(1, 500, 1);
+}
+
 odp_testinfo_t lso_suite[] = {
 	ODP_TEST_INFO(lso_capability),
 	ODP_TEST_INFO_CONDITIONAL(lso_create_ipv4_profile, check_lso_ipv4),
+	ODP_TEST_INFO_CONDITIONAL(lso_create_tcp_ipv4_profile, check_lso_tcp_ipv4),
+	ODP_TEST_INFO_CONDITIONAL(lso_create_tcp_ipv6_profile, check_lso_tcp_ipv6),
 	ODP_TEST_INFO_CONDITIONAL(lso_create_custom_profile, check_lso_custom),
 	ODP_TEST_INFO_CONDITIONAL(lso_send_ipv4_325_700_pkt_meta, check_lso_ipv4_segs_1),
 	ODP_TEST_INFO_CONDITIONAL(lso_send_ipv4_325_700_opt, check_lso_ipv4_segs_1),
@@ -928,6 +1166,10 @@ odp_testinfo_t lso_suite[] = {
 	ODP_TEST_INFO_CONDITIONAL(lso_send_ipv4_1500_1000_opt, check_lso_ipv4_segs_2),
 	ODP_TEST_INFO_CONDITIONAL(lso_send_ipv4_1500_700_pkt_meta, check_lso_ipv4_segs_3),
 	ODP_TEST_INFO_CONDITIONAL(lso_send_ipv4_1500_700_opt, check_lso_ipv4_segs_3),
+	ODP_TEST_INFO_CONDITIONAL(lso_send_tcp_ipv4_1500_500_pkt_meta, check_lso_tcp_ipv4_segs_3),
+	ODP_TEST_INFO_CONDITIONAL(lso_send_tcp_ipv4_1500_500_opt, check_lso_tcp_ipv4_segs_3),
+	ODP_TEST_INFO_CONDITIONAL(lso_send_tcp_ipv6_1500_500_pkt_meta, check_lso_tcp_ipv6_segs_3),
+	ODP_TEST_INFO_CONDITIONAL(lso_send_tcp_ipv6_1500_500_opt, check_lso_tcp_ipv6_segs_3),
 	ODP_TEST_INFO_CONDITIONAL(lso_send_custom_eth_723_800_pkt_meta, check_lso_custom_segs_1),
 	ODP_TEST_INFO_CONDITIONAL(lso_send_custom_eth_723_800_opt, check_lso_custom_segs_1),
 	ODP_TEST_INFO_CONDITIONAL(lso_send_custom_eth_723_500_pkt_meta, check_lso_custom_segs_2),
@@ -4557,6 +4557,290 @@ static void pktio_test_pktout_aging_tmo(void)
 	}
 }
 
+#define REASS_PAYLOAD_LEN  1000
+#define REASS_NUM_FRAGS    4
+#define REASS_IP_PROTO     253 /* Experimental */
+
+static int pktio_check_reass(odp_bool_t ipv6)
+{
+	odp_pktio_param_t pktio_param;
+	odp_pktio_capability_t capa;
+	odp_pktio_t pktio;
+	int ret;
+
+	odp_pktio_param_init(&pktio_param);
+	pktio_param.in_mode = ODP_PKTIN_MODE_DIRECT;
+
+	pktio = odp_pktio_open(iface_name[0], pool[0], &pktio_param);
+	if (pktio == ODP_PKTIO_INVALID)
+		return ODP_TEST_INACTIVE;
+
+	ret = odp_pktio_capability(pktio, &capa);
+	(void)odp_pktio_close(pktio);
+
+	if (ret < 0 || capa.reassembly.max_num_frags < REASS_NUM_FRAGS)
+		return ODP_TEST_INACTIVE;
+
+	if (!(ipv6 ? capa.reassembly.ipv6 : capa.reassembly.ipv4))
+		return ODP_TEST_INACTIVE;
+
+	return ODP_TEST_ACTIVE;
+}
+
+static int pktio_check_reass_ipv4(void)
+{
+	return pktio_check_reass(false);
+}
+
+static int pktio_check_reass_ipv6(void)
+{
+	return pktio_check_reass(true);
+}
+
+/* Create a fragment of a datagram with REASS_PAYLOAD_LEN bytes of payload.
+ * Payload byte values are (offset & 0xff). */
+static odp_packet_t reass_frag_create(odp_bool_t ipv6, uint16_t id, uint32_t offset,
+				      uint32_t len, odp_bool_t more)
+{
+	uint8_t src_mac[ODP_PKTIO_MACADDR_MAXSIZE] = PKTIO_SRC_MAC;
+	uint8_t dst_mac[ODP_PKTIO_MACADDR_MAXSIZE] = PKTIO_DST_MAC;
+	uint32_t hdr_len = ODPH_ETHHDR_LEN;
+	odph_ethhdr_t *eth;
+	odp_packet_t pkt;
+	uint8_t *data;
+	uint32_t i;
+
+	hdr_len += ipv6 ? ODPH_IPV6HDR_LEN + 8 : ODPH_IPV4HDR_LEN;
+
+	pkt = odp_packet_alloc(default_pkt_pool, hdr_len + len);
+	CU_ASSERT_FATAL(pkt != ODP_PACKET_INVALID);
+
+	data = odp_packet_data(pkt);
+	eth = (odph_ethhdr_t *)data;
+	memcpy(eth->src.addr, src_mac, ODPH_ETHADDR_LEN);
+	memcpy(eth->dst.addr, dst_mac, ODPH_ETHADDR_LEN);
+
+	if (ipv6) {
+		odph_ipv6hdr_t *ip = (odph_ipv6hdr_t *)(data + ODPH_ETHHDR_LEN);
+		uint8_t *frag = data + ODPH_ETHHDR_LEN + ODPH_IPV6HDR_LEN;
+		odp_u16be_t frag_off = odp_cpu_to_be_16(offset | (more ? 1 : 0));
+		odp_u32be_t frag_id = odp_cpu_to_be_32(id);
+
+		eth->type = odp_cpu_to_be_16(ODPH_ETHTYPE_IPV6);
+		memset(ip, 0, ODPH_IPV6HDR_LEN);
+		ip->ver_tc_flow = odp_cpu_to_be_32(ODPH_IPV6 << ODPH_IPV6HDR_VERSION_SHIFT);
+		ip->payload_len = odp_cpu_to_be_16(8 + len);
+		ip->next_hdr = ODPH_IPPROTO_FRAG;
+		ip->hop_limit = 64;
+		ip->src_addr[15] = 1;
+		ip->dst_addr[15] = 2;
+
+		frag[0] = REASS_IP_PROTO;
+		frag[1] = 0;
+		memcpy(&frag[2], &frag_off, 2);
+		memcpy(&frag[4], &frag_id, 4);
+	} else {
+		odph_ipv4hdr_t *ip = (odph_ipv4hdr_t *)(data + ODPH_ETHHDR_LEN);
+
+		eth->type = odp_cpu_to_be_16(ODPH_ETHTYPE_IPV4);
+		memset(ip, 0, ODPH_IPV4HDR_LEN);
+		ip->ver_ihl = ODPH_IPV4 << 4 | ODPH_IPV4HDR_IHL_MIN;
+		ip->tot_len = odp_cpu_to_be_16(ODPH_IPV4HDR_LEN + len);
+		ip->id = odp_cpu_to_be_16(id);
+		ip->frag_offset = odp_cpu_to_be_16((offset / 8) | (more ? 0x2000 : 0));
+		ip->ttl = 64;
+		ip->proto = REASS_IP_PROTO;
+		ip->src_addr = odp_cpu_to_be_32(0x0a000001);
+		ip->dst_addr = odp_cpu_to_be_32(0x0a000002);
+		odp_packet_l3_offset_set(pkt, ODPH_ETHHDR_LEN);
+		odph_ipv4_csum_update(pkt);
+	}
+
+	for (i = 0; i < len; i++)
+		data[hdr_len + i] = (offset + i) & 0xff;
+
+	return pkt;
+}
+
+static int reass_recv(odp_pktio_t pktio, odp_packet_t pkt_out[], int num, uint64_t tmo_ns)
+{
+	odp_pktin_queue_t pktin;
+	odp_time_t end = odp_time_sum(odp_time_local(), odp_time_local_from_ns(tmo_ns));
+	odp_packet_t pkt;
+	int num_rx = 0;
+
+	CU_ASSERT_FATAL(odp_pktin_queue(pktio, &pktin, 1) == 1);
+
+	while (num_rx < num && odp_time_cmp(end, odp_time_local()) > 0) {
+		if (odp_pktin_recv(pktin, &pkt, 1) != 1)
+			continue;
+
+		/* Drop possible non-test packets */
+		if (odp_packet_reass_status(pkt) == ODP_PACKET_REASS_NONE) {
+			odp_packet_free(pkt);
+			continue;
+		}
+
+		pkt_out[num_rx++] = pkt;
+	}
+
+	return num_rx;
+}
+
+static void reass_pktio_open(odp_pktio_t pktio[], odp_pktio_t *pktio_tx, odp_pktio_t *pktio_rx,
+			     uint64_t max_wait_time)
+{
+	odp_pktio_config_t config;
+	int i;
+
+	for (i = 0; i < num_ifaces; i++) {
+		pktio[i] = create_pktio(i, ODP_PKTIN_MODE_DIRECT, ODP_PKTOUT_MODE_DIRECT);
+		CU_ASSERT_FATAL(pktio[i] != ODP_PKTIO_INVALID);
+
+		odp_pktio_config_init(&config);
+		config.reassembly.en_ipv4 = true;
+		config.reassembly.en_ipv6 = true;
+		config.reassembly.max_num_frags = REASS_NUM_FRAGS;
+		config.reassembly.max_wait_time = max_wait_time;
+		CU_ASSERT_FATAL(odp_pktio_config(pktio[i], &config) == 0);
+		CU_ASSERT_FATAL(odp_pktio_start(pktio[i]) == 0);
+	}
+
+	for (i = 0; i < num_ifaces; i++)
+		_pktio_wait_linkup(pktio[i]);
+
+	*pktio_tx = pktio[0];
+	*pktio_rx = (num_ifaces > 1) ? pktio[1] : pktio[0];
+}
+
+static void reass_pktio_close(odp_pktio_t pktio[])
+{
+	int i;
+
+	for (i = 0; i < num_ifaces; i++) {
+		CU_ASSERT_FATAL(odp_pktio_stop(pktio[i]) == 0);
+		CU_ASSERT_FATAL(odp_pktio_close(pktio[i]) == 0);
+	}
+}
+
+static void pktio_test_reass(odp_bool_t ipv6)
+{
+	odp_pktio_t pktio[MAX_NUM_IFACES] = {ODP_PKTIO_INVALID};
+	odp_packet_t frag[REASS_NUM_FRAGS];
+	odp_pktio_t pktio_tx, pktio_rx;
+	odp_pktout_queue_t pktout;
+	odp_packet_reass_info_t info;
+	odp_packet_t pkt;
+	uint32_t frag_len = REASS_PAYLOAD_LEN / REASS_NUM_FRAGS;
+	uint32_t l3_len = ipv6 ? ODPH_IPV6HDR_LEN : ODPH_IPV4HDR_LEN;
+	uint32_t i, offset, len;
+	uint8_t *data;
+	int ok = 1;
+
+	reass_pktio_open(pktio, &pktio_tx, &pktio_rx, 0);
+	CU_ASSERT_FATAL(odp_pktout_queue(pktio_tx, &pktout, 1) == 1);
+
+	/* Fragment length must be a multiple of 8 bytes */
+	frag_len &= ~7u;
+
+	/* Send fragments in reverse order */
+	for (i = 0; i < REASS_NUM_FRAGS; i++) {
+		offset = i * frag_len;
+		len = (i == REASS_NUM_FRAGS - 1) ? REASS_PAYLOAD_LEN - offset : frag_len;
+		frag[REASS_NUM_FRAGS - 1 - i] = reass_frag_create(ipv6, 0x1234, offset, len,
+								  i != REASS_NUM_FRAGS - 1);
+	}
+
+	CU_ASSERT_FATAL(send_packets(pktout, frag, REASS_NUM_FRAGS) == 0);
+
+	CU_ASSERT_FATAL(reass_recv(pktio_rx, &pkt, 1, ODP_TIME_SEC_IN_NS) == 1);
+
+	CU_ASSERT(odp_packet_reass_status(pkt) == ODP_PACKET_REASS_COMPLETE);
+	CU_ASSERT(odp_packet_reass_info(pkt, &info) == 0);
+	CU_ASSERT(info.num_frags == REASS_NUM_FRAGS);
+	CU_ASSERT(odp_packet_has_ipfrag(pkt) == 0);
+	CU_ASSERT(odp_packet_l3_offset(pkt) == ODPH_ETHHDR_LEN);
+	CU_ASSERT_FATAL(odp_packet_len(pkt) == ODPH_ETHHDR_LEN + l3_len + REASS_PAYLOAD_LEN);
+
+	data = odp_packet_l3_ptr(pkt, NULL);
+	CU_ASSERT_FATAL(data != NULL);
+
+	if (ipv6) {
+		odph_ipv6hdr_t *ip = (odph_ipv6hdr_t *)data;
+
+		CU_ASSERT(odp_packet_has_ipv6(pkt));
+		CU_ASSERT(ip->next_hdr == REASS_IP_PROTO);
+		CU_ASSERT(odp_be_to_cpu_16(ip->payload_len) == REASS_PAYLOAD_LEN);
+	} else {
+		odph_ipv4hdr_t *ip = (odph_ipv4hdr_t *)data;
+
+		CU_ASSERT(odp_packet_has_ipv4(pkt));
+		CU_ASSERT(ODPH_IPV4HDR_IS_FRAGMENT(odp_be_to_cpu_16(ip->frag_offset)) == 0);
+		CU_ASSERT(odp_be_to_cpu_16(ip->tot_len) == l3_len + REASS_PAYLOAD_LEN);
+		CU_ASSERT(odph_ipv4_csum_valid(pkt));
+	}
+
+	for (i = 0; i < REASS_PAYLOAD_LEN; i++) {
+		uint8_t byte;
+
+		CU_ASSERT_FATAL(odp_packet_copy_to_mem(pkt, ODPH_ETHHDR_LEN + l3_len + i, 1,
+						       &byte) == 0);
+		if (byte != (i & 0xff))
+			ok = 0;
+	}
+	CU_ASSERT(ok);
+
+	odp_packet_free(pkt);
+	reass_pktio_close(pktio);
+}
+
+static void pktio_test_reass_ipv4(void)
+{
+	pktio_test_reass(false);
+}
+
+static void pktio_test_reass_ipv6(void)
+{
+	pktio_test_reass(true);
+}
+
+static void pktio_test_reass_incomplete(void)
+{
+	odp_pktio_t pktio[MAX_NUM_IFACES] = {ODP_PKTIO_INVALID};
+	odp_packet_t frag[REASS_NUM_FRAGS];
+	odp_pktio_t pktio_tx, pktio_rx;
+	odp_pktout_queue_t pktout;
+	odp_packet_reass_partial_state_t state;
+	odp_packet_t pkt;
+	uint64_t max_wait = 50 * ODP_TIME_MSEC_IN_NS;
+	int i;
+
+	reass_pktio_open(pktio, &pktio_tx, &pktio_rx, max_wait);
+	CU_ASSERT_FATAL(odp_pktout_queue(pktio_tx, &pktout, 1) == 1);
+
+	/* Last fragment is never sent */
+	frag[0] = reass_frag_create(false, 0x4321, 0, 256, true);
+	frag[1] = reass_frag_create(false, 0x4321, 256, 256, true);
+
+	CU_ASSERT_FATAL(send_packets(pktout, frag, 2) == 0);
+
+	CU_ASSERT_FATAL(reass_recv(pktio_rx, &pkt, 1, ODP_TIME_SEC_IN_NS) == 1);
+	CU_ASSERT_FATAL(odp_packet_reass_status(pkt) == ODP_PACKET_REASS_INCOMPLETE);
+
+	CU_ASSERT_FATAL(odp_packet_reass_partial_state(pkt, frag, &state) == 0);
+	CU_ASSERT(state.num_frags == 2);
+	CU_ASSERT(state.elapsed_time >= max_wait);
+
+	for (i = 0; i < state.num_frags && i < REASS_NUM_FRAGS; i++) {
+		CU_ASSERT(odp_packet_is_valid(frag[i]));
+		CU_ASSERT(odp_packet_reass_status(frag[i]) == ODP_PACKET_REASS_NONE);
+		CU_ASSERT(odp_packet_has_ipfrag(frag[i]));
+		odp_packet_free(frag[i]);
+	}
+
+	reass_pktio_close(pktio);
+}
+
 static void pktio_test_pktin_event_queue(odp_pktin_mode_t pktin_mode)
 {
 	odp_pktio_t pktio_tx, pktio_rx;
@@ -4921,6 +5205,9 @@ odp_testinfo_t pktio_suite_unsegmented[] = {
 				  pktio_check_maxlen_set),
 	ODP_TEST_INFO_CONDITIONAL(pktio_test_pktout_aging_tmo,
 				  pktio_check_pktout_aging_tmo),
+	ODP_TEST_INFO_CONDITIONAL(pktio_test_reass_ipv4, pktio_check_reass_ipv4),
+	ODP_TEST_INFO_CONDITIONAL(pktio_test_reass_ipv6, pktio_check_reass_ipv6),
+	ODP_TEST_INFO_CONDITIONAL(pktio_test_reass_incomplete, pktio_check_reass_ipv4),
 	ODP_TEST_INFO_CONDITIONAL(pktio_test_pktout_compl_plain_queue,
 				  pktio_check_pktout_compl_plain_queue),
 	ODP_TEST_INFO_CONDITIONAL(pktio_test_pktout_compl_sched_queue,
@@ -3493,6 +3493,7 @@ static void scheduler_test_flow_aware(void)
 static void scheduler_test_print(void)
 {
 	odp_schedule_print();
+	odp_schedule_stats_print();
 }
 
 /* Queues with initial events enqueued */
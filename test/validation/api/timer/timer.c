@@ -1537,6 +1537,114 @@ static void timer_test_cancel(void)
 		CU_FAIL_FATAL("Failed to destroy pool");
 }
 
+static void timer_test_multi(void)
+{
+	odp_pool_t pool;
+	odp_pool_param_t params;
+	odp_timer_pool_param_t tparam;
+	odp_queue_param_t queue_param;
+	odp_timer_capability_t capa;
+	odp_timer_pool_t tp;
+	odp_queue_t queue;
+	odp_timeout_t tmo;
+	uint64_t tick;
+	int ret, i;
+	const int num = 8;
+	odp_timer_t tim[num];
+	odp_event_t ev[num];
+	odp_timer_start_t start_param[num];
+
+	memset(&capa, 0, sizeof(capa));
+	ret = odp_timer_capability(ODP_CLOCK_DEFAULT, &capa);
+	CU_ASSERT_FATAL(ret == 0);
+
+	odp_pool_param_init(&params);
+	params.type    = ODP_POOL_TIMEOUT;
+	params.tmo.num = num;
+
+	pool = odp_pool_create("tmo_pool_for_multi", &params);
+	CU_ASSERT_FATAL(pool != ODP_POOL_INVALID);
+
+	odp_timer_pool_param_init(&tparam);
+	tparam.res_ns	  = global_mem->param.res_ns;
+	tparam.min_tmo    = global_mem->param.min_tmo;
+	tparam.max_tmo    = global_mem->param.max_tmo;
+	tparam.num_timers = num;
+	tparam.priv       = 0;
+	tparam.clk_src    = ODP_CLOCK_DEFAULT;
+	tp = odp_timer_pool_create(NULL, &tparam);
+	CU_ASSERT_FATAL(tp != ODP_TIMER_POOL_INVALID);
+
+	odp_timer_pool_start();
+
+	odp_queue_param_init(&queue_param);
+	if (capa.queue_type_plain) {
+		queue_param.type = ODP_QUEUE_TYPE_PLAIN;
+	} else if (capa.queue_type_sched) {
+		queue_param.type = ODP_QUEUE_TYPE_SCHED;
+		queue_param.sched.sync = ODP_SCHED_SYNC_ATOMIC;
+	}
+
+	queue = odp_queue_create("timer_queue", &queue_param);
+	CU_ASSERT_FATAL(queue != ODP_QUEUE_INVALID);
+
+	tick = odp_timer_ns_to_tick(tp, tparam.max_tmo / 2);
+
+	for (i = 0; i < num; i++) {
+		tim[i] = odp_timer_alloc(tp, queue, USER_PTR);
+		CU_ASSERT_FATAL(tim[i] != ODP_TIMER_INVALID);
+
+		ev[i] = odp_timeout_to_event(odp_timeout_alloc(pool));
+		CU_ASSERT_FATAL(ev[i] != ODP_EVENT_INVALID);
+
+		start_param[i].tick_type = ODP_TIMER_TICK_REL;
+		start_param[i].tick = tick;
+		start_param[i].tmo_ev = ev[i];
+	}
+
+	/* Expiration time passed already */
+	start_param[0].tick_type = ODP_TIMER_TICK_ABS;
+	start_param[0].tick = 0;
+	ret = odp_timer_start_multi(tim, start_param, num);
+	CU_ASSERT(ret == ODP_TIMER_TOO_NEAR);
+
+	start_param[0].tick_type = ODP_TIMER_TICK_REL;
+	start_param[0].tick = tick;
+	ret = odp_timer_start_multi(tim, start_param, num);
+	CU_ASSERT_FATAL(ret == num);
+
+	ret = odp_timer_restart_multi(tim, start_param, num);
+	CU_ASSERT(ret == num);
+
+	for (i = 0; i < num; i++)
+		ev[i] = ODP_EVENT_INVALID;
+
+	ret = odp_timer_cancel_multi(tim, ev, num);
+	CU_ASSERT(ret == num);
+
+	for (i = 0; i < num; i++) {
+		CU_ASSERT_FATAL(ev[i] != ODP_EVENT_INVALID);
+		tmo = odp_timeout_from_event(ev[i]);
+		CU_ASSERT(odp_timeout_timer(tmo) == tim[i]);
+		CU_ASSERT(odp_timeout_user_ptr(tmo) == USER_PTR);
+		odp_timeout_free(tmo);
+	}
+
+	/* Timers are inactive */
+	ret = odp_timer_cancel_multi(tim, ev, num);
+	CU_ASSERT(ret == 0);
+
+	for (i = 0; i < num; i++) {
+		CU_ASSERT(ev[i] == ODP_EVENT_INVALID);
+		CU_ASSERT(odp_timer_free(tim[i]) == ODP_EVENT_INVALID);
+	}
+
+	odp_timer_pool_destroy(tp);
+
+	CU_ASSERT(odp_queue_destroy(queue) == 0);
+	CU_ASSERT(odp_pool_destroy(pool) == 0);
+}
+
 static void timer_test_tmo_limit(odp_queue_type_t queue_type,
 				 int max_res, int min)
 {
@@ -2536,6 +2644,7 @@ odp_testinfo_t timer_suite[] = {
 	ODP_TEST_INFO_CONDITIONAL(timer_test_pkt_event_sched,
 				  check_sched_queue_support),
 	ODP_TEST_INFO(timer_test_cancel),
+	ODP_TEST_INFO(timer_test_multi),
 	ODP_TEST_INFO_CONDITIONAL(timer_test_max_res_min_tmo_plain,
 				  check_plain_queue_support),
 	ODP_TEST_INFO_CONDITIONAL(timer_test_max_res_min_tmo_sched,